@@ -277,6 +277,13 @@ Database::Copy(Ptr<MemDb::Database> const& dst) const
                 uint32_t const numBytes = byteSize * srcPart->CAPACITY;
 
                 Memory::Copy(srcBuffer, dstBuffer, (size_t)byteSize * (size_t)srcPart->numRows);
+
+                dstPart->columnVersions[p] = srcPart->columnVersions[p];
+                if (srcPart->rowVersions[p] != nullptr)
+                {
+                    uint64_t* dstVersions = dstPart->AllocateRowVersions(p);
+                    Memory::Copy(srcPart->rowVersions[p], dstVersions, sizeof(uint64_t) * srcPart->CAPACITY);
+                }
             }
         }
     }
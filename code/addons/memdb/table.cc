@@ -72,6 +72,8 @@ Table::NewPartition()
 
             Attribute const* const desc = AttributeRegistry::GetAttribute(attr);
             partition->columns.Append(nullptr);
+            partition->columnVersions.Append(0);
+            partition->rowVersions.Append(nullptr);
             if (desc->typeSize > 0)
             {
                 Table::ColumnBuffer& buffer = partition->columns[col];
@@ -182,6 +184,8 @@ Table::AddAttribute(AttributeId attribute, bool updateSignature)
     for (Partition* part : this->partitions)
     {
         part->columns.Append(nullptr);
+        part->columnVersions.Append(0);
+        part->rowVersions.Append(nullptr);
         if (desc->typeSize > 0)
         {
             Table::ColumnBuffer& buffer = part->columns[col];
@@ -217,6 +221,11 @@ Table::AddRow()
         void*& buf = this->currentPartition->columns[i];
         void* val = (char*)buf + ((size_t)index * desc->typeSize);
         Memory::Copy(desc->defVal, val, desc->typeSize);
+
+        // the row might have been recycled, so make sure it isn't considered modified
+        uint64_t* versions = this->currentPartition->rowVersions[i];
+        if (versions != nullptr)
+            versions[index] = 0;
     }
 
     return {this->currentPartition->partitionId, index};
@@ -325,6 +334,7 @@ Table::Defragment(std::function<void(Partition*, MemDb::RowId, MemDb::RowId)> co
 
             part->validRows.Clear();
             part->modifiedRows.Clear();
+            part->ResetVersions();
             part->version++;
 
             this->numActivePartitions--;
@@ -393,11 +403,65 @@ Table::Reset()
                 col = nullptr;
             }
         }
+        for (auto& versions : part->rowVersions)
+        {
+            if (versions != nullptr)
+            {
+                Memory::Free(Table::HEAP_MEMORY_TYPE, versions);
+                versions = nullptr;
+            }
+        }
     }
     this->partitions.Reset();
     this->currentPartition = nullptr;
 }
 
+//------------------------------------------------------------------------------
+/**
+*/
+void
+Table::Clear()
+{
+    // free partitions are still kept in the partitions array
+    for (IndexT i = 0; i < this->partitions.Size(); i++)
+    {
+        if (this->partitions[i] != nullptr)
+            delete this->partitions[i];
+    }
+    this->partitions.Clear();
+    this->freePartitions.Clear();
+    this->nullPartitions.Clear();
+    this->currentPartition = nullptr;
+    this->firstActivePartition = nullptr;
+    this->numActivePartitions = 0;
+    this->totalNumRows = 0;
+}
+
+//------------------------------------------------------------------------------
+/**
+    Partition ids that are skipped are kept as null partitions, like they would be after a defragment.
+*/
+Table::Partition*
+Table::RestorePartition(uint16_t partitionId)
+{
+    n_assert(partitionId >= this->partitions.Size());
+    n_assert(this->freePartitions.IsEmpty());
+
+    while (this->partitions.Size() < partitionId)
+    {
+        this->nullPartitions.Append((uint16_t)this->partitions.Size());
+        this->partitions.Append(nullptr);
+    }
+
+    // hide the null partitions so that the new partition is appended with the requested id
+    Util::Array<uint16_t> nulls = std::move(this->nullPartitions);
+    Partition* partition = this->NewPartition();
+    this->nullPartitions = std::move(nulls);
+
+    n_assert(partition->partitionId == partitionId);
+    return partition;
+}
+
 //------------------------------------------------------------------------------
 /**
 */
@@ -606,6 +670,11 @@ Table::DuplicateInstance(Table const& src, RowId srcRow, Table& dst)
                 (char*)dstBuf + ((size_t)byteSize * dstRow.index),
                 byteSize
             );
+
+            // Carry over the change tick, so that the row doesn't lose its modifications when migrating
+            uint64_t const* const srcVersions = srcPart->rowVersions[srcColId.id];
+            if (srcVersions != nullptr && srcVersions[srcRow.index] != 0)
+                dstPart->MarkModified(i, dstRow.index, srcVersions[srcRow.index]);
         }
         else
         {
@@ -697,6 +766,11 @@ Table::DuplicateInstances(Table& src, Util::Array<RowId> const& srcRows, Table&
                     (char*)dstBuf + ((size_t)byteSize * dstRow.index),
                     byteSize
                 );
+
+                // Carry over the change tick, so that the row doesn't lose its modifications when migrating
+                uint64_t const* const srcVersions = srcPart->rowVersions[srcColId.id];
+                if (srcVersions != nullptr && srcVersions[srcRow.index] != 0)
+                    dstPart->MarkModified(i, dstRow.index, srcVersions[srcRow.index]);
             }
             else
             {
@@ -721,6 +795,14 @@ Table::Partition::~Partition()
             col = nullptr;
         }
     }
+    for (auto& versions : this->rowVersions)
+    {
+        if (versions != nullptr)
+        {
+            Memory::Free(Table::HEAP_MEMORY_TYPE, versions);
+            versions = nullptr;
+        }
+    }
 }
 
 //------------------------------------------------------------------------------
@@ -783,6 +865,10 @@ Table::Partition::EraseSwapIndex(uint16_t instance)
             void*& buf = this->columns[i];
             const SizeT byteSize = desc->typeSize;
             Memory::Copy((char*)buf + ((size_t)byteSize * end), (char*)buf + ((size_t)byteSize * instance), byteSize);
+
+            uint64_t* versions = this->rowVersions[i];
+            if (versions != nullptr)
+                versions[instance] = versions[end];
         }
     }
 
@@ -792,4 +878,96 @@ Table::Partition::EraseSwapIndex(uint16_t instance)
     this->numRows--;
 }
 
+//------------------------------------------------------------------------------
+/**
+*/
+uint64_t*
+Table::Partition::AllocateRowVersions(ColumnIndex column)
+{
+    uint64_t*& versions = this->rowVersions[column.id];
+    if (versions == nullptr)
+    {
+        versions = (uint64_t*)Memory::Alloc(Table::HEAP_MEMORY_TYPE, sizeof(uint64_t) * CAPACITY);
+        Memory::Clear(versions, sizeof(uint64_t) * CAPACITY);
+    }
+    return versions;
+}
+
+//------------------------------------------------------------------------------
+/**
+*/
+void
+Table::Partition::ResetVersions()
+{
+    for (IndexT i = 0; i < this->columnVersions.Size(); i++)
+    {
+        this->columnVersions[i] = 0;
+        if (this->rowVersions[i] != nullptr)
+            Memory::Clear(this->rowVersions[i], sizeof(uint64_t) * CAPACITY);
+    }
+}
+
+//------------------------------------------------------------------------------
+/**
+*/
+void
+Table::Partition::MarkModified(ColumnIndex column, uint16_t row, uint64_t tick)
+{
+    n_assert(row < CAPACITY);
+    uint64_t* versions = this->AllocateRowVersions(column);
+    versions[row] = tick;
+    this->columnVersions[column.id] = Math::max(this->columnVersions[column.id], tick);
+}
+
+//------------------------------------------------------------------------------
+/**
+*/
+void
+Table::Partition::MarkModified(ColumnIndex column, Util::BitField<CAPACITY> const& rows, uint64_t tick)
+{
+    if (rows.IsNull())
+        return;
+
+    uint64_t* versions = this->AllocateRowVersions(column);
+    for (uint32_t section = 0; section < CAPACITY / 64; section++)
+    {
+        if (rows.SectionIsNull(section))
+            continue;
+
+        uint32_t const end = Math::min((section + 1) * 64, this->numRows);
+        for (uint32_t row = section * 64; row < end; row++)
+        {
+            if (rows.IsSet(row))
+                versions[row] = tick;
+        }
+    }
+    this->columnVersions[column.id] = Math::max(this->columnVersions[column.id], tick);
+}
+
+//------------------------------------------------------------------------------
+/**
+*/
+bool
+Table::Partition::IsModifiedSince(ColumnIndex column, uint64_t tick) const
+{
+    return this->columnVersions[column.id] > tick;
+}
+
+//------------------------------------------------------------------------------
+/**
+*/
+void
+Table::Partition::GetModifiedSince(ColumnIndex column, uint64_t tick, Util::BitField<CAPACITY>& outRows) const
+{
+    if (this->columnVersions[column.id] <= tick)
+        return;
+
+    uint64_t const* const versions = this->rowVersions[column.id];
+    n_assert(versions != nullptr);
+    for (uint32_t row = 0; row < this->numRows; row++)
+    {
+        outRows.SetBitIf(row, (uint64_t)(versions[row] > tick));
+    }
+}
+
 } // namespace MemDb
@@ -103,6 +103,10 @@ public:
     void Clean();
     /// Reset table. Deallocate all data
     void Reset();
+    /// Delete all partitions and rows. The columns of the table are kept.
+    void Clear();
+    /// Create a partition with a specific id. Only used when restoring a cleared table, where partitions must be restored in increasing id order.
+    Partition* RestorePartition(uint16_t partitionId);
 
     /// Get first active partition with entities
     Partition* GetFirstActivePartition();
@@ -232,6 +236,23 @@ public:
     /// bits are set if the row is occupied. If the row is removed, the bit is set to zero.
     /// this is kept up to date if defragging the partition.
     Util::BitField<CAPACITY> validRows;
+    /// per column change tick of the latest write to any row in the column.
+    /// used to reject entire partitions when looking for changes.
+    Util::Array<uint64_t> columnVersions;
+    /// per column and row change ticks. Lazily allocated the first time a column is marked as modified, null otherwise.
+    /// these follow the rows when they are moved, migrated or defragged.
+    Util::Array<uint64_t*> rowVersions;
+
+    /// get the row versions of a column, allocating them if the column has none
+    uint64_t* AllocateRowVersions(ColumnIndex column);
+    /// mark a single row in a column as modified at the given change tick
+    void MarkModified(ColumnIndex column, uint16_t row, uint64_t tick);
+    /// mark all rows that are set in the mask as modified at the given change tick
+    void MarkModified(ColumnIndex column, Util::BitField<CAPACITY> const& rows, uint64_t tick);
+    /// check if any row in the column has been modified after the given change tick
+    bool IsModifiedSince(ColumnIndex column, uint64_t tick) const;
+    /// sets the bits of all rows in the column that have been modified after the given change tick. Does not clear any bits in outRows.
+    void GetModifiedSince(ColumnIndex column, uint64_t tick, Util::BitField<CAPACITY>& outRows) const;
 
 private:
     friend Table;
@@ -241,6 +262,8 @@ private:
     void FreeIndex(uint16_t instance);
     /// erase row by swapping with last row and reducing number of rows in table
     void EraseSwapIndex(uint16_t instance);
+    /// reset all change tracking, used when recycling the partition
+    void ResetVersions();
 };
 
 } // namespace MemDb
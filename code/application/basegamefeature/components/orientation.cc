@@ -4,15 +4,14 @@
 #include "memdb/attributeregistry.h"
 #include "game/componentserialization.h"
 #include "game/componentinspection.h"
-#include "pjson/pjson.h"
 //------------------------------------------------------------------------------
 namespace IO
 {
 template<> void JsonReader::Get<Game::Orientation>(Game::Orientation& ret, const char* attr)
 {
     ret = Game::Orientation();
-    const pjson::value_variant* node = this->GetChild(attr);
-    if (node->is_object())
+    const Node* node = this->GetChild(attr);
+    if (node->IsObject())
     {
         this->SetToNode(attr);
         if (this->HasAttr("x")) this->Get<float>(ret.x, "x");
@@ -21,7 +20,7 @@ template<> void JsonReader::Get<Game::Orientation>(Game::Orientation& ret, const
         if (this->HasAttr("w")) this->Get<float>(ret.w, "w");
         this->SetToParent();
     }
-    else if (node->is_array())
+    else if (node->IsArray())
     {
         this->Get<Math::quat>(ret, attr);
     }
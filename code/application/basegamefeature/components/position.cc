@@ -4,15 +4,14 @@
 #include "memdb/attributeregistry.h"
 #include "game/componentserialization.h"
 #include "game/componentinspection.h"
-#include "pjson/pjson.h"
 //------------------------------------------------------------------------------
 namespace IO
 {
 template<> void JsonReader::Get<Game::Position>(Game::Position& ret, const char* attr)
 {
     ret = Game::Position();
-    const pjson::value_variant* node = this->GetChild(attr);
-    if (node->is_object())
+    const Node* node = this->GetChild(attr);
+    if (node->IsObject())
     {
         this->SetToNode(attr);
         if (this->HasAttr("x")) this->Get<float>(ret.x, "x");
@@ -20,7 +19,7 @@ template<> void JsonReader::Get<Game::Position>(Game::Position& ret, const char*
         if (this->HasAttr("z")) this->Get<float>(ret.z, "z");
         this->SetToParent();
     }
-    else if (node->is_array())
+    else if (node->IsArray())
     {
         this->Get<Math::vec3>(ret, attr);
     }
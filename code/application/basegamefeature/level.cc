@@ -6,6 +6,9 @@
 #include "basegamefeature/level.h"
 #include "io/ioserver.h"
 #include "game/world.h"
+#include "game/componentinspection.h"
+#include "jobs2/jobs2.h"
+#include "resources/resourceserver.h"
 
 #include "flat/game/level.h"
 
@@ -14,65 +17,239 @@ namespace Game
 
 //------------------------------------------------------------------------------
 /**
+    A range of rows of an entity group, that is copied into a partition.
+*/
+struct LevelCopyJob
+{
+    uint32_t group;
+    MemDb::Table::Partition* partition;
+    SizeT srcRow;
+    SizeT dstRow;
+    SizeT numRows;
+};
+
+struct LevelCopyJobContext
+{
+    PackedLevel const* level;
+    LevelCopyJob const* jobs;
+};
+
+//------------------------------------------------------------------------------
+/**
+*/
+PackedLevel::~PackedLevel()
+{
+    this->ReleasePrefetch();
+    if (this->reader.isvalid())
+    {
+        this->reader->Close();
+        this->reader = nullptr;
+    }
+}
+
+//------------------------------------------------------------------------------
+/**
+*/
+bool
+PackedLevel::IsLoaded() const
+{
+    return this->loaded;
+}
+
+//------------------------------------------------------------------------------
+/**
+    Sets up the entity groups so that they point directly into the mapped level file,
+    and builds the string table that string fields are resolved through.
+*/
+void
+PackedLevel::Parse()
+{
+    ubyte const* data = this->reader->mapCursor;
+    n_assert2(data != nullptr, "Levels must be loaded from a stream that can be memory mapped!");
+
+    auto flatLevel = Game::Serialization::GetLevel(data);
+    auto flatDescriptions = flatLevel->component_descriptions();
+
+    Util::FixedArray<ComponentId> componentIds(flatDescriptions->size());
+    uint componentIndex = 0;
+    for (auto desc : *flatDescriptions)
+    {
+        const char* componentName = desc->name()->c_str();
+        ComponentId cid = MemDb::AttributeRegistry::GetAttributeId(componentName);
+        componentIds[componentIndex++] = cid;
+
+#ifndef PUBLIC_BUILD
+        Game::ComponentInterface const* cInterface =
+            static_cast<Game::ComponentInterface*>(MemDb::AttributeRegistry::GetAttribute(cid));
+
+        // TODO: Validate all fields types as well and assert if incorrect!
+        n_assert(cInterface->GetNumFields() == desc->fields()->size());
+#endif
+    }
+
+    // string fields are stored as indices into this array, so we only need to create each atom once
+    this->strings.Resize(flatLevel->strings()->size());
+    for (uint32_t i = 0; i < flatLevel->strings()->size(); i++)
+    {
+        this->strings[i] = Util::StringAtom((*flatLevel->strings())[i]->data());
+    }
+
+    for (auto table : *flatLevel->tables())
+    {
+        Game::PackedLevel::EntityGroup entityGroup;
+        entityGroup.dstTable = MemDb::TableId::Invalid();
+        entityGroup.numRows = table->num_rows();
+
+        n_assert(entityGroup.numRows > 0);
+
+        SizeT const numComponents = (SizeT)table->components()->size();
+        n_assert(table->columns()->size() == numComponents);
+        entityGroup.components.Resize(numComponents);
+        entityGroup.columns.Resize(numComponents);
+        entityGroup.typeSizes.Resize(numComponents);
+        entityGroup.stringFields.Resize(numComponents);
+
+        for (componentIndex = 0; componentIndex < (uint)numComponents; componentIndex++)
+        {
+            uint32_t const descriptionIndex = (*table->components())[componentIndex];
+            ComponentId const cid = componentIds[descriptionIndex];
+            Game::ComponentInterface const* cInterface =
+                static_cast<Game::ComponentInterface*>(MemDb::AttributeRegistry::GetAttribute(cid));
+            auto column = (*table->columns())[componentIndex];
+
+            entityGroup.components[componentIndex] = cid;
+            entityGroup.typeSizes[componentIndex] = cInterface->typeSize;
+            entityGroup.columns[componentIndex] = nullptr;
+            if (cInterface->typeSize > 0)
+            {
+                n_assert(column->bytes()->size() == entityGroup.numRows * cInterface->typeSize);
+                entityGroup.columns[componentIndex] = column->bytes()->data();
+            }
+
+            // Find string fields, which are resolved when copying into the world
+            auto componentDescription = (*flatDescriptions)[descriptionIndex];
+            for (IndexT i = 0; i < cInterface->GetNumFields(); i++)
+            {
+                auto componentField = (*componentDescription->fields())[i];
+                if (componentField->feature() == Game::Serialization::ComponentFieldFeature_StringAtom)
+                {
+                    entityGroup.stringFields[componentIndex].Append(cInterface->GetFieldByteOffsets()[i]);
+                }
+            }
+        }
+
+        this->tables.Append(std::move(entityGroup));
+    }
+}
+
+//------------------------------------------------------------------------------
+/**
+*/
+void
+PackedLevel::CreateTables()
+{
+    for (IndexT i = 0; i < this->tables.Size(); i++)
+    {
+        EntityGroup& entityGroup = this->tables[i];
+        entityGroup.dstTable = this->world->CreateEntityTable({.name = "", .components = entityGroup.components});
+
+        // the table might already exist, with a different column order
+        MemDb::Table& table = this->world->GetDatabase()->GetTable(entityGroup.dstTable);
+        entityGroup.dstColumns.Resize(entityGroup.components.Size());
+        for (IndexT c = 0; c < entityGroup.components.Size(); c++)
+        {
+            entityGroup.dstColumns[c] = table.GetAttributeIndex(entityGroup.components[c]);
+            n_assert(entityGroup.dstColumns[c] != MemDb::ColumnIndex::Invalid());
+        }
+    }
+    this->loaded = true;
+}
+
+//------------------------------------------------------------------------------
+/**
+    Copies a range of rows from the mapped level file into a partition, and resolves all string fields.
+*/
+void
+PackedLevel::CopyRowsJob(SizeT totalJobs, SizeT groupSize, IndexT groupIndex, SizeT invocationOffset, void* ctx)
+{
+    static_assert(sizeof(Util::StringAtom) == sizeof(uint64_t));
+
+    LevelCopyJobContext* context = static_cast<LevelCopyJobContext*>(ctx);
+    for (uint i = 0; i < groupSize; i++)
+    {
+        IndexT index = i + invocationOffset;
+        if (index >= totalJobs)
+            return;
+
+        LevelCopyJob const& job = context->jobs[index];
+        EntityGroup const& entityGroup = context->level->tables[job.group];
+        Util::FixedArray<Util::StringAtom> const& strings = context->level->strings;
+
+        for (IndexT c = 0; c < entityGroup.columns.Size(); c++)
+        {
+            // flag components have no data
+            if (entityGroup.columns[c] == nullptr)
+                continue;
+
+            SizeT const typeSize = entityGroup.typeSizes[c];
+            ubyte* dst = (ubyte*)job.partition->columns[entityGroup.dstColumns[c].id] + job.dstRow * typeSize;
+            Memory::Copy(entityGroup.columns[c] + job.srcRow * typeSize, dst, job.numRows * typeSize);
+
+            Util::Array<uint32_t> const& stringFields = entityGroup.stringFields[c];
+            if (stringFields.IsEmpty())
+                continue;
+
+            ubyte* const end = dst + job.numRows * typeSize;
+            for (ubyte* it = dst; it < end; it += typeSize)
+            {
+                for (IndexT f = 0; f < stringFields.Size(); f++)
+                {
+                    uint64_t const stringIndex = *reinterpret_cast<uint64_t*>(it + stringFields[f]);
+                    *reinterpret_cast<Util::StringAtom*>(it + stringFields[f]) = strings[stringIndex];
+                }
+            }
+        }
+    }
+}
+
+//------------------------------------------------------------------------------
+/**
+    Rows are reserved in the partitions up front, then the column data of each partition is
+    copied in parallel, and finally the entities are created and initialized on the calling thread.
 */
 Util::Array<Game::Entity>
 PackedLevel::Instantiate() const
 {
+    n_assert2(this->loaded, "Level has not finished preloading!");
+
     Util::Array<Game::Entity> entities;
+    Util::Array<LevelCopyJob> jobs;
+    SizeT numEntities = 0;
 
     for (IndexT i = 0; i < this->tables.Size(); i++)
     {
         EntityGroup const& dataTable = this->tables[i];
         MemDb::Table& table = this->world->GetDatabase()->GetTable(dataTable.dstTable);
 
-        SizeT numRowsLeft = dataTable.numRows;
-
         MemDb::Table::Partition* partition = table.GetCurrentPartition();
         if (partition == nullptr || partition->numRows == MemDb::Table::Partition::CAPACITY)
             partition = table.NewPartition();
 
-    
-        // Create new partitions and fill them with data from table
+        // Reserve rows in new and existing partitions
         SizeT rowsProcessed = 0;
-        while (numRowsLeft > 0)
+        while (rowsProcessed < dataTable.numRows)
         {
-            SizeT numRows = Math::min(numRowsLeft, (SizeT)MemDb::Table::Partition::CAPACITY - (SizeT)partition->numRows);
-            numRowsLeft -= (SizeT)MemDb::Table::Partition::CAPACITY - partition->numRows;
+            SizeT const numRows = Math::min(dataTable.numRows - rowsProcessed, (SizeT)MemDb::Table::Partition::CAPACITY - (SizeT)partition->numRows);
 
-            SizeT const numColumns = table.GetAttributes().Size();
-            SizeT byteOffset = 0;
-            for (IndexT columnIndex = 0; columnIndex < numColumns; columnIndex++)
-            {
-                // TODO: maybe store this in the EntityGroup upon preloading.
-                SizeT const typeSize = MemDb::AttributeRegistry::TypeSize(table.GetAttributes()[columnIndex]);
-                SizeT const numBytes = numRows * typeSize;
-                ubyte* src = dataTable.columns + byteOffset + (rowsProcessed * typeSize);
-                Memory::Copy(src, (byte*)partition->columns[columnIndex] + (partition->numRows * typeSize), numBytes);
-                byteOffset += dataTable.numRows * typeSize;
-            }
+            LevelCopyJob job;
+            job.group = i;
+            job.partition = partition;
+            job.srcRow = rowsProcessed;
+            job.dstRow = partition->numRows;
+            job.numRows = numRows;
+            jobs.Append(job);
 
             rowsProcessed += numRows;
-
-            for (uint16_t rowIndex = partition->numRows; rowIndex < partition->numRows + numRows; rowIndex++)
-            {
-                partition->validRows.SetBit(rowIndex);
-                Game::Entity entity = this->world->AllocateEntityId();
-
-                Game::EntityMapping& mapping = this->world->entityMap[entity.index];
-                mapping.table = dataTable.dstTable;
-                mapping.instance = {.partition = partition->partitionId, .index = rowIndex};
-
-                // Set the owner of this instance.
-                MemDb::Table& table = this->world->GetDatabase()->GetTable(mapping.table);
-                Game::Entity* owners =
-                    (Game::Entity*)table.GetBuffer(mapping.instance.partition, Game::Entity::Traits::fixed_column_index);
-                owners[mapping.instance.index] = entity;
-
-                entities.Append(entity);
-                // TODO: could initialize all components of a specific type at the same time
-                this->world->InitializeAllComponents(entity, mapping.table, mapping.instance);
-            }
-
             partition->numRows += numRows;
             if (partition->numRows == MemDb::Table::Partition::CAPACITY)
                 partition = table.NewPartition();
@@ -80,9 +257,62 @@ PackedLevel::Instantiate() const
 
         // update table numRows total
         table.SetNumRows(table.GetNumRows() + dataTable.numRows);
+        numEntities += dataTable.numRows;
     }
 
+    if (jobs.IsEmpty())
+    {
+        this->ReleasePrefetch();
+        return entities;
+    }
+
+    LevelCopyJobContext context;
+    context.level = this;
+    context.jobs = jobs.Begin();
+
+    Threading::Event event;
+    Jobs2::JobDispatch(CopyRowsJob, jobs.Size(), 1, context, nullptr, nullptr, &event);
+    event.Wait();
+
+    entities.Reserve(numEntities);
+    for (IndexT i = 0; i < jobs.Size(); i++)
+    {
+        LevelCopyJob const& job = jobs[i];
+        MemDb::TableId const tableId = this->tables[job.group].dstTable;
+        MemDb::Table::Partition* partition = job.partition;
+        Game::Entity* owners = (Game::Entity*)partition->columns[Game::Entity::Traits::fixed_column_index];
+
+        for (uint16_t rowIndex = job.dstRow; rowIndex < job.dstRow + job.numRows; rowIndex++)
+        {
+            partition->validRows.SetBit(rowIndex);
+            Game::Entity entity = this->world->AllocateEntityId();
+
+            Game::EntityMapping& mapping = this->world->entityMap[entity.index];
+            mapping.table = tableId;
+            mapping.instance = {.partition = partition->partitionId, .index = rowIndex};
+
+            // Set the owner of this instance.
+            owners[rowIndex] = entity;
+
+            entities.Append(entity);
+            // TODO: could initialize all components of a specific type at the same time
+            this->world->InitializeAllComponents(entity, mapping.table, mapping.instance);
+        }
+    }
+
+    // the components have created their resources, so they hold their own references now
+    this->ReleasePrefetch();
     return entities;
 }
 
+//------------------------------------------------------------------------------
+/**
+*/
+void
+PackedLevel::ReleasePrefetch() const
+{
+    if (Resources::ResourceServer::HasInstance())
+        Resources::ResourceServer::Instance()->ReleasePrefetch(this->path);
+}
+
 } // namespace Game
@@ -10,6 +10,10 @@
 #include "core/refcounted.h"
 #include "memdb/database.h"
 #include "game/entity.h"
+#include "game/componentid.h"
+#include "io/binaryreader.h"
+#include "threading/interlocked.h"
+#include <functional>
 
 namespace Game
 {
@@ -24,13 +28,16 @@ class World;
 
     @details A packed level contains all information of a level
     in memory-packed entity groups that correspont to a table in the 
-    game world. When instantiating, the entity groups are effectively
-    just mem-copied into the game world, and then initialized.
+    game world. The level file stays memory mapped while the level is
+    loaded, and when instantiating, the columns of each entity group are
+    copied straight from the mapping into the partitions of the tables,
+    in parallel jobs. String fields are resolved while copying.
 
     PackedLevels are loaded directly via a game world and should not
     be created using `new`.
 
     @see Game::World::PreloadLevel
+    @see Game::World::PreloadLevelAsync
     @see Game::World::UnloadLevel
     
 */
@@ -39,6 +46,8 @@ class PackedLevel
 public:
     /// instantiates the level into game world
     Util::Array<Game::Entity> Instantiate() const;
+    /// check if the level has been preloaded and can be instantiated
+    bool IsLoaded() const;
 
 private:
     friend class World;
@@ -46,26 +55,52 @@ private:
     PackedLevel() {}; // only worlds may create this
 
     // only worlds may destroy this
-    ~PackedLevel()
-    {
-        for (auto& t : tables)
-        {
-            if (t.columns != nullptr)
-                delete[] t.columns;
-        }
-    };
+    ~PackedLevel();
+
+    /// parse the mapped level file. Does not touch the world, so it can be done on any thread.
+    void Parse();
+    /// create the entity tables in the world. Must be done on the main thread.
+    void CreateTables();
+    /// job that copies ranges of rows from the mapped level file into partitions
+    static void CopyRowsJob(SizeT totalJobs, SizeT groupSize, IndexT groupIndex, SizeT invocationOffset, void* ctx);
+    /// release the resources prefetched for the level
+    void ReleasePrefetch() const;
 
     // the destination world if we are to instantiate this level
     Game::World* world;
 
+    // keeps the level file mapped until the level is unloaded
+    Ptr<IO::BinaryReader> reader;
+
+    // path of the level file, its dependencies are prefetched until it is instantiated
+    Util::String path;
+
+    // all strings in the level. String fields in the columns are stored as indices into this array
+    Util::FixedArray<Util::StringAtom> strings;
+
     struct EntityGroup
     {
         MemDb::TableId dstTable;
         SizeT numRows;
-        ubyte* columns = nullptr;
+        /// the components of the entity group, in the order they are stored in the level
+        Util::FixedArray<ComponentId> components;
+        /// column data for each component, pointing into the mapped level file. Null for flag components.
+        Util::FixedArray<ubyte const*> columns;
+        /// size of each component
+        Util::FixedArray<SizeT> typeSizes;
+        /// byte offsets of all string fields within each component
+        Util::FixedArray<Util::Array<uint32_t>> stringFields;
+        /// the column in the destination table of each component
+        Util::FixedArray<MemDb::ColumnIndex> dstColumns;
     };
 
     Util::Array<EntityGroup> tables;
+
+    // set to zero when an async preload has finished parsing
+    Threading::AtomicCounter parseCounter = 0;
+    // called on the main thread when an async preload has finished
+    std::function<void(PackedLevel*)> onLoaded;
+    bool loaded = false;
 };
 
 } // namespace Game
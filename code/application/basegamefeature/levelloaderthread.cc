@@ -0,0 +1,77 @@
+//------------------------------------------------------------------------------
+//  @file levelloaderthread.cc
+//  @copyright (C) 2024 Individual contributors, see AUTHORS file
+//------------------------------------------------------------------------------
+#include "foundation/stdneb.h"
+#include "io/ioserver.h"
+#include "levelloaderthread.h"
+#include "profiling/profiling.h"
+
+namespace Game
+{
+
+__ImplementClass(Game::LevelLoaderThread, 'LLTH', Threading::Thread);
+
+//------------------------------------------------------------------------------
+/**
+*/
+LevelLoaderThread::LevelLoaderThread()
+{
+    // empty
+}
+
+//------------------------------------------------------------------------------
+/**
+*/
+LevelLoaderThread::~LevelLoaderThread()
+{
+    if (this->IsRunning())
+    {
+        this->Stop();
+    }
+}
+
+//------------------------------------------------------------------------------
+/**
+*/
+void
+LevelLoaderThread::Enqueue(std::function<void()> const& func)
+{
+    this->jobs.Enqueue(func);
+}
+
+//------------------------------------------------------------------------------
+/**
+*/
+void
+LevelLoaderThread::DoWork()
+{
+    this->ioServer = IO::IoServer::Create();
+    Profiling::ProfilingRegisterThread();
+    Util::Array<std::function<void()>> arr;
+    while (!this->ThreadStopRequested())
+    {
+        this->jobs.DequeueAll(arr);
+        for (IndexT i = 0; i < arr.Size(); i++)
+        {
+            arr[i]();
+        }
+        arr.Reset();
+
+        // wait for more levels
+        this->jobs.Wait();
+    }
+
+    this->ioServer = nullptr;
+}
+
+//------------------------------------------------------------------------------
+/**
+*/
+void
+LevelLoaderThread::EmitWakeupSignal()
+{
+    this->jobs.Signal();
+}
+
+} // namespace Game
@@ -0,0 +1,48 @@
+#pragma once
+//------------------------------------------------------------------------------
+/**
+    @class Game::LevelLoaderThread
+
+    Background thread that maps and parses levels that are preloaded asynchronously.
+
+    @see Game::World::PreloadLevelAsync
+
+    @copyright
+    (C) 2024 Individual contributors, see AUTHORS file
+*/
+//------------------------------------------------------------------------------
+#include "threading/thread.h"
+#include "threading/safequeue.h"
+#include <functional>
+
+namespace IO
+{
+class IoServer;
+}
+
+namespace Game
+{
+
+class LevelLoaderThread : public Threading::Thread
+{
+    __DeclareClass(LevelLoaderThread);
+public:
+    /// constructor
+    LevelLoaderThread();
+    /// destructor
+    virtual ~LevelLoaderThread();
+
+    /// queue work to be done on the thread
+    void Enqueue(std::function<void()> const& func);
+
+private:
+    /// perform work
+    void DoWork() override;
+    /// emit wakeup signal
+    virtual void EmitWakeupSignal() override;
+
+    Threading::SafeQueue<std::function<void()>> jobs;
+    Ptr<IO::IoServer> ioServer;
+};
+
+} // namespace Game
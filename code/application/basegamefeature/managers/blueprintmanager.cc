@@ -5,7 +5,9 @@
 
 #include "blueprintmanager.h"
 #include "io/jsonreader.h"
+#include "io/jsonpullreader.h"
 #include "io/ioserver.h"
+#include "profiling/profiling.h"
 #include "game/componentserialization.h"
 #include "util/arraystack.h"
 #include "game/gameserver.h"
@@ -42,6 +44,7 @@ BlueprintManager::OnActivate()
     // parse all templates from folders.
     if (IO::IoServer::Instance()->DirectoryExists(this->templatesFolder))
     {
+        N_SCOPE(LoadTemplates, Game);
         this->LoadTemplateFolder(this->templatesFolder);
     }
 }
@@ -84,48 +87,89 @@ BlueprintManager::~BlueprintManager()
 //------------------------------------------------------------------------------
 /**
     This method parses the file data:tables/blueprints.json into
-    the blueprints array.
+    the blueprints array. The file is only read front to back, so it is
+    streamed instead of building a document.
 */
 bool
 BlueprintManager::ParseBlueprint(Util::String const& blueprintsPath)
 {
+    using IO::JsonPullReader;
     if (IO::IoServer::Instance()->FileExists(blueprintsPath))
     {
-        Ptr<IO::JsonReader> jsonReader = IO::JsonReader::Create();
-        jsonReader->SetStream(IO::IoServer::Instance()->CreateStream(blueprintsPath));
-        if (jsonReader->Open())
+        Ptr<JsonPullReader> reader = JsonPullReader::Create();
+        reader->SetStream(IO::IoServer::Instance()->CreateStream(blueprintsPath));
+        if (reader->Open())
         {
             // make sure it's a BluePrints file
-            if (!jsonReader->SetToNode("blueprints"))
+            bool found = false;
+            if (reader->Next() == JsonPullReader::BeginObject)
+            {
+                while (!found && reader->Next() == JsonPullReader::Key)
+                {
+                    if (reader->GetView().Equals("blueprints"))
+                    {
+                        found = true;
+                    }
+                    else
+                    {
+                        reader->SkipValue();
+                    }
+                }
+            }
+            if (!found || reader->Next() != JsonPullReader::BeginObject)
             {
                 n_warning("Warning: BlueprintManager::ParseBlueprints(): not a valid blueprints file!\n");
+                reader->Close();
                 return false;
             }
-            if (jsonReader->SetToFirstChild()) do
+
+            while (reader->Next() == JsonPullReader::Key)
             {
                 Blueprint bluePrint;
-                bluePrint.name = jsonReader->GetCurrentNodeName();
+                bluePrint.name = reader->GetString();
 
-                if (jsonReader->SetToFirstChild("components"))
+                if (reader->Next() == JsonPullReader::BeginObject)
                 {
-                    if (jsonReader->IsArray())
+                    while (reader->Next() == JsonPullReader::Key)
                     {
-                        Util::Array<Util::String> comps;
-                        jsonReader->Get<>(comps);
-                        for (Util::String const& name : comps)
+                        if (!reader->GetView().Equals("components"))
                         {
-                            bluePrint.components.Append({ name });
+                            reader->SkipValue();
+                        }
+                        else if (reader->Next() == JsonPullReader::BeginArray)
+                        {
+                            while (reader->Next() == JsonPullReader::String)
+                            {
+                                bluePrint.components.Append({ reader->GetString() });
+                            }
+                            if (reader->GetToken() != JsonPullReader::EndArray)
+                            {
+                                n_warning("Warning: BlueprintManager::ParseBlueprints(): components of '%s' must be strings!\n", bluePrint.name.Value());
+                                reader->Close();
+                                return false;
+                            }
+                        }
+                        else
+                        {
+                            reader->SkipValue();
                         }
                     }
-                    jsonReader->SetToParent();
+                }
+                else
+                {
+                    reader->SkipValue();
                 }
 
                 this->blueprints.Append(bluePrint);
+            }
 
-            } while (jsonReader->SetToNextChild());
-
-            jsonReader->Close();
-            return true;
+            bool const valid = reader->GetToken() != JsonPullReader::Error;
+            if (!valid)
+            {
+                n_warning("Warning: BlueprintManager::ParseBlueprints(): syntax error in '%s' at offset %d!\n", blueprintsPath.AsCharPtr(), (int)reader->GetErrorOffset());
+            }
+            reader->Close();
+            return valid;
         }
         else
         {
@@ -33,7 +33,7 @@ ReleaseDatasets()
 /**
 */
 Game::Dataset
-Query(Ptr<MemDb::Database> const& db, Util::Array<MemDb::TableId>& tids, Filter filter)
+Query(Ptr<MemDb::Database> const& db, Util::Array<MemDb::TableId>& tids, Filter filter, uint64_t changedSince)
 {
     Game::Dataset data;
     data.numViews = 0;
@@ -59,6 +59,8 @@ Query(Ptr<MemDb::Database> const& db, Util::Array<MemDb::TableId>& tids, Filter
     data.numViews = 0;
 
     Util::FixedArray<ComponentId> const& components = ComponentsInFilter(filter);
+    Util::FixedArray<ComponentId> const& changedComponents = ChangedComponentsInFilter(filter);
+    MemDb::ColumnIndex changedColumns[FilterBuilder::FilterCreateInfo::MAX_CHANGED_COMPONENTS];
 
     for (IndexT tableIndex = 0; tableIndex < tids.Size(); tableIndex++)
     {
@@ -68,13 +70,46 @@ Query(Ptr<MemDb::Database> const& db, Util::Array<MemDb::TableId>& tids, Filter
             SizeT const numRows = tbl.GetNumRows();
             if (numRows > 0)
             {
+                for (IndexT c = 0; c < changedComponents.Size(); c++)
+                {
+                    changedColumns[c] = tbl.GetAttributeIndex(changedComponents[c]);
+                }
+
                 MemDb::Table::Partition* part = tbl.GetFirstActivePartition();
                 while (part != nullptr)
                 {
+                    decltype(MemDb::Table::Partition::modifiedRows) modifiedRows;
+                    if (changedComponents.IsEmpty())
+                    {
+                        modifiedRows = part->modifiedRows;
+                    }
+                    else
+                    {
+                        // gather rows where any of the changed components has been written to
+                        bool anyChanged = false;
+                        for (IndexT c = 0; c < changedComponents.Size(); c++)
+                        {
+                            if (changedColumns[c] != MemDb::ColumnIndex::Invalid() && part->IsModifiedSince(changedColumns[c], changedSince))
+                            {
+                                part->GetModifiedSince(changedColumns[c], changedSince, modifiedRows);
+                                anyChanged = true;
+                            }
+                        }
+
+                        if (!anyChanged)
+                        {
+                            // nothing has been touched in this partition, skip it entirely
+                            part = part->next;
+                            continue;
+                        }
+                    }
+
                     Dataset::View* view = data.views + data.numViews;
                     view->tableId = tids[tableIndex];
                     view->validInstances = part->validRows;
-                    view->modifiedInstances = part->modifiedRows;
+                    view->modifiedInstances = modifiedRows;
+                    view->changeTick = 0;
+                    view->compareWrites = true;
 
                     IndexT i = 0;
                     for (auto component : components)
@@ -31,8 +31,9 @@ class World;
 void DestroyFilter(Filter);
 
 /// Query a subset of tables in a specific db using a specified filter set. Modifies the tables array so that it only contains valid tables.
+/// If the filter has a changed set, only partitions that has been modified after changedSince are returned, with the changed rows in View::modifiedInstances.
 /// This does NOT wait for resources to be available.
-Dataset Query(Ptr<MemDb::Database> const& db, Util::Array<MemDb::TableId>& tables, Filter filter);
+Dataset Query(Ptr<MemDb::Database> const& db, Util::Array<MemDb::TableId>& tables, Filter filter, uint64_t changedSince = 0);
 /// Recycles all current datasets allocated memory to be reused
 void ReleaseDatasets();
 
@@ -0,0 +1,115 @@
+//------------------------------------------------------------------------------
+//  @file commandbuffer.cc
+//  @copyright (C) 2024 Individual contributors, see AUTHORS file
+//------------------------------------------------------------------------------
+#include "foundation/stdneb.h"
+#include "commandbuffer.h"
+
+namespace Game
+{
+
+//------------------------------------------------------------------------------
+/**
+*/
+void
+CommandBuffer::DeleteEntity(Entity entity)
+{
+    this->Record(CommandType::DeleteEntity, entity, 0);
+}
+
+//------------------------------------------------------------------------------
+/**
+*/
+void
+CommandBuffer::AddComponent(Entity entity, ComponentId component, void const* value)
+{
+    Command& cmd = this->Record(CommandType::AddComponent, entity, 1);
+    cmd.values[0] = {component, value != nullptr ? this->CopyValue(component, value) : nullptr};
+}
+
+//------------------------------------------------------------------------------
+/**
+*/
+void
+CommandBuffer::RemoveComponent(Entity entity, ComponentId component)
+{
+    Command& cmd = this->Record(CommandType::RemoveComponent, entity, 1);
+    cmd.values[0] = {component, nullptr};
+}
+
+//------------------------------------------------------------------------------
+/**
+*/
+void
+CommandBuffer::SetComponent(Entity entity, ComponentId component, void const* value)
+{
+    n_assert(value != nullptr);
+    Command& cmd = this->Record(CommandType::SetComponent, entity, 1);
+    cmd.values[0] = {component, this->CopyValue(component, value)};
+}
+
+//------------------------------------------------------------------------------
+/**
+*/
+bool
+CommandBuffer::IsEmpty() const
+{
+    return this->commands.IsEmpty();
+}
+
+//------------------------------------------------------------------------------
+/**
+*/
+void
+CommandBuffer::BeginBatch(uint64_t batch)
+{
+    this->batch = batch;
+    this->sequence = 0;
+}
+
+//------------------------------------------------------------------------------
+/**
+*/
+CommandBuffer::Command&
+CommandBuffer::Record(CommandType type, Entity entity, SizeT numValues)
+{
+    Command cmd;
+    cmd.batch = this->batch;
+    cmd.sequence = this->sequence++;
+    cmd.type = type;
+    cmd.entity = entity;
+    cmd.numValues = numValues;
+    if (numValues > 0)
+        cmd.values = this->allocator.Alloc<ComponentValue>(numValues);
+    this->commands.Append(cmd);
+    return this->commands.Back();
+}
+
+//------------------------------------------------------------------------------
+/**
+*/
+void*
+CommandBuffer::CopyValue(ComponentId component, void const* value)
+{
+    SizeT const typeSize = MemDb::AttributeRegistry::TypeSize(component);
+    if (typeSize == 0)
+        return nullptr;
+
+    void* data = this->allocator.Alloc(typeSize);
+    Memory::Copy(value, data, typeSize);
+    return data;
+}
+
+//------------------------------------------------------------------------------
+/**
+*/
+void
+CommandBuffer::Reset()
+{
+    this->commands.Clear();
+    this->allocator.Release();
+    this->batch = 0;
+    this->sequence = 0;
+}
+
+} // namespace Game
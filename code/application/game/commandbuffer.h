@@ -0,0 +1,153 @@
+#pragma once
+//------------------------------------------------------------------------------
+/**
+    @class Game::CommandBuffer
+
+    @brief Records changes to the entities of a world, to be executed later on the main thread.
+
+    @details Each thread of the job system has its own command buffer per world, so async
+    processors can spawn and destroy entities and add or remove components without any locking.
+    Get the buffer of the calling thread with Game::World::GetCommandBuffer.
+
+    All command buffers of a world are merged and executed at the end of each frame event.
+    Commands are sorted by the processor and view that recorded them, and then by the order
+    they were recorded in, so the result does not depend on which thread ran which view.
+
+    Commands targeting entities that have been deleted by the time the commands are executed are ignored.
+
+    @copyright
+    (C) 2024 Individual contributors, see AUTHORS file
+*/
+//------------------------------------------------------------------------------
+#include "category.h"
+#include "component.h"
+#include "memory/arenaallocator.h"
+
+namespace Game
+{
+
+class World;
+
+class CommandBuffer
+{
+public:
+    /// Record creation of an entity from a template. The component values overrides the template defaults, and are written before the components are initialized.
+    template <typename... TYPES>
+    void CreateEntity(TemplateId templateId, TYPES const&... values);
+    /// Record deletion of an entity
+    void DeleteEntity(Entity entity);
+
+    /// Record adding a component with a value to an entity
+    template <typename TYPE>
+    void AddComponent(Entity entity, TYPE const& value);
+    /// Record adding a component to an entity. If value is null, the default value of the component is used.
+    void AddComponent(Entity entity, ComponentId component, void const* value = nullptr);
+
+    /// Record removal of a component from an entity
+    template <typename TYPE>
+    void RemoveComponent(Entity entity);
+    /// Record removal of a component from an entity
+    void RemoveComponent(Entity entity, ComponentId component);
+
+    /// Record setting the value of a component of an entity
+    template <typename TYPE>
+    void SetComponent(Entity entity, TYPE const& value);
+    /// Record setting the value of a component of an entity
+    void SetComponent(Entity entity, ComponentId component, void const* value);
+
+    /// Returns true if no commands have been recorded
+    bool IsEmpty() const;
+
+    /// Begin a new batch of commands. Called by the frame event before a processor runs on a view.
+    void BeginBatch(uint64_t batch);
+
+private:
+    friend class World;
+
+    enum class CommandType : uint8_t
+    {
+        CreateEntity,
+        DeleteEntity,
+        AddComponent,
+        RemoveComponent,
+        SetComponent
+    };
+
+    struct ComponentValue
+    {
+        ComponentId component = ComponentId::Invalid();
+        void* data = nullptr;
+    };
+
+    struct Command
+    {
+        /// sort key of the processor and view that recorded the command
+        uint64_t batch = 0;
+        /// order within the batch
+        uint32_t sequence = 0;
+        CommandType type = CommandType::CreateEntity;
+        Entity entity = Entity::Invalid();
+        TemplateId templateId = TemplateId::Invalid();
+        /// component values, only CreateEntity commands can have more than one
+        ComponentValue* values = nullptr;
+        SizeT numValues = 0;
+    };
+
+    /// append a command and stamp it with the current batch
+    Command& Record(CommandType type, Entity entity, SizeT numValues);
+    /// copy a component value into the buffer's memory
+    void* CopyValue(ComponentId component, void const* value);
+    /// clear all commands and release their memory
+    void Reset();
+
+    Util::Array<Command> commands;
+    Memory::ArenaAllocator<64_KB> allocator;
+    uint64_t batch = 0;
+    uint32_t sequence = 0;
+};
+
+//------------------------------------------------------------------------------
+/**
+*/
+template <typename... TYPES>
+inline void
+CommandBuffer::CreateEntity(TemplateId templateId, TYPES const&... values)
+{
+    Command& cmd = this->Record(CommandType::CreateEntity, Entity::Invalid(), sizeof...(TYPES));
+    cmd.templateId = templateId;
+
+    [[maybe_unused]] IndexT i = 0;
+    ((cmd.values[i++] = {GetComponentId<TYPES>(), this->CopyValue(GetComponentId<TYPES>(), &values)}), ...);
+}
+
+//------------------------------------------------------------------------------
+/**
+*/
+template <typename TYPE>
+inline void
+CommandBuffer::AddComponent(Entity entity, TYPE const& value)
+{
+    this->AddComponent(entity, GetComponentId<TYPE>(), &value);
+}
+
+//------------------------------------------------------------------------------
+/**
+*/
+template <typename TYPE>
+inline void
+CommandBuffer::RemoveComponent(Entity entity)
+{
+    this->RemoveComponent(entity, GetComponentId<TYPE>());
+}
+
+//------------------------------------------------------------------------------
+/**
+*/
+template <typename TYPE>
+inline void
+CommandBuffer::SetComponent(Entity entity, TYPE const& value)
+{
+    this->SetComponent(entity, GetComponentId<TYPE>(), &value);
+}
+
+} // namespace Game
@@ -43,8 +43,14 @@ struct Dataset
         void* buffers[MAX_COMPONENT_BUFFERS];
         /// which instances are valid in this buffer
         decltype(MemDb::Table::Partition::validRows) validInstances;
-        /// which instances are marked as modified in this buffer. Note that you need to manually mark the entity as modified. @see Game::World::MarkAsModified
+        /// which instances are marked as modified in this buffer.
+        /// If the filter has a changed set, this contains the rows where any of those components were modified since the tick the query was made with.
+        /// Otherwise, you need to manually mark the entity as modified. @see Game::World::MarkAsModified
         decltype(MemDb::Table::Partition::modifiedRows) modifiedInstances;
+        /// change tick that rows written to by a processor are stamped with. Zero if writes aren't tracked.
+        uint64_t changeTick = 0;
+        /// set if written components are compared before and after the processor call, otherwise every processed row is stamped
+        bool compareWrites = true;
     };
 
     /// number of views in views array
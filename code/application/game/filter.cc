@@ -12,8 +12,8 @@ namespace Game
 using ComponentArray = Util::FixedArray<ComponentId>;
 using AccessModeArray = Util::FixedArray<AccessMode>;
 
-// 0: inclusiveMask, 1: exclusiveMask, 2: inclusiveComponents, 3: accessmodes, 4: exclusiveComponents
-static Ids::IdAllocator<InclusiveTableMask, ExclusiveTableMask, ComponentArray, AccessModeArray, ComponentArray> filterAllocator;
+// 0: inclusiveMask, 1: exclusiveMask, 2: inclusiveComponents, 3: accessmodes, 4: exclusiveComponents, 5: changedComponents
+static Ids::IdAllocator<InclusiveTableMask, ExclusiveTableMask, ComponentArray, AccessModeArray, ComponentArray, ComponentArray> filterAllocator;
 
 //------------------------------------------------------------------------------
 /**
@@ -26,6 +26,7 @@ DestroyFilter(Filter filter)
     filterAllocator.Get<2>(filter) = {};
     filterAllocator.Get<3>(filter) = {};
     filterAllocator.Get<4>(filter) = {};
+    filterAllocator.Get<5>(filter) = {};
     filterAllocator.Dealloc(filter);
 }
 
@@ -74,6 +75,15 @@ ExcludedComponentsInFilter(Filter filter)
     return filterAllocator.Get<4>(filter);
 }
 
+//------------------------------------------------------------------------------
+/**
+*/
+Util::FixedArray<ComponentId> const&
+ChangedComponentsInFilter(Filter filter)
+{
+    return filterAllocator.Get<5>(filter);
+}
+
 //------------------------------------------------------------------------------
 /**
 */
@@ -114,6 +124,21 @@ FilterBuilder::Excluding(std::initializer_list<ComponentId> components)
     return *this;
 }
 
+//------------------------------------------------------------------------------
+/**
+*/
+FilterBuilder&
+FilterBuilder::Changed(std::initializer_list<ComponentId> components)
+{
+    for (auto component : components)
+    {
+        int index = this->info.numChanged++;
+        n_assert(index < FilterCreateInfo::MAX_CHANGED_COMPONENTS);
+        this->info.changed[index] = component;
+    }
+    return *this;
+}
+
 //------------------------------------------------------------------------------
 /**
 */
@@ -153,6 +178,14 @@ FilterBuilder::CreateFilter(FilterCreateInfo info)
         accessArray[i] = info.access[i];
     }
 
+    ComponentArray changedArray;
+    changedArray.Resize(info.numChanged);
+    for (uint8_t i = 0; i < info.numChanged; i++)
+    {
+        changedArray[i] = info.changed[i];
+        n_assert2(inclusiveArray.FindIndex(info.changed[i]) != InvalidIndex, "Components checked for changes must be in the inclusive set of the filter!");
+    }
+
 #define VERIFY_FILTERS 1
 #if _DEBUG && VERIFY_FILTERS
     for (auto const& comp : inclusiveArray)
@@ -192,7 +225,8 @@ FilterBuilder::CreateFilter(FilterCreateInfo info)
         ExclusiveTableMask(exclusiveArray),
         inclusiveArray,
         accessArray,
-        exclusiveArray
+        exclusiveArray,
+        changedArray
     );
 
     return filter;
@@ -40,6 +40,8 @@ Util::FixedArray<ComponentId> const& ComponentsInFilter(Filter);
 Util::FixedArray<AccessMode> const& AccessModesInFilter(Filter);
 /// retrieve the excluded component array
 Util::FixedArray<ComponentId> const& ExcludedComponentsInFilter(Filter);
+/// retrieve the array of components that are checked for changes
+Util::FixedArray<ComponentId> const& ChangedComponentsInFilter(Filter);
 
 class FilterBuilder
 {
@@ -63,11 +65,17 @@ public:
     template<typename ... TYPES>
     FilterBuilder& Excluding();
     FilterBuilder& Excluding(std::initializer_list<ComponentId>);
+
+    /// Only rows where any of these components have been modified are considered changed when querying. @see Game::World::Query
+    template<typename ... TYPES>
+    FilterBuilder& Changed();
+    FilterBuilder& Changed(std::initializer_list<ComponentId>);
     Filter Build(); 
 
     struct FilterCreateInfo
     {
         static const uint32_t MAX_EXCLUSIVE_COMPONENTS = 32;
+        static const uint32_t MAX_CHANGED_COMPONENTS = 32;
 
         /// number of components in the inclusive set
         uint8_t numInclusive = 0;
@@ -79,6 +87,10 @@ public:
         uint8_t numExclusive = 0;
         /// exclusive set
         ComponentId exclusive[MAX_EXCLUSIVE_COMPONENTS];
+        /// number of components in the changed set
+        uint8_t numChanged = 0;
+        /// changed set. These should also be part of the inclusive set
+        ComponentId changed[MAX_CHANGED_COMPONENTS];
     };
 
     static Filter CreateFilter(FilterCreateInfo);
@@ -118,6 +130,21 @@ private:
     {
         (SetExclusive<typename std::tuple_element<Is, std::tuple<TYPES...>>::type>(Is), ...);
     }
+
+    template<class TYPE>
+    void SetChanged(size_t const i)
+    {
+        using UnqualifiedType = typename std::remove_const<typename std::remove_reference<TYPE>::type>::type;
+        int offset = info.numChanged++;
+        n_assert(offset < FilterCreateInfo::MAX_CHANGED_COMPONENTS);
+        info.changed[offset] = GetComponentId<UnqualifiedType>();
+    }
+
+    template<typename ... TYPES, std::size_t...Is>
+    void UnrollChangedComponents(std::index_sequence<Is...>)
+    {
+        (SetChanged<typename std::tuple_element<Is, std::tuple<TYPES...>>::type>(Is), ...);
+    }
 };
 
 //------------------------------------------------------------------------------
@@ -142,6 +169,17 @@ FilterBuilder::Excluding()
     return *this;
 }
 
+//------------------------------------------------------------------------------
+/**
+*/
+template<typename ... TYPES>
+inline FilterBuilder&
+FilterBuilder::Changed()
+{
+    UnrollChangedComponents<TYPES...>(std::make_index_sequence<sizeof...(TYPES)>());
+    return *this;
+}
+
 //------------------------------------------------------------------------------
 /**
 */
@@ -26,74 +26,233 @@ FrameBatchJob(SizeT totalJobs, SizeT groupSize, IndexT groupIndex, SizeT invocat
             return;
 
         ProcessorJobInput const& input = context->inputs[index];
+        context->world->GetCommandBuffer().BeginBatch(input.commandBatch);
         input.processor->callback(context->world, *input.view);
     }
 }
 
+//------------------------------------------------------------------------------
+/**
+    Commands recorded by a processor are sorted by schedule node, then by view.
+    Zero is left for commands recorded outside of processors.
+*/
+static uint64_t
+CommandBatch(IndexT node, IndexT view)
+{
+    return ((uint64_t)(node + 1) << 32) | (uint64_t)view;
+}
+
 //------------------------------------------------------------------------------
 /**
 */
 FrameEvent::~FrameEvent()
 {
-    for (SizeT i = 0; i < this->batches.Size(); i++)
+    for (SizeT i = 0; i < this->schedule.Size(); i++)
     {
-        delete this->batches[i];
+        delete this->schedule[i].processor;
     }
 }
 
 //------------------------------------------------------------------------------
 /**
+    Executes the dependency graph.
+
+    The main thread drives the graph; it queries the dataset of a processor
+    once all of its predecessors have finished, so that change detection sees
+    the writes of the predecessors, and then dispatches one job per view. Each
+    processor has its own done counter, and all processors signal the same event
+    so that the main thread can wake up as soon as any of them has finished.
+    A signal left over from the previous run only makes the main thread check
+    the counters once more.
 */
 void
 FrameEvent::Run(World* world)
 {
-    for (SizeT i = 0; i < this->batches.Size(); i++)
+    this->timer.Reset();
+    this->timer.Start();
+
+    SizeT const numNodes = this->schedule.Size();
+    if (numNodes == 0)
+    {
+        this->timer.Stop();
+        this->runTime = 0;
+        this->criticalPathTime = 0;
+        return;
+    }
+
+    enum class NodeState : uint8_t
+    {
+        Waiting,
+        Running,
+        Finished
+    };
+
+    Util::FixedArray<NodeState> states(numNodes, NodeState::Waiting);
+    Util::FixedArray<SizeT> numPendingPredecessors(numNodes);
+    Util::FixedArray<Dataset> datasets(numNodes);
+    Util::FixedArray<uint64_t> ticks(numNodes, 0);
+    Util::FixedArray<ProcessorJobInput*> inputs(numNodes, nullptr);
+    Threading::AtomicCounter* counters = new Threading::AtomicCounter[numNodes];
+
+    Util::Array<IndexT> ready;
+    ready.Reserve(numNodes);
+    for (IndexT i = 0; i < numNodes; i++)
+    {
+        numPendingPredecessors[i] = this->schedule[i].predecessors.Size();
+        if (numPendingPredecessors[i] == 0)
+            ready.Append(i);
+    }
+
+    SizeT numFinished = 0;
+    SizeT numRunning = 0;
+
+    auto Finish = [&](IndexT n)
+    {
+        ScheduleNode& node = this->schedule[n];
+
+        // processors skipped in editor has no tick
+        if (ticks[n] != 0)
+            node.processor->lastRunTick = ticks[n];
+
+        node.end = this->timer.GetTime();
+        states[n] = NodeState::Finished;
+        numFinished++;
+
+        for (IndexT s = 0; s < node.successors.Size(); s++)
+        {
+            IndexT const successor = node.successors[s];
+            if (--numPendingPredecessors[successor] == 0)
+                ready.Append(successor);
+        }
+    };
+
+    auto Start = [&](IndexT n)
     {
-        if (this->batches[i]->async)
+        ScheduleNode& node = this->schedule[n];
+        Processor* processor = node.processor;
+        node.start = this->timer.GetTime();
+
+#ifdef WITH_NEBULA_EDITOR
+        if (Game::EditorState::HasInstance())
+        {
+            Game::EditorState* editor = Game::EditorState::Instance();
+            if (editor->isRunning && !editor->isPlaying && !processor->runInEditor)
+            {
+                Finish(n);
+                return;
+            }
+        }
+#endif
+        // each processor gets its own tick, so that it won't pick up its own writes the next time it runs
+        ticks[n] = world->AdvanceChangeTick();
+        datasets[n] = world->Query(processor->filter, processor->cache, processor->lastRunTick);
+
+        // the processor stamps the rows it actually writes to with its tick, see ProcessorWriteTracker
+        for (IndexT v = 0; v < datasets[n].numViews; v++)
         {
-            this->pipeline->inAsync = true;
+            datasets[n].views[v].changeTick = ticks[n];
+            datasets[n].views[v].compareWrites = !processor->stampAllWrites;
         }
 
-        this->batches[i]->Execute(world);
+        if (!processor->async)
+        {
+            // barriers run on the main thread, when nothing else is running
+            n_assert(numRunning == 0);
+            for (int v = 0; v < datasets[n].numViews; v++)
+            {
+                world->GetCommandBuffer().BeginBatch(CommandBatch(n, v));
+                processor->callback(world, datasets[n].views[v]);
+            }
+            Finish(n);
+            return;
+        }
 
-        this->pipeline->inAsync = false;
+        if (datasets[n].numViews == 0)
+        {
+            Finish(n);
+            return;
+        }
+
+        inputs[n] = new ProcessorJobInput[datasets[n].numViews];
+        for (IndexT v = 0; v < datasets[n].numViews; v++)
+        {
+            inputs[n][v].processor = processor;
+            inputs[n][v].view = datasets[n].views + v;
+            inputs[n][v].commandBatch = CommandBatch(n, v);
+        }
+
+        ProcessorJobContext context;
+        context.world = world;
+        context.inputs = inputs[n];
+
+        counters[n] = 1;
+        states[n] = NodeState::Running;
+        numRunning++;
+        this->pipeline->inAsync = true;
+        Jobs2::JobDispatch(FrameBatchJob, datasets[n].numViews, 1, context, nullptr, &counters[n], &this->finishedEvent);
+    };
+
+    IndexT readyIndex = 0;
+    while (numFinished < numNodes)
+    {
+        // start everything that has no unfinished predecessors. Finishing a node can make more nodes ready.
+        while (readyIndex < ready.Size())
+        {
+            Start(ready[readyIndex++]);
+        }
+
+        if (numFinished == numNodes)
+            break;
+
+        // the graph is acyclic, so if nothing can be started something has to be running
+        n_assert(numRunning > 0);
+        this->finishedEvent.Wait();
+
+        for (IndexT i = 0; i < numNodes; i++)
+        {
+            if (states[i] == NodeState::Running && counters[i] == 0)
+            {
+                delete[] inputs[i];
+                inputs[i] = nullptr;
+                numRunning--;
+                Finish(i);
+            }
+        }
+
+        if (numRunning == 0)
+            this->pipeline->inAsync = false;
     }
+
+    delete[] counters;
+
+    // spawn and destroy entities recorded by the processors, in the order of the schedule
+    world->ExecuteDeferredCommands();
+
+    this->timer.Stop();
+    this->runTime = this->timer.GetTime();
+    this->UpdateCriticalPath();
 }
 
 //------------------------------------------------------------------------------
 /**
+    Insert the processor after all processors with the same or lower order, and rebuild the graph.
 */
 void
 FrameEvent::AddProcessor(Processor* processor)
 {
-    bool accepted = false;
-    int i;
-
-    // try to insert into existing batches
-    for (i = 0; i < this->batches.Size(); i++)
+    IndexT i;
+    for (i = 0; i < this->schedule.Size(); i++)
     {
-        if (this->batches[i]->async == processor->async &&
-            this->batches[i]->order == processor->order)
-        {
-            accepted = this->batches[i]->TryInsert(processor);
-            if (accepted)
-                break;
-        }
-        if (this->batches[i]->order > processor->order)
+        if (this->schedule[i].processor->order > processor->order)
         {
             break;
         }
     }
 
-    if (!accepted)
-    {
-        FrameEvent::Batch* batch = new FrameEvent::Batch();
-        batch->async = processor->async;
-        batch->order = processor->order;
-        bool res = batch->TryInsert(processor);
-        n_assert(res);
-        this->batches.Insert(i, batch);
-    }
+    ScheduleNode node;
+    node.processor = processor;
+    this->schedule.Insert(i, node);
+    this->BuildSchedule();
 }
 
 //------------------------------------------------------------------------------
@@ -102,9 +261,14 @@ FrameEvent::AddProcessor(Processor* processor)
 void
 FrameEvent::Prefilter(World* world, bool force)
 {
-    for (SizeT i = 0; i < this->batches.Size(); i++)
+    for (SizeT i = 0; i < this->schedule.Size(); i++)
     {
-        this->batches[i]->Prefilter(world, force);
+        Processor* processor = this->schedule[i].processor;
+        if (!processor->cacheValid || force)
+        {
+            processor->cache = world->GetDatabase()->Query(GetInclusiveTableMask(processor->filter), GetExclusiveTableMask(processor->filter));
+            processor->cacheValid = true;
+        }
     }
 }
 
@@ -114,224 +278,203 @@ FrameEvent::Prefilter(World* world, bool force)
 void
 FrameEvent::CacheTable(MemDb::TableId tid, MemDb::TableSignature const& signature)
 {
-    for (SizeT i = 0; i < this->batches.Size(); i++)
+    for (SizeT i = 0; i < this->schedule.Size(); i++)
     {
-        this->batches[i]->CacheTable(tid, signature);
+        Processor* processor = this->schedule[i].processor;
+        if (MemDb::TableSignature::CheckBits(signature, GetInclusiveTableMask(processor->filter)))
+        {
+            MemDb::TableSignature const& exclusive = GetExclusiveTableMask(processor->filter);
+            if (exclusive.IsValid())
+            {
+                if (!MemDb::TableSignature::HasAny(signature, exclusive))
+                    processor->cache.Append(tid);
+            }
+            else
+            {
+                processor->cache.Append(tid);
+            }
+        }
     }
 }
 
 //------------------------------------------------------------------------------
 /**
 */
-Util::Array<FrameEvent::Batch const*> const
-FrameEvent::GetBatches() const
+Util::Array<FrameEvent::ScheduleNode> const&
+FrameEvent::GetSchedule() const
 {
-    Util::Array<FrameEvent::Batch const*> batches;
-    for (IndexT i = 0; i < this->batches.Size(); i++)
-    {
-        batches.Append(this->batches[i]);
-    }
+    return this->schedule;
+}
 
-    return batches;
+//------------------------------------------------------------------------------
+/**
+*/
+Timing::Time
+FrameEvent::GetCriticalPathTime() const
+{
+    return this->criticalPathTime;
 }
 
 //------------------------------------------------------------------------------
 /**
 */
-FrameEvent::Batch::~Batch()
+Timing::Time
+FrameEvent::GetRunTime() const
 {
-    for (SizeT i = 0; i < this->processors.Size(); i++)
-    {
-        delete this->processors[i];
-    }
+    return this->runTime;
 }
 
 //------------------------------------------------------------------------------
 /**
+    Async nodes are drawn as ellipses, barriers as boxes.
+    Nodes on the critical path of the last run are drawn in red.
 */
 void
-FrameEvent::Batch::Execute(World* world)
+FrameEvent::DumpSchedule(Util::String& out) const
 {
-    if (this->async)
+    out.Append(Util::String::Sprintf("    subgraph \"cluster_%s\"\n    {\n", this->name.Value()));
+    out.Append(Util::String::Sprintf(
+        "        label=\"%s (order %d) | run %.3f ms | critical path %.3f ms\";\n",
+        this->name.Value(), this->order, this->runTime * 1000.0, this->criticalPathTime * 1000.0
+    ));
+
+    for (IndexT i = 0; i < this->schedule.Size(); i++)
     {
-        this->ExecuteAsync(world);
+        ScheduleNode const& node = this->schedule[i];
+        out.Append(Util::String::Sprintf(
+            "        \"%s_%d\" [label=\"%s\\norder %d | %.3f ms\", shape=%s%s];\n",
+            this->name.Value(), i,
+            node.processor->name.AsCharPtr(),
+            node.processor->order,
+            (node.end - node.start) * 1000.0,
+            node.processor->async ? "ellipse" : "box",
+            node.critical ? ", color=red" : ""
+        ));
     }
-    else
+
+    for (IndexT i = 0; i < this->schedule.Size(); i++)
     {
-        this->ExecuteSequential(world);
+        ScheduleNode const& node = this->schedule[i];
+        for (IndexT s = 0; s < node.successors.Size(); s++)
+        {
+            bool const critical = node.critical && this->schedule[node.successors[s]].critical;
+            out.Append(Util::String::Sprintf(
+                "        \"%s_%d\" -> \"%s_%d\"%s;\n",
+                this->name.Value(), i,
+                this->name.Value(), node.successors[s],
+                critical ? " [color=red]" : ""
+            ));
+        }
     }
+    out.Append("    }\n");
 }
 
 //------------------------------------------------------------------------------
 /**
 */
 bool
-FrameEvent::Batch::TryInsert(Processor* processor)
+FrameEvent::HasConflict(Processor const* a, Processor const* b)
 {
-    // if the batch is async, check so that we don't
-    // have multiple writers to the same components
-    if (processor->async)
+    // processors that run on the main thread can do anything
+    if (!a->async || !b->async)
+        return true;
+
+    // check so that we don't have multiple writers to the same components
+    Util::FixedArray<ComponentId> const& components = Game::ComponentsInFilter(a->filter);
+    Util::FixedArray<AccessMode> const& access = Game::AccessModesInFilter(a->filter);
+    Util::FixedArray<ComponentId> const& otherComponents = Game::ComponentsInFilter(b->filter);
+    Util::FixedArray<AccessMode> const& otherAccess = Game::AccessModesInFilter(b->filter);
+    for (IndexT i = 0; i < components.Size(); i++)
     {
-        Util::FixedArray<ComponentId> const& components = Game::ComponentsInFilter(processor->filter);
-        Util::FixedArray<AccessMode> const& access = Game::AccessModesInFilter(processor->filter);
-        for (IndexT i = 0; i < components.Size(); i++)
+        for (IndexT k = 0; k < otherComponents.Size(); k++)
         {
-            for (auto other : this->processors)
+            if (otherComponents[k] == components[i])
             {
-                auto const& otherComponents = Game::ComponentsInFilter(other->filter);
-                auto const& otherAccess = Game::AccessModesInFilter(other->filter);
-                for (IndexT k = 0; k < otherComponents.Size(); k++)
+                if (otherAccess[k] == AccessMode::WRITE || access[i] == AccessMode::WRITE)
                 {
-                    if (otherComponents[k] == components[i])
-                    {
-                        if (otherAccess[k] == AccessMode::WRITE || access[i] == AccessMode::WRITE)
-                        {
-                            // Some processor is already writing to this component, or we're trying to write, and some other is already reading.
-                            // Either way, we cannot add the processor since it will cause races.
-                            return false;
-                        }
-                        break; // we can break because a component should never exist twice in the filter
-                    }
+                    // One of the processors is writing to a component that the other is reading or writing to.
+                    return true;
                 }
+                break; // we can break because a component should never exist twice in the filter
             }
         }
     }
-
-    this->processors.Append(processor);
-    return true;
+    return false;
 }
 
 //------------------------------------------------------------------------------
 /**
+    Nodes are already sorted by order, so every edge goes from a lower to a higher index,
+    which makes the node order a valid topological order.
 */
 void
-FrameEvent::Batch::Prefilter(World* world, bool force)
+FrameEvent::BuildSchedule()
 {
-    for (SizeT i = 0; i < this->processors.Size(); i++)
+    for (IndexT i = 0; i < this->schedule.Size(); i++)
     {
-        Processor* processor = this->processors[i];
-        if (!processor->cacheValid || force)
-        {
-            processor->cache = world->GetDatabase()->Query(GetInclusiveTableMask(processor->filter), GetExclusiveTableMask(processor->filter));
-            processor->cacheValid = true;
-        }
+        this->schedule[i].predecessors.Clear();
+        this->schedule[i].successors.Clear();
     }
-}
 
-//------------------------------------------------------------------------------
-/**
-*/
-void
-FrameEvent::Batch::CacheTable(MemDb::TableId tid, MemDb::TableSignature const& signature)
-{
-    for (SizeT i = 0; i < this->processors.Size(); i++)
+    for (IndexT j = 0; j < this->schedule.Size(); j++)
     {
-        Processor* processor = this->processors[i];
-        if (MemDb::TableSignature::CheckBits(signature, GetInclusiveTableMask(processor->filter)))
+        Processor const* processor = this->schedule[j].processor;
+        for (IndexT i = j - 1; i >= 0; i--)
         {
-            MemDb::TableSignature const& exclusive = GetExclusiveTableMask(processor->filter);
-            if (exclusive.IsValid())
+            Processor const* other = this->schedule[i].processor;
+            if (HasConflict(other, processor))
             {
-                if (!MemDb::TableSignature::HasAny(signature, exclusive))
-                    processor->cache.Append(tid);
+                this->schedule[j].predecessors.Append(i);
+                this->schedule[i].successors.Append(j);
             }
-            else
-            {
-                processor->cache.Append(tid);
-            }
-        }
-    }
-}
 
-//------------------------------------------------------------------------------
-/**
-*/
-Util::Array<Processor const*>
-FrameEvent::Batch::GetProcessors() const
-{
-    Util::Array<Processor const*> procs;
-    for (IndexT i = 0; i < this->processors.Size(); i++)
-    {
-        procs.Append(this->processors[i]);
+            // everything before a barrier is already ordered by the barrier
+            if (!other->async)
+                break;
+        }
     }
-
-    return procs;
 }
 
 //------------------------------------------------------------------------------
 /**
+    The critical path is the chain of dependent processors with the longest
+    total duration. It is the lower bound of the time it takes to run the frame event,
+    no matter how many threads are available.
 */
 void
-FrameEvent::Batch::ExecuteAsync(World* world)
+FrameEvent::UpdateCriticalPath()
 {
-    Util::FixedArray<Dataset> datasets(this->processors.Size());
-
-    uint32_t numJobs = 0;
-
-    for (IndexT i = 0; i < this->processors.Size(); i++)
+    IndexT last = InvalidIndex;
+    this->criticalPathTime = 0;
+    for (IndexT i = 0; i < this->schedule.Size(); i++)
     {
-        Processor* processor = this->processors[i];
-
-#ifdef WITH_NEBULA_EDITOR
-        if (Game::EditorState::HasInstance())
+        ScheduleNode& node = this->schedule[i];
+        node.critical = false;
+        node.criticalPathTime = 0;
+        for (IndexT p = 0; p < node.predecessors.Size(); p++)
         {
-            Game::EditorState* editor = Game::EditorState::Instance();
-            if (editor->isRunning && !editor->isPlaying && !processor->runInEditor)
-                continue;
+            node.criticalPathTime = Math::max(node.criticalPathTime, this->schedule[node.predecessors[p]].criticalPathTime);
         }
-#endif
-        datasets[i] = world->Query(processor->filter, processor->cache);
-        numJobs += datasets[i].numViews;
+        node.criticalPathTime += node.end - node.start;
 
-    }
-
-    if (numJobs == 0)
-        return;
-
-    ProcessorJobContext context;
-    context.world = world;
-    context.inputs = new ProcessorJobInput[numJobs];
-
-    IndexT inputIndex = 0;
-    for (IndexT i = 0; i < datasets.Size(); i++)
-    {
-        for (IndexT v = 0; v < datasets[i].numViews; v++, inputIndex++)
+        if (last == InvalidIndex || node.criticalPathTime > this->criticalPathTime)
         {
-            context.inputs[inputIndex].processor = this->processors[i];
-            context.inputs[inputIndex].view = datasets[i].views + v;
+            this->criticalPathTime = node.criticalPathTime;
+            last = i;
         }
     }
 
-    Threading::Event event;
-    Jobs2::JobDispatch(FrameBatchJob, numJobs, 1, context, nullptr, nullptr, &event);
-    event.Wait();
-
-    delete[] context.inputs;
-}
-
-//------------------------------------------------------------------------------
-/**
-*/
-void
-FrameEvent::Batch::ExecuteSequential(World* world)
-{
-    for (SizeT i = 0; i < this->processors.Size(); i++)
+    // walk back through the slowest predecessors
+    while (last != InvalidIndex)
     {
-        Processor* processor = this->processors[i];
-
-#ifdef WITH_NEBULA_EDITOR
-        if (Game::EditorState::HasInstance())
+        ScheduleNode& node = this->schedule[last];
+        node.critical = true;
+        last = InvalidIndex;
+        for (IndexT p = 0; p < node.predecessors.Size(); p++)
         {
-            Game::EditorState* editor = Game::EditorState::Instance();
-            if (editor->isRunning && !editor->isPlaying && !processor->runInEditor)
-                continue;
-        }
-#endif
-
-        Dataset data = world->Query(processor->filter, processor->cache);
-        for (int v = 0; v < data.numViews; v++)
-        {
-            processor->callback(world, data.views[v]);
+            IndexT const predecessor = node.predecessors[p];
+            if (last == InvalidIndex || this->schedule[predecessor].criticalPathTime > this->schedule[last].criticalPathTime)
+                last = predecessor;
         }
     }
 }
@@ -513,5 +656,21 @@ FramePipeline::GetFrameEvents() const
     return events;
 }
 
+//------------------------------------------------------------------------------
+/**
+    Returns the dependency graphs of all frame events, in graphviz dot format.
+*/
+Util::String
+FramePipeline::DumpSchedule() const
+{
+    Util::String out = "digraph FramePipeline\n{\n    compound=true;\n";
+    for (IndexT i = 0; i < this->frameEvents.Size(); i++)
+    {
+        this->frameEvents[i]->DumpSchedule(out);
+    }
+    out.Append("}\n");
+    return out;
+}
+
 } // namespace Game
 
@@ -9,6 +9,8 @@
 //------------------------------------------------------------------------------
 #include "game/processor.h"
 #include "threading/assertingmutex.h"
+#include "threading/event.h"
+#include "timing/timer.h"
 
 namespace Game
 {
@@ -19,6 +21,8 @@ struct ProcessorJobInput
 {
     Game::Dataset::View* view;
     Processor* processor;
+    /// sort key of the commands recorded by the job
+    uint64_t commandBatch;
 };
 
 struct ProcessorJobContext
@@ -29,6 +33,16 @@ struct ProcessorJobContext
 
 //------------------------------------------------------------------------------
 /**
+    A frame event executes its processors as a dependency graph.
+
+    Two processors depend on each other if they both access the same component,
+    and at least one of them writes to it. Processors that are not async act
+    as barriers, since they run on the main thread and can touch anything.
+    Dependencies always go from lower to higher order, and from earlier to later
+    registered processors within the same order.
+
+    Async processors are dispatched as jobs as soon as all their predecessors
+    have finished, without waiting for unrelated processors.
 */
 class FrameEvent
 {
@@ -36,7 +50,22 @@ public:
     FrameEvent() = default;
     ~FrameEvent();
 
-    class Batch;
+    /// a processor in the dependency graph of the frame event
+    struct ScheduleNode
+    {
+        Processor* processor = nullptr;
+        /// nodes that must be finished before this node can start
+        Util::Array<IndexT> predecessors;
+        /// nodes that wait for this node to finish
+        Util::Array<IndexT> successors;
+        /// time when the node started and finished in the last run, relative to the start of the frame event
+        Timing::Time start = 0;
+        Timing::Time end = 0;
+        /// sum of the durations of the longest dependency chain ending in this node, in the last run
+        Timing::Time criticalPathTime = 0;
+        /// set if the node was on the critical path in the last run
+        bool critical = false;
+    };
 
     void Run(World* world);
     void AddProcessor(Processor* processor);
@@ -49,55 +78,37 @@ public:
     Util::StringAtom name;
     int order = 100;
 
-    Util::Array<Batch const*> const GetBatches() const;
+    /// get the dependency graph of the frame event, sorted by execution order
+    Util::Array<ScheduleNode> const& GetSchedule() const;
+    /// get the total duration of the critical path in the last run
+    Timing::Time GetCriticalPathTime() const;
+    /// get the wall time of the last run
+    Timing::Time GetRunTime() const;
+    /// write the dependency graph of the frame event as a graphviz subgraph
+    void DumpSchedule(Util::String& out) const;
 
 private:
     friend FramePipeline;
 
+    /// check if two processors can not run simultaneously
+    static bool HasConflict(Processor const* a, Processor const* b);
+    /// rebuild the dependency graph
+    void BuildSchedule();
+    /// find the critical path of the last run
+    void UpdateCriticalPath();
+
     /// Which pipeline is this event attached to
     FramePipeline* pipeline;
 
-    /// Batches that this event will execute
-    Util::Array<Batch*> batches;
-};
-
-
-//------------------------------------------------------------------------------
-/**
-    A batch of frame callbacks
-*/
-class FrameEvent::Batch
-{
-public:
-    Batch() = default;
-    ~Batch();
-
-    void Execute(World* world);
-
-    /// Try to insert a processor into the batch.
-    /// Can reject the processor if the batch is executed
-    /// async, and the processor is not allowed to run
-    /// simultaneously as the other processor. In this
-    /// case, use linear probing to insert the processor
-    /// into a new batch
-    bool TryInsert(Processor* processor);
-
-    /// prefilter all processors. Should not be done per frame - instead use CacheTable if you need to do incremental caching
-    void Prefilter(World* world, bool force = false);
-    /// add a table to the cache of any processors that accepts it, that is attached to this frame batch
-    void CacheTable(MemDb::TableId, MemDb::TableSignature const&);
-
-    /// sorting order in frame event
-    int order = 100;
-    bool async = false;
-
-    Util::Array<Processor const*> GetProcessors() const;
-
-private:
-    void ExecuteAsync(World* world);
-    void ExecuteSequential(World* world);
-
-    Util::Array<Processor*> processors;
+    /// All processors of this event as a dependency graph
+    Util::Array<ScheduleNode> schedule;
+    /// signaled by the processor jobs when they finish. Workers signal after decrementing their done counter,
+    /// so the event can be signaled after Run has returned, and has to outlive it.
+    Threading::Event finishedEvent;
+    /// timer used for measuring the processors
+    Timing::Timer timer;
+    Timing::Time criticalPathTime = 0;
+    Timing::Time runTime = 0;
 };
 
 
@@ -125,7 +136,7 @@ public:
     /// Run until the pipeline ends
     void RunRemaining();
 
-    /// check if the pipeline is currently executing an async frame event batch
+    /// check if the pipeline is currently executing async processors
     bool IsRunningAsync();
 
     /// prefilter all processors. Should not be done per frame - instead use CacheTable if you need to do incremental caching
@@ -135,6 +146,8 @@ public:
 
     // get read copy of frame events. This is not thread safe to read from!
     Util::Array<FrameEvent const*> const GetFrameEvents() const;
+    /// get the dependency graphs of all frame events in graphviz dot format
+    Util::String DumpSchedule() const;
 
 private:
     friend FrameEvent;
@@ -6,10 +6,25 @@
 #include "processor.h"
 #include "gameserver.h"
 #include "basegamefeature/components/basegamefeature.h"
+#include "world.h"
+#include "memdb/database.h"
 
 namespace Game
 {
 
+//------------------------------------------------------------------------------
+/**
+    Called from the processor jobs. Views of a processor are different
+    partitions, and processors that write the same component don't run
+    at the same time.
+*/
+void
+MarkWrittenRows(World* world, Dataset::View const& view, ComponentId component, Util::BitField<MemDb::Table::Partition::CAPACITY> const& rows)
+{
+    MemDb::Table& table = world->GetDatabase()->GetTable(view.tableId);
+    table.GetPartition(view.partitionId)->MarkModified(table.GetAttributeIndex(component), rows, view.changeTick);
+}
+
 //------------------------------------------------------------------------------
 /**
 */
@@ -67,6 +82,19 @@ ProcessorBuilder::OnlyModified()
     return *this;
 }
 
+//------------------------------------------------------------------------------
+/**
+    Processors that write to most of the instances they process don't gain
+    anything from comparing the components, and can skip the copy and
+    compare of every instance. Rows they only read are stamped as well.
+*/
+ProcessorBuilder&
+ProcessorBuilder::StampAllWrites()
+{
+    this->stampAllWrites = true;
+    return *this;
+}
+
 //------------------------------------------------------------------------------
 /**
 */
@@ -98,6 +126,8 @@ ProcessorBuilder::Build()
     Processor* processor = new Processor();
     processor->name = this->name.AsString();
     processor->async = this->async;
+    processor->onlyModified = this->onlyModified;
+    processor->stampAllWrites = this->stampAllWrites;
     processor->order = this->order;
     processor->filter = this->filterBuilder.Build();
 
@@ -18,15 +18,157 @@ class World;
 
 class ProcessorBuilder;
 
+/// stamp rows of a component in a view with the change tick of the view
+void MarkWrittenRows(World* world, Dataset::View const& view, ComponentId component, Util::BitField<MemDb::Table::Partition::CAPACITY> const& rows);
+
+//------------------------------------------------------------------------------
+/**
+    Size of a component a processor can write to, zero if it takes it by value or const reference
+*/
+template <typename TYPE>
+constexpr SizeT
+ProcessorWritableSize()
+{
+    using UnqualifiedType = typename std::remove_reference<TYPE>::type;
+    if constexpr (std::is_reference<TYPE>::value && !std::is_const<UnqualifiedType>::value)
+        return sizeof(UnqualifiedType);
+    else
+        return 0;
+}
+
+//------------------------------------------------------------------------------
+/**
+    Finds the rows a processor writes to. Every component the processor takes
+    by non-const reference is tracked, so change ticks are always up to date.
+    By default the components are compared before and after every call, and
+    only rows whose bytes changed are stamped. Processors built with
+    ProcessorBuilder::StampAllWrites skip the comparison and stamp every row
+    they process instead.
+*/
+template <typename... TYPES>
+class ProcessorWriteTracker
+{
+public:
+    /// constructor, nothing is tracked if the view has no change tick
+    ProcessorWriteTracker(Dataset::View const& view);
+    /// check if any component is tracked
+    bool IsActive() const;
+    /// copy the tracked components of an instance before it is processed
+    void Before(Dataset::View const& view, uint32_t instance);
+    /// compare the tracked components of an instance after it has been processed, or just mark it
+    void After(Dataset::View const& view, uint32_t instance);
+    /// stamp the rows that have been written to
+    void Commit(World* world, Dataset::View const& view) const;
+
+private:
+    static constexpr SizeT NumComponents = sizeof...(TYPES);
+    // the last element pads the arrays of processors without components
+    static constexpr SizeT Sizes[NumComponents + 1] = { ProcessorWritableSize<TYPES>()..., 0 };
+    static constexpr SizeT ScratchSize = (ProcessorWritableSize<TYPES>() + ... + 0);
+
+    bool active = false;
+    bool compare = true;
+    bool tracked[NumComponents + 1] = {};
+    ComponentId components[NumComponents + 1];
+    Util::BitField<MemDb::Table::Partition::CAPACITY> written[NumComponents + 1];
+    alignas(16) char scratch[ScratchSize + 1];
+};
+
+//------------------------------------------------------------------------------
+/**
+*/
+template <typename... TYPES>
+inline
+ProcessorWriteTracker<TYPES...>::ProcessorWriteTracker(Dataset::View const& view)
+{
+    IndexT i = 0;
+    ((this->components[i++] = GetComponentId<typename std::remove_const<typename std::remove_reference<TYPES>::type>::type>()), ...);
+    if (view.changeTick == 0)
+        return;
+
+    this->compare = view.compareWrites;
+    for (i = 0; i < NumComponents; i++)
+    {
+        // flag types have no buffers, and can't be written to
+        this->tracked[i] = Sizes[i] > 0 && view.buffers[i] != nullptr;
+        this->active |= this->tracked[i];
+    }
+}
+
+//------------------------------------------------------------------------------
+/**
+*/
+template <typename... TYPES>
+inline bool
+ProcessorWriteTracker<TYPES...>::IsActive() const
+{
+    return this->active;
+}
+
+//------------------------------------------------------------------------------
+/**
+*/
+template <typename... TYPES>
+inline void
+ProcessorWriteTracker<TYPES...>::Before(Dataset::View const& view, uint32_t instance)
+{
+    if (!this->compare)
+        return;
+
+    SizeT offset = 0;
+    for (IndexT i = 0; i < NumComponents; i++)
+    {
+        if (this->tracked[i])
+            Memory::Copy((char*)view.buffers[i] + Sizes[i] * instance, this->scratch + offset, Sizes[i]);
+        offset += Sizes[i];
+    }
+}
+
+//------------------------------------------------------------------------------
+/**
+*/
+template <typename... TYPES>
+inline void
+ProcessorWriteTracker<TYPES...>::After(Dataset::View const& view, uint32_t instance)
+{
+    SizeT offset = 0;
+    for (IndexT i = 0; i < NumComponents; i++)
+    {
+        if (this->tracked[i] && (!this->compare || memcmp((char*)view.buffers[i] + Sizes[i] * instance, this->scratch + offset, Sizes[i]) != 0))
+            this->written[i].SetBit(instance);
+        offset += Sizes[i];
+    }
+}
+
+//------------------------------------------------------------------------------
+/**
+*/
+template <typename... TYPES>
+inline void
+ProcessorWriteTracker<TYPES...>::Commit(World* world, Dataset::View const& view) const
+{
+    for (IndexT i = 0; i < NumComponents; i++)
+    {
+        if (this->tracked[i] && !this->written[i].IsNull())
+            MarkWrittenRows(world, view, this->components[i], this->written[i]);
+    }
+}
+
 class Processor
 {
 public:
     /// name of the processor
     Util::String name;
-    /// sorting order within frame event (same as batch order).
+    /// sorting order within frame event. The processor runs after every processor with a lower order that it shares components with.
     int order = 100;
     /// set if this processor should run as a job.
     bool async = false;
+    /// set if this processor only processes modified instances
+    bool onlyModified = false;
+    /// set if every processed row of the components the processor can write to is stamped, without comparing them
+    bool stampAllWrites = false;
+    /// change tick of the last execution. Used to find the components that has changed since then
+    uint64_t lastRunTick = 0;
     /// filter used for creating the dataset
     Filter filter;
     /// function that this processor runs
@@ -59,6 +201,7 @@ private:
     {
         return [func, bufferStartOffset](World* world, Game::Dataset::View const& view)
         {
+            ProcessorWriteTracker<COMPONENTS...> tracker(view);
             uint16_t i = 0;
             while (i < view.numInstances)
             {
@@ -71,6 +214,8 @@ private:
                         // make sure the instance we're processing is valid
                         if (view.validInstances.IsSet(instance))
                         {
+                            if (tracker.IsActive())
+                                tracker.Before(view, instance);
                             UpdateExpander<COMPONENTS...>(
                                 world,
                                 func,
@@ -79,12 +224,16 @@ private:
                                 bufferStartOffset,
                                 std::make_index_sequence<sizeof...(COMPONENTS)>()
                             );
+                            if (tracker.IsActive())
+                                tracker.After(view, instance);
                         }
                     }
                 }
                 // progress 64 instances, which corresponds to 1 section
                 i += 64;
             }
+            if (tracker.IsActive())
+                tracker.Commit(world, view);
         };
     }
 
@@ -94,6 +243,7 @@ private:
     {
         return [func, bufferStartOffset](World* world, Game::Dataset::View const& view)
         {
+            ProcessorWriteTracker<COMPONENTS...> tracker(view);
             uint16_t i = 0;
             while (i < view.numInstances)
             {
@@ -108,6 +258,8 @@ private:
                         // make sure the instance we're processing is valid
                         if (view.validInstances.IsSet(instance) && view.modifiedInstances.IsSet(instance))
                         {
+                            if (tracker.IsActive())
+                                tracker.Before(view, instance);
                             UpdateExpander<COMPONENTS...>(
                                 world,
                                 func,
@@ -116,12 +268,16 @@ private:
                                 bufferStartOffset,
                                 std::make_index_sequence<sizeof...(COMPONENTS)>()
                             );
+                            if (tracker.IsActive())
+                                tracker.After(view, instance);
                         }
                     }
                 }
                 // progress 64 instances, which corresponds to 1 section
                 i += 64;
             }
+            if (tracker.IsActive())
+                tracker.Commit(world, view);
         };
     }
 };
@@ -160,6 +316,13 @@ public:
     /// entities must be marked as modified for them to actually be processed
     ProcessorBuilder& OnlyModified();
 
+    /// only process entities where any of these components have been written to since the last time the processor ran
+    template<typename ... COMPONENTS>
+    ProcessorBuilder& OnlyModified();
+
+    /// stamp every processed row of the components taken by non-const reference as written, instead of comparing them
+    ProcessorBuilder& StampAllWrites();
+
     /// Set the sorting order for the processor
     ProcessorBuilder& Order(int order);
 
@@ -178,6 +341,7 @@ private:
     FilterBuilder filterBuilder;
     bool async = false;
     bool onlyModified = false;
+    bool stampAllWrites = false;
     int order = 100;
 #ifdef WITH_NEBULA_EDITOR
     bool runInEditor = false;
@@ -218,6 +382,23 @@ inline ProcessorBuilder& ProcessorBuilder::Including()
     return *this;
 }
 
+//------------------------------------------------------------------------------
+/**
+    Components are marked as modified when written to via World::SetComponent,
+    World::MarkAsModified, or when a processor that takes them by non-const
+    reference changes their value (or processes them at all, if it was built
+    with StampAllWrites). The components have to be in the inclusive set of
+    the processor.
+*/
+template<typename ...COMPONENTS>
+inline ProcessorBuilder& ProcessorBuilder::OnlyModified()
+{
+    static_assert(sizeof...(COMPONENTS) > 0);
+    this->onlyModified = true;
+    this->filterBuilder.Changed<COMPONENTS...>();
+    return *this;
+}
+
 //------------------------------------------------------------------------------
 /**
 */
@@ -22,8 +22,11 @@
 #include "io/binaryreader.h"
 #include "io/ioserver.h"
 #include "basegamefeature/level.h"
+#include "basegamefeature/levelloaderthread.h"
 #include "flat/game/level.h"
 #include "util/blob.h"
+#include "jobs2/jobs2.h"
+#include "resources/resourceserver.h"
 
 namespace Game
 {
@@ -66,6 +69,8 @@ World::World(WorldHash hash, WorldId id)
     MemDb::TableCreateInfo info = {.name = "Empty", .attributeIds = attributes, .numAttributes = 4};
     this->defaultTableId = this->db->CreateTable(info);
 
+    this->commandBuffers.Resize(Jobs2::JobGetNumThreads() + 1);
+
     // clang-format off
     this->pipeline.RegisterFrameEvent( 10,   "OnBeginFrame");
     this->pipeline.RegisterFrameEvent( 100,  "OnFrame");
@@ -78,131 +83,85 @@ World::World(WorldHash hash, WorldId id)
 */
 World::~World()
 {
+    if (this->levelLoaderThread.isvalid())
+    {
+        this->levelLoaderThread->Stop();
+        this->levelLoaderThread = nullptr;
+    }
+
+    for (IndexT i = 0; i < this->pendingLevels.Size(); i++)
+    {
+        delete this->pendingLevels[i];
+    }
+
     this->db = nullptr;
 }
 
 //------------------------------------------------------------------------------
 /**
+    The level file is memory mapped and kept open until the level is unloaded.
+    Nothing is copied until the level is instantiated.
 */
 PackedLevel*
 World::PreloadLevel(Util::String const& path)
 {
+    // start loading the resources used by the level while it is parsed
+    if (Resources::ResourceServer::HasInstance())
+        Resources::ResourceServer::Instance()->PrefetchDependencies(path, "");
+
     PackedLevel* level = new PackedLevel();
     level->world = this;
+    level->path = path;
 
-    Ptr<IO::BinaryReader> reader = IO::BinaryReader::Create();
-    reader->SetStream(IO::IoServer::Instance()->CreateStream(path));
-    reader->SetMemoryMappingEnabled(true);
-    reader->Open();
+    level->reader = IO::BinaryReader::Create();
+    level->reader->SetStream(IO::IoServer::Instance()->CreateStream(path));
+    level->reader->SetMemoryMappingEnabled(true);
+    level->reader->Open();
 
-    ubyte* data = reader->mapCursor;
+    level->Parse();
+    level->CreateTables();
 
-    auto flatLevel = Game::Serialization::GetLevel(data);
-    auto flatTables = flatLevel->tables();
+    return level;
+}
 
-    Util::FixedArray<ComponentId> componentIds(flatLevel->component_descriptions()->size());
-    uint componentIndex = 0;
-    for (auto desc : *flatLevel->component_descriptions())
+//------------------------------------------------------------------------------
+/**
+    Maps and parses the level file on the level loader thread. The tables are created, and the callback
+    is invoked on the main thread when the world manages its entities, once parsing has finished.
+*/
+PackedLevel*
+World::PreloadLevelAsync(Util::String const& path, std::function<void(PackedLevel*)> const& onLoaded)
+{
+    if (!this->levelLoaderThread.isvalid())
     {
-        const char* componentName = desc->name()->c_str();
-        ComponentId cid = MemDb::AttributeRegistry::GetAttributeId(componentName);
-        componentIds[componentIndex++] = cid;
-
-#ifndef PUBLIC_BUILD
-        Game::ComponentInterface const* cInterface =
-            static_cast<Game::ComponentInterface*>(MemDb::AttributeRegistry::GetAttribute(cid));
-
-        // TODO: Validate all fields types as well and assert if incorrect!
-        n_assert(cInterface->GetNumFields() == desc->fields()->size());
-#endif
+        this->levelLoaderThread = LevelLoaderThread::Create();
+        this->levelLoaderThread->SetName("LevelLoaderThread");
+        this->levelLoaderThread->Start();
     }
 
-    Util::FixedArray<Util::StringAtom> strings(flatLevel->strings()->size());
+    // start loading the resources used by the level while it is parsed
+    if (Resources::ResourceServer::HasInstance())
+        Resources::ResourceServer::Instance()->PrefetchDependencies(path, "");
 
-    for (uint32_t i = 0; i < flatLevel->strings()->size(); i++)
-    {
-        Util::StringAtom strAtm = (*flatLevel->strings())[i]->data();
-        strings[i] = strAtm;
-    }
-
-    for (auto table : *flatTables)
-    {
-        Game::PackedLevel::EntityGroup entityGroup;
-
-        size_t const numTableComponents = table->components()->size();
-        Util::FixedArray<ComponentId> components((SizeT)numTableComponents);
-        componentIndex = 0;
-        for (auto c : *table->components())
-        {
-            ComponentId cid = componentIds[c];
-            components[componentIndex++] = cid;
-        }
-        MemDb::TableId const tableId = this->CreateEntityTable({.name = "", .components = components});
-        entityGroup.dstTable = tableId;
-        entityGroup.numRows = table->num_rows();
-
-        n_assert(entityGroup.numRows > 0);
-
-        size_t bytesInWholeTable = 0;
-        for (auto column : *table->columns())
-        {
-            bytesInWholeTable += column->bytes()->size();
-        }
-
-        n_assert(bytesInWholeTable > 0);
-
-        entityGroup.columns = new byte[bytesInWholeTable];
-
-        size_t offset = 0;
-        for (auto column : *table->columns())
-        {
-            Memory::Copy(column->bytes()->data(), entityGroup.columns + offset, column->bytes()->size());
-            offset += column->bytes()->size();
-        }
+    PackedLevel* level = new PackedLevel();
+    level->world = this;
+    level->path = path;
+    level->onLoaded = onLoaded;
+    level->parseCounter = 1;
 
-        // Patch strings
-        offset = 0;
-        size_t const numComponents = components.Size();
-        for (componentIndex = 0; componentIndex < numComponents; componentIndex++)
+    this->levelLoaderThread->Enqueue(
+        [level, path]()
         {
-            ComponentId const cid = components[componentIndex];
-            auto component_description = (*flatLevel->component_descriptions())[(*table->components())[componentIndex]];
-            Game::ComponentInterface const* cInterface =
-                static_cast<Game::ComponentInterface*>(MemDb::AttributeRegistry::GetAttribute(cid));
-
-            size_t const bytesInColumn = entityGroup.numRows * cInterface->typeSize;
-
-            size_t const numFields = cInterface->GetNumFields();
-            for (IndexT i = 0; i < numFields; i++)
-            {
-                auto fieldTypename = cInterface->GetFieldTypenames()[i];
-                auto component_field = (*component_description->fields())[i];
-
-                // Check for strings and unpack them
-                if (component_field->feature() == Game::Serialization::ComponentFieldFeature_StringAtom)
-                {
-                    ubyte* it = entityGroup.columns + offset;
-                    it += cInterface->GetFieldByteOffsets()[i];
-                    while (it < entityGroup.columns + offset + bytesInColumn)
-                    {
-                        static_assert(sizeof(Util::StringAtom) == sizeof(uint64_t));
-
-                        Util::StringAtom* asStringAtom = reinterpret_cast<Util::StringAtom*>(it);
-                        uint64_t asInt = *reinterpret_cast<uint64_t*>(it);
-
-                        *asStringAtom = strings[asInt];
-
-                        it += cInterface->typeSize;
-                    }
-                }
-            }
-            offset += (*table->columns())[componentIndex]->bytes()->size();
+            level->reader = IO::BinaryReader::Create();
+            level->reader->SetStream(IO::IoServer::Instance()->CreateStream(path));
+            level->reader->SetMemoryMappingEnabled(true);
+            level->reader->Open();
+            level->Parse();
+            Threading::Interlocked::Exchange(&level->parseCounter, 0);
         }
-        level->tables.Append(std::move(entityGroup));
-    }
-
-    reader->Close();
+    );
 
+    this->pendingLevels.Append(level);
     return level;
 }
 
@@ -212,9 +171,36 @@ World::PreloadLevel(Util::String const& path)
 void
 World::UnloadLevel(PackedLevel* level)
 {
+    IndexT const pending = this->pendingLevels.FindIndex(level);
+    if (pending != InvalidIndex)
+    {
+        // the loader thread is still referencing the level
+        while (level->parseCounter > 0)
+            Threading::Thread::YieldThread();
+        this->pendingLevels.EraseIndexSwap(pending);
+    }
     delete level;
 }
 
+//------------------------------------------------------------------------------
+/**
+*/
+void
+World::FinishPendingLevels()
+{
+    for (IndexT i = 0; i < this->pendingLevels.Size(); i++)
+    {
+        PackedLevel* level = this->pendingLevels[i];
+        if (level->parseCounter == 0)
+        {
+            this->pendingLevels.EraseIndexSwap(i--);
+            level->CreateTables();
+            if (level->onLoaded != nullptr)
+                level->onLoaded(level);
+        }
+    }
+}
+
 //------------------------------------------------------------------------------
 /**
 */
@@ -501,6 +487,12 @@ World::ManageEntities()
 {
     // NOTE: The order of the following loops are important!
 
+    // Execute commands that were recorded outside of frame events
+    this->ExecuteDeferredCommands();
+
+    // Create tables for levels that have finished preloading, before anything else can modify the database
+    this->FinishPendingLevels();
+
     // Clean up entities
     while (!this->deallocQueue.IsEmpty())
     {
@@ -564,6 +556,9 @@ World::GetDatabase()
 Game::Entity
 World::CreateEntity(bool immediate)
 {
+#if NEBULA_DEBUG
+    n_assert2(!this->pipeline.IsRunningAsync(), "Creating entities from an async processor is not supported! Use GetCommandBuffer() instead.");
+#endif
     Entity const entity = this->AllocateEntityId();
 
     World::AllocateInstanceCommand cmd;
@@ -587,6 +582,9 @@ World::CreateEntity(bool immediate)
 Game::Entity
 World::CreateEntity(EntityCreateInfo const& info)
 {
+#if NEBULA_DEBUG
+    n_assert2(!this->pipeline.IsRunningAsync(), "Creating entities from an async processor is not supported! Use GetCommandBuffer() instead.");
+#endif
     World::AllocateInstanceCommand cmd;
     if (info.templateId != TemplateId::Invalid())
     {
@@ -619,6 +617,9 @@ World::CreateEntity(EntityCreateInfo const& info)
 void
 World::DeleteEntity(Game::Entity entity)
 {
+#if NEBULA_DEBUG
+    n_assert2(!this->pipeline.IsRunningAsync(), "Deleting entities from an async processor is not supported! Use GetCommandBuffer() instead.");
+#endif
     n_assert(this->IsValid(entity));
 
     if (this->HasInstance(entity))
@@ -681,7 +682,7 @@ World::AddComponent(Entity entity, Game::ComponentId id)
 {
 #if NEBULA_DEBUG
     n_assert2(
-        !this->pipeline.IsRunningAsync(), "Adding component to entities while in an async processor is currently not supported!"
+        !this->pipeline.IsRunningAsync(), "Adding component to entities while in an async processor is not supported! Use GetCommandBuffer() instead."
     );
 #endif
     SizeT const typeSize = MemDb::AttributeRegistry::TypeSize(id);
@@ -722,7 +723,7 @@ World::RemoveComponent(Entity entity, ComponentId component)
 #if NEBULA_DEBUG
     n_assert2(
         !this->pipeline.IsRunningAsync(),
-        "Removing components from entities while executing an async processor is currently not supported!"
+        "Removing components from entities while executing an async processor is not supported! Use GetCommandBuffer() instead."
     );
 #endif
     RemoveComponentCommand cmd = {
@@ -874,6 +875,134 @@ World::ExecuteRemoveComponentCommands()
     removeComponentQueue.Clear();
 }
 
+//------------------------------------------------------------------------------
+/**
+*/
+CommandBuffer&
+World::GetCommandBuffer()
+{
+    // job threads have their own buffer, everything else shares the last one
+    IndexT const threadIndex = Jobs2::JobGetThreadIndex();
+    IndexT const bufferIndex = threadIndex != InvalidIndex ? threadIndex : this->commandBuffers.Size() - 1;
+    n_assert(bufferIndex < this->commandBuffers.Size());
+    return this->commandBuffers[bufferIndex];
+}
+
+//------------------------------------------------------------------------------
+/**
+    Commands are executed in the order of their batch and sequence, which does
+    not depend on what thread recorded them.
+*/
+void
+World::ExecuteDeferredCommands()
+{
+    n_assert(!this->pipeline.IsRunningAsync());
+
+    struct SortedCommand
+    {
+        CommandBuffer::Command const* cmd;
+        IndexT buffer;
+    };
+
+    Util::Array<SortedCommand> sorted;
+    for (IndexT i = 0; i < this->commandBuffers.Size(); i++)
+    {
+        CommandBuffer const& buffer = this->commandBuffers[i];
+        for (IndexT j = 0; j < buffer.commands.Size(); j++)
+            sorted.Append({&buffer.commands[j], i});
+    }
+
+    if (sorted.IsEmpty())
+        return;
+
+    auto sortFunc = [](const void* lhs, const void* rhs) -> int
+    {
+        SortedCommand const* a = (SortedCommand const*)lhs;
+        SortedCommand const* b = (SortedCommand const*)rhs;
+        if (a->cmd->batch != b->cmd->batch)
+            return a->cmd->batch < b->cmd->batch ? -1 : 1;
+        if (a->buffer != b->buffer)
+            return a->buffer < b->buffer ? -1 : 1;
+        return (a->cmd->sequence > b->cmd->sequence) - (a->cmd->sequence < b->cmd->sequence);
+    };
+    sorted.QuickSortWithFunc(sortFunc);
+
+    for (IndexT i = 0; i < sorted.Size(); i++)
+    {
+        CommandBuffer::Command const& cmd = *sorted[i].cmd;
+        switch (cmd.type)
+        {
+            case CommandBuffer::CommandType::CreateEntity:
+            {
+                Entity const entity = this->CreateEntity({.templateId = cmd.templateId, .immediate = false});
+                if (entity == Entity::Invalid())
+                    break;
+
+                // overrides are written before the components are initialized
+                EntityMapping const mapping = this->entityMap[entity.index];
+                MemDb::Table& table = this->db->GetTable(mapping.table);
+                for (IndexT v = 0; v < cmd.numValues; v++)
+                {
+                    CommandBuffer::ComponentValue const& value = cmd.values[v];
+                    MemDb::ColumnIndex const column = table.GetAttributeIndex(value.component);
+                    if (column == MemDb::ColumnIndex::Invalid())
+                    {
+                        n_warning("Deferred CreateEntity: Template does not have component with id '%i'!\n", value.component.id);
+                    }
+                    else if (value.data != nullptr)
+                    {
+                        Memory::Copy(value.data, table.GetValuePointer(column, mapping.instance), MemDb::AttributeRegistry::TypeSize(value.component));
+                    }
+                }
+                break;
+            }
+            case CommandBuffer::CommandType::DeleteEntity:
+            {
+                if (this->IsValid(cmd.entity))
+                    this->DeleteEntity(cmd.entity);
+                break;
+            }
+            case CommandBuffer::CommandType::AddComponent:
+            {
+                if (!this->IsValid(cmd.entity))
+                    break;
+                void* data = this->AddComponent(cmd.entity, cmd.values[0].component);
+                if (cmd.values[0].data != nullptr)
+                    Memory::Copy(cmd.values[0].data, data, MemDb::AttributeRegistry::TypeSize(cmd.values[0].component));
+                break;
+            }
+            case CommandBuffer::CommandType::RemoveComponent:
+            {
+                if (this->IsValid(cmd.entity))
+                    this->RemoveComponent(cmd.entity, cmd.values[0].component);
+                break;
+            }
+            case CommandBuffer::CommandType::SetComponent:
+            {
+                if (!this->IsValid(cmd.entity) || !this->HasInstance(cmd.entity))
+                    break;
+                EntityMapping const mapping = this->entityMap[cmd.entity.index];
+                MemDb::Table& table = this->db->GetTable(mapping.table);
+                MemDb::ColumnIndex const column = table.GetAttributeIndex(cmd.values[0].component);
+                if (column == MemDb::ColumnIndex::Invalid())
+                {
+                    n_warning("Deferred SetComponent: Entity does not have component with id '%i'!\n", cmd.values[0].component.id);
+                    break;
+                }
+                if (cmd.values[0].data != nullptr)
+                {
+                    Memory::Copy(cmd.values[0].data, table.GetValuePointer(column, mapping.instance), MemDb::AttributeRegistry::TypeSize(cmd.values[0].component));
+                    this->MarkAsModified(mapping, column);
+                }
+                break;
+            }
+        }
+    }
+
+    for (IndexT i = 0; i < this->commandBuffers.Size(); i++)
+        this->commandBuffers[i].Reset();
+}
+
 //------------------------------------------------------------------------------
 /**
 */
@@ -1423,6 +1552,7 @@ World::SetComponentValue(Game::Entity entity, Game::ComponentId component, void*
     byte* const ptr = (byte*)this->GetInstanceBuffer(mapping.table, mapping.instance.partition, component);
     byte* valuePtr = ptr + (mapping.instance.index * size);
     Memory::Copy(value, valuePtr, size);
+    this->MarkAsModified(mapping, component);
 }
 
 //------------------------------------------------------------------------------
@@ -1448,6 +1578,7 @@ World::ReinitializeComponent(Game::Entity entity, Game::ComponentId component, v
     byte* const ptr = (byte*)this->GetInstanceBuffer(mapping.table, mapping.instance.partition, component);
     byte* valuePtr = ptr + (mapping.instance.index * size);
     Memory::Copy(value, valuePtr, size);
+    this->MarkAsModified(mapping, columnIndex);
 
     if (this->componentInitializationEnabled)
     {
@@ -1479,8 +1610,13 @@ World::RenderDebug()
         if (ImGui::IsItemHovered())
         {
             //ImGui::SetTooltip("Processors are executed _after_ feature units for each event.");
-            ImGui::SetTooltip("The pipeline that makes up the frame.\nThis consists of multiple frame events, possibly bundled "
-                              "in frame batches.");
+            ImGui::SetTooltip("The pipeline that makes up the frame.\nThis consists of multiple frame events, each executing "
+                              "its processors as a dependency graph.\nProcessors on the critical path are red.");
+        }
+        ImGui::SameLine();
+        if (ImGui::Button("Copy schedule as graphviz"))
+        {
+            ImGui::SetClipboardText(this->pipeline.DumpSchedule().AsCharPtr());
         }
 
         auto const events = this->pipeline.GetFrameEvents();
@@ -1490,62 +1626,70 @@ World::RenderDebug()
             ImGui::TextColored({0.8f, 0.4f, 0.8f, 1.0f}, "Event: %s", events[i]->name.Value());
             ImGui::SameLine();
             ImGui::Text(" | Order: %i", events[i]->order);
+            ImGui::SameLine();
+            ImGui::Text(" | %.3f ms (critical path %.3f ms)", events[i]->GetRunTime() * 1000.0, events[i]->GetCriticalPathTime() * 1000.0);
 
-            auto const batches = events[i]->GetBatches();
+            auto const& schedule = events[i]->GetSchedule();
             ImGui::Indent();
-            for (IndexT b = 0; b < batches.Size(); b++)
+            for (IndexT p = 0; p < schedule.Size(); p++)
             {
-                auto const batch = batches[b];
-                ImGui::TextColored({0.4f, 0.8f, 0.8f, 1.0f}, "Batch #%i", b);
+                Game::FrameEvent::ScheduleNode const& node = schedule[p];
+                Game::Processor const* const processor = node.processor;
+                if (node.critical)
+                    ImGui::TextColored({0.9f, 0.3f, 0.3f, 1.0f}, "#%i %s", p, processor->name.AsCharPtr());
+                else
+                    ImGui::TextColored({0.8f, 0.8f, 0.4f, 1.0f}, "#%i %s", p, processor->name.AsCharPtr());
                 ImGui::SameLine();
-                ImGui::Text(" | Order: %i", batch->order);
+                ImGui::Text(" | Order: %i", processor->order);
                 ImGui::SameLine();
-                ImGui::Text(" | Async: %s", batch->async ? "true" : "false");
-                auto const processors = batch->GetProcessors();
-                ImGui::Indent();
-                for (IndexT p = 0; p < processors.Size(); p++)
+                ImGui::Text(" | Async: %s", processor->async ? "true" : "false");
+                ImGui::SameLine();
+                ImGui::Text(" | %.3f ms", (node.end - node.start) * 1000.0);
+                if (node.predecessors.Size() > 0)
                 {
-                    Game::Processor const* const processor = processors[p];
-                    ImGui::TextColored({0.8f, 0.8f, 0.4f, 1.0f}, processor->name.AsCharPtr());
-                    ImGui::SameLine();
-                    ImGui::Text(" | Async: %s", processor->async ? "true" : "false");
+                    Util::String after;
+                    for (IndexT d = 0; d < node.predecessors.Size(); d++)
+                    {
+                        after.Append(Util::String::Sprintf(d == 0 ? "#%i" : ", #%i", node.predecessors[d]));
+                    }
                     ImGui::SameLine();
-                    ImGui::TextColored({0.5, 0.5, 0.9f, 1.0f}, " | Filter : %i", processor->filter);
-                    if (ImGui::IsItemHovered())
+                    ImGui::Text(" | After: %s", after.AsCharPtr());
+                }
+                ImGui::SameLine();
+                ImGui::TextColored({0.5, 0.5, 0.9f, 1.0f}, " | Filter : %i", processor->filter);
+                if (ImGui::IsItemHovered())
+                {
+                    ImGui::Indent();
+                    auto const compsInc = Game::ComponentsInFilter(processor->filter);
+                    if (compsInc.Size() > 0)
                     {
-                        ImGui::Indent();
-                        auto const compsInc = Game::ComponentsInFilter(processor->filter);
-                        if (compsInc.Size() > 0)
+                        ImGui::TextColored({0.1f, 0.8f, 0.1f, 1.0f}, "Includes entities with components:");
+                        ImGui::BeginChild(1, ImVec2(0, ImGui::GetTextLineHeightWithSpacing() * compsInc.Size()));
                         {
-                            ImGui::TextColored({0.1f, 0.8f, 0.1f, 1.0f}, "Includes entities with components:");
-                            ImGui::BeginChild(1, ImVec2(0, ImGui::GetTextLineHeightWithSpacing() * compsInc.Size()));
+                            for (auto c : compsInc)
                             {
-                                for (auto c : compsInc)
-                                {
-                                    const char* componentName = MemDb::AttributeRegistry::GetAttribute(c)->name.Value();
-                                    ImGui::Selectable(componentName);
-                                }
-                                ImGui::EndChild();
+                                const char* componentName = MemDb::AttributeRegistry::GetAttribute(c)->name.Value();
+                                ImGui::Selectable(componentName);
                             }
+                            ImGui::EndChild();
                         }
-                        auto const compsEx = Game::ExcludedComponentsInFilter(processor->filter);
-                        if (compsEx.Size() > 0)
+                    }
+                    auto const compsEx = Game::ExcludedComponentsInFilter(processor->filter);
+                    if (compsEx.Size() > 0)
+                    {
+                        ImGui::TextColored({0.8, 0.2, 0.2, 1.0f}, "Excludes entities with components:");
+                        ImGui::BeginChild(2, ImVec2(0, ImGui::GetTextLineHeightWithSpacing() * compsEx.Size()));
                         {
-                            ImGui::TextColored({0.8, 0.2, 0.2, 1.0f}, "Excludes entities with components:");
-                            ImGui::BeginChild(2, ImVec2(0, ImGui::GetTextLineHeightWithSpacing() * compsEx.Size()));
+                            for (auto c : compsEx)
                             {
-                                for (auto c : compsEx)
-                                {
-                                    const char* componentName = MemDb::AttributeRegistry::GetAttribute(c)->name.Value();
-                                    ImGui::Selectable(componentName);
-                                }
-                                ImGui::EndChild();
+                                const char* componentName = MemDb::AttributeRegistry::GetAttribute(c)->name.Value();
+                                ImGui::Selectable(componentName);
                             }
+                            ImGui::EndChild();
                         }
-                        ImGui::Unindent();
                     }
+                    ImGui::Unindent();
                 }
-                ImGui::Unindent();
             }
             ImGui::Unindent();
         }
@@ -1750,6 +1894,36 @@ World::MarkAsModified(Game::Entity entity)
     partition->modifiedRows.SetBit(mapping.instance.index);
 }
 
+//------------------------------------------------------------------------------
+/**
+*/
+void
+World::MarkAsModified(Game::Entity entity, ComponentId component)
+{
+    this->MarkAsModified(this->GetEntityMapping(entity), component);
+}
+
+//------------------------------------------------------------------------------
+/**
+*/
+void
+World::MarkAsModified(EntityMapping const& mapping, ComponentId component)
+{
+    MemDb::ColumnIndex const column = this->db->GetTable(mapping.table).GetAttributeIndex(component);
+    n_assert(column != MemDb::ColumnIndex::Invalid());
+    this->MarkAsModified(mapping, column);
+}
+
+//------------------------------------------------------------------------------
+/**
+*/
+void
+World::MarkAsModified(EntityMapping const& mapping, MemDb::ColumnIndex column)
+{
+    MemDb::Table::Partition* partition = this->db->GetTable(mapping.table).GetPartition(mapping.instance.partition);
+    partition->MarkModified(column, mapping.instance.index, this->AdvanceChangeTick());
+}
+
 //------------------------------------------------------------------------------
 /**
     @returns    Dataset with category table views.
@@ -1769,13 +1943,27 @@ World::Query(Filter filter)
     return this->Query(filter, tids);
 }
 
+//------------------------------------------------------------------------------
+/**
+    @returns    Dataset with category table views, excluding all partitions where none of
+                the changed components has been written to after changedSince. The rows
+                that have been written to are set in Dataset::View::modifiedInstances.
+*/
+Dataset
+World::Query(Filter filter, uint64_t changedSince)
+{
+    Util::Array<MemDb::TableId> tids = this->db->Query(GetInclusiveTableMask(filter), GetExclusiveTableMask(filter));
+
+    return this->Query(filter, tids, changedSince);
+}
+
 //------------------------------------------------------------------------------
 /**
 */
 Dataset
-World::Query(Filter filter, Util::Array<MemDb::TableId>& tids)
+World::Query(Filter filter, Util::Array<MemDb::TableId>& tids, uint64_t changedSince)
 {
-    return Game::Query(this->db, tids, filter);
+    return Game::Query(this->db, tids, filter, changedSince);
 }
 
 //------------------------------------------------------------------------------
@@ -1868,6 +2056,7 @@ World::SetComponent(Entity entity, Game::Position const& value)
     MemDb::ColumnIndex const column = Game::Position::Traits::fixed_column_index;
     Game::Position* ptr = (Game::Position*)this->GetColumnData(mapping.table, mapping.instance.partition, column);
     *(ptr + mapping.instance.index) = value;
+    this->MarkAsModified(mapping, column);
 }
 
 //------------------------------------------------------------------------------�
@@ -1891,6 +2080,7 @@ World::SetComponent(Entity entity, Game::Orientation const& value)
     MemDb::ColumnIndex const column = Game::Orientation::Traits::fixed_column_index;
     Game::Orientation* ptr = (Game::Orientation*)this->GetColumnData(mapping.table, mapping.instance.partition, column);
     *(ptr + mapping.instance.index) = value;
+    this->MarkAsModified(mapping, column);
 }
 
 //------------------------------------------------------------------------------
@@ -1914,6 +2104,7 @@ World::SetComponent(Entity entity, Game::Scale const& value)
     MemDb::ColumnIndex const column = Game::Scale::Traits::fixed_column_index;
     Game::Scale* ptr = (Game::Scale*)this->GetColumnData(mapping.table, mapping.instance.partition, column);
     *(ptr + mapping.instance.index) = value;
+    this->MarkAsModified(mapping, column);
 }
 
 } // namespace Game
@@ -18,6 +18,7 @@
 #include "processor.h"
 #include "memory/arenaallocator.h"
 #include "frameevent.h"
+#include "commandbuffer.h"
 #include "util/fourcc.h"
 
 namespace MemDb
@@ -33,6 +34,7 @@ namespace Game
 {
 
 class PackedLevel;
+class LevelLoaderThread;
 
 //------------------------------------------------------------------------------
 /**
@@ -131,18 +133,32 @@ public:
 
     /// Mark an entity as modified in its table.
     void MarkAsModified(Game::Entity entity);
+    /// Mark a component of an entity as modified. The write is stamped with a new change tick.
+    void MarkAsModified(Game::Entity entity, ComponentId component);
+    /// Mark a component of an entity as modified. The write is stamped with a new change tick.
+    template <typename TYPE>
+    void MarkAsModified(Game::Entity entity);
+    /// Returns the latest change tick. Keep it around and pass it to Query to only get what has been modified since.
+    uint64_t GetChangeTick() const;
+    /// Returns the number of alive entities in the world
+    SizeT GetNumEntities() const;
 
     /// Query the entity database using specified filter set. This does NOT wait for resources to be available.
     Dataset Query(Filter filter);
+    /// Query the entity database, skipping everything where none of the filters changed components has been modified after the given change tick.
+    /// This does NOT wait for resources to be available.
+    Dataset Query(Filter filter, uint64_t changedSince);
     /// Query a subset of tables using a specified filter set. Modifies the tables array so that it only contains valid tables.
     /// This does NOT wait for resources to be available.
-    Dataset Query(Filter filter, Util::Array<MemDb::TableId>& tids);
+    Dataset Query(Filter filter, Util::Array<MemDb::TableId>& tids, uint64_t changedSince = 0);
 
     /// Get a decay buffer for the given component
     ComponentDecayBuffer const GetDecayBuffer(ComponentId component);
 
     /// preload a level that can be instantiated
     PackedLevel* PreloadLevel(Util::String const& path);
+    /// preload a level in the background. The callback is invoked on the main thread once the level can be instantiated.
+    PackedLevel* PreloadLevelAsync(Util::String const& path, std::function<void(PackedLevel*)> const& onLoaded);
     /// unload a preloaded level
     void UnloadLevel(PackedLevel* level);
     /// Export the world as a level
@@ -189,6 +205,12 @@ public:
     void* GetColumnData(MemDb::TableId const tableId, uint16_t partitionId, MemDb::ColumnIndex const column);
     /// dispatches all staged components to be added to entities
     void ExecuteAddComponentCommands();
+    /// Get the command buffer of the calling thread. Use this to create and delete entities, or add and remove components from async processors.
+    CommandBuffer& GetCommandBuffer();
+    /// Merge and execute the command buffers of all threads. This is called at the end of each frame event.
+    void ExecuteDeferredCommands();
+    /// Bump and return the change tick. All writes tagged with the returned tick are considered to happen at the same time.
+    uint64_t AdvanceChangeTick();
     /// Disable if initialization of components is not required (ex. when running as editor db)
     bool componentInitializationEnabled = true;
 
@@ -198,6 +220,7 @@ private:
     friend class GameServer;
     friend class BlueprintManager;
     friend class PackedLevel;
+    friend class WorldSnapshot;
 
     struct AllocateInstanceCommand
     {
@@ -238,6 +261,8 @@ private:
     void ClearDecayBuffers();
 
     void ExecuteRemoveComponentCommands();
+    /// create tables and run the callbacks of levels that have finished preloading
+    void FinishPendingLevels();
 
     /// Get total number of instances in an entity table
     SizeT GetNumInstances(MemDb::TableId tid);
@@ -261,6 +286,11 @@ private:
     /// Run OnInit on all components. Use with caution, since they can only be initialized once and the function doesn't check for this.
     void InitializeAllComponents(Entity entity, MemDb::TableId tableId, MemDb::RowId row);
 
+    /// Stamp a column of an entity row with a new change tick
+    void MarkAsModified(EntityMapping const& mapping, MemDb::ColumnIndex column);
+    /// Stamp a component of an entity row with a new change tick
+    void MarkAsModified(EntityMapping const& mapping, ComponentId component);
+
     /// Adds all components in cmds to entity 
     void AddStagedComponentsToEntity(Entity entity, AddStagedComponentCommand* cmds, SizeT numCmds);
     /// Removes all components in cmds from entity
@@ -288,8 +318,14 @@ private:
     Util::Array<AddStagedComponentCommand> addStagedQueue;
     /// Stores all deferred remove component commands
     Util::Array<RemoveComponentCommand> removeComponentQueue;
+    /// levels that are preloading in the background
+    Util::Array<PackedLevel*> pendingLevels;
+    /// thread that preloads levels in the background, started on demand
+    Ptr<LevelLoaderThread> levelLoaderThread;
     /// Allocator for staged components
     Memory::ArenaAllocator<4096_KB> componentStageAllocator;
+    /// Deferred commands, one buffer per job thread and one for all other threads
+    Util::FixedArray<CommandBuffer> commandBuffers;
     /// Set to true if the caches for the frame pipeline are valid
     bool cacheValid = false;
     /// The frame pipeline for this world
@@ -298,6 +334,8 @@ private:
     MemDb::TableId defaultTableId;
     /// Contains all the component decay buffers. Lookup directly via ComponentId
     Util::FixedArray<ComponentDecayBuffer> componentDecayTable;
+    /// Monotonically increasing change tick, bumped per write on the main thread and per processor execution
+    uint64_t changeTick = 0;
 };
 
 //------------------------------------------------------------------------------
@@ -318,6 +356,43 @@ World::GetWorldId() const
     return this->worldId;
 }
 
+//------------------------------------------------------------------------------
+/**
+*/
+inline uint64_t
+World::GetChangeTick() const
+{
+    return this->changeTick;
+}
+
+//------------------------------------------------------------------------------
+/**
+*/
+inline SizeT
+World::GetNumEntities() const
+{
+    return this->numEntities;
+}
+
+//------------------------------------------------------------------------------
+/**
+*/
+inline uint64_t
+World::AdvanceChangeTick()
+{
+    return ++this->changeTick;
+}
+
+//------------------------------------------------------------------------------
+/**
+*/
+template <typename TYPE>
+inline void
+World::MarkAsModified(Entity entity)
+{
+    this->MarkAsModified(entity, Game::GetComponentId<TYPE>());
+}
+
 //------------------------------------------------------------------------------
 /**
 */
@@ -341,6 +416,7 @@ World::SetComponent(Entity entity, TYPE const& value)
     EntityMapping mapping = this->GetEntityMapping(entity);
     TYPE* ptr = (TYPE*)this->GetInstanceBuffer(mapping.table, mapping.instance.partition, GetComponentId<TYPE>());
     *(ptr + mapping.instance.index) = value;
+    this->MarkAsModified(mapping, GetComponentId<TYPE>());
 }
 
 //------------------------------------------------------------------------------
@@ -0,0 +1,894 @@
+//------------------------------------------------------------------------------
+//  @file worldsnapshot.cc
+//  @copyright (C) 2024 Individual contributors, see AUTHORS file
+//------------------------------------------------------------------------------
+#include "foundation/stdneb.h"
+#include "worldsnapshot.h"
+#include "world.h"
+#include "memdb/database.h"
+#include "memdb/table.h"
+#include "io/ioserver.h"
+#include "io/binaryreader.h"
+#include "io/binarywriter.h"
+
+namespace Game
+{
+
+static constexpr uint32_t SnapshotMagic = 'NWSN';
+static constexpr uint32_t SnapshotVersion = 1;
+static constexpr uintptr_t SnapshotAlignment = 16;
+/// marks a column in a delta snapshot that should be copied from the base snapshot
+static constexpr uint64_t ColumnInBase = ~0ull;
+/// marks a string field that contains an invalid string atom
+static constexpr uint64_t InvalidString = ~0ull;
+static constexpr uint32_t InvalidSnapshotIndex = ~0u;
+
+enum SnapshotFlags : uint32_t
+{
+    SnapshotFlag_Delta = 1 << 0
+};
+
+//------------------------------------------------------------------------------
+/**
+    All offsets are in bytes from the start of the snapshot.
+*/
+struct SnapshotHeader
+{
+    uint32_t magic;
+    uint32_t version;
+    uint32_t flags;
+    uint32_t numComponents;
+    uint32_t numTables;
+    uint32_t numStrings;
+    uint32_t numEntities;
+    uint32_t entityMapSize;
+    uint32_t numFreeEntityIds;
+    uint32_t pad;
+    /// change tick of the world when the snapshot was written
+    uint64_t changeTick;
+    /// change tick of the base snapshot, if this is a delta snapshot
+    uint64_t baseChangeTick;
+    uint64_t totalSize;
+    /// SnapshotComponent[numComponents]
+    uint64_t components;
+    /// SnapshotTable[numTables]
+    uint64_t tables;
+    /// SnapshotEntityMapping[entityMapSize]
+    uint64_t entityMap;
+    /// uint16_t[entityMapSize]
+    uint64_t generations;
+    /// uint32_t[numFreeEntityIds]
+    uint64_t freeEntityIds;
+    /// uint64_t[numStrings], offsets of each string relative to stringData
+    uint64_t stringOffsets;
+    /// null terminated strings
+    uint64_t stringData;
+};
+
+struct SnapshotComponent
+{
+    /// index into the string table
+    uint32_t name;
+    uint32_t typeSize;
+};
+
+struct SnapshotTable
+{
+    uint32_t numColumns;
+    uint32_t numPartitions;
+    uint32_t totalNumRows;
+    /// the table in the base snapshot with the same columns, if this is a delta snapshot
+    uint32_t baseTable;
+    /// uint32_t[numColumns], indices into the components of the snapshot
+    uint64_t columns;
+    /// SnapshotPartition[numPartitions], sorted by partition id
+    uint64_t partitions;
+};
+
+struct SnapshotPartition
+{
+    Util::BitField<MemDb::Table::Partition::CAPACITY> validRows;
+    uint16_t partitionId;
+    uint16_t pad;
+    uint32_t numRows;
+    uint32_t numFreeIds;
+    /// the same partition in the base snapshot, if this is a delta snapshot
+    uint32_t basePartition;
+    /// uint16_t[numFreeIds]
+    uint64_t freeIds;
+    /// uint64_t[numColumns], offsets to the column data. Zero for flag components, or ColumnInBase
+    uint64_t columns;
+};
+
+struct SnapshotEntityMapping
+{
+    /// index into the tables of the snapshot
+    uint32_t table;
+    MemDb::RowId instance;
+};
+
+static_assert(std::is_trivially_copyable<SnapshotPartition>::value);
+
+//------------------------------------------------------------------------------
+/**
+    Serializes the world in two passes. The first pass only measures and gathers strings, the second pass writes.
+*/
+struct SnapshotWriter
+{
+    World* world = nullptr;
+    ubyte* data = nullptr;
+    uint64_t size = 0;
+
+    /// base snapshot if writing a delta
+    ubyte const* base = nullptr;
+    SnapshotHeader const* baseHeader = nullptr;
+    Util::FixedArray<ComponentId> baseComponents;
+    uint64_t const* baseStringOffsets = nullptr;
+    const char* baseStringData = nullptr;
+
+    Util::Array<MemDb::TableId> tables;
+    Util::Array<ComponentId> components;
+    Util::HashTable<ComponentId, uint32_t> componentIndices;
+    Util::Array<Util::StringAtom> strings;
+    Util::HashTable<Util::StringAtom, uint32_t> stringIndices;
+
+    /// reserve aligned space, and return its offset
+    uint64_t
+    Reserve(uint64_t bytes)
+    {
+        uint64_t const offset = Math::alignptr(this->size, SnapshotAlignment);
+        this->size = offset + bytes;
+        return offset;
+    }
+
+    /// get a pointer into the snapshot, or null when measuring
+    template <typename TYPE>
+    TYPE*
+    At(uint64_t offset)
+    {
+        return this->data != nullptr ? reinterpret_cast<TYPE*>(this->data + offset) : nullptr;
+    }
+
+    /// get the index of a string, adding it to the string table if missing
+    uint32_t
+    AddString(Util::StringAtom const& atom)
+    {
+        IndexT const index = this->stringIndices.FindIndex(atom);
+        if (index != InvalidIndex)
+            return this->stringIndices.ValueAtIndex(atom, index);
+        uint32_t const stringIndex = this->strings.Size();
+        this->strings.Append(atom);
+        this->stringIndices.Add(atom, stringIndex);
+        return stringIndex;
+    }
+};
+
+//------------------------------------------------------------------------------
+/**
+*/
+static bool
+IsStringField(const char* fieldTypename)
+{
+    return Util::String::StrCmp(fieldTypename, "Resources::ResourceName") == 0 ||
+           Util::String::StrCmp(fieldTypename, "string") == 0 ||
+           Util::String::StrCmp(fieldTypename, "Util::StringAtom") == 0;
+}
+
+//------------------------------------------------------------------------------
+/**
+*/
+static SnapshotHeader const*
+ValidateSnapshot(void const* data, size_t size)
+{
+    n_assert(data != nullptr && size >= sizeof(SnapshotHeader));
+    SnapshotHeader const* header = static_cast<SnapshotHeader const*>(data);
+    n_assert2(header->magic == SnapshotMagic, "Not a world snapshot!");
+    n_assert2(header->version == SnapshotVersion, "World snapshot version mismatch!");
+    n_assert2(header->totalSize == size, "World snapshot is truncated!");
+    return header;
+}
+
+//------------------------------------------------------------------------------
+/**
+    Maps the components of a snapshot to the components registered in this build.
+*/
+static Util::FixedArray<ComponentId>
+ResolveComponents(ubyte const* data, SnapshotHeader const* header)
+{
+    SnapshotComponent const* components = reinterpret_cast<SnapshotComponent const*>(data + header->components);
+    uint64_t const* stringOffsets = reinterpret_cast<uint64_t const*>(data + header->stringOffsets);
+    const char* stringData = reinterpret_cast<const char*>(data + header->stringData);
+
+    Util::FixedArray<ComponentId> ids(header->numComponents);
+    for (uint32_t i = 0; i < header->numComponents; i++)
+    {
+        const char* name = stringData + stringOffsets[components[i].name];
+        ids[i] = MemDb::AttributeRegistry::GetAttributeId(name);
+        n_assert2(ids[i] != ComponentId::Invalid(), "World snapshot contains an unregistered component!");
+        n_assert2(MemDb::AttributeRegistry::TypeSize(ids[i]) == components[i].typeSize, "World snapshot component size mismatch!");
+    }
+    return ids;
+}
+
+//------------------------------------------------------------------------------
+/**
+*/
+static Util::FixedArray<Util::StringAtom>
+ResolveStrings(ubyte const* data, SnapshotHeader const* header)
+{
+    uint64_t const* stringOffsets = reinterpret_cast<uint64_t const*>(data + header->stringOffsets);
+    const char* stringData = reinterpret_cast<const char*>(data + header->stringData);
+
+    Util::FixedArray<Util::StringAtom> strings(header->numStrings);
+    for (uint32_t i = 0; i < header->numStrings; i++)
+    {
+        strings[i] = Util::StringAtom(stringData + stringOffsets[i]);
+    }
+    return strings;
+}
+
+//------------------------------------------------------------------------------
+/**
+    Find the table in the base snapshot that has the exact same columns.
+*/
+static uint32_t
+FindBaseTable(SnapshotWriter const& writer, MemDb::Table const& table)
+{
+    Util::Array<MemDb::AttributeId> const& attributes = table.GetAttributes();
+    SnapshotTable const* baseTables = reinterpret_cast<SnapshotTable const*>(writer.base + writer.baseHeader->tables);
+    for (uint32_t t = 0; t < writer.baseHeader->numTables; t++)
+    {
+        SnapshotTable const& baseTable = baseTables[t];
+        if (baseTable.numColumns != (uint32_t)attributes.Size())
+            continue;
+
+        uint32_t const* baseColumns = reinterpret_cast<uint32_t const*>(writer.base + baseTable.columns);
+        bool match = true;
+        for (uint32_t c = 0; c < baseTable.numColumns && match; c++)
+        {
+            match = writer.baseComponents[baseColumns[c]] == attributes[c];
+        }
+        if (match)
+            return t;
+    }
+    return InvalidSnapshotIndex;
+}
+
+//------------------------------------------------------------------------------
+/**
+    Find a partition in a table of the base snapshot. Partitions are sorted by id.
+*/
+static uint32_t
+FindBasePartition(SnapshotWriter const& writer, SnapshotTable const& baseTable, uint16_t partitionId)
+{
+    SnapshotPartition const* basePartitions = reinterpret_cast<SnapshotPartition const*>(writer.base + baseTable.partitions);
+    uint32_t low = 0;
+    uint32_t high = baseTable.numPartitions;
+    while (low < high)
+    {
+        uint32_t const mid = (low + high) / 2;
+        if (basePartitions[mid].partitionId < partitionId)
+            low = mid + 1;
+        else
+            high = mid;
+    }
+    if (low < baseTable.numPartitions && basePartitions[low].partitionId == partitionId)
+        return low;
+    return InvalidSnapshotIndex;
+}
+
+//------------------------------------------------------------------------------
+/**
+    A partition can only reference column data in the base snapshot if its rows are exactly the same.
+    Rows that have been removed and reused by new entities are caught by comparing the owner column.
+*/
+static bool
+IsSameLayout(SnapshotWriter const& writer, SnapshotPartition const& basePartition, MemDb::Table::Partition const* partition)
+{
+    if (basePartition.numRows != partition->numRows || basePartition.validRows != partition->validRows)
+        return false;
+
+    uint64_t const* baseColumns = reinterpret_cast<uint64_t const*>(writer.base + basePartition.columns);
+    uint64_t const ownerColumn = baseColumns[Game::Entity::Traits::fixed_column_index];
+    n_assert(ownerColumn != 0 && ownerColumn != ColumnInBase);
+    return memcmp(
+        writer.base + ownerColumn,
+        partition->columns[Game::Entity::Traits::fixed_column_index],
+        partition->numRows * sizeof(Game::Entity)
+    ) == 0;
+}
+
+//------------------------------------------------------------------------------
+/**
+    Compares a column with the same column in the base snapshot. String fields are
+    compared by their strings, everything else byte by byte.
+*/
+static bool
+ColumnMatchesBase(
+    SnapshotWriter const& writer,
+    Game::ComponentInterface const* cInterface,
+    Util::Array<uint32_t> const& stringFields,
+    MemDb::Table::Partition const* partition,
+    void const* buffer,
+    uint64_t baseOffset
+)
+{
+    SizeT const typeSize = cInterface->typeSize;
+    ubyte const* src = static_cast<ubyte const*>(buffer);
+    ubyte const* baseSrc = writer.base + baseOffset;
+    if (stringFields.IsEmpty())
+        return memcmp(src, baseSrc, partition->numRows * typeSize) == 0;
+
+    for (uint32_t row = 0; row < partition->numRows; row++)
+    {
+        ubyte const* component = src + row * typeSize;
+        ubyte const* baseComponent = baseSrc + row * typeSize;
+
+        // the bytes between the string fields, which are sorted by offset
+        uint32_t begin = 0;
+        for (IndexT f = 0; f <= stringFields.Size(); f++)
+        {
+            uint32_t const end = f < stringFields.Size() ? stringFields[f] : typeSize;
+            if (memcmp(component + begin, baseComponent + begin, end - begin) != 0)
+                return false;
+            begin = end + sizeof(Util::StringAtom);
+        }
+
+        for (IndexT f = 0; f < stringFields.Size(); f++)
+        {
+            Util::StringAtom const& atom = *reinterpret_cast<Util::StringAtom const*>(component + stringFields[f]);
+            uint64_t const stringIndex = *reinterpret_cast<uint64_t const*>(baseComponent + stringFields[f]);
+            if (stringIndex == InvalidString || !atom.IsValid())
+            {
+                if ((stringIndex == InvalidString) != !atom.IsValid())
+                    return false;
+            }
+            else if (Util::String::StrCmp(atom.Value(), writer.baseStringData + writer.baseStringOffsets[stringIndex]) != 0)
+            {
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+//------------------------------------------------------------------------------
+/**
+*/
+static void
+SerializeColumn(
+    SnapshotWriter& writer,
+    Game::ComponentInterface const* cInterface,
+    Util::Array<uint32_t> const& stringFields,
+    MemDb::Table::Partition const* partition,
+    void const* buffer,
+    uint64_t offset
+)
+{
+    SizeT const typeSize = cInterface->typeSize;
+    ubyte* dst = writer.At<ubyte>(offset);
+    if (dst != nullptr)
+        Memory::Copy(buffer, dst, partition->numRows * typeSize);
+
+    if (stringFields.IsEmpty())
+        return;
+
+    // replace all string atoms with indices into the string table
+    ubyte const* src = static_cast<ubyte const*>(buffer);
+    for (uint32_t row = 0; row < partition->numRows; row++)
+    {
+        for (IndexT f = 0; f < stringFields.Size(); f++)
+        {
+            Util::StringAtom const& atom = *reinterpret_cast<Util::StringAtom const*>(src + row * typeSize + stringFields[f]);
+            uint64_t const stringIndex = atom.IsValid() ? writer.AddString(atom) : InvalidString;
+            if (dst != nullptr)
+                *reinterpret_cast<uint64_t*>(dst + row * typeSize + stringFields[f]) = stringIndex;
+        }
+    }
+}
+
+//------------------------------------------------------------------------------
+/**
+*/
+static void
+Serialize(SnapshotWriter& writer)
+{
+    World* world = writer.world;
+    Ptr<MemDb::Database> db = world->GetDatabase();
+    writer.size = 0;
+
+    uint64_t const headerOffset = writer.Reserve(sizeof(SnapshotHeader));
+    uint64_t const componentsOffset = writer.Reserve(sizeof(SnapshotComponent) * writer.components.Size());
+    uint64_t const tablesOffset = writer.Reserve(sizeof(SnapshotTable) * writer.tables.Size());
+
+    SnapshotComponent* components = writer.At<SnapshotComponent>(componentsOffset);
+    if (components != nullptr)
+    {
+        for (IndexT i = 0; i < writer.components.Size(); i++)
+        {
+            components[i].name = writer.stringIndices[MemDb::AttributeRegistry::GetAttribute(writer.components[i])->name];
+            components[i].typeSize = MemDb::AttributeRegistry::TypeSize(writer.components[i]);
+        }
+    }
+
+    for (IndexT t = 0; t < writer.tables.Size(); t++)
+    {
+        MemDb::Table& table = db->GetTable(writer.tables[t]);
+        Util::Array<MemDb::AttributeId> const& attributes = table.GetAttributes();
+        SizeT const numColumns = attributes.Size();
+
+        uint32_t numPartitions = 0;
+        for (uint16_t p = 0; p < table.GetNumPartitions(); p++)
+        {
+            if (table.GetPartition(p) != nullptr)
+                numPartitions++;
+        }
+
+        SnapshotTable snapshotTable;
+        snapshotTable.numColumns = numColumns;
+        snapshotTable.numPartitions = numPartitions;
+        snapshotTable.totalNumRows = table.GetNumRows();
+        snapshotTable.baseTable = writer.base != nullptr ? FindBaseTable(writer, table) : InvalidSnapshotIndex;
+        snapshotTable.columns = writer.Reserve(sizeof(uint32_t) * numColumns);
+        snapshotTable.partitions = writer.Reserve(sizeof(SnapshotPartition) * numPartitions);
+
+        uint32_t* columns = writer.At<uint32_t>(snapshotTable.columns);
+        if (columns != nullptr)
+        {
+            for (IndexT c = 0; c < numColumns; c++)
+                columns[c] = writer.componentIndices[attributes[c]];
+        }
+
+        // gather string fields of each column
+        Util::FixedArray<Util::Array<uint32_t>> stringFields(numColumns);
+        for (IndexT c = 0; c < numColumns; c++)
+        {
+            Game::ComponentInterface const* cInterface =
+                static_cast<Game::ComponentInterface*>(MemDb::AttributeRegistry::GetAttribute(attributes[c]));
+            for (IndexT i = 0; i < cInterface->GetNumFields(); i++)
+            {
+                if (IsStringField(cInterface->GetFieldTypenames()[i]))
+                    stringFields[c].Append(cInterface->GetFieldByteOffsets()[i]);
+            }
+        }
+
+        SnapshotTable const* baseTable = nullptr;
+        if (snapshotTable.baseTable != InvalidSnapshotIndex)
+            baseTable = reinterpret_cast<SnapshotTable const*>(writer.base + writer.baseHeader->tables) + snapshotTable.baseTable;
+
+        uint32_t partitionIndex = 0;
+        for (uint16_t p = 0; p < table.GetNumPartitions(); p++)
+        {
+            MemDb::Table::Partition* partition = table.GetPartition(p);
+            if (partition == nullptr)
+                continue;
+
+            SnapshotPartition snapshotPartition;
+            snapshotPartition.validRows = partition->validRows;
+            snapshotPartition.partitionId = partition->partitionId;
+            snapshotPartition.pad = 0;
+            snapshotPartition.numRows = partition->numRows;
+            snapshotPartition.numFreeIds = partition->freeIds.Size();
+            snapshotPartition.basePartition = InvalidSnapshotIndex;
+            snapshotPartition.freeIds = writer.Reserve(sizeof(uint16_t) * partition->freeIds.Size());
+            snapshotPartition.columns = writer.Reserve(sizeof(uint64_t) * numColumns);
+
+            uint64_t const* baseColumnOffsets = nullptr;
+            if (baseTable != nullptr)
+            {
+                snapshotPartition.basePartition = FindBasePartition(writer, *baseTable, partition->partitionId);
+                if (snapshotPartition.basePartition != InvalidSnapshotIndex)
+                {
+                    SnapshotPartition const& basePartition =
+                        reinterpret_cast<SnapshotPartition const*>(writer.base + baseTable->partitions)[snapshotPartition.basePartition];
+                    if (IsSameLayout(writer, basePartition, partition))
+                        baseColumnOffsets = reinterpret_cast<uint64_t const*>(writer.base + basePartition.columns);
+                }
+            }
+
+            uint16_t* freeIds = writer.At<uint16_t>(snapshotPartition.freeIds);
+            if (freeIds != nullptr && !partition->freeIds.IsEmpty())
+                Memory::Copy(partition->freeIds.Begin(), freeIds, sizeof(uint16_t) * partition->freeIds.Size());
+
+            uint64_t* columnOffsets = writer.At<uint64_t>(snapshotPartition.columns);
+            for (IndexT c = 0; c < numColumns; c++)
+            {
+                Game::ComponentInterface const* cInterface =
+                    static_cast<Game::ComponentInterface*>(MemDb::AttributeRegistry::GetAttribute(attributes[c]));
+
+                uint64_t columnOffset = 0;
+                if (cInterface->typeSize > 0)
+                {
+                    // not every write bumps the change ticks, such as writes through views outside of processors,
+                    // so columns are compared with the base. Columns written after the base can skip the comparison.
+                    if (baseColumnOffsets != nullptr &&
+                        partition->columnVersions[c] <= writer.baseHeader->changeTick &&
+                        ColumnMatchesBase(writer, cInterface, stringFields[c], partition, partition->columns[c], baseColumnOffsets[c]))
+                    {
+                        columnOffset = ColumnInBase;
+                    }
+                    else
+                    {
+                        columnOffset = writer.Reserve(partition->numRows * cInterface->typeSize);
+                        SerializeColumn(writer, cInterface, stringFields[c], partition, partition->columns[c], columnOffset);
+                    }
+                }
+                if (columnOffsets != nullptr)
+                    columnOffsets[c] = columnOffset;
+            }
+
+            SnapshotPartition* partitions = writer.At<SnapshotPartition>(snapshotTable.partitions);
+            if (partitions != nullptr)
+                partitions[partitionIndex] = snapshotPartition;
+            partitionIndex++;
+        }
+
+        SnapshotTable* tables = writer.At<SnapshotTable>(tablesOffset);
+        if (tables != nullptr)
+            tables[t] = snapshotTable;
+    }
+
+    // entity map, remapped to indices into the tables of the snapshot
+    uint64_t const entityMapOffset = writer.Reserve(sizeof(SnapshotEntityMapping) * world->entityMap.Size());
+    uint64_t const generationsOffset = writer.Reserve(sizeof(uint16_t) * world->pool.generations.Size());
+    uint64_t const freeEntityIdsOffset = writer.Reserve(sizeof(uint32_t) * world->pool.freeIds.Size());
+    if (writer.data != nullptr)
+    {
+        SnapshotEntityMapping* entityMap = writer.At<SnapshotEntityMapping>(entityMapOffset);
+        for (IndexT i = 0; i < world->entityMap.Size(); i++)
+        {
+            EntityMapping const& mapping = world->entityMap[i];
+            entityMap[i].table = mapping.table == MemDb::InvalidTableId ? InvalidSnapshotIndex : writer.tables.FindIndex(mapping.table);
+            entityMap[i].instance = mapping.instance;
+        }
+
+        if (!world->pool.generations.IsEmpty())
+            Memory::Copy(world->pool.generations.Begin(), writer.At<uint16_t>(generationsOffset), sizeof(uint16_t) * world->pool.generations.Size());
+
+        uint32_t* freeEntityIds = writer.At<uint32_t>(freeEntityIdsOffset);
+        for (IndexT i = 0; i < world->pool.freeIds.Size(); i++)
+            freeEntityIds[i] = world->pool.freeIds[i];
+    }
+
+    // string table goes last, since the column data adds strings to it during the first pass
+    uint64_t const stringOffsetsOffset = writer.Reserve(sizeof(uint64_t) * writer.strings.Size());
+    uint64_t stringDataSize = 0;
+    for (IndexT i = 0; i < writer.strings.Size(); i++)
+        stringDataSize += Util::String::StrLen(writer.strings[i].Value()) + 1;
+    uint64_t const stringDataOffset = writer.Reserve(stringDataSize);
+
+    if (writer.data != nullptr)
+    {
+        uint64_t* stringOffsets = writer.At<uint64_t>(stringOffsetsOffset);
+        char* stringData = writer.At<char>(stringDataOffset);
+        uint64_t offset = 0;
+        for (IndexT i = 0; i < writer.strings.Size(); i++)
+        {
+            SizeT const length = Util::String::StrLen(writer.strings[i].Value()) + 1;
+            stringOffsets[i] = offset;
+            Memory::Copy(writer.strings[i].Value(), stringData + offset, length);
+            offset += length;
+        }
+
+        SnapshotHeader* header = writer.At<SnapshotHeader>(headerOffset);
+        header->magic = SnapshotMagic;
+        header->version = SnapshotVersion;
+        header->flags = writer.base != nullptr ? SnapshotFlag_Delta : 0;
+        header->numComponents = writer.components.Size();
+        header->numTables = writer.tables.Size();
+        header->numStrings = writer.strings.Size();
+        header->numEntities = world->numEntities;
+        header->entityMapSize = world->entityMap.Size();
+        header->numFreeEntityIds = world->pool.freeIds.Size();
+        header->pad = 0;
+        header->changeTick = world->GetChangeTick();
+        header->baseChangeTick = writer.base != nullptr ? writer.baseHeader->changeTick : 0;
+        header->totalSize = Math::alignptr(writer.size, SnapshotAlignment);
+        header->components = componentsOffset;
+        header->tables = tablesOffset;
+        header->entityMap = entityMapOffset;
+        header->generations = generationsOffset;
+        header->freeEntityIds = freeEntityIdsOffset;
+        header->stringOffsets = stringOffsetsOffset;
+        header->stringData = stringDataOffset;
+    }
+
+    writer.size = Math::alignptr(writer.size, SnapshotAlignment);
+}
+
+//------------------------------------------------------------------------------
+/**
+*/
+static Util::Blob
+WriteSnapshot(SnapshotWriter& writer)
+{
+    Ptr<MemDb::Database> db = writer.world->GetDatabase();
+    db->ForEachTable(
+        [&writer, &db](MemDb::TableId tid)
+        {
+            writer.tables.Append(tid);
+            Util::Array<MemDb::AttributeId> const& attributes = db->GetTable(tid).GetAttributes();
+            for (IndexT c = 0; c < attributes.Size(); c++)
+            {
+                if (!writer.componentIndices.Contains(attributes[c]))
+                {
+                    writer.componentIndices.Add(attributes[c], writer.components.Size());
+                    writer.components.Append(attributes[c]);
+                    writer.AddString(MemDb::AttributeRegistry::GetAttribute(attributes[c])->name);
+                }
+            }
+        }
+    );
+
+    // measure and gather strings
+    Serialize(writer);
+
+    Util::Blob blob(writer.size);
+    Memory::Clear(blob.GetPtr(), writer.size);
+    writer.data = static_cast<ubyte*>(blob.GetPtr());
+    Serialize(writer);
+    return blob;
+}
+
+//------------------------------------------------------------------------------
+/**
+*/
+Util::Blob
+WorldSnapshot::Write(World* world)
+{
+    SnapshotWriter writer;
+    writer.world = world;
+    return WriteSnapshot(writer);
+}
+
+//------------------------------------------------------------------------------
+/**
+*/
+Util::Blob
+WorldSnapshot::WriteDelta(World* world, void const* base, size_t baseSize)
+{
+    SnapshotHeader const* baseHeader = ValidateSnapshot(base, baseSize);
+    n_assert2((baseHeader->flags & SnapshotFlag_Delta) == 0, "Delta snapshots must be written against a full snapshot!");
+
+    SnapshotWriter writer;
+    writer.world = world;
+    writer.base = static_cast<ubyte const*>(base);
+    writer.baseHeader = baseHeader;
+    writer.baseComponents = ResolveComponents(writer.base, baseHeader);
+    writer.baseStringOffsets = reinterpret_cast<uint64_t const*>(writer.base + baseHeader->stringOffsets);
+    writer.baseStringData = reinterpret_cast<const char*>(writer.base + baseHeader->stringData);
+    return WriteSnapshot(writer);
+}
+
+//------------------------------------------------------------------------------
+/**
+*/
+bool
+WorldSnapshot::IsDelta(void const* data, size_t size)
+{
+    return (ValidateSnapshot(data, size)->flags & SnapshotFlag_Delta) != 0;
+}
+
+//------------------------------------------------------------------------------
+/**
+    The tables of the world are kept, and only their content is replaced, so that
+    table ids that are kept around (such as blueprint tables) stay valid.
+*/
+void
+WorldSnapshot::Read(World* world, void const* data, size_t size, void const* base, size_t baseSize)
+{
+    n_assert(!world->GetFramePipeline().IsRunningAsync());
+
+    ubyte const* src = static_cast<ubyte const*>(data);
+    SnapshotHeader const* header = ValidateSnapshot(data, size);
+
+    ubyte const* baseData = static_cast<ubyte const*>(base);
+    SnapshotHeader const* baseHeader = nullptr;
+    if ((header->flags & SnapshotFlag_Delta) != 0)
+    {
+        n_assert2(base != nullptr, "Delta snapshots can only be read together with their base snapshot!");
+        baseHeader = ValidateSnapshot(base, baseSize);
+        n_assert2(baseHeader->changeTick == header->baseChangeTick, "Delta snapshot was not written against this base snapshot!");
+    }
+
+    Util::FixedArray<ComponentId> const components = ResolveComponents(src, header);
+
+    // resolve all strings once. Columns copied from the base snapshot index into its string table.
+    Util::FixedArray<Util::StringAtom> const strings = ResolveStrings(src, header);
+    Util::FixedArray<Util::StringAtom> baseStrings;
+    if (baseHeader != nullptr)
+        baseStrings = ResolveStrings(baseData, baseHeader);
+
+    // move the components of all current entities to the decay buffers, so that
+    // the managers release the resources they own, same as when deleting them
+    Ptr<MemDb::Database> db = world->GetDatabase();
+    for (IndexT i = 0; i < world->entityMap.Size(); i++)
+    {
+        EntityMapping const& mapping = world->entityMap[i];
+        if (mapping.table == MemDb::InvalidTableId || mapping.instance == MemDb::InvalidRow)
+            continue;
+        Util::Array<ComponentId> const& attributes = db->GetTable(mapping.table).GetAttributes();
+        for (MemDb::ColumnIndex column = 0; column.id < attributes.Size(); column.id++)
+            world->DecayComponent(attributes[column.id], mapping.table, column, mapping.instance);
+    }
+
+    // empty all tables in the world
+    db->ForEachTable([&db](MemDb::TableId tid) { db->GetTable(tid).Clear(); });
+
+    SnapshotTable const* tables = reinterpret_cast<SnapshotTable const*>(src + header->tables);
+    Util::FixedArray<MemDb::TableId> tableIds(header->numTables);
+    for (uint32_t t = 0; t < header->numTables; t++)
+    {
+        SnapshotTable const& snapshotTable = tables[t];
+        uint32_t const* columns = reinterpret_cast<uint32_t const*>(src + snapshotTable.columns);
+
+        Util::FixedArray<ComponentId> attributes(snapshotTable.numColumns);
+        for (uint32_t c = 0; c < snapshotTable.numColumns; c++)
+            attributes[c] = components[columns[c]];
+
+        MemDb::TableId tid = db->FindTable(MemDb::TableSignature(attributes));
+        if (tid == MemDb::TableId::Invalid())
+        {
+            MemDb::TableCreateInfo info;
+            info.name = "";
+            info.numAttributes = attributes.Size();
+            info.attributeIds = attributes.Begin();
+            tid = db->CreateTable(info);
+        }
+        tableIds[t] = tid;
+
+        MemDb::Table& table = db->GetTable(tid);
+        Util::FixedArray<MemDb::ColumnIndex> dstColumns(snapshotTable.numColumns);
+        Util::FixedArray<SizeT> typeSizes(snapshotTable.numColumns);
+        Util::FixedArray<Util::Array<uint32_t>> stringFields(snapshotTable.numColumns);
+        for (uint32_t c = 0; c < snapshotTable.numColumns; c++)
+        {
+            dstColumns[c] = table.GetAttributeIndex(attributes[c]);
+            Game::ComponentInterface const* cInterface =
+                static_cast<Game::ComponentInterface*>(MemDb::AttributeRegistry::GetAttribute(attributes[c]));
+            typeSizes[c] = cInterface->typeSize;
+            for (IndexT i = 0; i < cInterface->GetNumFields(); i++)
+            {
+                if (IsStringField(cInterface->GetFieldTypenames()[i]))
+                    stringFields[c].Append(cInterface->GetFieldByteOffsets()[i]);
+            }
+        }
+
+        SnapshotPartition const* basePartitions = nullptr;
+        if (snapshotTable.baseTable != InvalidSnapshotIndex)
+            basePartitions = reinterpret_cast<SnapshotPartition const*>(baseData + reinterpret_cast<SnapshotTable const*>(baseData + baseHeader->tables)[snapshotTable.baseTable].partitions);
+
+        SnapshotPartition const* partitions = reinterpret_cast<SnapshotPartition const*>(src + snapshotTable.partitions);
+        for (uint32_t p = 0; p < snapshotTable.numPartitions; p++)
+        {
+            SnapshotPartition const& snapshotPartition = partitions[p];
+            MemDb::Table::Partition* partition = table.RestorePartition(snapshotPartition.partitionId);
+            partition->numRows = snapshotPartition.numRows;
+            partition->validRows = snapshotPartition.validRows;
+
+            uint16_t const* freeIds = reinterpret_cast<uint16_t const*>(src + snapshotPartition.freeIds);
+            partition->freeIds.Reserve(snapshotPartition.numFreeIds);
+            for (uint32_t i = 0; i < snapshotPartition.numFreeIds; i++)
+                partition->freeIds.Append(freeIds[i]);
+
+            uint64_t const* columnOffsets = reinterpret_cast<uint64_t const*>(src + snapshotPartition.columns);
+            for (uint32_t c = 0; c < snapshotTable.numColumns; c++)
+            {
+                if (columnOffsets[c] == 0)
+                    continue;
+
+                ubyte const* columnData;
+                Util::FixedArray<Util::StringAtom> const* columnStrings = &strings;
+                if (columnOffsets[c] == ColumnInBase)
+                {
+                    columnStrings = &baseStrings;
+                    n_assert(basePartitions != nullptr && snapshotPartition.basePartition != InvalidSnapshotIndex);
+                    uint64_t const* baseColumnOffsets = reinterpret_cast<uint64_t const*>(baseData + basePartitions[snapshotPartition.basePartition].columns);
+                    columnData = baseData + baseColumnOffsets[c];
+                }
+                else
+                {
+                    columnData = src + columnOffsets[c];
+                }
+
+                SizeT const typeSize = typeSizes[c];
+                ubyte* dst = static_cast<ubyte*>(partition->columns[dstColumns[c].id]);
+                Memory::Copy(columnData, dst, snapshotPartition.numRows * typeSize);
+
+                // resolve string indices
+                Util::Array<uint32_t> const& fields = stringFields[c];
+                for (IndexT f = 0; f < fields.Size(); f++)
+                {
+                    for (uint32_t row = 0; row < snapshotPartition.numRows; row++)
+                    {
+                        ubyte* field = dst + row * typeSize + fields[f];
+                        uint64_t const stringIndex = *reinterpret_cast<uint64_t*>(field);
+                        *reinterpret_cast<Util::StringAtom*>(field) = stringIndex == InvalidString ? Util::StringAtom() : (*columnStrings)[stringIndex];
+                    }
+                }
+            }
+
+            // the owners might come from a different world
+            Game::Entity* owners = static_cast<Game::Entity*>(partition->columns[Game::Entity::Traits::fixed_column_index]);
+            for (uint32_t row = 0; row < snapshotPartition.numRows; row++)
+                owners[row].world = world->worldId;
+        }
+        table.SetNumRows(snapshotTable.totalNumRows);
+    }
+
+    // entity map and pool
+    SnapshotEntityMapping const* entityMap = reinterpret_cast<SnapshotEntityMapping const*>(src + header->entityMap);
+    world->entityMap.Clear();
+    world->entityMap.Reserve(header->entityMapSize);
+    for (uint32_t i = 0; i < header->entityMapSize; i++)
+    {
+        EntityMapping mapping;
+        mapping.table = entityMap[i].table == InvalidSnapshotIndex ? MemDb::InvalidTableId : tableIds[entityMap[i].table];
+        mapping.instance = entityMap[i].instance;
+        world->entityMap.Append(mapping);
+    }
+
+    uint16_t const* generations = reinterpret_cast<uint16_t const*>(src + header->generations);
+    world->pool.generations.Clear();
+    world->pool.generations.Reserve(header->entityMapSize);
+    for (uint32_t i = 0; i < header->entityMapSize; i++)
+        world->pool.generations.Append(generations[i]);
+
+    uint32_t const* freeEntityIds = reinterpret_cast<uint32_t const*>(src + header->freeEntityIds);
+    world->pool.freeIds.Clear();
+    for (uint32_t i = 0; i < header->numFreeEntityIds; i++)
+        world->pool.freeIds.Enqueue(freeEntityIds[i]);
+
+    world->numEntities = header->numEntities;
+
+    // initialize all components, any resources they were written with have been released above
+    if (world->componentInitializationEnabled)
+    {
+        for (IndexT i = 0; i < world->entityMap.Size(); i++)
+        {
+            EntityMapping const& mapping = world->entityMap[i];
+            if (mapping.table == MemDb::InvalidTableId)
+                continue;
+            Game::Entity const* owners = static_cast<Game::Entity*>(
+                world->GetInstanceBuffer(mapping.table, mapping.instance.partition, GetComponentId<Game::Entity>())
+            );
+            Game::Entity const entity = owners[mapping.instance.index];
+            world->InitializeAllComponents(entity, mapping.table, mapping.instance);
+        }
+    }
+
+    world->PrefilterProcessors();
+}
+
+//------------------------------------------------------------------------------
+/**
+*/
+void
+WorldSnapshot::Save(World* world, IO::URI const& uri)
+{
+    Util::Blob const blob = WorldSnapshot::Write(world);
+
+    Ptr<IO::BinaryWriter> writer = IO::BinaryWriter::Create();
+    writer->SetStream(IO::IoServer::Instance()->CreateStream(uri));
+    writer->Open();
+    writer->WriteRawData(blob.GetPtr(), blob.Size());
+    writer->Close();
+}
+
+//------------------------------------------------------------------------------
+/**
+*/
+void
+WorldSnapshot::Load(World* world, IO::URI const& uri)
+{
+    Ptr<IO::BinaryReader> reader = IO::BinaryReader::Create();
+    reader->SetStream(IO::IoServer::Instance()->CreateStream(uri));
+    reader->SetMemoryMappingEnabled(true);
+    reader->Open();
+    n_assert2(reader->mapCursor != nullptr, "World snapshots must be loaded from a stream that can be memory mapped!");
+
+    WorldSnapshot::Read(world, reader->mapCursor, reader->GetStream()->GetSize());
+    reader->Close();
+}
+
+} // namespace Game
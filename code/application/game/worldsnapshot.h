@@ -0,0 +1,55 @@
+#pragma once
+//------------------------------------------------------------------------------
+/**
+    @class Game::WorldSnapshot
+
+    @brief Raw binary snapshots of a game world.
+
+    @details A snapshot contains the tables of the world's database with their
+    partitions and column data, the entity map, the entity pool and a table of
+    all strings referenced by string fields. Column data is stored as raw blobs,
+    aligned to 16 bytes, so that snapshots can be read directly from a memory
+    mapped file.
+
+    A delta snapshot is written against a previous, full snapshot. It only contains
+    the column data of partitions that differ from the previous snapshot. Columns
+    that have been written since are found through the change ticks of the
+    partitions, all other columns are compared with the previous snapshot. The layout of all
+    tables, partitions and the entity map is always stored in full. Reading a delta
+    snapshot requires the snapshot it was written against.
+
+    Snapshots are only compatible with the same build, since component data is stored as-is.
+
+    @see Game::World::Override
+
+    @copyright
+    (C) 2024 Individual contributors, see AUTHORS file
+*/
+//------------------------------------------------------------------------------
+#include "util/blob.h"
+#include "io/uri.h"
+
+namespace Game
+{
+
+class World;
+
+class WorldSnapshot
+{
+public:
+    /// write a snapshot of the world
+    static Util::Blob Write(World* world);
+    /// write a snapshot that only contains the column data that changed since the base snapshot was written
+    static Util::Blob WriteDelta(World* world, void const* base, size_t baseSize);
+    /// replace the contents of the world with a snapshot, the current components are decayed. Delta snapshots require the snapshot they were written against
+    static void Read(World* world, void const* data, size_t size, void const* base = nullptr, size_t baseSize = 0);
+    /// check if data is a delta snapshot
+    static bool IsDelta(void const* data, size_t size);
+
+    /// write a snapshot of the world to a file
+    static void Save(World* world, IO::URI const& uri);
+    /// replace the contents of the world with a snapshot read from a memory mapped file
+    static void Load(World* world, IO::URI const& uri);
+};
+
+} // namespace Game
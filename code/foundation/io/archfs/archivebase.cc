@@ -103,4 +103,24 @@ ArchiveBase::ConvertToPathInArchive(const String& absPath) const
     return absPath;
 }
 
+//------------------------------------------------------------------------------
+/**
+    Override this method in a subclass!
+*/
+bool
+ArchiveBase::HasFile(const String& pathInArchive) const
+{
+    return false;
+}
+
+//------------------------------------------------------------------------------
+/**
+    Override this method in a subclass!
+*/
+bool
+ArchiveBase::HasDirectory(const String& pathInArchive) const
+{
+    return false;
+}
+
 } // namespace IO
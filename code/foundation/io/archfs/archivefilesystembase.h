@@ -4,6 +4,9 @@
     @class Base::ArchiveFileSystemBase
     
     Base class for archive file system wrappers.
+
+    Mounting an archive prefers a pack archive (.pack) over a zip archive
+    (.zip) with the same name, see IO::PackArchive.
     
     @copyright
     (C) 2009 Radon Labs GmbH
@@ -13,11 +16,11 @@
 #include "core/singleton.h"
 #include "util/dictionary.h"
 #include "io/uri.h"
+#include "io/archfs/archivebase.h"
 
 //------------------------------------------------------------------------------
 namespace IO
 {
-class Archive;
 
 class ArchiveFileSystemBase : public Core::RefCounted
 {
@@ -37,13 +40,13 @@ public:
     bool IsValid() const;
     
     /// mount an archive
-    virtual Ptr<Archive> Mount(const URI& uri);
+    virtual Ptr<ArchiveBase> Mount(const URI& uri);
     /// mount an embedded archive
-    virtual Ptr<Archive> MountEmbedded(const URI& uri, const Util::String& rootPath);
+    virtual Ptr<ArchiveBase> MountEmbedded(const URI& uri, const Util::String& rootPath);
     /// unmount an archive by URI
     virtual void Unmount(const URI& uri);
     /// unmount an archive by pointer
-    virtual void Unmount(const Ptr<Archive>& archive);
+    virtual void Unmount(const Ptr<ArchiveBase>& archive);
     /// return true if an archive is mounted
     bool IsMounted(const URI& uri) const;
 
@@ -51,14 +54,14 @@ public:
     bool HasArchives() const;
     
     /// get an array of all mounted archives
-    Util::Array<Ptr<Archive> > GetMountedArchives() const;
+    Util::Array<Ptr<ArchiveBase> > GetMountedArchives() const;
     /// find a zip archive by its URI, returns invalid ptr if not mounted
-    Ptr<Archive> FindArchive(const URI& uri) const;
+    Ptr<ArchiveBase> FindArchive(const URI& uri) const;
 
     /// find first archive which contains the file path
-    virtual Ptr<Archive> FindArchiveWithFile(const URI& fileUri) const;
+    virtual Ptr<ArchiveBase> FindArchiveWithFile(const URI& fileUri) const;
     /// find first archive which contains the directory path
-    virtual Ptr<Archive> FindArchiveWithDir(const URI& dirUri) const;
+    virtual Ptr<ArchiveBase> FindArchiveWithDir(const URI& dirUri) const;
     /// transparently convert a URI pointing to a file into a matching archive URI
     URI ConvertFileToArchiveURIIfExists(const URI& uri) const;
     /// transparently convert a URI pointing to a directory into a matching archive URI    
@@ -66,7 +69,7 @@ public:
 
 protected:
     Threading::CriticalSection critSect;
-    Util::Dictionary<Util::String, Ptr<Archive> > archives;
+    Util::Dictionary<Util::String, Ptr<ArchiveBase> > archives;
     bool isValid;
 };
 
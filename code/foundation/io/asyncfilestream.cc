@@ -0,0 +1,105 @@
+//------------------------------------------------------------------------------
+//  asyncfilestream.cc
+//  (C) 2024 Individual contributors, see AUTHORS file
+//------------------------------------------------------------------------------
+#include "foundation/stdneb.h"
+#include "io/asyncfilestream.h"
+#include "io/ioserver.h"
+
+namespace IO
+{
+__ImplementClass(IO::AsyncFileStream, 'AFST', Core::RefCounted);
+
+//------------------------------------------------------------------------------
+/**
+*/
+AsyncFileStream::AsyncFileStream() :
+    handle(nullptr),
+    numPendingReads(0)
+{
+    // empty
+}
+
+//------------------------------------------------------------------------------
+/**
+*/
+AsyncFileStream::~AsyncFileStream()
+{
+    if (this->IsOpen())
+    {
+        this->Close();
+    }
+}
+
+//------------------------------------------------------------------------------
+/**
+*/
+bool
+AsyncFileStream::Open()
+{
+    n_assert(!this->IsOpen());
+    n_assert(this->uri.Scheme() == "file");
+    n_assert(this->uri.LocalPath().IsValid());
+
+    if (!this->queue.isvalid())
+    {
+        this->queue = IoServer::Instance()->GetAsyncIoQueue();
+    }
+
+    // async streams read with explicit offsets, so the access pattern is always random
+    this->handle = FSWrapper::OpenFile(this->uri.GetHostAndLocalPath(), Stream::ReadAccess, Stream::Random);
+    return this->handle != nullptr;
+}
+
+//------------------------------------------------------------------------------
+/**
+*/
+void
+AsyncFileStream::Close()
+{
+    n_assert(this->IsOpen());
+
+    // the backend still writes into the buffers of reads in flight
+    while (this->numPendingReads > 0)
+    {
+        this->queue->Wait();
+    }
+    FSWrapper::CloseFile(this->handle);
+    this->handle = nullptr;
+}
+
+//------------------------------------------------------------------------------
+/**
+*/
+Stream::Size
+AsyncFileStream::GetSize() const
+{
+    n_assert(this->IsOpen());
+    return FSWrapper::GetFileSize(this->handle);
+}
+
+//------------------------------------------------------------------------------
+/**
+*/
+void
+AsyncFileStream::ReadAsync(Stream::Position offset, void* buffer, Stream::Size numBytes, const AsyncReadCallback& callback)
+{
+    AsyncReadRegion region;
+    region.offset = offset;
+    region.buffer = buffer;
+    region.size = numBytes;
+    this->ReadAsync(&region, 1, callback);
+}
+
+//------------------------------------------------------------------------------
+/**
+*/
+void
+AsyncFileStream::ReadAsync(const AsyncReadRegion* regions, SizeT numRegions, const AsyncReadCallback& callback)
+{
+    n_assert(this->IsOpen());
+    n_assert(numRegions > 0);
+    this->queue->Read(this, regions, numRegions, callback);
+}
+
+} // namespace IO
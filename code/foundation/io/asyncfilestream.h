@@ -0,0 +1,131 @@
+#pragma once
+//------------------------------------------------------------------------------
+/**
+    @class IO::AsyncFileStream
+
+    A read-only filesystem file which is read asynchronously through an
+    IO::AsyncIoQueue, instead of blocking the calling thread like IO::FileStream.
+
+    Reads go straight into caller owned buffers, for example staging memory
+    handed out by a Memory::RangeAllocator, and a single request can scatter
+    several ranges of the file into different buffers. The completion callback
+    is invoked once all ranges of a request have been read, from the Poll or
+    Wait of the queue, on the thread that issued the read.
+
+    Any number of reads can be in flight on the same stream. Buffers must stay
+    valid until the callback has been invoked. Closing the stream waits for its
+    reads to finish.
+
+    By default reads are issued on the queue of the calling thread's IoServer.
+
+    @copyright
+    (C) 2024 Individual contributors, see AUTHORS file
+*/
+#include "core/refcounted.h"
+#include "io/uri.h"
+#include "io/asyncioqueue.h"
+
+//------------------------------------------------------------------------------
+namespace IO
+{
+class AsyncFileStream : public Core::RefCounted
+{
+    __DeclareClass(AsyncFileStream);
+public:
+    /// constructor
+    AsyncFileStream();
+    /// destructor
+    virtual ~AsyncFileStream();
+
+    /// set the uri of the file, must be a file scheme uri
+    void SetURI(const URI& u);
+    /// get the uri of the file
+    const URI& GetURI() const;
+    /// set the queue to issue reads on, must be called before Open
+    void SetQueue(const Ptr<AsyncIoQueue>& queue);
+    /// get the queue reads are issued on
+    const Ptr<AsyncIoQueue>& GetQueue() const;
+
+    /// open the file
+    bool Open();
+    /// close the file, waits for all reads in flight
+    void Close();
+    /// return true if the file is open
+    bool IsOpen() const;
+    /// get the size of the file in bytes
+    Stream::Size GetSize() const;
+    /// get the number of reads of this stream that have not finished
+    SizeT GetNumPendingReads() const;
+
+    /// read numBytes at offset into buffer
+    void ReadAsync(Stream::Position offset, void* buffer, Stream::Size numBytes, const AsyncReadCallback& callback);
+    /// read several ranges of the file into their buffers, the callback is invoked once all of them have been read
+    void ReadAsync(const AsyncReadRegion* regions, SizeT numRegions, const AsyncReadCallback& callback);
+
+private:
+    friend class AsyncIoQueue;
+
+    URI uri;
+    Ptr<AsyncIoQueue> queue;
+    FSWrapper::Handle handle;
+    SizeT numPendingReads;
+};
+
+//------------------------------------------------------------------------------
+/**
+*/
+inline void
+AsyncFileStream::SetURI(const URI& u)
+{
+    n_assert(!this->IsOpen());
+    this->uri = u;
+}
+
+//------------------------------------------------------------------------------
+/**
+*/
+inline const URI&
+AsyncFileStream::GetURI() const
+{
+    return this->uri;
+}
+
+//------------------------------------------------------------------------------
+/**
+*/
+inline void
+AsyncFileStream::SetQueue(const Ptr<AsyncIoQueue>& q)
+{
+    n_assert(!this->IsOpen());
+    this->queue = q;
+}
+
+//------------------------------------------------------------------------------
+/**
+*/
+inline const Ptr<AsyncIoQueue>&
+AsyncFileStream::GetQueue() const
+{
+    return this->queue;
+}
+
+//------------------------------------------------------------------------------
+/**
+*/
+inline bool
+AsyncFileStream::IsOpen() const
+{
+    return this->handle != nullptr;
+}
+
+//------------------------------------------------------------------------------
+/**
+*/
+inline SizeT
+AsyncFileStream::GetNumPendingReads() const
+{
+    return this->numPendingReads;
+}
+
+} // namespace IO
+//------------------------------------------------------------------------------
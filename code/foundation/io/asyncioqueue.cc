@@ -0,0 +1,579 @@
+//------------------------------------------------------------------------------
+//  asyncioqueue.cc
+//  (C) 2024 Individual contributors, see AUTHORS file
+//------------------------------------------------------------------------------
+#include "foundation/stdneb.h"
+#include "io/asyncioqueue.h"
+#include "io/asyncfilestream.h"
+#include "math/scalar.h"
+#include <stdio.h>
+
+namespace IO
+{
+__ImplementClass(IO::AsyncIoThread, 'AIOT', Threading::Thread);
+__ImplementClass(IO::AsyncIoQueue, 'AIOQ', Core::RefCounted);
+
+/// largest read handed to io_uring at once, longer reads are split
+static const Stream::Size MaxRingReadSize = 1 << 30;
+/// user data of the cancellations posted when the ring fails
+static const uint64_t CancelUserData = ~0ull;
+
+//------------------------------------------------------------------------------
+/**
+*/
+AsyncIoThread::AsyncIoThread() :
+    queue(nullptr)
+{
+    // empty
+}
+
+//------------------------------------------------------------------------------
+/**
+*/
+void
+AsyncIoThread::DoWork()
+{
+    AsyncIoQueue::Work work;
+    while (!this->ThreadStopRequested())
+    {
+        if (this->queue->TakeWork(work))
+        {
+            Stream::Size res = FSWrapper::ReadAt(work.handle, work.buffer, work.size, work.offset);
+            this->queue->PushCompletion(work.read, res);
+        }
+        else
+        {
+            this->queue->WaitForWork();
+        }
+    }
+}
+
+//------------------------------------------------------------------------------
+/**
+*/
+void
+AsyncIoThread::EmitWakeupSignal()
+{
+    this->queue->workEvent.Signal();
+}
+
+//------------------------------------------------------------------------------
+/**
+*/
+AsyncIoQueue::AsyncIoQueue() :
+    backend(None),
+    numPending(0),
+    numReadsInFlight(0),
+    numThreads(0),
+    shuttingDown(false)
+{
+    // empty
+}
+
+//------------------------------------------------------------------------------
+/**
+*/
+AsyncIoQueue::~AsyncIoQueue()
+{
+    if (this->backend != None)
+    {
+        this->Discard();
+    }
+}
+
+//------------------------------------------------------------------------------
+/**
+*/
+void
+AsyncIoQueue::Setup(SizeT queueDepth, SizeT numThreads, bool forceThreadPool)
+{
+    n_assert(this->backend == None);
+    n_assert(queueDepth > 0);
+    n_assert(numThreads > 0);
+    this->numThreads = numThreads;
+
+#if __linux__
+    if (!forceThreadPool && this->ring.Setup((uint32_t)queueDepth))
+    {
+        this->backend = IoUring;
+        return;
+    }
+#endif
+
+    this->backend = ThreadPool;
+    this->StartThreads();
+}
+
+//------------------------------------------------------------------------------
+/**
+*/
+void
+AsyncIoQueue::StartThreads()
+{
+    for (IndexT i = 0; i < this->numThreads; i++)
+    {
+        Ptr<AsyncIoThread> thread = AsyncIoThread::Create();
+        thread->queue = this;
+        thread->SetName(Util::String::Sprintf("Async IO Thread #%d", i));
+        thread->Start();
+        this->threads.Append(thread);
+    }
+}
+
+//------------------------------------------------------------------------------
+/**
+*/
+void
+AsyncIoQueue::Discard()
+{
+    n_assert(this->backend != None);
+    this->Wait();
+
+#if __linux__
+    if (this->ring.IsValid())
+    {
+        this->ring.Discard();
+    }
+#endif
+
+    if (!this->threads.IsEmpty())
+    {
+        this->shuttingDown = true;
+        this->workEvent.Signal();
+        for (IndexT i = 0; i < this->threads.Size(); i++)
+        {
+            this->threads[i]->Stop();
+        }
+        this->threads.Clear();
+        this->shuttingDown = false;
+    }
+
+    this->requests.Clear();
+    this->freeRequests.Clear();
+    this->reads.Clear();
+    this->freeReads.Clear();
+    this->backend = None;
+}
+
+//------------------------------------------------------------------------------
+/**
+*/
+void
+AsyncIoQueue::Read(AsyncFileStream* stream, const AsyncReadRegion* regions, SizeT numRegions, const AsyncReadCallback& callback)
+{
+    n_assert(this->backend != None);
+
+    IndexT requestIndex;
+    if (!this->freeRequests.IsEmpty())
+    {
+        requestIndex = this->freeRequests.PopBack();
+    }
+    else
+    {
+        requestIndex = this->requests.Size();
+        this->requests.Append(Request());
+    }
+    Request& request = this->requests[requestIndex];
+    request.stream = stream;
+    request.callback = callback;
+    request.numReadsLeft = numRegions;
+    request.bytesRead = 0;
+    request.success = true;
+    stream->numPendingReads++;
+    this->numPending++;
+
+    for (IndexT i = 0; i < numRegions; i++)
+    {
+        n_assert(regions[i].buffer != nullptr);
+        n_assert(regions[i].size > 0);
+        n_assert(regions[i].offset >= 0);
+
+        IndexT readIndex;
+        if (!this->freeReads.IsEmpty())
+        {
+            readIndex = this->freeReads.PopBack();
+        }
+        else
+        {
+            readIndex = this->reads.Size();
+            this->reads.Append(PendingRead());
+        }
+        PendingRead& read = this->reads[readIndex];
+        read.request = requestIndex;
+        read.buffer = regions[i].buffer;
+        read.size = regions[i].size;
+        read.offset = regions[i].offset;
+        read.bytesDone = 0;
+        this->queuedReads.Append(readIndex);
+    }
+}
+
+//------------------------------------------------------------------------------
+/**
+*/
+void
+AsyncIoQueue::PostResult(const AsyncReadCallback& callback, const AsyncReadResult& result)
+{
+    n_assert(this->backend != None);
+
+    IndexT requestIndex;
+    if (!this->freeRequests.IsEmpty())
+    {
+        requestIndex = this->freeRequests.PopBack();
+    }
+    else
+    {
+        requestIndex = this->requests.Size();
+        this->requests.Append(Request());
+    }
+    Request& request = this->requests[requestIndex];
+    request.stream = nullptr;
+    request.callback = callback;
+    request.numReadsLeft = 0;
+    request.bytesRead = result.bytesRead;
+    request.success = result.success;
+    this->finishedRequests.Append(requestIndex);
+    this->numPending++;
+}
+
+//------------------------------------------------------------------------------
+/**
+    Hands all queued reads to the backend. With io_uring, reads beyond the number
+    of completion slots stay queued until earlier reads have completed.
+*/
+void
+AsyncIoQueue::Submit()
+{
+    if (this->queuedReads.IsEmpty())
+        return;
+
+#if __linux__
+    if (this->backend == IoUring)
+    {
+        uint32_t const numSlots = this->ring.GetNumCompletionSlots();
+        IndexT i = 0;
+        while (i < this->queuedReads.Size() && this->numReadsInFlight < (SizeT)numSlots)
+        {
+            IndexT const readIndex = this->queuedReads[i];
+            PendingRead const& read = this->reads[readIndex];
+            int const fd = fileno(this->requests[read.request].stream->handle);
+            void* const buffer = (char*)read.buffer + read.bytesDone;
+            Stream::Size const numBytes = Math::min(read.size - read.bytesDone, MaxRingReadSize);
+            Stream::Position const offset = read.offset + read.bytesDone;
+            if (!this->ring.PrepareRead(fd, buffer, (uint32_t)numBytes, offset, readIndex))
+            {
+                // submission queue is full, hand it to the kernel to make room
+                if (!this->ring.Submit(false))
+                {
+                    this->FailRing();
+                    return;
+                }
+
+                // the kernel took nothing, leave the rest queued until completions have been reaped
+                if (!this->ring.PrepareRead(fd, buffer, (uint32_t)numBytes, offset, readIndex))
+                    break;
+            }
+            this->numReadsInFlight++;
+            i++;
+        }
+        if (!this->ring.Submit(false))
+        {
+            this->FailRing();
+            return;
+        }
+
+        if (i == this->queuedReads.Size())
+            this->queuedReads.Clear();
+        else if (i > 0)
+            this->queuedReads.EraseRange(0, i);
+        return;
+    }
+#endif
+
+    n_assert(this->backend == ThreadPool);
+    this->lock.Enter();
+    for (IndexT i = 0; i < this->queuedReads.Size(); i++)
+    {
+        IndexT const readIndex = this->queuedReads[i];
+        PendingRead const& read = this->reads[readIndex];
+
+        // reader threads only ever see copies, since the reads array may grow while they run
+        Work work;
+        work.read = readIndex;
+        work.handle = this->requests[read.request].stream->handle;
+        work.buffer = (char*)read.buffer + read.bytesDone;
+        work.size = read.size - read.bytesDone;
+        work.offset = read.offset + read.bytesDone;
+        this->workQueue.Enqueue(work);
+    }
+    this->lock.Leave();
+    this->numReadsInFlight += this->queuedReads.Size();
+    this->queuedReads.Clear();
+    this->workEvent.Signal();
+}
+
+//------------------------------------------------------------------------------
+/**
+*/
+SizeT
+AsyncIoQueue::Poll()
+{
+    this->Submit();
+    SizeT numFinished = this->ReapCompletions();
+
+    // submit reads that were split or queued by callbacks
+    this->Submit();
+    return numFinished;
+}
+
+//------------------------------------------------------------------------------
+/**
+*/
+void
+AsyncIoQueue::Wait()
+{
+    while (this->numPending > 0)
+    {
+        this->Submit();
+        if (this->ReapCompletions() > 0 || !this->queuedReads.IsEmpty())
+            continue;
+
+        // nothing has finished, block until the backend completes a read
+        if (this->numReadsInFlight > 0)
+        {
+#if __linux__
+            if (this->backend == IoUring)
+            {
+                if (!this->ring.Submit(true))
+                    this->FailRing();
+                continue;
+            }
+#endif
+            this->completionEvent.Wait();
+        }
+    }
+}
+
+//------------------------------------------------------------------------------
+/**
+*/
+SizeT
+AsyncIoQueue::ReapCompletions()
+{
+    SizeT numFinished = 0;
+
+    // callbacks may post new results, so take the current ones first
+    if (!this->finishedRequests.IsEmpty())
+    {
+        Util::Array<IndexT> finished = std::move(this->finishedRequests);
+        for (IndexT i = 0; i < finished.Size(); i++)
+        {
+            this->FinishRequest(finished[i]);
+        }
+        numFinished += finished.Size();
+    }
+
+#if __linux__
+    if (this->backend == IoUring)
+    {
+        uint64_t userData;
+        int32_t res;
+        while (this->ring.PopCompletion(userData, res))
+        {
+            this->numReadsInFlight--;
+            this->CompleteRead((IndexT)userData, res, numFinished);
+        }
+        return numFinished;
+    }
+#endif
+
+    this->lock.Enter();
+    Util::Array<Completion> done = std::move(this->completions);
+    this->lock.Leave();
+    for (IndexT i = 0; i < done.Size(); i++)
+    {
+        this->numReadsInFlight--;
+        this->CompleteRead(done[i].read, done[i].res, numFinished);
+    }
+    return numFinished;
+}
+
+//------------------------------------------------------------------------------
+/**
+*/
+void
+AsyncIoQueue::CompleteRead(IndexT readIndex, Stream::Size res, SizeT& numFinished)
+{
+    PendingRead& read = this->reads[readIndex];
+    Request& request = this->requests[read.request];
+    if (res < 0)
+    {
+        request.success = false;
+    }
+    else
+    {
+        read.bytesDone += res;
+        if (res > 0 && read.bytesDone < read.size)
+        {
+            // short read or a read split into several, queue the rest
+            this->queuedReads.Append(readIndex);
+            return;
+        }
+    }
+
+    IndexT const requestIndex = read.request;
+    request.bytesRead += read.bytesDone;
+    read.request = InvalidIndex;
+    this->freeReads.Append(readIndex);
+    if (--request.numReadsLeft == 0)
+    {
+        this->FinishRequest(requestIndex);
+        numFinished++;
+    }
+}
+
+#if __linux__
+//------------------------------------------------------------------------------
+/**
+    Called when the kernel rejects a submission. The kernel may still write to
+    the buffers of reads it has taken, so they are cancelled, and the ring is
+    only torn down once each of them has posted its completion. Every
+    unfinished read then fails, and its request finishes on the next poll.
+    Later reads go to reader threads.
+*/
+void
+AsyncIoQueue::FailRing()
+{
+    n_assert(this->backend == IoUring);
+    n_warning("AsyncIoQueue: io_uring failed, falling back to reader threads\n");
+
+    // reads the kernel has not taken yet never complete, withdraw them
+    this->numReadsInFlight -= (SizeT)this->ring.DropPrepared();
+
+    if (this->numReadsInFlight > 0)
+    {
+        // reads of unsubmitted or finished entries just fail to cancel
+        for (IndexT readIndex = 0; readIndex < this->reads.Size(); readIndex++)
+        {
+            if (this->reads[readIndex].request == InvalidIndex)
+                continue;
+            if (!this->ring.PrepareCancel(readIndex, CancelUserData))
+                break;
+        }
+        if (!this->ring.Submit(false))
+            this->ring.DropPrepared();
+
+        // their results are dropped, the reads fail below
+        while (this->numReadsInFlight > 0)
+        {
+            uint64_t userData;
+            int32_t res;
+            while (this->ring.PopCompletion(userData, res))
+            {
+                if (userData != CancelUserData)
+                    this->numReadsInFlight--;
+            }
+            if (this->numReadsInFlight > 0 && !this->ring.Submit(true))
+            {
+                // completions still show up in the mapped queue without waiting on the ring
+                Threading::Thread::YieldThread();
+            }
+        }
+    }
+    this->ring.Discard();
+
+    for (IndexT readIndex = 0; readIndex < this->reads.Size(); readIndex++)
+    {
+        PendingRead& read = this->reads[readIndex];
+        if (read.request == InvalidIndex)
+            continue;
+
+        Request& request = this->requests[read.request];
+        request.success = false;
+        request.bytesRead += read.bytesDone;
+        if (--request.numReadsLeft == 0)
+            this->finishedRequests.Append(read.request);
+        read.request = InvalidIndex;
+        this->freeReads.Append(readIndex);
+    }
+    this->queuedReads.Clear();
+    this->numReadsInFlight = 0;
+
+    this->backend = ThreadPool;
+    this->StartThreads();
+}
+#endif
+
+//------------------------------------------------------------------------------
+/**
+*/
+void
+AsyncIoQueue::FinishRequest(IndexT requestIndex)
+{
+    Request& request = this->requests[requestIndex];
+    AsyncReadResult result;
+    result.success = request.success;
+    result.bytesRead = request.bytesRead;
+    AsyncReadCallback callback = std::move(request.callback);
+    request.callback = nullptr;
+    if (request.stream != nullptr)
+        request.stream->numPendingReads--;
+    request.stream = nullptr;
+
+    // release the request before the callback, which may issue new reads
+    this->freeRequests.Append(requestIndex);
+    this->numPending--;
+    if (callback)
+        callback(result);
+}
+
+//------------------------------------------------------------------------------
+/**
+*/
+bool
+AsyncIoQueue::TakeWork(Work& work)
+{
+    this->lock.Enter();
+    bool const found = !this->workQueue.IsEmpty();
+    if (found)
+        work = this->workQueue.Dequeue();
+    bool const moreWork = !this->workQueue.IsEmpty();
+    this->lock.Leave();
+
+    // pass the wakeup on to the next thread
+    if (moreWork)
+        this->workEvent.Signal();
+    return found;
+}
+
+//------------------------------------------------------------------------------
+/**
+*/
+void
+AsyncIoQueue::PushCompletion(IndexT readIndex, Stream::Size res)
+{
+    Completion completion;
+    completion.read = readIndex;
+    completion.res = res;
+
+    this->lock.Enter();
+    this->completions.Append(completion);
+    this->lock.Leave();
+    this->completionEvent.Signal();
+}
+
+//------------------------------------------------------------------------------
+/**
+*/
+void
+AsyncIoQueue::WaitForWork()
+{
+    if (!this->shuttingDown)
+        this->workEvent.Wait();
+
+    // wake up the next thread, so that all threads get to see their stop request
+    if (this->shuttingDown)
+        this->workEvent.Signal();
+}
+
+} // namespace IO
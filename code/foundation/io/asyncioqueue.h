@@ -0,0 +1,224 @@
+#pragma once
+//------------------------------------------------------------------------------
+/**
+    @class IO::AsyncIoQueue
+
+    Issues asynchronous reads of IO::AsyncFileStream objects and delivers their
+    completions.
+
+    On Linux, reads are batched through io_uring, so a single thread can keep
+    many reads in flight with one system call per batch. Where io_uring is not
+    available, reads are served by a small pool of reader threads using
+    positional reads instead.
+
+    Reads are queued by the streams and submitted on the next Submit, Poll or
+    Wait. Should the ring fail, unfinished reads fail and reader threads take over.
+
+    Completion callbacks are always invoked from Poll or Wait, on the thread
+    that owns the queue, so they never need any locking. A queue must only be
+    used from one thread, each IoServer has its own.
+
+    @copyright
+    (C) 2024 Individual contributors, see AUTHORS file
+*/
+#include "core/refcounted.h"
+#include "util/array.h"
+#include "util/queue.h"
+#include "io/stream.h"
+#include "io/fswrapper.h"
+#include "threading/thread.h"
+#include "threading/criticalsection.h"
+#include "threading/event.h"
+#include <functional>
+#if __linux__
+#include "io/posix/linuxiouring.h"
+#endif
+
+//------------------------------------------------------------------------------
+namespace IO
+{
+class AsyncFileStream;
+class AsyncIoQueue;
+
+/// a range of a file to read into a caller owned buffer
+struct AsyncReadRegion
+{
+    Stream::Position offset;
+    void* buffer;
+    Stream::Size size;
+};
+
+/// result of an asynchronous read, passed to the completion callback
+struct AsyncReadResult
+{
+    bool success;
+    /// total number of bytes read into all regions, less than requested if the end of the file was reached
+    Stream::Size bytesRead;
+};
+using AsyncReadCallback = std::function<void(AsyncReadResult const&)>;
+
+//------------------------------------------------------------------------------
+/**
+    Reader thread of the fallback path.
+*/
+class AsyncIoThread : public Threading::Thread
+{
+    __DeclareClass(AsyncIoThread);
+public:
+    /// constructor
+    AsyncIoThread();
+
+private:
+    friend class AsyncIoQueue;
+
+    /// this method runs in the thread context
+    void DoWork() override;
+    /// wake up the thread so it can see its stop request
+    void EmitWakeupSignal() override;
+
+    AsyncIoQueue* queue;
+};
+
+//------------------------------------------------------------------------------
+class AsyncIoQueue : public Core::RefCounted
+{
+    __DeclareClass(AsyncIoQueue);
+public:
+    enum Backend
+    {
+        None,
+        IoUring,
+        ThreadPool
+    };
+
+    /// constructor
+    AsyncIoQueue();
+    /// destructor
+    virtual ~AsyncIoQueue();
+
+    /// setup the queue, tries io_uring first unless forceThreadPool is set
+    void Setup(SizeT queueDepth = 128, SizeT numThreads = 2, bool forceThreadPool = false);
+    /// wait for all reads and discard the queue
+    void Discard();
+    /// get the backend the queue uses
+    Backend GetBackend() const;
+
+    /// submit all queued reads without waiting
+    void Submit();
+    /// submit queued reads and invoke the callbacks of finished requests, returns the number of finished requests
+    SizeT Poll();
+    /// wait until all requests have finished, invoking their callbacks
+    void Wait();
+    /// get the number of requests that have not finished
+    SizeT GetNumPending() const;
+
+    /// finish a request which was served without the queue, the callback is invoked on the next poll
+    void PostResult(const AsyncReadCallback& callback, const AsyncReadResult& result);
+
+private:
+    friend class AsyncFileStream;
+    friend class AsyncIoThread;
+
+    /// queue a request reading one or more regions of a stream
+    void Read(AsyncFileStream* stream, const AsyncReadRegion* regions, SizeT numRegions, const AsyncReadCallback& callback);
+    /// handle the result of a read, res is the number of bytes read or negative on failure
+    void CompleteRead(IndexT readIndex, Stream::Size res, SizeT& numFinished);
+    /// finish a request and invoke its callback
+    void FinishRequest(IndexT requestIndex);
+    /// pick up completions from the backend, returns the number of finished requests
+    SizeT ReapCompletions();
+    /// start the reader threads of the fallback path
+    void StartThreads();
+#if __linux__
+    /// cancel and drain the reads in flight, fail all unfinished reads and fall back to reader threads
+    void FailRing();
+#endif
+
+    struct Work
+    {
+        IndexT read;
+        FSWrapper::Handle handle;
+        void* buffer;
+        Stream::Size size;
+        Stream::Position offset;
+    };
+
+    /// called by reader threads to take a read, returns false if there is none
+    bool TakeWork(Work& work);
+    /// called by reader threads when a read is done
+    void PushCompletion(IndexT readIndex, Stream::Size res);
+    /// called by reader threads to wait for reads
+    void WaitForWork();
+
+    struct Request
+    {
+        AsyncFileStream* stream;
+        AsyncReadCallback callback;
+        SizeT numReadsLeft;
+        Stream::Size bytesRead;
+        bool success;
+    };
+
+    struct PendingRead
+    {
+        /// invalid while the read is free
+        IndexT request;
+        void* buffer;
+        Stream::Size size;
+        Stream::Position offset;
+        Stream::Size bytesDone;
+    };
+
+    struct Completion
+    {
+        IndexT read;
+        Stream::Size res;
+    };
+
+    Backend backend;
+    Util::Array<Request> requests;
+    Util::Array<IndexT> freeRequests;
+    Util::Array<PendingRead> reads;
+    Util::Array<IndexT> freeReads;
+    /// reads waiting to be handed to the backend
+    Util::Array<IndexT> queuedReads;
+    /// requests finished without io
+    Util::Array<IndexT> finishedRequests;
+    SizeT numPending;
+    SizeT numReadsInFlight;
+    SizeT numThreads;
+
+#if __linux__
+    Linux::IoUring ring;
+#endif
+
+    /// fallback path, shared with the reader threads
+    Util::Array<Ptr<AsyncIoThread>> threads;
+    Util::Queue<Work> workQueue;
+    Util::Array<Completion> completions;
+    Threading::CriticalSection lock;
+    Threading::Event workEvent;
+    Threading::Event completionEvent;
+    volatile bool shuttingDown;
+};
+
+//------------------------------------------------------------------------------
+/**
+*/
+inline AsyncIoQueue::Backend
+AsyncIoQueue::GetBackend() const
+{
+    return this->backend;
+}
+
+//------------------------------------------------------------------------------
+/**
+*/
+inline SizeT
+AsyncIoQueue::GetNumPending() const
+{
+    return this->numPending;
+}
+
+} // namespace IO
+//------------------------------------------------------------------------------
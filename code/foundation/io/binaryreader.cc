@@ -44,11 +44,21 @@ BinaryReader::Open()
 {
     if (StreamReader::Open())
     {
-        if (this->enableMapping && this->stream->CanBeMapped())
+        // file streams are mapped directly instead of being read into a buffer
+        this->view = nullptr;
+        if (this->enableMapping && this->stream->CanBeMapped() && this->stream->GetSize() > 0)
+        {
+            this->view = MappedView::Create();
+            if (!this->view->Setup(this->stream))
+            {
+                this->view = nullptr;
+            }
+        }
+        if (this->view.isvalid())
         {
             this->isMapped = true;
-            this->mapCursor = (unsigned char*) this->stream->Map();
-            this->mapEnd = this->mapCursor + this->stream->GetSize();
+            this->mapCursor = (unsigned char*)this->view->GetPointer();
+            this->mapEnd = this->mapCursor + this->view->GetSize();
         }
         else
         {
@@ -67,6 +77,19 @@ BinaryReader::Open()
 void
 BinaryReader::Close()
 {
+    if (this->view.isvalid())
+    {
+        if (this->view->GetRefCount() == 1)
+        {
+            this->view->Discard();
+        }
+        else if (this->view->GetStream().isvalid())
+        {
+            // someone still points into a view which needs the stream, it closes the stream when released
+            this->streamWasOpen = true;
+        }
+        this->view = nullptr;
+    }
     StreamReader::Close();
     this->isMapped = false;
     this->mapCursor = 0;
@@ -597,6 +620,22 @@ BinaryReader::ReadBoolArray()
     return val;
 }
 
+//------------------------------------------------------------------------------
+/**
+    Returns a pointer into the mapped view and advances the read cursor.
+    The pointer stays valid as long as a reference to the view is held,
+    see GetMappedView().
+*/
+const void*
+BinaryReader::ReadView(SizeT numBytes)
+{
+    n_assert(this->isMapped);
+    n_assert((this->mapCursor + numBytes) <= this->mapEnd);
+    const void* ptr = this->mapCursor;
+    this->mapCursor += numBytes;
+    return ptr;
+}
+
 //------------------------------------------------------------------------------
 /**
 */ 
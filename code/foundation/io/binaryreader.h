@@ -14,6 +14,7 @@
     (C) 2013-2020 Individual contributors, see AUTHORS file
 */
 #include "io/streamreader.h"
+#include "io/mappedview.h"
 #if !__OSX__
 #include "math/vec2.h"
 #include "math/vec4.h"
@@ -99,11 +100,16 @@ public:
     Util::Blob ReadBlob();
     /// read raw data
     void ReadRawData(void* ptr, SizeT numBytes);
+    /// get a pointer to raw data in the mapped view and skip it, no copy (memory mapping only)
+    const void* ReadView(SizeT numBytes);
+    /// get the mapped view, keep a reference to use pointers into it after Close() (memory mapping only)
+    const Ptr<MappedView>& GetMappedView() const;
 
 public:
     System::ByteOrder byteOrder;
     unsigned char* mapCursor;
     unsigned char* mapEnd;
+    Ptr<MappedView> view;
     bool enableMapping;
     bool isMapped;
 };
@@ -126,6 +132,15 @@ BinaryReader::IsMemoryMappingEnabled() const
     return this->enableMapping;
 }
 
+//------------------------------------------------------------------------------
+/**
+*/
+inline const Ptr<MappedView>&
+BinaryReader::GetMappedView() const
+{
+    return this->view;
+}
+
 //------------------------------------------------------------------------------
 /**
 */
@@ -29,7 +29,6 @@ CachedStream::~CachedStream()
     {
         this->Close();
     }
-    this->parentStream = nullptr;
 }
 
 //------------------------------------------------------------------------------
@@ -65,8 +64,7 @@ CachedStream::CanBeMapped() const
 Stream::Size
 CachedStream::GetSize() const
 {
-    n_assert(this->parentStream.isvalid());
-    return this->parentStream->GetSize();
+    return this->size;
 }
 
 //------------------------------------------------------------------------------
@@ -80,7 +78,8 @@ CachedStream::GetPosition() const
 
 //------------------------------------------------------------------------------
 /**
-  
+    Pins the content in the stream cache, the parent stream is only opened
+    if the content isn't cached yet.
 */
 bool
 CachedStream::Open()
@@ -88,29 +87,23 @@ CachedStream::Open()
     n_assert(!this->IsOpen());
     n_assert(this->accessMode == ReadAccess);
 
-    if (Stream::Open())
+    void* data = nullptr;
+    if (StreamCache::Instance()->Acquire(this->uri, this->GetParentRtti(), data, this->size))
     {
-        if(!StreamCache::Instance()->IsCached(this->uri))
+        if (Stream::Open())
         {
-            if (!StreamCache::Instance()->OpenStream(this->uri, this->GetParentRtti()))
-            {
-                return false;
-            }
+            this->position = 0;
+            this->buffer = (unsigned char*)data;
+            return true;
         }
-
-        Util::KeyValuePair<void*, Ptr<IO::Stream>> entry = StreamCache::Instance()->GetCachedStream(this->uri);
-        this->parentStream = entry.Value();
-        n_assert(this->parentStream.isvalid());
-        this->position = 0;
-        this->buffer = (unsigned char*)entry.Key();
-        this->size = this->parentStream->GetSize();
-        return true;
+        StreamCache::Instance()->Release(this->uri);
     }
     return false;
 }
 
+//------------------------------------------------------------------------------
 /**
-  
+    Unpins the content, it stays cached until evicted.
 */
 void
 CachedStream::Close()
@@ -120,10 +113,9 @@ CachedStream::Close()
         this->Unmap();
     }
     Stream::Close();
-    if (StreamCache::Instance()->IsCached(this->uri))
-    {
-        StreamCache::Instance()->RemoveStream(this->uri);
-    }
+    StreamCache::Instance()->Release(this->uri);
+    this->buffer = nullptr;
+    this->size = 0;
 }
 
 //------------------------------------------------------------------------------
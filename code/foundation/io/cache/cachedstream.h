@@ -3,8 +3,9 @@
 /**
     @class IO::CachedStream
   
-    Wraps an underlying mappable stream object to avoid reopening it more than 
-    once (e. g. httpstreams)
+    Wraps an underlying stream object to avoid reopening it more than 
+    once (e. g. httpstreams). The content is owned by the StreamCache and
+    pinned while the stream is open.
     
     @copyright
     (C) 2020 Individual contributors, see AUTHORS file
@@ -56,11 +57,9 @@ public:
 protected:
     friend class IO::StreamCache;
 
+    /// class of the underlying stream, used by the cache to read the content
     virtual Core::Rtti const& GetParentRtti() = 0;
 
-    // underlying object
-    Ptr<IO::Stream> parentStream;
-
     Size size;
     Position position;
     unsigned char* buffer;
@@ -4,6 +4,11 @@
 //------------------------------------------------------------------------------
 
 #include "io/cache/streamcache.h"
+#include "io/ioserver.h"
+#include "io/assignregistry.h"
+#include "io/fswrapper.h"
+#include "io/archfs/archivefilesystem.h"
+#include <string.h>
 
 namespace IO
 {
@@ -12,10 +17,90 @@ __ImplementSingleton(IO::StreamCache);
 
 using namespace Util;
 
+static const Stream::Size DefaultBudget = 64 * 1024 * 1024;
+
+// disk cache files start with this header, followed by the uri and the content
+static const uint32_t DiskCacheMagic = 'NSCB';
+static const uint32_t DiskCacheVersion = 2;
+struct DiskCacheHeader
+{
+    uint32_t magic;
+    uint32_t version;
+    uint32_t uriLength;
+    uint32_t pad;
+    uint64_t size;
+    uint64_t hash;
+    /// write time and size of the source when the content was read from it
+    uint64_t sourceTime;
+    uint64_t sourceSize;
+};
+
 //------------------------------------------------------------------------------
 /**
+    64 bit FNV-1a, used for both content and disk cache file names.
 */
-StreamCache::StreamCache()
+static uint64_t
+Fnv1a(const void* data, size_t size)
+{
+    const unsigned char* ptr = (const unsigned char*)data;
+    uint64_t hash = 0xcbf29ce484222325ull;
+    for (size_t i = 0; i < size; i++)
+    {
+        hash ^= ptr[i];
+        hash *= 0x100000001b3ull;
+    }
+    return hash;
+}
+
+//------------------------------------------------------------------------------
+/**
+    Gets the write time and size of the file behind an uri, or of the archive
+    containing it. Returns false if the source doesn't exist. Sources which
+    aren't files can't be checked without opening them, their stamp is zero.
+*/
+static bool
+GetSourceStamp(IO::URI const& uri, uint64_t& outTime, uint64_t& outSize)
+{
+    outTime = 0;
+    outSize = 0;
+    if (uri.Scheme() != "file")
+    {
+        return true;
+    }
+
+    String path = uri.GetHostAndLocalPath();
+    if (!FSWrapper::FileExists(path))
+    {
+        Ptr<ArchiveBase> archive;
+        if (IoServer::Instance()->IsArchiveFileSystemEnabled())
+        {
+            archive = ArchiveFileSystem::Instance()->FindArchiveWithFile(uri);
+        }
+        if (!archive.isvalid())
+        {
+            return false;
+        }
+        path = archive->GetURI().GetHostAndLocalPath();
+    }
+
+    FileTime const time = FSWrapper::GetFileWriteTime(path);
+    outTime = ((uint64_t)time.GetHighBits() << 32) | time.GetLowBits();
+    FSWrapper::Handle handle = FSWrapper::OpenFile(path, Stream::ReadAccess, Stream::Random);
+    if (0 == handle)
+    {
+        return false;
+    }
+    outSize = (uint64_t)FSWrapper::GetFileSize(handle);
+    FSWrapper::CloseFile(handle);
+    return true;
+}
+
+//------------------------------------------------------------------------------
+/**
+*/
+StreamCache::StreamCache() :
+    budget(DefaultBudget),
+    useCounter(0)
 {
     __ConstructSingleton;
 }
@@ -32,65 +117,386 @@ StreamCache::~StreamCache()
 //------------------------------------------------------------------------------
 /**
 */
-bool 
-StreamCache::IsCached(IO::URI const & uri) const
+void
+StreamCache::SetBudget(Stream::Size numBytes)
 {
-    return this->streams.Contains(uri.AsString());
+    this->budget = numBytes;
+    this->Evict(this->budget);
 }
 
 //------------------------------------------------------------------------------
 /**
 */
-Util::KeyValuePair<void*, Ptr<IO::Stream>>
-StreamCache::GetCachedStream(IO::URI const & uri)
+void
+StreamCache::SetDiskCacheDirectory(const URI& dir)
 {
-    n_assert(this->IsCached(uri));
-    CacheEntry& entry = this->streams[uri.AsString()];
-    ++entry.useCount;
-    return Util::KeyValuePair(entry.buffer, entry.stream);
+    if (dir.IsEmpty())
+    {
+        this->diskCacheDir.Clear();
+        return;
+    }
+    this->diskCacheDir = AssignRegistry::Instance()->ResolveAssigns(dir);
+    if (!IoServer::Instance()->DirectoryExists(this->diskCacheDir))
+    {
+        IoServer::Instance()->CreateDirectory(this->diskCacheDir);
+    }
 }
 
 //------------------------------------------------------------------------------
 /**
 */
+void
+StreamCache::ClearDiskCache()
+{
+    if (this->diskCacheDir.IsEmpty())
+    {
+        return;
+    }
+    Array<String> files = IoServer::Instance()->ListFiles(this->diskCacheDir, "*.blob");
+    IndexT i;
+    for (i = 0; i < files.Size(); i++)
+    {
+        URI file = this->diskCacheDir;
+        file.AppendLocalPath(files[i]);
+        IoServer::Instance()->DeleteFile(file);
+    }
+}
+
+//------------------------------------------------------------------------------
+/**
+*/
+bool
+StreamCache::IsCached(IO::URI const& uri) const
+{
+    return this->uris.Contains(uri.AsString());
+}
+
+//------------------------------------------------------------------------------
+/**
+    Returns the content of an uri and pins it until Release() is called. On
+    a miss the content is read from the disk cache or through a stream of
+    the given class. If identical content is already cached under another
+    uri, the new copy is dropped and both uris share the blob.
+*/
 bool
-StreamCache::OpenStream(IO::URI const& uri, Core::Rtti const& rtti)
+StreamCache::Acquire(IO::URI const& uri, Core::Rtti const& rtti, void*& outBuffer, Stream::Size& outSize)
 {
     String uriString = uri.AsString();
-    n_assert(!this->streams.Contains(uriString));
+    IndexT blobIndex = this->uris.FindIndex(uriString);
+    if (blobIndex != InvalidIndex)
+    {
+        Blob& blob = this->blobs[this->uris.ValueAtIndex(blobIndex)];
+        blob.pinCount++;
+        blob.lastUse = ++this->useCounter;
+        this->stats.hits++;
+        outBuffer = blob.buffer;
+        outSize = blob.size;
+        return true;
+    }
 
-    Ptr<IO::Stream> stream = (Stream*) rtti.Create();
+    this->stats.misses++;
+    void* buffer = nullptr;
+    Stream::Size size = 0;
+    SourceStamp stamp;
+    bool const hasStamp = !this->diskCacheDir.IsEmpty() && GetSourceStamp(uri, stamp.time, stamp.size);
+    if (hasStamp && this->ReadDiskCache(uri, stamp, buffer, size))
+    {
+        this->stats.diskHits++;
+    }
+    else if (this->ReadStream(uri, rtti, buffer, size))
+    {
+        // the stamp is taken before reading, so a source changing meanwhile is read again next time
+        if (hasStamp)
+        {
+            this->WriteDiskCache(uri, stamp, buffer, size);
+        }
+    }
+    else
+    {
+        return false;
+    }
+
+    uint64_t const hash = Fnv1a(buffer, (size_t)size);
+    IndexT const hashIndex = this->hashes.FindIndex(hash);
+    if (hashIndex != InvalidIndex)
+    {
+        IndexT const existing = this->hashes.ValueAtIndex(hashIndex);
+        Blob const& blob = this->blobs[existing];
+        if (blob.size == size && (size == 0 || memcmp(blob.buffer, buffer, (size_t)size) == 0))
+        {
+            if (buffer != nullptr)
+            {
+                Memory::Free(Memory::StreamDataHeap, buffer);
+            }
+            this->stats.dedups++;
+            blobIndex = existing;
+        }
+    }
+
+    if (blobIndex == InvalidIndex)
+    {
+        if (!this->freeBlobs.IsEmpty())
+        {
+            blobIndex = this->freeBlobs.Back();
+            this->freeBlobs.EraseBack();
+        }
+        else
+        {
+            blobIndex = this->blobs.Size();
+            this->blobs.Append(Blob());
+        }
+        Blob& blob = this->blobs[blobIndex];
+        blob.buffer = buffer;
+        blob.size = size;
+        blob.hash = hash;
+
+        // on a hash collision with different content the first blob keeps the hash
+        if (hashIndex == InvalidIndex)
+        {
+            this->hashes.Add(hash, blobIndex);
+        }
+        this->stats.numBlobs++;
+        this->stats.numBytes += size;
+    }
 
+    Blob& blob = this->blobs[blobIndex];
+    blob.uris.Append(uriString);
+    blob.pinCount++;
+    blob.lastUse = ++this->useCounter;
+    this->uris.Add(uriString, blobIndex);
+    outBuffer = blob.buffer;
+    outSize = blob.size;
+
+    this->Evict(this->budget);
+    return true;
+}
+
+//------------------------------------------------------------------------------
+/**
+*/
+void
+StreamCache::Release(IO::URI const& uri)
+{
+    IndexT const index = this->uris.FindIndex(uri.AsString());
+    n_assert(index != InvalidIndex);
+    Blob& blob = this->blobs[this->uris.ValueAtIndex(index)];
+    n_assert(blob.pinCount > 0);
+    blob.pinCount--;
+    blob.lastUse = ++this->useCounter;
+    if (blob.pinCount == 0 && this->stats.numBytes > this->budget)
+    {
+        this->Evict(this->budget);
+    }
+}
+
+//------------------------------------------------------------------------------
+/**
+*/
+void
+StreamCache::Purge()
+{
+    this->Evict(0);
+}
+
+//------------------------------------------------------------------------------
+/**
+    Frees the unpinned blob with the oldest use until the cache fits into
+    the budget. The cache holds few, large blobs, so a linear search for
+    the oldest one is cheaper than maintaining a list.
+*/
+void
+StreamCache::Evict(Stream::Size maxBytes)
+{
+    while (this->stats.numBytes > maxBytes || (maxBytes == 0 && this->stats.numBlobs > 0))
+    {
+        IndexT oldest = InvalidIndex;
+        IndexT i;
+        for (i = 0; i < this->blobs.Size(); i++)
+        {
+            Blob const& blob = this->blobs[i];
+            if (!blob.uris.IsEmpty() && blob.pinCount == 0
+                && (oldest == InvalidIndex || blob.lastUse < this->blobs[oldest].lastUse))
+            {
+                oldest = i;
+            }
+        }
+        if (oldest == InvalidIndex)
+        {
+            // everything left is pinned
+            break;
+        }
+        this->FreeBlob(oldest);
+        this->stats.evictions++;
+    }
+}
+
+//------------------------------------------------------------------------------
+/**
+*/
+void
+StreamCache::FreeBlob(IndexT blobIndex)
+{
+    Blob& blob = this->blobs[blobIndex];
+    IndexT i;
+    for (i = 0; i < blob.uris.Size(); i++)
+    {
+        this->uris.Erase(blob.uris[i]);
+    }
+    IndexT const hashIndex = this->hashes.FindIndex(blob.hash);
+    if (hashIndex != InvalidIndex && this->hashes.ValueAtIndex(hashIndex) == blobIndex)
+    {
+        this->hashes.EraseAtIndex(hashIndex);
+    }
+    if (blob.buffer != nullptr)
+    {
+        Memory::Free(Memory::StreamDataHeap, blob.buffer);
+    }
+    this->stats.numBlobs--;
+    this->stats.numBytes -= blob.size;
+    blob = Blob();
+    this->freeBlobs.Append(blobIndex);
+}
+
+//------------------------------------------------------------------------------
+/**
+    Copies the content of the stream, the source stream is closed again
+    right away.
+*/
+bool
+StreamCache::ReadStream(IO::URI const& uri, Core::Rtti const& rtti, void*& outBuffer, Stream::Size& outSize)
+{
+    Ptr<IO::Stream> stream = (Stream*) rtti.Create();
     stream->SetURI(uri);
     stream->SetAccessMode(Stream::ReadAccess);
-    if (stream->Open())
+    if (!stream->Open())
     {
-        CacheEntry & entry = this->streams.Emplace(uriString);
-        entry.stream = stream;
-        entry.useCount = 0;
-        entry.buffer = stream->Map();
-        return true;
+        return false;
+    }
+
+    outBuffer = nullptr;
+    outSize = stream->GetSize();
+    bool success = true;
+    if (outSize > 0)
+    {
+        outBuffer = Memory::Alloc(Memory::StreamDataHeap, outSize);
+        if (stream->Read(outBuffer, outSize) != outSize)
+        {
+            n_warning("StreamCache: failed to read '%s'!\n", uri.AsString().AsCharPtr());
+            Memory::Free(Memory::StreamDataHeap, outBuffer);
+            outBuffer = nullptr;
+            success = false;
+        }
+    }
+    stream->Close();
+    return success;
+}
+
+//------------------------------------------------------------------------------
+/**
+*/
+URI
+StreamCache::GetDiskCachePath(IO::URI const& uri) const
+{
+    String const uriString = uri.AsString();
+    uint64_t const hash = Fnv1a(uriString.AsCharPtr(), uriString.Length());
+    URI path = this->diskCacheDir;
+    path.AppendLocalPath(String::Sprintf("%08x%08x.blob", (uint32_t)(hash >> 32), (uint32_t)hash));
+    return path;
+}
+
+//------------------------------------------------------------------------------
+/**
+    The uri is stored in the file as well, a file written for a different
+    uri with the same name hash is treated as a miss. So is a file written
+    from a source with a different write time or size, it is overwritten
+    once the source has been read again.
+*/
+bool
+StreamCache::ReadDiskCache(IO::URI const& uri, SourceStamp const& stamp, void*& outBuffer, Stream::Size& outSize)
+{
+    if (this->diskCacheDir.IsEmpty())
+    {
+        return false;
+    }
+    URI const path = this->GetDiskCachePath(uri);
+    if (!IoServer::Instance()->FileExists(path))
+    {
+        return false;
+    }
+    Ptr<Stream> stream = IoServer::Instance()->CreateStream(path);
+    stream->SetAccessMode(Stream::ReadAccess);
+    if (!stream->Open())
+    {
+        return false;
+    }
+
+    bool success = false;
+    String const uriString = uri.AsString();
+    DiskCacheHeader header;
+    if (stream->Read(&header, sizeof(header)) == sizeof(header)
+        && header.magic == DiskCacheMagic
+        && header.version == DiskCacheVersion
+        && header.uriLength == (uint32_t)uriString.Length()
+        && header.sourceTime == stamp.time
+        && header.sourceSize == stamp.size
+        && stream->GetSize() == (Stream::Size)(sizeof(header) + header.uriLength + header.size))
+    {
+        Array<char> uriChars(header.uriLength + 1, 0, 0);
+        stream->Read(uriChars.Begin(), header.uriLength);
+        if (uriString == uriChars.Begin())
+        {
+            outSize = (Stream::Size)header.size;
+            outBuffer = nullptr;
+            success = true;
+            if (outSize > 0)
+            {
+                outBuffer = Memory::Alloc(Memory::StreamDataHeap, outSize);
+                if (stream->Read(outBuffer, outSize) != outSize || Fnv1a(outBuffer, (size_t)outSize) != header.hash)
+                {
+                    n_warning("StreamCache: corrupt disk cache file '%s'!\n", path.LocalPath().AsCharPtr());
+                    Memory::Free(Memory::StreamDataHeap, outBuffer);
+                    outBuffer = nullptr;
+                    success = false;
+                }
+            }
+        }
     }
-    return false;
+    stream->Close();
+    return success;
 }
 
 //------------------------------------------------------------------------------
 /**
 */
-void 
-StreamCache::RemoveStream(IO::URI const & uri)
+void
+StreamCache::WriteDiskCache(IO::URI const& uri, SourceStamp const& stamp, const void* buffer, Stream::Size size)
 {
-    Util::String uriString = uri.AsString();
-    n_assert(this->streams.Contains(uriString));
-    CacheEntry& entry = this->streams[uriString];
-    --entry.useCount;
-    if (entry.useCount == 0)
+    String const uriString = uri.AsString();
+    DiskCacheHeader header;
+    Memory::Clear(&header, sizeof(header));
+    header.magic = DiskCacheMagic;
+    header.version = DiskCacheVersion;
+    header.uriLength = (uint32_t)uriString.Length();
+    header.size = (uint64_t)size;
+    header.hash = Fnv1a(buffer, (size_t)size);
+    header.sourceTime = stamp.time;
+    header.sourceSize = stamp.size;
+
+    URI const path = this->GetDiskCachePath(uri);
+    Ptr<Stream> stream = IoServer::Instance()->CreateStream(path);
+    stream->SetAccessMode(Stream::WriteAccess);
+    if (!stream->Open())
+    {
+        n_warning("StreamCache: failed to write disk cache file '%s'!\n", path.LocalPath().AsCharPtr());
+        return;
+    }
+    stream->Write(&header, sizeof(header));
+    stream->Write(uriString.AsCharPtr(), header.uriLength);
+    if (size > 0)
     {
-        entry.stream->Unmap();
-        entry.stream->Close();
-        entry.stream = nullptr;
-        this->streams.Erase(uriString);
+        stream->Write(buffer, size);
     }
+    stream->Close();
 }
 
 //------------------------------------------------------------------------------
@@ -99,14 +505,20 @@ StreamCache::RemoveStream(IO::URI const & uri)
 void
 StreamCache::Discard()
 {
-    // release all streams
-    for (CacheEntry& entry : this->streams.ValuesAsArray())
+    IndexT i;
+    for (i = 0; i < this->blobs.Size(); i++)
     {
-        entry.stream->Unmap();
-        entry.stream->Close();
-        entry.stream = nullptr;
+        if (this->blobs[i].buffer != nullptr)
+        {
+            Memory::Free(Memory::StreamDataHeap, this->blobs[i].buffer);
+        }
     }
-    this->streams.Clear();
+    this->blobs.Clear();
+    this->freeBlobs.Clear();
+    this->uris.Clear();
+    this->hashes.Clear();
+    this->stats.numBlobs = 0;
+    this->stats.numBytes = 0;
 }
 
 } // namespace IO
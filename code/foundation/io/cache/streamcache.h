@@ -2,10 +2,29 @@
 //------------------------------------------------------------------------------
 /**
     @class IO::StreamCache
-    
+
     Explicit cache for reusing read-only streams that are already opened.
     Main use-case are expensive to open streams like http objects/zips
-    
+
+    The cache keeps the content of streams, not the streams themselves. A
+    stream is read once, its content is hashed, and identical content reached
+    through different URIs is only held once.
+
+    Blobs are pinned while a CachedStream has them open. Unpinned blobs stay
+    in memory until the total size of all blobs exceeds the budget, then the
+    least recently used unpinned blobs are evicted. Pinned blobs are never
+    evicted, so the budget may be exceeded while many streams are open.
+
+    Optionally, blobs can also be written to a directory on disk, which is
+    checked before the source stream is opened, so content fetched or
+    decompressed once doesn't need to be fetched again on the next launch.
+    The disk cache is keyed by URI, and for file sources also checked against
+    the write time and size of the file, or of the archive containing it.
+    Other sources can't be checked without opening them, it is up to the
+    application to clear the disk cache when those change.
+
+    Like the IoServer, each thread has its own stream cache.
+
     @copyright
     (C) 2020 Individual contributors, see AUTHORS file
 */
@@ -29,27 +48,115 @@ public:
     /// destructor
     virtual ~StreamCache();
 
-    ///
+    struct Stats
+    {
+        /// opens served from memory
+        SizeT hits = 0;
+        /// opens which had to read the stream or disk cache
+        SizeT misses = 0;
+        /// misses served from the disk cache
+        SizeT diskHits = 0;
+        /// misses whose content was already cached under another uri
+        SizeT dedups = 0;
+        /// blobs evicted to stay within the budget
+        SizeT evictions = 0;
+        /// number of blobs and their total size
+        SizeT numBlobs = 0;
+        Stream::Size numBytes = 0;
+    };
+
+    /// set the memory budget in bytes, evicts immediately if exceeded
+    void SetBudget(Stream::Size numBytes);
+    /// get the memory budget in bytes
+    Stream::Size GetBudget() const;
+    /// set the directory of the disk cache, an empty uri disables it
+    void SetDiskCacheDirectory(const URI& dir);
+    /// get the directory of the disk cache
+    const URI& GetDiskCacheDirectory() const;
+    /// delete all files of the disk cache
+    void ClearDiskCache();
+    /// get the counters
+    const Stats& GetStats() const;
+
+    /// return true if the content of an uri is in memory
     bool IsCached(IO::URI const& uri) const;
-    /// 
-    Util::KeyValuePair<void*,Ptr<IO::Stream>> GetCachedStream(IO::URI const& uri);
-    ///
-    bool OpenStream(IO::URI const& uri, Core::Rtti const& rtti);
-    ///
-    void RemoveStream(IO::URI const& uri);
+    /// pin the content of an uri, reading it through a stream of the given class if not cached
+    bool Acquire(IO::URI const& uri, Core::Rtti const& rtti, void*& outBuffer, Stream::Size& outSize);
+    /// unpin content acquired before
+    void Release(IO::URI const& uri);
+    /// evict all unpinned blobs
+    void Purge();
 
 private:
-    /// discard 
+    /// discard
     void Discard();
-    struct CacheEntry
+    /// read the content of a stream into a new buffer
+    bool ReadStream(IO::URI const& uri, Core::Rtti const& rtti, void*& outBuffer, Stream::Size& outSize);
+    struct SourceStamp
     {
-        Ptr<IO::Stream> stream;
-        void * buffer = nullptr;
-        SizeT useCount = 0;
+        uint64_t time = 0;
+        uint64_t size = 0;
     };
 
-    Util::Dictionary<Util::String, CacheEntry> streams;
+    /// read content from the disk cache into a new buffer, if it was written from a source with the same stamp
+    bool ReadDiskCache(IO::URI const& uri, SourceStamp const& stamp, void*& outBuffer, Stream::Size& outSize);
+    /// write content to the disk cache
+    void WriteDiskCache(IO::URI const& uri, SourceStamp const& stamp, const void* buffer, Stream::Size size);
+    /// get the disk cache file of an uri
+    URI GetDiskCachePath(IO::URI const& uri) const;
+    /// evict least recently used unpinned blobs until the budget is met
+    void Evict(Stream::Size budget);
+    /// free a blob and forget all uris pointing to it
+    void FreeBlob(IndexT blobIndex);
+
+    struct Blob
+    {
+        void* buffer = nullptr;
+        Stream::Size size = 0;
+        uint64_t hash = 0;
+        SizeT pinCount = 0;
+        uint64_t lastUse = 0;
+        Util::Array<Util::String> uris;
+    };
+
+    Util::Array<Blob> blobs;
+    Util::Array<IndexT> freeBlobs;
+    /// uri to blob index
+    Util::Dictionary<Util::String, IndexT> uris;
+    /// content hash to blob index
+    Util::Dictionary<uint64_t, IndexT> hashes;
+    Stream::Size budget;
+    uint64_t useCounter;
+    URI diskCacheDir;
+    Stats stats;
 };
 
+//------------------------------------------------------------------------------
+/**
+*/
+inline Stream::Size
+StreamCache::GetBudget() const
+{
+    return this->budget;
+}
+
+//------------------------------------------------------------------------------
+/**
+*/
+inline const URI&
+StreamCache::GetDiskCacheDirectory() const
+{
+    return this->diskCacheDir;
+}
+
+//------------------------------------------------------------------------------
+/**
+*/
+inline const StreamCache::Stats&
+StreamCache::GetStats() const
+{
+    return this->stats;
+}
+
 } // namespace IO
 //------------------------------------------------------------------------------
@@ -257,4 +257,20 @@ FileStream::MemoryUnmap()
     Stream::Unmap();
 }
 
+//------------------------------------------------------------------------------
+/**
+    The mapping stays valid after the file is closed, so whoever keeps the
+    content doesn't need to keep a file handle open as well.
+*/
+FSWrapper::Handle
+FileStream::DetachMemoryMap()
+{
+    n_assert(0 != this->mappedContent);
+    FSWrapper::Handle detached = this->mapHandle;
+    this->mapHandle = nullptr;
+    this->mappedContent = nullptr;
+    Stream::Unmap();
+    return detached;
+}
+
 } // namespace IO
@@ -57,6 +57,8 @@ public:
     virtual void* MemoryMap() override;
     /// unmap memory stream 
     virtual void MemoryUnmap() override;
+    /// hand a memory mapping over to the caller, which unmaps it with FSWrapper::Unmap, the stream can be closed afterwards
+    FSWrapper::Handle DetachMemoryMap();
 
 protected:
     FSWrapper::Handle handle;
@@ -15,6 +15,7 @@
 #include "io/archfs/archivefilesystem.h"
 #include "io/filewatcher.h"
 #include "io/filestream.h"
+#include "io/asyncfilestream.h"
 #include <filesystem>
 #include "http/httpclientregistry.h"
 
@@ -82,7 +83,6 @@ IoServer::IoServer() :
     this->archiveCriticalSection.Leave();
 
     this->watcherCriticalSection.Enter();
-    #ifndef __linux__
     if (!FileWatcher::HasInstance())
     {
         this->watcher = FileWatcher::Create();
@@ -92,7 +92,6 @@ IoServer::IoServer() :
     {
         this->watcher = FileWatcher::Instance();
     }
-    #endif
     this->watcherCriticalSection.Leave();
 
     this->httpClientRegistry = Http::HttpClientRegistry::Create();
@@ -105,6 +104,11 @@ IoServer::IoServer() :
 */
 IoServer::~IoServer()
 {
+    if (this->asyncIoQueue.isvalid())
+    {
+        this->asyncIoQueue->Discard();
+        this->asyncIoQueue = nullptr;
+    }
     this->streamCache = nullptr;
     this->httpClientRegistry->Discard();
     this->httpClientRegistry = nullptr;
@@ -167,7 +171,7 @@ IoServer::CreateStream(const URI& uri) const
 bool
 IoServer::MountArchive(const URI& uri)
 {
-    Ptr<Archive> archive = this->archiveFileSystem->Mount(uri);
+    Ptr<ArchiveBase> archive = this->archiveFileSystem->Mount(uri);
     return archive.isvalid();
 }
 
@@ -177,7 +181,7 @@ IoServer::MountArchive(const URI& uri)
 bool
 IoServer::MountEmbeddedArchive(const URI& uri)
 {
-    Ptr<Archive> archive = this->archiveFileSystem->MountEmbedded(uri, "root:");
+    Ptr<ArchiveBase> archive = this->archiveFileSystem->MountEmbedded(uri, "root:");
     return archive.isvalid();
 }
 
@@ -429,7 +433,7 @@ IoServer::FileExists(const URI& uri) const
     // transparent archive support
     if (this->IsArchiveFileSystemEnabled())
     {
-        Ptr<Archive> archive = ArchiveFileSystem::Instance()->FindArchiveWithFile(uri);
+        Ptr<ArchiveBase> archive = ArchiveFileSystem::Instance()->FindArchiveWithFile(uri);
         if (archive.isvalid())
         {
             return true;
@@ -453,7 +457,7 @@ IoServer::DirectoryExists(const URI& uri) const
     {
         if (uri.Scheme() == "file")
         {
-            Ptr<Archive> archive = ArchiveFileSystem::Instance()->FindArchiveWithDir(uri);
+            Ptr<ArchiveBase> archive = ArchiveFileSystem::Instance()->FindArchiveWithDir(uri);
             if (archive.isvalid())
             {
                 return true;
@@ -560,7 +564,7 @@ IoServer::ListFiles(const URI& uri, const String& pattern, bool asFullPath) cons
     // transparent archive file system support
     if (this->IsArchiveFileSystemEnabled())
     {
-        Ptr<Archive> archive = ArchiveFileSystem::Instance()->FindArchiveWithDir(uri);
+        Ptr<ArchiveBase> archive = ArchiveFileSystem::Instance()->FindArchiveWithDir(uri);
         if (archive.isvalid())
         {
             String pathInArchive = archive->ConvertToPathInArchive(uri.LocalPath());
@@ -598,7 +602,7 @@ IoServer::ListDirectories(const URI& uri, const String& pattern, bool asFullPath
     // transparent archive file system support
     if (this->IsArchiveFileSystemEnabled() && prioritizeArchive)
     {
-        Ptr<Archive> archive = ArchiveFileSystem::Instance()->FindArchiveWithDir(uri);
+        Ptr<ArchiveBase> archive = ArchiveFileSystem::Instance()->FindArchiveWithDir(uri);
         if (archive.isvalid())
         {
             String pathInArchive = archive->ConvertToPathInArchive(uri.LocalPath());
@@ -730,4 +734,103 @@ IoServer::IterateFolders(const URI& dir, const Util::String& pattern, FileMapFun
 
 }
 
+//------------------------------------------------------------------------------
+/**
+    Each io server has its own queue, so reads issued from different threads
+    never share a queue.
+*/
+const Ptr<AsyncIoQueue>&
+IoServer::GetAsyncIoQueue()
+{
+    if (!this->asyncIoQueue.isvalid())
+    {
+        this->asyncIoQueue = AsyncIoQueue::Create();
+        this->asyncIoQueue->Setup();
+    }
+    return this->asyncIoQueue;
+}
+
+//------------------------------------------------------------------------------
+/**
+*/
+void
+IoServer::ReadAsync(const URI& uri, Stream::Position offset, void* buffer, Stream::Size numBytes, const AsyncReadCallback& callback)
+{
+    AsyncReadRegion region;
+    region.offset = offset;
+    region.buffer = buffer;
+    region.size = numBytes;
+    this->ReadAsync(uri, &region, 1, callback);
+}
+
+//------------------------------------------------------------------------------
+/**
+    Only plain files on disk are read asynchronously. Files in archives and
+    other schemes are read immediately through a regular stream, and their
+    callback is invoked on the next poll like any other.
+*/
+void
+IoServer::ReadAsync(const URI& uri, const AsyncReadRegion* regions, SizeT numRegions, const AsyncReadCallback& callback)
+{
+    n_assert(numRegions > 0);
+    const Ptr<AsyncIoQueue>& queue = this->GetAsyncIoQueue();
+
+    if (uri.Scheme() == "file" && FSWrapper::FileExists(uri.GetHostAndLocalPath()))
+    {
+        Ptr<AsyncFileStream> stream = AsyncFileStream::Create();
+        stream->SetURI(uri);
+        stream->SetQueue(queue);
+        if (stream->Open())
+        {
+            // the callback keeps the stream open until the read has finished
+            stream->ReadAsync(regions, numRegions, [stream, callback](AsyncReadResult const& result)
+            {
+                if (callback)
+                    callback(result);
+            });
+            return;
+        }
+    }
+
+    AsyncReadResult result;
+    result.success = false;
+    result.bytesRead = 0;
+    Ptr<Stream> stream = this->CreateStream(uri);
+    stream->SetAccessMode(Stream::ReadAccess);
+    if (stream->Open())
+    {
+        result.success = true;
+        for (IndexT i = 0; i < numRegions; i++)
+        {
+            stream->Seek(regions[i].offset, Stream::Begin);
+            result.bytesRead += stream->Read(regions[i].buffer, regions[i].size);
+        }
+        stream->Close();
+    }
+    queue->PostResult(callback, result);
+}
+
+//------------------------------------------------------------------------------
+/**
+*/
+SizeT
+IoServer::PollAsyncReads()
+{
+    if (!this->asyncIoQueue.isvalid())
+        return 0;
+    return this->asyncIoQueue->Poll();
+}
+
+//------------------------------------------------------------------------------
+/**
+*/
+void
+IoServer::WaitForAsyncReads()
+{
+    if (this->asyncIoQueue.isvalid())
+    {
+        this->asyncIoQueue->Wait();
+    }
+}
+
 } // namespace IO
@@ -24,6 +24,7 @@
 #include "io/schemeregistry.h"
 #include "archfs/archivefilesystem.h"
 #include "io/cache/streamcache.h"
+#include "io/asyncioqueue.h"
 
 namespace Http
 {
@@ -112,6 +113,17 @@ public:
     /// create a temporary file name
     URI CreateTemporaryFilename(const URI& path) const;
 
+    /// get the async io queue of this io server, which is set up on first use
+    const Ptr<AsyncIoQueue>& GetAsyncIoQueue();
+    /// read a range of a file asynchronously, the callback is invoked from PollAsyncReads or WaitForAsyncReads
+    void ReadAsync(const URI& uri, Stream::Position offset, void* buffer, Stream::Size numBytes, const AsyncReadCallback& callback);
+    /// read several ranges of a file asynchronously into their buffers, the callback is invoked once all of them have been read
+    void ReadAsync(const URI& uri, const AsyncReadRegion* regions, SizeT numRegions, const AsyncReadCallback& callback);
+    /// submit queued async reads and invoke the callbacks of finished ones, returns the number of finished reads
+    SizeT PollAsyncReads();
+    /// wait for all async reads to finish, invoking their callbacks
+    void WaitForAsyncReads();
+
 private:
     /// helper function to add path prefix to file or dir names in array
     Util::Array<Util::String> AddPathPrefixToArray(const Util::String& prefix, const Util::Array<Util::String>& filenames) const;
@@ -126,6 +138,7 @@ private:
     Ptr<SchemeRegistry> schemeRegistry;
     Ptr<FileWatcher> watcher;
     Ptr<StreamCache> streamCache;
+    Ptr<AsyncIoQueue> asyncIoQueue;
     static Threading::CriticalSection assignCriticalSection;
     static Threading::CriticalSection schemeCriticalSection;
     static Threading::CriticalSection watcherCriticalSection;
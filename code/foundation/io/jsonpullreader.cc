@@ -0,0 +1,564 @@
+//------------------------------------------------------------------------------
+//  jsonpullreader.cc
+//  (C) 2024 Individual contributors, see AUTHORS file
+//------------------------------------------------------------------------------
+
+#include "io/jsonpullreader.h"
+#include "util/bit.h"
+#include <stdlib.h>
+#include <string.h>
+#if defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#define JSON_SSE2 (1)
+#endif
+
+namespace IO
+{
+__ImplementClass(IO::JsonPullReader, 'JSPR', IO::StreamReader);
+
+using namespace Util;
+
+//------------------------------------------------------------------------------
+/**
+*/
+JsonPullReader::JsonPullReader() :
+    begin(nullptr),
+    cur(nullptr),
+    end(nullptr),
+    token(None),
+    text({ nullptr, 0 }),
+    escapes(false),
+    afterKey(false),
+    needComma(false),
+    rootDone(false),
+    depth(0)
+{
+    // empty
+}
+
+//------------------------------------------------------------------------------
+/**
+*/
+JsonPullReader::~JsonPullReader()
+{
+    if (this->IsOpen())
+    {
+        this->Close();
+    }
+}
+
+//------------------------------------------------------------------------------
+/**
+*/
+bool
+JsonPullReader::Open()
+{
+    n_assert(!this->view.isvalid());
+    if (StreamReader::Open())
+    {
+        this->view = MappedView::Create();
+        if (this->stream->GetSize() == 0 || !this->view->Setup(this->stream))
+        {
+            n_warning("JsonPullReader::Open(): failed to map '%s'!\n", this->stream->GetURI().AsString().AsCharPtr());
+            this->view = nullptr;
+            StreamReader::Close();
+            return false;
+        }
+        this->begin = (const char*)this->view->GetPointer();
+        this->cur = this->begin;
+        this->end = this->begin + this->view->GetSize();
+
+        // skip utf-8 byte order mark
+        if (this->end - this->cur >= 3 && (uchar)this->cur[0] == 0xEF && (uchar)this->cur[1] == 0xBB && (uchar)this->cur[2] == 0xBF)
+        {
+            this->cur += 3;
+        }
+        this->token = None;
+        this->afterKey = false;
+        this->needComma = false;
+        this->rootDone = false;
+        this->depth = 0;
+        return true;
+    }
+    return false;
+}
+
+//------------------------------------------------------------------------------
+/**
+*/
+void
+JsonPullReader::Close()
+{
+    this->view->Discard();
+    this->view = nullptr;
+    this->begin = this->cur = this->end = nullptr;
+    this->text = { nullptr, 0 };
+    this->token = None;
+    StreamReader::Close();
+}
+
+//------------------------------------------------------------------------------
+/**
+*/
+void
+JsonPullReader::SkipWhitespace()
+{
+    while (this->cur < this->end)
+    {
+        char const c = *this->cur;
+        if (c != ' ' && c != '\n' && c != '\r' && c != '\t')
+        {
+            break;
+        }
+        this->cur++;
+    }
+}
+
+//------------------------------------------------------------------------------
+/**
+    Called with the cursor after the opening quote, leaves it after the
+    closing quote. Quotes and backslashes are searched for 16 bytes at a
+    time, everything in between is skipped without looking at it.
+*/
+bool
+JsonPullReader::ScanString()
+{
+    const char* start = this->cur;
+    const char* p = this->cur;
+    this->escapes = false;
+    for (;;)
+    {
+#if JSON_SSE2
+        __m128i const quote = _mm_set1_epi8('"');
+        __m128i const backslash = _mm_set1_epi8('\\');
+        while (p + 16 <= this->end)
+        {
+            __m128i const chunk = _mm_loadu_si128((const __m128i*)p);
+            int const mask = _mm_movemask_epi8(_mm_or_si128(_mm_cmpeq_epi8(chunk, quote), _mm_cmpeq_epi8(chunk, backslash)));
+            if (mask != 0)
+            {
+                p += Util::FirstOne((uint)mask);
+                break;
+            }
+            p += 16;
+        }
+#endif
+        while (p < this->end && *p != '"' && *p != '\\')
+        {
+            p++;
+        }
+        if (p >= this->end)
+        {
+            this->cur = p;
+            return false;
+        }
+        if (*p == '"')
+        {
+            break;
+        }
+
+        // escape sequence, the escaped character may be a quote
+        this->escapes = true;
+        p += 2;
+        if (p > this->end)
+        {
+            this->cur = this->end;
+            return false;
+        }
+    }
+    this->text = { start, (SizeT)(p - start) };
+    this->cur = p + 1;
+    return true;
+}
+
+//------------------------------------------------------------------------------
+/**
+*/
+bool
+JsonPullReader::ScanNumber()
+{
+    const char* start = this->cur;
+    const char* p = this->cur;
+    if (p < this->end && *p == '-')
+    {
+        p++;
+    }
+    const char* digits = p;
+    while (p < this->end && ((*p >= '0' && *p <= '9') || *p == '.' || *p == 'e' || *p == 'E' || *p == '+' || *p == '-'))
+    {
+        p++;
+    }
+    if (p == digits || *digits < '0' || *digits > '9')
+    {
+        return false;
+    }
+    this->text = { start, (SizeT)(p - start) };
+    this->escapes = false;
+    this->cur = p;
+    return true;
+}
+
+//------------------------------------------------------------------------------
+/**
+*/
+bool
+JsonPullReader::ScanLiteral(const char* literal, SizeT length)
+{
+    if (this->end - this->cur < length || memcmp(this->cur, literal, length) != 0)
+    {
+        return false;
+    }
+    this->text = { this->cur, length };
+    this->escapes = false;
+    this->cur += length;
+    return true;
+}
+
+//------------------------------------------------------------------------------
+/**
+*/
+JsonPullReader::Token
+JsonPullReader::SetError()
+{
+    this->token = Error;
+    this->text = { nullptr, 0 };
+    return Error;
+}
+
+//------------------------------------------------------------------------------
+/**
+*/
+JsonPullReader::Token
+JsonPullReader::EndValue(Token t)
+{
+    this->afterKey = false;
+    this->needComma = this->depth > 0;
+    this->rootDone = this->depth == 0;
+    this->token = t;
+    return t;
+}
+
+//------------------------------------------------------------------------------
+/**
+    Validates the structure of the document while reading it, a malformed
+    document results in an Error token, which is sticky.
+*/
+JsonPullReader::Token
+JsonPullReader::Next()
+{
+    n_assert(this->IsOpen());
+    if (this->token == Error || this->token == EndOfDocument)
+    {
+        return this->token;
+    }
+
+    this->SkipWhitespace();
+    if (this->cur >= this->end)
+    {
+        if (this->rootDone)
+        {
+            this->token = EndOfDocument;
+            this->text = { nullptr, 0 };
+            return EndOfDocument;
+        }
+        return this->SetError();
+    }
+    if (this->rootDone)
+    {
+        // trailing characters after the root value
+        return this->SetError();
+    }
+
+    char c = *this->cur;
+    char const container = this->depth > 0 ? this->stack[this->depth - 1] : 0;
+
+    // closing the current container
+    if ((c == '}' || c == ']') && !this->afterKey)
+    {
+        if ((c == '}' && container != '{') || (c == ']' && container != '['))
+        {
+            return this->SetError();
+        }
+        if (!this->needComma && this->token != BeginObject && this->token != BeginArray)
+        {
+            // trailing comma
+            return this->SetError();
+        }
+        this->cur++;
+        this->depth--;
+        this->text = { nullptr, 0 };
+        return this->EndValue(c == '}' ? EndObject : EndArray);
+    }
+
+    if (this->needComma)
+    {
+        if (c != ',')
+        {
+            return this->SetError();
+        }
+        this->cur++;
+        this->needComma = false;
+        this->SkipWhitespace();
+        if (this->cur >= this->end)
+        {
+            return this->SetError();
+        }
+        c = *this->cur;
+    }
+
+    // keys of objects
+    if (container == '{' && !this->afterKey)
+    {
+        if (c != '"')
+        {
+            return this->SetError();
+        }
+        this->cur++;
+        if (!this->ScanString())
+        {
+            return this->SetError();
+        }
+        this->SkipWhitespace();
+        if (this->cur >= this->end || *this->cur != ':')
+        {
+            return this->SetError();
+        }
+        this->cur++;
+        this->afterKey = true;
+        this->token = Key;
+        return Key;
+    }
+
+    // values
+    switch (c)
+    {
+        case '{':
+        case '[':
+            if (this->depth == MaxDepth)
+            {
+                return this->SetError();
+            }
+            this->stack[this->depth++] = c;
+            this->cur++;
+            this->afterKey = false;
+            this->needComma = false;
+            this->text = { nullptr, 0 };
+            this->token = c == '{' ? BeginObject : BeginArray;
+            return this->token;
+        case '"':
+            this->cur++;
+            return this->ScanString() ? this->EndValue(String) : this->SetError();
+        case 't':
+            return this->ScanLiteral("true", 4) ? this->EndValue(True) : this->SetError();
+        case 'f':
+            return this->ScanLiteral("false", 5) ? this->EndValue(False) : this->SetError();
+        case 'n':
+            return this->ScanLiteral("null", 4) ? this->EndValue(Null) : this->SetError();
+        default:
+            return this->ScanNumber() ? this->EndValue(Number) : this->SetError();
+    }
+}
+
+//------------------------------------------------------------------------------
+/**
+    After a key, skips its value. On BeginObject or BeginArray, skips to
+    the matching end token. Any other token is already a complete value.
+*/
+bool
+JsonPullReader::SkipValue()
+{
+    Token t = this->token;
+    if (t == Key)
+    {
+        t = this->Next();
+    }
+    if (t == BeginObject || t == BeginArray)
+    {
+        SizeT const target = this->depth - 1;
+        while (this->depth > target)
+        {
+            t = this->Next();
+            if (t == Error)
+            {
+                return false;
+            }
+        }
+    }
+    return t != Error && t != EndOfDocument;
+}
+
+//------------------------------------------------------------------------------
+/**
+*/
+static void
+AppendUtf8(String& str, uint code)
+{
+    if (code < 0x80)
+    {
+        str.AppendChar((char)code);
+    }
+    else if (code < 0x800)
+    {
+        str.AppendChar((char)(0xC0 | (code >> 6)));
+        str.AppendChar((char)(0x80 | (code & 0x3F)));
+    }
+    else if (code < 0x10000)
+    {
+        str.AppendChar((char)(0xE0 | (code >> 12)));
+        str.AppendChar((char)(0x80 | ((code >> 6) & 0x3F)));
+        str.AppendChar((char)(0x80 | (code & 0x3F)));
+    }
+    else
+    {
+        str.AppendChar((char)(0xF0 | (code >> 18)));
+        str.AppendChar((char)(0x80 | ((code >> 12) & 0x3F)));
+        str.AppendChar((char)(0x80 | ((code >> 6) & 0x3F)));
+        str.AppendChar((char)(0x80 | (code & 0x3F)));
+    }
+}
+
+//------------------------------------------------------------------------------
+/**
+*/
+static bool
+ParseHex4(const char* p, const char* end, uint& outCode)
+{
+    if (end - p < 4)
+    {
+        return false;
+    }
+    outCode = 0;
+    IndexT i;
+    for (i = 0; i < 4; i++)
+    {
+        char const c = p[i];
+        outCode <<= 4;
+        if (c >= '0' && c <= '9') outCode |= c - '0';
+        else if (c >= 'a' && c <= 'f') outCode |= c - 'a' + 10;
+        else if (c >= 'A' && c <= 'F') outCode |= c - 'A' + 10;
+        else return false;
+    }
+    return true;
+}
+
+//------------------------------------------------------------------------------
+/**
+*/
+String
+JsonPullReader::GetString() const
+{
+    n_assert(this->token == Key || this->token == String || this->token == Number);
+    String str;
+    if (!this->escapes)
+    {
+        str.Set(this->text.ptr, this->text.length);
+        return str;
+    }
+
+    str.Reserve(this->text.length);
+    const char* p = this->text.ptr;
+    const char* end = this->text.ptr + this->text.length;
+    while (p < end)
+    {
+        if (*p != '\\')
+        {
+            const char* run = p;
+            while (p < end && *p != '\\')
+            {
+                p++;
+            }
+            str.AppendRange(run, (SizeT)(p - run));
+            continue;
+        }
+        p++;
+        switch (*p++)
+        {
+            case '"': str.AppendChar('"'); break;
+            case '\\': str.AppendChar('\\'); break;
+            case '/': str.AppendChar('/'); break;
+            case 'b': str.AppendChar('\b'); break;
+            case 'f': str.AppendChar('\f'); break;
+            case 'n': str.AppendChar('\n'); break;
+            case 'r': str.AppendChar('\r'); break;
+            case 't': str.AppendChar('\t'); break;
+            case 'u':
+            {
+                uint code;
+                if (!ParseHex4(p, end, code))
+                {
+                    return str;
+                }
+                p += 4;
+                if (code >= 0xD800 && code < 0xDC00 && end - p >= 6 && p[0] == '\\' && p[1] == 'u')
+                {
+                    uint low;
+                    if (ParseHex4(p + 2, end, low) && low >= 0xDC00 && low < 0xE000)
+                    {
+                        code = 0x10000 + ((code - 0xD800) << 10) + (low - 0xDC00);
+                        p += 6;
+                    }
+                }
+                AppendUtf8(str, code);
+                break;
+            }
+            default:
+                break;
+        }
+    }
+    return str;
+}
+
+//------------------------------------------------------------------------------
+/**
+    The view isn't 0-terminated, numbers are copied to the stack for strtod.
+*/
+double
+JsonPullReader::GetDouble() const
+{
+    n_assert(this->token == Number);
+    char buf[64];
+    SizeT const length = Math::min(this->text.length, (SizeT)sizeof(buf) - 1);
+    Memory::Copy(this->text.ptr, buf, length);
+    buf[length] = 0;
+    return strtod(buf, nullptr);
+}
+
+//------------------------------------------------------------------------------
+/**
+*/
+float
+JsonPullReader::GetFloat() const
+{
+    return (float)this->GetDouble();
+}
+
+//------------------------------------------------------------------------------
+/**
+    Integers are parsed directly, anything with a fraction or exponent goes
+    through GetDouble().
+*/
+int
+JsonPullReader::GetInt() const
+{
+    n_assert(this->token == Number);
+    const char* p = this->text.ptr;
+    const char* end = p + this->text.length;
+    bool const negative = *p == '-';
+    if (negative)
+    {
+        p++;
+    }
+    int64_t value = 0;
+    while (p < end && *p >= '0' && *p <= '9')
+    {
+        value = value * 10 + (*p - '0');
+        p++;
+    }
+    if (p != end)
+    {
+        return (int)this->GetDouble();
+    }
+    return (int)(negative ? -value : value);
+}
+
+} // namespace IO
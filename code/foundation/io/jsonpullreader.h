@@ -0,0 +1,200 @@
+#pragma once
+//------------------------------------------------------------------------------
+/**
+    @class IO::JsonPullReader
+
+    Streaming, pull style json reader. Instead of building a document tree
+    like the JsonReader, the document is walked token by token with Next(),
+    and values are consumed in document order. Subtrees which aren't needed
+    can be skipped with SkipValue().
+
+    The stream is read through a MappedView, keys and strings are returned
+    as views into the mapped file, so reading a document doesn't allocate.
+    GetString() returns an unescaped copy where one is needed. Strings are
+    scanned 16 bytes at a time for quotes and escapes.
+
+    Use this for large files which are read once from front to back, the
+    JsonReader is more convenient where random access is needed.
+
+    @copyright
+    (C) 2024 Individual contributors, see AUTHORS file
+*/
+#include "io/streamreader.h"
+#include "io/mappedview.h"
+#include "util/string.h"
+
+//------------------------------------------------------------------------------
+namespace IO
+{
+class JsonPullReader : public StreamReader
+{
+    __DeclareClass(JsonPullReader);
+public:
+    enum Token
+    {
+        None,
+        BeginObject,
+        EndObject,
+        BeginArray,
+        EndArray,
+        Key,
+        String,
+        Number,
+        True,
+        False,
+        Null,
+        EndOfDocument,
+        Error
+    };
+
+    /// a range of characters in the mapped document, not 0-terminated
+    struct StringView
+    {
+        const char* ptr;
+        SizeT length;
+
+        /// compare with a 0-terminated string
+        bool Equals(const char* str) const;
+    };
+
+    /// maximum nesting depth of objects and arrays
+    static const SizeT MaxDepth = 256;
+
+    /// constructor
+    JsonPullReader();
+    /// destructor
+    virtual ~JsonPullReader();
+
+    /// begin reading from the stream
+    virtual bool Open();
+    /// end reading from the stream
+    virtual void Close();
+
+    /// advance to the next token
+    Token Next();
+    /// skip the value after the current key, or the rest of the current object or array
+    bool SkipValue();
+    /// get the current token
+    Token GetToken() const;
+    /// get the current nesting depth
+    SizeT GetDepth() const;
+    /// get the byte offset of an error
+    Stream::Size GetErrorOffset() const;
+
+    /// get the raw text of the current key, string or number, escape sequences are not resolved
+    const StringView& GetView() const;
+    /// return true if the current key or string contains escape sequences
+    bool HasEscapes() const;
+    /// get the current key or string with escape sequences resolved
+    Util::String GetString() const;
+    /// get the current number as double
+    double GetDouble() const;
+    /// get the current number as float
+    float GetFloat() const;
+    /// get the current number as int
+    int GetInt() const;
+    /// get the current true or false token as bool
+    bool GetBool() const;
+
+private:
+    /// skip whitespace
+    void SkipWhitespace();
+    /// scan a string after the opening quote
+    bool ScanString();
+    /// scan a number
+    bool ScanNumber();
+    /// scan a literal like true
+    bool ScanLiteral(const char* literal, SizeT length);
+    /// set the error token
+    Token SetError();
+    /// finish a value, returns the token
+    Token EndValue(Token token);
+
+    Ptr<MappedView> view;
+    const char* begin;
+    const char* cur;
+    const char* end;
+    Token token;
+    StringView text;
+    bool escapes;
+    bool afterKey;
+    bool needComma;
+    bool rootDone;
+    SizeT depth;
+    char stack[MaxDepth];
+};
+
+//------------------------------------------------------------------------------
+/**
+*/
+inline bool
+JsonPullReader::StringView::Equals(const char* str) const
+{
+    SizeT i;
+    for (i = 0; i < this->length; i++)
+    {
+        if (str[i] != this->ptr[i])
+        {
+            return false;
+        }
+    }
+    return str[i] == 0;
+}
+
+//------------------------------------------------------------------------------
+/**
+*/
+inline JsonPullReader::Token
+JsonPullReader::GetToken() const
+{
+    return this->token;
+}
+
+//------------------------------------------------------------------------------
+/**
+*/
+inline SizeT
+JsonPullReader::GetDepth() const
+{
+    return this->depth;
+}
+
+//------------------------------------------------------------------------------
+/**
+*/
+inline Stream::Size
+JsonPullReader::GetErrorOffset() const
+{
+    return this->cur - this->begin;
+}
+
+//------------------------------------------------------------------------------
+/**
+*/
+inline const JsonPullReader::StringView&
+JsonPullReader::GetView() const
+{
+    return this->text;
+}
+
+//------------------------------------------------------------------------------
+/**
+*/
+inline bool
+JsonPullReader::HasEscapes() const
+{
+    return this->escapes;
+}
+
+//------------------------------------------------------------------------------
+/**
+*/
+inline bool
+JsonPullReader::GetBool() const
+{
+    n_assert(this->token == True || this->token == False);
+    return this->token == True;
+}
+
+} // namespace IO
+//------------------------------------------------------------------------------
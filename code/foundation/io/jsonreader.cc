@@ -3,16 +3,10 @@
 //  (C) 2018-2020 Individual contributors, see AUTHORS file
 //------------------------------------------------------------------------------
 
-#ifdef min
-#undef min
-#endif
-#ifdef max
-#undef max
-#endif
-#include "pjson/pjson.h"
 #include "io/jsonreader.h"
 #include "util/variant.h"
 #include <climits>
+#include <string.h>
 
 namespace IO
 {
@@ -21,8 +15,10 @@ __ImplementClass(IO::JsonReader, 'JSLR', IO::StreamReader);
 
 using namespace Util;
 using namespace Math;
-using namespace pjson;
-    
+
+/// strings are copied into blocks of this size, longer strings get their own block
+static const SizeT StringBlockSize = 4096;
+
 //------------------------------------------------------------------------------
 /**
 */
@@ -46,8 +42,7 @@ JsonReader::~JsonReader()
 
 //------------------------------------------------------------------------------
 /**
-    Opens the stream and reads the content of the stream into
-    pjson.
+    Opens the stream and builds the node tree from it.
 */
 bool
 JsonReader::Open()
@@ -56,27 +51,27 @@ JsonReader::Open()
     
     if (StreamReader::Open())
     {
-        this->document = new pjson::document;
+        const URI& uri = this->stream->GetURI();
+        Util::String const fileName = uri.IsEmpty() ? "" : uri.AsString();
 
-        // create an document object        
-        // we need to 0 terminate the input buffer
-        Stream::Size fileSize = this->stream->GetSize();
-        this->buffer = (char*)Memory::Alloc(Memory::StreamDataHeap, fileSize + 1);
-        this->stream->Read(buffer, fileSize);
-        this->buffer[fileSize] = '\0';
-        if (!this->document->deserialize_in_place(buffer))
+        Ptr<JsonPullReader> reader = JsonPullReader::Create();
+        reader->SetStream(this->stream);
+        if (!reader->Open())
         {
-            const URI& uri = this->stream->GetURI();
-            const pjson::error_info & error = this->document->get_error();
-            Util::String position;
-            if(error.m_ofs<(size_t)this->stream->GetSize())
-            {
-                position.Set(((const char *)this->buffer) + error.m_ofs, 40);
-            }
-			Util::String const fileName = uri.IsEmpty() ? "" : uri.AsString();
-			n_error("JsonReader::Open(): failed to parse json file: %s\n%s\nat: %s\n", fileName.AsCharPtr(), error.m_pError_message, position.AsCharPtr());
-			return false;
-        }        
+            n_error("JsonReader::Open(): failed to read json file: %s\n", fileName.AsCharPtr());
+            return false;
+        }
+
+        this->document = this->Parse(reader);
+        if (0 == this->document)
+        {
+            Stream::Size const offset = reader->GetErrorOffset();
+            reader->Close();
+            this->arena.Release();
+            n_error("JsonReader::Open(): failed to parse json file: %s\nat byte %lld\n", fileName.AsCharPtr(), (long long)offset);
+            return false;
+        }
+        reader->Close();
 
         // set the current node to the root node
         this->curNode = this->document;
@@ -92,14 +87,187 @@ void
 JsonReader::Close()
 {
     n_assert(0 != this->document);
-    this->document->clear();
-    delete this->document;
+    this->arena.Release();
+    this->document = 0;
     this->curNode = 0;
-    Memory::Free(Memory::StreamDataHeap, this->buffer);
-    this->buffer = nullptr;
+    this->stringCur = nullptr;
+    this->stringEnd = nullptr;
+    this->parents.Clear();
+    this->parentIdx.Clear();
     StreamReader::Close();
 }
 
+//------------------------------------------------------------------------------
+/**
+    Walks the document once. The values of all open arrays and objects are
+    kept on one stack, each container followed by its children, and when a
+    container ends its children are moved into the arena as one block. So
+    every node is copied once, and no node needs its own allocation.
+*/
+const JsonReader::Node*
+JsonReader::Parse(JsonPullReader* reader)
+{
+    Array<Node> pending;
+    Array<IndexT> starts;
+    pending.Reserve(256);
+    const char* key = nullptr;
+
+    JsonPullReader::Token token;
+    while ((token = reader->Next()) != JsonPullReader::EndOfDocument)
+    {
+        Node node;
+        node.key = key;
+        node.size = 0;
+        node.i = 0;
+        switch (token)
+        {
+            case JsonPullReader::Key:
+            {
+                const JsonPullReader::StringView& view = reader->GetView();
+                if (reader->HasEscapes())
+                {
+                    String const unescaped = reader->GetString();
+                    key = this->CopyString(unescaped.AsCharPtr(), unescaped.Length());
+                }
+                else
+                {
+                    key = this->CopyString(view.ptr, view.length);
+                }
+                continue;
+            }
+            case JsonPullReader::BeginObject:
+            case JsonPullReader::BeginArray:
+                node.type = token == JsonPullReader::BeginObject ? Node::ObjectType : Node::ArrayType;
+                node.children = nullptr;
+                pending.Append(node);
+                starts.Append(pending.Size());
+                key = nullptr;
+                continue;
+            case JsonPullReader::EndObject:
+            case JsonPullReader::EndArray:
+            {
+                IndexT const start = starts.Back();
+                starts.EraseBack();
+                SizeT const num = pending.Size() - start;
+                Node& container = pending[start - 1];
+                container.size = (uint32_t)num;
+                if (num > 0)
+                {
+                    Node* children = (Node*)this->arena.Alloc(num * sizeof(Node));
+                    Memory::Copy(&pending[start], children, num * sizeof(Node));
+                    container.children = children;
+                    pending.Resize(start);
+                }
+                continue;
+            }
+            case JsonPullReader::String:
+            {
+                const JsonPullReader::StringView& view = reader->GetView();
+                node.type = Node::StringType;
+                if (reader->HasEscapes())
+                {
+                    String const unescaped = reader->GetString();
+                    node.str = this->CopyString(unescaped.AsCharPtr(), unescaped.Length());
+                }
+                else
+                {
+                    node.str = this->CopyString(view.ptr, view.length);
+                }
+                break;
+            }
+            case JsonPullReader::Number:
+            {
+                // integers with up to 18 digits fit into an int64, everything else is read as double
+                const JsonPullReader::StringView& view = reader->GetView();
+                bool const negative = view.ptr[0] == '-';
+                IndexT i = negative ? 1 : 0;
+                int64_t value = 0;
+                for (; i < view.length && i - negative < 18 && view.ptr[i] >= '0' && view.ptr[i] <= '9'; i++)
+                {
+                    value = value * 10 + (view.ptr[i] - '0');
+                }
+                if (i == view.length)
+                {
+                    node.type = Node::IntType;
+                    node.i = negative ? -value : value;
+                }
+                else
+                {
+                    node.type = Node::DoubleType;
+                    node.d = reader->GetDouble();
+                }
+                break;
+            }
+            case JsonPullReader::True:
+            case JsonPullReader::False:
+                node.type = Node::BoolType;
+                node.b = token == JsonPullReader::True;
+                break;
+            case JsonPullReader::Null:
+                node.type = Node::NullType;
+                break;
+            default:
+                return 0;
+        }
+        pending.Append(node);
+        key = nullptr;
+    }
+
+    // an empty document has no root
+    if (pending.Size() != 1)
+    {
+        return 0;
+    }
+    Node* root = (Node*)this->arena.Alloc(sizeof(Node));
+    *root = pending[0];
+    return root;
+}
+
+//------------------------------------------------------------------------------
+/**
+*/
+const char*
+JsonReader::CopyString(const char* str, SizeT length)
+{
+    if (this->stringEnd - this->stringCur < length + 1)
+    {
+        SizeT const blockSize = Math::max(length + 1, StringBlockSize);
+        this->stringCur = (char*)this->arena.Alloc(blockSize);
+        this->stringEnd = this->stringCur + blockSize;
+    }
+    char* copy = this->stringCur;
+    if (length > 0)
+    {
+        Memory::Copy(str, copy, length);
+    }
+    copy[length] = 0;
+    this->stringCur += length + 1;
+    return copy;
+}
+
+//------------------------------------------------------------------------------
+/**
+    Finds a key by comparing it with every key of the object, the same as a
+    scan over the object in the file would. Arrays have no keys.
+*/
+IndexT
+JsonReader::Node::FindIndex(const char* name) const
+{
+    if (!this->IsObject())
+    {
+        return InvalidIndex;
+    }
+    IndexT i;
+    for (i = 0; i < (IndexT)this->size; i++)
+    {
+        if (strcmp(this->children[i].key, name) == 0)
+        {
+            return i;
+        }
+    }
+    return InvalidIndex;
+}
+
 //------------------------------------------------------------------------------
 /**
     This method returns true if the node identified by path exists. Path
@@ -114,7 +282,7 @@ JsonReader::HasNode(const String& path)
     Array<String> tokens = path.Tokenize("/");
 
     // get starting node (either root or current node)
-    const value_variant* node;
+    const Node* node;
     if (absPath)
     {
         node = this->document;
@@ -131,11 +299,11 @@ JsonReader::HasNode(const String& path)
     for (i = 0; i < num; i++)
     {       
         const String& cur = tokens[i];
-        if (!node->is_object())
+        if (!node->IsObject())
         {
             return false;
         }
-        node = node->find_value_variant(cur.AsCharPtr());
+        node = node->Find(cur.AsCharPtr());
         if (0 == node)
         {
             return false;
@@ -194,10 +362,10 @@ JsonReader::SetToNode(const String& path)
             Util::String numstr = cur;
             numstr.Trim("[]");
             unsigned int idx = numstr.AsInt();
-            if (!this->curNode->is_object_or_array()) goto fail;
-            if (!(idx < this->curNode->size())) goto fail;
+            if (!this->curNode->IsObjectOrArray()) goto fail;
+            if (!(idx < this->curNode->Size())) goto fail;
 
-            const value_variant* node = &this->curNode->get_value_at_index(idx);
+            const Node* node = &this->curNode->At(idx);
             this->parents.Push(this->curNode);
             this->parentIdx.Push(this->childIdx);
             this->curNode = node;
@@ -227,18 +395,18 @@ JsonReader::SetToFirstChild(const Util::String& name)
 {
     n_assert(this->IsOpen());
     n_assert(0 != this->curNode);
-    const value_variant* child = nullptr;
+    const Node* child = nullptr;
     IndexT cIdx = 0;
-    if (this->curNode->has_children())
+    if (this->curNode->HasChildren())
     {
         if (name.IsEmpty())
         {
-            child = &this->curNode->get_value_at_index(0);
+            child = &this->curNode->At(0);
         }
         else
         {
-            child = this->curNode->find_value_variant(name.AsCharPtr());
-            cIdx = this->curNode->find_key(name.AsCharPtr());
+            child = this->curNode->Find(name.AsCharPtr());
+            cIdx = this->curNode->FindIndex(name.AsCharPtr());
         }
 
         if (child)
@@ -270,9 +438,9 @@ JsonReader::SetToNextChild()
 
     this->childIdx++;
 
-    if (this->childIdx < (IndexT)this->parents.Peek()->size())
+    if (this->childIdx < (IndexT)this->parents.Peek()->Size())
     {
-        const value_variant* child = &this->parents.Peek()->get_value_at_index(this->childIdx);
+        const Node* child = &this->parents.Peek()->At(this->childIdx);
         if (child)
         {
             this->curNode = child;
@@ -315,9 +483,9 @@ JsonReader::GetChildNodeName(SizeT childIndex)
     n_assert(0 != this->curNode);
     n_assert(0 <= childIndex);
 
-    if (childIndex < (IndexT)this->curNode->size())
+    if (childIndex < (IndexT)this->curNode->Size())
     {
-        return this->curNode->get_key_name_at_index(childIndex);
+        return this->curNode->KeyAt(childIndex);
     }
 
     return "";
@@ -332,7 +500,7 @@ JsonReader::IsArray() const
 {
     n_assert(this->IsOpen());
     n_assert(0 != this->curNode);
-    return this->curNode->is_array();
+    return this->curNode->IsArray();
 }
 
 
@@ -345,7 +513,7 @@ JsonReader::IsObject() const
 {
     n_assert(this->IsOpen());
     n_assert(0 != this->curNode);
-    return this->curNode->is_object();
+    return this->curNode->IsObject();
 }
 //------------------------------------------------------------------------------
 /**
@@ -356,7 +524,7 @@ JsonReader::HasChildren() const
 {
     n_assert(this->IsOpen());
     n_assert(0 != this->curNode);
-    return this->curNode->has_children();
+    return this->curNode->HasChildren();
 }
 
 //------------------------------------------------------------------------------
@@ -368,9 +536,9 @@ JsonReader::CurrentSize() const
 {
     n_assert(this->IsOpen());
     n_assert(0 != this->curNode);
-    if (this->curNode->is_object_or_array())
+    if (this->curNode->IsObjectOrArray())
     {
-        return this->curNode->size();
+        return this->curNode->Size();
     }
     return 0;
 }
@@ -385,8 +553,8 @@ JsonReader::HasAttr(const char* name) const
     n_assert(this->IsOpen());
     n_assert(0 != this->curNode);
     n_assert(0 != name);
-    n_assert(this->curNode->is_object());
-    return (0 != this->curNode->has_key(name));
+    n_assert(this->curNode->IsObject());
+    return (0 != this->curNode->Find(name));
 }
 
 //------------------------------------------------------------------------------
@@ -398,11 +566,11 @@ JsonReader::GetAttrs() const
 {
     n_assert(this->IsOpen());
     n_assert(0 != this->curNode);
-    n_assert(this->curNode->is_object());
+    n_assert(this->curNode->IsObject());
     Array<String> res;
-    for (unsigned int i = 0; i < this->curNode->size(); ++i)
+    for (IndexT i = 0; i < this->curNode->Size(); ++i)
     {
-        res.Append(this->curNode->get_key_name_at_index(i));
+        res.Append(this->curNode->KeyAt(i));
     }
     return res;
 }
@@ -416,7 +584,7 @@ JsonReader::GetCurrentNodeName() const
     //  get_key_name_at_index(this->childIdx)
     auto parent = this->parents.Peek();
     // auto parentIdx = this->parentIdx.Peek();
-    return parent->get_key_name_at_index(this->childIdx);
+    return parent->KeyAt(this->childIdx);
 }
 
 
@@ -424,7 +592,7 @@ JsonReader::GetCurrentNodeName() const
 /**
     
 */
-const pjson::value_variant* 
+const JsonReader::Node*
 JsonReader::GetChild(const char * name) const
 {
     n_assert(this->IsOpen());
@@ -432,8 +600,8 @@ JsonReader::GetChild(const char * name) const
 
     if (0 != name)
     {
-        n_assert(this->curNode->is_object());        
-        return this->curNode->find_value_variant(name);
+        n_assert(this->curNode->IsObject());        
+        return this->curNode->Find(name);
     }
     else
     {
@@ -449,11 +617,11 @@ JsonReader::GetChild(const char * name) const
 String
 JsonReader::GetString(const char* name) const
 {
-    const value_variant * node = this->GetChild(name);
+    const Node* node = this->GetChild(name);
 
     n_assert(node);
-    n_assert(node->is_string());
-    return node->as_string_ptr();    
+    n_assert(node->IsString());
+    return node->AsString();    
 }
 
 //------------------------------------------------------------------------------
@@ -464,11 +632,11 @@ JsonReader::GetString(const char* name) const
 StringAtom
 JsonReader::GetStringAtom(const char* name) const
 {
-    const value_variant * node = this->GetChild(name);
+    const Node* node = this->GetChild(name);
 
     n_assert(node);
-    n_assert(node->is_string());
-    return node->as_string_ptr();
+    n_assert(node->IsString());
+    return node->AsString();
 }
 
 //------------------------------------------------------------------------------
@@ -479,11 +647,11 @@ JsonReader::GetStringAtom(const char* name) const
 bool
 JsonReader::GetBool(const char* name) const
 {
-    const value_variant * node = this->GetChild(name);
+    const Node* node = this->GetChild(name);
 
     n_assert(node);
-    n_assert(node->is_bool());
-    return node->as_bool();
+    n_assert(node->IsBool());
+    return node->AsBool();
 }
 
 //------------------------------------------------------------------------------
@@ -494,11 +662,11 @@ JsonReader::GetBool(const char* name) const
 int
 JsonReader::GetInt(const char* name) const
 {
-    const value_variant * node = this->GetChild(name);
+    const Node* node = this->GetChild(name);
 
     n_assert(node);
-    n_assert(node->is_int());
-    return node->as_int32();
+    n_assert(node->IsInt());
+    return node->AsInt();
 }
 
 //------------------------------------------------------------------------------
@@ -509,11 +677,11 @@ JsonReader::GetInt(const char* name) const
 uint
 JsonReader::GetUInt(const char * attr) const
 {
-    const value_variant * node = this->GetChild(attr);
+    const Node* node = this->GetChild(attr);
     
     n_assert(node);
-    n_assert(node->is_int());
-    return (uint)node->as_int32();
+    n_assert(node->IsInt());
+    return (uint)node->AsInt();
 }
 
 //------------------------------------------------------------------------------
@@ -524,12 +692,12 @@ JsonReader::GetUInt(const char * attr) const
 float
 JsonReader::GetFloat(const char* name) const
 {
-    const value_variant * node = this->GetChild(name);
+    const Node* node = this->GetChild(name);
 
     n_assert(node);
     // Floats can be either double or integer if it has no fraction
-    n_assert(node->is_double() || node->is_int());
-    return node->as_float();
+    n_assert(node->IsDouble() || node->IsInt());
+    return node->AsFloat();
 }
 
 //------------------------------------------------------------------------------
@@ -540,11 +708,11 @@ JsonReader::GetFloat(const char* name) const
 vec2
 JsonReader::GetVec2(const char* name) const
 {
-    const value_variant * node = this->GetChild(name);
+    const Node* node = this->GetChild(name);
 
-    n_assert(node->is_array());
-    n_assert(node->size() == 2);
-    return vec2(node->get_value_at_index(0).as_float(), node->get_value_at_index(1).as_float());
+    n_assert(node->IsArray());
+    n_assert(node->Size() == 2);
+    return vec2(node->At(0).AsFloat(), node->At(1).AsFloat());
 }
 
 //------------------------------------------------------------------------------
@@ -553,14 +721,14 @@ JsonReader::GetVec2(const char* name) const
 Math::vec3 
 JsonReader::GetVec3(const char* name) const
 {
-    const value_variant* node = this->GetChild(name);
+    const Node* node = this->GetChild(name);
 
-    n_assert(node->is_array());
-    n_assert(node->size() == 3);
+    n_assert(node->IsArray());
+    n_assert(node->Size() == 3);
     NEBULA_ALIGN16 float v[3];
     for (int i = 0; i < 3; i++)
     {
-        v[i] = node->get_value_at_index(i).as_float();
+        v[i] = node->At(i).AsFloat();
     }
     vec3 f;
     f.load(v);
@@ -575,14 +743,14 @@ JsonReader::GetVec3(const char* name) const
 vec4
 JsonReader::GetVec4(const char* name) const
 {
-    const value_variant * node = this->GetChild(name);
+    const Node* node = this->GetChild(name);
 
-    n_assert(node->is_array());
-    n_assert(node->size() == 4);
+    n_assert(node->IsArray());
+    n_assert(node->Size() == 4);
     NEBULA_ALIGN16 float v[4];
     for (int i = 0; i < 4; i++)
     {
-        v[i] = node->get_value_at_index(i).as_float();
+        v[i] = node->At(i).AsFloat();
     }
     vec4 f;
     f.load(v);
@@ -597,14 +765,14 @@ JsonReader::GetVec4(const char* name) const
 mat4
 JsonReader::GetMat4(const char* name) const
 {
-    const value_variant * node = this->GetChild(name);
+    const Node* node = this->GetChild(name);
 
-    n_assert(node->is_array());
-    n_assert(node->size() == 16);
+    n_assert(node->IsArray());
+    n_assert(node->Size() == 16);
     NEBULA_ALIGN16 float v[16];
     for (int i = 0; i < 16; i++)
     {
-        v[i] = node->get_value_at_index(i).as_float();
+        v[i] = node->At(i).AsFloat();
     }
     mat4 m;
     m.load(v);
@@ -619,15 +787,15 @@ the method will fail hard (use HasAttr() to check for its existance).
 transform44
 JsonReader::GetTransform44(const char* name) const
 {
-    const value_variant * node = this->GetChild(name);
+    const Node* node = this->GetChild(name);
 
-    n_assert(node->is_array());
-    n_assert(node->size() == 36);
+    n_assert(node->IsArray());
+    n_assert(node->Size() == 36);
 
     float v[36];
     for (int i = 0; i < 36; i++)
     {
-        v[i] = node->get_value_at_index(i).as_float();
+        v[i] = node->At(i).AsFloat();
     }
     transform44 m;
     m.loadu(v);
@@ -783,14 +951,14 @@ JsonReader::GetOptTransform44(const char* name, const transform44& defaultValue)
 */
 template<> void JsonReader::Get<Util::Array<uint32_t>>(Util::Array<uint32_t> & ret, const char* attr)
 {
-    const value_variant * node = this->GetChild(attr);
+    const Node* node = this->GetChild(attr);
 
-    n_assert(node->is_array());
-    unsigned int count = node->size();    
+    n_assert(node->IsArray());
+    unsigned int count = node->Size();    
     ret.Reserve(count);
     for (unsigned int i = 0; i < count; i++)
     {
-        ret.Append(node->get_value_at_index(i).as_int32());
+        ret.Append(node->At(i).AsInt());
     }    
 }
 
@@ -799,14 +967,14 @@ template<> void JsonReader::Get<Util::Array<uint32_t>>(Util::Array<uint32_t> & r
 */
 template<> void JsonReader::Get<Util::Array<int>>(Util::Array<int> & ret, const char* attr)
 {
-    const value_variant * node = this->GetChild(attr);
+    const Node* node = this->GetChild(attr);
 
-    n_assert(node->is_array());
-    unsigned int count = node->size();
+    n_assert(node->IsArray());
+    unsigned int count = node->Size();
     ret.Reserve(count);
     for (unsigned int i = 0; i < count; i++)
     {
-        ret.Append(node->get_value_at_index(i).as_int32());
+        ret.Append(node->At(i).AsInt());
     }
 }
 
@@ -815,10 +983,10 @@ template<> void JsonReader::Get<Util::Array<int>>(Util::Array<int> & ret, const
 */
 template<> void JsonReader::Get<bool>(bool & ret, const char* attr)
 {
-    const value_variant * node = this->GetChild(attr);
+    const Node* node = this->GetChild(attr);
 
-    n_assert(node->is_bool());
-    ret = node->as_bool();
+    n_assert(node->IsBool());
+    ret = node->AsBool();
 }
 
 //------------------------------------------------------------------------------
@@ -826,10 +994,10 @@ template<> void JsonReader::Get<bool>(bool & ret, const char* attr)
 */
 template<> void JsonReader::Get<int64_t>(int64_t& ret, const char* attr)
 {
-    const value_variant* node = this->GetChild(attr);
+    const Node* node = this->GetChild(attr);
 
-    n_assert(node->is_int());
-    ret = node->as_int64();
+    n_assert(node->IsInt());
+    ret = node->AsInt64();
 }
 
 //------------------------------------------------------------------------------
@@ -837,10 +1005,10 @@ template<> void JsonReader::Get<int64_t>(int64_t& ret, const char* attr)
 */
 template<> void JsonReader::Get<int32_t>(int32_t& ret, const char* attr)
 {
-    const value_variant * node = this->GetChild(attr);
+    const Node* node = this->GetChild(attr);
 
-    n_assert(node->is_int());
-    ret = node->as_int32();
+    n_assert(node->IsInt());
+    ret = node->AsInt();
 }
 
 //------------------------------------------------------------------------------
@@ -848,10 +1016,10 @@ template<> void JsonReader::Get<int32_t>(int32_t& ret, const char* attr)
 */
 template<> void JsonReader::Get<int16_t>(int16_t& ret, const char* attr)
 {
-    const value_variant* node = this->GetChild(attr);
+    const Node* node = this->GetChild(attr);
 
-    n_assert(node->is_int());
-    ret = (int16_t)node->as_int32();
+    n_assert(node->IsInt());
+    ret = (int16_t)node->AsInt();
 }
 
 //------------------------------------------------------------------------------
@@ -859,10 +1027,10 @@ template<> void JsonReader::Get<int16_t>(int16_t& ret, const char* attr)
 */
 template<> void JsonReader::Get<int8_t>(int8_t& ret, const char* attr)
 {
-    const value_variant* node = this->GetChild(attr);
+    const Node* node = this->GetChild(attr);
 
-    n_assert(node->is_int());
-    ret = (int8_t)node->as_int32();
+    n_assert(node->IsInt());
+    ret = (int8_t)node->AsInt();
 }
 
 //------------------------------------------------------------------------------
@@ -870,10 +1038,10 @@ template<> void JsonReader::Get<int8_t>(int8_t& ret, const char* attr)
 */
 template<> void JsonReader::Get<char>(char& ret, const char* attr)
 {
-    const value_variant* node = this->GetChild(attr);
+    const Node* node = this->GetChild(attr);
 
-    n_assert(node->is_int());
-    ret = (char)node->as_int32();
+    n_assert(node->IsInt());
+    ret = (char)node->AsInt();
 }
 
 //------------------------------------------------------------------------------
@@ -889,12 +1057,12 @@ template<> void JsonReader::Get<Math::mat4>(Math::mat4 & ret, const char* attr)
 */
 template<> void JsonReader::Get<Math::int2>(Math::int2& ret, const char* attr)
 {
-    const value_variant* node = this->GetChild(attr);
+    const Node* node = this->GetChild(attr);
 
-    n_assert(node->is_array());
-    n_assert(node->size() == 2);
-    ret.x = node->get_value_at_index(0).as_int32();
-    ret.y = node->get_value_at_index(1).as_int32();
+    n_assert(node->IsArray());
+    n_assert(node->Size() == 2);
+    ret.x = node->At(0).AsInt();
+    ret.y = node->At(1).AsInt();
 }
 
 //------------------------------------------------------------------------------
@@ -903,11 +1071,11 @@ template<> void JsonReader::Get<Math::int2>(Math::int2& ret, const char* attr)
 template<> void JsonReader::Get<Math::vector>(Math::vector& ret, const char* attr)
 {
     //FIXME this searches twice
-    const value_variant* node = this->GetChild(attr);
+    const Node* node = this->GetChild(attr);
     NEBULA_ALIGN16 float v[4];
     for (int i = 0; i < 3; i++)
     {
-        v[i] = node->get_value_at_index(i).as_float();
+        v[i] = node->At(i).AsFloat();
     }
     ret.load(v);
 }
@@ -917,11 +1085,11 @@ template<> void JsonReader::Get<Math::vector>(Math::vector& ret, const char* att
 */
 template<> void JsonReader::Get<Math::vec4>(Math::vec4& ret, const char* attr)
 {
-    const value_variant* node = this->GetChild(attr);
+    const Node* node = this->GetChild(attr);
     NEBULA_ALIGN16 float v[4];
     for (int i = 0; i < 4; i++)
     {
-        v[i] = node->get_value_at_index(i).as_float();
+        v[i] = node->At(i).AsFloat();
     }
     ret.load(v);
 }
@@ -931,15 +1099,15 @@ template<> void JsonReader::Get<Math::vec4>(Math::vec4& ret, const char* attr)
 */
 template<> void JsonReader::Get<Util::Color>(Util::Color& ret, const char* attr)
 {
-    const value_variant* node = this->GetChild(attr);
+    const Node* node = this->GetChild(attr);
     NEBULA_ALIGN16 float v[4];
     for (int i = 0; i < 3; i++)
     {
-        v[i] = node->get_value_at_index(i).as_float();
+        v[i] = node->At(i).AsFloat();
     }
-    if (node->size() == 4)
+    if (node->Size() == 4)
     {
-        v[3] = node->get_value_at_index(3).as_float();
+        v[3] = node->At(3).AsFloat();
     }
     else
     {
@@ -954,11 +1122,11 @@ template<> void JsonReader::Get<Util::Color>(Util::Color& ret, const char* attr)
 */
 template<> void JsonReader::Get<Math::quat>(Math::quat& ret, const char* attr)
 {
-	const value_variant* node = this->GetChild(attr);
+	const Node* node = this->GetChild(attr);
 	NEBULA_ALIGN16 float v[4];
 	for (int i = 0; i < 4; i++)
 	{
-		v[i] = node->get_value_at_index(i).as_float();
+		v[i] = node->At(i).AsFloat();
 	}
 	ret.load(v);
 }
@@ -968,11 +1136,11 @@ template<> void JsonReader::Get<Math::quat>(Math::quat& ret, const char* attr)
 */
 template<> void JsonReader::Get<Math::vec3>(Math::vec3& ret, const char* attr)
 {
-    const value_variant* node = this->GetChild(attr);
+    const Node* node = this->GetChild(attr);
     NEBULA_ALIGN16 float v[4];
     for (int i = 0; i < 3; i++)
     {
-        v[i] = node->get_value_at_index(i).as_float();
+        v[i] = node->At(i).AsFloat();
     }
     ret.load(v);
 }
@@ -982,9 +1150,9 @@ template<> void JsonReader::Get<Math::vec3>(Math::vec3& ret, const char* attr)
 */
 template<> void JsonReader::Get<Math::vec2>(Math::vec2& ret, const char* attr)
 {
-    const value_variant* node = this->GetChild(attr);
-    ret.x = node->get_value_at_index(0).as_float();
-    ret.y = node->get_value_at_index(1).as_float();
+    const Node* node = this->GetChild(attr);
+    ret.x = node->At(0).AsFloat();
+    ret.y = node->At(1).AsFloat();
 }
 
 //------------------------------------------------------------------------------
@@ -994,9 +1162,9 @@ template <>
 void
 JsonReader::Get<uint64_t>(uint64_t& ret, const char* attr)
 {
-    const value_variant* node = this->GetChild(attr);
-    n_assert(node->is_int());
-    int64_t val = node->as_int64();
+    const Node* node = this->GetChild(attr);
+    n_assert(node->IsInt());
+    int64_t val = node->AsInt64();
 
 #if NEBULA_DEBUG
     if (val < 0)
@@ -1016,9 +1184,9 @@ JsonReader::Get<uint64_t>(uint64_t& ret, const char* attr)
 */
 template<> void JsonReader::Get<uint32_t>(uint32_t & ret, const char* attr)
 {
-    const value_variant* node = this->GetChild(attr);
-    n_assert(node->is_int());
-    int32_t val = node->as_int32();
+    const Node* node = this->GetChild(attr);
+    n_assert(node->IsInt());
+    int32_t val = node->AsInt();
 
 #if NEBULA_DEBUG
     if (val < 0)
@@ -1038,9 +1206,9 @@ template<> void JsonReader::Get<uint32_t>(uint32_t & ret, const char* attr)
 */
 template<> void JsonReader::Get<uint16_t>(uint16_t & ret, const char* attr)
 {
-    const value_variant* node = this->GetChild(attr);
-    n_assert(node->is_int());
-    int32_t val = node->as_int32();
+    const Node* node = this->GetChild(attr);
+    n_assert(node->IsInt());
+    int32_t val = node->AsInt();
 
 #if NEBULA_DEBUG
     if (val < 0)
@@ -1060,9 +1228,9 @@ template<> void JsonReader::Get<uint16_t>(uint16_t & ret, const char* attr)
 */
 template<> void JsonReader::Get<uint8_t>(uint8_t & ret, const char* attr)
 {
-    const value_variant* node = this->GetChild(attr);
-    n_assert(node->is_int());
-    int32_t val = node->as_int32();
+    const Node* node = this->GetChild(attr);
+    n_assert(node->IsInt());
+    int32_t val = node->AsInt();
 
 #if NEBULA_DEBUG
     if (val < 0)
@@ -1082,10 +1250,10 @@ template<> void JsonReader::Get<uint8_t>(uint8_t & ret, const char* attr)
 */
 template<> void JsonReader::Get<float>(float & ret, const char* attr)
 {
-    const value_variant * node = this->GetChild(attr);
+    const Node* node = this->GetChild(attr);
 
-    n_assert(node->is_numeric());
-    ret = node->as_float();
+    n_assert(node->IsNumeric());
+    ret = node->AsFloat();
 }
 
 //------------------------------------------------------------------------------
@@ -1102,27 +1270,27 @@ template<> void JsonReader::Get<Util::Variant>(Util::Variant & ret, const char*
     case Util::Variant::Type::Void:
     {
         // Special case: No type has been assigned, let the parser decide the type.
-        const value_variant * node = this->GetChild(attr);
+        const Node* node = this->GetChild(attr);
 
-        if (node->is_bool())
+        if (node->IsBool())
         {
             ret.SetType(Util::Variant::Type::Bool);
-            ret.SetBool(node->as_bool());
+            ret.SetBool(node->AsBool());
         }
-        if (node->is_int())
+        if (node->IsInt())
         {
             ret.SetType(Util::Variant::Type::Int);
-            ret.SetInt(node->as_int32());
+            ret.SetInt(node->AsInt());
         }
-        else if (node->is_double())
+        else if (node->IsDouble())
         {
             ret.SetType(Util::Variant::Type::Double);
-            ret.SetDouble(node->as_double());
+            ret.SetDouble(node->AsDouble());
         }
-        else if (node->is_string())
+        else if (node->IsString())
         {
             ret.SetType(Util::Variant::Type::String);
-            ret.SetString(node->as_string_ptr());
+            ret.SetString(node->AsString());
         }
         else
         {
@@ -1168,10 +1336,10 @@ template<> void JsonReader::Get<Util::Variant>(Util::Variant & ret, const char*
 */
 template<> void JsonReader::Get<Util::String>(Util::String & ret, const char* attr)
 {
-    const value_variant * node = this->GetChild(attr);
+    const Node* node = this->GetChild(attr);
 
-    n_assert(node->is_string());
-    ret = node->as_string_ptr();
+    n_assert(node->IsString());
+    ret = node->AsString();
 }
 
 //------------------------------------------------------------------------------
@@ -1189,12 +1357,12 @@ template<> void JsonReader::Get<Util::Guid>(Util::Guid& ret, const char* attr)
 */
 template<> void JsonReader::Get<Util::FourCC>(Util::FourCC& ret, const char* attr)
 {
-    const value_variant* node = this->GetChild(attr);
+    const Node* node = this->GetChild(attr);
 
-    if (node->is_string())
-        ret.FromString(node->as_string_ptr());
-    else if (node->is_int())
-        ret.SetFromUInt(node->as_int32());
+    if (node->IsString())
+        ret.FromString(node->AsString());
+    else if (node->IsInt())
+        ret.SetFromUInt(node->AsInt());
     else
         n_error("Invalid input\n");
 }
@@ -1204,10 +1372,10 @@ template<> void JsonReader::Get<Util::FourCC>(Util::FourCC& ret, const char* att
 */
 template<> void JsonReader::Get<Util::StringAtom>(Util::StringAtom & ret, const char* attr)
 {
-    const value_variant * node = this->GetChild(attr);
+    const Node* node = this->GetChild(attr);
 
-    n_assert(node->is_string());
-    ret = node->as_string_ptr();
+    n_assert(node->IsString());
+    ret = node->AsString();
 }
 
 //------------------------------------------------------------------------------
@@ -1215,14 +1383,14 @@ template<> void JsonReader::Get<Util::StringAtom>(Util::StringAtom & ret, const
 */
 template<> void JsonReader::Get<Util::Array<float>>(Util::Array<float> &ret, const char* attr)
 {
-    const value_variant * node = this->GetChild(attr);
+    const Node* node = this->GetChild(attr);
 
-    n_assert(node->is_array());
-    unsigned int count = node->size();
+    n_assert(node->IsArray());
+    unsigned int count = node->Size();
     ret.Reserve(count);
     for (unsigned int i = 0; i < count; i++)
     {
-        ret.Append(node->get_value_at_index(i).as_float());
+        ret.Append(node->At(i).AsFloat());
     }    
 }
 
@@ -1231,14 +1399,14 @@ template<> void JsonReader::Get<Util::Array<float>>(Util::Array<float> &ret, con
 */
 template<> void JsonReader::Get<Util::Array<Util::String>>(Util::Array<Util::String> &ret, const char* attr)
 {
-    const value_variant * node = this->GetChild(attr);
+    const Node* node = this->GetChild(attr);
 
-    n_assert(node->is_array());
-    unsigned int count = node->size();
+    n_assert(node->IsArray());
+    unsigned int count = node->Size();
     ret.Reserve(count);
     for (unsigned int i = 0; i < count; i++)
     {
-        ret.Append(node->get_value_at_index(i).as_string_ptr());
+        ret.Append(node->At(i).AsString());
     }    
 }
 
@@ -1247,11 +1415,11 @@ template<> void JsonReader::Get<Util::Array<Util::String>>(Util::Array<Util::Str
 */
 template<> bool JsonReader::GetOpt<bool>(bool & ret, const char* attr)
 {
-    const value_variant * node = this->GetChild(attr);
+    const Node* node = this->GetChild(attr);
     if (node)
     {
-        n_assert(node->is_bool());
-        ret = node->as_bool();
+        n_assert(node->IsBool());
+        ret = node->AsBool();
         return true;
     }
     return false;
@@ -1262,11 +1430,11 @@ template<> bool JsonReader::GetOpt<bool>(bool & ret, const char* attr)
 */
 template<> bool JsonReader::GetOpt<int>(int & ret, const char* attr)
 {
-    const value_variant * node = this->GetChild(attr);
+    const Node* node = this->GetChild(attr);
     if (node)
     {
-        n_assert(node->is_int());
-        ret = node->as_int32();
+        n_assert(node->IsInt());
+        ret = node->AsInt();
         return true;
     }
     return false;
@@ -1277,11 +1445,11 @@ template<> bool JsonReader::GetOpt<int>(int & ret, const char* attr)
 */
 template<> bool JsonReader::GetOpt<uint16_t>(uint16_t & ret, const char* attr)
 {
-    const value_variant * node = this->GetChild(attr);
+    const Node* node = this->GetChild(attr);
     if (node)
     {
-        n_assert(node->is_int());
-        ret = static_cast<uint16_t>(node->as_int32());
+        n_assert(node->IsInt());
+        ret = static_cast<uint16_t>(node->AsInt());
         return true;
     }
     return false;
@@ -1292,11 +1460,11 @@ template<> bool JsonReader::GetOpt<uint16_t>(uint16_t & ret, const char* attr)
 */
 template<> bool JsonReader::GetOpt<uint32_t>(uint32_t & ret, const char* attr)
 {
-    const value_variant * node = this->GetChild(attr);
+    const Node* node = this->GetChild(attr);
     if (node)
     {
-        n_assert(node->is_int());
-        ret = node->as_int32();        
+        n_assert(node->IsInt());
+        ret = node->AsInt();        
         return true;
     }
     return false;
@@ -1307,11 +1475,11 @@ template<> bool JsonReader::GetOpt<uint32_t>(uint32_t & ret, const char* attr)
 */
 template<> bool JsonReader::GetOpt<float>(float & ret, const char* attr)
 {
-    const value_variant * node = this->GetChild(attr);
+    const Node* node = this->GetChild(attr);
     if (node)
     {
-        n_assert(node->is_numeric());
-        ret = node->as_float();
+        n_assert(node->IsNumeric());
+        ret = node->AsFloat();
         return true;
     }
     return false;
@@ -1323,7 +1491,7 @@ template<> bool JsonReader::GetOpt<float>(float & ret, const char* attr)
 template<> bool JsonReader::GetOpt<Math::vec4>(Math::vec4 & ret, const char* attr)
 {    
     //FIXME this searches twice
-    const value_variant * node = this->GetChild(attr);
+    const Node* node = this->GetChild(attr);
     if (node)
     {
         ret = this->GetVec4(attr);        
@@ -1338,7 +1506,7 @@ template<> bool JsonReader::GetOpt<Math::vec4>(Math::vec4 & ret, const char* att
 template<> bool JsonReader::GetOpt<Math::quat>(Math::quat & ret, const char* attr)
 {
     //FIXME this searches twice
-    const value_variant * node = this->GetChild(attr);
+    const Node* node = this->GetChild(attr);
     if (node)
     {
         ret = this->GetVec4(attr);
@@ -1354,7 +1522,7 @@ template<> bool JsonReader::GetOpt<Math::quat>(Math::quat & ret, const char* att
 template<> bool JsonReader::GetOpt<Math::mat4>(Math::mat4 & ret, const char* attr)
 {
     //FIXME this searches twice
-    const value_variant * node = this->GetChild(attr);
+    const Node* node = this->GetChild(attr);
     if (node)
     {
         ret = this->GetMat4(attr);
@@ -1367,11 +1535,11 @@ template<> bool JsonReader::GetOpt<Math::mat4>(Math::mat4 & ret, const char* att
 */
 template<> bool JsonReader::GetOpt<Util::String>(Util::String & ret, const char* attr)
 {
-    const value_variant * node = this->GetChild(attr);
+    const Node* node = this->GetChild(attr);
     if (node)
     {
-        n_assert(node->is_string());
-        ret = node->as_string_ptr();
+        n_assert(node->IsString());
+        ret = node->AsString();
         return true;
     }
     return false;
@@ -1382,16 +1550,16 @@ template<> bool JsonReader::GetOpt<Util::String>(Util::String & ret, const char*
 */
 template<> bool JsonReader::GetOpt<Util::Array<int>>(Util::Array<int> & target, const char* attr)
 {
-    const value_variant * node = this->GetChild(attr);
+    const Node* node = this->GetChild(attr);
 
     if (node)
     {
-        n_assert(node->is_array());
-        unsigned int count = node->size();
+        n_assert(node->IsArray());
+        unsigned int count = node->Size();
         target.Reserve(count);
         for (unsigned int i = 0; i < count; i++)
         {
-            target.Append(node->get_value_at_index(i).as_int32());
+            target.Append(node->At(i).AsInt());
         }
         return true;
     }
@@ -1403,16 +1571,16 @@ template<> bool JsonReader::GetOpt<Util::Array<int>>(Util::Array<int> & target,
 */
 template<> bool JsonReader::GetOpt<Util::Array<uint32_t>>(Util::Array<uint32_t> & target, const char* attr)
 {
-    const value_variant * node = this->GetChild(attr);
+    const Node* node = this->GetChild(attr);
 
     if (node)
     {
-        n_assert(node->is_array());
-        unsigned int count = node->size();
+        n_assert(node->IsArray());
+        unsigned int count = node->Size();
         target.Reserve(count);
         for (unsigned int i = 0; i < count; i++)
         {
-            target.Append(node->get_value_at_index(i).as_int32());
+            target.Append(node->At(i).AsInt());
         }
         return true;
     }
@@ -1424,16 +1592,16 @@ template<> bool JsonReader::GetOpt<Util::Array<uint32_t>>(Util::Array<uint32_t>
 */
 template<> bool JsonReader::GetOpt<Util::Array<float>>(Util::Array<float> & target, const char* attr)
 {
-    const value_variant * node = this->GetChild(attr);
+    const Node* node = this->GetChild(attr);
     
     if (node)
     {
-        n_assert(node->is_array());
-        unsigned int count = node->size();
+        n_assert(node->IsArray());
+        unsigned int count = node->Size();
         target.Reserve(count);
         for (unsigned int i = 0; i < count; i++)
         {
-            target.Append(node->get_value_at_index(i).as_float());
+            target.Append(node->At(i).AsFloat());
         }
         return true;
     }
@@ -1445,16 +1613,16 @@ template<> bool JsonReader::GetOpt<Util::Array<float>>(Util::Array<float> & targ
 */
 template<> bool JsonReader::GetOpt<Util::Array<Util::String>>(Util::Array<Util::String> & target, const char* attr)
 {
-    const value_variant * node = this->GetChild(attr);
+    const Node* node = this->GetChild(attr);
 
     if (node)
     {
-        n_assert(node->is_array());
-        unsigned int count = node->size();
+        n_assert(node->IsArray());
+        unsigned int count = node->Size();
         target.Reserve(count);
         for (unsigned int i = 0; i < count; i++)
         {
-            target.Append(node->get_value_at_index(i).as_string_ptr());
+            target.Append(node->At(i).AsString());
         }
         return true;
     }
@@ -3,14 +3,20 @@
 /**
     @class IO::JsonReader
   
-    Reads json formatted data with random access from a stream using 
-    pjson as backend. The json document is represented as a tree of
-    nodes, which can be navigated and queried.
+    Reads json formatted data with random access from a stream. The json
+    document is represented as a tree of nodes, which can be navigated and
+    queried.
+
+    The tree is built with a JsonPullReader walking the mapped stream, so
+    the file is never copied into a buffer. Nodes are allocated from an
+    arena, with the children of each array or object stored next to each
+    other, and keys and strings are copied into the arena 0-terminated.
         
     @copyright
     (C) 2018-2020 Individual contributors, see AUTHORS file
 */
 #include "io/streamreader.h"
+#include "io/jsonpullreader.h"
 #include "math/vec4.h"
 #include "math/vec2.h"
 #include "math/mat4.h"
@@ -19,12 +25,8 @@
 #include "util/stringatom.h"
 #include "util/bitfield.h"
 #include "util/variant.h"
+#include "memory/arenaallocator.h"
 
-namespace pjson
-{
-    class value_variant;
-    class document;
-}
 //------------------------------------------------------------------------------
 namespace IO
 {
@@ -125,19 +127,277 @@ public:
     /// generic getter for optional items
     template<typename T> bool GetOpt(T& target, const char* attr, const T& _default);
 
+    /// a value in the document
+    struct Node
+    {
+        enum Type : uint8_t
+        {
+            NullType,
+            BoolType,
+            IntType,
+            DoubleType,
+            StringType,
+            ArrayType,
+            ObjectType
+        };
+
+        Type type;
+        /// number of children of an array or object
+        uint32_t size;
+        /// key of the node in its parent object, nullptr in arrays
+        const char* key;
+        union
+        {
+            bool b;
+            int64_t i;
+            double d;
+            const char* str;
+            const Node* children;
+        };
+
+        /// return true if the node is an object
+        bool IsObject() const;
+        /// return true if the node is an array
+        bool IsArray() const;
+        /// return true if the node is an array or object
+        bool IsObjectOrArray() const;
+        /// return true if the node is an array or object with at least one child
+        bool HasChildren() const;
+        /// return true if the node is a string
+        bool IsString() const;
+        /// return true if the node is true or false
+        bool IsBool() const;
+        /// return true if the node is a number without fraction or exponent
+        bool IsInt() const;
+        /// return true if the node is a number with fraction or exponent
+        bool IsDouble() const;
+        /// return true if the node is a number
+        bool IsNumeric() const;
+
+        /// get the value as bool
+        bool AsBool() const;
+        /// get the value as int
+        int AsInt() const;
+        /// get the value as 64 bit int
+        int64_t AsInt64() const;
+        /// get the value as float
+        float AsFloat() const;
+        /// get the value as double
+        double AsDouble() const;
+        /// get the value as 0-terminated string
+        const char* AsString() const;
+
+        /// get the number of children
+        SizeT Size() const;
+        /// get a child of an array or object
+        const Node& At(IndexT index) const;
+        /// get the key of a child of an object, an empty string in arrays
+        const char* KeyAt(IndexT index) const;
+        /// find the index of a child of an object by key, InvalidIndex if not found
+        IndexT FindIndex(const char* key) const;
+        /// find a child of an object by key, nullptr if not found
+        const Node* Find(const char* key) const;
+    };
+
 private:  
+    /// size of the arena chunks nodes and strings are allocated from
+    static const int ArenaChunkSize = 64 * 1024;
+
     ///
-    const pjson::value_variant* GetChild(const char * key = 0) const;
+    const Node* GetChild(const char * key = 0) const;
+    /// build the tree from a pull reader, returns nullptr on a parse error
+    const Node* Parse(JsonPullReader* reader);
+    /// copy a string into the arena, 0-terminated
+    const char* CopyString(const char* str, SizeT length);
        
-    pjson::document* document;
-    const pjson::value_variant* curNode;
+    const Node* document;
+    const Node* curNode;
     IndexT childIdx = -1;
-    Util::Stack<const pjson::value_variant*> parents;
+    Util::Stack<const Node*> parents;
     Util::Stack<IndexT> parentIdx;
-    // 0 terminated buffer containing the raw json file
-    char * buffer = nullptr;
+    Memory::ArenaAllocator<ArenaChunkSize> arena;
+    char* stringCur = nullptr;
+    char* stringEnd = nullptr;
 };
 
+//------------------------------------------------------------------------------
+/**
+*/
+inline bool
+JsonReader::Node::IsObject() const
+{
+    return this->type == ObjectType;
+}
+
+//------------------------------------------------------------------------------
+/**
+*/
+inline bool
+JsonReader::Node::IsArray() const
+{
+    return this->type == ArrayType;
+}
+
+//------------------------------------------------------------------------------
+/**
+*/
+inline bool
+JsonReader::Node::IsObjectOrArray() const
+{
+    return this->type == ObjectType || this->type == ArrayType;
+}
+
+//------------------------------------------------------------------------------
+/**
+*/
+inline bool
+JsonReader::Node::HasChildren() const
+{
+    return this->IsObjectOrArray() && this->size > 0;
+}
+
+//------------------------------------------------------------------------------
+/**
+*/
+inline bool
+JsonReader::Node::IsString() const
+{
+    return this->type == StringType;
+}
+
+//------------------------------------------------------------------------------
+/**
+*/
+inline bool
+JsonReader::Node::IsBool() const
+{
+    return this->type == BoolType;
+}
+
+//------------------------------------------------------------------------------
+/**
+*/
+inline bool
+JsonReader::Node::IsInt() const
+{
+    return this->type == IntType;
+}
+
+//------------------------------------------------------------------------------
+/**
+*/
+inline bool
+JsonReader::Node::IsDouble() const
+{
+    return this->type == DoubleType;
+}
+
+//------------------------------------------------------------------------------
+/**
+*/
+inline bool
+JsonReader::Node::IsNumeric() const
+{
+    return this->type == IntType || this->type == DoubleType;
+}
+
+//------------------------------------------------------------------------------
+/**
+*/
+inline bool
+JsonReader::Node::AsBool() const
+{
+    n_assert(this->type == BoolType);
+    return this->b;
+}
+
+//------------------------------------------------------------------------------
+/**
+*/
+inline int64_t
+JsonReader::Node::AsInt64() const
+{
+    n_assert(this->IsNumeric());
+    return this->type == IntType ? this->i : (int64_t)this->d;
+}
+
+//------------------------------------------------------------------------------
+/**
+*/
+inline int
+JsonReader::Node::AsInt() const
+{
+    return (int)this->AsInt64();
+}
+
+//------------------------------------------------------------------------------
+/**
+*/
+inline double
+JsonReader::Node::AsDouble() const
+{
+    n_assert(this->IsNumeric());
+    return this->type == DoubleType ? this->d : (double)this->i;
+}
+
+//------------------------------------------------------------------------------
+/**
+*/
+inline float
+JsonReader::Node::AsFloat() const
+{
+    return (float)this->AsDouble();
+}
+
+//------------------------------------------------------------------------------
+/**
+*/
+inline const char*
+JsonReader::Node::AsString() const
+{
+    n_assert(this->type == StringType);
+    return this->str;
+}
+
+//------------------------------------------------------------------------------
+/**
+*/
+inline SizeT
+JsonReader::Node::Size() const
+{
+    return this->IsObjectOrArray() ? (SizeT)this->size : 0;
+}
+
+//------------------------------------------------------------------------------
+/**
+*/
+inline const JsonReader::Node&
+JsonReader::Node::At(IndexT index) const
+{
+    n_assert(this->IsObjectOrArray() && index >= 0 && index < (IndexT)this->size);
+    return this->children[index];
+}
+
+//------------------------------------------------------------------------------
+/**
+*/
+inline const char*
+JsonReader::Node::KeyAt(IndexT index) const
+{
+    const char* key = this->At(index).key;
+    return key != nullptr ? key : "";
+}
+
+//------------------------------------------------------------------------------
+/**
+*/
+inline const JsonReader::Node*
+JsonReader::Node::Find(const char* key) const
+{
+    IndexT const index = this->FindIndex(key);
+    return index != InvalidIndex ? &this->children[index] : nullptr;
+}
+
 template<> void JsonReader::Get<bool>(bool& ret, const char* attr);
 template<> void JsonReader::Get<Util::Array<uint32_t>>(Util::Array<uint32_t>& ret, const char* attr);
 template<> void JsonReader::Get<Util::Array<int>>(Util::Array<int>& ret, const char* attr);
@@ -0,0 +1,119 @@
+//------------------------------------------------------------------------------
+//  mappedview.cc
+//  (C) 2024 Individual contributors, see AUTHORS file
+//------------------------------------------------------------------------------
+
+#include "io/mappedview.h"
+#include "io/filestream.h"
+
+namespace IO
+{
+__ImplementClass(IO::MappedView, 'MPVW', Core::RefCounted);
+
+//------------------------------------------------------------------------------
+/**
+*/
+MappedView::MappedView() :
+    mapHandle(nullptr),
+    ptr(nullptr),
+    size(0),
+    memoryMapped(false),
+    detached(false)
+{
+    // empty
+}
+
+//------------------------------------------------------------------------------
+/**
+*/
+MappedView::~MappedView()
+{
+    if (this->IsValid())
+    {
+        this->Discard();
+    }
+}
+
+//------------------------------------------------------------------------------
+/**
+    Streams which don't implement memory mapping return a null pointer from
+    Stream::MemoryMap(), these are mapped through Map() instead. The mapping
+    of a file stream is detached from it, so the view doesn't keep the file
+    open.
+*/
+bool
+MappedView::Setup(const Ptr<Stream>& s)
+{
+    n_assert(!this->IsValid());
+    n_assert(s->IsOpen());
+    n_assert(!s->IsMapped());
+    if (!s->CanBeMapped() || s->GetSize() == 0)
+    {
+        return false;
+    }
+
+    if (s->IsA(FileStream::RTTI))
+    {
+        FileStream* file = (FileStream*)s.get();
+        void* p = file->MemoryMap();
+        n_assert(p != nullptr);
+        this->mapHandle = file->DetachMemoryMap();
+        this->detached = true;
+        this->ptr = (const unsigned char*)p;
+        this->size = s->GetSize();
+        return true;
+    }
+
+    this->memoryMapped = true;
+    void* p = s->MemoryMap();
+    if (p == nullptr)
+    {
+        s->MemoryUnmap();
+        this->memoryMapped = false;
+        p = s->Map();
+    }
+    if (p == nullptr)
+    {
+        s->Unmap();
+        return false;
+    }
+    this->stream = s;
+    this->ptr = (const unsigned char*)p;
+    this->size = s->GetSize();
+    return true;
+}
+
+//------------------------------------------------------------------------------
+/**
+*/
+void
+MappedView::Discard()
+{
+    n_assert(this->IsValid());
+    if (this->detached)
+    {
+        FSWrapper::Unmap(this->mapHandle, (char*)this->ptr);
+        this->mapHandle = nullptr;
+        this->detached = false;
+        this->ptr = nullptr;
+        this->size = 0;
+        return;
+    }
+    if (this->memoryMapped)
+    {
+        this->stream->MemoryUnmap();
+    }
+    else
+    {
+        this->stream->Unmap();
+    }
+    if (this->stream->GetRefCount() == 1 && this->stream->IsOpen())
+    {
+        this->stream->Close();
+    }
+    this->stream = nullptr;
+    this->ptr = nullptr;
+    this->size = 0;
+}
+
+} // namespace IO
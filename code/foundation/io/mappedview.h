@@ -0,0 +1,123 @@
+#pragma once
+//------------------------------------------------------------------------------
+/**
+    @class IO::MappedView
+
+    A reference counted, read-only mapping of the whole content of a stream.
+
+    Loaders which keep immutable data like animation keys can point directly
+    into the view instead of copying the data into their own allocations, the
+    content stays mapped until the last reference is gone.
+
+    File streams are memory mapped and the view takes over the mapping, so
+    the stream can be closed right away and no file handle is held by the
+    view. Other streams which support memory mapping (stored pack entries)
+    and streams falling back to Stream::Map() only stay mapped while open,
+    the view keeps a reference to those.
+
+    @copyright
+    (C) 2024 Individual contributors, see AUTHORS file
+*/
+#include "core/refcounted.h"
+#include "io/stream.h"
+#include "io/fswrapper.h"
+
+//------------------------------------------------------------------------------
+namespace IO
+{
+class MappedView : public Core::RefCounted
+{
+    __DeclareClass(MappedView);
+public:
+    /// constructor
+    MappedView();
+    /// destructor
+    virtual ~MappedView();
+
+    /// map an open stream, the view keeps a reference to the stream unless it could take over the mapping
+    bool Setup(const Ptr<Stream>& stream);
+    /// unmap, closes a referenced stream if the view held the last reference
+    void Discard();
+    /// return true if the view is mapped
+    bool IsValid() const;
+
+    /// get pointer to the start of the content
+    const void* GetPointer() const;
+    /// get typed pointer at a byte offset
+    template <typename TYPE> const TYPE* At(Stream::Size offset) const;
+    /// get size of the content in bytes
+    Stream::Size GetSize() const;
+    /// return true if a range of memory lies within the view
+    bool Contains(const void* ptr, Stream::Size numBytes) const;
+    /// get the mapped stream, invalid if the view owns the mapping itself
+    const Ptr<Stream>& GetStream() const;
+
+private:
+    Ptr<Stream> stream;
+    /// mapping taken over from a file stream
+    FSWrapper::Handle mapHandle;
+    const unsigned char* ptr;
+    Stream::Size size;
+    bool memoryMapped;
+    bool detached;
+};
+
+//------------------------------------------------------------------------------
+/**
+*/
+inline bool
+MappedView::IsValid() const
+{
+    return this->ptr != nullptr;
+}
+
+//------------------------------------------------------------------------------
+/**
+*/
+inline const void*
+MappedView::GetPointer() const
+{
+    return this->ptr;
+}
+
+//------------------------------------------------------------------------------
+/**
+*/
+template <typename TYPE>
+inline const TYPE*
+MappedView::At(Stream::Size offset) const
+{
+    n_assert(offset >= 0 && offset <= this->size);
+    return (const TYPE*)(this->ptr + offset);
+}
+
+//------------------------------------------------------------------------------
+/**
+*/
+inline Stream::Size
+MappedView::GetSize() const
+{
+    return this->size;
+}
+
+//------------------------------------------------------------------------------
+/**
+*/
+inline bool
+MappedView::Contains(const void* p, Stream::Size numBytes) const
+{
+    const unsigned char* c = (const unsigned char*)p;
+    return c >= this->ptr && numBytes >= 0 && c + numBytes <= this->ptr + this->size;
+}
+
+//------------------------------------------------------------------------------
+/**
+*/
+inline const Ptr<Stream>&
+MappedView::GetStream() const
+{
+    return this->stream;
+}
+
+} // namespace IO
+//------------------------------------------------------------------------------
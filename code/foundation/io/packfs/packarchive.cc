@@ -0,0 +1,464 @@
+//------------------------------------------------------------------------------
+//  packarchive.cc
+//  (C) 2024 Individual contributors, see AUTHORS file
+//------------------------------------------------------------------------------
+
+#include "io/packfs/packarchive.h"
+#include "io/assignregistry.h"
+#include "math/scalar.h"
+#include "zlib/zlib.h"
+
+namespace IO
+{
+__ImplementClass(IO::PackArchive, 'PKAR', IO::ArchiveBase);
+
+using namespace Util;
+
+//------------------------------------------------------------------------------
+/**
+*/
+PackArchive::PackArchive() :
+    base(nullptr),
+    fileSize(0),
+    header(nullptr),
+    entries(nullptr),
+    buckets(nullptr),
+    blocks(nullptr),
+    names(nullptr)
+{
+    // empty
+}
+
+//------------------------------------------------------------------------------
+/**
+*/
+PackArchive::~PackArchive()
+{
+    if (this->IsValid())
+    {
+        this->Discard();
+    }
+}
+
+//------------------------------------------------------------------------------
+/**
+    Maps the pack file and builds the directory tree. The root location
+    of the archive is handled like in ZipArchive.
+*/
+bool
+PackArchive::Setup(const URI& packFileURI, const String& rootPathOverride)
+{
+    n_assert(!this->IsValid());
+    n_assert(!this->file.isvalid());
+
+    if (!ArchiveBase::Setup(packFileURI, rootPathOverride))
+    {
+        return false;
+    }
+
+    // extract the root location of the archive
+    if (!rootPathOverride.IsEmpty())
+    {
+        this->rootPath = AssignRegistry::Instance()->ResolveAssigns(rootPathOverride).LocalPath() + "/";
+    }
+    else
+    {
+        this->rootPath = this->uri.LocalPath().ExtractDirName();
+    }
+
+    // map the whole pack file, it stays mapped until the archive is discarded
+    URI absPath = AssignRegistry::Instance()->ResolveAssigns(this->uri);
+    this->file = FileStream::Create();
+    this->file->SetURI(URI(absPath.AsString() + ".pack"));
+    this->file->SetAccessMode(Stream::ReadAccess);
+    this->file->SetAccessPattern(Stream::Random);
+    if (!this->file->Open())
+    {
+        this->file = nullptr;
+        return false;
+    }
+    this->fileSize = this->file->GetSize();
+    if (this->fileSize < (Stream::Size)sizeof(Pack::Header))
+    {
+        n_warning("PackArchive::Setup(): '%s' is not a pack file!\n", absPath.AsString().AsCharPtr());
+        this->file->Close();
+        this->file = nullptr;
+        return false;
+    }
+    this->base = (const uint8_t*)this->file->MemoryMap();
+    this->header = (const Pack::Header*)this->base;
+    if (!this->ValidateTables())
+    {
+        n_warning("PackArchive::Setup(): '%s' is not a valid pack file!\n", absPath.AsString().AsCharPtr());
+        this->file->MemoryUnmap();
+        this->file->Close();
+        this->file = nullptr;
+        this->base = nullptr;
+        this->header = nullptr;
+        return false;
+    }
+    this->entries = (const Pack::Entry*)(this->base + this->header->entriesOffset);
+    this->buckets = (const uint32_t*)(this->base + this->header->bucketsOffset);
+    this->blocks = (const Pack::Block*)(this->base + this->header->blocksOffset);
+    this->names = (const char*)(this->base + this->header->namesOffset);
+
+    this->BuildDirectories();
+    return true;
+}
+
+//------------------------------------------------------------------------------
+/**
+*/
+void
+PackArchive::Discard()
+{
+    n_assert(this->IsValid());
+    if (this->file.isvalid())
+    {
+        this->file->MemoryUnmap();
+        this->file->Close();
+        this->file = nullptr;
+    }
+    this->base = nullptr;
+    this->fileSize = 0;
+    this->header = nullptr;
+    this->entries = nullptr;
+    this->buckets = nullptr;
+    this->blocks = nullptr;
+    this->names = nullptr;
+    this->directories.Clear();
+    ArchiveBase::Discard();
+}
+
+//------------------------------------------------------------------------------
+/**
+    Checks the header and makes sure that all tables and entries lie inside
+    the file, so that lookups and reads never have to.
+*/
+bool
+PackArchive::ValidateTables() const
+{
+    const Pack::Header* h = this->header;
+    if (h->magic != Pack::Magic || h->version != Pack::Version)
+        return false;
+    if (h->numBuckets == 0 || (h->numBuckets & (h->numBuckets - 1)) != 0)
+        return false;
+
+    uint64_t const size = (uint64_t)this->fileSize;
+    if (h->entriesOffset + (uint64_t)h->numEntries * sizeof(Pack::Entry) > size
+        || h->bucketsOffset + (uint64_t)h->numBuckets * sizeof(uint32_t) > size
+        || h->blocksOffset + (uint64_t)h->numBlocks * sizeof(Pack::Block) > size
+        || h->namesOffset + h->namesSize > size)
+    {
+        return false;
+    }
+
+    const Pack::Entry* entryTable = (const Pack::Entry*)(this->base + h->entriesOffset);
+    const uint32_t* bucketTable = (const uint32_t*)(this->base + h->bucketsOffset);
+    const Pack::Block* blockTable = (const Pack::Block*)(this->base + h->blocksOffset);
+    for (uint32_t i = 0; i < h->numBuckets; i++)
+    {
+        if (bucketTable[i] != Pack::InvalidEntry && bucketTable[i] >= h->numEntries)
+            return false;
+    }
+    for (uint32_t i = 0; i < h->numEntries; i++)
+    {
+        const Pack::Entry& entry = entryTable[i];
+        if (entry.nextInBucket != Pack::InvalidEntry && entry.nextInBucket >= h->numEntries)
+            return false;
+        if ((uint64_t)entry.nameOffset + entry.nameLength > h->namesSize)
+            return false;
+        if (entry.dataOffset + entry.storedSize > size)
+            return false;
+        if (entry.codec == Pack::Stored)
+        {
+            if (entry.storedSize != entry.size)
+                return false;
+        }
+        else if (entry.codec == Pack::Zlib)
+        {
+            uint64_t const numBlocks = (entry.size + Pack::BlockSize - 1) / Pack::BlockSize;
+            if (entry.numBlocks != numBlocks || (uint64_t)entry.firstBlock + entry.numBlocks > h->numBlocks)
+                return false;
+            for (uint32_t j = 0; j < entry.numBlocks; j++)
+            {
+                const Pack::Block& block = blockTable[entry.firstBlock + j];
+                if (block.offset + block.compressedSize > entry.storedSize)
+                    return false;
+            }
+        }
+        else
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+//------------------------------------------------------------------------------
+/**
+*/
+String
+PackArchive::NormalizePath(const String& path)
+{
+    String result = path;
+    result.ConvertBackslashes();
+    result.TrimRight("/");
+    return result;
+}
+
+//------------------------------------------------------------------------------
+/**
+    The root directory has the empty path.
+*/
+PackArchive::Directory&
+PackArchive::AddDirectory(const String& dirPath)
+{
+    IndexT index = this->directories.FindIndex(dirPath);
+    if (index != InvalidIndex)
+    {
+        return this->directories.ValueAtIndex(index);
+    }
+
+    if (dirPath.IsValid())
+    {
+        // link into the parent first, adding the parent may move other directories
+        const char* lastSlash = strrchr(dirPath.AsCharPtr(), '/');
+        if (lastSlash != nullptr)
+        {
+            String parentPath;
+            parentPath.Set(dirPath.AsCharPtr(), SizeT(lastSlash - dirPath.AsCharPtr()));
+            this->AddDirectory(parentPath).dirs.Append(lastSlash + 1);
+        }
+        else
+        {
+            this->AddDirectory("").dirs.Append(dirPath);
+        }
+    }
+    return this->directories.ValueAtIndex(this->directories.Add(dirPath, Directory()));
+}
+
+//------------------------------------------------------------------------------
+/**
+*/
+void
+PackArchive::BuildDirectories()
+{
+    this->AddDirectory("");
+    for (uint32_t i = 0; i < this->header->numEntries; i++)
+    {
+        const Pack::Entry& entry = this->entries[i];
+        const char* name = this->names + entry.nameOffset;
+
+        // find the last slash within the name, names are not null terminated
+        IndexT lastSlash = InvalidIndex;
+        for (IndexT c = SizeT(entry.nameLength) - 1; c >= 0; c--)
+        {
+            if (name[c] == '/')
+            {
+                lastSlash = c;
+                break;
+            }
+        }
+
+        String dirPath;
+        String fileName;
+        if (lastSlash != InvalidIndex)
+        {
+            dirPath.Set(name, lastSlash);
+            fileName.Set(name + lastSlash + 1, SizeT(entry.nameLength) - lastSlash - 1);
+        }
+        else
+        {
+            fileName.Set(name, SizeT(entry.nameLength));
+        }
+        this->AddDirectory(dirPath).files.Append(fileName);
+    }
+}
+
+//------------------------------------------------------------------------------
+/**
+    Test if an absolute path points into the archive and return the local
+    path in the archive, same as ZipArchive::ConvertToPathInArchive().
+*/
+String
+PackArchive::ConvertToPathInArchive(const String& absPath) const
+{
+    IndexT rootPathIndex = absPath.FindStringIndex(this->rootPath, 0);
+    if (0 == rootPathIndex)
+    {
+        String localPath = absPath;
+        localPath.SubstituteString(this->rootPath, "");
+        return localPath;
+    }
+    return "";
+}
+
+//------------------------------------------------------------------------------
+/**
+    Lock-free, the tables are never modified after Setup.
+*/
+const Pack::Entry*
+PackArchive::FindEntry(const String& pathInArchive) const
+{
+    n_assert(this->IsValid());
+    String path = NormalizePath(pathInArchive);
+    uint64_t const hash = Pack::HashPath(path.AsCharPtr(), path.Length());
+    uint32_t index = this->buckets[hash & (this->header->numBuckets - 1)];
+    while (index != Pack::InvalidEntry)
+    {
+        const Pack::Entry& entry = this->entries[index];
+        if (entry.hash == hash
+            && entry.nameLength == (uint32_t)path.Length()
+            && 0 == memcmp(this->names + entry.nameOffset, path.AsCharPtr(), entry.nameLength))
+        {
+            return &entry;
+        }
+        index = entry.nextInBucket;
+    }
+    return nullptr;
+}
+
+//------------------------------------------------------------------------------
+/**
+*/
+bool
+PackArchive::HasFile(const String& pathInArchive) const
+{
+    return nullptr != this->FindEntry(pathInArchive);
+}
+
+//------------------------------------------------------------------------------
+/**
+*/
+bool
+PackArchive::HasDirectory(const String& pathInArchive) const
+{
+    String path = NormalizePath(pathInArchive);
+    return path.IsValid() && this->directories.Contains(path);
+}
+
+//------------------------------------------------------------------------------
+/**
+*/
+const void*
+PackArchive::GetEntryData(const Pack::Entry* entry) const
+{
+    n_assert(nullptr != entry);
+    if (entry->codec != Pack::Stored)
+    {
+        return nullptr;
+    }
+    return this->base + entry->dataOffset;
+}
+
+//------------------------------------------------------------------------------
+/**
+    Blocks are independent, so this needs no state besides the mapping and may
+    run on any number of threads at once.
+*/
+bool
+PackArchive::ReadEntry(const Pack::Entry* entry, void* buffer) const
+{
+    n_assert(nullptr != entry);
+    n_assert(nullptr != buffer);
+    const uint8_t* data = this->base + entry->dataOffset;
+    if (entry->codec == Pack::Stored)
+    {
+        Memory::Copy(data, buffer, (size_t)entry->size);
+        return true;
+    }
+
+    n_assert(entry->codec == Pack::Zlib);
+    uint8_t* dst = (uint8_t*)buffer;
+    for (uint32_t i = 0; i < entry->numBlocks; i++)
+    {
+        const Pack::Block& block = this->blocks[entry->firstBlock + i];
+        uint64_t const blockStart = (uint64_t)i * Pack::BlockSize;
+        uLongf const blockSize = (uLongf)Math::min<uint64_t>(Pack::BlockSize, entry->size - blockStart);
+        if (block.compressedSize == blockSize)
+        {
+            // didn't compress, stored as is
+            Memory::Copy(data + block.offset, dst + blockStart, blockSize);
+            continue;
+        }
+        uLongf destLen = blockSize;
+        if (Z_OK != uncompress(dst + blockStart, &destLen, data + block.offset, block.compressedSize) || destLen != blockSize)
+        {
+            n_warning("PackArchive::ReadEntry(): corrupt block %d in '%s'!\n", i, this->uri.AsString().AsCharPtr());
+            return false;
+        }
+    }
+    return true;
+}
+
+//------------------------------------------------------------------------------
+/**
+*/
+Array<String>
+PackArchive::ListFiles(const String& dirPathInArchive, const String& pattern) const
+{
+    Array<String> result;
+    IndexT index = this->directories.FindIndex(NormalizePath(dirPathInArchive));
+    if (index != InvalidIndex)
+    {
+        const Array<String>& files = this->directories.ValueAtIndex(index).files;
+        for (IndexT i = 0; i < files.Size(); i++)
+        {
+            if (String::MatchPattern(files[i], pattern))
+            {
+                result.Append(files[i]);
+            }
+        }
+    }
+    return result;
+}
+
+//------------------------------------------------------------------------------
+/**
+*/
+Array<String>
+PackArchive::ListDirectories(const String& dirPathInArchive, const String& pattern) const
+{
+    Array<String> result;
+    IndexT index = this->directories.FindIndex(NormalizePath(dirPathInArchive));
+    if (index != InvalidIndex)
+    {
+        const Array<String>& dirs = this->directories.ValueAtIndex(index).dirs;
+        for (IndexT i = 0; i < dirs.Size(); i++)
+        {
+            if (String::MatchPattern(dirs[i], pattern))
+            {
+                result.Append(dirs[i]);
+            }
+        }
+    }
+    return result;
+}
+
+//------------------------------------------------------------------------------
+/**
+    Converts a "file:" URI into a "pack:" URI pointing to the file in this
+    archive. The path in the archive is stored in the query, like for zip
+    archives.
+*/
+URI
+PackArchive::ConvertToArchiveURI(const URI& fileURI) const
+{
+    String localPath = this->ConvertToPathInArchive(fileURI.LocalPath());
+    if (!localPath.IsValid())
+    {
+        n_error("PackArchive::ConvertToArchiveURI(): file '%s' doesn't point into this pack archive (%s)!\n",
+            fileURI.AsString().AsCharPtr(), this->uri.AsString().AsCharPtr());
+    }
+
+    URI packURI = this->uri;
+    packURI.SetScheme("pack");
+    String query;
+    query.Append("file=");
+    query.Append(localPath);
+    packURI.SetQuery(query);
+    return packURI;
+}
+
+} // namespace IO
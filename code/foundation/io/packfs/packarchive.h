@@ -0,0 +1,107 @@
+#pragma once
+//------------------------------------------------------------------------------
+/**
+    @class IO::PackArchive
+
+    A mounted pack archive, see packformat.h for the file layout.
+
+    The whole pack file is memory mapped when the archive is set up, and the
+    table of contents is used directly from the mapping. Entry lookups hash the
+    path and walk a single bucket chain, the directory tree for listing files
+    and directories is built once at mount time.
+
+    Multithreading: unlike ZipArchive, a pack archive is never modified after
+    Setup, so any number of threads may look up and read entries at the same
+    time without locking. Stored entries can be accessed in place through
+    GetEntryData, compressed entries are decompressed block by block straight
+    into the caller's buffer.
+
+    Pack files are created with the -pack mode of the archiver tool, or
+    directly through IO::PackWriter.
+
+    @copyright
+    (C) 2024 Individual contributors, see AUTHORS file
+*/
+#include "io/archfs/archivebase.h"
+#include "io/packfs/packformat.h"
+#include "io/filestream.h"
+#include "util/dictionary.h"
+
+//------------------------------------------------------------------------------
+namespace IO
+{
+class PackArchive : public ArchiveBase
+{
+    __DeclareClass(PackArchive);
+public:
+    /// constructor
+    PackArchive();
+    /// destructor
+    virtual ~PackArchive();
+
+    /// setup the archive from an URI (without file extension)
+    bool Setup(const URI& uri, const Util::String& rootPath = "") override;
+    /// discard the archive
+    void Discard() override;
+
+    /// list all files in a directory in the archive
+    Util::Array<Util::String> ListFiles(const Util::String& dirPathInArchive, const Util::String& pattern) const override;
+    /// list all subdirectories in a directory in the archive
+    Util::Array<Util::String> ListDirectories(const Util::String& dirPathInArchive, const Util::String& pattern) const override;
+    /// convert a "file:" URI into a "pack:" URI pointing into this archive
+    URI ConvertToArchiveURI(const URI& fileURI) const override;
+    /// convert an absolute path to local path inside archive, returns empty string if absPath doesn't point into this archive
+    Util::String ConvertToPathInArchive(const Util::String& absPath) const override;
+    /// return true if the archive contains a file
+    bool HasFile(const Util::String& pathInArchive) const override;
+    /// return true if the archive contains a directory
+    bool HasDirectory(const Util::String& pathInArchive) const override;
+
+    /// get the number of entries in the archive
+    SizeT GetNumEntries() const;
+    /// find an entry by its path in the archive, returns nullptr if not found
+    const Pack::Entry* FindEntry(const Util::String& pathInArchive) const;
+    /// get the data of a stored entry directly from the mapping, returns nullptr for compressed entries
+    const void* GetEntryData(const Pack::Entry* entry) const;
+    /// read and decompress the whole entry into a buffer of at least entry->size bytes
+    bool ReadEntry(const Pack::Entry* entry, void* buffer) const;
+
+private:
+    struct Directory
+    {
+        Util::Array<Util::String> files;
+        Util::Array<Util::String> dirs;
+    };
+
+    /// check that the mapped header and tables are sane
+    bool ValidateTables() const;
+    /// build the directory tree from the entry paths
+    void BuildDirectories();
+    /// get the directory of a path, creating it and its parents on the way
+    Directory& AddDirectory(const Util::String& dirPath);
+    /// normalize a path in the archive to forward slashes without a trailing slash
+    static Util::String NormalizePath(const Util::String& path);
+
+    Util::String rootPath;
+    Ptr<FileStream> file;
+    const uint8_t* base;
+    Stream::Size fileSize;
+    const Pack::Header* header;
+    const Pack::Entry* entries;
+    const uint32_t* buckets;
+    const Pack::Block* blocks;
+    const char* names;
+    Util::Dictionary<Util::String, Directory> directories;
+};
+
+//------------------------------------------------------------------------------
+/**
+*/
+inline SizeT
+PackArchive::GetNumEntries() const
+{
+    return this->header != nullptr ? this->header->numEntries : 0;
+}
+
+} // namespace IO
+//------------------------------------------------------------------------------
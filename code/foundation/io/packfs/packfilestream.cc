@@ -0,0 +1,272 @@
+//------------------------------------------------------------------------------
+//  packfilestream.cc
+//  (C) 2024 Individual contributors, see AUTHORS file
+//------------------------------------------------------------------------------
+
+#include "io/packfs/packfilestream.h"
+#include "io/packfs/packarchive.h"
+#include "io/archfs/archivefilesystembase.h"
+#include "math/scalar.h"
+
+namespace IO
+{
+__ImplementClass(IO::PackFileStream, 'PKFS', IO::Stream);
+
+using namespace Util;
+
+//------------------------------------------------------------------------------
+/**
+*/
+PackFileStream::PackFileStream() :
+    size(0),
+    position(0),
+    data(nullptr),
+    buffer(nullptr)
+{
+    // empty
+}
+
+//------------------------------------------------------------------------------
+/**
+*/
+PackFileStream::~PackFileStream()
+{
+    if (this->IsOpen())
+    {
+        this->Close();
+    }
+    n_assert(nullptr == this->buffer);
+}
+
+//------------------------------------------------------------------------------
+/**
+*/
+bool
+PackFileStream::CanRead() const
+{
+    return true;
+}
+
+//------------------------------------------------------------------------------
+/**
+*/
+bool
+PackFileStream::CanWrite() const
+{
+    return false;
+}
+
+//------------------------------------------------------------------------------
+/**
+*/
+bool
+PackFileStream::CanSeek() const
+{
+    return true;
+}
+
+//------------------------------------------------------------------------------
+/**
+*/
+bool
+PackFileStream::CanBeMapped() const
+{
+    return true;
+}
+
+//------------------------------------------------------------------------------
+/**
+*/
+Stream::Size
+PackFileStream::GetSize() const
+{
+    return this->size;
+}
+
+//------------------------------------------------------------------------------
+/**
+*/
+Stream::Position
+PackFileStream::GetPosition() const
+{
+    return this->position;
+}
+
+//------------------------------------------------------------------------------
+/**
+    Open the stream for reading. Stored entries are used in place, compressed
+    entries are decompressed into memory here.
+*/
+bool
+PackFileStream::Open()
+{
+    n_assert(!this->IsOpen());
+    n_assert(nullptr == this->buffer);
+    if (ReadAccess != this->accessMode)
+    {
+        return false;
+    }
+    if (!Stream::Open())
+    {
+        return false;
+    }
+
+    Ptr<ArchiveBase> archiveBase = ArchiveFileSystemBase::Instance()->FindArchive(this->uri);
+    if (archiveBase.isvalid() && archiveBase->IsA(PackArchive::RTTI))
+    {
+        this->archive = archiveBase.downcast<PackArchive>();
+        Dictionary<String, String> params = this->uri.ParseQuery();
+        if (params.Contains("file"))
+        {
+            const Pack::Entry* entry = this->archive->FindEntry(params["file"]);
+            if (nullptr != entry)
+            {
+                this->size = (Size)entry->size;
+                this->position = 0;
+                this->data = (const unsigned char*)this->archive->GetEntryData(entry);
+                if (nullptr != this->data)
+                {
+                    return true;
+                }
+
+                this->buffer = (unsigned char*)Memory::Alloc(Memory::StreamDataHeap, this->size);
+                if (this->archive->ReadEntry(entry, this->buffer))
+                {
+                    this->data = this->buffer;
+                    return true;
+                }
+            }
+        }
+    }
+
+    // fallthrough: failure
+    this->Close();
+    return false;
+}
+
+//------------------------------------------------------------------------------
+/**
+*/
+void
+PackFileStream::Close()
+{
+    n_assert(this->IsOpen());
+    if (this->IsMapped())
+    {
+        this->Unmap();
+    }
+    if (nullptr != this->buffer)
+    {
+        Memory::Free(Memory::StreamDataHeap, this->buffer);
+        this->buffer = nullptr;
+    }
+    this->data = nullptr;
+    this->archive = nullptr;
+    Stream::Close();
+    this->size = 0;
+    this->position = 0;
+}
+
+//------------------------------------------------------------------------------
+/**
+*/
+Stream::Size
+PackFileStream::Read(void* ptr, Size numBytes)
+{
+    n_assert(ptr);
+    n_assert(this->IsOpen());
+    n_assert(ReadAccess == this->accessMode);
+    n_assert((this->position >= 0) && (this->position <= this->size));
+
+    Size readBytes = Math::min(numBytes, this->size - this->position);
+    if (readBytes > 0)
+    {
+        Memory::Copy(this->data + this->position, ptr, readBytes);
+        this->position += readBytes;
+    }
+    return readBytes;
+}
+
+//------------------------------------------------------------------------------
+/**
+*/
+void
+PackFileStream::Seek(Offset offset, SeekOrigin origin)
+{
+    n_assert(this->IsOpen());
+    n_assert(!this->IsMapped());
+    n_assert((this->position >= 0) && (this->position <= this->size));
+
+    switch (origin)
+    {
+        case Begin:
+            this->position = offset;
+            break;
+        case Current:
+            this->position += offset;
+            break;
+        case End:
+            this->position = this->size + offset;
+            break;
+        default:
+            n_assert(false);
+    }
+
+    // make sure read position doesn't become invalid
+    this->position = Math::clamp(this->position, (Stream::Size)0, this->size);
+}
+
+//------------------------------------------------------------------------------
+/**
+*/
+bool
+PackFileStream::Eof() const
+{
+    n_assert(this->IsOpen());
+    n_assert((this->position >= 0) && (this->position <= this->size));
+    return (this->position == this->size);
+}
+
+//------------------------------------------------------------------------------
+/**
+    The returned memory is read-only for stored entries, since it points
+    into the mapped pack file.
+*/
+void*
+PackFileStream::Map()
+{
+    n_assert(this->IsOpen());
+    n_assert(nullptr != this->data);
+    Stream::Map();
+    return (void*)this->data;
+}
+
+//------------------------------------------------------------------------------
+/**
+*/
+void
+PackFileStream::Unmap()
+{
+    n_assert(this->IsOpen());
+    Stream::Unmap();
+}
+
+//------------------------------------------------------------------------------
+/**
+*/
+void*
+PackFileStream::MemoryMap()
+{
+    return this->Map();
+}
+
+//------------------------------------------------------------------------------
+/**
+*/
+void
+PackFileStream::MemoryUnmap()
+{
+    this->Unmap();
+}
+
+} // namespace IO
@@ -0,0 +1,82 @@
+#pragma once
+//------------------------------------------------------------------------------
+/**
+    @class IO::PackFileStream
+
+    Wraps a file in a pack archive into a read-only stream.
+
+    Stored entries are read straight from the memory mapped pack file, so
+    opening them costs nothing but the table of contents lookup, and Map()
+    returns a pointer into the mapping. Compressed entries are decompressed
+    into a private buffer when the stream is opened, like with ZipFileStream.
+
+    As with zip archives, the IoServer transparently redirects "file:" URIs
+    into mounted pack archives. To force reading from a pack archive, use an
+    URI of the following format:
+
+    pack://[samba server]/bla/blob/archive?file=path/in/pack
+
+    The local path of the URI is the path of the pack file without the
+    .pack extension, the query contains the path of the file in the archive.
+
+    @copyright
+    (C) 2024 Individual contributors, see AUTHORS file
+*/
+#include "io/stream.h"
+
+//------------------------------------------------------------------------------
+namespace IO
+{
+class PackArchive;
+class PackFileStream : public Stream
+{
+    __DeclareClass(PackFileStream);
+public:
+    /// constructor
+    PackFileStream();
+    /// destructor
+    virtual ~PackFileStream();
+    /// pack streams support reading
+    bool CanRead() const override;
+    /// pack streams don't support writing
+    bool CanWrite() const override;
+    /// pack streams support seeking
+    bool CanSeek() const override;
+    /// pack streams are mappable
+    bool CanBeMapped() const override;
+    /// get the size of the stream in bytes
+    Size GetSize() const override;
+    /// get the current position of the read cursor
+    Position GetPosition() const override;
+    /// open the stream
+    bool Open() override;
+    /// close the stream
+    void Close() override;
+    /// directly read from the stream
+    Size Read(void* ptr, Size numBytes) override;
+    /// seek in stream
+    void Seek(Offset offset, SeekOrigin origin) override;
+    /// return true if end-of-stream reached
+    bool Eof() const override;
+    /// map for direct memory-access
+    void* Map() override;
+    /// unmap a mapped stream
+    void Unmap() override;
+    /// map for direct memory-access, does nothing but call Map()
+    void* MemoryMap() override;
+    /// unmap memory stream
+    void MemoryUnmap() override;
+
+private:
+    /// keeps the mapping alive while the stream is open
+    Ptr<PackArchive> archive;
+    Size size;
+    Position position;
+    /// entry data, either inside the mapping or in buffer
+    const unsigned char* data;
+    /// decompressed data of compressed entries
+    unsigned char* buffer;
+};
+
+} // namespace IO
+//------------------------------------------------------------------------------
@@ -0,0 +1,119 @@
+#pragma once
+//------------------------------------------------------------------------------
+/**
+    @file packformat.h
+
+    On-disk layout of Nebula pack archives (.pack), the shipping alternative to zip.
+
+    A pack is meant to be memory mapped as a whole. All tables are plain arrays
+    that are used in place, and entry data starts on page boundaries. The
+    tables follow the data, so packs can be written in a single pass.
+
+        Header
+        ...                         entry data, each aligned to DataAlignment
+        Entry[numEntries]           in no particular order, chained into hash buckets
+        uint32_t[numBuckets]        first entry in each bucket
+        Block[numBlocks]            block tables of all compressed entries
+        char[namesSize]             entry paths, not null terminated
+
+    Paths are relative to the directory the archive is mounted in, use forward
+    slashes and are case sensitive, like the zip archive paths.
+
+    Compressed entries are split into blocks of BlockSize uncompressed bytes
+    that are compressed independently, so any block can be decompressed on its
+    own and blocks of one entry can be decompressed in parallel. A block whose
+    compressed size equals its uncompressed size is stored as is.
+
+    @copyright
+    (C) 2024 Individual contributors, see AUTHORS file
+*/
+#include "core/types.h"
+
+//------------------------------------------------------------------------------
+namespace IO
+{
+namespace Pack
+{
+
+/// 'NPAK'
+static const uint32_t Magic = 0x4E50414B;
+static const uint32_t Version = 1;
+/// alignment of entry data in the file, a page so entries can be mapped and read directly
+static const uint64_t DataAlignment = 4096;
+/// uncompressed size of a compression block
+static const uint32_t BlockSize = 64 * 1024;
+/// end of a bucket chain
+static const uint32_t InvalidEntry = 0xFFFFFFFF;
+
+enum Codec : uint8_t
+{
+    /// uncompressed, entry data can be used straight from the mapping
+    Stored = 0,
+    /// independent zlib blocks
+    Zlib = 1,
+};
+
+struct Header
+{
+    uint32_t magic;
+    uint32_t version;
+    uint32_t numEntries;
+    /// number of hash buckets, a power of two
+    uint32_t numBuckets;
+    uint32_t numBlocks;
+    uint32_t pad;
+    uint64_t entriesOffset;
+    uint64_t bucketsOffset;
+    uint64_t blocksOffset;
+    uint64_t namesOffset;
+    uint64_t namesSize;
+};
+
+struct Entry
+{
+    /// hash of the path, see HashPath
+    uint64_t hash;
+    /// next entry in the same hash bucket
+    uint32_t nextInBucket;
+    uint32_t nameOffset;
+    uint32_t nameLength;
+    uint8_t codec;
+    uint8_t pad[3];
+    /// offset of the entry data in the file
+    uint64_t dataOffset;
+    /// uncompressed size
+    uint64_t size;
+    /// size of the entry data in the file
+    uint64_t storedSize;
+    /// first block in the block table, compressed entries only
+    uint32_t firstBlock;
+    uint32_t numBlocks;
+};
+
+struct Block
+{
+    /// offset relative to the entry data offset
+    uint64_t offset;
+    uint32_t compressedSize;
+    uint32_t pad;
+};
+
+//------------------------------------------------------------------------------
+/**
+    FNV-1a, fixed here since the value is stored in the file.
+*/
+inline uint64_t
+HashPath(const char* path, SizeT length)
+{
+    uint64_t hash = 0xCBF29CE484222325ull;
+    for (IndexT i = 0; i < length; i++)
+    {
+        hash ^= (uint8_t)path[i];
+        hash *= 0x100000001B3ull;
+    }
+    return hash;
+}
+
+} // namespace Pack
+} // namespace IO
+//------------------------------------------------------------------------------
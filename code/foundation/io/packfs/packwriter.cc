@@ -0,0 +1,240 @@
+//------------------------------------------------------------------------------
+//  packwriter.cc
+//  (C) 2024 Individual contributors, see AUTHORS file
+//------------------------------------------------------------------------------
+
+#include "io/packfs/packwriter.h"
+#include "io/ioserver.h"
+#include "math/scalar.h"
+#include "zlib/zlib.h"
+
+namespace IO
+{
+__ImplementClass(IO::PackWriter, 'PKWR', Core::RefCounted);
+
+using namespace Util;
+
+static const unsigned char ZeroPadding[Pack::DataAlignment] = { 0 };
+
+//------------------------------------------------------------------------------
+/**
+*/
+PackWriter::PackWriter() :
+    compressionLevel(Z_DEFAULT_COMPRESSION)
+{
+    // empty
+}
+
+//------------------------------------------------------------------------------
+/**
+*/
+PackWriter::~PackWriter()
+{
+    if (this->IsOpen())
+    {
+        this->Close();
+    }
+}
+
+//------------------------------------------------------------------------------
+/**
+    Reserves the first page for the header, which is written on Close().
+*/
+bool
+PackWriter::Open()
+{
+    n_assert(!this->IsOpen());
+    this->stream = IoServer::Instance()->CreateStream(this->uri);
+    this->stream->SetAccessMode(Stream::WriteAccess);
+    if (!this->stream->Open())
+    {
+        n_warning("PackWriter::Open(): failed to open '%s' for writing!\n", this->uri.AsString().AsCharPtr());
+        this->stream = nullptr;
+        return false;
+    }
+    this->stream->Write(ZeroPadding, Pack::DataAlignment);
+    this->compressBuffer.Resize((SizeT)compressBound(Pack::BlockSize));
+    return true;
+}
+
+//------------------------------------------------------------------------------
+/**
+*/
+void
+PackWriter::Align()
+{
+    Stream::Position const pos = this->stream->GetPosition();
+    Stream::Size const padding = (Stream::Size)((Pack::DataAlignment - (pos % Pack::DataAlignment)) % Pack::DataAlignment);
+    if (padding > 0)
+    {
+        this->stream->Write(ZeroPadding, padding);
+    }
+}
+
+//------------------------------------------------------------------------------
+/**
+    Compresses the file block by block and writes it out. The compressed
+    blocks of a file are collected first, since the file may end up being
+    stored uncompressed after all.
+*/
+bool
+PackWriter::AddFile(const String& pathInArchive, const void* data, SizeT size)
+{
+    n_assert(this->IsOpen());
+    n_assert(size == 0 || data != nullptr);
+
+    String path = pathInArchive;
+    path.ConvertBackslashes();
+    path.TrimLeft("/");
+    if (path.IsEmpty() || this->paths.Contains(path))
+    {
+        n_warning("PackWriter::AddFile(): invalid or duplicate path '%s'!\n", pathInArchive.AsCharPtr());
+        return false;
+    }
+
+    Pack::Entry entry;
+    Memory::Clear(&entry, sizeof(entry));
+    entry.hash = Pack::HashPath(path.AsCharPtr(), path.Length());
+    entry.nextInBucket = Pack::InvalidEntry;
+    entry.nameOffset = (uint32_t)this->names.Size();
+    entry.nameLength = (uint32_t)path.Length();
+    entry.size = (uint64_t)size;
+    entry.codec = Pack::Stored;
+    entry.storedSize = (uint64_t)size;
+
+    // compress into independent blocks
+    Array<unsigned char> compressed;
+    Array<Pack::Block> entryBlocks;
+    if (this->compressionLevel != 0 && size > 0)
+    {
+        const unsigned char* src = (const unsigned char*)data;
+        for (SizeT offset = 0; offset < size; offset += Pack::BlockSize)
+        {
+            uLong const blockSize = (uLong)Math::min<SizeT>(Pack::BlockSize, size - offset);
+            uLongf compressedSize = (uLongf)this->compressBuffer.Size();
+            Pack::Block block;
+            block.offset = (uint64_t)compressed.Size();
+            block.pad = 0;
+            if (Z_OK == compress2(this->compressBuffer.Begin(), &compressedSize, src + offset, blockSize, this->compressionLevel)
+                && compressedSize < blockSize)
+            {
+                block.compressedSize = (uint32_t)compressedSize;
+                compressed.AppendArray(this->compressBuffer.Begin(), (SizeT)compressedSize);
+            }
+            else
+            {
+                // incompressible block, store as is
+                block.compressedSize = (uint32_t)blockSize;
+                compressed.AppendArray(src + offset, (SizeT)blockSize);
+            }
+            entryBlocks.Append(block);
+        }
+
+        // only keep compressed files which save at least an eighth, stored files can be used in place
+        if (compressed.Size() < size - size / 8)
+        {
+            entry.codec = Pack::Zlib;
+            entry.storedSize = (uint64_t)compressed.Size();
+            entry.firstBlock = (uint32_t)this->blocks.Size();
+            entry.numBlocks = (uint32_t)entryBlocks.Size();
+            this->blocks.AppendArray(entryBlocks);
+        }
+    }
+
+    this->Align();
+    entry.dataOffset = (uint64_t)this->stream->GetPosition();
+    if (entry.codec == Pack::Zlib)
+    {
+        this->stream->Write(compressed.Begin(), compressed.Size());
+    }
+    else if (size > 0)
+    {
+        this->stream->Write(data, size);
+    }
+
+    // grow the names geometrically, AppendArray only grows to fit
+    if (this->names.Size() + path.Length() > this->names.Capacity())
+    {
+        this->names.Reserve(Math::max(path.Length(), this->names.Size()));
+    }
+    this->names.AppendArray(path.AsCharPtr(), path.Length());
+    this->paths.Add(path, this->entries.Size());
+    this->entries.Append(entry);
+    return true;
+}
+
+//------------------------------------------------------------------------------
+/**
+    Chains the entries into hash buckets and writes the tables after the
+    entry data, then the header at the start of the file.
+*/
+void
+PackWriter::Close()
+{
+    n_assert(this->IsOpen());
+
+    uint32_t numBuckets = 1;
+    while (numBuckets < (uint32_t)this->entries.Size())
+    {
+        numBuckets <<= 1;
+    }
+    Array<uint32_t> buckets(numBuckets, 0, Pack::InvalidEntry);
+    for (IndexT i = 0; i < this->entries.Size(); i++)
+    {
+        Pack::Entry& entry = this->entries[i];
+        uint32_t const bucket = (uint32_t)(entry.hash & (numBuckets - 1));
+        entry.nextInBucket = buckets[bucket];
+        buckets[bucket] = (uint32_t)i;
+    }
+
+    Pack::Header header;
+    Memory::Clear(&header, sizeof(header));
+    header.magic = Pack::Magic;
+    header.version = Pack::Version;
+    header.numEntries = (uint32_t)this->entries.Size();
+    header.numBuckets = numBuckets;
+    header.numBlocks = (uint32_t)this->blocks.Size();
+
+    // tables hold 64 bit fields, keep them 8 byte aligned
+    Stream::Position pos = this->stream->GetPosition();
+    if (pos % 8 != 0)
+    {
+        this->stream->Write(ZeroPadding, 8 - pos % 8);
+    }
+    header.entriesOffset = (uint64_t)this->stream->GetPosition();
+    if (!this->entries.IsEmpty())
+    {
+        this->stream->Write(this->entries.Begin(), this->entries.ByteSize());
+    }
+    header.bucketsOffset = (uint64_t)this->stream->GetPosition();
+    this->stream->Write(buckets.Begin(), buckets.ByteSize());
+    pos = this->stream->GetPosition();
+    if (pos % 8 != 0)
+    {
+        this->stream->Write(ZeroPadding, 8 - pos % 8);
+    }
+    header.blocksOffset = (uint64_t)this->stream->GetPosition();
+    if (!this->blocks.IsEmpty())
+    {
+        this->stream->Write(this->blocks.Begin(), this->blocks.ByteSize());
+    }
+    header.namesOffset = (uint64_t)this->stream->GetPosition();
+    header.namesSize = (uint64_t)this->names.Size();
+    if (!this->names.IsEmpty())
+    {
+        this->stream->Write(this->names.Begin(), this->names.Size());
+    }
+
+    this->stream->Seek(0, Stream::Begin);
+    this->stream->Write(&header, sizeof(header));
+    this->stream->Close();
+    this->stream = nullptr;
+
+    this->entries.Clear();
+    this->blocks.Clear();
+    this->names.Clear();
+    this->paths.Clear();
+    this->compressBuffer.Clear();
+}
+
+} // namespace IO
@@ -0,0 +1,103 @@
+#pragma once
+//------------------------------------------------------------------------------
+/**
+    @class IO::PackWriter
+
+    Writes a pack archive (see packformat.h) in a single pass. Files are
+    added one at a time, their data is compressed and written out right away,
+    and the tables are written when the writer is closed.
+
+    Files are compressed in independent blocks of Pack::BlockSize bytes. A file
+    is stored uncompressed if compression doesn't save at least an eighth of its
+    size, so that it can be used in place from the mapped archive.
+
+    @copyright
+    (C) 2024 Individual contributors, see AUTHORS file
+*/
+#include "core/refcounted.h"
+#include "io/stream.h"
+#include "io/packfs/packformat.h"
+#include "util/array.h"
+#include "util/dictionary.h"
+
+//------------------------------------------------------------------------------
+namespace IO
+{
+class PackWriter : public Core::RefCounted
+{
+    __DeclareClass(PackWriter);
+public:
+    /// constructor
+    PackWriter();
+    /// destructor
+    virtual ~PackWriter();
+
+    /// set the uri of the pack file, including the .pack extension
+    void SetURI(const URI& uri);
+    /// set zlib compression level, 0 stores all files uncompressed
+    void SetCompressionLevel(int level);
+    /// open the pack file for writing
+    bool Open();
+    /// write the tables and close the pack file
+    void Close();
+    /// return true if the writer is open
+    bool IsOpen() const;
+
+    /// add a file, pathInArchive is relative to the directory the pack will be mounted in
+    bool AddFile(const Util::String& pathInArchive, const void* data, SizeT size);
+    /// get the number of files added so far
+    SizeT GetNumFiles() const;
+
+private:
+    /// pad the file with zeros up to the data alignment
+    void Align();
+
+    URI uri;
+    Ptr<Stream> stream;
+    int compressionLevel;
+    Util::Array<Pack::Entry> entries;
+    Util::Array<Pack::Block> blocks;
+    Util::Array<char> names;
+    Util::Dictionary<Util::String, IndexT> paths;
+    Util::Array<unsigned char> compressBuffer;
+};
+
+//------------------------------------------------------------------------------
+/**
+*/
+inline void
+PackWriter::SetURI(const URI& u)
+{
+    n_assert(!this->IsOpen());
+    this->uri = u;
+}
+
+//------------------------------------------------------------------------------
+/**
+*/
+inline void
+PackWriter::SetCompressionLevel(int level)
+{
+    this->compressionLevel = level;
+}
+
+//------------------------------------------------------------------------------
+/**
+*/
+inline bool
+PackWriter::IsOpen() const
+{
+    return this->stream.isvalid();
+}
+
+//------------------------------------------------------------------------------
+/**
+*/
+inline SizeT
+PackWriter::GetNumFiles() const
+{
+    return this->entries.Size();
+}
+
+} // namespace IO
+//------------------------------------------------------------------------------
@@ -4,25 +4,233 @@
 //---------------------------------------------------------------------------
 #include "foundation/stdneb.h"
 #include "io/filewatcher.h"
+#include "io/assignregistry.h"
+#include <sys/inotify.h>
+#include <dirent.h>
+#include <errno.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
 
 namespace IO
 {
- 
- void 
- FileWatcherImpl::CreateWatcher(EventHandlerData& data)
- {
-     //FIXME
- }
-
-void 
-FileWatcherImpl::DestroyWatcher(EventHandlerData& data)
+
+// time a file has to be quiet before its merged events are delivered
+static const Timing::Time DebounceWindow = 0.05;
+
+//------------------------------------------------------------------------------
+/**
+*/
+static Timing::Time
+MonotonicTime()
+{
+    timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return Timing::Time(ts.tv_sec) + Timing::Time(ts.tv_nsec) * 1e-9;
+}
+
+//------------------------------------------------------------------------------
+/**
+    Adds a watch for a directory and, for recursive watchers, all its
+    subdirectories. The path is relative to the watched folder.
+*/
+static void
+AddWatch(FileWatcherPlatform& p, const Util::String& relPath)
+{
+    Util::String path = relPath.IsEmpty() ? p.root : p.root + "/" + relPath;
+    uint32_t mask = p.notifyMask | IN_ONLYDIR;
+    if (p.recursive)
+    {
+        // needed to pick up new subdirectories, even if not reported
+        mask |= IN_CREATE | IN_MOVED_TO;
+    }
+    int wd = inotify_add_watch(p.fd, path.AsCharPtr(), mask);
+    if (wd < 0)
+    {
+        n_warning("FileWatcher: failed to watch '%s' (%s)\n", path.AsCharPtr(), strerror(errno));
+        return;
+    }
+    if (p.dirs.Contains(wd))
+    {
+        // same directory reached twice, e.g. through a symlink
+        return;
+    }
+    p.dirs.Add(wd, relPath);
+
+    if (p.recursive)
+    {
+        DIR* dir = opendir(path.AsCharPtr());
+        if (dir != nullptr)
+        {
+            struct dirent* ent;
+            while ((ent = readdir(dir)) != nullptr)
+            {
+                if (ent->d_type == DT_DIR && strcmp(ent->d_name, ".") != 0 && strcmp(ent->d_name, "..") != 0)
+                {
+                    AddWatch(p, relPath.IsEmpty() ? Util::String(ent->d_name) : relPath + "/" + ent->d_name);
+                }
+            }
+            closedir(dir);
+        }
+    }
+}
+
+//------------------------------------------------------------------------------
+/**
+    Queues an event, merging it with the last queued event for the same
+    file if that is of the same type.
+*/
+static void
+QueueEvent(FileWatcherPlatform& p, WatchEventType type, const Util::String& file, Timing::Time now)
+{
+    IndexT i;
+    for (i = p.pending.Size() - 1; i >= 0; i--)
+    {
+        FileWatcherPlatform::PendingEvent& ev = p.pending[i];
+        if (ev.file == file)
+        {
+            if (ev.type == type)
+            {
+                ev.time = now;
+                return;
+            }
+            break;
+        }
+    }
+    p.pending.Append({ type, file, now });
+}
+
+//------------------------------------------------------------------------------
+/**
+*/
+void
+FileWatcherImpl::CreateWatcher(EventHandlerData& data)
 {
-    //FIXME
+    FileWatcherPlatform& p = data.data;
+    p.fd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+    n_assert(p.fd >= 0);
+
+    p.notifyMask = 0;
+    p.notifyMask |= data.flags & NameChanged ? IN_CREATE | IN_DELETE | IN_MOVED_TO : 0;
+    p.notifyMask |= data.flags & SizeChanged ? IN_MODIFY | IN_CLOSE_WRITE : 0;
+    p.notifyMask |= data.flags & Write ? IN_MODIFY | IN_CLOSE_WRITE : 0;
+    p.notifyMask |= data.flags & Access ? IN_ACCESS | IN_ATTRIB : 0;
+    p.notifyMask |= data.flags & Creation ? IN_CREATE | IN_MOVED_TO : 0;
+
+    p.root = IO::AssignRegistry::Instance()->ResolveAssigns(data.folder.AsString()).LocalPath();
+    p.root.TrimRight("/");
+    AddWatch(p, "");
 }
 
-void 
+//------------------------------------------------------------------------------
+/**
+    Drains the inotify queue without blocking and delivers the merged
+    events of all files which have been quiet for the debounce window.
+*/
+void
 FileWatcherImpl::Update(EventHandlerData& data)
 {
-    //FIXME
+    FileWatcherPlatform& p = data.data;
+    if (p.fd < 0)
+    {
+        return;
+    }
+
+    Timing::Time const now = MonotonicTime();
+    alignas(struct inotify_event) char buffer[16 * 1024];
+    ssize_t len;
+    while ((len = read(p.fd, buffer, sizeof(buffer))) > 0)
+    {
+        const char* ptr = buffer;
+        while (ptr < buffer + len)
+        {
+            const struct inotify_event* ev = (const struct inotify_event*)ptr;
+            ptr += sizeof(struct inotify_event) + ev->len;
+
+            if (ev->mask & IN_Q_OVERFLOW)
+            {
+                n_warning("FileWatcher: event queue of '%s' overflowed, events were lost\n", data.folder.Value());
+                continue;
+            }
+            IndexT const dirIndex = p.dirs.FindIndex(ev->wd);
+            if (dirIndex == InvalidIndex)
+            {
+                continue;
+            }
+            if (ev->mask & IN_IGNORED)
+            {
+                // directory was removed or moved away
+                p.dirs.EraseAtIndex(dirIndex);
+                continue;
+            }
+            if (ev->len == 0)
+            {
+                continue;
+            }
+
+            Util::String const& dir = p.dirs.ValueAtIndex(dirIndex);
+            Util::String file = dir.IsEmpty() ? Util::String(ev->name) : dir + "/" + ev->name;
+            if (p.recursive && (ev->mask & IN_ISDIR) && (ev->mask & (IN_CREATE | IN_MOVED_TO)))
+            {
+                // files created in the new directory before the watch is added are not reported
+                AddWatch(p, file);
+            }
+            if (!(ev->mask & p.notifyMask))
+            {
+                continue;
+            }
+
+            if (ev->mask & IN_CREATE)
+            {
+                QueueEvent(p, Created, file, now);
+            }
+            else if (ev->mask & IN_DELETE)
+            {
+                QueueEvent(p, Deleted, file, now);
+            }
+            else if (ev->mask & IN_MOVED_TO)
+            {
+                QueueEvent(p, NameChange, file, now);
+            }
+            else
+            {
+                QueueEvent(p, Modified, file, now);
+            }
+        }
+    }
+
+    // deliver in order, events of a file are never overtaken by later ones of the same file
+    IndexT i;
+    for (i = 0; i < p.pending.Size();)
+    {
+        FileWatcherPlatform::PendingEvent const& ev = p.pending[i];
+        if (now - ev.time >= DebounceWindow)
+        {
+            data.callback({ (WatchEventType)ev.type, data.folder, ev.file });
+            p.pending.EraseIndex(i);
+        }
+        else
+        {
+            i++;
+        }
+    }
+}
+
+//------------------------------------------------------------------------------
+/**
+*/
+void
+FileWatcherImpl::DestroyWatcher(EventHandlerData& data)
+{
+    FileWatcherPlatform& p = data.data;
+    if (p.fd >= 0)
+    {
+        // closing the descriptor removes all its watches
+        close(p.fd);
+        p.fd = -1;
+    }
+    p.dirs.Clear();
+    p.pending.Clear();
+}
+
 }
-}
\ No newline at end of file
@@ -3,26 +3,50 @@
 /**
     @class Linux::FileWatcher
 
-    Linux implementation of filewatcher
+    Linux implementation of filewatcher, based on inotify.
+
+    Recursive watches add a watch for every subdirectory, including ones
+    created later. Events are queued per watched folder and repeated events
+    of the same kind for the same file are merged until the file has been
+    quiet for a short while, so a tool writing a file in many small chunks
+    results in a single modification event.
 
     (C) 2020 Individual contributors, see AUTHORS file
 */
 #include "core/types.h"
 #include "core/refcounted.h"
+#include "util/array.h"
+#include "util/dictionary.h"
+#include "util/string.h"
+#include "timing/time.h"
 
 namespace IO
 {
     struct EventHandlerData;
     struct FileWatcherPlatform
-    {        
-        bool recursive;        
+    {
+        struct PendingEvent
+        {
+            int type;
+            Util::String file;
+            Timing::Time time;
+        };
+
+        int fd = -1;
+        uint32_t notifyMask = 0;
+        /// local path of the watched folder
+        Util::String root;
+        /// watch descriptor to directory, relative to the watched folder
+        Util::Dictionary<int, Util::String> dirs;
+        Util::Array<PendingEvent> pending;
+        bool recursive;
     };
 
-class FileWatcherImpl 
+class FileWatcherImpl
 {
 public:
     static void CreateWatcher(EventHandlerData& data);
     static void DestroyWatcher(EventHandlerData& data);
     static void Update(EventHandlerData& data);
 };
-}
\ No newline at end of file
+}
@@ -0,0 +1,321 @@
+//------------------------------------------------------------------------------
+//  linuxiouring.cc
+//  (C) 2024 Individual contributors, see AUTHORS file
+//------------------------------------------------------------------------------
+#include "foundation/stdneb.h"
+#include "io/posix/linuxiouring.h"
+#include "math/scalar.h"
+
+#if __linux__
+#include <errno.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <linux/io_uring.h>
+#endif
+
+// IORING_FEAT_RW_CUR_POS was added in the same kernel release as IORING_OP_READ
+#if __linux__ && defined(__NR_io_uring_setup) && defined(IORING_FEAT_RW_CUR_POS)
+#define NEBULA_IO_URING 1
+#else
+#define NEBULA_IO_URING 0
+#endif
+
+namespace Linux
+{
+
+//------------------------------------------------------------------------------
+/**
+*/
+IoUring::IoUring() :
+    ringFd(-1),
+    numPrepared(0),
+    sqRing(nullptr),
+    sqRingSize(0),
+    cqRing(nullptr),
+    cqRingSize(0),
+    sqes(nullptr),
+    sqesSize(0),
+    sqHead(nullptr),
+    sqTail(nullptr),
+    sqMask(0),
+    sqEntries(0),
+    sqArray(nullptr),
+    cqHead(nullptr),
+    cqTail(nullptr),
+    cqMask(0),
+    cqEntries(0),
+    cqes(nullptr)
+{
+    // empty
+}
+
+//------------------------------------------------------------------------------
+/**
+*/
+IoUring::~IoUring()
+{
+    if (this->IsValid())
+    {
+        this->Discard();
+    }
+}
+
+//------------------------------------------------------------------------------
+/**
+*/
+bool
+IoUring::Setup(uint32_t entries)
+{
+    n_assert(!this->IsValid());
+#if NEBULA_IO_URING
+    io_uring_params params;
+    memset(&params, 0, sizeof(params));
+    int fd = (int)syscall(__NR_io_uring_setup, entries, &params);
+    if (fd < 0)
+        return false;
+
+    if ((params.features & IORING_FEAT_RW_CUR_POS) == 0)
+    {
+        close(fd);
+        return false;
+    }
+
+    this->sqRingSize = params.sq_off.array + params.sq_entries * sizeof(uint32_t);
+    this->cqRingSize = params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe);
+    bool const singleMap = (params.features & IORING_FEAT_SINGLE_MMAP) != 0;
+    if (singleMap)
+    {
+        this->sqRingSize = this->cqRingSize = Math::max(this->sqRingSize, this->cqRingSize);
+    }
+
+    this->sqRing = mmap(nullptr, this->sqRingSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_SQ_RING);
+    if (this->sqRing == MAP_FAILED)
+    {
+        this->sqRing = nullptr;
+        close(fd);
+        return false;
+    }
+
+    if (singleMap)
+    {
+        this->cqRing = this->sqRing;
+    }
+    else
+    {
+        this->cqRing = mmap(nullptr, this->cqRingSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_CQ_RING);
+        if (this->cqRing == MAP_FAILED)
+        {
+            munmap(this->sqRing, this->sqRingSize);
+            this->sqRing = this->cqRing = nullptr;
+            close(fd);
+            return false;
+        }
+    }
+
+    this->sqesSize = params.sq_entries * sizeof(io_uring_sqe);
+    this->sqes = mmap(nullptr, this->sqesSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_SQES);
+    if (this->sqes == MAP_FAILED)
+    {
+        if (!singleMap)
+            munmap(this->cqRing, this->cqRingSize);
+        munmap(this->sqRing, this->sqRingSize);
+        this->sqRing = this->cqRing = this->sqes = nullptr;
+        close(fd);
+        return false;
+    }
+
+    char* sq = (char*)this->sqRing;
+    this->sqHead = (uint32_t*)(sq + params.sq_off.head);
+    this->sqTail = (uint32_t*)(sq + params.sq_off.tail);
+    this->sqMask = *(uint32_t*)(sq + params.sq_off.ring_mask);
+    this->sqEntries = params.sq_entries;
+    this->sqArray = (uint32_t*)(sq + params.sq_off.array);
+
+    char* cq = (char*)this->cqRing;
+    this->cqHead = (uint32_t*)(cq + params.cq_off.head);
+    this->cqTail = (uint32_t*)(cq + params.cq_off.tail);
+    this->cqMask = *(uint32_t*)(cq + params.cq_off.ring_mask);
+    this->cqEntries = params.cq_entries;
+    this->cqes = cq + params.cq_off.cqes;
+
+    this->ringFd = fd;
+    this->numPrepared = 0;
+    return true;
+#else
+    return false;
+#endif
+}
+
+//------------------------------------------------------------------------------
+/**
+    All reads in flight must have completed before the ring is destroyed,
+    since the kernel keeps writing to their buffers otherwise.
+*/
+void
+IoUring::Discard()
+{
+    n_assert(this->IsValid());
+#if NEBULA_IO_URING
+    munmap(this->sqes, this->sqesSize);
+    if (this->cqRing != this->sqRing)
+        munmap(this->cqRing, this->cqRingSize);
+    munmap(this->sqRing, this->sqRingSize);
+    close(this->ringFd);
+#endif
+    this->sqRing = this->cqRing = this->sqes = this->cqes = nullptr;
+    this->sqHead = this->sqTail = this->sqArray = this->cqHead = this->cqTail = nullptr;
+    this->ringFd = -1;
+    this->numPrepared = 0;
+}
+
+//------------------------------------------------------------------------------
+/**
+*/
+bool
+IoUring::PrepareRead(int fd, void* buffer, uint32_t numBytes, uint64_t offset, uint64_t userData)
+{
+    n_assert(this->IsValid());
+#if NEBULA_IO_URING
+    // only this thread writes the tail, the kernel moves the head as it consumes entries
+    uint32_t const tail = *this->sqTail;
+    uint32_t const head = __atomic_load_n(this->sqHead, __ATOMIC_ACQUIRE);
+    if (tail - head >= this->sqEntries)
+        return false;
+
+    uint32_t const index = tail & this->sqMask;
+    io_uring_sqe* sqe = (io_uring_sqe*)this->sqes + index;
+    memset(sqe, 0, sizeof(io_uring_sqe));
+    sqe->opcode = IORING_OP_READ;
+    sqe->fd = fd;
+    sqe->off = offset;
+    sqe->addr = (uint64_t)(uintptr_t)buffer;
+    sqe->len = numBytes;
+    sqe->user_data = userData;
+    this->sqArray[index] = index;
+
+    // publish the entry to the kernel
+    __atomic_store_n(this->sqTail, tail + 1, __ATOMIC_RELEASE);
+    this->numPrepared++;
+    return true;
+#else
+    return false;
+#endif
+}
+
+//------------------------------------------------------------------------------
+/**
+    Reads already running are not interrupted, so the cancelled request may
+    still complete normally.
+*/
+bool
+IoUring::PrepareCancel(uint64_t userData, uint64_t cancelUserData)
+{
+    n_assert(this->IsValid());
+#if NEBULA_IO_URING
+    uint32_t const tail = *this->sqTail;
+    uint32_t const head = __atomic_load_n(this->sqHead, __ATOMIC_ACQUIRE);
+    if (tail - head >= this->sqEntries)
+        return false;
+
+    uint32_t const index = tail & this->sqMask;
+    io_uring_sqe* sqe = (io_uring_sqe*)this->sqes + index;
+    memset(sqe, 0, sizeof(io_uring_sqe));
+    sqe->opcode = IORING_OP_ASYNC_CANCEL;
+    sqe->fd = -1;
+    sqe->addr = userData;
+    sqe->user_data = cancelUserData;
+    this->sqArray[index] = index;
+
+    __atomic_store_n(this->sqTail, tail + 1, __ATOMIC_RELEASE);
+    this->numPrepared++;
+    return true;
+#else
+    return false;
+#endif
+}
+
+//------------------------------------------------------------------------------
+/**
+    The kernel only consumes entries in io_uring_enter, so entries which have
+    not been submitted can be withdrawn by moving the tail back.
+*/
+uint32_t
+IoUring::DropPrepared()
+{
+    n_assert(this->IsValid());
+#if NEBULA_IO_URING
+    uint32_t const tail = *this->sqTail;
+    uint32_t const head = __atomic_load_n(this->sqHead, __ATOMIC_ACQUIRE);
+    uint32_t const numDropped = Math::min(this->numPrepared, tail - head);
+    __atomic_store_n(this->sqTail, tail - numDropped, __ATOMIC_RELEASE);
+    this->numPrepared = 0;
+    return numDropped;
+#else
+    return 0;
+#endif
+}
+
+//------------------------------------------------------------------------------
+/**
+*/
+bool
+IoUring::Submit(bool wait)
+{
+    n_assert(this->IsValid());
+#if NEBULA_IO_URING
+    if (this->numPrepared == 0 && !wait)
+        return true;
+
+    unsigned const flags = wait ? IORING_ENTER_GETEVENTS : 0;
+    while (true)
+    {
+        int res = (int)syscall(__NR_io_uring_enter, this->ringFd, this->numPrepared, wait ? 1 : 0, flags, nullptr, 0);
+        if (res < 0)
+        {
+            if (errno == EINTR)
+                continue;
+
+            // the kernel is short of resources or the completion queue is full, the entries
+            // stay prepared and go out with the next call, once completions have been reaped
+            if (errno == EAGAIN || errno == EBUSY)
+                return true;
+            n_warning("IoUring: io_uring_enter failed: %s\n", strerror(errno));
+            return false;
+        }
+        this->numPrepared -= Math::min((uint32_t)res, this->numPrepared);
+        return true;
+    }
+#else
+    return false;
+#endif
+}
+
+//------------------------------------------------------------------------------
+/**
+*/
+bool
+IoUring::PopCompletion(uint64_t& userData, int32_t& result)
+{
+    n_assert(this->IsValid());
+#if NEBULA_IO_URING
+    // only this thread writes the head, the kernel moves the tail as reads complete
+    uint32_t const head = *this->cqHead;
+    uint32_t const tail = __atomic_load_n(this->cqTail, __ATOMIC_ACQUIRE);
+    if (head == tail)
+        return false;
+
+    io_uring_cqe const* cqe = (io_uring_cqe const*)this->cqes + (head & this->cqMask);
+    userData = cqe->user_data;
+    result = cqe->res;
+
+    // hand the slot back to the kernel
+    __atomic_store_n(this->cqHead, head + 1, __ATOMIC_RELEASE);
+    return true;
+#else
+    return false;
+#endif
+}
+
+} // namespace Linux
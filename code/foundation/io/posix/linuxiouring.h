@@ -0,0 +1,95 @@
+#pragma once
+//------------------------------------------------------------------------------
+/**
+    @class Linux::IoUring
+
+    Minimal wrapper around a Linux io_uring instance, used by IO::AsyncIoQueue
+    to batch file reads into a single system call.
+
+    Talks to the kernel through the raw system calls, so there is no dependency
+    on liburing. Requires a kernel with IORING_OP_READ (5.6 or later), Setup
+    returns false otherwise, as well as when io_uring is blocked, which is common
+    in containers.
+
+    Not thread safe, a ring must only be used from one thread.
+
+    @copyright
+    (C) 2024 Individual contributors, see AUTHORS file
+*/
+#include "core/types.h"
+
+//------------------------------------------------------------------------------
+namespace Linux
+{
+class IoUring
+{
+public:
+    /// constructor
+    IoUring();
+    /// destructor
+    ~IoUring();
+
+    /// create the ring, returns false if io_uring is not available
+    bool Setup(uint32_t entries);
+    /// destroy the ring
+    void Discard();
+    /// return true if the ring has been set up
+    bool IsValid() const;
+    /// get the number of completion slots, which limits the number of reads in flight
+    uint32_t GetNumCompletionSlots() const;
+
+    /// prepare a read, returns false if the submission queue is full
+    bool PrepareRead(int fd, void* buffer, uint32_t numBytes, uint64_t offset, uint64_t userData);
+    /// prepare the cancellation of the request with the given user data, its own completion carries cancelUserData
+    bool PrepareCancel(uint64_t userData, uint64_t cancelUserData);
+    /// take back all prepared entries the kernel has not consumed yet, returns their number
+    uint32_t DropPrepared();
+    /// submit all prepared reads, and if wait is set, wait for at least one completion, returns false if the ring is unusable
+    bool Submit(bool wait);
+    /// pop a completion, result is the number of bytes read or a negative error code, returns false if there are none
+    bool PopCompletion(uint64_t& userData, int32_t& result);
+
+private:
+    int ringFd;
+    uint32_t numPrepared;
+
+    void* sqRing;
+    size_t sqRingSize;
+    void* cqRing;
+    size_t cqRingSize;
+    void* sqes;
+    size_t sqesSize;
+
+    uint32_t* sqHead;
+    uint32_t* sqTail;
+    uint32_t sqMask;
+    uint32_t sqEntries;
+    uint32_t* sqArray;
+
+    uint32_t* cqHead;
+    uint32_t* cqTail;
+    uint32_t cqMask;
+    uint32_t cqEntries;
+    void* cqes;
+};
+
+//------------------------------------------------------------------------------
+/**
+*/
+inline bool
+IoUring::IsValid() const
+{
+    return this->ringFd >= 0;
+}
+
+//------------------------------------------------------------------------------
+/**
+*/
+inline uint32_t
+IoUring::GetNumCompletionSlots() const
+{
+    return this->cqEntries;
+}
+
+} // namespace Linux
+//------------------------------------------------------------------------------
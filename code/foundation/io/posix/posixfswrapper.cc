@@ -14,6 +14,7 @@
 #include <sys/stat.h>
 #include <sys/file.h>
 #include <sys/mman.h>
+#include <unistd.h>
 
 #ifdef __APPLE__
 namespace CoreFoundation {
@@ -111,6 +112,38 @@ PosixFSWrapper::Read(Handle handle, void* buf, Stream::Size numBytes)
     return bytesRead;
 }
 
+//------------------------------------------------------------------------------
+/**
+    Read data from a file at an offset with pread, which is safe to call from
+    several threads on the same handle. Returns the number of bytes read, which
+    is only less than numBytes at the end of the file, or -1 on failure.
+*/
+Stream::Size
+PosixFSWrapper::ReadAt(Handle handle, void* buf, Stream::Size numBytes, Stream::Position offset)
+{
+    n_assert(0 != handle);
+    n_assert(buf != 0);
+    n_assert(numBytes > 0);
+    int fd = fileno(handle);
+    n_assert(fd >= 0);
+
+    Stream::Size bytesRead = 0;
+    while (bytesRead < numBytes)
+    {
+        ssize_t res = pread(fd, (char*)buf + bytesRead, numBytes - bytesRead, offset + bytesRead);
+        if (res < 0)
+        {
+            if (errno == EINTR)
+                continue;
+            return -1;
+        }
+        if (res == 0)
+            break;
+        bytesRead += res;
+    }
+    return bytesRead;
+}
+
 //------------------------------------------------------------------------------
 /**
 */
@@ -33,6 +33,8 @@ public:
     static void Write(Handle h, const void* buf, IO::Stream::Size numBytes);
     /// read from a file
     static IO::Stream::Size Read(Handle h, void* buf, IO::Stream::Size numBytes);
+    /// read from a file at an offset, without moving the file position, returns -1 on failure
+    static IO::Stream::Size ReadAt(Handle h, void* buf, IO::Stream::Size numBytes, IO::Stream::Position offset);
     /// map file to virtual memory
     static char* Map(Handle h, IO::Stream::AccessMode accessMode, Handle& mappedHandle);
     /// unmap file
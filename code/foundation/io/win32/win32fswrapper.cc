@@ -139,6 +139,44 @@ Win32FSWrapper::Read(Handle handle, void* buf, Stream::Size numBytes)
     return bytesRead;
 }
 
+//------------------------------------------------------------------------------
+/**
+    Read data from a file at an offset. Returns the number of bytes read,
+    which is only less than numBytes at the end of the file, or -1 on failure.
+*/
+Stream::Size
+Win32FSWrapper::ReadAt(Handle handle, void* buf, Stream::Size numBytes, Stream::Position offset)
+{
+    n_assert(0 != handle);
+    n_assert(buf != 0);
+    n_assert(numBytes > 0);
+    n_assert(numBytes < LLONG_MAX);
+
+    Stream::Size bytesRead = 0;
+    while (bytesRead < numBytes)
+    {
+        OVERLAPPED overlapped = {};
+        ULARGE_INTEGER pos;
+        pos.QuadPart = offset + bytesRead;
+        overlapped.Offset = pos.LowPart;
+        overlapped.OffsetHigh = pos.HighPart;
+
+        Stream::Size const remaining = numBytes - bytesRead;
+        DWORD chunk = remaining > 0x7FFFFFFF ? 0x7FFFFFFF : (DWORD)remaining;
+        DWORD res;
+        if (0 == ReadFile(handle, (char*)buf + bytesRead, chunk, &res, &overlapped))
+        {
+            if (GetLastError() == ERROR_HANDLE_EOF)
+                break;
+            return -1;
+        }
+        if (res == 0)
+            break;
+        bytesRead += res;
+    }
+    return bytesRead;
+}
+
 //------------------------------------------------------------------------------
 /**
 */
@@ -20,7 +20,8 @@ using namespace Util;
 /**
 */
 ZipArchive::ZipArchive() :
-    zipFileHandle(0)
+    zipFileHandle(0),
+    fileHandle(0)
 {
     fill_nebula3_filefunc(&this->zlibIoFuncs);
 }
@@ -69,6 +70,13 @@ ZipArchive::Setup(const URI& zipFileURI, const String& rootPathOverride)
             return false;
         }
 
+        // second handle for positional reads, shared by all threads
+        this->fileHandle = FSWrapper::OpenFile(URI(realPath).GetHostAndLocalPath(), Stream::ReadAccess, Stream::Random);
+        if (0 == this->fileHandle)
+        {
+            n_warning("ZipArchive: failed to open '%s' for parallel reads!\n", realPath.AsCharPtr());
+        }
+
         // read the table of contents
         this->ParseTableOfContents();    
         return true;
@@ -91,6 +99,11 @@ ZipArchive::Discard()
 
     unzClose(this->zipFileHandle);
     this->zipFileHandle = 0;
+    if (0 != this->fileHandle)
+    {
+        FSWrapper::CloseFile(this->fileHandle);
+        this->fileHandle = 0;
+    }
 
     ArchiveBase::Discard();
 }
@@ -177,7 +190,7 @@ ZipArchive::AddEntry(const String& path)
     else
     {
         ZipFileEntry* finalFileEntry = dirEntry->AddFileEntry(finalName);
-        finalFileEntry->Setup(finalName, this->zipFileHandle, &this->archiveCritSect);
+        finalFileEntry->Setup(finalName, this->zipFileHandle, &this->archiveCritSect, this->fileHandle);
     }
 }
 
@@ -287,6 +300,24 @@ ZipArchive::FindDirEntry(const String& pathInZipArchive) const
     return dirEntry;
 }
 
+//------------------------------------------------------------------------------
+/**
+*/
+bool
+ZipArchive::HasFile(const String& pathInArchive) const
+{
+    return 0 != this->FindFileEntry(pathInArchive);
+}
+
+//------------------------------------------------------------------------------
+/**
+*/
+bool
+ZipArchive::HasDirectory(const String& pathInArchive) const
+{
+    return 0 != this->FindDirEntry(pathInArchive);
+}
+
 //------------------------------------------------------------------------------
 /**
 */
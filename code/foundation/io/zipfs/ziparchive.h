@@ -6,9 +6,10 @@
     Private helper class for ZipFileSystem to hold per-Zip-archive data.
     Uses the zlib and the minizip lib for zip file access.
     
-    Multithreading: access to zlib archives needs to be serialized. A
+    Multithreading: access to the minizip handle needs to be serialized. A
     ZipArchive objects contains a critical section which it will hand down
-    to ZipFileEntry objects.
+    to ZipFileEntry objects. Most entries don't need it though, they are
+    read with positional reads on a second file handle, see ZipFileEntry.
 
     @copyright
     (C) 2006 Radon Labs GmbH
@@ -32,18 +33,22 @@ public:
     virtual ~ZipArchive();
 
     /// setup the archive from an URI
-    bool Setup(const URI& uri, const Util::String& rootPath = "");
+    bool Setup(const URI& uri, const Util::String& rootPath = "") override;
     /// discard the archive
-    void Discard();
+    void Discard() override;
 
     /// list all files in a directory in the archive
-    Util::Array<Util::String> ListFiles(const Util::String& dirPathInArchive, const Util::String& pattern) const;
+    Util::Array<Util::String> ListFiles(const Util::String& dirPathInArchive, const Util::String& pattern) const override;
     /// list all subdirectories in a directory in the archive
-    Util::Array<Util::String> ListDirectories(const Util::String& dirPathInArchive, const Util::String& pattern) const;
+    Util::Array<Util::String> ListDirectories(const Util::String& dirPathInArchive, const Util::String& pattern) const override;
     /// convert a "file:" URI into a "zip:" URI pointing into this archive
-    URI ConvertToArchiveURI(const URI& fileURI) const;
+    URI ConvertToArchiveURI(const URI& fileURI) const override;
     /// convert an absolute path to local path inside archive, returns empty string if absPath doesn't point into this archive
-    Util::String ConvertToPathInArchive(const Util::String& absPath) const;
+    Util::String ConvertToPathInArchive(const Util::String& absPath) const override;
+    /// return true if the archive contains a file
+    bool HasFile(const Util::String& pathInArchive) const override;
+    /// return true if the archive contains a directory
+    bool HasDirectory(const Util::String& pathInArchive) const override;
 
 private:
     friend class ZipFileSystem;
@@ -62,6 +67,7 @@ private:
 
     Util::String rootPath;                      // location of the zip archive file
     unzFile zipFileHandle;                      // the zip file handle
+    FSWrapper::Handle fileHandle;               // raw file handle for positional reads
     ZipDirEntry rootEntry;                      // the root entry of the zip archive
     Threading::CriticalSection archiveCritSect; // need to serialize access to archive from multiple threads!
     zlib_filefunc64_def zlibIoFuncs;            // io functions struct from zlib to nebula
@@ -5,19 +5,30 @@
 //------------------------------------------------------------------------------
 
 #include "io/zipfs/zipfileentry.h"
+#include "math/scalar.h"
+#include "zlib/zlib.h"
 
 namespace IO
 {
 using namespace Util;
 using namespace Threading;
 
+/// size of the chunks compressed data is read in by ReadParallel
+static const Stream::Size ReadChunkSize = 256 * 1024;
+
 //------------------------------------------------------------------------------
 /**
 */
 ZipFileEntry::ZipFileEntry() :
     archiveCritSect(0),
     zipFileHandle(0),
-    uncompressedSize(0)
+    uncompressedSize(0),
+    fileHandle(0),
+    dataOffset(0),
+    compressedSize(0),
+    crc(0),
+    compressionMethod(0),
+    isParallel(false)
 {
     Memory::Clear(&this->filePosInfo, sizeof(this->filePosInfo));
 }
@@ -32,9 +43,11 @@ ZipFileEntry::~ZipFileEntry()
 
 //------------------------------------------------------------------------------
 /**
+    Called by the archive while walking the table of contents, with the entry
+    being the current file of the zip handle.
 */
 void
-ZipFileEntry::Setup(const StringAtom& n, unzFile h, CriticalSection* critSect)
+ZipFileEntry::Setup(const StringAtom& n, unzFile h, CriticalSection* critSect, FSWrapper::Handle fh)
 {
     n_assert(0 != h);
     n_assert(0 == this->zipFileHandle);
@@ -42,6 +55,7 @@ ZipFileEntry::Setup(const StringAtom& n, unzFile h, CriticalSection* critSect)
 
     this->name = n;
     this->zipFileHandle = h;
+    this->fileHandle = fh;
 
     // store pointer to archive's critical section
     this->archiveCritSect = critSect;
@@ -55,14 +69,37 @@ ZipFileEntry::Setup(const StringAtom& n, unzFile h, CriticalSection* critSect)
     res = unzGetCurrentFileInfo64(this->zipFileHandle, &fileInfo, 0, 0, 0, 0, 0, 0);
     n_assert(UNZ_OK == res);
     this->uncompressedSize = fileInfo.uncompressed_size;
+    this->compressedSize = fileInfo.compressed_size;
+    this->crc = (uint32_t)fileInfo.crc;
+    this->compressionMethod = (uint16_t)fileInfo.compression_method;
+
+    // unencrypted stored and deflated entries are read directly, which needs the
+    // offset of the data behind the local header, opening raw avoids setting up inflate
+    bool const encrypted = (fileInfo.flag & 1) != 0;
+    if (0 != fh && !encrypted && (0 == this->compressionMethod || Z_DEFLATED == this->compressionMethod))
+    {
+        if (UNZ_OK == unzOpenCurrentFile2(this->zipFileHandle, 0, 0, 1))
+        {
+            this->dataOffset = unzGetCurrentFileZStreamPos64(this->zipFileHandle);
+            unzCloseCurrentFile(this->zipFileHandle);
+            this->isParallel = true;
+        }
+    }
 }
 
 //------------------------------------------------------------------------------
 /**
+    Entries which are read in parallel need no state, so opening them
+    does nothing. The password is only needed for encrypted entries.
 */
 bool
 ZipFileEntry::Open(const String& password)
 {
+    if (this->isParallel)
+    {
+        return true;
+    }
+
     // critical section active until close is called or this function fails
     this->archiveCritSect->Enter();
 
@@ -99,6 +136,11 @@ ZipFileEntry::Open(const String& password)
 void
 ZipFileEntry::Close()
 {
+    if (this->isParallel)
+    {
+        return;
+    }
+
     // close the file
     int res = unzCloseCurrentFile(this->zipFileHandle);
     n_assert(UNZ_OK == res);
@@ -117,6 +159,11 @@ ZipFileEntry::Read(void* buf, Stream::Size numBytes) const
     n_assert(0 != buf);
     n_assert(0 != this->archiveCritSect);
     n_assert(numBytes < INT_MAX);
+    if (this->isParallel)
+    {
+        return this->ReadParallel(buf, numBytes);
+    }
+
     // read uncompressed data 
     int readResult = unzReadCurrentFile(this->zipFileHandle, buf, (uint32_t)numBytes);
     if (numBytes != readResult) return false;
@@ -124,4 +171,70 @@ ZipFileEntry::Read(void* buf, Stream::Size numBytes) const
     return true;
 }
 
+//------------------------------------------------------------------------------
+/**
+    Reads the compressed data in chunks with positional reads and inflates
+    it with a zlib stream of its own, so no state is shared with other
+    threads reading from the same archive.
+*/
+bool
+ZipFileEntry::ReadParallel(void* buf, Stream::Size numBytes) const
+{
+    if ((uint64_t)numBytes != this->uncompressedSize)
+    {
+        return false;
+    }
+
+    if (0 == this->compressionMethod)
+    {
+        if (FSWrapper::ReadAt(this->fileHandle, buf, numBytes, this->dataOffset) != numBytes)
+        {
+            return false;
+        }
+        return crc32(0, (const Bytef*)buf, (uInt)numBytes) == this->crc;
+    }
+
+    z_stream stream;
+    Memory::Clear(&stream, sizeof(stream));
+    if (Z_OK != inflateInit2(&stream, -MAX_WBITS))
+    {
+        return false;
+    }
+    stream.next_out = (Bytef*)buf;
+    stream.avail_out = (uInt)numBytes;
+
+    Stream::Size const chunkSize = Math::min<Stream::Size>(ReadChunkSize, (Stream::Size)this->compressedSize);
+    Bytef* chunk = (Bytef*)Memory::Alloc(Memory::ScratchHeap, Math::max<Stream::Size>(chunkSize, 1));
+    uint64_t offset = 0;
+    int res = Z_OK;
+    while (Z_OK == res && offset < this->compressedSize)
+    {
+        Stream::Size const readSize = Math::min<Stream::Size>(chunkSize, (Stream::Size)(this->compressedSize - offset));
+        if (FSWrapper::ReadAt(this->fileHandle, chunk, readSize, this->dataOffset + offset) != readSize)
+        {
+            res = Z_DATA_ERROR;
+            break;
+        }
+        offset += readSize;
+        stream.next_in = chunk;
+        stream.avail_in = (uInt)readSize;
+        res = inflate(&stream, Z_NO_FLUSH);
+        if ((Z_OK == res || Z_BUF_ERROR == res) && 0 != stream.avail_in)
+        {
+            // output is full but the stream hasn't ended, the entry is corrupt
+            res = Z_DATA_ERROR;
+        }
+    }
+    if (Z_OK == res)
+    {
+        // all input consumed, let zlib flush the end of the stream
+        res = inflate(&stream, Z_FINISH);
+    }
+    bool const success = Z_STREAM_END == res && stream.total_out == (uLong)numBytes;
+    inflateEnd(&stream);
+    Memory::Free(Memory::ScratchHeap, chunk);
+
+    return success && crc32(0, (const Bytef*)buf, (uInt)numBytes) == this->crc;
+}
+
 } // namespace ZipFileEntry
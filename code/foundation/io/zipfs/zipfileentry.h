@@ -6,12 +6,19 @@
     A file entry in a zip archive. The ZipFileEntry class is thread-safe,
     all public methods can be invoked from on the same object from different
     threads.
+
+    Stored and deflated entries without encryption are read with positional
+    reads on the archive's file handle and inflated with a private zlib
+    stream, so any number of threads can read entries of the same archive at
+    once. Other entries go through the shared minizip handle, which is locked
+    from Open() until Close().
     
     @copyright
     (C) 2006 Radon Labs GmbH
     (C) 2013-2020 Individual contributors, see AUTHORS file
 */    
 #include "io/stream.h"
+#include "io/fswrapper.h"
 #include "minizip/unzip.h"
 #include "util/stringatom.h"
 
@@ -37,18 +44,28 @@ public:
     void Close();
     /// read the *entire* content into the provided memory buffer
     bool Read(void* buf, IO::Stream::Size bufSize) const;
+    /// return true if the entry can be read without locking the archive
+    bool IsParallel() const;
 
 private:
     friend class ZipArchive;
     
     /// setup the file entry object
-    void Setup(const Util::StringAtom& name, unzFile zipFileHandle, Threading::CriticalSection* critSect);
+    void Setup(const Util::StringAtom& name, unzFile zipFileHandle, Threading::CriticalSection* critSect, FSWrapper::Handle fileHandle);
+    /// read and decompress the entry with positional reads
+    bool ReadParallel(void* buf, IO::Stream::Size numBytes) const;
 
     Threading::CriticalSection* archiveCritSect;
     Util::StringAtom name;
     unzFile zipFileHandle;    // handle on zip file
     unz64_file_pos filePosInfo; // info about position in zip file
     uint64_t uncompressedSize;    // uncompressed size of the file
+    FSWrapper::Handle fileHandle; // raw handle on the zip file for positional reads
+    uint64_t dataOffset;        // offset of the entry data in the zip file
+    uint64_t compressedSize;    // size of the entry data in the zip file
+    uint32_t crc;               // crc32 of the uncompressed data
+    uint16_t compressionMethod; // 0 = stored, Z_DEFLATED = deflate
+    bool isParallel;            // true if the entry is read with positional reads
 };
 
 //------------------------------------------------------------------------------
@@ -69,6 +86,15 @@ ZipFileEntry::GetFileSize() const
     return this->uncompressedSize;
 }
 
+//------------------------------------------------------------------------------
+/**
+*/
+inline bool
+ZipFileEntry::IsParallel() const
+{
+    return this->isParallel;
+}
+
 } // namespace IO
 //------------------------------------------------------------------------------
 
@@ -129,12 +129,17 @@ ZipFileStream::Open()
                     {
                         // read content of zip file entry into private buffer
                         this->size = this->zipFileEntry->GetFileSize();
-                        if(!this->zipFileEntry->Open(pwd)) return false;
-                        if(!this->CopyToMap()) return false;
-                        this->position = 0;
-                        this->zipFileEntry->Close();
-                        this->zipFileEntry = nullptr;
-                        return true;
+                        if (this->zipFileEntry->Open(pwd))
+                        {
+                            bool const copied = this->CopyToMap();
+                            this->zipFileEntry->Close();
+                            this->zipFileEntry = nullptr;
+                            if (copied)
+                            {
+                                this->position = 0;
+                                return true;
+                            }
+                        }
                     }
                 }
             }
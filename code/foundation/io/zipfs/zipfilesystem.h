@@ -53,9 +53,9 @@ public:
     void Discard();
 
     /// find first archive which contains the file path
-    Ptr<Archive> FindArchiveWithFile(const URI& fileUri) const;
+    Ptr<ArchiveBase> FindArchiveWithFile(const URI& fileUri) const;
     /// find first archive which contains the directory path
-    Ptr<Archive> FindArchiveWithDir(const URI& dirUri) const;
+    Ptr<ArchiveBase> FindArchiveWithDir(const URI& dirUri) const;
 };
 
 } // namespace IO
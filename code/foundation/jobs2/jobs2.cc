@@ -11,13 +11,15 @@ namespace Jobs2
 {
 
 Jobs2Context ctx;
+thread_local IndexT JobThreadIndex = InvalidIndex;
 
 __ImplementClass(Jobs2::JobThread, 'J2TH', Threading::Thread);
 //------------------------------------------------------------------------------
 /**
 */
 JobThread::JobThread()
-    : wakeupEvent{ false }
+    : threadIndex(InvalidIndex)
+    , wakeupEvent{ false }
 {
     // empty
 }
@@ -57,6 +59,7 @@ JobThread::EmitWakeupSignal()
 void
 JobThread::DoWork()
 {
+    JobThreadIndex = this->threadIndex;
     if (this->enableIo)
         IO::IoServer::Create();
     if (this->enableProfiling)
@@ -213,6 +216,7 @@ JobSystemInit(const JobSystemInitInfo& info)
         Ptr<JobThread> thread = JobThread::Create();
         thread->enableIo = info.enableIo;
         thread->enableProfiling = info.enableProfiling;
+        thread->threadIndex = i;
         thread->SetName(Util::String::Sprintf("%s #%d", info.name.Value(), i));
         thread->SetThreadAffinity(info.affinity);
         thread->Start();
@@ -257,6 +261,24 @@ JobNewFrame()
     N_BUDGET_COUNTER_RESET(N_JOBS2_MEMORY_COUNTER);
 }
 
+//------------------------------------------------------------------------------
+/**
+*/
+SizeT
+JobGetNumThreads()
+{
+    return ctx.threads.Size();
+}
+
+//------------------------------------------------------------------------------
+/**
+*/
+IndexT
+JobGetThreadIndex()
+{
+    return JobThreadIndex;
+}
+
 //------------------------------------------------------------------------------
 /**
 */
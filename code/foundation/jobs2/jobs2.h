@@ -132,6 +132,8 @@ public:
     
     bool enableIo;
     bool enableProfiling;
+    /// index of the thread in the job system
+    IndexT threadIndex;
 protected:
 
     /// override this method if your thread loop needs a wakeup call before stopping
@@ -179,6 +181,11 @@ void* JobAlloc(SizeT bytes);
 /// Progress to new buffer
 void JobNewFrame();
 
+/// Get the number of job threads
+SizeT JobGetNumThreads();
+/// Get the index of the calling job thread, returns InvalidIndex if not called from a job thread
+IndexT JobGetThreadIndex();
+
 extern JobNode* sequenceNode;
 extern JobNode* sequenceTail;
 extern const Threading::AtomicCounter* prevDoneCounter;
@@ -0,0 +1,268 @@
+//------------------------------------------------------------------------------
+//  transformbatch.cc
+//  (C) 2024 Individual contributors, see AUTHORS file
+//------------------------------------------------------------------------------
+
+#include "math/transformbatch.h"
+#include "system/cpu.h"
+#include <immintrin.h>
+
+namespace Math
+{
+
+typedef SizeT (*TransformBatchEvaluateFunc)(const TransformBatch& batch, const IndexT* parents, const IndexT* order, const IndexT* follow, mat4* unscaled, mat4* scaled);
+typedef void (*TransformBatchSkinFunc)(const mat4* model, const mat4* inverseBind, const IndexT* palette, const IndexT* follow, SizeT num, mat4* out);
+
+//------------------------------------------------------------------------------
+/**
+*/
+void
+transformbatch_setup(TransformBatch& batch, float* memory, SizeT num)
+{
+    const SizeT padded = transformbatch_size(num) / 10;
+    IndexT i;
+    for (i = 0; i < 3; i++)
+    {
+        batch.translation[i] = memory + i * padded;
+        batch.scale[i] = memory + (7 + i) * padded;
+    }
+    for (i = 0; i < 4; i++)
+        batch.rotation[i] = memory + (3 + i) * padded;
+    batch.num = num;
+
+    // The padding is evaluated along with the last joints, so keep it a valid transform
+    for (i = num; i < padded; i++)
+    {
+        batch.translation[0][i] = batch.translation[1][i] = batch.translation[2][i] = 0.0f;
+        batch.rotation[0][i] = batch.rotation[1][i] = batch.rotation[2][i] = 0.0f;
+        batch.rotation[3][i] = 1.0f;
+        batch.scale[0][i] = batch.scale[1][i] = batch.scale[2][i] = 1.0f;
+    }
+}
+
+//------------------------------------------------------------------------------
+/**
+*/
+SizeT
+transformbatch_evaluate_sse(const TransformBatch& batch, const IndexT* parents, const IndexT* order, const IndexT* follow, mat4* unscaled, mat4* scaled)
+{
+    IndexT i;
+    for (i = 0; i < batch.num; i++)
+    {
+        const quat rotation(batch.rotation[0][i], batch.rotation[1][i], batch.rotation[2][i], batch.rotation[3][i]);
+        const vec3 translation(batch.translation[0][i], batch.translation[1][i], batch.translation[2][i]);
+        const vec3 scale(batch.scale[0][i], batch.scale[1][i], batch.scale[2][i]);
+        unscaled[i] = affine(vec3(1.0f), rotation, translation);
+        scaled[i] = affine(scale, rotation, translation);
+    }
+
+    SizeT numEvaluated = 0;
+    for (i = 0; i < batch.num; i++)
+    {
+        const IndexT joint = order[i];
+        if (follow != nullptr && follow[joint] != InvalidIndex)
+        {
+            scaled[joint] = scaled[follow[joint]];
+            continue;
+        }
+        numEvaluated++;
+
+        const IndexT parent = parents[joint];
+        if (parent != InvalidIndex)
+        {
+            scaled[joint] = unscaled[parent] * scaled[joint];
+            unscaled[joint] = unscaled[parent] * unscaled[joint];
+        }
+    }
+    return numEvaluated;
+}
+
+//------------------------------------------------------------------------------
+/**
+*/
+void
+transformbatch_skin_sse(const mat4* model, const mat4* inverseBind, const IndexT* palette, const IndexT* follow, SizeT num, mat4* out)
+{
+    IndexT i;
+    for (i = 0; i < num; i++)
+    {
+        IndexT joint = palette[i];
+        if (follow != nullptr && follow[joint] != InvalidIndex)
+            joint = follow[joint];
+        out[i] = model[joint] * inverseBind[joint];
+    }
+}
+
+//------------------------------------------------------------------------------
+/**
+    Transposes four rows of 8 lanes, and writes them to the same row of the
+    first num matrices
+*/
+static N_TARGET_AVX2 void
+StoreRowsAVX2(__m256 x, __m256 y, __m256 z, __m256 w, IndexT row, SizeT num, mat4* out)
+{
+    const __m256 xy0 = _mm256_unpacklo_ps(x, y);
+    const __m256 xy1 = _mm256_unpackhi_ps(x, y);
+    const __m256 zw0 = _mm256_unpacklo_ps(z, w);
+    const __m256 zw1 = _mm256_unpackhi_ps(z, w);
+
+    // Every register holds the row of matrix i in its low half, and of i + 4 in its high half
+    const __m256 rows[4] =
+    {
+        _mm256_shuffle_ps(xy0, zw0, 0x44),
+        _mm256_shuffle_ps(xy0, zw0, 0xEE),
+        _mm256_shuffle_ps(xy1, zw1, 0x44),
+        _mm256_shuffle_ps(xy1, zw1, 0xEE),
+    };
+    IndexT i;
+    for (i = 0; i < 4 && i < num; i++)
+        _mm_storeu_ps(&out[i].m[row][0], _mm256_castps256_ps128(rows[i]));
+    for (i = 4; i < num; i++)
+        _mm_storeu_ps(&out[i].m[row][0], _mm256_extractf128_ps(rows[i - 4], 1));
+}
+
+//------------------------------------------------------------------------------
+/**
+    m0 * m1 for affine matrices, two rows at a time
+*/
+static N_TARGET_AVX2 void
+AffineMultiplyAVX2(const mat4& m0, const mat4& m1, mat4& out)
+{
+    const __m256 row0 = _mm256_broadcast_ps(&m0.r[0].vec);
+    const __m256 row1 = _mm256_broadcast_ps(&m0.r[1].vec);
+    const __m256 row2 = _mm256_broadcast_ps(&m0.r[2].vec);
+    const __m256 position = _mm256_insertf128_ps(_mm256_setzero_ps(), m0.r[3].vec, 1);
+
+    const __m256 a01 = _mm256_loadu_ps(&m1.m[0][0]);
+    const __m256 a23 = _mm256_loadu_ps(&m1.m[2][0]);
+    __m256 out01 = _mm256_mul_ps(_mm256_permute_ps(a01, 0x00), row0);
+    __m256 out23 = _mm256_mul_ps(_mm256_permute_ps(a23, 0x00), row0);
+    out01 = _mm256_add_ps(out01, _mm256_mul_ps(_mm256_permute_ps(a01, 0x55), row1));
+    out23 = _mm256_add_ps(out23, _mm256_mul_ps(_mm256_permute_ps(a23, 0x55), row1));
+    out01 = _mm256_add_ps(out01, _mm256_mul_ps(_mm256_permute_ps(a01, 0xAA), row2));
+    out23 = _mm256_add_ps(out23, _mm256_mul_ps(_mm256_permute_ps(a23, 0xAA), row2));
+    out23 = _mm256_add_ps(out23, position);
+
+    _mm256_storeu_ps(&out.m[0][0], out01);
+    _mm256_storeu_ps(&out.m[2][0], out23);
+}
+
+//------------------------------------------------------------------------------
+/**
+    Builds the local matrices of 8 joints at a time from the component arrays,
+    then applies the parents one joint at a time
+*/
+N_TARGET_AVX2 SizeT
+transformbatch_evaluate_avx2(const TransformBatch& batch, const IndexT* parents, const IndexT* order, const IndexT* follow, mat4* unscaled, mat4* scaled)
+{
+    const __m256 zero = _mm256_setzero_ps();
+    const __m256 one = _mm256_set1_ps(1.0f);
+    const __m256 two = _mm256_set1_ps(2.0f);
+
+    IndexT i;
+    for (i = 0; i < batch.num; i += TransformBatchWidth)
+    {
+        const __m256 x = _mm256_loadu_ps(batch.rotation[0] + i);
+        const __m256 y = _mm256_loadu_ps(batch.rotation[1] + i);
+        const __m256 z = _mm256_loadu_ps(batch.rotation[2] + i);
+        const __m256 w = _mm256_loadu_ps(batch.rotation[3] + i);
+
+        // Same as rotationquat, which doesn't expect unit quaternions either
+        const __m256 lengthSq = _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(x, x), _mm256_mul_ps(y, y)), _mm256_add_ps(_mm256_mul_ps(z, z), _mm256_mul_ps(w, w)));
+        const __m256 s = _mm256_div_ps(two, lengthSq);
+        const __m256 xs = _mm256_mul_ps(x, s), ys = _mm256_mul_ps(y, s), zs = _mm256_mul_ps(z, s);
+        const __m256 wx = _mm256_mul_ps(w, xs), wy = _mm256_mul_ps(w, ys), wz = _mm256_mul_ps(w, zs);
+        const __m256 xx = _mm256_mul_ps(x, xs), xy = _mm256_mul_ps(x, ys), xz = _mm256_mul_ps(x, zs);
+        const __m256 yy = _mm256_mul_ps(y, ys), yz = _mm256_mul_ps(y, zs), zz = _mm256_mul_ps(z, zs);
+
+        const __m256 r00 = _mm256_sub_ps(one, _mm256_add_ps(yy, zz));
+        const __m256 r01 = _mm256_add_ps(xy, wz);
+        const __m256 r02 = _mm256_sub_ps(xz, wy);
+        const __m256 r10 = _mm256_sub_ps(xy, wz);
+        const __m256 r11 = _mm256_sub_ps(one, _mm256_add_ps(xx, zz));
+        const __m256 r12 = _mm256_add_ps(yz, wx);
+        const __m256 r20 = _mm256_add_ps(xz, wy);
+        const __m256 r21 = _mm256_sub_ps(yz, wx);
+        const __m256 r22 = _mm256_sub_ps(one, _mm256_add_ps(xx, yy));
+
+        const __m256 sx = _mm256_loadu_ps(batch.scale[0] + i);
+        const __m256 sy = _mm256_loadu_ps(batch.scale[1] + i);
+        const __m256 sz = _mm256_loadu_ps(batch.scale[2] + i);
+        const __m256 tx = _mm256_loadu_ps(batch.translation[0] + i);
+        const __m256 ty = _mm256_loadu_ps(batch.translation[1] + i);
+        const __m256 tz = _mm256_loadu_ps(batch.translation[2] + i);
+
+        const SizeT num = Math::min(TransformBatchWidth, batch.num - i);
+        StoreRowsAVX2(r00, r01, r02, zero, 0, num, unscaled + i);
+        StoreRowsAVX2(r10, r11, r12, zero, 1, num, unscaled + i);
+        StoreRowsAVX2(r20, r21, r22, zero, 2, num, unscaled + i);
+        StoreRowsAVX2(tx, ty, tz, one, 3, num, unscaled + i);
+
+        // Like affine, the scale multiplies the columns of the rotation
+        StoreRowsAVX2(_mm256_mul_ps(r00, sx), _mm256_mul_ps(r01, sy), _mm256_mul_ps(r02, sz), zero, 0, num, scaled + i);
+        StoreRowsAVX2(_mm256_mul_ps(r10, sx), _mm256_mul_ps(r11, sy), _mm256_mul_ps(r12, sz), zero, 1, num, scaled + i);
+        StoreRowsAVX2(_mm256_mul_ps(r20, sx), _mm256_mul_ps(r21, sy), _mm256_mul_ps(r22, sz), zero, 2, num, scaled + i);
+        StoreRowsAVX2(tx, ty, tz, one, 3, num, scaled + i);
+    }
+
+    SizeT numEvaluated = 0;
+    for (i = 0; i < batch.num; i++)
+    {
+        const IndexT joint = order[i];
+        if (follow != nullptr && follow[joint] != InvalidIndex)
+        {
+            scaled[joint] = scaled[follow[joint]];
+            continue;
+        }
+        numEvaluated++;
+
+        const IndexT parent = parents[joint];
+        if (parent != InvalidIndex)
+        {
+            AffineMultiplyAVX2(unscaled[parent], scaled[joint], scaled[joint]);
+            AffineMultiplyAVX2(unscaled[parent], unscaled[joint], unscaled[joint]);
+        }
+    }
+    return numEvaluated;
+}
+
+//------------------------------------------------------------------------------
+/**
+*/
+N_TARGET_AVX2 void
+transformbatch_skin_avx2(const mat4* model, const mat4* inverseBind, const IndexT* palette, const IndexT* follow, SizeT num, mat4* out)
+{
+    IndexT i;
+    for (i = 0; i < num; i++)
+    {
+        IndexT joint = palette[i];
+        if (follow != nullptr && follow[joint] != InvalidIndex)
+            joint = follow[joint];
+        AffineMultiplyAVX2(model[joint], inverseBind[joint], out[i]);
+    }
+}
+
+//------------------------------------------------------------------------------
+/**
+    Joints have to be in an order where parents come before their children,
+    unscaled and scaled have to hold batch.num matrices
+*/
+SizeT
+transformbatch_evaluate(const TransformBatch& batch, const IndexT* parents, const IndexT* order, const IndexT* follow, mat4* unscaled, mat4* scaled)
+{
+    static const TransformBatchEvaluateFunc evaluate = System::Cpu::HasFeature(System::Cpu::AVX2) ? transformbatch_evaluate_avx2 : transformbatch_evaluate_sse;
+    return evaluate(batch, parents, order, follow, unscaled, scaled);
+}
+
+//------------------------------------------------------------------------------
+/**
+    out may point straight into mapped memory, it is only written to
+*/
+void
+transformbatch_skin(const mat4* model, const mat4* inverseBind, const IndexT* palette, const IndexT* follow, SizeT num, mat4* out)
+{
+    static const TransformBatchSkinFunc skin = System::Cpu::HasFeature(System::Cpu::AVX2) ? transformbatch_skin_avx2 : transformbatch_skin_sse;
+    skin(model, inverseBind, palette, follow, num, out);
+}
+
+} // namespace Math
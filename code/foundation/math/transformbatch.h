@@ -0,0 +1,67 @@
+#pragma once
+//------------------------------------------------------------------------------
+/**
+    @file transformbatch.h
+
+    Evaluation of joint hierarchies from batches of local transforms.
+
+    A batch stores translation, rotation and scale as one array per component,
+    padded to TransformBatchWidth elements, so the local matrices of that many
+    joints are built at a time. Parents are then applied in an order where
+    every parent comes before its children.
+
+    All matrices are expected to be affine, their w column is ignored and
+    the products are computed in 3x4 form.
+
+    transformbatch_evaluate and transformbatch_skin pick the widest kernel
+    the CPU supports, the kernels themselves are only exposed for testing.
+
+    @copyright
+    (C) 2024 Individual contributors, see AUTHORS file
+*/
+//------------------------------------------------------------------------------
+#include "core/types.h"
+#include "math/mat4.h"
+namespace Math
+{
+
+/// number of joints built at a time, batches are padded to a multiple of it
+static const SizeT TransformBatchWidth = 8;
+
+struct TransformBatch
+{
+    float* translation[3];
+    float* rotation[4];
+    float* scale[3];
+    SizeT num;
+};
+
+/// get the number of floats needed for a batch of num transforms
+SizeT transformbatch_size(SizeT num);
+/// point a batch at memory of transformbatch_size(num) floats, and set the padding to identity
+void transformbatch_setup(TransformBatch& batch, float* memory, SizeT num);
+/// build the model space matrices of a hierarchy, joints with a valid follow index copy that joint instead, returns the number of joints evaluated
+SizeT transformbatch_evaluate(const TransformBatch& batch, const IndexT* parents, const IndexT* order, const IndexT* follow, mat4* unscaled, mat4* scaled);
+/// write the skin matrices of the joints in palette, joints with a valid follow index are skinned like that joint
+void transformbatch_skin(const mat4* model, const mat4* inverseBind, const IndexT* palette, const IndexT* follow, SizeT num, mat4* out);
+
+/// transformbatch_evaluate building one joint at a time
+SizeT transformbatch_evaluate_sse(const TransformBatch& batch, const IndexT* parents, const IndexT* order, const IndexT* follow, mat4* unscaled, mat4* scaled);
+/// transformbatch_evaluate building TransformBatchWidth joints at a time, only call if the CPU supports AVX2
+SizeT transformbatch_evaluate_avx2(const TransformBatch& batch, const IndexT* parents, const IndexT* order, const IndexT* follow, mat4* unscaled, mat4* scaled);
+/// transformbatch_skin using the mat4 product
+void transformbatch_skin_sse(const mat4* model, const mat4* inverseBind, const IndexT* palette, const IndexT* follow, SizeT num, mat4* out);
+/// transformbatch_skin with 3x4 products, only call if the CPU supports AVX2
+void transformbatch_skin_avx2(const mat4* model, const mat4* inverseBind, const IndexT* palette, const IndexT* follow, SizeT num, mat4* out);
+
+//------------------------------------------------------------------------------
+/**
+*/
+inline SizeT
+transformbatch_size(SizeT num)
+{
+    const SizeT padded = (num + TransformBatchWidth - 1) / TransformBatchWidth * TransformBatchWidth;
+    return padded * 10;
+}
+
+} // namespace Math
@@ -207,10 +207,12 @@ ProfilingSetupBudgetCounter(const char* id, uint64 budget)
 {
     counterLock.Enter();
 
-    // Add budget
+    // Add budget, or change the budget of an existing counter
     IndexT idx = budgetCounters.FindIndex(id);
-    n_assert(idx == InvalidIndex);
-    budgetCounters.Add(id, { budget, 0 });
+    if (idx == InvalidIndex)
+        budgetCounters.Add(id, { budget, 0 });
+    else
+        budgetCounters.ValueAtIndex(idx).first = budget;
 
     counterLock.Leave();
 }
@@ -50,6 +50,10 @@
 #define N_MARKER_END()
 #define N_COUNTER_INCR(name, value)
 #define N_COUNTER_DECR(name, value)
+#define N_BUDGET_COUNTER_SETUP(name, budget)
+#define N_BUDGET_COUNTER_INCR(name, value)
+#define N_BUDGET_COUNTER_DECR(name, value)
+#define N_BUDGET_COUNTER_RESET(name)
 #define N_DECLARE_COUNTER(name, label)
 #endif
 
@@ -0,0 +1,96 @@
+//------------------------------------------------------------------------------
+//  cpu.cc
+//  (C) 2024 Individual contributors, see AUTHORS file
+//------------------------------------------------------------------------------
+#include "foundation/stdneb.h"
+#include "system/cpu.h"
+#if __WIN32__
+#include <intrin.h>
+#else
+#include <cpuid.h>
+#endif
+
+namespace System
+{
+
+//------------------------------------------------------------------------------
+/**
+*/
+static void
+CpuId(uint32_t leaf, uint32_t subLeaf, uint32_t regs[4])
+{
+#if __WIN32__
+    __cpuidex(reinterpret_cast<int*>(regs), leaf, subLeaf);
+#else
+    __cpuid_count(leaf, subLeaf, regs[0], regs[1], regs[2], regs[3]);
+#endif
+}
+
+//------------------------------------------------------------------------------
+/**
+*/
+static uint64_t
+XGetBv()
+{
+#if __WIN32__
+    return _xgetbv(0);
+#else
+    uint32_t eax, edx;
+    __asm__ volatile("xgetbv" : "=a"(eax), "=d"(edx) : "c"(0));
+    return ((uint64_t)edx << 32) | eax;
+#endif
+}
+
+//------------------------------------------------------------------------------
+/**
+    Figures out the features once. AVX needs the OS to save the YMM registers
+    and AVX-512 needs it to save the opmask and ZMM registers as well, which
+    is checked through XGETBV.
+*/
+static Cpu::Feature
+DetectFeatures()
+{
+    uint32_t features = 0;
+    uint32_t regs[4];
+    CpuId(0, 0, regs);
+    const uint32_t maxLeaf = regs[0];
+    if (maxLeaf < 1)
+        return (Cpu::Feature)features;
+
+    CpuId(1, 0, regs);
+    const uint32_t ecx1 = regs[2];
+    if (ecx1 & (1 << 19))
+        features |= Cpu::SSE41;
+
+    const bool osxsave = (ecx1 & (1 << 27)) != 0;
+    const uint64_t xcr0 = osxsave ? XGetBv() : 0;
+    const bool ymmEnabled = (xcr0 & 0x6) == 0x6;
+    const bool zmmEnabled = (xcr0 & 0xE6) == 0xE6;
+    if (ymmEnabled && (ecx1 & (1 << 28)))
+        features |= Cpu::AVX;
+    if (ymmEnabled && (ecx1 & (1 << 12)))
+        features |= Cpu::FMA;
+
+    if (maxLeaf >= 7)
+    {
+        CpuId(7, 0, regs);
+        const uint32_t ebx7 = regs[1];
+        if (ymmEnabled && (ebx7 & (1 << 5)))
+            features |= Cpu::AVX2;
+        if (zmmEnabled && (ebx7 & (1 << 16)))
+            features |= Cpu::AVX512F;
+    }
+    return (Cpu::Feature)features;
+}
+
+//------------------------------------------------------------------------------
+/**
+*/
+bool
+Cpu::HasFeature(Feature features)
+{
+    static const Feature Supported = DetectFeatures();
+    return (Supported & features) == features;
+}
+
+} // namespace System
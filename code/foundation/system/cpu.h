@@ -4,6 +4,11 @@
     @class System::Cpu
     
     Provides information about the system's CPU(s).
+
+    HasFeature() checks whether an instruction set can be used, both by the
+    CPU and the OS, so code paths can be selected at runtime. Functions
+    marked N_TARGET_AVX, N_TARGET_AVX2 or N_TARGET_AVX512 may use that
+    instruction set whatever the build flags are.
     
     @copyright
     (C) 2007 Radon Labs GmbH
@@ -51,9 +56,34 @@ public:
         Core31 = 0x80000000,  // << Threadripper gen 1 level
         All = (Core31 << 1) - 1
     };
+
+    enum Feature : uint32_t
+    {
+        SSE41   = 0x1,
+        AVX     = 0x2,
+        AVX2    = 0x4,
+        FMA     = 0x8,
+        AVX512F = 0x10,
+    };
+
+    /// returns true if the CPU and the OS support all the given features
+    static bool HasFeature(Feature features);
 };
 
 __ImplementEnumBitOperators(System::Cpu::CoreId);
+__ImplementEnumBitOperators(System::Cpu::Feature);
 }
+
+// Wide kernels are compiled for their instruction set regardless of the
+// build flags, and only called if HasFeature() reports the CPU supports it
+#if __WIN32__
+#define N_TARGET_AVX
+#define N_TARGET_AVX2
+#define N_TARGET_AVX512
+#else
+#define N_TARGET_AVX __attribute__((target("avx")))
+#define N_TARGET_AVX2 __attribute__((target("avx2")))
+#define N_TARGET_AVX512 __attribute__((target("avx512f")))
+#endif
 //------------------------------------------------------------------------------
     
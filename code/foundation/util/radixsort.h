@@ -0,0 +1,71 @@
+#pragma once
+//------------------------------------------------------------------------------
+/**
+    @file radixsort.h
+
+    Least significant digit radix sort of 64 bit keys, 8 bits per pass.
+
+    The histograms of all digits are built in a single pass over the keys,
+    and digits which are the same for every key are skipped, so keys which
+    only differ in their lower bits take only a few passes.
+
+    @copyright
+    (C) 2024 Individual contributors, see AUTHORS file
+*/
+//------------------------------------------------------------------------------
+#include "core/types.h"
+namespace Util
+{
+
+//------------------------------------------------------------------------------
+/**
+    Sorts keys in ascending order, scratch has to hold as many keys. Returns
+    the one of the two which holds the sorted keys.
+*/
+inline uint64*
+RadixSort(uint64* keys, uint64* scratch, SizeT num)
+{
+    static const SizeT NumPasses = 8;
+    uint32 histograms[NumPasses][256] = {};
+
+    IndexT i, pass;
+    for (i = 0; i < num; i++)
+    {
+        const uint64 key = keys[i];
+        for (pass = 0; pass < NumPasses; pass++)
+            histograms[pass][(key >> (pass * 8)) & 0xFF]++;
+    }
+
+    uint64* src = keys;
+    uint64* dst = scratch;
+    for (pass = 0; pass < NumPasses && num > 1; pass++)
+    {
+        const uint shift = pass * 8;
+        uint32* histogram = histograms[pass];
+        if (histogram[(src[0] >> shift) & 0xFF] == (uint32)num)
+            continue;
+
+        // Turn the counts into where each digit starts
+        uint32 offset = 0;
+        IndexT digit;
+        for (digit = 0; digit < 256; digit++)
+        {
+            const uint32 count = histogram[digit];
+            histogram[digit] = offset;
+            offset += count;
+        }
+
+        for (i = 0; i < num; i++)
+        {
+            const uint64 key = src[i];
+            dst[histogram[(key >> shift) & 0xFF]++] = key;
+        }
+
+        uint64* tmp = src;
+        src = dst;
+        dst = tmp;
+    }
+    return src;
+}
+
+} // namespace Util
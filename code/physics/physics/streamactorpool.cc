@@ -35,7 +35,6 @@ StreamActorPool *actorPool = nullptr;
 */
 StreamActorPool::StreamActorPool()
 {
-    this->streamerThreadName = "Physics Actor Pool Streamer Thread";
 }
 
 //------------------------------------------------------------------------------
@@ -14,6 +14,10 @@
 #include "models/nodes/characterskinnode.h"
 #include "profiling/profiling.h"
 #include "resources/resourceserver.h"
+#include "graphics/cameracontext.h"
+#include "math/transformbatch.h"
+
+N_DECLARE_COUNTER(N_CHARACTER_JOINTS_EVALUATED, Character Joints Evaluated);
 
 using namespace Graphics;
 using namespace Resources;
@@ -26,6 +30,14 @@ __ImplementContext(CharacterContext, CharacterContext::characterContextAllocator
 Util::HashTable<Util::StringAtom, CoreAnimation::AnimSampleMask> CharacterContext::masks;
 Threading::Event CharacterContext::totalCompletionEvent;
 Threading::AtomicCounter CharacterContext::ConstantUpdateCounter = 0;
+CharacterContext::LodSettings CharacterContext::lodSettings;
+
+/// joints with a subtree shorter than this part of the skeleton's size follow their parent at low detail
+static const float LeafJointExtent = 0.06f;
+
+/// joints evaluated by the last frame's jobs, and joints of all characters
+static Threading::AtomicCounter NumEvaluatedJoints = 0;
+static SizeT NumJoints = 0;
 
 //------------------------------------------------------------------------------
 /**
@@ -74,6 +86,7 @@ CharacterContext::Setup(
     n_assert_fmt(cid != InvalidContextEntityId, "Entity %d is not registered in CharacterContext", id.HashCode());
     characterContextAllocator.Set<Loaded>(cid.id, NoneLoaded);
     characterContextAllocator.Set<EntityId>(cid.id, id);
+    characterContextAllocator.Set<Lod>(cid.id, AnimationLod{ 1, 0, false, false, false });
 
     // check to make sure we registered this entity for observation, then get the visibility context
     const ContextEntityId visId = Visibility::ObservableContext::GetContextId(id);
@@ -104,22 +117,21 @@ CharacterContext::Setup(
             characterContextAllocator.Get<Loaded>(cid.id) |= SkeletonLoaded;
 
             const Util::FixedArray<CharacterJoint>& joints = Characters::SkeletonGetJoints(skeleton);
-            characterContextAllocator.Get<JobJoints>(cid.id).Resize(joints.Size());
+            const Util::FixedArray<IndexT>& order = Characters::SkeletonGetEvaluationOrder(skeleton);
 
-            // setup joints, scaled joints and user controlled joints
-            characterContextAllocator.Get<JointPalette>(cid.id).Resize(joints.Size());
-            characterContextAllocator.Get<JointPaletteScaled>(cid.id).Resize(joints.Size());
+            // setup scaled joints and user controlled joints
+            Util::FixedArray<Math::mat4>& scaledJointPalette = characterContextAllocator.Get<JointPaletteScaled>(cid.id);
+            scaledJointPalette.Resize(joints.Size());
             characterContextAllocator.Get<UserControlledJoint>(cid.id).Resize(joints.Size());
 
-            // setup job joints
+            // Start out in the bind pose, which skins to identity until the first evaluation
+            const Util::FixedArray<Math::mat4>& bindPose = Characters::SkeletonGetBindPose(skeleton);
             IndexT i;
             for (i = 0; i < joints.Size(); i++)
-            {
-                const CharacterJoint& joint = joints[i];
-                SkeletonJobJoint& jobJoint = characterContextAllocator.Get<JobJoints>(cid.id)[i];
-                jobJoint.parentJointIndex = joint.parentJointIndex;
-            }
+                scaledJointPalette[i] = Math::inverse(bindPose[i]);
 
+            // Short subtrees follow the closest joint above them at low detail
+            ComputeLodJointParents(joints, order, bindPose, characterContextAllocator.Get<LodJointParents>(cid.id));
         }, nullptr, true);
 
     characterContextAllocator.Get<Animation>(cid.id) = CoreAnimation::InvalidAnimationId;
@@ -131,6 +143,7 @@ CharacterContext::Setup(
 
             // setup sample buffer when animation is done loading
             characterContextAllocator.Get<SampleBuffer>(cid.id).Setup(animation);
+            characterContextAllocator.Get<LodSamples>(cid.id).Resize(characterContextAllocator.Get<SampleBuffer>(cid.id).GetNumSamples());
             characterContextAllocator.Set<SupportMix>(cid.id, supportBlending);
         }, nullptr, true);
 
@@ -380,20 +393,27 @@ struct CharacterJobContext
     const Util::Array<CharacterContext::AnimationTracks>* tracks;
     const Util::Array<CoreAnimation::AnimationId>* anims;
     const Util::Array<CoreAnimation::AnimSampleBuffer>* sampleBuffers;
-    const Util::Array<Util::FixedArray<SkeletonJobJoint>>* jobJoints;
     const Util::Array<SkeletonId>* skeletons;
-    const Util::Array<Util::FixedArray<Math::mat4>>* jointPalettes;
     const Util::Array<Util::FixedArray<Math::mat4>>* scaledJointPalettes;
     const Util::Array<Util::FixedArray<Math::mat4>>* userJoints;
     float** tmpSamples;
     uint** tmpSampleIndices;
     Math::mat4** tmpJoints;
+    float** tmpBatches;
     
     const Util::Array<Graphics::GraphicsEntityId>* entities;
     CoreAnimation::AnimSampleMixInfo* animMixInfos;
     float frameTime;
     Timing::Tick time;
     Timing::Tick ticks;
+
+    const Util::Array<IndexT>* characterSkinNodeIndices;
+    const Util::Array<CharacterContext::AnimationLod>* lods;
+    const Util::Array<Util::FixedArray<float>>* lodSamples;
+    const Util::Array<Util::FixedArray<IndexT>>* lodJointParents;
+    CharacterContext::LodSettings lodSettings;
+    Math::point cameraPosition;
+    float projectionScale;
 };
 
 //------------------------------------------------------------------------------
@@ -419,22 +439,57 @@ EvalCharacter(SizeT totalJobs, SizeT groupSize, IndexT groupIndex, SizeT invocat
         const AnimationId anim = context->anims->Get(index);
         if (anim == InvalidAnimationId)
             continue;
-        const Util::FixedArray<SkeletonJobJoint>& jobJoint = context->jobJoints->Get(index);
         const SkeletonId skeleton = context->skeletons->Get(index);
         if (skeleton == InvalidSkeletonId)
             continue;
-        const Util::FixedArray<Math::mat4>& bindPose = Characters::SkeletonGetBindPose(skeleton);
-        const Util::FixedArray<Characters::CharacterJoint>& joints = Characters::SkeletonGetJoints(skeleton);
-        const Util::FixedArray<Math::mat4>& jointPalette = context->jointPalettes->Get(index);
         const Util::FixedArray<Math::mat4>& scaledJointPalette = context->scaledJointPalettes->Get(index);
         const Util::FixedArray<Math::vec4>& idleSamples = Characters::SkeletonGetIdleSamples(skeleton);
         const CoreAnimation::AnimSampleBuffer& sampleBuffer = context->sampleBuffers->Get(index);
-        Math::mat4* tmpMatrices = context->tmpJoints[index];
         float* tmpSamples = context->tmpSamples[index];
         uint* tmpSampleIndices = context->tmpSampleIndices[index];
         auto sampleMixInfo = context->animMixInfos + index;
         bool runSkeletonThisFrame = false;
 
+        // Pick the level of detail from what the observers saw last frame
+        const Graphics::GraphicsEntityId entity = context->entities->Get(index);
+        if (entity == Graphics::InvalidGraphicsEntityId)
+            continue;
+        CharacterContext::AnimationLod& lod = context->lods->Get(index);
+        const CharacterContext::LodSettings& settings = context->lodSettings;
+        const Models::NodeInstanceRange& range = Models::ModelContext::GetModelRenderableRange(entity);
+        const Models::ModelContext::ModelInstance::Renderable& renderables = Models::ModelContext::GetModelRenderables();
+        const IndexT node = range.begin + context->characterSkinNodeIndices->Get(index);
+        const float screenSize = CharacterContext::LodScreenSize(renderables.nodeBoundingBoxes[node], context->cameraPosition, context->projectionScale);
+        const bool wasVisible = AllBits(renderables.nodeFlags[node], Models::NodeInstanceFlags::NodeInstance_WasVisible);
+
+        // Characters nobody saw keep their last pose, and don't interpolate from it once seen again
+        const bool evaluate = !settings.skipInvisible || wasVisible || !lod.evaluated;
+        if (!evaluate)
+        {
+            lod.framesSinceUpdate = lod.updateInterval;
+            lod.interpolate = false;
+        }
+
+        // Sample ahead, and interpolate towards it until the next sampling
+        bool sampleThisFrame = false;
+        Timing::Tick sampleAhead = 0;
+        if (evaluate && ++lod.framesSinceUpdate >= lod.updateInterval)
+        {
+            const SizeT interval = lod.interpolate ? CharacterContext::LodUpdateInterval(screenSize, settings) : 1;
+            if (interval > 1)
+            {
+                Util::FixedArray<float>& prevSamples = context->lodSamples->Get(index);
+                Memory::Copy(sampleBuffer.GetSamplesPointer(), prevSamples.Begin(), prevSamples.ByteSize());
+                sampleAhead = Timing::SecondsToTicks(context->frameTime * interval);
+            }
+            lod.updateInterval = interval;
+            lod.framesSinceUpdate = 0;
+            lod.interpolate = true;
+            sampleThisFrame = true;
+        }
+        const bool interpolatePose = lod.updateInterval > 1;
+        const float interpolation = (float)lod.framesSinceUpdate / lod.updateInterval;
+
         // loop over all tracks, and update the playing clip on each respective track
         bool firstAnimTrack = true;
         IndexT j;
@@ -542,28 +597,23 @@ EvalCharacter(SizeT totalJobs, SizeT groupSize, IndexT groupIndex, SizeT invocat
                 sampleMixInfo->sampleType = SampleType::Linear;
                 sampleMixInfo->velocityScale.set(playing.timeFactor, playing.timeFactor, playing.timeFactor, 0);
 
-                // Get pointers to memory and size
-                const float* srcPtr = buffer->GetKeyBufferPointer();
-                const AnimKeyBuffer::Interval* srcTimePtr = buffer->GetIntervalBufferPointer();
-
                 const Util::FixedArray<AnimCurve>& curves = CoreAnimation::AnimGetCurves(anim);
-                Timing::Tick evalTime = playing.sampleTime % clip.duration;
+                Timing::Tick evalTime = (playing.sampleTime + (playing.paused ? 0 : sampleAhead)) % clip.duration;
 
-                if (firstAnimTrack
+                // Between samplings, only the tracks are kept going
+                if (!sampleThisFrame)
+                {
+                    // empty
+                }
+                else if (firstAnimTrack
                     || playing.blend != 1.0f)
                 {
-                    if (sampleMixInfo->sampleType == SampleType::Step)
-                        AnimSampleStep(clip, curves, evalTime, sampleMixInfo->velocityScale, idleSamples, srcPtr, srcTimePtr, playing.curveSampleIndices.Begin(), sampleBuffer.GetSamplesPointer(), sampleBuffer.GetSampleCountsPointer());
-                    else
-                        AnimSampleLinear(clip, curves, evalTime, sampleMixInfo->velocityScale, idleSamples, srcPtr, srcTimePtr, playing.curveSampleIndices.Begin(), sampleBuffer.GetSamplesPointer(), sampleBuffer.GetSampleCountsPointer());
+                    AnimSample(sampleMixInfo->sampleType, clip, curves, evalTime, sampleMixInfo->velocityScale, idleSamples, buffer, playing.curveSampleIndices.Begin(), sampleBuffer.GetSamplesPointer(), sampleBuffer.GetSampleCountsPointer());
                 }
                 else // Playing with mix
                 {
                     uchar tmpSampleCounts = 0;
-                    if (sampleMixInfo->sampleType == SampleType::Step)
-                        AnimSampleStep(clip, curves, evalTime, sampleMixInfo->velocityScale, idleSamples, srcPtr, srcTimePtr, tmpSampleIndices, tmpSamples, &tmpSampleCounts);
-                    else
-                        AnimSampleLinear(clip, curves, evalTime, sampleMixInfo->velocityScale, idleSamples, srcPtr, srcTimePtr, tmpSampleIndices, tmpSamples, &tmpSampleCounts);
+                    AnimSample(sampleMixInfo->sampleType, clip, curves, evalTime, sampleMixInfo->velocityScale, idleSamples, buffer, tmpSampleIndices, tmpSamples, &tmpSampleCounts);
 
                     AnimMix(clip, curves.Size(), playing.mask, sampleMixInfo->mixWeight, sampleBuffer.GetSamplesPointer(), tmpSamples, sampleBuffer.GetSampleCountsPointer(), &tmpSampleCounts, sampleBuffer.GetSamplesPointer(), sampleBuffer.GetSampleCountsPointer());
                 }
@@ -578,66 +628,17 @@ EvalCharacter(SizeT totalJobs, SizeT groupSize, IndexT groupIndex, SizeT invocat
         }
 
         // If we have no animations, just skip the character skeleton update
-        if (!runSkeletonThisFrame)
+        if (!runSkeletonThisFrame || !evaluate)
             continue;
-
-        // Evaluate skeleton
-        const Math::mat4* invPoseMatrixBase = bindPose.Begin();
-        Math::mat4* unscaledMatrixBase = tmpMatrices;
-
-        Math::vec3 translate(0.0f, 0.0f, 0.0f);
-        Math::vec3 scale(1.0f, 1.0f, 1.0f);
-        Math::quat rotate;
-
-        // load pointers from context
-        // NOTE: the samplesBase pointer may be NULL if no valid animation
-        // data exists, in this case the skeleton should simply be set
-        // to its jesus pose
-        const SkeletonJobJoint* compsBase = jobJoint.Begin();
-        n_assert(0 != compsBase);
-        const float* samplesBase = sampleBuffer.GetSamplesPointer();
-        const float* samplesPtr = samplesBase;
-
-        Math::mat4* scaledMatrixBase = scaledJointPalette.Begin();
-        Math::mat4* skinMatrixBase = jointPalette.Begin();
-
-        // input samples may optionally include velocity samples which we need to skip...
-        uint sampleWidth = (sampleBuffer.GetNumSamples() / jointPalette.Size());
-
-        // compute number of joints
-        int jointIndex;
-        for (jointIndex = 0; jointIndex < jointPalette.Size(); jointIndex++)
-        {
-            static const size_t TRANSLATION_OFFSET = 0;
-            static const size_t ROTATION_OFFSET = 3;
-            static const size_t SCALE_OFFSET = 7;
-
-            translate.load(samplesPtr + TRANSLATION_OFFSET);
-            rotate.load(samplesPtr + ROTATION_OFFSET);
-            scale.load(samplesPtr + SCALE_OFFSET);
-
-            samplesPtr += sampleWidth;
-
-            const SkeletonJobJoint& comps = compsBase[jointIndex];
-
-            Math::mat4& unscaledMatrix = unscaledMatrixBase[jointIndex];
-            Math::mat4& scaledMatrix = scaledMatrixBase[jointIndex];
-
-            Math::vec3 baseScale = xyz(idleSamples[jointIndex * 3 + 2]);
-
-            // update unscaled matrix
-            // animation rotation
-            scaledMatrix = Math::affine(scale, rotate, translate);
-            unscaledMatrix = Math::affine(Math::vec3(1), rotate, translate);
-            if (InvalidIndex != comps.parentJointIndex)
-            {
-                const Math::mat4& parentUnscaledMatrix = unscaledMatrixBase[comps.parentJointIndex];
-                scaledMatrix = parentUnscaledMatrix * scaledMatrix;
-                unscaledMatrix = parentUnscaledMatrix * unscaledMatrix;
-            }
-
-            skinMatrixBase[jointIndex] = scaledMatrix * invPoseMatrixBase[jointIndex];
-        }
+        lod.evaluated = true;
+
+        // Evaluate skeleton, the skin matrices are made from it when the constants are written
+        const float* prevSamples = interpolatePose ? context->lodSamples->Get(index).Begin() : nullptr;
+        const IndexT* followJoints = CharacterContext::LodFollowsParents(screenSize, settings) ? context->lodJointParents->Get(index).Begin() : nullptr;
+        const SizeT sampleWidth = sampleBuffer.GetNumSamples() / scaledJointPalette.Size();
+        const SizeT numEvaluated = SkeletonEvaluate(skeleton, sampleBuffer.GetSamplesPointer(), prevSamples, interpolation, sampleWidth, followJoints, context->tmpBatches[index], context->tmpJoints[index], scaledJointPalette.Begin());
+        lod.followParents = followJoints != nullptr;
+        Threading::Interlocked::Add(&NumEvaluatedJoints, (int)numEvaluated);
     }
 }
 
@@ -653,15 +654,20 @@ CharacterContext::UpdateAnimations(const Graphics::FrameContext& ctx)
     const Util::Array<AnimationTracks>& tracks = characterContextAllocator.GetArray<TrackController>();
     const Util::Array<AnimationId>& anims = characterContextAllocator.GetArray<Animation>();
     const Util::Array<CoreAnimation::AnimSampleBuffer>& sampleBuffers = characterContextAllocator.GetArray<SampleBuffer>();
-    const Util::Array<Util::FixedArray<SkeletonJobJoint>>& jobJoints = characterContextAllocator.GetArray<JobJoints>();
     const Util::Array<SkeletonId>& skeletons = characterContextAllocator.GetArray<Skeleton>();
-    const Util::Array<Util::FixedArray<Math::mat4>>& jointPalettes = characterContextAllocator.GetArray<JointPalette>();
     const Util::Array<Util::FixedArray<Math::mat4>>& scaledJointPalettes = characterContextAllocator.GetArray<JointPaletteScaled>();
     const Util::Array<Util::FixedArray<Math::mat4>>& userJoints = characterContextAllocator.GetArray<UserControlledJoint>();
     const Util::Array<Graphics::GraphicsEntityId>& models = characterContextAllocator.GetArray<EntityId>();
     const Util::Array<bool>& supportsBlending = characterContextAllocator.GetArray<SupportMix>();
     const Util::Array<IndexT>& characterSkinNodeIndices = characterContextAllocator.GetArray<CharacterSkinNodeIndexOffset>();
 
+    // Report the joints evaluated last frame, its jobs are done by now
+    N_BUDGET_COUNTER_SETUP(N_CHARACTER_JOINTS_EVALUATED, NumJoints);
+    N_BUDGET_COUNTER_RESET(N_CHARACTER_JOINTS_EVALUATED);
+    N_BUDGET_COUNTER_INCR(N_CHARACTER_JOINTS_EVALUATED, NumEvaluatedJoints);
+    NumEvaluatedJoints = 0;
+    NumJoints = 0;
+
     if (!models.IsEmpty())
     {
         static Threading::AtomicCounter animationCounter = 0;
@@ -675,9 +681,7 @@ CharacterContext::UpdateAnimations(const Graphics::FrameContext& ctx)
         charCtx.tracks = &tracks;
         charCtx.anims = &anims;
         charCtx.sampleBuffers = &sampleBuffers;
-        charCtx.jobJoints = &jobJoints;
         charCtx.skeletons = &skeletons;
-        charCtx.jointPalettes = &jointPalettes;
         charCtx.scaledJointPalettes = &scaledJointPalettes;
         charCtx.userJoints = &userJoints;
         charCtx.entities = &models;
@@ -685,8 +689,19 @@ CharacterContext::UpdateAnimations(const Graphics::FrameContext& ctx)
         charCtx.ticks = ctx.ticks;
         charCtx.time = ctx.time;
         charCtx.animMixInfos = Jobs2::JobAlloc<AnimSampleMixInfo>(models.Size());
+        charCtx.characterSkinNodeIndices = &characterSkinNodeIndices;
+        charCtx.lods = &characterContextAllocator.GetArray<Lod>();
+        charCtx.lodSamples = &characterContextAllocator.GetArray<LodSamples>();
+        charCtx.lodJointParents = &characterContextAllocator.GetArray<LodJointParents>();
+        charCtx.lodSettings = lodSettings;
+
+        // Screen sizes are measured from the LOD camera
+        const Graphics::GraphicsEntityId lodCamera = Graphics::CameraContext::GetLODCamera();
+        charCtx.cameraPosition = Graphics::CameraContext::GetTransform(lodCamera).position;
+        charCtx.projectionScale = Graphics::CameraContext::GetProjection(lodCamera).r[1].y;
 
         charCtx.tmpJoints = Jobs2::JobAlloc<Math::mat4*>(models.Size());
+        charCtx.tmpBatches = Jobs2::JobAlloc<float*>(models.Size());
         charCtx.tmpSampleIndices = Jobs2::JobAlloc<uint*>(models.Size());
         charCtx.tmpSamples = Jobs2::JobAlloc<float*>(models.Size());
 
@@ -697,8 +712,10 @@ CharacterContext::UpdateAnimations(const Graphics::FrameContext& ctx)
                 continue;
 
             // Allocate scratch memory for character transforms
-            const Util::FixedArray<Math::mat4>& jointPalette = jointPalettes[i];
+            const Util::FixedArray<Math::mat4>& jointPalette = scaledJointPalettes[i];
             charCtx.tmpJoints[i] = Jobs2::JobAlloc<Math::mat4>(jointPalette.Size());
+            charCtx.tmpBatches[i] = Jobs2::JobAlloc<float>(Math::transformbatch_size(jointPalette.Size()));
+            NumJoints += jointPalette.Size();
 
             // Allocate scratch memory for animation mixing
             const CoreAnimation::AnimSampleBuffer& sampleBuffer = sampleBuffers[i];
@@ -709,18 +726,21 @@ CharacterContext::UpdateAnimations(const Graphics::FrameContext& ctx)
             }
         }
 
-        // Run job
-        Jobs2::JobDispatch(EvalCharacter, models.Size(), 64, charCtx, nullptr, &animationCounter, nullptr);
+        // Run job once the bounding boxes and visibility flags of the models are updated
+        Jobs2::JobDispatch(EvalCharacter, models.Size(), 64, charCtx, { &Models::ModelContext::LodUpdateCounter }, &animationCounter, nullptr);
 
         n_assert(ConstantUpdateCounter == 0);
         ConstantUpdateCounter = 1;
 
-        // Run job to update constants
+        // Run job to write the skin matrices straight into constant memory
         Jobs2::JobDispatch(
             [
                 characterNodeIndices = characterSkinNodeIndices.ConstBegin()
                 , entities = models.ConstBegin()
-                , jointPalettes = jointPalettes.ConstBegin()
+                , skeletons = skeletons.ConstBegin()
+                , scaledJointPalettes = scaledJointPalettes.ConstBegin()
+                , lods = characterContextAllocator.GetArray<Lod>().ConstBegin()
+                , lodJointParents = characterContextAllocator.GetArray<LodJointParents>().ConstBegin()
             ]
         (SizeT totalJobs, SizeT groupSize, IndexT groupIndex, SizeT invocationOffset)
         {
@@ -738,27 +758,27 @@ CharacterContext::UpdateAnimations(const Graphics::FrameContext& ctx)
                 const Models::NodeInstanceRange& range = Models::ModelContext::GetModelRenderableRange(entity);
                 const Models::ModelContext::ModelInstance::Renderable& renderables = Models::ModelContext::GetModelRenderables();
 
-                const Util::FixedArray<Math::mat4>& jointPalette = jointPalettes[index];
+                const Util::FixedArray<Math::mat4>& scaledJointPalette = scaledJointPalettes[index];
                 IndexT node = range.begin + characterNodeIndices[index];
                 n_assert(renderables.nodeTypes[node] == Models::NodeType::CharacterSkinNodeType);
                 Models::CharacterSkinNode* sparent = reinterpret_cast<Models::CharacterSkinNode*>(renderables.nodes[node]);
                 const Util::Array<IndexT>& usedIndices = sparent->skinFragments[0].jointPalette;
-                Util::FixedArray<Math::mat4, true> usedMatrices(usedIndices.Size());
 
-                // update joints, which is stored in character context
-                if (!jointPalette.IsEmpty())
+                // Update skinning palette, or set identity until the skeleton is loaded
+                const CoreGraphics::ConstantBufferOffset offset = CoreGraphics::AllocateConstantBufferMemory(usedIndices.Size() * sizeof(Math::mat4));
+                Math::mat4* palette = (Math::mat4*)CoreGraphics::GetConstantBufferMemory(offset);
+                if (!scaledJointPalette.IsEmpty())
+                {
+                    const Util::FixedArray<Math::mat4>& bindPose = Characters::SkeletonGetBindPose(skeletons[index]);
+                    const IndexT* followJoints = lods[index].followParents ? lodJointParents[index].Begin() : nullptr;
+                    Math::transformbatch_skin(scaledJointPalette.Begin(), bindPose.Begin(), usedIndices.Begin(), followJoints, usedIndices.Size(), palette);
+                }
+                else
                 {
-                    // copy active matrix palette, or set identity
                     IndexT j;
                     for (j = 0; j < usedIndices.Size(); j++)
-                    {
-                        const IndexT lookup = usedIndices[j];
-                        usedMatrices[j] = jointPalette[lookup];
-                    }
+                        palette[j] = Math::mat4::identity;
                 }
-
-                // Update skinning palette
-                uint64 offset = CoreGraphics::SetConstants(usedMatrices.Begin(), usedMatrices.Size());
                 renderables.nodeStates[node].resourceTableOffsets[renderables.nodeStates[node].skinningConstantsIndex] = offset;
             }
 
@@ -789,6 +809,101 @@ CharacterContext::CreateAnimSampleMask(const Util::StringAtom& name, const Util:
     return &CharacterContext::masks.ValueAtIndex(name, index);
 }
 
+//------------------------------------------------------------------------------
+/**
+    The fraction of the screen height covered by the bounding sphere of a box
+*/
+float
+CharacterContext::LodScreenSize(const Math::bbox& box, const Math::point& cameraPosition, float projectionScale)
+{
+    const float radius = Math::length(box.extents());
+    const float distance = Math::length(box.center() - cameraPosition);
+    if (distance <= radius)
+        return 1.0f;
+    return radius * projectionScale / distance;
+}
+
+//------------------------------------------------------------------------------
+/**
+    Below the full rate size, the interval doubles every time the size halves
+*/
+SizeT
+CharacterContext::LodUpdateInterval(float screenSize, const LodSettings& settings)
+{
+    SizeT interval = 1;
+    float size = settings.fullRateScreenSize;
+    while (screenSize < size && interval < settings.maxUpdateInterval)
+    {
+        interval *= 2;
+        size *= 0.5f;
+    }
+    return interval;
+}
+
+//------------------------------------------------------------------------------
+/**
+*/
+bool
+CharacterContext::LodFollowsParents(float screenSize, const LodSettings& settings)
+{
+    return screenSize < settings.leafJointScreenSize;
+}
+
+//------------------------------------------------------------------------------
+/**
+    Joints whose subtree is shorter than a part of the skeleton's size get the
+    closest ancestor which is still evaluated, all other joints get InvalidIndex
+*/
+void
+CharacterContext::ComputeLodJointParents(const Util::FixedArray<CharacterJoint>& joints, const Util::FixedArray<IndexT>& order, const Util::FixedArray<Math::mat4>& bindPose, Util::FixedArray<IndexT>& outParents)
+{
+    Util::FixedArray<Math::vec3> positions(joints.Size());
+    Util::FixedArray<float> subtreeExtents(joints.Size(), 0.0f);
+    Math::bbox box;
+    box.begin_extend();
+    IndexT i;
+    for (i = 0; i < joints.Size(); i++)
+    {
+        positions[i] = Math::xyz(Math::inverse(bindPose[i]).position);
+        box.extend(positions[i]);
+    }
+
+    // Measure the longest chain of bones below every joint, walking the
+    // evaluation order backwards sees a subtree before its root
+    for (i = order.Size() - 1; i >= 0; i--)
+    {
+        const IndexT joint = order[i];
+        const IndexT parent = joints[joint].parentJointIndex;
+        if (parent != InvalidIndex)
+            subtreeExtents[parent] = Math::max(subtreeExtents[parent], subtreeExtents[joint] + Math::length(positions[joint] - positions[parent]));
+    }
+
+    // Short subtrees follow the closest joint above them which is still evaluated
+    outParents.Resize(joints.Size());
+    const float minExtent = LeafJointExtent * box.diagonal_size();
+    for (i = 0; i < order.Size(); i++)
+    {
+        const IndexT joint = order[i];
+        const IndexT parent = joints[joint].parentJointIndex;
+        if (parent == InvalidIndex)
+            outParents[joint] = InvalidIndex;
+        else if (outParents[parent] != InvalidIndex)
+            outParents[joint] = outParents[parent];
+        else
+            outParents[joint] = subtreeExtents[joint] < minExtent ? parent : InvalidIndex;
+    }
+}
+
+//------------------------------------------------------------------------------
+/**
+*/
+void
+CharacterContext::SetLodSettings(const LodSettings& settings)
+{
+    n_assert(settings.maxUpdateInterval >= 1);
+    CharacterContext::lodSettings = settings;
+}
+
 //------------------------------------------------------------------------------
 /**
 */
@@ -21,6 +21,16 @@
         Animations can be played without enqueueing, which replaces the currently
         playing animation on that track.
 
+    Characters are evaluated at a level of detail picked from how large they
+    were on screen and whether any observer saw them the previous frame:
+        Characters nobody saw are not sampled or evaluated, their time still runs.
+        Small characters sample their animations every few frames, ahead of time,
+        and interpolate towards the sampled pose in the frames between.
+        Below a smaller size, joints with very short subtrees, like fingers and
+        face joints, follow their parent instead of being evaluated.
+
+    Skeletons are evaluated several joints at a time from a Math::TransformBatch,
+    and the skin matrices are written straight into constant memory.
 
     @copyright
     (C) 2018-2020 Individual contributors, see AUTHORS file
@@ -33,7 +43,6 @@
 #include "characters/skeleton.h"
 #include "coreanimation/animation.h"
 #include "coreanimation/animsamplebuffer.h"
-#include "characters/skeletonjoint.h"
 #include "jobs/jobs.h"
 
 namespace CoreAnimation
@@ -47,6 +56,8 @@ extern void AnimSampleJobWithMix(SizeT totalJobs, SizeT groupSize, IndexT groupI
 namespace Characters
 {
 
+extern SizeT SkeletonEvaluate(const SkeletonId skeleton, const float* samples, const float* prevSamples, const float interpolation, const SizeT sampleWidth, const IndexT* followJoints, float* batchMemory, Math::mat4* unscaledJoints, Math::mat4* scaledJoints);
+
 enum EnqueueMode
 {
     Append,             // adds clip to the queue to play after current on the track
@@ -127,6 +138,30 @@ public:
     /// get anim sample mask by name
     static CoreAnimation::AnimSampleMask* GetAnimSampleMask(const Util::StringAtom& name);
 
+    /// level of detail settings, screen sizes are the fraction of the screen height covered by a character
+    struct LodSettings
+    {
+        /// below this size, the frames between two samplings double each time the size halves
+        float fullRateScreenSize = 0.25f;
+        /// most frames between two samplings
+        SizeT maxUpdateInterval = 8;
+        /// below this size, short leaf joints follow their parent
+        float leafJointScreenSize = 0.1f;
+        /// don't evaluate characters which no observer saw the previous frame
+        bool skipInvisible = true;
+    };
+
+    /// set level of detail settings
+    static void SetLodSettings(const LodSettings& settings);
+    /// get the fraction of the screen height covered by a bounding box
+    static float LodScreenSize(const Math::bbox& box, const Math::point& cameraPosition, float projectionScale);
+    /// get the frames between two samplings for a character of a screen size
+    static SizeT LodUpdateInterval(float screenSize, const LodSettings& settings);
+    /// check if short leaf joints follow their parent for a character of a screen size
+    static bool LodFollowsParents(float screenSize, const LodSettings& settings);
+    /// compute the joint each joint follows at low detail, or InvalidIndex if it is evaluated
+    static void ComputeLodJointParents(const Util::FixedArray<CharacterJoint>& joints, const Util::FixedArray<IndexT>& order, const Util::FixedArray<Math::mat4>& bindPose, Util::FixedArray<IndexT>& outParents);
+
 #ifndef PUBLIC_DEBUG    
     /// debug rendering
     static void OnRenderDebug(uint32_t flags);
@@ -168,6 +203,15 @@ private:
     friend Timing::Tick GetAbsoluteStopTime(const CharacterContext::AnimationRuntime& runtime);
     friend void EvalCharacter(SizeT totalJobs, SizeT groupSize, IndexT groupIndex, SizeT invocationOffset, void* ctx);
 
+    struct AnimationLod
+    {
+        SizeT updateInterval;       // frames between the last sampling and the next
+        SizeT framesSinceUpdate;
+        bool evaluated;             // the joint palette has been evaluated at least once
+        bool interpolate;           // the samples of the previous sampling are valid to interpolate from
+        bool followParents;         // short leaf joints followed their parent in the last evaluation
+    };
+
     static const SizeT MaxNumTracks = 16;
     struct AnimationTracks
     {
@@ -182,14 +226,15 @@ private:
         Loaded,
         TrackController,
         AnimTime,
-        JointPalette,
         JointPaletteScaled,
         UserControlledJoint,
-        JobJoints,
         SampleBuffer,
         SupportMix,
         EntityId,
-        CharacterSkinNodeIndexOffset
+        CharacterSkinNodeIndexOffset,
+        Lod,
+        LodSamples,
+        LodJointParents
     };
 
     typedef Ids::IdAllocator<
@@ -200,12 +245,13 @@ private:
         Timing::Time,
         Util::FixedArray<Math::mat4>,
         Util::FixedArray<Math::mat4>,
-        Util::FixedArray<Math::mat4>,
-        Util::FixedArray<SkeletonJobJoint>,
         CoreAnimation::AnimSampleBuffer,
         bool,
         Graphics::GraphicsEntityId,
-        IndexT
+        IndexT,
+        AnimationLod,
+        Util::FixedArray<float>,
+        Util::FixedArray<IndexT>
     > CharacterContextAllocator;
     static CharacterContextAllocator characterContextAllocator;
 
@@ -216,6 +262,7 @@ private:
 
     static Util::HashTable<Util::StringAtom, CoreAnimation::AnimSampleMask> masks;
     static Threading::Event totalCompletionEvent;
+    static LodSettings lodSettings;
 };
 
 __ImplementEnumBitOperators(CharacterContext::LoadState);
@@ -20,6 +20,34 @@ CreateSkeleton(const SkeletonCreateInfo& info)
     skeletonAllocator.Set<Skeleton_JointNameMap>(id, info.jointIndexMap);
     skeletonAllocator.Set<Skeleton_IdleSamples>(id, info.idleSamples);
 
+    // Sort the joints by their depth in the hierarchy, so every parent is evaluated before its children
+    const SizeT numJoints = info.joints.Size();
+    Util::FixedArray<IndexT> parents(numJoints);
+    Util::FixedArray<IndexT> depths(numJoints);
+    IndexT maxDepth = 0;
+    IndexT i;
+    for (i = 0; i < numJoints; i++)
+    {
+        parents[i] = info.joints[i].parentJointIndex;
+        depths[i] = 0;
+        IndexT parent;
+        for (parent = parents[i]; parent != InvalidIndex; parent = info.joints[parent].parentJointIndex)
+            depths[i]++;
+        maxDepth = Math::max(maxDepth, depths[i]);
+    }
+    Util::FixedArray<IndexT> order(numJoints);
+    IndexT depth, next = 0;
+    for (depth = 0; depth <= maxDepth && next < numJoints; depth++)
+    {
+        for (i = 0; i < numJoints; i++)
+        {
+            if (depths[i] == depth)
+                order[next++] = i;
+        }
+    }
+    skeletonAllocator.Set<Skeleton_JointParents>(id, parents);
+    skeletonAllocator.Set<Skeleton_EvaluationOrder>(id, order);
+
     SkeletonId ret = id;
     return ret;
 }
@@ -78,4 +106,22 @@ SkeletonGetIdleSamples(const SkeletonId id)
     return skeletonAllocator.Get<Skeleton_IdleSamples>(id.id);
 }
 
+//------------------------------------------------------------------------------
+/**
+*/
+const Util::FixedArray<IndexT>&
+SkeletonGetJointParents(const SkeletonId id)
+{
+    return skeletonAllocator.Get<Skeleton_JointParents>(id.id);
+}
+
+//------------------------------------------------------------------------------
+/**
+*/
+const Util::FixedArray<IndexT>&
+SkeletonGetEvaluationOrder(const SkeletonId id)
+{
+    return skeletonAllocator.Get<Skeleton_EvaluationOrder>(id.id);
+}
+
 } // namespace Characters
@@ -49,20 +49,28 @@ const Util::FixedArray<Math::mat4>& SkeletonGetBindPose(const SkeletonId id);
 const IndexT SkeletonGetJointIndex(const SkeletonId id, const Util::StringAtom& name);
 /// Get idle samples
 const Util::FixedArray<Math::vec4>& SkeletonGetIdleSamples(const SkeletonId id);
+/// get the parent index of every joint
+const Util::FixedArray<IndexT>& SkeletonGetJointParents(const SkeletonId id);
+/// get the joints in an order where parents come before their children
+const Util::FixedArray<IndexT>& SkeletonGetEvaluationOrder(const SkeletonId id);
 
 enum
 {
     Skeleton_Joints,
     Skeleton_BindPose,
     Skeleton_JointNameMap,
-    Skeleton_IdleSamples
+    Skeleton_IdleSamples,
+    Skeleton_JointParents,
+    Skeleton_EvaluationOrder
 };
 
 typedef Ids::IdAllocator<
     Util::FixedArray<CharacterJoint>,
     Util::FixedArray<Math::mat4>,
     Util::HashTable<Util::StringAtom, IndexT>,
-    Util::FixedArray<Math::vec4>
+    Util::FixedArray<Math::vec4>,
+    Util::FixedArray<IndexT>,
+    Util::FixedArray<IndexT>
 > SkeletonAllocator;
 extern SkeletonAllocator skeletonAllocator;
 
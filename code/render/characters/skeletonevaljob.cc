@@ -3,10 +3,8 @@
 //  (C) 2018-2020 Individual contributors, see AUTHORS file
 //------------------------------------------------------------------------------
 
-#include "jobs/jobs.h"
-#include "math/vec4.h"
-#include "math/mat4.h"
-#include "characters/skeletonjoint.h"
+#include "math/transformbatch.h"
+#include "characters/skeleton.h"
 #include "profiling/profiling.h"
 
 using namespace Math;
@@ -15,216 +13,73 @@ namespace Characters
 
 //------------------------------------------------------------------------------
 /**
+    Gathers the translation, rotation and scale samples of every joint into a
+    batch and evaluates the skeleton from it. If prevSamples is set, the pose
+    is interpolated from it, rotations are blended linearly since the batch
+    doesn't need them normalized.
+
+    batchMemory has to hold transformbatch_size(numJoints) floats, and both
+    matrix arrays numJoints matrices. Returns the number of joints evaluated.
 */
-void
-SkeletonEvalJob(const Jobs::JobFuncContext& ctx)
+SizeT
+SkeletonEvaluate(
+    const SkeletonId skeleton
+    , const float* samples
+    , const float* prevSamples
+    , const float interpolation
+    , const SizeT sampleWidth
+    , const IndexT* followJoints
+    , float* batchMemory
+    , mat4* unscaledJoints
+    , mat4* scaledJoints)
 {
-    N_SCOPE_ACCUM(SkeletonEvaluateAndTransform, Character);
-    mat4* invPoseMatrixBase = (mat4*)ctx.uniforms[0];
-    mat4* mixPoseMatrixBase = (mat4*)ctx.uniforms[1];
-    mat4* unscaledMatrixBase = (mat4*)ctx.scratch;
-
-    for (ptrdiff sliceIdx = 0; sliceIdx < ctx.numSlices; sliceIdx++)
-    {
-        vec4 finalScale, parentFinalScale, variationTranslation;
-        vec4 translate(0.0f, 0.0f, 0.0f, 1.0f);
-        vec4 scale(1.0f, 1.0f, 1.0f, 0.0f);
-        vec4 parentScale(1.0f, 1.0f, 1.0f, 0.0f);
-        vec4 parentTranslate(0.0f, 0.0f, 0.0f, 1.0f);
-        quat rotate;
-        vec4 vec1111(1.0f, 1.0f, 1.0f, 1.0f);
+    N_SCOPE_ACCUM(SkeletonEvaluate, Character);
+    static const SizeT TranslationOffset = 0;
+    static const SizeT RotationOffset = 3;
+    static const SizeT ScaleOffset = 7;
 
-        // load pointers from context
-        // NOTE: the samplesBase pointer may be NULL if no valid animation
-        // data exists, in this case the skeleton should simply be set
-        // to its jesus pose
-        SkeletonJobJoint* compsBase = (SkeletonJobJoint*)(ctx.inputs[0] + sliceIdx * ctx.inputSizes[0]);
-        n_assert(0 != compsBase);
-        const vec4* samplesBase = (const vec4*)(ctx.inputs[1] + sliceIdx * ctx.inputSizes[1]);
-        const vec4* samplesPtr = samplesBase;
+    const SizeT numJoints = SkeletonGetNumJoints(skeleton);
+    TransformBatch batch;
+    transformbatch_setup(batch, batchMemory, numJoints);
 
-        mat4* scaledMatrixBase = (mat4*)(ctx.outputs[0] + sliceIdx * ctx.outputSizes[0]);
-        mat4* skinMatrixBase = (mat4*)(ctx.outputs[1] + sliceIdx * ctx.outputSizes[1]);
-
-        // input samples may optionally include velocity samples which we need to skip...
-        uint numElements = ctx.inputSizes[0] / sizeof(SkeletonJobJoint);
-        uint sampleWidth = (ctx.inputSizes[1] / numElements) / sizeof(vec4);
-
-        // compute number of joints
-        int jointIndex;
-        int numJoints = ctx.inputSizes[0] / sizeof(SkeletonJobJoint);
-        for (jointIndex = 0; jointIndex < numJoints; jointIndex++)
+    IndexT i, j;
+    if (prevSamples == nullptr)
+    {
+        for (i = 0; i < numJoints; i++)
         {
-            // load joint translate/rotate/scale
-            translate.load((scalar*)&(samplesPtr[0]));
-            rotate.load((scalar*)&(samplesPtr[1]));
-            scale.load((scalar*)&(samplesPtr[2]));
-            samplesPtr += sampleWidth;
-
-            const SkeletonJobJoint& comps = compsBase[jointIndex];
-
-            // load variation scale
-            finalScale.load(&comps.varScaleX);
-            finalScale = scale * finalScale;
-            finalScale = permute(finalScale, vec1111, 0, 1, 2, 7);
-
-            mat4& unscaledMatrix = unscaledMatrixBase[jointIndex];
-            mat4& scaledMatrix = scaledMatrixBase[jointIndex];
-
-            // update unscaled matrix
-            // animation rotation
-            unscaledMatrix = rotationquat(rotate);
-
-            // load variation translation
-            variationTranslation.load(&comps.varTranslationX);
-            unscaledMatrix.translate(xyz(translate + variationTranslation));
-
-            // add mix pose if the pointer is set
-            if (mixPoseMatrixBase)
-                unscaledMatrix = mixPoseMatrixBase[jointIndex] * unscaledMatrix;
-
-            // update scaled matrix
-            // scale after rotation
-            scaledMatrix.x_axis = unscaledMatrix.x_axis * splat_x(finalScale);
-            scaledMatrix.y_axis = unscaledMatrix.y_axis * splat_y(finalScale);
-            scaledMatrix.z_axis = unscaledMatrix.z_axis * splat_z(finalScale);
-
-            if (InvalidIndex == comps.parentJointIndex)
+            const float* jointSamples = samples + i * sampleWidth;
+            for (j = 0; j < 3; j++)
             {
-                // no parent directly set translation
-                scaledMatrix.position = unscaledMatrix.position;
+                batch.translation[j][i] = jointSamples[TranslationOffset + j];
+                batch.scale[j][i] = jointSamples[ScaleOffset + j];
             }
-            else
-            {
-                // load parent animation scale
-                parentScale.load((scalar*)(samplesBase + sampleWidth * jointIndex + 2));
-                const SkeletonJobJoint& parentComps = compsBase[comps.parentJointIndex];
-
-                // combine both scaling types
-                parentFinalScale.load(&parentComps.varScaleX);
-                parentFinalScale = parentScale * parentFinalScale;
-                parentFinalScale = permute(parentFinalScale, vec1111, 0, 1, 2, 7);
-
-                // transform our unscaled position with parent scaling
-                unscaledMatrix.position = unscaledMatrix.position * parentFinalScale;
-                scaledMatrix.position = unscaledMatrix.position;
-
-                // apply rotation and relative animation translation of parent 
-                const mat4& parentUnscaledMatrix = unscaledMatrixBase[comps.parentJointIndex];
-                unscaledMatrix = parentUnscaledMatrix * unscaledMatrix;
-                scaledMatrix = parentUnscaledMatrix * scaledMatrix;
-            }
-            skinMatrixBase[jointIndex] = scaledMatrix * invPoseMatrixBase[jointIndex];
+            for (j = 0; j < 4; j++)
+                batch.rotation[j][i] = jointSamples[RotationOffset + j];
         }
     }
-}
-
-//------------------------------------------------------------------------------
-/**
-*/
-void
-SkeletonEvalJobWithVariation(const Jobs::JobFuncContext& ctx)
-{
-    N_SCOPE_ACCUM(SkeletonEvaluateAndTransformWithVariation, Character);
-    mat4* invPoseMatrixBase = (mat4*)ctx.uniforms[0];
-    mat4* mixPoseMatrixBase = (mat4*)ctx.uniforms[1];
-    mat4* unscaledMatrixBase = (mat4*)ctx.scratch;
-
-    for (ptrdiff sliceIdx = 0; sliceIdx < ctx.numSlices; sliceIdx++)
+    else
     {
-        vec4 finalScale, parentFinalScale, variationTranslation;
-        vec4 translate(0.0f, 0.0f, 0.0f, 1.0f);
-        vec4 scale(1.0f, 1.0f, 1.0f, 0.0f);
-        vec4 parentScale(1.0f, 1.0f, 1.0f, 0.0f);
-        vec4 parentTranslate(0.0f, 0.0f, 0.0f, 1.0f);
-        quat rotate;
-        vec4 vec1111(1.0f, 1.0f, 1.0f, 1.0f);
-
-        // load pointers from context
-        // NOTE: the samplesBase pointer may be NULL if no valid animation
-        // data exists, in this case the skeleton should simply be set
-        // to its jesus pose
-        SkeletonJobJoint* compsBase = (SkeletonJobJoint*)N_JOB_INPUT(ctx, sliceIdx, 0);
-        n_assert(0 != compsBase);
-        const vec4* samplesBase = (const vec4*)N_JOB_INPUT(ctx, sliceIdx, 1);
-        const vec4* samplesPtr = samplesBase;
-
-        mat4* scaledMatrixBase = (mat4*)N_JOB_OUTPUT(ctx, sliceIdx, 0);
-        mat4* skinMatrixBase = (mat4*)N_JOB_OUTPUT(ctx, sliceIdx, 1);
-
-        // input samples may optionally include velocity samples which we need to skip...
-        uint numElements = ctx.inputSizes[0] / sizeof(SkeletonJobJoint);
-        uint sampleWidth = (ctx.inputSizes[1] / numElements) / sizeof(vec4);
-
-        // compute number of joints
-        int jointIndex;
-        int numJoints = ctx.inputSizes[0] / sizeof(SkeletonJobJoint);
-        for (jointIndex = 0; jointIndex < numJoints; jointIndex++)
+        for (i = 0; i < numJoints; i++)
         {
-            // load joint translate/rotate/scale
-            translate.load((scalar*)&(samplesPtr[0]));
-            rotate.load((scalar*)&(samplesPtr[1]));
-            scale.load((scalar*)&(samplesPtr[2]));
-            samplesPtr += sampleWidth;
-
-            const SkeletonJobJoint& comps = compsBase[jointIndex];
-
-            // load variation scale
-            finalScale.load(&comps.varScaleX);
-            finalScale = scale * finalScale;
-            finalScale = permute(finalScale, vec1111, 0, 1, 2, 7);
-
-            mat4& unscaledMatrix = unscaledMatrixBase[jointIndex];
-            mat4& scaledMatrix = scaledMatrixBase[jointIndex];
-
-            // update unscaled matrix
-            // animation rotation
-            unscaledMatrix = rotationquat(rotate);
-
-            // load variation translation
-            variationTranslation.load(&comps.varTranslationX);
-            unscaledMatrix.translate(xyz(translate + variationTranslation));
-
-            // add mix pose if the pointer is set
-            if (mixPoseMatrixBase)  
-                unscaledMatrix = mixPoseMatrixBase[jointIndex] * unscaledMatrix;
-
-            // update scaled matrix
-            // scale after rotation
-            scaledMatrix.x_axis = unscaledMatrix.x_axis * splat_x(finalScale);
-            scaledMatrix.y_axis = unscaledMatrix.y_axis * splat_y(finalScale);
-            scaledMatrix.z_axis = unscaledMatrix.z_axis * splat_z(finalScale);
-
-            if (InvalidIndex == comps.parentJointIndex)
+            const float* jointSamples = samples + i * sampleWidth;
+            const float* prevJointSamples = prevSamples + i * sampleWidth;
+            for (j = 0; j < 3; j++)
             {
-                // no parent directly set translation
-                scaledMatrix.position = unscaledMatrix.position;
+                batch.translation[j][i] = Math::lerp(prevJointSamples[TranslationOffset + j], jointSamples[TranslationOffset + j], interpolation);
+                batch.scale[j][i] = Math::lerp(prevJointSamples[ScaleOffset + j], jointSamples[ScaleOffset + j], interpolation);
             }
-            else
-            {
-                // load parent animation scale
-                parentScale.load((scalar*)(samplesBase + sampleWidth * jointIndex + 2));
-                const SkeletonJobJoint& parentComps = compsBase[comps.parentJointIndex];
 
-                // load parent variation scale
-                parentFinalScale.load(&parentComps.varScaleX);
-
-                // combine both scaling types
-                parentFinalScale = parentScale * parentFinalScale;
-                parentFinalScale = permute(parentFinalScale, vec1111, 0, 1, 2, 7);
-
-                // transform our unscaled position with parent scaling
-                unscaledMatrix.position = unscaledMatrix.position * parentFinalScale;
-                scaledMatrix.position = unscaledMatrix.position;
-
-                // apply rotation and relative animation translation of parent 
-                const mat4& parentUnscaledMatrix = unscaledMatrixBase[comps.parentJointIndex];
-                unscaledMatrix = parentUnscaledMatrix * unscaledMatrix;
-                scaledMatrix = parentUnscaledMatrix * scaledMatrix;
-            }
-            skinMatrixBase[jointIndex] = scaledMatrix * invPoseMatrixBase[jointIndex];
+            // Blend along the shorter arc
+            float dot = 0.0f;
+            for (j = 0; j < 4; j++)
+                dot += prevJointSamples[RotationOffset + j] * jointSamples[RotationOffset + j];
+            const float sign = dot < 0.0f ? -1.0f : 1.0f;
+            for (j = 0; j < 4; j++)
+                batch.rotation[j][i] = Math::lerp(prevJointSamples[RotationOffset + j] * sign, jointSamples[RotationOffset + j], interpolation);
         }
     }
+
+    return transformbatch_evaluate(batch, SkeletonGetJointParents(skeleton).Begin(), SkeletonGetEvaluationOrder(skeleton).Begin(), followJoints, unscaledJoints, scaledJoints);
 }
 
 } // namespace Characters
@@ -7,6 +7,7 @@
 #include "nskfileformatstructs.h"
 #include "util/fourcc.h"
 #include "skeletonresource.h"
+#include "io/mappedview.h"
 using namespace IO;
 namespace Characters
 {
@@ -19,12 +20,18 @@ __ImplementClass(Characters::SkeletonLoader, 'SSKP', Resources::ResourceLoader)
 Resources::ResourceLoader::ResourceInitOutput
 SkeletonLoader::InitializeResource(const ResourceLoadJob& job, const Ptr<IO::Stream>& stream)
 {
-    // map buffer
+    // map the file, joints are converted in place without reading it into a buffer first
     Resources::ResourceLoader::ResourceInitOutput ret;
-    byte* ptr = (byte*)stream->Map();
+    Ptr<MappedView> view = MappedView::Create();
+    if (!view->Setup(stream))
+    {
+        n_warning("StreamSkeletonCache::InitializeResource(): failed to map '%s'!\n", stream->GetURI().AsString().AsCharPtr());
+        return ret;
+    }
+    const byte* ptr = (const byte*)view->GetPointer();
 
     // read header
-    Nsk3Header* header = (Nsk3Header*)ptr;
+    const Nsk3Header* header = (const Nsk3Header*)ptr;
     ptr += sizeof(Nsk3Header);
 
     // check magic value
@@ -38,7 +45,7 @@ SkeletonLoader::InitializeResource(const ResourceLoadJob& job, const Ptr<IO::Str
     skeletons.Fill(InvalidSkeletonId);
     for (uint skeletonIndex = 0; skeletonIndex < header->numSkeletons; skeletonIndex++)
     {
-        Nsk3Skeleton* nsk3Skeleton = (Nsk3Skeleton*)ptr;
+        const Nsk3Skeleton* nsk3Skeleton = (const Nsk3Skeleton*)ptr;
         ptr += sizeof(Nsk3Skeleton);
 
         // load joints
@@ -55,7 +62,7 @@ SkeletonLoader::InitializeResource(const ResourceLoadJob& job, const Ptr<IO::Str
             uint jointIndex;
             for (jointIndex = 0; jointIndex < nsk3Skeleton->numJoints; jointIndex++)
             {
-                Nsk3Joint* joint = (Nsk3Joint*)ptr;
+                const Nsk3Joint* joint = (const Nsk3Joint*)ptr;
                 ptr += sizeof(Nsk3Joint);
 
                 // setup base components
@@ -89,7 +96,7 @@ SkeletonLoader::InitializeResource(const ResourceLoadJob& job, const Ptr<IO::Str
             skeletons[skeletonIndex] = skeleton;
         }
     }
-    stream->Unmap();
+    view->Discard();
 
     auto id = skeletonResourceAllocator.Alloc();
     skeletonResourceAllocator.Set<0>(id, skeletons);
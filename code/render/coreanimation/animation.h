@@ -17,6 +17,7 @@
 #include "coreanimation/animclip.h"
 #include "coreanimation/animkeybuffer.h"
 #include "coreanimation/animsamplemask.h"
+#include "coreanimation/sampletype.h"
 
 //------------------------------------------------------------------------------
 namespace CoreAnimation
@@ -64,6 +65,57 @@ extern void AnimSampleLinear(
     uchar* outSampleCounts
 );
 
+//------------------------------------------------------------------------------
+/**
+    Same as AnimSampleStep, for compressed keys
+*/
+extern void AnimSampleStep(
+    const AnimClip& clip,
+    const Util::FixedArray<AnimCurve>& curves,
+    const Timing::Tick time,
+    const Math::vec4& velocityScale,
+    const Util::FixedArray<Math::vec4>& idleSamples,
+    const ushort* srcSamplePtr,
+    const AnimKeyBuffer::Interval* intervalPtr,
+    uint* outSampleKeyPtr,
+    float* outSamplePtr,
+    uchar* outSampleCounts
+);
+
+//------------------------------------------------------------------------------
+/**
+    Same as AnimSampleLinear, for compressed keys
+*/
+extern void AnimSampleLinear(
+    const AnimClip& clip,
+    const Util::FixedArray<AnimCurve>& curves,
+    const Timing::Tick time,
+    const Math::vec4& velocityScale,
+    const Util::FixedArray<Math::vec4>& idleSamples,
+    const ushort* srcSamplePtr,
+    const AnimKeyBuffer::Interval* intervalPtr,
+    uint* outSampleKeyPtr,
+    float* outSamplePtr,
+    uchar* outSampleCounts
+);
+
+//------------------------------------------------------------------------------
+/**
+    Samples the keys of a buffer, compressed or not
+*/
+extern void AnimSample(
+    const SampleType::Code sampleType,
+    const AnimClip& clip,
+    const Util::FixedArray<AnimCurve>& curves,
+    const Timing::Tick time,
+    const Math::vec4& velocityScale,
+    const Util::FixedArray<Math::vec4>& idleSamples,
+    const Ptr<AnimKeyBuffer>& keyBuffer,
+    uint* outSampleKeyPtr,
+    float* outSamplePtr,
+    uchar* outSampleCounts
+);
+
 //------------------------------------------------------------------------------
 /**
 */
@@ -8,6 +8,8 @@
 #include "coreanimation/animationresource.h"
 #include "system/byteorder.h"
 #include "coreanimation/naxfileformatstructs.h"
+#include "coreanimation/animkeycompression.h"
+#include "io/mappedview.h"
 
 namespace CoreAnimation
 {
@@ -27,15 +29,22 @@ AnimationLoader::InitializeResource(const ResourceLoadJob& job, const Ptr<IO::St
     Ptr<AnimKeyBuffer> keyBuffer = nullptr;
     Resources::ResourceLoader::ResourceInitOutput ret;
     
-    // map buffer
-    uchar* ptr = (uchar*)stream->Map();
+    // map the file, the key buffers point directly into it
+    Ptr<MappedView> view = MappedView::Create();
+    if (!view->Setup(stream))
+    {
+        n_warning("StreamAnimationLoader::InitializeResource(): failed to map '%s'!\n", stream->GetURI().AsString().AsCharPtr());
+        return ret;
+    }
+    const uchar* ptr = (const uchar*)view->GetPointer();
 
     // read header
-    Nax3Header* naxHeader = (Nax3Header*)ptr;
+    const Nax3Header* naxHeader = (const Nax3Header*)ptr;
     ptr += sizeof(Nax3Header);
 
     // check magic value
-    if (FourCC(naxHeader->magic) != NEBULA_NAX3_MAGICNUMBER)
+    const bool compressed = FourCC(naxHeader->magic) == NEBULA_NAX3_COMPRESSED_MAGICNUMBER;
+    if (FourCC(naxHeader->magic) != NEBULA_NAX3_MAGICNUMBER && !compressed)
     {
         n_error("StreamAnimationLoader::InitializeResource(): '%s' has invalid file format (magic number doesn't match)!", stream->GetURI().AsString().AsCharPtr());
         return ret;
@@ -46,17 +55,20 @@ AnimationLoader::InitializeResource(const ResourceLoadJob& job, const Ptr<IO::St
     animations.Fill(InvalidAnimationId);
     for (IndexT animationIndex = 0; animationIndex < naxHeader->numAnimations; animationIndex++)
     {
-        Nax3Anim* anim = (Nax3Anim*)ptr;
+        const Nax3Anim* anim = (const Nax3Anim*)ptr;
         ptr += sizeof(Nax3Anim);
 
         Util::HashTable<Util::StringAtom, IndexT, 32> clipIndices;
         Util::FixedArray<AnimCurve> curves;
+        Util::FixedArray<const Nax3CompressedCurve*> compressedCurves;
         if (anim->numCurves > 0)
         {
             curves.SetSize(anim->numCurves);
+            if (compressed)
+                compressedCurves.SetSize(anim->numCurves);
             for (IndexT curveIndex = 0; curveIndex < anim->numCurves; curveIndex++)
             {
-                Nax3Curve* naxCurve = (Nax3Curve*)ptr;
+                const Nax3Curve* naxCurve = (const Nax3Curve*)ptr;
                 ptr += sizeof(Nax3Curve);
 
                 AnimCurve& curve = curves[curveIndex];
@@ -65,6 +77,16 @@ AnimationLoader::InitializeResource(const ResourceLoadJob& job, const Ptr<IO::St
                 curve.preInfinityType = (CoreAnimation::InfinityType::Code)naxCurve->preInfinityType;
                 curve.postInfinityType = (CoreAnimation::InfinityType::Code)naxCurve->postInfinityType;
                 curve.curveType = (CoreAnimation::CurveType::Code)naxCurve->curveType;
+
+                // compressed keys are quantized to the range of their curve
+                if (compressed)
+                {
+                    const Nax3CompressedCurve* naxCompressed = (const Nax3CompressedCurve*)ptr;
+                    ptr += sizeof(Nax3CompressedCurve);
+                    curve.keyOffset.set(naxCompressed->offset[0], naxCompressed->offset[1], naxCompressed->offset[2], 0.0f);
+                    curve.keyScale.set(naxCompressed->scale[0], naxCompressed->scale[1], naxCompressed->scale[2], 0.0f);
+                    compressedCurves[curveIndex] = naxCompressed;
+                }
             }
         }
 
@@ -74,7 +96,7 @@ AnimationLoader::InitializeResource(const ResourceLoadJob& job, const Ptr<IO::St
             events.SetSize(anim->numEvents);
             for (IndexT eventIndex = 0; eventIndex < anim->numEvents; eventIndex++)
             {
-                Nax3AnimEvent* naxEvent = (Nax3AnimEvent*)ptr;
+                const Nax3AnimEvent* naxEvent = (const Nax3AnimEvent*)ptr;
                 ptr += sizeof(Nax3AnimEvent);
 
                 AnimEvent& event = events[eventIndex];
@@ -91,7 +113,7 @@ AnimationLoader::InitializeResource(const ResourceLoadJob& job, const Ptr<IO::St
             clips.SetSize(anim->numClips);
             for (IndexT clipIndex = 0; clipIndex < anim->numClips; clipIndex++)
             {
-                Nax3Clip* naxClip = (Nax3Clip*)ptr;
+                const Nax3Clip* naxClip = (const Nax3Clip*)ptr;
                 ptr += sizeof(Nax3Clip);
 
                 // setup anim clip object
@@ -114,10 +136,41 @@ AnimationLoader::InitializeResource(const ResourceLoadJob& job, const Ptr<IO::St
 
         // Load keys
         keyBuffer = AnimKeyBuffer::Create();
-        keyBuffer->Setup(anim->numIntervals, anim->numKeys, ptr, ptr + sizeof(Nax3Interval) * anim->numIntervals);
+        if (compressed)
+        {
+            // expand the interval durations, the keys of a curve follow each other
+            const ushort* durations = (const ushort*)ptr;
+            ptr += Math::align(sizeof(ushort) * anim->numIntervals, 4);
+            Util::FixedArray<AnimKeyBuffer::Interval> intervals(anim->numIntervals);
+            IndexT curveIndex;
+            for (curveIndex = 0; curveIndex < curves.Size(); curveIndex++)
+            {
+                const AnimCurve& curve = curves[curveIndex];
+                Timing::Tick time = compressedCurves[curveIndex]->startTime;
+                uint key = compressedCurves[curveIndex]->firstKey;
+                IndexT i;
+                for (i = 0; i < (IndexT)curve.numIntervals; i++)
+                {
+                    AnimKeyBuffer::Interval& interval = intervals[curve.firstIntervalOffset + i];
+                    interval.start = time;
+                    interval.end = time + durations[curve.firstIntervalOffset + i];
+                    interval.key0 = key;
+                    interval.key1 = key + AnimKeyCompressedStride;
+                    interval.duration = 1 / float(interval.end - interval.start);
+                    time = interval.end;
+                    key = interval.key1;
+                }
+            }
+            keyBuffer->Setup(anim->numIntervals, anim->numKeys, intervals.Begin(), ptr, view, compressed);
+            ptr += Math::align(keyBuffer->GetByteSize(), 4);
+        }
+        else
+        {
+            keyBuffer->Setup(anim->numIntervals, anim->numKeys, ptr, ptr + sizeof(Nax3Interval) * anim->numIntervals, view, compressed);
 
-        // Advance pointer by keys and timings
-        ptr += anim->numKeys * sizeof(float) + anim->numIntervals * sizeof(AnimKeyBuffer::Interval);
+            // Advance pointer by keys and timings
+            ptr += keyBuffer->GetByteSize() + anim->numIntervals * sizeof(AnimKeyBuffer::Interval);
+        }
 
         // Create animation
         AnimationCreateInfo info;
@@ -130,8 +183,8 @@ AnimationLoader::InitializeResource(const ResourceLoadJob& job, const Ptr<IO::St
         animations[animationIndex] = animid;
     }
 
-    // unmap memory
-    stream->Unmap();
+    // the key buffers keep the view alive, if any of them points into it
+    view = nullptr;
 
     auto id = animationResourceAllocator.Alloc();
     animationResourceAllocator.Set<0>(id, animations);
@@ -11,6 +11,9 @@
     For performance reasons, AnimCurve's are not as flexible as their
     Maya counterparts, for instance it is not possible to set 
     the pre- and post-infinity types per curve, but only per clip.
+
+    If the keys are compressed, the keys of translation, scale and velocity
+    curves are quantized to the range given by keyOffset and keyScale.
     
     @copyright
     (C) 2008 Radon Labs GmbH
@@ -35,6 +38,8 @@ public:
     CoreAnimation::InfinityType::Code preInfinityType;
     CoreAnimation::InfinityType::Code postInfinityType;
     CurveType::Code curveType;
+    Math::vec4 keyOffset;
+    Math::vec4 keyScale;
 };
 
 //------------------------------------------------------------------------------
@@ -47,6 +52,8 @@ AnimCurve::AnimCurve()
     , preInfinityType(CoreAnimation::InfinityType::InvalidInfinityType)
     , postInfinityType(CoreAnimation::InfinityType::InvalidInfinityType)
     , curveType(CoreAnimation::CurveType::InvalidCurveType)
+    , keyOffset(0.0f)
+    , keyScale(0.0f)
 {
     // empty
 }
@@ -18,7 +18,9 @@ using namespace Math;
 AnimKeyBuffer::AnimKeyBuffer()
     : numKeys(0)
     , numIntervals(0)
-    , mapCount(0)
+    , compressed(false)
+    , keysMapped(false)
+    , intervalsMapped(false)
     , keyBuffer(nullptr)
     , intervalBuffer(nullptr)
 {
@@ -38,18 +40,50 @@ AnimKeyBuffer::~AnimKeyBuffer()
 
 //------------------------------------------------------------------------------
 /**
+    Keys and intervals are each read in place from the view, unless they
+    are not in it or not aligned for their types, in which case they are
+    copied.
 */
 void
-AnimKeyBuffer::Setup(SizeT numIntervals, SizeT numKeys, void* intervalPtr, void* keyPtr)
+AnimKeyBuffer::Setup(SizeT numIntervals, SizeT numKeys, const void* intervalPtr, const void* keyPtr, const Ptr<IO::MappedView>& view, bool compressed)
 {
     n_assert(!this->IsValid());
     this->numIntervals = numIntervals;
     this->numKeys = numKeys;
-    this->mapCount = 0;
-    this->keyBuffer = (float*)Memory::Alloc(Memory::ResourceHeap, sizeof(float) * this->numKeys);
-    Memory::Copy(keyPtr, this->keyBuffer, this->GetByteSize());
-    this->intervalBuffer = (AnimKeyBuffer::Interval*)Memory::Alloc(Memory::ResourceHeap, sizeof(AnimKeyBuffer::Interval) * this->numIntervals);
-    Memory::Copy(intervalPtr, this->intervalBuffer, sizeof(AnimKeyBuffer::Interval) * this->numIntervals);
+    this->compressed = compressed;
+    SizeT const intervalSize = sizeof(AnimKeyBuffer::Interval) * this->numIntervals;
+    SizeT const keyAlignment = compressed ? alignof(ushort) : alignof(float);
+    this->keysMapped = view.isvalid()
+        && view->Contains(keyPtr, this->GetByteSize())
+        && ((uintptr_t)keyPtr % keyAlignment) == 0;
+    this->intervalsMapped = view.isvalid()
+        && view->Contains(intervalPtr, intervalSize)
+        && ((uintptr_t)intervalPtr % alignof(AnimKeyBuffer::Interval)) == 0;
+
+    if (this->keysMapped)
+    {
+        this->keyBuffer = keyPtr;
+    }
+    else
+    {
+        void* keys = Memory::Alloc(Memory::ResourceHeap, this->GetByteSize());
+        Memory::Copy(keyPtr, keys, this->GetByteSize());
+        this->keyBuffer = keys;
+    }
+
+    if (this->intervalsMapped)
+    {
+        this->intervalBuffer = (const AnimKeyBuffer::Interval*)intervalPtr;
+    }
+    else
+    {
+        AnimKeyBuffer::Interval* intervals = (AnimKeyBuffer::Interval*)Memory::Alloc(Memory::ResourceHeap, intervalSize);
+        Memory::Copy(intervalPtr, intervals, intervalSize);
+        this->intervalBuffer = intervals;
+    }
+
+    if (this->keysMapped || this->intervalsMapped)
+        this->view = view;
 }
 
 //------------------------------------------------------------------------------
@@ -59,11 +93,18 @@ void
 AnimKeyBuffer::Discard()
 {
     n_assert(this->IsValid());
-    Memory::Free(Memory::ResourceHeap, this->keyBuffer);
-    this->keyBuffer = 0;
-    Memory::Free(Memory::ResourceHeap, this->intervalBuffer);
-    this->intervalBuffer = 0;
+    if (!this->keysMapped)
+        Memory::Free(Memory::ResourceHeap, (void*)this->keyBuffer);
+    if (!this->intervalsMapped)
+        Memory::Free(Memory::ResourceHeap, (void*)this->intervalBuffer);
+    this->view = nullptr;
+    this->keyBuffer = nullptr;
+    this->intervalBuffer = nullptr;
+    this->keysMapped = false;
+    this->intervalsMapped = false;
     this->numKeys = 0;
+    this->numIntervals = 0;
+    this->compressed = false;
 }
 
 } // namespace CoreAnimation
@@ -3,7 +3,14 @@
 /**
     @class CoreAnimation::AnimKeyBuffer
     
-    A simple buffer of vec4 animation keys.
+    A simple buffer of animation keys, either floats or compressed keys
+    as described in animkeycompression.h.
+
+    If the keys or intervals are set up from a mapped view, the buffer points
+    directly into the view and keeps a reference to it, otherwise they are
+    copied.
+    A view of a file only holds the mapping, the file itself is closed once
+    the loader is done with it.
     
     @copyright
     (C) 2008 Radon Labs GmbH
@@ -11,6 +18,7 @@
 */
 #include "core/refcounted.h"
 #include "timing/time.h"
+#include "io/mappedview.h"
 
 //------------------------------------------------------------------------------
 namespace CoreAnimation
@@ -30,8 +38,8 @@ public:
     AnimKeyBuffer();
     /// destructor
     virtual ~AnimKeyBuffer();
-    /// setup the buffer
-    void Setup(SizeT numIntervals, SizeT numKeys, void* intervalPtr, void* keyPtr);
+    /// setup the buffer, points into the view if one is given and the keys are aligned, numKeys counts floats or ushorts if compressed
+    void Setup(SizeT numIntervals, SizeT numKeys, const void* intervalPtr, const void* keyPtr, const Ptr<IO::MappedView>& view = nullptr, bool compressed = false);
     /// discard the buffer
     void Discard();
     /// return true if the object has been setup
@@ -40,17 +48,26 @@ public:
     SizeT GetNumKeys() const;
     /// get buffer size in bytes
     SizeT GetByteSize() const;
-    /// Get direct pointer to keys
+    /// return true if the keys point into a mapped view
+    bool IsMapped() const;
+    /// return true if the keys are compressed
+    bool IsCompressed() const;
+    /// Get direct pointer to keys, nullptr if compressed
     const float* GetKeyBufferPointer() const;
+    /// get direct pointer to compressed keys, nullptr if not compressed
+    const ushort* GetCompressedKeyBufferPointer() const;
     /// get direct pointer to interval buffer
     const AnimKeyBuffer::Interval* GetIntervalBufferPointer() const;
 
 private:
     SizeT numKeys;
     SizeT numIntervals;
-    uint mapCount;
-    float* keyBuffer;
-    AnimKeyBuffer::Interval* intervalBuffer;
+    bool compressed;
+    bool keysMapped;
+    bool intervalsMapped;
+    const void* keyBuffer;
+    const AnimKeyBuffer::Interval* intervalBuffer;
+    Ptr<IO::MappedView> view;
 };
 
 //------------------------------------------------------------------------------
@@ -77,7 +94,25 @@ AnimKeyBuffer::GetNumKeys() const
 inline SizeT
 AnimKeyBuffer::GetByteSize() const
 {
-    return this->numKeys * sizeof(float);
+    return this->numKeys * (this->compressed ? sizeof(ushort) : sizeof(float));
+}
+
+//------------------------------------------------------------------------------
+/**
+*/
+inline bool
+AnimKeyBuffer::IsMapped() const
+{
+    return this->keysMapped;
+}
+
+//------------------------------------------------------------------------------
+/**
+*/
+inline bool
+AnimKeyBuffer::IsCompressed() const
+{
+    return this->compressed;
 }
 
 //------------------------------------------------------------------------------
@@ -86,7 +121,16 @@ AnimKeyBuffer::GetByteSize() const
 inline const float*
 AnimKeyBuffer::GetKeyBufferPointer() const
 {
-    return this->keyBuffer;
+    return this->compressed ? nullptr : (const float*)this->keyBuffer;
+}
+
+//------------------------------------------------------------------------------
+/**
+*/
+inline const ushort*
+AnimKeyBuffer::GetCompressedKeyBufferPointer() const
+{
+    return this->compressed ? (const ushort*)this->keyBuffer : nullptr;
 }
 
 //------------------------------------------------------------------------------
@@ -0,0 +1,123 @@
+#pragma once
+//------------------------------------------------------------------------------
+/**
+    @file animkeycompression.h
+
+    Encoding and decoding of compressed animation keys, shared by the
+    exporter and the samplers. Every key takes 3 ushorts.
+
+    Rotations are stored as the three smallest components of the
+    quaternion, with 15 bits each. The index of the largest component is
+    kept in the top bits of the first two words, the largest component
+    itself follows from the quaternion being of unit length. Since q and
+    -q are the same rotation, the largest component is always positive.
+
+    Translations, scales and velocities are quantized to 16 bits each in
+    the range of their curve, key = offset + quantized * scale.
+
+    The decoders read 4 ushorts, so buffers of compressed keys have to be
+    padded by one ushort.
+
+    @copyright
+    (C) 2024 Individual contributors, see AUTHORS file
+*/
+//------------------------------------------------------------------------------
+#include "core/types.h"
+#include "math/quat.h"
+#include "math/vec4.h"
+namespace CoreAnimation
+{
+
+/// number of ushorts per compressed key
+static const SizeT AnimKeyCompressedStride = 3;
+/// the three smallest components of a unit quaternion are in [-range, range], range = 1/sqrt(2)
+static const float AnimKeyRotationRange = 0.70710678f;
+
+//------------------------------------------------------------------------------
+/**
+*/
+inline void
+AnimKeyEncodeRotation(const Math::quat& rotation, ushort* key)
+{
+    float q[4] = { rotation.x, rotation.y, rotation.z, rotation.w };
+    const float length = Math::sqrt(q[0] * q[0] + q[1] * q[1] + q[2] * q[2] + q[3] * q[3]);
+    uint largest = 0;
+    IndexT i;
+    for (i = 1; i < 4; i++)
+    {
+        if (Math::abs(q[i]) > Math::abs(q[largest]))
+            largest = i;
+    }
+    const float sign = q[largest] < 0.0f ? -1.0f : 1.0f;
+
+    // The smallest components are in [-1/sqrt(2), 1/sqrt(2)]
+    uint words[3];
+    IndexT j = 0;
+    for (i = 0; i < 4; i++)
+    {
+        if (i == largest)
+            continue;
+        const float value = q[i] * sign / length;
+        const float quantized = (value + AnimKeyRotationRange) * (32767.0f / (2.0f * AnimKeyRotationRange)) + 0.5f;
+        words[j++] = (uint)Math::clamp(quantized, 0.0f, 32767.0f);
+    }
+    key[0] = (ushort)(words[0] | ((largest & 1) << 15));
+    key[1] = (ushort)(words[1] | ((largest >> 1) << 15));
+    key[2] = (ushort)words[2];
+}
+
+//------------------------------------------------------------------------------
+/**
+*/
+inline void
+AnimKeyEncodeVector(const float* value, const Math::vec4& offset, const Math::vec4& scale, ushort* key)
+{
+    IndexT i;
+    for (i = 0; i < 3; i++)
+    {
+        const float quantized = scale[i] > 0.0f ? (value[i] - offset[i]) / scale[i] + 0.5f : 0.0f;
+        key[i] = (ushort)Math::clamp(quantized, 0.0f, 65535.0f);
+    }
+}
+
+//------------------------------------------------------------------------------
+/**
+    The three stored components are decoded together, then the largest is
+    computed in the last lane and moved into place with a byte shuffle
+*/
+inline Math::quat
+AnimKeyDecodeRotation(const ushort* key)
+{
+    const __m128i words = _mm_cvtepu16_epi32(_mm_loadl_epi64((const __m128i*)key));
+    const __m128 values = _mm_sub_ps(
+        _mm_mul_ps(_mm_cvtepi32_ps(_mm_and_si128(words, _mm_set1_epi32(0x7FFF))), _mm_set1_ps(2.0f * AnimKeyRotationRange / 32767.0f)),
+        _mm_set1_ps(AnimKeyRotationRange));
+    const __m128 dot = _mm_dp_ps(values, values, 0x78);
+    const __m128 largest = _mm_sqrt_ps(_mm_max_ps(_mm_sub_ps(_mm_set1_ps(1.0f), dot), _mm_setzero_ps()));
+    const __m128 q = _mm_blend_ps(values, largest, 0x8);
+
+    // Byte shuffles which move the largest component from the last lane to its index
+    alignas(16) static const uchar shuffles[4][16] =
+    {
+        { 12, 13, 14, 15, 0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11 },
+        { 0, 1, 2, 3, 12, 13, 14, 15, 4, 5, 6, 7, 8, 9, 10, 11 },
+        { 0, 1, 2, 3, 4, 5, 6, 7, 12, 13, 14, 15, 8, 9, 10, 11 },
+        { 0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15 },
+    };
+    const uint largestIndex = (key[0] >> 15) | ((key[1] >> 15) << 1);
+    const __m128i shuffle = _mm_load_si128((const __m128i*)shuffles[largestIndex]);
+    return Math::quat(_mm_castsi128_ps(_mm_shuffle_epi8(_mm_castps_si128(q), shuffle)));
+}
+
+//------------------------------------------------------------------------------
+/**
+    The w component of offset and scale is expected to be 0
+*/
+inline Math::vec4
+AnimKeyDecodeVector(const ushort* key, const Math::vec4& offset, const Math::vec4& scale)
+{
+    const __m128i words = _mm_cvtepu16_epi32(_mm_loadl_epi64((const __m128i*)key));
+    return Math::vec4(_mm_add_ps(_mm_mul_ps(_mm_cvtepi32_ps(words), scale.vec), offset.vec));
+}
+
+} // namespace CoreAnimation
@@ -7,6 +7,8 @@
 #include "animkeybuffer.h"
 #include "animcurve.h"
 #include "animclip.h"
+#include "animkeycompression.h"
+#include "sampletype.h"
 
 using namespace Math;
 namespace CoreAnimation
@@ -64,15 +66,57 @@ FindNextInterval(
 
 //------------------------------------------------------------------------------
 /**
+    Uncompressed keys are read as they are
 */
+inline Math::quat
+DecodeRotationKey(const float* keys, uint key, const AnimCurve& curve)
+{
+    Math::quat q;
+    q.loadu(&keys[key]);
+    return q;
+}
+
+//------------------------------------------------------------------------------
+/**
+*/
+inline Math::vec3
+DecodeVectorKey(const float* keys, uint key, const AnimCurve& curve)
+{
+    Math::vec3 v;
+    v.loadu(&keys[key]);
+    return v;
+}
+
+//------------------------------------------------------------------------------
+/**
+*/
+inline Math::quat
+DecodeRotationKey(const ushort* keys, uint key, const AnimCurve& curve)
+{
+    return AnimKeyDecodeRotation(&keys[key]);
+}
+
+//------------------------------------------------------------------------------
+/**
+*/
+inline Math::vec3
+DecodeVectorKey(const ushort* keys, uint key, const AnimCurve& curve)
+{
+    return xyz(AnimKeyDecodeVector(&keys[key], curve.keyOffset, curve.keyScale));
+}
+
+//------------------------------------------------------------------------------
+/**
+*/
+template <typename KEY>
 void
-AnimSampleStep(
+AnimSampleStepKeys(
     const AnimClip& clip,
     const Util::FixedArray<AnimCurve>& curves,
     const Timing::Tick time,
     const vec4& velocityScale,
     const Util::FixedArray<Math::vec4>& idleSamples,
-    const float* srcSamplePtr,
+    const KEY* srcSamplePtr,
     const AnimKeyBuffer::Interval* intervalPtr,
     uint* lastUsedIntervalPtr,
     float* outSamplePtr,
@@ -99,7 +143,7 @@ AnimSampleStep(
             case CurveType::Rotation:
             {
                 if (activeCurve)
-                    memcpy(outSamplePtr, &srcSamplePtr[currentTime.key0], 4 * sizeof(float));
+                    DecodeRotationKey(srcSamplePtr, currentTime.key0, curve).storeu(outSamplePtr);
                 else
                     idleSamples[i].store(outSamplePtr);
                 stride = 4;
@@ -110,7 +154,7 @@ AnimSampleStep(
             case CurveType::Translation:
             {
                 if (activeCurve)
-                    memcpy(outSamplePtr, &srcSamplePtr[currentTime.key0], 3 * sizeof(float));
+                    DecodeVectorKey(srcSamplePtr, currentTime.key0, curve).store(outSamplePtr);
                 else
                     idleSamples[i].store(outSamplePtr);
                 stride = 3;
@@ -139,14 +183,15 @@ AnimSampleStep(
 //------------------------------------------------------------------------------
 /**
 */
+template <typename KEY>
 void 
-AnimSampleLinear(
+AnimSampleLinearKeys(
     const AnimClip& clip,
     const Util::FixedArray<AnimCurve>& curves,
     const Timing::Tick time,
     const vec4& velocityScale,
     const Util::FixedArray<Math::vec4>& idleSamples,
-    const float* srcSamplePtr,
+    const KEY* srcSamplePtr,
     const AnimKeyBuffer::Interval* intervalPtr,
     uint* lastUsedIntervalPtr,
     float* outSamplePtr,
@@ -182,15 +227,14 @@ AnimSampleLinear(
                 Math::quat q0;
                 if (activeCurve)
                 {
-                    Math::quat q1;
-                    q0.load(&srcSamplePtr[currentTime.key0]);
-                    q1.load(&srcSamplePtr[currentTime.key1]);
+                    q0 = DecodeRotationKey(srcSamplePtr, currentTime.key0, curve);
+                    Math::quat q1 = DecodeRotationKey(srcSamplePtr, currentTime.key1, curve);
                     q0 = Math::slerp(q0, q1, sampleWeight);
                 }
                 else
                     q0 = idleSamples[i].vec;
 
-                q0.store(outSamplePtr);
+                q0.storeu(outSamplePtr);
                 stride = 4;
                 break;
             }
@@ -201,9 +245,8 @@ AnimSampleLinear(
                 Math::vec3 v0;
                 if (activeCurve)
                 {
-                    Math::vec3 v1;
-                    v0.load(&srcSamplePtr[currentTime.key0]);
-                    v1.load(&srcSamplePtr[currentTime.key1]);
+                    v0 = DecodeVectorKey(srcSamplePtr, currentTime.key0, curve);
+                    Math::vec3 v1 = DecodeVectorKey(srcSamplePtr, currentTime.key1, curve);
                     v0 = Math::lerp(v0, v1, sampleWeight);
                 }
                 else
@@ -233,6 +276,117 @@ AnimSampleLinear(
     }
 }
 
+//------------------------------------------------------------------------------
+/**
+*/
+void
+AnimSampleStep(
+    const AnimClip& clip,
+    const Util::FixedArray<AnimCurve>& curves,
+    const Timing::Tick time,
+    const vec4& velocityScale,
+    const Util::FixedArray<Math::vec4>& idleSamples,
+    const float* srcSamplePtr,
+    const AnimKeyBuffer::Interval* intervalPtr,
+    uint* lastUsedIntervalPtr,
+    float* outSamplePtr,
+    uchar* outSampleCounts)
+{
+    AnimSampleStepKeys(clip, curves, time, velocityScale, idleSamples, srcSamplePtr, intervalPtr, lastUsedIntervalPtr, outSamplePtr, outSampleCounts);
+}
+
+//------------------------------------------------------------------------------
+/**
+*/
+void
+AnimSampleStep(
+    const AnimClip& clip,
+    const Util::FixedArray<AnimCurve>& curves,
+    const Timing::Tick time,
+    const vec4& velocityScale,
+    const Util::FixedArray<Math::vec4>& idleSamples,
+    const ushort* srcSamplePtr,
+    const AnimKeyBuffer::Interval* intervalPtr,
+    uint* lastUsedIntervalPtr,
+    float* outSamplePtr,
+    uchar* outSampleCounts)
+{
+    AnimSampleStepKeys(clip, curves, time, velocityScale, idleSamples, srcSamplePtr, intervalPtr, lastUsedIntervalPtr, outSamplePtr, outSampleCounts);
+}
+
+//------------------------------------------------------------------------------
+/**
+*/
+void 
+AnimSampleLinear(
+    const AnimClip& clip,
+    const Util::FixedArray<AnimCurve>& curves,
+    const Timing::Tick time,
+    const vec4& velocityScale,
+    const Util::FixedArray<Math::vec4>& idleSamples,
+    const float* srcSamplePtr,
+    const AnimKeyBuffer::Interval* intervalPtr,
+    uint* lastUsedIntervalPtr,
+    float* outSamplePtr,
+    uchar* outSampleCounts)
+{
+    AnimSampleLinearKeys(clip, curves, time, velocityScale, idleSamples, srcSamplePtr, intervalPtr, lastUsedIntervalPtr, outSamplePtr, outSampleCounts);
+}
+
+//------------------------------------------------------------------------------
+/**
+*/
+void 
+AnimSampleLinear(
+    const AnimClip& clip,
+    const Util::FixedArray<AnimCurve>& curves,
+    const Timing::Tick time,
+    const vec4& velocityScale,
+    const Util::FixedArray<Math::vec4>& idleSamples,
+    const ushort* srcSamplePtr,
+    const AnimKeyBuffer::Interval* intervalPtr,
+    uint* lastUsedIntervalPtr,
+    float* outSamplePtr,
+    uchar* outSampleCounts)
+{
+    AnimSampleLinearKeys(clip, curves, time, velocityScale, idleSamples, srcSamplePtr, intervalPtr, lastUsedIntervalPtr, outSamplePtr, outSampleCounts);
+}
+
+//------------------------------------------------------------------------------
+/**
+*/
+void
+AnimSample(
+    const SampleType::Code sampleType,
+    const AnimClip& clip,
+    const Util::FixedArray<AnimCurve>& curves,
+    const Timing::Tick time,
+    const vec4& velocityScale,
+    const Util::FixedArray<Math::vec4>& idleSamples,
+    const Ptr<AnimKeyBuffer>& keyBuffer,
+    uint* lastUsedIntervalPtr,
+    float* outSamplePtr,
+    uchar* outSampleCounts)
+{
+    const AnimKeyBuffer::Interval* intervalPtr = keyBuffer->GetIntervalBufferPointer();
+    if (keyBuffer->IsCompressed())
+    {
+        const ushort* srcSamplePtr = keyBuffer->GetCompressedKeyBufferPointer();
+        if (sampleType == SampleType::Step)
+            AnimSampleStepKeys(clip, curves, time, velocityScale, idleSamples, srcSamplePtr, intervalPtr, lastUsedIntervalPtr, outSamplePtr, outSampleCounts);
+        else
+            AnimSampleLinearKeys(clip, curves, time, velocityScale, idleSamples, srcSamplePtr, intervalPtr, lastUsedIntervalPtr, outSamplePtr, outSampleCounts);
+    }
+    else
+    {
+        const float* srcSamplePtr = keyBuffer->GetKeyBufferPointer();
+        if (sampleType == SampleType::Step)
+            AnimSampleStepKeys(clip, curves, time, velocityScale, idleSamples, srcSamplePtr, intervalPtr, lastUsedIntervalPtr, outSamplePtr, outSampleCounts);
+        else
+            AnimSampleLinearKeys(clip, curves, time, velocityScale, idleSamples, srcSamplePtr, intervalPtr, lastUsedIntervalPtr, outSamplePtr, outSampleCounts);
+    }
+}
+
 //------------------------------------------------------------------------------
 /**
 */
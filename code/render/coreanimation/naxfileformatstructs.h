@@ -16,12 +16,23 @@ namespace CoreAnimation
 #pragma pack(push, 1)
 
 #define NEBULA_NAX3_MAGICNUMBER 'NA01'
+#define NEBULA_NAX3_COMPRESSED_MAGICNUMBER 'NA02'
 
 //------------------------------------------------------------------------------
 /** 
     NAX3 file format structs.
 
     NOTE: keep all header-structs 4-byte aligned!
+
+    Files with the compressed magic number have a Nax3CompressedCurve after
+    every Nax3Curve, and their keys are ushorts encoded as described in
+    animkeycompression.h, with numKeys counting ushorts. Instead of a
+    Nax3Interval, every interval is stored as its duration in a ushort.
+    The start of an interval is the end of the one before, beginning at
+    the startTime of its curve, and its keys follow each other from the
+    firstKey of the curve. The loader expands them to full intervals.
+    The durations and the keys are each padded with a zero ushort if
+    their count is odd, so they take a multiple of 4 bytes.
 */
 struct Nax3Header
 {
@@ -75,6 +86,17 @@ struct Nax3Curve
     uchar curveType;                // CoreAnimation::CurveType::Code
 };
 
+struct Nax3CompressedCurve
+{
+    float offset[3];
+    float scale[3];
+    uint firstKey;                  // index of the first ushort of the curve's keys
+    uint startTime;                 // start of the curve's first interval
+};
+
+/// longest interval between two keys in a compressed file
+static const uint Nax3MaxCompressedIntervalDuration = 0xFFFF;
+
 //------------------------------------------------------------------------------
 /** 
     legacy NAX2 file format structs
@@ -80,7 +80,6 @@ ShaderServerBase::Open()
 
     RecursiveLoadShaders(this, "shd:");
 
-#ifndef __linux__
     auto reloadFileFunc = [this](IO::WatchEvent const& event)
     {
         if (event.type == WatchEventType::Modified || event.type == WatchEventType::NameChange &&
@@ -162,7 +161,6 @@ ShaderServerBase::Open()
             FileWatcher::Instance()->Watch(shaderPath.AsString(), true, IO::WatchFlags(NameChanged | SizeChanged | Write), reloadFileFunc);
         }
     }
-#endif
 #endif
 
     this->isOpen = true;
@@ -176,13 +174,11 @@ void
 ShaderServerBase::Close()
 {
     n_assert(this->isOpen);
-    #ifndef __linux__
     // unwatch 
     //if (IO::IoServer::Instance()->DirectoryExists("home:work/shaders/vk"))
     //{
     //    IO::FileWatcher::Instance()->Unwatch("home:work/shaders/vk");
     //}
-    #endif
 
     // unload all currently loaded shaders
     IndexT i;
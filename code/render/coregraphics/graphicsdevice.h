@@ -242,6 +242,8 @@ void LockConstantUpdates();
 void SetConstantsInternal(ConstantBufferOffset offset, const void* data, SizeT size);
 /// Reserve range of constant buffer memory and return offset
 ConstantBufferOffset AllocateConstantBufferMemory(uint size);
+/// Get pointer to pre-allocated constant memory, to write constants in place (thread safe)
+void* GetConstantBufferMemory(ConstantBufferOffset offset);
 
 /// return id to global graphics constant buffer
 CoreGraphics::BufferId GetConstantBuffer(IndexT i);
@@ -26,7 +26,8 @@ MeshLoader::MeshLoader()
     this->failResourceName = "sysmsh:error.nvx";
     this->async = true;
 
-    this->streamerThreadName = "Mesh Streamer Thread";
+    // Copying to upload memory runs in parallel, allocation and recording are serialized by allocatorLock and cmdPoolLock
+    this->maxConcurrentJobs = 4;
 
     // Setup vertex layouts
     CoreGraphics::VertexLayoutCreateInfo vlCreateInfo;
@@ -108,7 +109,10 @@ MeshLoader::InitializeResource(const ResourceLoadJob& job, const Ptr<IO::Stream>
 
     if (resIdExt == "nvx")
     {
+        // The mesh resource allocator isn't thread safe
+        this->allocatorLock.Enter();
         MeshResourceId id = meshResourceAllocator.Alloc();
+        this->allocatorLock.Leave();
         ResourceLoader::ResourceInitOutput ret;
 
         ret.loaderStreamData = this->SetupMeshFromNvx(stream, job, id);
@@ -152,6 +156,29 @@ MeshLoader::StreamResource(const ResourceLoadJob& job)
 
     if (bitsToLoad != 0x0)
     {
+        // Copy to upload memory first, this can run on several loader threads at once
+        CoreGraphics::BufferId vertexUpload = CoreGraphics::InvalidBufferId, indexUpload = CoreGraphics::InvalidBufferId;
+        Memory::RangeAllocation vertexAlloc, indexAlloc;
+        if (bitsToLoad & 0x1)
+        {
+            auto [alloc, buffer] = CoreGraphics::UploadArray(vertexData, header->vertexDataSize);
+            vertexUpload = buffer;
+            vertexAlloc = alloc;
+            if (buffer != CoreGraphics::InvalidBufferId)
+                rangesToFlush.Append(alloc);
+        }
+        if (bitsToLoad & 0x2)
+        {
+            auto [alloc, buffer] = CoreGraphics::UploadArray(indexData, header->indexDataSize);
+            indexUpload = buffer;
+            indexAlloc = alloc;
+            if (buffer != CoreGraphics::InvalidBufferId)
+                rangesToFlush.Append(alloc);
+        }
+
+        // The command buffer pools are shared by all loader threads
+        Threading::CriticalScope scope(&this->cmdPoolLock);
+
         CoreGraphics::CmdBufferCreateInfo cmdCreateInfo;
         cmdCreateInfo.name = name.Value();
         cmdCreateInfo.pool = job.immediate ? this->immediateTransferPool : this->asyncTransferPool;
@@ -169,45 +196,35 @@ MeshLoader::StreamResource(const ResourceLoadJob& job)
 
 
         // Upload vertices
-        if (bitsToLoad & 0x1)
+        if (vertexUpload != CoreGraphics::InvalidBufferId)
         {
-            auto [alloc, buffer] = CoreGraphics::UploadArray(vertexData, header->vertexDataSize);
-            if (buffer != CoreGraphics::InvalidBufferId)
-            {
-                rangesToFlush.Append(alloc);
-                BufferIdAcquire(vbo);
-                SizeT baseVertexOffset = streamData->vertexAllocationOffset.offset;
+            BufferIdAcquire(vbo);
+            SizeT baseVertexOffset = streamData->vertexAllocationOffset.offset;
 
-                // Copy from host mappable buffer to device local buffer
-                CoreGraphics::BufferCopy from, to;
-                from.offset = alloc.offset;
-                to.offset = baseVertexOffset;
-                CoreGraphics::CmdCopy(transferCommands, buffer, { from }, vbo, { to }, header->vertexDataSize);
-                BufferIdRelease(vbo);
+            // Copy from host mappable buffer to device local buffer
+            CoreGraphics::BufferCopy from, to;
+            from.offset = vertexAlloc.offset;
+            to.offset = baseVertexOffset;
+            CoreGraphics::CmdCopy(transferCommands, vertexUpload, { from }, vbo, { to }, header->vertexDataSize);
+            BufferIdRelease(vbo);
 
-                ret.pendingBits |= 1 << 0;
-            }
+            ret.pendingBits |= 1 << 0;
         }
 
         // Upload indices
-        if (bitsToLoad & 0x2)
+        if (indexUpload != CoreGraphics::InvalidBufferId)
         {
-            auto [alloc, buffer] = CoreGraphics::UploadArray(indexData, header->indexDataSize);
-            if (buffer != CoreGraphics::InvalidBufferId)
-            {
-                rangesToFlush.Append(alloc);
-                BufferIdAcquire(ibo);
-                SizeT baseIndexOffset = streamData->indexAllocationOffset.offset;
+            BufferIdAcquire(ibo);
+            SizeT baseIndexOffset = streamData->indexAllocationOffset.offset;
 
-                // Copy from host mappable buffer to device local buffer
-                CoreGraphics::BufferCopy from, to;
-                from.offset = alloc.offset;
-                to.offset = baseIndexOffset;
-                CoreGraphics::CmdCopy(transferCommands, buffer, { from }, ibo, { to }, header->indexDataSize);
-                BufferIdRelease(ibo);
+            // Copy from host mappable buffer to device local buffer
+            CoreGraphics::BufferCopy from, to;
+            from.offset = indexAlloc.offset;
+            to.offset = baseIndexOffset;
+            CoreGraphics::CmdCopy(transferCommands, indexUpload, { from }, ibo, { to }, header->indexDataSize);
+            BufferIdRelease(ibo);
 
-                ret.pendingBits |= 1 << 1;
-            }
+            ret.pendingBits |= 1 << 1;
         }
 
         CoreGraphics::CmdEndMarker(transferCommands);
@@ -221,8 +238,11 @@ MeshLoader::StreamResource(const ResourceLoadJob& job)
         {
             CoreGraphics::FlushUploads(rangesToFlush);
             CoreGraphics::SubmissionWaitEvent waitEvent = CoreGraphics::SubmitCommandBuffers({ transferCommands }, CoreGraphics::GraphicsQueueType, nullptr, "Upload meshes");
+            this->cmdPoolLock.Enter();
             CoreGraphics::DeferredDestroyCmdBuffer(transferCommands);
+            this->cmdPoolLock.Leave();
 
+            Threading::CriticalScope scope(&this->meshLock);
             IndexT index = this->meshesToFinish.FindIndex(job.id);
             if (index == InvalidIndex)
                 this->meshesToFinish.Add(job.id, { FinishedMesh{ .submissionId = waitEvent.timelineIndex, .bits = ret.pendingBits, .rangesToFree = rangesToFlush, .cmdBuf = transferCommands } });
@@ -247,7 +267,9 @@ MeshLoader::StreamResource(const ResourceLoadJob& job)
                 if (CoreGraphics::PollSubmissionIndex(CoreGraphics::GraphicsQueueType, mesh.submissionId))
                 {
                     CoreGraphics::FreeUploads(mesh.rangesToFree);
+                    this->cmdPoolLock.Enter();
                     CoreGraphics::DestroyCmdBuffer(mesh.cmdBuf);
+                    this->cmdPoolLock.Leave();
                     ret.loadedBits |= mesh.bits;
                     ret.pendingBits &= ~mesh.bits;
                     meshes.EraseIndex(i);
@@ -273,6 +295,7 @@ MeshLoader::StreamResource(const ResourceLoadJob& job)
 void
 MeshLoader::Unload(const Resources::ResourceId id)
 {
+    Threading::CriticalScope scope(&this->allocatorLock);
     DestroyMeshResource(id);
 }
 
@@ -378,7 +401,6 @@ MeshLoader::SetupMeshFromNvx(const Ptr<IO::Stream>& stream, const ResourceLoadJo
             // Allocate vertices from global repository
             vertexAllocation = CoreGraphics::AllocateVertices(header->vertexDataSize);
             streamData->vertexAllocationOffset = vertexAllocation;
-            meshResourceAllocator.Set<MeshResource_VertexData>(meshResource.id, vertexAllocation);
             if (job.immediate)
             {
                 BufferCopyWithStaging(CoreGraphics::GetVertexBuffer(), streamData->vertexAllocationOffset.offset, vertexData, header->vertexDataSize);
@@ -390,13 +412,13 @@ MeshLoader::SetupMeshFromNvx(const Ptr<IO::Stream>& stream, const ResourceLoadJo
             // Allocate vertices from global repository
             indexAllocation = CoreGraphics::AllocateIndices(header->indexDataSize);
             streamData->indexAllocationOffset = indexAllocation;
-            meshResourceAllocator.Set<MeshResource_IndexData>(meshResource.id, vertexAllocation);
             if (job.immediate)
             {
                 BufferCopyWithStaging(CoreGraphics::GetIndexBuffer(), streamData->indexAllocationOffset.offset, indexData, header->indexDataSize);
             }
         }
 
+        Util::FixedArray<MeshCreateInfo> meshInfos(header->numMeshes);
         for (uint i = 0; i < header->numMeshes; i++)
         {
             Util::Array<CoreGraphics::PrimitiveGroup> primGroups;
@@ -410,7 +432,7 @@ MeshLoader::SetupMeshFromNvx(const Ptr<IO::Stream>& stream, const ResourceLoadJo
                 group.SetNumIndices(nvxGroup->numIndices);
                 primGroups.Append(group);
             }
-            MeshCreateInfo mshInfo;
+            MeshCreateInfo& mshInfo = meshInfos[i];
             mshInfo.streams.Append({ vbo, (SizeT)(streamData->vertexAllocationOffset.offset + range.baseVertexByteOffset), 0 });
             mshInfo.streams.Append({ vbo, (SizeT)(streamData->vertexAllocationOffset.offset + range.attributesVertexByteOffset), 1 });
             mshInfo.indexBufferOffset = streamData->indexAllocationOffset.offset + (SizeT)range.indexByteOffset;
@@ -420,15 +442,23 @@ MeshLoader::SetupMeshFromNvx(const Ptr<IO::Stream>& stream, const ResourceLoadJo
             mshInfo.primitiveGroups = primGroups;
             mshInfo.vertexLayout = Layouts[(uint)range.layout];
             mshInfo.name = job.name;
-            MeshId mesh = CreateMesh(mshInfo);
-            meshes[i] = mesh;
         }
 
         reader->Close();
-    }
 
-    // Update mesh allocator
-    meshResourceAllocator.Set<MeshResource_Meshes>(meshResource.id, meshes);
+        // Only the allocators need to be serialized, the vertex and index allocations lock themselves
+        Threading::CriticalScope scope(&this->allocatorLock);
+        meshResourceAllocator.Set<MeshResource_VertexData>(meshResource.id, vertexAllocation);
+        meshResourceAllocator.Set<MeshResource_IndexData>(meshResource.id, vertexAllocation);
+        for (uint i = 0; i < header->numMeshes; i++)
+            meshes[i] = CreateMesh(meshInfos[i]);
+        meshResourceAllocator.Set<MeshResource_Meshes>(meshResource.id, meshes);
+    }
+    else
+    {
+        Threading::CriticalScope scope(&this->allocatorLock);
+        meshResourceAllocator.Set<MeshResource_Meshes>(meshResource.id, meshes);
+    }
 
     return ret;
 }
@@ -75,6 +75,10 @@ private:
 
 
     CoreGraphics::CmdBufferPoolId asyncTransferPool, immediateTransferPool;
+    /// the pools are used by several loader threads at once
+    Threading::CriticalSection cmdPoolLock;
+    /// guards the mesh resource allocator, which several loader threads allocate from
+    Threading::CriticalSection allocatorLock;
 
 };
 
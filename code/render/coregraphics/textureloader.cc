@@ -28,58 +28,40 @@ using namespace Resources;
 using namespace IO;
 
 
+/// a mip layer copied to upload memory, waiting to be copied to the texture
+struct MipUpload
+{
+    CoreGraphics::BufferId buffer;
+    Memory::RangeAllocation alloc;
+    uint layer, mip;
+};
+
 //------------------------------------------------------------------------------
 /**
-    Attempt to upload texture data to GPU memory
+    Attempt to copy texture data to upload memory
     May fail if the upload buffer is full, in which case the function returns false
 */
 bool
-UploadToTexture(const CoreGraphics::TextureId texture, const CoreGraphics::CmdBufferId cmdBuf, gliml::context& ctx, uchar layer, uint mip, Memory::RangeAllocation& outAlloc)
+UploadToTexture(const CoreGraphics::TextureId texture, gliml::context& ctx, uchar layer, uint mip, MipUpload& outUpload)
 {
-    // Attempt to upload
-    CoreGraphics::TextureSubresourceInfo subres(CoreGraphics::ImageBits::ColorBits, mip, 1, layer, 1);
-
     CoreGraphics::PixelFormat::Code fmt = TextureGetPixelFormat(texture);
     uint blockSize = CoreGraphics::PixelFormat::ToBlockSize(fmt);
     SizeT alignment = CoreGraphics::PixelFormat::ToTexelSize(fmt) / blockSize;
     auto [alloc, buffer] = CoreGraphics::UploadArray((byte*)ctx.image_data(layer, mip), ctx.image_size(layer, mip), alignment);
     if (buffer == CoreGraphics::InvalidBufferId)
-    {
         return false;
-    }
-    else
-    {
-        // If upload is successful, put a barrier on the buffer
-        CoreGraphics::CmdBarrier(
-            cmdBuf
-            , CoreGraphics::PipelineStage::ImageInitial
-            , CoreGraphics::PipelineStage::TransferWrite
-            , CoreGraphics::BarrierDomain::Global
-            , { TextureBarrierInfo{ .tex = texture, .subres = subres } }
-        );
 
-        // Then run a copy on the command buffer
-        uint width = ctx.image_width(layer, mip);
-        uint height = ctx.image_height(layer, mip);
-        CoreGraphics::BufferCopy bufCopy;
-        bufCopy.offset = alloc.offset;
-        bufCopy.imageHeight = 0;
-        bufCopy.rowLength = 0;
-        CoreGraphics::TextureCopy texCopy;
-        texCopy.layer = layer;
-        texCopy.mip = mip;
-        texCopy.region.set(0, 0, width, height);
-        CoreGraphics::CmdCopy(cmdBuf, buffer, { bufCopy }, texture, { texCopy });
-        outAlloc = alloc;
-    }
+    outUpload = MipUpload{ .buffer = buffer, .alloc = alloc, .layer = layer, .mip = mip };
     return true;
 }
 
 //------------------------------------------------------------------------------
 /**
+    Copies the mips to upload memory, returns the bits of the mips which were
+    uploaded completely. Layers of a mip which didn't fit are loaded next time.
 */
 uint
-LoadMips(CoreGraphics::CmdBufferId cmdBuf, TextureStreamData* streamData, uint bitsToLoad, const CoreGraphics::TextureId texture, Util::Array<Memory::RangeAllocation>& rangesToFlush)
+LoadMips(TextureStreamData* streamData, uint bitsToLoad, const CoreGraphics::TextureId texture, Util::Array<MipUpload>& uploads)
 {
     // use resource submission
     uint loadedBits = 0x0;
@@ -89,19 +71,18 @@ LoadMips(CoreGraphics::CmdBufferId cmdBuf, TextureStreamData* streamData, uint b
         uint mipToLoad = streamData->numMips - 1 - mipIndexToLoad;
 
         uint layerMask = streamData->layers[mipToLoad];
-        uint numLayers = Util::PopCnt(layerMask);
         while (layerMask != 0x0)
         {
             uint layer = Util::FirstOne(layerMask);
-            Memory::RangeAllocation alloc;
+            MipUpload upload;
 
             // Attempt to upload, if it fails we continue from here next time
-            if (!UploadToTexture(texture, cmdBuf, streamData->ctx, layer, mipToLoad, alloc))
+            if (!UploadToTexture(texture, streamData->ctx, layer, mipToLoad, upload))
             {
                 // If upload fails, escape the loop
                 goto quit_loop;
             }
-            rangesToFlush.Append(alloc);
+            uploads.Append(upload);
 
             layerMask &= ~(1 << layer);
         }
@@ -114,6 +95,40 @@ quit_loop:
     return loadedBits;
 }
 
+//------------------------------------------------------------------------------
+/**
+    Record the copies from upload memory to the texture
+*/
+void
+RecordMips(CoreGraphics::CmdBufferId cmdBuf, const Util::Array<MipUpload>& uploads, const CoreGraphics::TextureId texture, gliml::context& ctx)
+{
+    for (const MipUpload& upload : uploads)
+    {
+        // Put a barrier on the texture
+        CoreGraphics::TextureSubresourceInfo subres(CoreGraphics::ImageBits::ColorBits, upload.mip, 1, upload.layer, 1);
+        CoreGraphics::CmdBarrier(
+            cmdBuf
+            , CoreGraphics::PipelineStage::ImageInitial
+            , CoreGraphics::PipelineStage::TransferWrite
+            , CoreGraphics::BarrierDomain::Global
+            , { TextureBarrierInfo{ .tex = texture, .subres = subres } }
+        );
+
+        // Then run a copy on the command buffer
+        uint width = ctx.image_width(upload.layer, upload.mip);
+        uint height = ctx.image_height(upload.layer, upload.mip);
+        CoreGraphics::BufferCopy bufCopy;
+        bufCopy.offset = upload.alloc.offset;
+        bufCopy.imageHeight = 0;
+        bufCopy.rowLength = 0;
+        CoreGraphics::TextureCopy texCopy;
+        texCopy.layer = upload.layer;
+        texCopy.mip = upload.mip;
+        texCopy.region.set(0, 0, width, height);
+        CoreGraphics::CmdCopy(cmdBuf, upload.buffer, { bufCopy }, texture, { texCopy });
+    }
+}
+
 //------------------------------------------------------------------------------
 /**
 */
@@ -160,11 +175,12 @@ FinishMips(CoreGraphics::CmdBufferId transferCommands, CoreGraphics::CmdBufferId
 TextureLoader::TextureLoader()
 {
     this->async = true;
+
+    // Mapping, parsing and copying to upload memory run in parallel, only recording is serialized by cmdPoolLock
+    this->maxConcurrentJobs = 4;
     this->placeholderResourceName = "systex:white.dds";
     this->failResourceName = "systex:error.dds";
 
-    this->streamerThreadName = "Texture Streamer Thread";
-
     CoreGraphics::CmdBufferPoolCreateInfo cmdPoolInfo;
     cmdPoolInfo.name = "Async Transfer Commandbuffer Pool";
     cmdPoolInfo.queue = CoreGraphics::QueueType::TransferQueueType;
@@ -298,44 +314,57 @@ TextureLoader::StreamResource(const ResourceLoadJob& job)
     Util::Array<Memory::RangeAllocation> rangesToFlush;
     if (bitsToLoad != 0x0)
     {
-        CoreGraphics::CmdBufferCreateInfo cmdCreateInfo;
-        cmdCreateInfo.name = name.Value();
-        cmdCreateInfo.pool = job.immediate ? this->immediateTransferPool : this->asyncTransferPool;
-        cmdCreateInfo.usage = CoreGraphics::TransferQueueType;
-        cmdCreateInfo.queryTypes = CoreGraphics::CmdBufferQueryBits::NoQueries;
-        CoreGraphics::CmdBufferId uploadCommands = CoreGraphics::CreateCmdBuffer(cmdCreateInfo);
-
-        CoreGraphics::CmdBufferBeginInfo beginInfo;
-        beginInfo.submitOnce = true;
-        beginInfo.submitDuringPass = false;
-        beginInfo.resubmittable = false;
-        CoreGraphics::CmdBeginRecord(uploadCommands, beginInfo);
-        CoreGraphics::CmdBeginMarker(uploadCommands, NEBULA_MARKER_TRANSFER, name.Value());
-
-        // Perform mip loads
-        uint mask = LoadMips(uploadCommands, streamData, bitsToLoad, texture, rangesToFlush);
+        // Copy the mips to upload memory first, this can run on several loader threads at once
+        Util::Array<MipUpload> uploads;
+        uint mask = LoadMips(streamData, bitsToLoad, texture, uploads);
+        for (const MipUpload& upload : uploads)
+            rangesToFlush.Append(upload.alloc);
+
         if (mask != 0x0)
         {
             pendingBits |= mask;
 
-            // Then record mip finishes
-            CoreGraphics::CmdBufferCreateInfo handoverCmdCreateInfo;
-            handoverCmdCreateInfo.name = "Texture Mip Upload";
-            handoverCmdCreateInfo.pool = job.immediate ? this->immediateHandoverPool : this->asyncHandoverPool;
-            handoverCmdCreateInfo.usage = CoreGraphics::GraphicsQueueType;
-            handoverCmdCreateInfo.queryTypes = CoreGraphics::CmdBufferQueryBits::NoQueries;
-
-            CoreGraphics::CmdBufferId handoverCommands = CoreGraphics::CreateCmdBuffer(handoverCmdCreateInfo);
-            CoreGraphics::CmdBeginRecord(handoverCommands, beginInfo);
-            CoreGraphics::CmdBeginMarker(handoverCommands, NEBULA_MARKER_GRAPHICS, job.name.AsCharPtr());
-
-            FinishMips(uploadCommands, handoverCommands, streamData, mask, texture, job.name.AsCharPtr());
-
-            CoreGraphics::CmdEndMarker(handoverCommands);
-            CoreGraphics::CmdEndRecord(handoverCommands);
-
-            CoreGraphics::CmdEndMarker(uploadCommands);
-            CoreGraphics::CmdEndRecord(uploadCommands);
+            CoreGraphics::CmdBufferId uploadCommands, handoverCommands;
+            {
+                // The command buffer pools are shared by all loader threads
+                Threading::CriticalScope scope(&this->cmdPoolLock);
+
+                CoreGraphics::CmdBufferCreateInfo cmdCreateInfo;
+                cmdCreateInfo.name = name.Value();
+                cmdCreateInfo.pool = job.immediate ? this->immediateTransferPool : this->asyncTransferPool;
+                cmdCreateInfo.usage = CoreGraphics::TransferQueueType;
+                cmdCreateInfo.queryTypes = CoreGraphics::CmdBufferQueryBits::NoQueries;
+                uploadCommands = CoreGraphics::CreateCmdBuffer(cmdCreateInfo);
+
+                CoreGraphics::CmdBufferBeginInfo beginInfo;
+                beginInfo.submitOnce = true;
+                beginInfo.submitDuringPass = false;
+                beginInfo.resubmittable = false;
+                CoreGraphics::CmdBeginRecord(uploadCommands, beginInfo);
+                CoreGraphics::CmdBeginMarker(uploadCommands, NEBULA_MARKER_TRANSFER, name.Value());
+
+                // Perform mip loads
+                RecordMips(uploadCommands, uploads, texture, streamData->ctx);
+
+                // Then record mip finishes
+                CoreGraphics::CmdBufferCreateInfo handoverCmdCreateInfo;
+                handoverCmdCreateInfo.name = "Texture Mip Upload";
+                handoverCmdCreateInfo.pool = job.immediate ? this->immediateHandoverPool : this->asyncHandoverPool;
+                handoverCmdCreateInfo.usage = CoreGraphics::GraphicsQueueType;
+                handoverCmdCreateInfo.queryTypes = CoreGraphics::CmdBufferQueryBits::NoQueries;
+
+                handoverCommands = CoreGraphics::CreateCmdBuffer(handoverCmdCreateInfo);
+                CoreGraphics::CmdBeginRecord(handoverCommands, beginInfo);
+                CoreGraphics::CmdBeginMarker(handoverCommands, NEBULA_MARKER_GRAPHICS, job.name.AsCharPtr());
+
+                FinishMips(uploadCommands, handoverCommands, streamData, mask, texture, job.name.AsCharPtr());
+
+                CoreGraphics::CmdEndMarker(handoverCommands);
+                CoreGraphics::CmdEndRecord(handoverCommands);
+
+                CoreGraphics::CmdEndMarker(uploadCommands);
+                CoreGraphics::CmdEndRecord(uploadCommands);
+            }
 
             if (job.immediate)
             {
@@ -343,11 +372,13 @@ TextureLoader::StreamResource(const ResourceLoadJob& job)
                 CoreGraphics::SubmissionWaitEvent transferWait = CoreGraphics::SubmitCommandBuffers({ uploadCommands }, CoreGraphics::TransferQueueType, nullptr, "Texture mip upload");
                 CoreGraphics::SubmissionWaitEvent graphicsWait = CoreGraphics::SubmitCommandBuffers({ handoverCommands }, CoreGraphics::GraphicsQueueType, { transferWait }, "Receive texture");
 
+                this->handoverLock.Enter();
                 IndexT index = this->mipHandovers.FindIndex(job.id);
                 if (index == InvalidIndex)
                     this->mipHandovers.Add(job.id, { MipHandoverLoaderThread{ .handoverSubmissionId = graphicsWait.timelineIndex, .bits = mask, .rangesToFree = rangesToFlush, .uploadBuffer = uploadCommands, .receiveBuffer = handoverCommands } });
                 else
                     this->mipHandovers.ValueAtIndex(job.id, index).Append(MipHandoverLoaderThread{ .handoverSubmissionId = graphicsWait.timelineIndex, .bits = mask, .rangesToFree = rangesToFlush, .uploadBuffer = uploadCommands, .receiveBuffer = handoverCommands });
+                this->handoverLock.Leave();
             }
             else
             {
@@ -359,10 +390,8 @@ TextureLoader::StreamResource(const ResourceLoadJob& job)
         }
         else
         {
-            CoreGraphics::CmdEndMarker(uploadCommands);
-            CoreGraphics::CmdEndRecord(uploadCommands);
-            CoreGraphics::CmdBufferIdRelease(uploadCommands);
-            CoreGraphics::DestroyCmdBuffer(uploadCommands);
+            // Not even one mip fit, give back the layers which did
+            CoreGraphics::FreeUploads(rangesToFlush);
         }
     }
     if (job.loadState.pendingBits != 0x0)
@@ -380,8 +409,10 @@ TextureLoader::StreamResource(const ResourceLoadJob& job)
                 {
                     // First, delete the initial buffer
                     CoreGraphics::FreeUploads(handover.rangesToFree);
+                    this->cmdPoolLock.Enter();
                     CoreGraphics::DestroyCmdBuffer(handover.uploadBuffer);
                     CoreGraphics::DestroyCmdBuffer(handover.receiveBuffer);
+                    this->cmdPoolLock.Leave();
 
                     loadedBits |= handover.bits;
                     pendingBits &= ~handover.bits;
@@ -468,4 +499,27 @@ TextureLoader::LodMask(const _StreamData& stream, float lod, bool async) const
     return (1 << numMipsRequested) - 1;
 }
 
+//------------------------------------------------------------------------------
+/**
+    Textures are created with their whole mip chain, so the memory doesn't
+    depend on how many mips have been streamed in. This counts the size of
+    every mip as stored in the file, which is what the texture allocates
+    apart from alignment.
+*/
+uint64
+TextureLoader::ResidentBytes(const _StreamData& stream, uint loadedBits) const
+{
+    TextureStreamData* texStreamData = static_cast<TextureStreamData*>(stream.data);
+
+    uint64 bytes = 0;
+    for (uint mip = 0; mip < texStreamData->numMips; mip++)
+    {
+        for (uint layer = 0; layer < texStreamData->numLayers; layer++)
+        {
+            bytes += texStreamData->ctx.image_size(layer, mip);
+        }
+    }
+    return bytes;
+}
+
 } // namespace CoreGraphics
@@ -40,6 +40,8 @@ private:
     void Unload(const Resources::ResourceId id) override;
     /// Create load mask based on LOD
     uint LodMask(const _StreamData& stream, float lod, bool async) const override;
+    /// Get the size of all mips, which are allocated whether they are loaded or not
+    uint64 ResidentBytes(const _StreamData& stream, uint loadedBits) const override;
 
     /// Update intermediate loaded state
     void UpdateLoaderSyncState() override;
@@ -67,6 +69,8 @@ private:
     Threading::CriticalSection handoverLock;
 
     CoreGraphics::CmdBufferPoolId asyncTransferPool, immediateTransferPool, asyncHandoverPool, immediateHandoverPool;
+    /// the pools are used by several loader threads at once
+    Threading::CriticalSection cmdPoolLock;
 };
 
 } // namespace CoreGraphics
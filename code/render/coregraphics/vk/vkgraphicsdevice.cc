@@ -1835,6 +1835,16 @@ SetConstantsInternal(ConstantBufferOffset offset, const void* data, SizeT size)
     BufferUpdate(state.globalConstantBuffer[state.currentBufferedFrameIndex], data, size, offset);
 }
 
+//------------------------------------------------------------------------------
+/**
+    Get the mapped memory which SetConstantsInternal copies to
+*/
+void*
+GetConstantBufferMemory(ConstantBufferOffset offset)
+{
+    return (byte*)BufferMap(state.globalConstantBuffer[state.currentBufferedFrameIndex]) + offset;
+}
+
 //------------------------------------------------------------------------------
 /**
 */
@@ -25,6 +25,8 @@ CreateMaterial(const MaterialTemplates::Entry* entry)
 
     //materialAllocator.Set<Material_ShaderConfig>(id, info.config);
     materialAllocator.Set<Material_MinLOD>(id, 1.0f);
+    materialAllocator.Set<Material_UsedFrame>(id, InvalidIndex);
+    materialAllocator.Set<Material_UsedLOD>(id, 1.0f);
 
     auto& tablesPerPass = materialAllocator.Get<Material_Table>(id);
     auto& instanceTablesPerPass = materialAllocator.Get<Material_InstanceTables>(id);
@@ -284,7 +286,8 @@ MaterialAddLODTexture(const MaterialId mat, const Resources::ResourceId tex)
     materialAllocator.Get<Material_LODTextures>(mat.id).Append(tex);
 
     // When a new texture is added, make sure to update it's LOD as well
-    Resources::SetMinLod(tex, materialAllocator.Get<Material_MinLOD>(mat.id), false);
+    const float lod = materialAllocator.Get<Material_MinLOD>(mat.id);
+    Resources::SetMinLod(tex, lod, false, -lod);
 }
 
 //------------------------------------------------------------------------------
@@ -300,9 +303,38 @@ MaterialSetLowestLod(const MaterialId mat, float lod)
         return;
     minLod = lod;
 
+    // The LOD goes down with the view distance, so textures of closer objects are streamed first
     for (IndexT i = 0; i < textures.Size(); i++)
     {
-        Resources::SetMinLod(textures[i], lod, false);
+        Resources::SetMinLod(textures[i], lod, false, -lod);
+    }
+}
+
+//------------------------------------------------------------------------------
+/**
+    Takes the material lock once for the whole batch. Many instances share a
+    material, so usage is only passed on to the textures once per frame, or
+    when an instance needs a finer LOD.
+*/
+void
+MaterialReportUsage(const MaterialUsage* usages, SizeT num, IndexT frameIndex)
+{
+    Threading::CriticalScope scope(&materialTextureLoadSection);
+    for (IndexT i = 0; i < num; i++)
+    {
+        const MaterialUsage& usage = usages[i];
+        IndexT& usedFrame = materialAllocator.Get<Material_UsedFrame>(usage.mat.id);
+        float& usedLod = materialAllocator.Get<Material_UsedLOD>(usage.mat.id);
+        if (usedFrame == frameIndex && usedLod <= usage.lod)
+            continue;
+        usedFrame = frameIndex;
+        usedLod = usage.lod;
+
+        const Util::Array<Resources::ResourceId>& textures = materialAllocator.Get<Material_LODTextures>(usage.mat.id);
+        for (IndexT j = 0; j < textures.Size(); j++)
+        {
+            Resources::ReportUsage(textures[j], usage.lod);
+        }
     }
 }
 
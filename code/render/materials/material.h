@@ -73,6 +73,14 @@ IndexT MaterialGetBufferBinding(const MaterialId id);
 void MaterialAddLODTexture(const MaterialId mat, const Resources::ResourceId tex);
 /// Update LOD for material
 void MaterialSetLowestLod(const MaterialId mat, float lod);
+/// LOD a material is used with in a frame
+struct MaterialUsage
+{
+    MaterialId mat;
+    float lod;
+};
+/// Report the LODs a batch of materials are used with this frame, for texture residency
+void MaterialReportUsage(const MaterialUsage* usages, SizeT num, IndexT frameIndex);
 
 /// Apply material
 void MaterialApply(const MaterialId id, const CoreGraphics::CmdBufferId buf, IndexT index);
@@ -121,6 +129,8 @@ enum
 {
     Material_MinLOD,
     Material_LODTextures,
+    Material_UsedFrame,
+    Material_UsedLOD,
     Material_Table,
     Material_Buffer,
     Material_InstanceTables,
@@ -139,6 +149,8 @@ enum
 typedef Ids::IdAllocator<
     float,
     Util::Array<Resources::ResourceId>,
+    IndexT,                                                                         // last frame usage was reported
+    float,                                                                          // finest LOD reported in that frame
     Util::FixedArray<CoreGraphics::ResourceTableId>,                                // surface level resource table, mapped batch -> table
     CoreGraphics::BufferId,                                                         // Material buffer
     Util::FixedArray<Util::FixedArray<CoreGraphics::ResourceTableId>>,              // instance level resource table, mapped batch -> table
@@ -32,6 +32,7 @@ __ImplementContext(ModelContext, ModelContext::modelContextAllocator);
 
 Threading::AtomicCounter ModelContext::ConstantsUpdateCounter = 0;
 Threading::AtomicCounter ModelContext::TransformsUpdateCounter = 0;
+Threading::AtomicCounter ModelContext::LodUpdateCounter = 0;
 
 Memory::RangeAllocator ModelContext::TransformInstanceAllocator, ModelContext::RenderInstanceAllocator;
 
@@ -663,9 +664,8 @@ ModelContext::UpdateTransforms(const Graphics::FrameContext& ctx)
         }
     }, nodeInstanceTransformRanges.Size(), 256, nullptr, &TransformsUpdateCounter, nullptr);
 
-    static Threading::AtomicCounter lodUpdateCounter = 0;
-    n_assert(lodUpdateCounter == 0);
-    lodUpdateCounter = 1;
+    n_assert(LodUpdateCounter == 0);
+    LodUpdateCounter = 1;
 
     Jobs2::JobDispatch(
         [
@@ -673,15 +673,19 @@ ModelContext::UpdateTransforms(const Graphics::FrameContext& ctx)
             , nodeInstanceStateRanges = nodeInstanceStateRanges.ConstBegin()
             , instanceBoxes = instanceBoxes.Begin()
             , cameraTransform
+            , frameIndex = ctx.frameIndex
         ]
     (SizeT totalJobs, SizeT groupSize, IndexT groupIndex, SizeT invocationOffset)
     {
         N_SCOPE(ModelLodUpdate, Graphics);
+
+        // Usage is reported once for the whole job, since it takes the material lock
+        Util::Array<Materials::MaterialUsage, 256> materialUsage;
         for (IndexT i = 0; i < groupSize; i++)
         {
             IndexT index = i + invocationOffset;
             if (index >= totalJobs)
-                return;
+                break;
 
             const NodeInstanceRange& stateRange = nodeInstanceStateRanges[index];
             const NodeInstanceRange& transformRange = nodeInstanceTransformRanges[index];
@@ -709,6 +713,16 @@ ModelContext::UpdateTransforms(const Graphics::FrameContext& ctx)
                     NodeInstances.renderable.textureLods[j] = textureLod;
                 }
 
+                // Feed back the detail needed this frame so the residency manager knows what to keep, beyond LOD 1 only the base mips are needed
+                if (textureLod < 1.0f)
+                {
+                    const Materials::MaterialId material = NodeInstances.renderable.nodeMaterials[j];
+                    if (!materialUsage.IsEmpty() && materialUsage.Back().mat.id == material.id)
+                        materialUsage.Back().lod = Math::min(materialUsage.Back().lod, textureLod);
+                    else
+                        materialUsage.Append({ material, textureLod });
+                }
+
                 Models::NodeInstanceFlags nodeFlag = NodeInstances.renderable.nodeFlags[j];
 
                 // Calculate if object should be culled due to LOD
@@ -726,6 +740,13 @@ ModelContext::UpdateTransforms(const Graphics::FrameContext& ctx)
                     // If not, make the lod active by default
                     nodeFlag = SetBits(nodeFlag, Models::NodeInstanceFlags::NodeInstance_LodActive);
 
+                // Keep whether the node was seen last frame, the draw lists of this frame set it again
+                if (AllBits(nodeFlag, Models::NodeInstanceFlags::NodeInstance_Visible))
+                    nodeFlag = SetBits(nodeFlag, Models::NodeInstanceFlags::NodeInstance_WasVisible);
+                else
+                    nodeFlag = UnsetBits(nodeFlag, Models::NodeInstanceFlags::NodeInstance_WasVisible);
+                nodeFlag = UnsetBits(nodeFlag, Models::NodeInstanceFlags::NodeInstance_Visible);
+
                 // Set the flags back
                 NodeInstances.renderable.nodeFlags[j] = nodeFlag;
 
@@ -734,7 +755,10 @@ ModelContext::UpdateTransforms(const Graphics::FrameContext& ctx)
 
             }
         }
-    }, nodeInstanceStateRanges.Size(), 256, { &TransformsUpdateCounter }, &lodUpdateCounter, nullptr);
+
+        if (!materialUsage.IsEmpty())
+            Materials::MaterialReportUsage(materialUsage.Begin(), materialUsage.Size(), frameIndex);
+    }, nodeInstanceStateRanges.Size(), 256, { &TransformsUpdateCounter }, &LodUpdateCounter, nullptr);
 
     n_assert(ConstantsUpdateCounter == 0);
     ConstantsUpdateCounter = 1;
@@ -787,7 +811,7 @@ ModelContext::UpdateTransforms(const Graphics::FrameContext& ctx)
                 */
             }
         }
-    }, nodeInstanceStateRanges.Size(), 256, { &lodUpdateCounter }, &ConstantsUpdateCounter, &ModelContext::completionEvent);
+    }, nodeInstanceStateRanges.Size(), 256, { &LodUpdateCounter }, &ConstantsUpdateCounter, &ModelContext::completionEvent);
 }
 
 //------------------------------------------------------------------------------
@@ -51,6 +51,7 @@ enum class NodeInstanceFlags
     , NodeInstance_AlwaysVisible = N_BIT(3)     // Should always resolve to being visible by visibility
     , NodeInstance_Visible = N_BIT(4)           // Set to true if any observer sees it
     , NodeInstance_Moved = N_BIT(5)
+    , NodeInstance_WasVisible = N_BIT(6)        // Set if any observer saw it the previous frame
 };
 __ImplementEnumBitOperators(NodeInstanceFlags);
 
@@ -198,6 +199,7 @@ public:
 
     static Threading::AtomicCounter ConstantsUpdateCounter;
     static Threading::AtomicCounter TransformsUpdateCounter;
+    static Threading::AtomicCounter LodUpdateCounter;
 
 private:
     friend class Visibility::VisibilityContext;
@@ -50,6 +50,9 @@ ModelLoader::Setup()
     IMPLEMENT_NODE_ALLOCATOR('CHRN', CharacterNode);
     IMPLEMENT_NODE_ALLOCATOR('PSND', ParticleSystemNode);
 
+    // models come with a manifest of their meshes, materials and textures
+    this->prefetchDependencies = true;
+
     // never forget to run this
     ResourceLoader::Setup();
 }
@@ -3,8 +3,9 @@
 /**
     @class Particles::Particle
     
-    The particle structure holds the current state of a single particle and
-    common data for particle-job and nebula3 particle system
+    The particle structure describes a single particle when it's emitted.
+    The particles of a system are kept in a ParticleBuffer as structure of
+    arrays, so the simulation kernels can process a batch of them at once.
 
     !! NOTE: this header is also included from job particlejob.cc, so only 
     !! job-compliant headers can be included here
@@ -19,6 +20,7 @@
 #include "particles/emitterattrs.h"
 #include "threading/interlocked.h"
 #include "threading/event.h"
+#include "util/fixedarray.h"
 
 //------------------------------------------------------------------------------
 namespace Particles
@@ -27,6 +29,7 @@ namespace Particles
     static const SizeT ParticleSystemNumEnvelopeSamples = 192;
     static const SizeT MaxNumRenderedParticles = 65535;
 
+    /// a single particle as it's emitted, particles are stored in a ParticleBuffer after that
     struct Particle
     {
         Math::vec4 position;
@@ -45,6 +48,58 @@ namespace Particles
         float particleId;                   // id for differing particles in vertex shader
     };
 
+    /// the streams of a particle buffer, one float per particle each
+    enum ParticleStream
+    {
+        Stream_PositionX, Stream_PositionY, Stream_PositionZ,
+        Stream_StartPositionX, Stream_StartPositionY, Stream_StartPositionZ,
+        Stream_StretchPositionX, Stream_StretchPositionY, Stream_StretchPositionZ,
+        Stream_VelocityX, Stream_VelocityY, Stream_VelocityZ,
+        Stream_UvMinMaxX, Stream_UvMinMaxY, Stream_UvMinMaxZ, Stream_UvMinMaxW,
+        Stream_ColorR, Stream_ColorG, Stream_ColorB, Stream_ColorA,
+        Stream_Rotation,
+        Stream_RotationVariation,
+        Stream_Size,
+        Stream_SizeVariation,
+        Stream_OneDivLifeTime,
+        Stream_RelAge,
+        Stream_Age,
+        Stream_ParticleId,
+
+        NumParticleStreams
+    };
+
+    /// number of particles the simulation kernels process at once, streams are padded to a multiple of it
+    static const SizeT ParticleBatchSize = 8;
+
+    /// particles stored as structure of arrays in a ring, the newest particle replaces the oldest when full
+    struct ParticleBuffer
+    {
+        ParticleBuffer() : capacity(0), stride(0), count(0), head(0) {};
+
+        /// set capacity, kills all particles
+        void SetCapacity(SizeT capacity);
+        /// kill all particles
+        void Reset();
+        /// add a particle
+        void Add(const Particle& particle);
+        /// get the number of slots in use, including dead particles
+        SizeT Size() const;
+        /// get the number of slots the kernels may process, padded with dead particles
+        SizeT PaddedSize() const;
+
+        /// get a stream
+        float* Stream(ParticleStream stream);
+        /// get a stream
+        const float* Stream(ParticleStream stream) const;
+
+        SizeT capacity;
+        SizeT stride;
+        SizeT count;
+        IndexT head;
+        Util::FixedArray<float> data;
+    };
+
     typedef unsigned int JOB_ID;
 
     // uniform data for particle system instances, used for job-uniform data as well,
@@ -72,22 +127,127 @@ namespace Particles
     {
         Math::bbox bbox;
         unsigned int numLivingParticles;
+        unsigned int numVisibleParticles;   // living particles which aren't completely transparent
     };
 
     struct ParticleJobContext
     {
-        const Particle* inputParticles;
-        Particle* outputParticles;
+        ParticleBuffer* particles;
         const ParticleJobUniformData* uniformData;
         float stepTime;
-        uint numParticles;
         ParticleJobSliceOutputData* output;
     };
 
-    static const SizeT ParticleJobInputElementSize = sizeof(Particle);
+    /// a particle is drawn if it's alive and not completely transparent
+    static const float ParticleMinAlpha = 0.001f;
+
+//------------------------------------------------------------------------------
+/**
+*/
+inline void
+ParticleBuffer::SetCapacity(SizeT capacity)
+{
+    this->capacity = capacity;
+    this->stride = (capacity + ParticleBatchSize - 1) & ~(ParticleBatchSize - 1);
+    this->data.Resize(this->stride * NumParticleStreams);
+    this->data.Fill(0.0f);
+    this->Reset();
+}
+
+//------------------------------------------------------------------------------
+/**
+    Every slot is marked dead, since the kernels process whole batches past
+    the slots in use
+*/
+inline void
+ParticleBuffer::Reset()
+{
+    this->count = 0;
+    this->head = 0;
+    float* relAge = this->Stream(Stream_RelAge);
+    IndexT i;
+    for (i = 0; i < this->stride; i++)
+        relAge[i] = 2.0f;
+}
+
+//------------------------------------------------------------------------------
+/**
+*/
+inline void
+ParticleBuffer::Add(const Particle& particle)
+{
+    n_assert(this->capacity > 0);
+    const IndexT i = this->head;
+    float* streams = this->data.Begin();
+    const SizeT stride = this->stride;
+    streams[Stream_PositionX * stride + i] = particle.position.x;
+    streams[Stream_PositionY * stride + i] = particle.position.y;
+    streams[Stream_PositionZ * stride + i] = particle.position.z;
+    streams[Stream_StartPositionX * stride + i] = particle.startPosition.x;
+    streams[Stream_StartPositionY * stride + i] = particle.startPosition.y;
+    streams[Stream_StartPositionZ * stride + i] = particle.startPosition.z;
+    streams[Stream_StretchPositionX * stride + i] = particle.stretchPosition.x;
+    streams[Stream_StretchPositionY * stride + i] = particle.stretchPosition.y;
+    streams[Stream_StretchPositionZ * stride + i] = particle.stretchPosition.z;
+    streams[Stream_VelocityX * stride + i] = particle.velocity.x;
+    streams[Stream_VelocityY * stride + i] = particle.velocity.y;
+    streams[Stream_VelocityZ * stride + i] = particle.velocity.z;
+    streams[Stream_UvMinMaxX * stride + i] = particle.uvMinMax.x;
+    streams[Stream_UvMinMaxY * stride + i] = particle.uvMinMax.y;
+    streams[Stream_UvMinMaxZ * stride + i] = particle.uvMinMax.z;
+    streams[Stream_UvMinMaxW * stride + i] = particle.uvMinMax.w;
+    streams[Stream_ColorR * stride + i] = particle.color.x;
+    streams[Stream_ColorG * stride + i] = particle.color.y;
+    streams[Stream_ColorB * stride + i] = particle.color.z;
+    streams[Stream_ColorA * stride + i] = particle.color.w;
+    streams[Stream_Rotation * stride + i] = particle.rotation;
+    streams[Stream_RotationVariation * stride + i] = particle.rotationVariation;
+    streams[Stream_Size * stride + i] = particle.size;
+    streams[Stream_SizeVariation * stride + i] = particle.sizeVariation;
+    streams[Stream_OneDivLifeTime * stride + i] = particle.oneDivLifeTime;
+    streams[Stream_RelAge * stride + i] = particle.relAge;
+    streams[Stream_Age * stride + i] = particle.age;
+    streams[Stream_ParticleId * stride + i] = particle.particleId;
+
+    this->head = (this->head + 1) % this->capacity;
+    this->count = Math::min(this->count + 1, this->capacity);
+}
+
+//------------------------------------------------------------------------------
+/**
+*/
+inline SizeT
+ParticleBuffer::Size() const
+{
+    return this->count;
+}
 
-    static const SizeT ParticleJobInputMaxElementsPerSlice = JobMaxSliceSize / ParticleJobInputElementSize;
-    static const SizeT ParticleJobInputSliceSize = ParticleJobInputMaxElementsPerSlice * ParticleJobInputElementSize;
+//------------------------------------------------------------------------------
+/**
+*/
+inline SizeT
+ParticleBuffer::PaddedSize() const
+{
+    return (this->count + ParticleBatchSize - 1) & ~(ParticleBatchSize - 1);
+}
+
+//------------------------------------------------------------------------------
+/**
+*/
+inline float*
+ParticleBuffer::Stream(ParticleStream stream)
+{
+    return this->data.Begin() + stream * this->stride;
+}
+
+//------------------------------------------------------------------------------
+/**
+*/
+inline const float*
+ParticleBuffer::Stream(ParticleStream stream) const
+{
+    return this->data.Begin() + stream * this->stride;
+}
 
 } // namespace Particles
 //------------------------------------------------------------------------------
@@ -10,6 +10,7 @@
 #include "particles/emitterattrs.h"
 #include "particles/emittermesh.h"
 #include "particles/envelopesamplebuffer.h"
+#include "particles/particlejob.h"
 #include "graphics/cameracontext.h"
 #include "graphics/view.h"
 
@@ -23,10 +24,6 @@ namespace Particles
 ParticleContext::ParticleContextAllocator ParticleContext::particleContextAllocator;
 __ImplementContext(ParticleContext, ParticleContext::particleContextAllocator);
 
-extern void JobStep(const ParticleJobUniformData* perSystemUniforms, const float stepTime, unsigned int numParticles,
-             const Particle* particles_input, Particle* particles_output,
-             ParticleJobSliceOutputData* sliceOutput);
-
 CoreGraphics::MeshId ParticleContext::DefaultEmitterMesh;
 const Timing::Time DefaultStepTime = 1.0f / 60.0f;
 Timing::Time StepTime = 1.0f / 60.0f;
@@ -52,6 +49,17 @@ struct
     CoreGraphics::PrimitiveGroup primGroup;
 
     SizeT numParticlesThisFrame;
+
+    // the region of the vertex buffer each system writes its particles to
+    struct VertexRegion
+    {
+        const ParticleBuffer* particles;
+        SizeT numParticles;
+        CoreGraphics::MeshId mesh;
+        IndexT nodeIndex;
+        IndexT baseVertex;
+    };
+    Util::Array<VertexRegion> vertexRegions;
 } state;
 
 //------------------------------------------------------------------------------
@@ -201,7 +209,7 @@ ParticleContext::Create()
     layoutComponents.AppendArray(state.particleComponents);
     CoreGraphics::VertexLayoutCreateInfo vloInfo;
     state.layout = CoreGraphics::CreateVertexLayout({ .name = "Particle"_atm, .comps = layoutComponents });
-    state.vertexSize = sizeof(Math::vec4) * 5; // 5 vertex attibutes using vec4
+    state.vertexSize = sizeof(float) * ParticleVertexWidth; // 5 vertex attibutes using vec4
 
     state.primGroup.SetBaseIndex(0);
     state.primGroup.SetNumIndices(6);
@@ -538,12 +546,41 @@ ParticleContext::WaitForParticleUpdates(const Graphics::FrameContext& ctx)
     // get frame to modify
     IndexT frame = CoreGraphics::GetBufferedFrameIndex();
 
+    // Give every system a region as large as its number of visible particles,
+    // the base vertices are a running offset computed serially over the systems
+    state.vertexRegions.Clear();
+    SizeT numVertices = 0;
+    IndexT i;
+    for (i = 0; i < allSystems.Size(); i++)
+    {
+        Util::Array<ParticleSystemRuntime>& systems = allSystems[i];
+        const NodeInstanceRange& stateRange = Models::ModelContext::GetModelRenderableRange(models[i]);
+
+        IndexT j;
+        for (j = 0; j < systems.Size(); j++)
+        {
+            ParticleSystemRuntime& system = systems[j];
+            const IndexT nodeIndex = stateRange.begin + system.renderableIndex;
+            if (system.outputData.numLivingParticles == 0 || system.outputData.numVisibleParticles == 0)
+            {
+                renderables.nodeDrawModifiers[nodeIndex] = Util::MakeTuple(0, numVertices);
+                continue;
+            }
+            state.vertexRegions.Append({ &system.particles, system.outputData.numVisibleParticles, system.meshPerFrame[frame], nodeIndex, numVertices });
+            system.baseVertex = numVertices;
+            numVertices += system.outputData.numVisibleParticles;
+        }
+    }
+
+    if (numVertices == 0)
+        return;
+
     // Check if we need to realloc buffers
-    if (state.numParticlesThisFrame * state.vertexSize > state.vboSizes[frame])
+    if (numVertices * state.vertexSize > state.vboSizes[frame])
     {
         CoreGraphics::BufferCreateInfo vboInfo;
         vboInfo.name = "Particle Vertex Buffer";
-        vboInfo.size = state.numParticlesThisFrame;
+        vboInfo.size = numVertices;
         vboInfo.elementSize = CoreGraphics::VertexLayoutGetSize(state.layout);
         vboInfo.mode = CoreGraphics::HostCached;
         vboInfo.usageFlags = CoreGraphics::VertexBuffer;
@@ -558,56 +595,41 @@ ParticleContext::WaitForParticleUpdates(const Graphics::FrameContext& ctx)
         }
         state.vbos[frame] = CoreGraphics::CreateBuffer(vboInfo);
         state.mappedVertices[frame] = (byte*)CoreGraphics::BufferMap(state.vbos[frame]);
-        state.vboSizes[frame] = state.numParticlesThisFrame * state.vertexSize;
+        state.vboSizes[frame] = numVertices * state.vertexSize;
     }
 
-    IndexT baseVertex = 0;
-
-    // Walk through systems again and update index and vertex buffers
-    float* buf = (float*)state.mappedVertices[frame];
-    Math::vec4 tmp;
-    IndexT i;
-    for (i = 0; i < allSystems.Size(); i++)
+    // Update meshes to make sure we're using the right VBO
+    for (i = 0; i < state.vertexRegions.Size(); i++)
     {
-        const Util::Array<ParticleSystemRuntime>& systems = allSystems[i];
-        const NodeInstanceRange& stateRange = Models::ModelContext::GetModelRenderableRange(models[i]);
+        const auto& region = state.vertexRegions[i];
+        CoreGraphics::MeshSetVertexBuffer(region.mesh, state.vbos[frame], 1);
+        renderables.nodeMeshes[region.nodeIndex] = region.mesh;
+    }
 
-        IndexT j;
-        for (j = 0; j < systems.Size(); j++)
+    // Stream the vertices of all systems in parallel, each into its own region
+    Threading::Event vertexEvent;
+    Jobs2::JobDispatch(
+        [
+            regions = state.vertexRegions.ConstBegin()
+            , vertices = (float*)state.mappedVertices[frame]
+            , floatsPerVertex = state.vertexSize / sizeof(float)
+            , renderables = &renderables
+        ]
+    (SizeT totalJobs, SizeT groupSize, IndexT groupIndex, SizeT invocationOffset)
+    {
+        N_SCOPE(ParticleVertexUpdate, Graphics);
+        for (IndexT i = 0; i < groupSize; i++)
         {
-            ParticleSystemRuntime& system = systems[j];
-            SizeT numParticles = 0;
+            IndexT index = i + invocationOffset;
+            if (index >= totalJobs)
+                return;
 
-            // stream update vertex buffer region
-            IndexT k;
-            for (k = 0; k < system.outputData.numLivingParticles; k++)
-            {
-                const Particle& particle = system.particles[k];
-                if (particle.relAge < 1.0f && particle.color.w > 0.001f)
-                {
-                    particle.position.stream(buf); buf += 4;
-                    particle.stretchPosition.stream(buf); buf += 4;
-                    particle.color.stream(buf); buf += 4;
-                    particle.uvMinMax.stream(buf); buf += 4;
-                    float sinRot = Math::sin(particle.rotation);
-                    float cosRot = Math::cos(particle.rotation);
-                    tmp.set(sinRot, cosRot, particle.size, particle.particleId);
-                    tmp.stream(buf); buf += 4;
-                    numParticles++;
-                }
-            }
-
-            // Update mesh to make sure we're using the right VBO
-            const IndexT nodeIndex = stateRange.begin + system.renderableIndex;
-            CoreGraphics::MeshSetVertexBuffer(system.meshPerFrame[frame], state.vbos[frame], 1);
-            renderables.nodeMeshes[nodeIndex] = system.meshPerFrame[frame];
-            renderables.nodeDrawModifiers[nodeIndex] = Util::MakeTuple(numParticles, baseVertex);
-            system.baseVertex = baseVertex;
-
-            // Bump base vertex with number of particles from this system
-            baseVertex += numParticles;
+            const auto& region = regions[index];
+            SizeT numParticles = ParticleWriteVertices(region.particles, region.numParticles, vertices + region.baseVertex * floatsPerVertex);
+            renderables->nodeDrawModifiers[region.nodeIndex] = Util::MakeTuple(numParticles, region.baseVertex);
         }
-    }
+    }, state.vertexRegions.Size(), 8, nullptr, nullptr, &vertexEvent);
+    vertexEvent.Wait();
 
     // flush changes
     CoreGraphics::BufferFlush(state.vbos[frame]);
@@ -897,15 +919,11 @@ ParticleContext::RunParticleStep(ParticleRuntime& rt, ParticleSystemRuntime& srt
     if (srt.particles.Size() == 0)
         return;
 
-    n_assert(srt.particles.GetBuffer());
-
     ParticleJobContext jobContext;
-    jobContext.inputParticles = srt.particles.GetBuffer();
-    jobContext.outputParticles = srt.particles.GetBuffer();
+    jobContext.particles = &srt.particles;
     jobContext.output = &srt.outputData;
     jobContext.uniformData = &srt.uniformData;
     jobContext.stepTime = stepTime;
-    jobContext.numParticles = srt.particles.Size();
 
     // Sequence job
     Jobs2::JobAppendSequence([](SizeT totalJobs, SizeT groupSize, IndexT groupIndex, SizeT invocationOffset, void* ctx)
@@ -914,11 +932,8 @@ ParticleContext::RunParticleStep(ParticleRuntime& rt, ParticleSystemRuntime& srt
         ParticleJobContext* context = static_cast<ParticleJobContext*>(ctx);
         n_assert(totalJobs == 1); // Assert we only have one particle system per job execution
 
-        context->output->numLivingParticles = 0;
-        context->output->bbox = Math::bbox();
-
-        // Take a job step
-        JobStep(context->uniformData, context->stepTime, context->numParticles, context->inputParticles, context->outputParticles, context->output);
+        // Take a job step, this fills in the whole output
+        JobStep(context->uniformData, context->stepTime, context->particles, context->output);
     }, 1, jobContext);
 }
 
@@ -14,7 +14,6 @@
 #include "models/nodes/particlesystemnode.h"
 #include "jobs/jobs.h"
 #include "jobs2/jobs2.h"
-#include "util/ringbuffer.h"
 #include "particle.h"
 namespace Particles
 {
@@ -104,7 +103,7 @@ private:
     struct ParticleSystemRuntime
     {
         uint32 renderableIndex;
-        Util::RingBuffer<Particle> particles;
+        ParticleBuffer particles;
         Math::mat4 transform;
         Math::bbox boundingBox;
         SizeT emissionCounter;
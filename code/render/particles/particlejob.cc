@@ -6,165 +6,488 @@
 
 #include "jobs/jobs.h"
 #include "math/vec4.h"
-#include "particles/particle.h"
-
-#if __NEBULA_NO_ASSERT__
-#define ASSERT_POINT(p)
-#define ASSERT_VECTOR(v)
-#else
-#define ASSERT_POINT(p)     { n_assert(p.w > 0.995f);  n_assert(p.w < 1.005f) }
-#define ASSERT_VECTOR(v)    { n_assert(v.w > -0.005f); n_assert(v.w < 0.005f) }
-#endif
+#include "particles/particlejob.h"
+#include "system/cpu.h"
+#include "util/bit.h"
+#include <immintrin.h>
 
 namespace Particles
 {
 
 using namespace Math;
 
+/// simulates all particles of a buffer and fills in the output
+typedef void (*ParticleStepFunc)(const ParticleJobUniformData* perSystemUniforms, const float stepTime, ParticleBuffer* particles, ParticleJobSliceOutputData* sliceOutput);
+
 //------------------------------------------------------------------------------
 /**
-
-    NOTE: JobStepAndVlist does the same as JobStep, but it also generates the vertex 
-          list. It could be in one function, but then we would always have to check a 
-          boolean value for each particle. Thats bad for the SPU, since it doesnt
-          have any branch prediction, and it would have to throw away commands 
-          and fetch new commands from the program in each iteration
+    Sets the bounding box from the extents of the living particles, or to
+    the null box if there are none
 */
+static void
+ParticleSetBbox(const float* minimum, const float* maximum, SizeT width, ParticleJobSliceOutputData* sliceOutput)
+{
+    if (sliceOutput->numLivingParticles == 0)
+    {
+        sliceOutput->bbox.pmin.set(0.0f, 0.0f, 0.0f);
+        sliceOutput->bbox.pmax.set(0.0f, 0.0f, 0.0f);
+        return;
+    }
 
-
-/// lookup samples at index "sampleIndex" in sample-table
-const float* LookupEnvelopeSamples(const float sampleBuffer[ParticleSystemNumEnvelopeSamples*EmitterAttrs::NumEnvelopeAttrs], IndexT sampleIndex);
-/// update bounding box (min, max) with vector v
-void UpdateBbox(const vec4& v, vec4& min, vec4& max);
-/// update the age of one particle
-void ParticleUpdateAge(const float stepTime, const Particle& in, Particle& out);
-/// integrate the particle state with a given time-step
-void ParticleStep(const ParticleJobUniformData* perSystemUniforms, const float stepTime, const Particle& in, Particle& out, ParticleJobSliceOutputData* sliceOutput);
-/// update particle system step
-void JobStep(const ParticleJobUniformData* perSystemUniforms, const float stepTime, unsigned int numParticles, const Particle* particles_input, Particle* particles_output, ParticleJobSliceOutputData* sliceOutput);
+    float result[6] = { minimum[0], minimum[width], minimum[width * 2], maximum[0], maximum[width], maximum[width * 2] };
+    IndexT i, j;
+    for (i = 0; i < 3; i++)
+    {
+        for (j = 1; j < width; j++)
+        {
+            result[i] = Math::min(result[i], minimum[i * width + j]);
+            result[i + 3] = Math::max(result[i + 3], maximum[i * width + j]);
+        }
+    }
+    sliceOutput->bbox.pmin.set(result[0], result[1], result[2]);
+    sliceOutput->bbox.pmax.set(result[3], result[4], result[5]);
+}
 
 //------------------------------------------------------------------------------
 /**
+    Dead particles only age, every other stream is left as it is. The
+    envelope samples are looked up at the new relative age, which is
+    clamped so dead particles don't read past the sample buffer.
 */
-__forceinline 
-const float*
-LookupEnvelopeSamples(const float sampleBuffer[ParticleSystemNumEnvelopeSamples*EmitterAttrs::NumEnvelopeAttrs], IndexT sampleIndex)
+void
+ParticleStepSSE(const ParticleJobUniformData* perSystemUniforms, const float stepTime, ParticleBuffer* particles, ParticleJobSliceOutputData* sliceOutput)
 {
-    n_assert(sampleIndex >= 0);
-    n_assert(sampleIndex < ParticleSystemNumEnvelopeSamples);
-    return sampleBuffer + (sampleIndex * EmitterAttrs::NumEnvelopeAttrs);
+    const float* sampleBuffer = perSystemUniforms->sampleBuffer;
+    const __m128 dt = _mm_set1_ps(stepTime);
+    const __m128 zero = _mm_setzero_ps();
+    const __m128 one = _mm_set1_ps(1.0f);
+    const __m128 half = _mm_set1_ps(0.5f);
+    const __m128 minAlpha = _mm_set1_ps(ParticleMinAlpha);
+    const __m128 lastSample = _mm_set1_ps((float)(ParticleSystemNumEnvelopeSamples - 1));
+    const __m128i maxSample = _mm_set1_epi32(ParticleSystemNumEnvelopeSamples - 1);
+    const __m128i numAttrs = _mm_set1_epi32(EmitterAttrs::NumEnvelopeAttrs);
+    const __m128 windX = _mm_set1_ps(perSystemUniforms->windVector.x);
+    const __m128 windY = _mm_set1_ps(perSystemUniforms->windVector.y);
+    const __m128 windZ = _mm_set1_ps(perSystemUniforms->windVector.z);
+    const __m128 gravityX = _mm_set1_ps(perSystemUniforms->gravity.x);
+    const __m128 gravityY = _mm_set1_ps(perSystemUniforms->gravity.y);
+    const __m128 gravityZ = _mm_set1_ps(perSystemUniforms->gravity.z);
+    const __m128 stretchTime = _mm_set1_ps(perSystemUniforms->stretchTime);
+    const bool stretchToStart = perSystemUniforms->stretchToStart;
+    const bool stretch = perSystemUniforms->stretchTime > 0.0f;
+
+    float* px = particles->Stream(Stream_PositionX);
+    float* py = particles->Stream(Stream_PositionY);
+    float* pz = particles->Stream(Stream_PositionZ);
+    const float* startX = particles->Stream(Stream_StartPositionX);
+    const float* startY = particles->Stream(Stream_StartPositionY);
+    const float* startZ = particles->Stream(Stream_StartPositionZ);
+    float* sx = particles->Stream(Stream_StretchPositionX);
+    float* sy = particles->Stream(Stream_StretchPositionY);
+    float* sz = particles->Stream(Stream_StretchPositionZ);
+    float* vx = particles->Stream(Stream_VelocityX);
+    float* vy = particles->Stream(Stream_VelocityY);
+    float* vz = particles->Stream(Stream_VelocityZ);
+    float* r = particles->Stream(Stream_ColorR);
+    float* g = particles->Stream(Stream_ColorG);
+    float* b = particles->Stream(Stream_ColorB);
+    float* a = particles->Stream(Stream_ColorA);
+    float* rotation = particles->Stream(Stream_Rotation);
+    const float* rotationVariation = particles->Stream(Stream_RotationVariation);
+    float* size = particles->Stream(Stream_Size);
+    const float* sizeVariation = particles->Stream(Stream_SizeVariation);
+    const float* oneDivLifeTime = particles->Stream(Stream_OneDivLifeTime);
+    float* relAge = particles->Stream(Stream_RelAge);
+    float* age = particles->Stream(Stream_Age);
+
+    __m128 minX = _mm_set1_ps(+1000000.0f), minY = minX, minZ = minX;
+    __m128 maxX = _mm_set1_ps(-1000000.0f), maxY = maxX, maxZ = maxX;
+    uint numLiving = 0, numVisible = 0;
+
+    IndexT i;
+    const SizeT num = particles->PaddedSize();
+    for (i = 0; i < num; i += 4)
+    {
+        // update particle's age
+        const __m128 newAge = _mm_add_ps(_mm_loadu_ps(age + i), dt);
+        const __m128 newRelAge = _mm_add_ps(_mm_loadu_ps(relAge + i), _mm_mul_ps(dt, _mm_loadu_ps(oneDivLifeTime + i)));
+        _mm_storeu_ps(age + i, newAge);
+        _mm_storeu_ps(relAge + i, newRelAge);
+        const __m128 alive = _mm_cmplt_ps(newRelAge, one);
+        const int aliveMask = _mm_movemask_ps(alive);
+        if (aliveMask == 0)
+            continue;
+
+        // look up the envelope samples of each particle
+        __m128i sampleIndex = _mm_cvttps_epi32(_mm_mul_ps(newRelAge, lastSample));
+        sampleIndex = _mm_max_epi32(_mm_min_epi32(sampleIndex, maxSample), _mm_setzero_si128());
+        alignas(16) int32 offsets[4];
+        _mm_store_si128((__m128i*)offsets, _mm_mullo_epi32(sampleIndex, numAttrs));
+        const float* s0 = sampleBuffer + offsets[0];
+        const float* s1 = sampleBuffer + offsets[1];
+        const float* s2 = sampleBuffer + offsets[2];
+        const float* s3 = sampleBuffer + offsets[3];
+#define SAMPLE(attr) _mm_setr_ps(s0[EmitterAttrs::attr], s1[EmitterAttrs::attr], s2[EmitterAttrs::attr], s3[EmitterAttrs::attr])
+        const __m128 airResistance = SAMPLE(AirResistance);
+        const __m128 mass = SAMPLE(Mass);
+        const __m128 velocityFactor = SAMPLE(VelocityFactor);
+        const __m128 sampleSize = SAMPLE(Size);
+        const __m128 rotationVelocity = SAMPLE(RotationVelocity);
+        const __m128 red = SAMPLE(Red);
+        const __m128 green = SAMPLE(Green);
+        const __m128 blue = SAMPLE(Blue);
+        const __m128 alpha = _mm_min_ps(_mm_max_ps(SAMPLE(Alpha), zero), one);
+#undef SAMPLE
+
+        // compute current particle acceleration
+        const __m128 accX = _mm_mul_ps(_mm_add_ps(_mm_mul_ps(windX, airResistance), gravityX), mass);
+        const __m128 accY = _mm_mul_ps(_mm_add_ps(_mm_mul_ps(windY, airResistance), gravityY), mass);
+        const __m128 accZ = _mm_mul_ps(_mm_add_ps(_mm_mul_ps(windZ, airResistance), gravityZ), mass);
+
+        // update position, velocity
+        const __m128 oldVx = _mm_loadu_ps(vx + i), oldVy = _mm_loadu_ps(vy + i), oldVz = _mm_loadu_ps(vz + i);
+        const __m128 newPx = _mm_add_ps(_mm_loadu_ps(px + i), _mm_mul_ps(_mm_mul_ps(oldVx, velocityFactor), dt));
+        const __m128 newPy = _mm_add_ps(_mm_loadu_ps(py + i), _mm_mul_ps(_mm_mul_ps(oldVy, velocityFactor), dt));
+        const __m128 newPz = _mm_add_ps(_mm_loadu_ps(pz + i), _mm_mul_ps(_mm_mul_ps(oldVz, velocityFactor), dt));
+        const __m128 newVx = _mm_add_ps(oldVx, _mm_mul_ps(accX, dt));
+        const __m128 newVy = _mm_add_ps(oldVy, _mm_mul_ps(accY, dt));
+        const __m128 newVz = _mm_add_ps(oldVz, _mm_mul_ps(accZ, dt));
+
+        // stretch, particles don't rotate while stretched
+        const __m128 oldRotation = _mm_loadu_ps(rotation + i);
+        __m128 newSx, newSy, newSz, newRotation;
+        if (stretchToStart)
+        {
+            newSx = _mm_loadu_ps(startX + i);
+            newSy = _mm_loadu_ps(startY + i);
+            newSz = _mm_loadu_ps(startZ + i);
+            newRotation = oldRotation;
+        }
+        else
+        {
+            const __m128 rotated = _mm_add_ps(oldRotation, _mm_mul_ps(_mm_mul_ps(_mm_loadu_ps(rotationVariation + i), rotationVelocity), dt));
+            newSx = newPx;
+            newSy = newPy;
+            newSz = newPz;
+            newRotation = rotated;
+            if (stretch)
+            {
+                const __m128 curStretchTime = _mm_min_ps(stretchTime, newAge);
+                const __m128 stretching = _mm_cmpgt_ps(curStretchTime, zero);
+                const __m128 back = _mm_mul_ps(curStretchTime, half);
+                const __m128 scale = _mm_mul_ps(stretchTime, velocityFactor);
+                newSx = _mm_blendv_ps(newPx, _mm_sub_ps(newPx, _mm_mul_ps(_mm_sub_ps(newVx, _mm_mul_ps(accX, back)), scale)), stretching);
+                newSy = _mm_blendv_ps(newPy, _mm_sub_ps(newPy, _mm_mul_ps(_mm_sub_ps(newVy, _mm_mul_ps(accY, back)), scale)), stretching);
+                newSz = _mm_blendv_ps(newPz, _mm_sub_ps(newPz, _mm_mul_ps(_mm_sub_ps(newVz, _mm_mul_ps(accZ, back)), scale)), stretching);
+                newRotation = _mm_blendv_ps(rotated, oldRotation, stretching);
+            }
+        }
+
+        // only living particles are written
+#define STORE(ptr, value) _mm_storeu_ps(ptr + i, _mm_blendv_ps(_mm_loadu_ps(ptr + i), value, alive))
+        STORE(px, newPx); STORE(py, newPy); STORE(pz, newPz);
+        STORE(vx, newVx); STORE(vy, newVy); STORE(vz, newVz);
+        STORE(sx, newSx); STORE(sy, newSy); STORE(sz, newSz);
+        STORE(rotation, newRotation);
+        STORE(r, red); STORE(g, green); STORE(b, blue); STORE(a, alpha);
+        STORE(size, _mm_mul_ps(sampleSize, _mm_loadu_ps(sizeVariation + i)));
+#undef STORE
+
+        // extend the bounding box with the living particles
+        minX = _mm_blendv_ps(minX, _mm_min_ps(minX, _mm_sub_ps(newPx, sampleSize)), alive);
+        minY = _mm_blendv_ps(minY, _mm_min_ps(minY, _mm_sub_ps(newPy, sampleSize)), alive);
+        minZ = _mm_blendv_ps(minZ, _mm_min_ps(minZ, _mm_sub_ps(newPz, sampleSize)), alive);
+        maxX = _mm_blendv_ps(maxX, _mm_max_ps(maxX, _mm_add_ps(newPx, sampleSize)), alive);
+        maxY = _mm_blendv_ps(maxY, _mm_max_ps(maxY, _mm_add_ps(newPy, sampleSize)), alive);
+        maxZ = _mm_blendv_ps(maxZ, _mm_max_ps(maxZ, _mm_add_ps(newPz, sampleSize)), alive);
+
+        numLiving += Util::PopCnt((uint)aliveMask);
+        numVisible += Util::PopCnt((uint)(aliveMask & _mm_movemask_ps(_mm_cmpgt_ps(alpha, minAlpha))));
+    }
+
+    sliceOutput->numLivingParticles = numLiving;
+    sliceOutput->numVisibleParticles = numVisible;
+    alignas(16) float minimum[12], maximum[12];
+    _mm_store_ps(minimum, minX); _mm_store_ps(minimum + 4, minY); _mm_store_ps(minimum + 8, minZ);
+    _mm_store_ps(maximum, maxX); _mm_store_ps(maximum + 4, maxY); _mm_store_ps(maximum + 8, maxZ);
+    ParticleSetBbox(minimum, maximum, 4, sliceOutput);
 }
 
 //------------------------------------------------------------------------------
 /**
+    Same as ParticleStepSSE, 8 particles at a time with the envelope
+    samples gathered in one instruction each
 */
-__forceinline 
-void
-UpdateBbox(const vec4& v, vec4& min, vec4& max)
+N_TARGET_AVX2 void
+ParticleStepAVX2(const ParticleJobUniformData* perSystemUniforms, const float stepTime, ParticleBuffer* particles, ParticleJobSliceOutputData* sliceOutput)
 {
-    min = minimize(min, v);
-    max = maximize(max, v);
+    const float* sampleBuffer = perSystemUniforms->sampleBuffer;
+    const __m256 dt = _mm256_set1_ps(stepTime);
+    const __m256 zero = _mm256_setzero_ps();
+    const __m256 one = _mm256_set1_ps(1.0f);
+    const __m256 half = _mm256_set1_ps(0.5f);
+    const __m256 minAlpha = _mm256_set1_ps(ParticleMinAlpha);
+    const __m256 lastSample = _mm256_set1_ps((float)(ParticleSystemNumEnvelopeSamples - 1));
+    const __m256i maxSample = _mm256_set1_epi32(ParticleSystemNumEnvelopeSamples - 1);
+    const __m256i numAttrs = _mm256_set1_epi32(EmitterAttrs::NumEnvelopeAttrs);
+    const __m256 windX = _mm256_set1_ps(perSystemUniforms->windVector.x);
+    const __m256 windY = _mm256_set1_ps(perSystemUniforms->windVector.y);
+    const __m256 windZ = _mm256_set1_ps(perSystemUniforms->windVector.z);
+    const __m256 gravityX = _mm256_set1_ps(perSystemUniforms->gravity.x);
+    const __m256 gravityY = _mm256_set1_ps(perSystemUniforms->gravity.y);
+    const __m256 gravityZ = _mm256_set1_ps(perSystemUniforms->gravity.z);
+    const __m256 stretchTime = _mm256_set1_ps(perSystemUniforms->stretchTime);
+    const bool stretchToStart = perSystemUniforms->stretchToStart;
+    const bool stretch = perSystemUniforms->stretchTime > 0.0f;
+
+    float* px = particles->Stream(Stream_PositionX);
+    float* py = particles->Stream(Stream_PositionY);
+    float* pz = particles->Stream(Stream_PositionZ);
+    const float* startX = particles->Stream(Stream_StartPositionX);
+    const float* startY = particles->Stream(Stream_StartPositionY);
+    const float* startZ = particles->Stream(Stream_StartPositionZ);
+    float* sx = particles->Stream(Stream_StretchPositionX);
+    float* sy = particles->Stream(Stream_StretchPositionY);
+    float* sz = particles->Stream(Stream_StretchPositionZ);
+    float* vx = particles->Stream(Stream_VelocityX);
+    float* vy = particles->Stream(Stream_VelocityY);
+    float* vz = particles->Stream(Stream_VelocityZ);
+    float* r = particles->Stream(Stream_ColorR);
+    float* g = particles->Stream(Stream_ColorG);
+    float* b = particles->Stream(Stream_ColorB);
+    float* a = particles->Stream(Stream_ColorA);
+    float* rotation = particles->Stream(Stream_Rotation);
+    const float* rotationVariation = particles->Stream(Stream_RotationVariation);
+    float* size = particles->Stream(Stream_Size);
+    const float* sizeVariation = particles->Stream(Stream_SizeVariation);
+    const float* oneDivLifeTime = particles->Stream(Stream_OneDivLifeTime);
+    float* relAge = particles->Stream(Stream_RelAge);
+    float* age = particles->Stream(Stream_Age);
+
+    __m256 minX = _mm256_set1_ps(+1000000.0f), minY = minX, minZ = minX;
+    __m256 maxX = _mm256_set1_ps(-1000000.0f), maxY = maxX, maxZ = maxX;
+    uint numLiving = 0, numVisible = 0;
+
+    IndexT i;
+    const SizeT num = particles->PaddedSize();
+    for (i = 0; i < num; i += 8)
+    {
+        // update particle's age
+        const __m256 newAge = _mm256_add_ps(_mm256_loadu_ps(age + i), dt);
+        const __m256 newRelAge = _mm256_add_ps(_mm256_loadu_ps(relAge + i), _mm256_mul_ps(dt, _mm256_loadu_ps(oneDivLifeTime + i)));
+        _mm256_storeu_ps(age + i, newAge);
+        _mm256_storeu_ps(relAge + i, newRelAge);
+        const __m256 alive = _mm256_cmp_ps(newRelAge, one, _CMP_LT_OQ);
+        const int aliveMask = _mm256_movemask_ps(alive);
+        if (aliveMask == 0)
+            continue;
+
+        // look up the envelope samples of each particle
+        __m256i sampleIndex = _mm256_cvttps_epi32(_mm256_mul_ps(newRelAge, lastSample));
+        sampleIndex = _mm256_max_epi32(_mm256_min_epi32(sampleIndex, maxSample), _mm256_setzero_si256());
+        const __m256i offsets = _mm256_mullo_epi32(sampleIndex, numAttrs);
+#define SAMPLE(attr) _mm256_i32gather_ps(sampleBuffer + EmitterAttrs::attr, offsets, 4)
+        const __m256 airResistance = SAMPLE(AirResistance);
+        const __m256 mass = SAMPLE(Mass);
+        const __m256 velocityFactor = SAMPLE(VelocityFactor);
+        const __m256 sampleSize = SAMPLE(Size);
+        const __m256 rotationVelocity = SAMPLE(RotationVelocity);
+        const __m256 red = SAMPLE(Red);
+        const __m256 green = SAMPLE(Green);
+        const __m256 blue = SAMPLE(Blue);
+        const __m256 alpha = _mm256_min_ps(_mm256_max_ps(SAMPLE(Alpha), zero), one);
+#undef SAMPLE
+
+        // compute current particle acceleration
+        const __m256 accX = _mm256_mul_ps(_mm256_add_ps(_mm256_mul_ps(windX, airResistance), gravityX), mass);
+        const __m256 accY = _mm256_mul_ps(_mm256_add_ps(_mm256_mul_ps(windY, airResistance), gravityY), mass);
+        const __m256 accZ = _mm256_mul_ps(_mm256_add_ps(_mm256_mul_ps(windZ, airResistance), gravityZ), mass);
+
+        // update position, velocity
+        const __m256 oldVx = _mm256_loadu_ps(vx + i), oldVy = _mm256_loadu_ps(vy + i), oldVz = _mm256_loadu_ps(vz + i);
+        const __m256 newPx = _mm256_add_ps(_mm256_loadu_ps(px + i), _mm256_mul_ps(_mm256_mul_ps(oldVx, velocityFactor), dt));
+        const __m256 newPy = _mm256_add_ps(_mm256_loadu_ps(py + i), _mm256_mul_ps(_mm256_mul_ps(oldVy, velocityFactor), dt));
+        const __m256 newPz = _mm256_add_ps(_mm256_loadu_ps(pz + i), _mm256_mul_ps(_mm256_mul_ps(oldVz, velocityFactor), dt));
+        const __m256 newVx = _mm256_add_ps(oldVx, _mm256_mul_ps(accX, dt));
+        const __m256 newVy = _mm256_add_ps(oldVy, _mm256_mul_ps(accY, dt));
+        const __m256 newVz = _mm256_add_ps(oldVz, _mm256_mul_ps(accZ, dt));
+
+        // stretch, particles don't rotate while stretched
+        const __m256 oldRotation = _mm256_loadu_ps(rotation + i);
+        __m256 newSx, newSy, newSz, newRotation;
+        if (stretchToStart)
+        {
+            newSx = _mm256_loadu_ps(startX + i);
+            newSy = _mm256_loadu_ps(startY + i);
+            newSz = _mm256_loadu_ps(startZ + i);
+            newRotation = oldRotation;
+        }
+        else
+        {
+            const __m256 rotated = _mm256_add_ps(oldRotation, _mm256_mul_ps(_mm256_mul_ps(_mm256_loadu_ps(rotationVariation + i), rotationVelocity), dt));
+            newSx = newPx;
+            newSy = newPy;
+            newSz = newPz;
+            newRotation = rotated;
+            if (stretch)
+            {
+                const __m256 curStretchTime = _mm256_min_ps(stretchTime, newAge);
+                const __m256 stretching = _mm256_cmp_ps(curStretchTime, zero, _CMP_GT_OQ);
+                const __m256 back = _mm256_mul_ps(curStretchTime, half);
+                const __m256 scale = _mm256_mul_ps(stretchTime, velocityFactor);
+                newSx = _mm256_blendv_ps(newPx, _mm256_sub_ps(newPx, _mm256_mul_ps(_mm256_sub_ps(newVx, _mm256_mul_ps(accX, back)), scale)), stretching);
+                newSy = _mm256_blendv_ps(newPy, _mm256_sub_ps(newPy, _mm256_mul_ps(_mm256_sub_ps(newVy, _mm256_mul_ps(accY, back)), scale)), stretching);
+                newSz = _mm256_blendv_ps(newPz, _mm256_sub_ps(newPz, _mm256_mul_ps(_mm256_sub_ps(newVz, _mm256_mul_ps(accZ, back)), scale)), stretching);
+                newRotation = _mm256_blendv_ps(rotated, oldRotation, stretching);
+            }
+        }
+
+        // only living particles are written
+#define STORE(ptr, value) _mm256_storeu_ps(ptr + i, _mm256_blendv_ps(_mm256_loadu_ps(ptr + i), value, alive))
+        STORE(px, newPx); STORE(py, newPy); STORE(pz, newPz);
+        STORE(vx, newVx); STORE(vy, newVy); STORE(vz, newVz);
+        STORE(sx, newSx); STORE(sy, newSy); STORE(sz, newSz);
+        STORE(rotation, newRotation);
+        STORE(r, red); STORE(g, green); STORE(b, blue); STORE(a, alpha);
+        STORE(size, _mm256_mul_ps(sampleSize, _mm256_loadu_ps(sizeVariation + i)));
+#undef STORE
+
+        // extend the bounding box with the living particles
+        minX = _mm256_blendv_ps(minX, _mm256_min_ps(minX, _mm256_sub_ps(newPx, sampleSize)), alive);
+        minY = _mm256_blendv_ps(minY, _mm256_min_ps(minY, _mm256_sub_ps(newPy, sampleSize)), alive);
+        minZ = _mm256_blendv_ps(minZ, _mm256_min_ps(minZ, _mm256_sub_ps(newPz, sampleSize)), alive);
+        maxX = _mm256_blendv_ps(maxX, _mm256_max_ps(maxX, _mm256_add_ps(newPx, sampleSize)), alive);
+        maxY = _mm256_blendv_ps(maxY, _mm256_max_ps(maxY, _mm256_add_ps(newPy, sampleSize)), alive);
+        maxZ = _mm256_blendv_ps(maxZ, _mm256_max_ps(maxZ, _mm256_add_ps(newPz, sampleSize)), alive);
+
+        numLiving += Util::PopCnt((uint)aliveMask);
+        numVisible += Util::PopCnt((uint)(aliveMask & _mm256_movemask_ps(_mm256_cmp_ps(alpha, minAlpha, _CMP_GT_OQ))));
+    }
+
+    sliceOutput->numLivingParticles = numLiving;
+    sliceOutput->numVisibleParticles = numVisible;
+    alignas(32) float minimum[24], maximum[24];
+    _mm256_store_ps(minimum, minX); _mm256_store_ps(minimum + 8, minY); _mm256_store_ps(minimum + 16, minZ);
+    _mm256_store_ps(maximum, maxX); _mm256_store_ps(maximum + 8, maxY); _mm256_store_ps(maximum + 16, maxZ);
+    ParticleSetBbox(minimum, maximum, 8, sliceOutput);
 }
 
 //------------------------------------------------------------------------------
 /**
 */
-__forceinline
-void ParticleUpdateAge(const float stepTime, const Particle& in, Particle& out)
+void
+JobStep(const ParticleJobUniformData* perSystemUniforms, const float stepTime, ParticleBuffer* particles, ParticleJobSliceOutputData* sliceOutput)
 {
-    // update particle's age
-    out.oneDivLifeTime = in.oneDivLifeTime;
-    out.age = in.age + stepTime;
-    out.relAge = in.relAge + stepTime * in.oneDivLifeTime;
+    static const ParticleStepFunc step = System::Cpu::HasFeature(System::Cpu::AVX2) ? ParticleStepAVX2 : ParticleStepSSE;
+    step(perSystemUniforms, stepTime, particles, sliceOutput);
 }
 
 //------------------------------------------------------------------------------
 /**
+    Sine and cosine of 4 angles. The angles are reduced to [-pi/4, pi/4]
+    around the nearest multiple of pi/2 and evaluated with the Cephes
+    polynomials, the octant picks which polynomial and sign each result
+    gets. Accurate to a few ulp as long as the angles are well below 8192.
 */
-__forceinline
-void ParticleStep(const ParticleJobUniformData* perSystemUniforms, const float stepTime, const Particle& in, Particle& out, ParticleJobSliceOutputData* sliceOutput)
+static void
+ParticleSinCos(__m128 angle, __m128& sine, __m128& cosine)
 {
-    ++sliceOutput->numLivingParticles;
-
-    // copy the *const* members
-    out.startPosition = in.startPosition;
-    out.uvMinMax = in.uvMinMax;
-    out.rotationVariation = in.rotationVariation;
-    out.sizeVariation = in.sizeVariation;
+    const __m128 signMask = _mm_set1_ps(-0.0f);
+    const __m128 sinSign = _mm_and_ps(angle, signMask);
+    __m128 x = _mm_andnot_ps(signMask, angle);
 
-    const IndexT sampleIndex = IndexT(out.relAge * (float)(ParticleSystemNumEnvelopeSamples-1));
-    n_assert(sampleIndex >= 0);            
-    n_assert(sampleIndex < ParticleSystemNumEnvelopeSamples);
+    // round the octant up to even, so x ends up within pi/4 of y * pi/4
+    __m128i octant = _mm_cvttps_epi32(_mm_mul_ps(x, _mm_set1_ps(1.27323954473516f)));
+    octant = _mm_and_si128(_mm_add_epi32(octant, _mm_set1_epi32(1)), _mm_set1_epi32(~1));
+    const __m128 y = _mm_cvtepi32_ps(octant);
 
-    const float* samples = LookupEnvelopeSamples(perSystemUniforms->sampleBuffer, sampleIndex);
-    
-    // compute current particle acceleration
-    Math::vec4 acceleration = perSystemUniforms->windVector * samples[EmitterAttrs::AirResistance];
-    acceleration += perSystemUniforms->gravity;
-    acceleration *= samples[EmitterAttrs::Mass];
+    // pi/4 in three parts, so the reduction doesn't lose precision
+    x = _mm_add_ps(x, _mm_mul_ps(y, _mm_set1_ps(-0.78515625f)));
+    x = _mm_add_ps(x, _mm_mul_ps(y, _mm_set1_ps(-2.4187564849853515625e-4f)));
+    x = _mm_add_ps(x, _mm_mul_ps(y, _mm_set1_ps(-3.77489497744594108e-8f)));
 
-    float curStretchTime = 0.0f;
-
-    // fix stretch time (if particle stretch is enabled
-    if (perSystemUniforms->stretchTime > 0.0f)
-    {
-        curStretchTime = (perSystemUniforms->stretchTime > out.age) ? out.age : perSystemUniforms->stretchTime;
-    }
+    const __m128 z = _mm_mul_ps(x, x);
+    __m128 c = _mm_add_ps(_mm_mul_ps(_mm_set1_ps(2.443315711809948e-5f), z), _mm_set1_ps(-1.388731625493765e-3f));
+    c = _mm_add_ps(_mm_mul_ps(c, z), _mm_set1_ps(4.166664568298827e-2f));
+    c = _mm_mul_ps(_mm_mul_ps(c, z), z);
+    c = _mm_add_ps(_mm_sub_ps(c, _mm_mul_ps(z, _mm_set1_ps(0.5f))), _mm_set1_ps(1.0f));
+    __m128 s = _mm_add_ps(_mm_mul_ps(_mm_set1_ps(-1.9515295891e-4f), z), _mm_set1_ps(8.3321608736e-3f));
+    s = _mm_add_ps(_mm_mul_ps(s, z), _mm_set1_ps(-1.6666654611e-1f));
+    s = _mm_add_ps(_mm_mul_ps(_mm_mul_ps(s, z), x), x);
 
-    // update position, velocity, rotation
-    ASSERT_POINT(in.position);
-    ASSERT_VECTOR(in.velocity);
-    out.position = in.position + in.velocity * samples[EmitterAttrs::VelocityFactor] * stepTime;
-    ASSERT_POINT(out.position);
-    sliceOutput->bbox.extend(Math::bbox(out.position, Math::vector(samples[EmitterAttrs::Size])));
-    out.velocity = in.velocity + acceleration * stepTime;
-    ASSERT_VECTOR(out.velocity);
-    if (perSystemUniforms->stretchToStart)
-    {
-        // NOTE: don't support particle rotation in stretch modes
-        out.stretchPosition = in.startPosition;
-        out.rotation = in.rotation;
-    }
-    else if (curStretchTime > 0.0f)
-    {
-        // NOTE: don't support particle rotation in stretch modes
-        // ???
-        out.stretchPosition = out.position -
-                              (out.velocity - acceleration * curStretchTime * 0.5f) *
-                              (perSystemUniforms->stretchTime * samples[EmitterAttrs::VelocityFactor]);
-        out.rotation = in.rotation;
-    }                
-    else
-    {
-        out.stretchPosition = out.position;
-        out.rotation = in.rotation + in.rotationVariation * samples[EmitterAttrs::RotationVelocity] * stepTime;
-    }
-    out.color.loadu(&(samples[EmitterAttrs::Red]));
-    out.color.w = Math::clamp(out.color.w, 0.0f, 1.0f);
-    out.size = samples[EmitterAttrs::Size] * in.sizeVariation;
+    // in odd quadrants the polynomials swap places
+    const __m128 swap = _mm_castsi128_ps(_mm_cmpeq_epi32(_mm_and_si128(octant, _mm_set1_epi32(2)), _mm_set1_epi32(2)));
+    const __m128 flipSin = _mm_castsi128_ps(_mm_slli_epi32(_mm_and_si128(octant, _mm_set1_epi32(4)), 29));
+    const __m128 flipCos = _mm_castsi128_ps(_mm_slli_epi32(_mm_andnot_si128(_mm_sub_epi32(octant, _mm_set1_epi32(2)), _mm_set1_epi32(4)), 29));
+    sine = _mm_xor_ps(_mm_blendv_ps(s, c, swap), _mm_xor_ps(sinSign, flipSin));
+    cosine = _mm_xor_ps(_mm_blendv_ps(c, s, swap), flipCos);
 }
 
 //------------------------------------------------------------------------------
 /**
+    Writes 5 vec4 per particle: position, stretch position, color, uvMinMax
+    and (sin(rotation), cos(rotation), size, particleId). The particles to
+    write are found 4 at a time, so only the visible ones are touched, and
+    the rotations of those 4 are turned into sine and cosine together.
 */
-void
-JobStep(const ParticleJobUniformData* perSystemUniforms, const float stepTime, unsigned int numParticles,
-             const Particle* particles_input, Particle* particles_output, 
-             ParticleJobSliceOutputData* sliceOutput)
+SizeT
+ParticleWriteVertices(const ParticleBuffer* particles, SizeT maxParticles, float* vertices)
 {
-    unsigned int i;
-    sliceOutput->bbox.begin_extend();
-    for (i = 0; i < numParticles; i++)
+    const float* px = particles->Stream(Stream_PositionX);
+    const float* py = particles->Stream(Stream_PositionY);
+    const float* pz = particles->Stream(Stream_PositionZ);
+    const float* sx = particles->Stream(Stream_StretchPositionX);
+    const float* sy = particles->Stream(Stream_StretchPositionY);
+    const float* sz = particles->Stream(Stream_StretchPositionZ);
+    const float* r = particles->Stream(Stream_ColorR);
+    const float* g = particles->Stream(Stream_ColorG);
+    const float* b = particles->Stream(Stream_ColorB);
+    const float* a = particles->Stream(Stream_ColorA);
+    const float* u0 = particles->Stream(Stream_UvMinMaxX);
+    const float* u1 = particles->Stream(Stream_UvMinMaxY);
+    const float* u2 = particles->Stream(Stream_UvMinMaxZ);
+    const float* u3 = particles->Stream(Stream_UvMinMaxW);
+    const float* rotation = particles->Stream(Stream_Rotation);
+    const float* size = particles->Stream(Stream_Size);
+    const float* particleId = particles->Stream(Stream_ParticleId);
+    const float* relAge = particles->Stream(Stream_RelAge);
+
+    const __m128 one = _mm_set1_ps(1.0f);
+    const __m128 minAlpha = _mm_set1_ps(ParticleMinAlpha);
+    SizeT numWritten = 0;
+    IndexT i;
+    const SizeT num = particles->PaddedSize();
+    for (i = 0; i < num && numWritten < maxParticles; i += 4)
     {
-        const Particle &in = particles_input[i];
-        Particle &out = particles_output[i];
-        ParticleUpdateAge(stepTime, in, out);
-        if (out.relAge < 1.0f)
+        const __m128 alive = _mm_cmplt_ps(_mm_loadu_ps(relAge + i), one);
+        const __m128 opaque = _mm_cmpgt_ps(_mm_loadu_ps(a + i), minAlpha);
+        uint mask = _mm_movemask_ps(_mm_and_ps(alive, opaque));
+        if (mask == 0)
+            continue;
+
+        __m128 sine, cosine;
+        ParticleSinCos(_mm_loadu_ps(rotation + i), sine, cosine);
+        alignas(16) float sines[4], cosines[4];
+        _mm_store_ps(sines, sine);
+        _mm_store_ps(cosines, cosine);
+        while (mask != 0 && numWritten < maxParticles)
         {
-            ParticleStep(perSystemUniforms, stepTime, in, out, sliceOutput);
+            const IndexT lane = Util::FirstOne(mask);
+            const IndexT j = i + lane;
+            mask &= mask - 1;
+
+            _mm_stream_ps(vertices, _mm_setr_ps(px[j], py[j], pz[j], 1.0f)); vertices += 4;
+            _mm_stream_ps(vertices, _mm_setr_ps(sx[j], sy[j], sz[j], 1.0f)); vertices += 4;
+            _mm_stream_ps(vertices, _mm_setr_ps(r[j], g[j], b[j], a[j])); vertices += 4;
+            _mm_stream_ps(vertices, _mm_setr_ps(u0[j], u1[j], u2[j], u3[j])); vertices += 4;
+            _mm_stream_ps(vertices, _mm_setr_ps(sines[lane], cosines[lane], size[j], particleId[j])); vertices += 4;
+            numWritten++;
         }
     }
-    sliceOutput->bbox.end_extend();
+
+    // make the streamed vertices visible before the buffer is flushed
+    _mm_sfence();
+    return numWritten;
 }
 
 } // namespace Particles
@@ -0,0 +1,33 @@
+#pragma once
+//------------------------------------------------------------------------------
+/**
+    @file particlejob.h
+
+    The kernels simulating and writing out the particles of one system.
+
+    ParticleStepSSE and ParticleStepAVX2 simulate 4 and 8 particles at a
+    time, JobStep picks the widest one the CPU supports. The vertex regions
+    handed to ParticleWriteVertices are laid out by the particle context,
+    one system after another.
+
+    @copyright
+    (C) 2019-2020 Individual contributors, see AUTHORS file
+*/
+//------------------------------------------------------------------------------
+#include "particles/particle.h"
+namespace Particles
+{
+
+/// number of floats ParticleWriteVertices writes per particle
+static const SizeT ParticleVertexWidth = 20;
+
+/// simulate 4 particles at a time
+void ParticleStepSSE(const ParticleJobUniformData* perSystemUniforms, const float stepTime, ParticleBuffer* particles, ParticleJobSliceOutputData* sliceOutput);
+/// simulate 8 particles at a time, only call if the CPU supports AVX2
+void ParticleStepAVX2(const ParticleJobUniformData* perSystemUniforms, const float stepTime, ParticleBuffer* particles, ParticleJobSliceOutputData* sliceOutput);
+/// update particle system step
+void JobStep(const ParticleJobUniformData* perSystemUniforms, const float stepTime, ParticleBuffer* particles, ParticleJobSliceOutputData* sliceOutput);
+/// write the vertices of at most maxParticles visible particles to 16 byte aligned memory, returns the number of particles written
+SizeT ParticleWriteVertices(const ParticleBuffer* particles, SizeT maxParticles, float* vertices);
+
+} // namespace Particles
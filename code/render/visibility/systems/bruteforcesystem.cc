@@ -7,9 +7,27 @@
 #include "jobs2/jobs2.h"
 #include "math/mat4.h"
 #include "math/clipstatus.h"
+#include "util/bit.h"
+#include "profiling/profiling.h"
+
+N_DECLARE_COUNTER(N_BRUTEFORCE_CACHE_HITS, Bruteforce Visibility Cache Hits);
+
 namespace Visibility
 {
 
+//------------------------------------------------------------------------------
+/**
+*/
+BruteforceSystem::BruteforceSystem()
+    : cull(FrustumCullSelect())
+    , gatherCounter(0)
+    , numGathered(0)
+    , numEntityTests(0)
+    , numCacheHits(0)
+{
+    // empty
+}
+
 //------------------------------------------------------------------------------
 /**
 */
@@ -24,80 +42,207 @@ BruteforceSystem::Setup(const BruteforceSystemLoadInfo& info)
 void
 BruteforceSystem::Run(const Threading::AtomicCounter* previousSystemCompletionCounters, const Util::FixedArray<const Threading::AtomicCounter*, true>& extraCounters)
 {
+    // Report how much of the last frame could be reused, its jobs are done by now
+    N_BUDGET_COUNTER_SETUP(N_BRUTEFORCE_CACHE_HITS, this->numEntityTests);
+    N_BUDGET_COUNTER_RESET(N_BRUTEFORCE_CACHE_HITS);
+    N_BUDGET_COUNTER_INCR(N_BRUTEFORCE_CACHE_HITS, this->numCacheHits);
+    this->numEntityTests = this->ent.count * this->obs.count;
+    this->numCacheHits = 0;
+
+    if (this->ent.count == 0)
+        return;
+
+    // Pad to whole words of always visible bits, which also covers the widest batch of the kernels
+    const SizeT capacity = (this->ent.count + 31) & ~31;
+    if (this->minX.Size() < capacity)
+    {
+        this->minX.Resize(capacity);
+        this->minY.Resize(capacity);
+        this->minZ.Resize(capacity);
+        this->maxX.Resize(capacity);
+        this->maxY.Resize(capacity);
+        this->maxZ.Resize(capacity);
+        this->alwaysVisible.Resize(capacity / 32);
+        this->ids.Resize(capacity);
+        this->dirty.Resize(capacity / 32);
+    }
+
+    // Gather the bounding boxes once for all observers, as soon as they are ready,
+    // and mark the ones which aren't what they were last frame
+    n_assert(this->gatherCounter == 0);
+    this->gatherCounter = 1;
+    Jobs2::JobDispatch(
+        [
+            ids = this->ent.ids
+            , boundingBoxes = this->ent.boxes
+            , flags = this->ent.entityFlags
+            , minX = this->minX.Begin(), minY = this->minY.Begin(), minZ = this->minZ.Begin()
+            , maxX = this->maxX.Begin(), maxY = this->maxY.Begin(), maxZ = this->maxZ.Begin()
+            , alwaysVisible = this->alwaysVisible.Begin()
+            , previousIds = this->ids.Begin()
+            , numPrevious = this->numGathered
+            , dirty = this->dirty.Begin()
+        ]
+    (SizeT totalJobs, SizeT groupSize, IndexT groupIndex, SizeT invocationOffset)
+    {
+        N_SCOPE(BruteforceGatherBoxes, Visibility);
+        uint32 previousAlwaysVisible = 0;
+        for (IndexT i = 0; i < groupSize; i++)
+        {
+            IndexT index = i + invocationOffset;
+            if (index >= totalJobs)
+                return;
+
+            // Groups start at a multiple of 32, so every word is owned by a single job
+            if ((index & 31) == 0)
+            {
+                previousAlwaysVisible = alwaysVisible[index >> 5];
+                alwaysVisible[index >> 5] = 0;
+                dirty[index >> 5] = 0;
+            }
+
+            uint32 objectId = ids[index];
+            const Math::bbox& box = boundingBoxes[objectId];
+            const uint32 bit = 1u << (index & 31);
+            const bool isAlwaysVisible = AllBits(flags[objectId], (uint32_t)Models::NodeInstanceFlags::NodeInstance_AlwaysVisible);
+            const bool changed = index >= numPrevious
+                || previousIds[index] != objectId
+                || minX[index] != box.pmin.x || minY[index] != box.pmin.y || minZ[index] != box.pmin.z
+                || maxX[index] != box.pmax.x || maxY[index] != box.pmax.y || maxZ[index] != box.pmax.z
+                || ((previousAlwaysVisible & bit) != 0) != isAlwaysVisible;
+
+            previousIds[index] = objectId;
+            minX[index] = box.pmin.x;
+            minY[index] = box.pmin.y;
+            minZ[index] = box.pmin.z;
+            maxX[index] = box.pmax.x;
+            maxY[index] = box.pmax.y;
+            maxZ[index] = box.pmax.z;
+
+            if (isAlwaysVisible)
+                alwaysVisible[index >> 5] |= bit;
+            if (changed)
+                dirty[index >> 5] |= bit;
+        }
+    }
+    , this->ent.count
+    , GroupSize
+    , extraCounters
+    , { &this->gatherCounter }
+    , nullptr);
+    this->numGathered = this->ent.count;
+
+    const FrustumCullBoxes boxes =
+    {
+        this->minX.Begin(), this->minY.Begin(), this->minZ.Begin(),
+        this->maxX.Begin(), this->maxY.Begin(), this->maxZ.Begin(),
+        this->alwaysVisible.Begin()
+    };
+
+    // Observers are matched to last frame's by index, if there are more or less nothing can be reused
+    if (this->caches.Size() != this->obs.count)
+    {
+        this->caches.Resize(this->obs.count);
+        for (ObserverCache& cache : this->caches)
+            cache.valid = false;
+    }
+
     IndexT i;
     for (i = 0; i < this->obs.count; i++)
     {
-        Math::mat4 camera = this->obs.transforms[i];
-
         n_assert(this->obs.completionCounters[i] == 0);
         this->obs.completionCounters[i] = 1;
 
         // Setup counters
-        Util::FixedArray<const Threading::AtomicCounter*, true> counters(extraCounters.Size() + (previousSystemCompletionCounters == nullptr ? 0 : 1));
-        if (!extraCounters.IsEmpty())
-            Memory::CopyElements(extraCounters.Begin(), counters.Begin(), extraCounters.Size());
+        Util::FixedArray<const Threading::AtomicCounter*, true> counters(previousSystemCompletionCounters == nullptr ? 1 : 2);
+        counters[0] = &this->gatherCounter;
         if (previousSystemCompletionCounters != nullptr)
-            counters[extraCounters.Size()] = &previousSystemCompletionCounters[i];
-
-        // Splat the matrix such that all _x, _y, ... will contain the column values of x, y, ...
-        // This provides a way to rearrange the camera transform into a more SSE friendly matrix transform in the job
-        Math::vec4 colX[4], colY[4], colZ[4], colW[4];
-        colX[0] = Math::splat_x((camera).r[0]);
-        colX[1] = Math::splat_x((camera).r[1]);
-        colX[2] = Math::splat_x((camera).r[2]);
-        colX[3] = Math::splat_x((camera).r[3]);
-
-        colY[0] = Math::splat_y((camera).r[0]);
-        colY[1] = Math::splat_y((camera).r[1]);
-        colY[2] = Math::splat_y((camera).r[2]);
-        colY[3] = Math::splat_y((camera).r[3]);
-
-        colZ[0] = Math::splat_z((camera).r[0]);
-        colZ[1] = Math::splat_z((camera).r[1]);
-        colZ[2] = Math::splat_z((camera).r[2]);
-        colZ[3] = Math::splat_z((camera).r[3]);
-
-        colW[0] = Math::splat_w((camera).r[0]);
-        colW[1] = Math::splat_w((camera).r[1]);
-        colW[2] = Math::splat_w((camera).r[2]);
-        colW[3] = Math::splat_w((camera).r[3]);
+            counters[1] = &previousSystemCompletionCounters[i];
+
+        FrustumPlanes planes;
+        FrustumPlanesSetup(planes, this->obs.transforms[i], this->obs.isOrtho[i]);
+
+        // An observer which moved has to test everything again
+        ObserverCache& cache = this->caches[i];
+        if (cache.visible.Size() < capacity / 32)
+            cache.visible.Resize(capacity / 32);
+        const bool moved = !cache.valid || cache.isOrtho != this->obs.isOrtho[i] || cache.transform != this->obs.transforms[i];
+        cache.transform = this->obs.transforms[i];
+        cache.isOrtho = this->obs.isOrtho[i];
+        cache.valid = true;
 
         // All set, run the job
         Jobs2::JobDispatch(
             [
-                ids = this->ent.ids
+                cull = this->cull
+                , boxes
+                , planes
+                , moved
+                , cached = cache.visible.Begin()
+                , dirty = this->dirty.Begin()
+                , ids = this->ent.ids
                 , boundingBoxes = this->ent.boxes
-                , flags = this->ent.entityFlags
-                , isOrtho = this->obs.isOrtho[i]
-                , clipStatuses = this->obs.results[i].Begin()
-                , colX, colY, colZ, colW
+                , numCacheHits = &this->numCacheHits
+                , results = &this->obs.results[i]
             ]
         (SizeT totalJobs, SizeT groupSize, IndexT groupIndex, SizeT invocationOffset)
         {
             N_SCOPE(BruteforceViewFrustumCulling, Visibility);
-            // Iterate over work group
-            for (IndexT i = 0; i < groupSize; i++)
+            if (invocationOffset >= totalJobs)
+                return;
+
+            const SizeT num = Math::min(groupSize, totalJobs - invocationOffset);
+            const IndexT firstWord = invocationOffset >> 5;
+            const IndexT endWord = (invocationOffset + num + 31) >> 5;
+            uint32 visible[GroupSize];
+            SizeT numVisible = 0;
+            if (moved)
             {
-                // Get item index
-                IndexT index = i + invocationOffset;
-                if (index >= totalJobs)
-                    return;
+                // Cull the whole group at once and remember what's visible
+                numVisible = cull(planes, boxes, invocationOffset, num, visible);
+                Memory::Clear(cached + firstWord, (endWord - firstWord) * sizeof(uint32));
+                IndexT j;
+                for (j = 0; j < numVisible; j++)
+                    cached[visible[j] >> 5] |= 1u << (visible[j] & 31);
+            }
+            else
+            {
+                // Only test what changed since last frame
+                SizeT numTested = 0;
+                IndexT word;
+                for (word = firstWord; word < endWord; word++)
+                {
+                    uint32 changed = dirty[word];
+                    uint32 mask = cached[word] & ~changed;
+                    numTested += Util::PopCnt(changed);
+                    while (changed != 0)
+                    {
+                        const uint bit = Util::FirstOne(changed);
+                        const IndexT index = (word << 5) + bit;
+                        if ((boxes.alwaysVisible[word] & (1u << bit)) != 0
+                            || FrustumClip(planes, boundingBoxes[ids[index]]) != Math::ClipStatus::Outside)
+                            mask |= 1u << bit;
+                        changed &= changed - 1;
+                    }
 
-                uint32 objectId = ids[index];
+                    // Entities past the end may be left from a frame with more of them
+                    const SizeT remaining = totalJobs - (word << 5);
+                    if (remaining < 32)
+                        mask &= (1u << remaining) - 1;
+                    cached[word] = mask;
 
-                if (AllBits(flags[objectId], (uint32_t)Models::NodeInstanceFlags::NodeInstance_AlwaysVisible))
-                {
-                    clipStatuses[index] = Math::ClipStatus::Inside;
-                    continue;
+                    while (mask != 0)
+                    {
+                        visible[numVisible++] = (word << 5) + Util::FirstOne(mask);
+                        mask &= mask - 1;
+                    }
                 }
-
-                // Run bounding box check and store output in clip statuses, if clip status is still outside
-                if (clipStatuses[index] == Math::ClipStatus::Outside)
-                    clipStatuses[index] = boundingBoxes[objectId].clipstatus(colX, colY, colZ, colW, isOrtho);
+                Threading::Interlocked::Add(numCacheHits, (int)(num - numTested));
             }
+            results->Append(visible, numVisible);
         }
         , this->ent.count
-        , 1024
+        , GroupSize
         , counters
         , { &this->obs.completionCounters[i] }
         , nullptr);
@@ -3,17 +3,34 @@
 /**
     Brute force system
 
+    Tests every entity against every observer. The bounding boxes are first
+    gathered into structure of arrays, once for all observers, which are then
+    culled with the widest frustum culling kernel the CPU supports.
+
+    What each observer saw is kept between frames, one bit per entity. While
+    the gathered boxes are written, the ones which differ from the last frame
+    are marked dirty. An observer which didn't move only tests its dirty
+    entities and takes the rest from the last frame, so a static observer
+    in a static scene doesn't cull anything. An observer which moved culls
+    everything again. The number of entities taken from the last frame is
+    reported as a profiling counter.
+
     @copyright
     (C) 2018-2020 Individual contributors, see AUTHORS file
 */
 //------------------------------------------------------------------------------
 #include "visibilitysystem.h"
+#include "frustumculling.h"
 #include "jobs/jobs.h"
 namespace Visibility
 {
 
 class BruteforceSystem : public VisibilitySystem
 {
+public:
+    /// constructor
+    BruteforceSystem();
+
 private:
     friend class ObserverContext;
 
@@ -22,6 +39,33 @@ private:
 
     /// run system
     void Run(const Threading::AtomicCounter* previousSystemCompletionCounters, const Util::FixedArray<const Threading::AtomicCounter*, true>& extraCounters) override;
+
+    /// number of entities per job, a multiple of 32 so each job writes whole words of always visible bits
+    static const SizeT GroupSize = 1024;
+
+    /// what an observer saw last frame
+    struct ObserverCache
+    {
+        Math::mat4 transform;
+        bool isOrtho;
+        bool valid;
+        Util::FixedArray<uint32> visible;   // one bit per entity
+    };
+
+    FrustumCullFunc cull;
+    Util::FixedArray<float> minX, minY, minZ, maxX, maxY, maxZ;
+    Util::FixedArray<uint32> alwaysVisible;
+    Threading::AtomicCounter gatherCounter;
+
+    /// entity ids of the last frame, and one bit per entity which changed since
+    Util::FixedArray<uint32> ids;
+    Util::FixedArray<uint32> dirty;
+    SizeT numGathered;
+    Util::FixedArray<ObserverCache> caches;
+
+    /// entities tested and taken from the last frame, for profiling
+    SizeT numEntityTests;
+    Threading::AtomicCounter numCacheHits;
 };
 
 } // namespace Visibility
@@ -0,0 +1,241 @@
+//------------------------------------------------------------------------------
+//  frustumculling.cc
+//  (C) 2024 Individual contributors, see AUTHORS file
+//------------------------------------------------------------------------------
+#include "frustumculling.h"
+#include "system/cpu.h"
+#include "util/bit.h"
+#include <immintrin.h>
+
+namespace Visibility
+{
+
+//------------------------------------------------------------------------------
+/**
+*/
+void
+FrustumPlanesSetup(FrustumPlanes& planes, const Math::mat4& viewProjection, bool isOrtho)
+{
+    FrustumPlanesSetup(planes, viewProjection, isOrtho, -1.0f, -1.0f, 1.0f, 1.0f);
+}
+
+//------------------------------------------------------------------------------
+/**
+    A point p is transformed to clip space as the sum of the rows of the
+    matrix weighted by p, and it's inside if left * w <= x <= right * w,
+    bottom * w <= y <= top * w and -w <= z <= w. Each of these six
+    conditions is a plane in world space.
+*/
+void
+FrustumPlanesSetup(FrustumPlanes& planes, const Math::mat4& viewProjection, bool isOrtho, float left, float bottom, float right, float top)
+{
+    IndexT i;
+    for (i = 0; i < 4; i++)
+    {
+        const Math::vec4& row = viewProjection.r[i];
+        const float w = isOrtho ? (i == 3 ? 1.0f : 0.0f) : row.w;
+        float* coefficients[] = { planes.a, planes.b, planes.c, planes.d };
+        float* plane = coefficients[i];
+        plane[0] = row.x - left * w;    // left
+        plane[1] = right * w - row.x;   // right
+        plane[2] = row.y - bottom * w;  // bottom
+        plane[3] = top * w - row.y;     // top
+        plane[4] = w + row.z;           // far
+        plane[5] = w - row.z;           // near
+    }
+}
+
+//------------------------------------------------------------------------------
+/**
+    The box is outside if its corner furthest along the plane normal is on
+    the outside of any plane, and inside if its nearest corner is inside of
+    all of them.
+*/
+Math::ClipStatus::Type
+FrustumClip(const FrustumPlanes& planes, const Math::bbox& box)
+{
+    bool inside = true;
+    IndexT i;
+    for (i = 0; i < 6; i++)
+    {
+        const float ax0 = planes.a[i] * box.pmin.x, ax1 = planes.a[i] * box.pmax.x;
+        const float by0 = planes.b[i] * box.pmin.y, by1 = planes.b[i] * box.pmax.y;
+        const float cz0 = planes.c[i] * box.pmin.z, cz1 = planes.c[i] * box.pmax.z;
+        const float furthest = Math::max(ax0, ax1) + Math::max(by0, by1) + Math::max(cz0, cz1) + planes.d[i];
+        if (furthest < 0.0f)
+            return Math::ClipStatus::Outside;
+        const float nearest = Math::min(ax0, ax1) + Math::min(by0, by1) + Math::min(cz0, cz1) + planes.d[i];
+        inside &= nearest >= 0.0f;
+    }
+    return inside ? Math::ClipStatus::Inside : Math::ClipStatus::Clipped;
+}
+
+//------------------------------------------------------------------------------
+/**
+*/
+FrustumCullFunc
+FrustumCullSelect()
+{
+    if (System::Cpu::HasFeature(System::Cpu::AVX512F))
+        return FrustumCullAVX512;
+    else if (System::Cpu::HasFeature(System::Cpu::AVX))
+        return FrustumCullAVX;
+    else
+        return FrustumCullSSE;
+}
+
+//------------------------------------------------------------------------------
+/**
+    Get the always visible bits for a batch
+*/
+static inline uint
+AlwaysVisibleBits(const uint32* alwaysVisible, IndexT index, uint batchMask)
+{
+    return (alwaysVisible[index >> 5] >> (index & 31)) & batchMask;
+}
+
+//------------------------------------------------------------------------------
+/**
+    Append the indices of the set bits of a mask
+*/
+static inline SizeT
+Compact(uint mask, IndexT index, uint32* visible)
+{
+    SizeT num = 0;
+    while (mask != 0)
+    {
+        visible[num++] = index + Util::FirstOne(mask);
+        mask &= mask - 1;
+    }
+    return num;
+}
+
+//------------------------------------------------------------------------------
+/**
+*/
+SizeT
+FrustumCullSSE(const FrustumPlanes& planes, const FrustumCullBoxes& boxes, IndexT begin, SizeT num, uint32* visible)
+{
+    n_assert((begin % FrustumCullBatchSize) == 0);
+    const __m128 zero = _mm_setzero_ps();
+    SizeT numVisible = 0;
+    IndexT index;
+    for (index = begin; index < begin + num; index += 4)
+    {
+        const SizeT remaining = begin + num - index;
+        const uint batchMask = remaining >= 4 ? 0xF : (1u << remaining) - 1;
+
+        const __m128 minX = _mm_loadu_ps(boxes.minX + index);
+        const __m128 minY = _mm_loadu_ps(boxes.minY + index);
+        const __m128 minZ = _mm_loadu_ps(boxes.minZ + index);
+        const __m128 maxX = _mm_loadu_ps(boxes.maxX + index);
+        const __m128 maxY = _mm_loadu_ps(boxes.maxY + index);
+        const __m128 maxZ = _mm_loadu_ps(boxes.maxZ + index);
+
+        uint mask = batchMask;
+        IndexT i;
+        for (i = 0; i < 6 && mask != 0; i++)
+        {
+            const __m128 a = _mm_set1_ps(planes.a[i]);
+            const __m128 b = _mm_set1_ps(planes.b[i]);
+            const __m128 c = _mm_set1_ps(planes.c[i]);
+            const __m128 d = _mm_set1_ps(planes.d[i]);
+            __m128 furthest = _mm_max_ps(_mm_mul_ps(a, minX), _mm_mul_ps(a, maxX));
+            furthest = _mm_add_ps(furthest, _mm_max_ps(_mm_mul_ps(b, minY), _mm_mul_ps(b, maxY)));
+            furthest = _mm_add_ps(furthest, _mm_max_ps(_mm_mul_ps(c, minZ), _mm_mul_ps(c, maxZ)));
+            furthest = _mm_add_ps(furthest, d);
+            mask &= _mm_movemask_ps(_mm_cmpge_ps(furthest, zero));
+        }
+        mask |= AlwaysVisibleBits(boxes.alwaysVisible, index, batchMask);
+        numVisible += Compact(mask, index, visible + numVisible);
+    }
+    return numVisible;
+}
+
+//------------------------------------------------------------------------------
+/**
+*/
+N_TARGET_AVX SizeT
+FrustumCullAVX(const FrustumPlanes& planes, const FrustumCullBoxes& boxes, IndexT begin, SizeT num, uint32* visible)
+{
+    n_assert((begin % FrustumCullBatchSize) == 0);
+    const __m256 zero = _mm256_setzero_ps();
+    SizeT numVisible = 0;
+    IndexT index;
+    for (index = begin; index < begin + num; index += 8)
+    {
+        const SizeT remaining = begin + num - index;
+        const uint batchMask = remaining >= 8 ? 0xFF : (1u << remaining) - 1;
+
+        const __m256 minX = _mm256_loadu_ps(boxes.minX + index);
+        const __m256 minY = _mm256_loadu_ps(boxes.minY + index);
+        const __m256 minZ = _mm256_loadu_ps(boxes.minZ + index);
+        const __m256 maxX = _mm256_loadu_ps(boxes.maxX + index);
+        const __m256 maxY = _mm256_loadu_ps(boxes.maxY + index);
+        const __m256 maxZ = _mm256_loadu_ps(boxes.maxZ + index);
+
+        uint mask = batchMask;
+        IndexT i;
+        for (i = 0; i < 6 && mask != 0; i++)
+        {
+            const __m256 a = _mm256_set1_ps(planes.a[i]);
+            const __m256 b = _mm256_set1_ps(planes.b[i]);
+            const __m256 c = _mm256_set1_ps(planes.c[i]);
+            const __m256 d = _mm256_set1_ps(planes.d[i]);
+            __m256 furthest = _mm256_max_ps(_mm256_mul_ps(a, minX), _mm256_mul_ps(a, maxX));
+            furthest = _mm256_add_ps(furthest, _mm256_max_ps(_mm256_mul_ps(b, minY), _mm256_mul_ps(b, maxY)));
+            furthest = _mm256_add_ps(furthest, _mm256_max_ps(_mm256_mul_ps(c, minZ), _mm256_mul_ps(c, maxZ)));
+            furthest = _mm256_add_ps(furthest, d);
+            mask &= _mm256_movemask_ps(_mm256_cmp_ps(furthest, zero, _CMP_GE_OQ));
+        }
+        mask |= AlwaysVisibleBits(boxes.alwaysVisible, index, batchMask);
+        numVisible += Compact(mask, index, visible + numVisible);
+    }
+    _mm256_zeroupper();
+    return numVisible;
+}
+
+//------------------------------------------------------------------------------
+/**
+*/
+N_TARGET_AVX512 SizeT
+FrustumCullAVX512(const FrustumPlanes& planes, const FrustumCullBoxes& boxes, IndexT begin, SizeT num, uint32* visible)
+{
+    n_assert((begin % FrustumCullBatchSize) == 0);
+    const __m512 zero = _mm512_setzero_ps();
+    SizeT numVisible = 0;
+    IndexT index;
+    for (index = begin; index < begin + num; index += 16)
+    {
+        const SizeT remaining = begin + num - index;
+        const uint batchMask = remaining >= 16 ? 0xFFFF : (1u << remaining) - 1;
+
+        const __m512 minX = _mm512_loadu_ps(boxes.minX + index);
+        const __m512 minY = _mm512_loadu_ps(boxes.minY + index);
+        const __m512 minZ = _mm512_loadu_ps(boxes.minZ + index);
+        const __m512 maxX = _mm512_loadu_ps(boxes.maxX + index);
+        const __m512 maxY = _mm512_loadu_ps(boxes.maxY + index);
+        const __m512 maxZ = _mm512_loadu_ps(boxes.maxZ + index);
+
+        __mmask16 mask = (__mmask16)batchMask;
+        IndexT i;
+        for (i = 0; i < 6 && mask != 0; i++)
+        {
+            const __m512 a = _mm512_set1_ps(planes.a[i]);
+            const __m512 b = _mm512_set1_ps(planes.b[i]);
+            const __m512 c = _mm512_set1_ps(planes.c[i]);
+            const __m512 d = _mm512_set1_ps(planes.d[i]);
+            __m512 furthest = _mm512_max_ps(_mm512_mul_ps(a, minX), _mm512_mul_ps(a, maxX));
+            furthest = _mm512_add_ps(furthest, _mm512_max_ps(_mm512_mul_ps(b, minY), _mm512_mul_ps(b, maxY)));
+            furthest = _mm512_add_ps(furthest, _mm512_max_ps(_mm512_mul_ps(c, minZ), _mm512_mul_ps(c, maxZ)));
+            furthest = _mm512_add_ps(furthest, d);
+            mask = _mm512_mask_cmp_ps_mask(mask, furthest, zero, _CMP_GE_OQ);
+        }
+        const uint bits = (uint)mask | AlwaysVisibleBits(boxes.alwaysVisible, index, batchMask);
+        numVisible += Compact(bits, index, visible + numVisible);
+    }
+    _mm256_zeroupper();
+    return numVisible;
+}
+
+} // namespace Visibility
@@ -0,0 +1,67 @@
+#pragma once
+//------------------------------------------------------------------------------
+/**
+    Frustum culling kernels
+
+    Observers are turned into six clip planes once per frame, and bounding
+    boxes are tested against them as structure of arrays, 4, 8 or 16 boxes at
+    a time depending on what the CPU supports. The kernels don't produce a
+    clip status per box, but append the indices of the visible boxes to a
+    list, so whatever runs after them only touches what's visible.
+
+    FrustumClip() is the scalar version of the same test, for systems which
+    walk a hierarchy. Since both use the exact same arithmetic, a box found
+    visible by one is found visible by the other.
+
+    @copyright
+    (C) 2024 Individual contributors, see AUTHORS file
+*/
+//------------------------------------------------------------------------------
+#include "math/mat4.h"
+#include "math/bbox.h"
+#include "math/clipstatus.h"
+namespace Visibility
+{
+
+/// planes of an observer, a point is on the inside of a plane if a*x + b*y + c*z + d >= 0
+struct FrustumPlanes
+{
+    float a[6], b[6], c[6], d[6];
+};
+
+/// bounding boxes as structure of arrays, readable up to count rounded up to FrustumCullBatchSize
+struct FrustumCullBoxes
+{
+    const float* minX;
+    const float* minY;
+    const float* minZ;
+    const float* maxX;
+    const float* maxY;
+    const float* maxZ;
+    /// one bit per box, boxes with the bit set are visible without testing
+    const uint32* alwaysVisible;
+};
+
+/// widest batch of any kernel, ranges passed to the kernels have to start at a multiple of this
+static const SizeT FrustumCullBatchSize = 16;
+
+/// culls the boxes in [begin, begin + num) and writes the indices of the visible ones, returns how many
+typedef SizeT (*FrustumCullFunc)(const FrustumPlanes& planes, const FrustumCullBoxes& boxes, IndexT begin, SizeT num, uint32* visible);
+
+/// setup planes from a view projection matrix
+void FrustumPlanesSetup(FrustumPlanes& planes, const Math::mat4& viewProjection, bool isOrtho);
+/// setup planes narrowed to a rectangle in normalized device coordinates
+void FrustumPlanesSetup(FrustumPlanes& planes, const Math::mat4& viewProjection, bool isOrtho, float left, float bottom, float right, float top);
+/// classify a single box against the planes
+Math::ClipStatus::Type FrustumClip(const FrustumPlanes& planes, const Math::bbox& box);
+/// get the widest kernel the CPU supports
+FrustumCullFunc FrustumCullSelect();
+
+/// 4 boxes at a time
+SizeT FrustumCullSSE(const FrustumPlanes& planes, const FrustumCullBoxes& boxes, IndexT begin, SizeT num, uint32* visible);
+/// 8 boxes at a time
+SizeT FrustumCullAVX(const FrustumPlanes& planes, const FrustumCullBoxes& boxes, IndexT begin, SizeT num, uint32* visible);
+/// 16 boxes at a time
+SizeT FrustumCullAVX512(const FrustumPlanes& planes, const FrustumCullBoxes& boxes, IndexT begin, SizeT num, uint32* visible);
+
+} // namespace Visibility
@@ -0,0 +1,197 @@
+//------------------------------------------------------------------------------
+//  occlusionsystem.cc
+//  (C) 2024 Individual contributors, see AUTHORS file
+//------------------------------------------------------------------------------
+
+#include "occlusionsystem.h"
+#include "jobs2/jobs2.h"
+#include "math/mat4.h"
+namespace Visibility
+{
+
+//------------------------------------------------------------------------------
+/**
+*/
+OcclusionSystem::OcclusionSystem()
+    : width(DefaultWidth)
+    , height(DefaultHeight)
+    , tilesX(DefaultWidth / TileWidth)
+    , tilesY(DefaultHeight / TileHeight)
+{
+    // empty
+}
+
+//------------------------------------------------------------------------------
+/**
+*/
+OcclusionSystem::~OcclusionSystem()
+{
+    for (DepthBuffer* buffer : this->buffers)
+        delete buffer;
+    this->buffers.Clear();
+}
+
+//------------------------------------------------------------------------------
+/**
+*/
+void
+OcclusionSystem::Setup(const OcclusionSystemLoadInfo& info)
+{
+    if (info.width > 0 && info.height > 0)
+    {
+        this->width = info.width;
+        this->height = info.height;
+    }
+
+    // The buffer is padded to whole tiles, the pixels outside are never tested
+    this->tilesX = (this->width + TileWidth - 1) / TileWidth;
+    this->tilesY = (this->height + TileHeight - 1) / TileHeight;
+}
+
+//------------------------------------------------------------------------------
+/**
+*/
+IndexT
+OcclusionSystem::AddOccluder(const Math::vec3* vertices, SizeT numVertices, const uint32* indices, SizeT numIndices, const Math::mat4& transform)
+{
+    n_assert((numIndices % 3) == 0);
+    IndexT index;
+    if (this->freeOccluders.IsEmpty())
+    {
+        index = this->occluders.Size();
+        this->occluders.Append(Occluder());
+    }
+    else
+    {
+        index = this->freeOccluders.Back();
+        this->freeOccluders.EraseBack();
+    }
+
+    Occluder& occluder = this->occluders[index];
+    occluder.vertices.Clear();
+    occluder.vertices.Reserve(numVertices);
+    IndexT i;
+    for (i = 0; i < numVertices; i++)
+        occluder.vertices.Append(Math::vec4(vertices[i], 1.0f));
+    occluder.indices.Clear();
+    occluder.indices.AppendArray(indices, numIndices);
+    occluder.transform = transform;
+    occluder.active = true;
+    return index;
+}
+
+//------------------------------------------------------------------------------
+/**
+*/
+void
+OcclusionSystem::SetOccluderTransform(IndexT occluder, const Math::mat4& transform)
+{
+    n_assert(this->occluders[occluder].active);
+    this->occluders[occluder].transform = transform;
+}
+
+//------------------------------------------------------------------------------
+/**
+*/
+void
+OcclusionSystem::RemoveOccluder(IndexT occluder)
+{
+    n_assert(this->occluders[occluder].active);
+    Occluder& data = this->occluders[occluder];
+    data.vertices.Clear();
+    data.indices.Clear();
+    data.active = false;
+    this->freeOccluders.Append(occluder);
+}
+
+//------------------------------------------------------------------------------
+/**
+*/
+void
+OcclusionSystem::Run(const Threading::AtomicCounter* previousSystemCompletionCounters, const Util::FixedArray<const Threading::AtomicCounter*, true>& extraCounters)
+{
+    if (this->ent.count == 0)
+        return;
+
+    const SizeT numTiles = this->tilesX * this->tilesY;
+    while (this->buffers.Size() < this->obs.count)
+    {
+        DepthBuffer* buffer = new DepthBuffer;
+        buffer->depth.Resize(numTiles * TileSize);
+        buffer->tileMaxDepth.Resize(numTiles);
+        buffer->bins.Resize(numTiles);
+        buffer->setupCounter = 0;
+        buffer->rasterCounter = 0;
+        this->buffers.Append(buffer);
+    }
+
+    IndexT i;
+    for (i = 0; i < this->obs.count; i++)
+    {
+        DepthBuffer* buffer = this->buffers[i];
+        buffer->viewProjection = this->obs.transforms[i];
+        buffer->isOrtho = this->obs.isOrtho[i];
+
+        // The occluders don't depend on anything else this frame, so they are
+        // rasterized while the systems before this one are still culling
+        n_assert(buffer->setupCounter == 0);
+        buffer->setupCounter = 1;
+        Jobs2::JobDispatch(
+            [system = this, buffer]
+        (SizeT totalJobs, SizeT groupSize, IndexT groupIndex, SizeT invocationOffset)
+        {
+            N_SCOPE(OcclusionSetupTriangles, Visibility);
+            OcclusionSystem::SetupTriangles(system, buffer);
+        }
+        , 1
+        , nullptr
+        , { &buffer->setupCounter }
+        , nullptr);
+
+        n_assert(buffer->rasterCounter == 0);
+        buffer->rasterCounter = 1;
+        Jobs2::JobDispatch(
+            [system = this, buffer]
+        (SizeT totalJobs, SizeT groupSize, IndexT groupIndex, SizeT invocationOffset)
+        {
+            N_SCOPE(OcclusionRasterize, Visibility);
+            for (IndexT j = 0; j < groupSize; j++)
+            {
+                IndexT tile = j + invocationOffset;
+                if (tile >= totalJobs)
+                    return;
+                OcclusionSystem::RasterizeTile(system, buffer, tile);
+            }
+        }
+        , numTiles
+        , TilesPerJob
+        , { &buffer->setupCounter }
+        , { &buffer->rasterCounter }
+        , nullptr);
+
+        // Setup counters, the visible list is done when the previous system is
+        Util::FixedArray<const Threading::AtomicCounter*, true> counters(extraCounters.Size() + (previousSystemCompletionCounters == nullptr ? 1 : 2));
+        IndexT numCounters = 0;
+        counters[numCounters++] = &buffer->rasterCounter;
+        if (previousSystemCompletionCounters != nullptr)
+            counters[numCounters++] = &previousSystemCompletionCounters[i];
+        for (const Threading::AtomicCounter* counter : extraCounters)
+            counters[numCounters++] = counter;
+
+        n_assert(this->obs.completionCounters[i] == 0);
+        this->obs.completionCounters[i] = 1;
+        Jobs2::JobDispatch(
+            [system = this, buffer, results = &this->obs.results[i]]
+        (SizeT totalJobs, SizeT groupSize, IndexT groupIndex, SizeT invocationOffset)
+        {
+            N_SCOPE(OcclusionCulling, Visibility);
+            OcclusionSystem::CullOccludees(system, buffer, results);
+        }
+        , 1
+        , counters
+        , { &this->obs.completionCounters[i] }
+        , nullptr);
+    }
+}
+
+} // namespace Visibility
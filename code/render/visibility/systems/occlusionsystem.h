@@ -0,0 +1,114 @@
+#pragma once
+//------------------------------------------------------------------------------
+/**
+    Occlusion system
+
+    Software occlusion culling on the CPU. A small set of occluder meshes,
+    like walls and buildings, is rasterized into a low resolution depth buffer
+    per observer, and the bounding boxes of the entities found visible by the
+    systems before this one are tested against it. Entities hidden behind the
+    occluders are removed from the visible list of the observer, so this system
+    has to be created after the frustum culling systems.
+
+    The depth buffer is split into tiles, and each tile keeps the farthest
+    depth of its pixels, so a box is most of the time rejected or accepted
+    by looking at the tiles it covers. Only tiles where that isn't enough are
+    tested per pixel. Occluder triangles are binned to the tiles they touch,
+    and every tile is rasterized by its own job, 4 pixels at a time.
+
+    Depth is z / w of the projection, which goes from 0 at the near plane to 1
+    at the far plane. Boxes crossing the near plane or leaving the screen are
+    always considered visible.
+
+    Occluders are not taken from the entities, but added explicitly, and must
+    not be changed while visibility is running.
+
+    @copyright
+    (C) 2024 Individual contributors, see AUTHORS file
+*/
+//------------------------------------------------------------------------------
+#include "visibilitysystem.h"
+namespace Visibility
+{
+
+class OcclusionSystem : public VisibilitySystem
+{
+public:
+    /// constructor
+    OcclusionSystem();
+    /// destructor
+    virtual ~OcclusionSystem();
+
+    /// add an occluder, every three indices form a triangle, returns the occluder index
+    IndexT AddOccluder(const Math::vec3* vertices, SizeT numVertices, const uint32* indices, SizeT numIndices, const Math::mat4& transform);
+    /// set the object to world transform of an occluder
+    void SetOccluderTransform(IndexT occluder, const Math::mat4& transform);
+    /// remove an occluder, its index may be reused
+    void RemoveOccluder(IndexT occluder);
+
+    /// run system
+    void Run(const Threading::AtomicCounter* previousSystemCompletionCounters, const Util::FixedArray<const Threading::AtomicCounter*, true>& extraCounters) override;
+
+private:
+    friend class ObserverContext;
+
+    /// setup from load info
+    void Setup(const OcclusionSystemLoadInfo& info);
+
+    /// size of a tile in pixels, the width has to be a multiple of 4
+    static const SizeT TileWidth = 32;
+    static const SizeT TileHeight = 8;
+    static const SizeT TileSize = TileWidth * TileHeight;
+    /// number of tiles rasterized by one job
+    static const SizeT TilesPerJob = 4;
+    /// default size of the depth buffer
+    static const SizeT DefaultWidth = 256;
+    static const SizeT DefaultHeight = 128;
+
+    struct Occluder
+    {
+        Util::Array<Math::vec4> vertices;   // object space
+        Util::Array<uint32> indices;
+        Math::mat4 transform;
+        bool active;
+    };
+
+    /// a triangle ready to rasterize, a pixel center is inside if all edges are >= 0
+    struct Triangle
+    {
+        float edgeA[3], edgeB[3], edgeC[3];
+        float depthX, depthY, depth0;       // depth = depthX * x + depthY * y + depth0
+        int minX, minY, maxX, maxY;         // pixel bounds, max is exclusive
+    };
+
+    /// depth buffer of one observer
+    struct DepthBuffer
+    {
+        Math::mat4 viewProjection;
+        bool isOrtho;
+        Util::FixedArray<float> depth;      // tile by tile, TileSize pixels each
+        Util::FixedArray<float> tileMaxDepth;
+        Util::Array<Math::vec4> clipVertices; // vertices of the occluder being setup
+        Util::Array<Triangle> triangles;
+        Util::FixedArray<Util::Array<uint32>> bins; // triangles touching each tile
+        Threading::AtomicCounter setupCounter;
+        Threading::AtomicCounter rasterCounter;
+    };
+
+    /// transform, clip and bin the occluder triangles for an observer, run as a job
+    static void SetupTriangles(const OcclusionSystem* system, DepthBuffer* buffer);
+    /// rasterize all triangles touching a tile, run as a job
+    static void RasterizeTile(const OcclusionSystem* system, DepthBuffer* buffer, IndexT tile);
+    /// remove occluded entities from the visible list of an observer, run as a job
+    static void CullOccludees(const OcclusionSystem* system, const DepthBuffer* buffer, VisibleList* results);
+    /// test if a box is completely hidden
+    static bool IsOccluded(const OcclusionSystem* system, const DepthBuffer* buffer, const Math::bbox& box);
+
+    SizeT width, height;                    // requested size in pixels
+    SizeT tilesX, tilesY;
+    Util::Array<Occluder> occluders;
+    Util::Array<IndexT> freeOccluders;
+    Util::Array<DepthBuffer*> buffers;
+};
+
+} // namespace Visibility
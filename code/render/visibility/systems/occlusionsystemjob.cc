@@ -0,0 +1,331 @@
+//------------------------------------------------------------------------------
+//  occlusionsystemjob.cc
+//  (C) 2024 Individual contributors, see AUTHORS file
+//------------------------------------------------------------------------------
+
+#include "occlusionsystem.h"
+#include <float.h>
+#include <immintrin.h>
+namespace Visibility
+{
+
+//------------------------------------------------------------------------------
+/**
+    Transform to clip space, orthographic observers always have w = 1
+*/
+static inline Math::vec4
+ToClipSpace(const Math::mat4& transform, bool isOrtho, const Math::vec4& p)
+{
+    Math::vec4 clip = transform * p;
+    if (isOrtho)
+        clip.w = 1.0f;
+    return clip;
+}
+
+//------------------------------------------------------------------------------
+/**
+    One bit per side of the frustum the vertex is outside of
+*/
+static inline uint
+OutsideBits(const Math::vec4& v)
+{
+    return (v.x < -v.w ? 1 : 0)
+        | (v.x > v.w ? 2 : 0)
+        | (v.y < -v.w ? 4 : 0)
+        | (v.y > v.w ? 8 : 0)
+        | (v.z < 0.0f ? 16 : 0)
+        | (v.z > v.w ? 32 : 0);
+}
+
+//------------------------------------------------------------------------------
+/**
+    Clip a triangle against the near plane, z >= 0, which gives at most
+    a quad. Returns the number of vertices.
+*/
+static SizeT
+ClipNear(const Math::vec4* triangle, Math::vec4* polygon)
+{
+    SizeT num = 0;
+    IndexT i;
+    for (i = 0; i < 3; i++)
+    {
+        const Math::vec4& a = triangle[i];
+        const Math::vec4& b = triangle[(i + 1) % 3];
+        if (a.z >= 0.0f)
+            polygon[num++] = a;
+        if ((a.z >= 0.0f) != (b.z >= 0.0f))
+            polygon[num++] = Math::lerp(a, b, a.z / (a.z - b.z));
+    }
+    return num;
+}
+
+//------------------------------------------------------------------------------
+/**
+*/
+void
+OcclusionSystem::SetupTriangles(const OcclusionSystem* system, DepthBuffer* buffer)
+{
+    buffer->triangles.Clear();
+    for (Util::Array<uint32>& bin : buffer->bins)
+        bin.Clear();
+
+    const float width = (float)system->width;
+    const float height = (float)system->height;
+    for (const Occluder& occluder : system->occluders)
+    {
+        if (!occluder.active)
+            continue;
+
+        const Math::mat4 transform = buffer->viewProjection * occluder.transform;
+        buffer->clipVertices.Clear();
+        for (const Math::vec4& vertex : occluder.vertices)
+            buffer->clipVertices.Append(ToClipSpace(transform, buffer->isOrtho, vertex));
+
+        IndexT i;
+        for (i = 0; i < occluder.indices.Size(); i += 3)
+        {
+            const Math::vec4 triangle[3] =
+            {
+                buffer->clipVertices[occluder.indices[i]],
+                buffer->clipVertices[occluder.indices[i + 1]],
+                buffer->clipVertices[occluder.indices[i + 2]],
+            };
+
+            // Skip triangles completely outside of one of the planes
+            if ((OutsideBits(triangle[0]) & OutsideBits(triangle[1]) & OutsideBits(triangle[2])) != 0)
+                continue;
+
+            Math::vec4 polygon[4];
+            const SizeT numVertices = ClipNear(triangle, polygon);
+            if (numVertices < 3)
+                continue;
+
+            // Project to pixels, with y pointing down
+            float x[4], y[4], z[4];
+            IndexT j;
+            for (j = 0; j < numVertices; j++)
+            {
+                const float invW = 1.0f / polygon[j].w;
+                x[j] = (polygon[j].x * invW * 0.5f + 0.5f) * width;
+                y[j] = (0.5f - polygon[j].y * invW * 0.5f) * height;
+                z[j] = polygon[j].z * invW;
+            }
+
+            // Setup the edge functions and depth plane of every triangle of the fan
+            for (j = 1; j < numVertices - 1; j++)
+            {
+                const IndexT v[3] = { 0, j, j + 1 };
+                const float area = (x[v[1]] - x[v[0]]) * (y[v[2]] - y[v[0]]) - (x[v[2]] - x[v[0]]) * (y[v[1]] - y[v[0]]);
+                if (Math::abs(area) < 1e-6f)
+                    continue;
+
+                Triangle tri;
+                tri.minX = Math::max(0, (int)Math::floor(Math::min(x[v[0]], Math::min(x[v[1]], x[v[2]]))));
+                tri.minY = Math::max(0, (int)Math::floor(Math::min(y[v[0]], Math::min(y[v[1]], y[v[2]]))));
+                tri.maxX = Math::min((int)system->width, (int)Math::ceil(Math::max(x[v[0]], Math::max(x[v[1]], x[v[2]]))));
+                tri.maxY = Math::min((int)system->height, (int)Math::ceil(Math::max(y[v[0]], Math::max(y[v[1]], y[v[2]]))));
+                if (tri.minX >= tri.maxX || tri.minY >= tri.maxY)
+                    continue;
+
+                // Flip the edges of clockwise triangles so the inside is always positive
+                const float sign = area > 0.0f ? 1.0f : -1.0f;
+                IndexT edge;
+                for (edge = 0; edge < 3; edge++)
+                {
+                    const IndexT p = v[edge], q = v[(edge + 1) % 3];
+                    tri.edgeA[edge] = -(y[q] - y[p]) * sign;
+                    tri.edgeB[edge] = (x[q] - x[p]) * sign;
+                    tri.edgeC[edge] = ((y[q] - y[p]) * x[p] - (x[q] - x[p]) * y[p]) * sign;
+                }
+
+                const float invArea = 1.0f / area;
+                const float dx1 = x[v[1]] - x[v[0]], dy1 = y[v[1]] - y[v[0]], dz1 = z[v[1]] - z[v[0]];
+                const float dx2 = x[v[2]] - x[v[0]], dy2 = y[v[2]] - y[v[0]], dz2 = z[v[2]] - z[v[0]];
+                tri.depthX = (dz1 * dy2 - dz2 * dy1) * invArea;
+                tri.depthY = (dz2 * dx1 - dz1 * dx2) * invArea;
+                tri.depth0 = z[v[0]] - tri.depthX * x[v[0]] - tri.depthY * y[v[0]];
+
+                // Bin to every tile the bounds touch
+                const uint32 index = buffer->triangles.Size();
+                buffer->triangles.Append(tri);
+                IndexT tileX, tileY;
+                for (tileY = tri.minY / TileHeight; tileY <= (tri.maxY - 1) / TileHeight; tileY++)
+                    for (tileX = tri.minX / TileWidth; tileX <= (tri.maxX - 1) / TileWidth; tileX++)
+                        buffer->bins[tileX + tileY * system->tilesX].Append(index);
+            }
+        }
+    }
+}
+
+//------------------------------------------------------------------------------
+/**
+    Keeps the nearest depth of the triangles covering each pixel center,
+    then updates the farthest depth of the tile. Pixels no triangle covers
+    are infinitely far away.
+*/
+void
+OcclusionSystem::RasterizeTile(const OcclusionSystem* system, DepthBuffer* buffer, IndexT tile)
+{
+    const int originX = (tile % system->tilesX) * TileWidth;
+    const int originY = (tile / system->tilesX) * TileHeight;
+    float* depth = buffer->depth.Begin() + tile * TileSize;
+
+    const __m128 zero = _mm_setzero_ps();
+    const __m128 offsets = _mm_setr_ps(0.5f, 1.5f, 2.5f, 3.5f);
+    const __m128 cleared = _mm_set1_ps(FLT_MAX);
+    IndexT i;
+    for (i = 0; i < TileSize; i += 4)
+        _mm_storeu_ps(depth + i, cleared);
+
+    for (uint32 index : buffer->bins[tile])
+    {
+        const Triangle& tri = buffer->triangles[index];
+
+        // Bounds of the triangle in the tile, starting at a whole batch of pixels
+        const int x0 = (Math::max(tri.minX, originX) - originX) & ~3;
+        const int x1 = Math::min(tri.maxX, originX + (int)TileWidth) - originX;
+        const int y0 = Math::max(tri.minY, originY) - originY;
+        const int y1 = Math::min(tri.maxY, originY + (int)TileHeight) - originY;
+
+        const __m128 a0 = _mm_set1_ps(tri.edgeA[0]);
+        const __m128 a1 = _mm_set1_ps(tri.edgeA[1]);
+        const __m128 a2 = _mm_set1_ps(tri.edgeA[2]);
+        const __m128 depthX = _mm_set1_ps(tri.depthX);
+
+        int y;
+        for (y = y0; y < y1; y++)
+        {
+            const float py = originY + y + 0.5f;
+            const __m128 row0 = _mm_set1_ps(tri.edgeB[0] * py + tri.edgeC[0]);
+            const __m128 row1 = _mm_set1_ps(tri.edgeB[1] * py + tri.edgeC[1]);
+            const __m128 row2 = _mm_set1_ps(tri.edgeB[2] * py + tri.edgeC[2]);
+            const __m128 rowDepth = _mm_set1_ps(tri.depthY * py + tri.depth0);
+
+            int x;
+            for (x = x0; x < x1; x += 4)
+            {
+                const __m128 px = _mm_add_ps(_mm_set1_ps((float)(originX + x)), offsets);
+                __m128 inside = _mm_cmpge_ps(_mm_add_ps(_mm_mul_ps(a0, px), row0), zero);
+                inside = _mm_and_ps(inside, _mm_cmpge_ps(_mm_add_ps(_mm_mul_ps(a1, px), row1), zero));
+                inside = _mm_and_ps(inside, _mm_cmpge_ps(_mm_add_ps(_mm_mul_ps(a2, px), row2), zero));
+                if (_mm_movemask_ps(inside) == 0)
+                    continue;
+
+                float* pixels = depth + y * TileWidth + x;
+                const __m128 current = _mm_loadu_ps(pixels);
+                const __m128 nearest = _mm_min_ps(current, _mm_add_ps(_mm_mul_ps(depthX, px), rowDepth));
+                _mm_storeu_ps(pixels, _mm_or_ps(_mm_and_ps(inside, nearest), _mm_andnot_ps(inside, current)));
+            }
+        }
+    }
+
+    __m128 farthest = _mm_loadu_ps(depth);
+    for (i = 4; i < TileSize; i += 4)
+        farthest = _mm_max_ps(farthest, _mm_loadu_ps(depth + i));
+    farthest = _mm_max_ps(farthest, _mm_shuffle_ps(farthest, farthest, _MM_SHUFFLE(1, 0, 3, 2)));
+    farthest = _mm_max_ps(farthest, _mm_shuffle_ps(farthest, farthest, _MM_SHUFFLE(2, 3, 0, 1)));
+    buffer->tileMaxDepth[tile] = _mm_cvtss_f32(farthest);
+}
+
+//------------------------------------------------------------------------------
+/**
+    Compacts the visible list in place, keeping only what isn't occluded
+*/
+void
+OcclusionSystem::CullOccludees(const OcclusionSystem* system, const DepthBuffer* buffer, VisibleList* results)
+{
+    if (buffer->triangles.IsEmpty())
+        return;
+
+    const uint32* ids = system->ent.ids;
+    const Math::bbox* boxes = system->ent.boxes;
+    const uint32_t* flags = system->ent.entityFlags;
+    uint32* indices = results->indices.Begin();
+    const SizeT count = results->count;
+    SizeT numVisible = 0;
+    IndexT i;
+    for (i = 0; i < count; i++)
+    {
+        const uint32 objectId = ids[indices[i]];
+        if (AllBits(flags[objectId], (uint32_t)Models::NodeInstanceFlags::NodeInstance_AlwaysVisible)
+            || !OcclusionSystem::IsOccluded(system, buffer, boxes[objectId]))
+            indices[numVisible++] = indices[i];
+    }
+    results->count = numVisible;
+}
+
+//------------------------------------------------------------------------------
+/**
+    The box is projected to a rectangle at its nearest depth, and is occluded
+    if every pixel in the rectangle is nearer than that. Tiles which are nearer
+    everywhere are skipped without looking at their pixels.
+*/
+bool
+OcclusionSystem::IsOccluded(const OcclusionSystem* system, const DepthBuffer* buffer, const Math::bbox& box)
+{
+    float minX = FLT_MAX, minY = FLT_MAX, maxX = -FLT_MAX, maxY = -FLT_MAX;
+    float nearest = FLT_MAX;
+    IndexT i;
+    for (i = 0; i < 8; i++)
+    {
+        const Math::vec4 clip = ToClipSpace(buffer->viewProjection, buffer->isOrtho, box.corner_point(i));
+        if (clip.z < 0.0f || clip.w <= 0.0f)
+            return false;
+
+        const float invW = 1.0f / clip.w;
+        const float x = (clip.x * invW * 0.5f + 0.5f) * system->width;
+        const float y = (0.5f - clip.y * invW * 0.5f) * system->height;
+        minX = Math::min(minX, x);
+        minY = Math::min(minY, y);
+        maxX = Math::max(maxX, x);
+        maxY = Math::max(maxY, y);
+        nearest = Math::min(nearest, clip.z * invW);
+    }
+
+    const int x0 = Math::max(0, (int)Math::floor(minX));
+    const int y0 = Math::max(0, (int)Math::floor(minY));
+    const int x1 = Math::min((int)system->width, (int)Math::ceil(maxX));
+    const int y1 = Math::min((int)system->height, (int)Math::ceil(maxY));
+    if (x0 >= x1 || y0 >= y1)
+        return false;
+
+    const __m128 nearestDepth = _mm_set1_ps(nearest);
+    int tileX, tileY;
+    for (tileY = y0 / TileHeight; tileY <= (y1 - 1) / TileHeight; tileY++)
+    {
+        for (tileX = x0 / TileWidth; tileX <= (x1 - 1) / TileWidth; tileX++)
+        {
+            const IndexT tile = tileX + tileY * system->tilesX;
+            if (buffer->tileMaxDepth[tile] < nearest)
+                continue;
+
+            // Rectangle in the tile
+            const int originX = tileX * TileWidth;
+            const int originY = tileY * TileHeight;
+            const int rectX0 = Math::max(x0, originX) - originX;
+            const int rectX1 = Math::min(x1, originX + (int)TileWidth) - originX;
+            const int rectY0 = Math::max(y0, originY) - originY;
+            const int rectY1 = Math::min(y1, originY + (int)TileHeight) - originY;
+            const float* depth = buffer->depth.Begin() + tile * TileSize;
+
+            int x, y;
+            for (y = rectY0; y < rectY1; y++)
+            {
+                for (x = rectX0 & ~3; x < rectX1; x += 4)
+                {
+                    uint lanes = 0xF;
+                    if (x < rectX0)
+                        lanes &= 0xF << (rectX0 - x);
+                    if (x + 4 > rectX1)
+                        lanes &= 0xF >> (x + 4 - rectX1);
+                    const __m128 behind = _mm_cmpge_ps(_mm_loadu_ps(depth + y * TileWidth + x), nearestDepth);
+                    if ((_mm_movemask_ps(behind) & lanes) != 0)
+                        return false;
+                }
+            }
+        }
+    }
+    return true;
+}
+
+} // namespace Visibility
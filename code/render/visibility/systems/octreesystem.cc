@@ -4,15 +4,352 @@
 //------------------------------------------------------------------------------
 
 #include "octreesystem.h"
+#include "jobs2/jobs2.h"
+#include "math/mat4.h"
+#include "math/clipstatus.h"
 namespace Visibility
 {
 
+//------------------------------------------------------------------------------
+/**
+*/
+OctreeSystem::OctreeSystem()
+    : worldExpanding(true)
+    , maxDepth(DefaultDepth)
+    , frame(0)
+    , numOutside(0)
+    , updateCounter(0)
+{
+    this->Rebuild(Math::bbox());
+}
+
+//------------------------------------------------------------------------------
+/**
+*/
+OctreeSystem::~OctreeSystem()
+{
+    // empty
+}
+
 //------------------------------------------------------------------------------
 /**
 */
 void
 OctreeSystem::Setup(const OctreeSystemLoadInfo& info)
 {
+    this->worldExpanding = info.worldExpanding;
+    if (!this->worldExpanding)
+    {
+        // subdivide until the smallest cells are as many as requested along the longest axis
+        uint cells = Math::max(info.cellsX, Math::max(info.cellsY, info.cellsZ));
+        this->maxDepth = 1;
+        while ((1u << this->maxDepth) < cells && this->maxDepth < MaxDepth)
+            this->maxDepth++;
+
+        Math::vector extents(info.width * 0.5f, info.height * 0.5f, info.depth * 0.5f);
+        this->Rebuild(Math::bbox(Math::point(info.pos.x, info.pos.y, info.pos.z), extents));
+    }
+}
+
+//------------------------------------------------------------------------------
+/**
+*/
+void
+OctreeSystem::Run(const Threading::AtomicCounter* previousSystemCompletionCounters, const Util::FixedArray<const Threading::AtomicCounter*, true>& extraCounters)
+{
+    // Update the tree once the bounding boxes are ready
+    n_assert(this->updateCounter == 0);
+    this->updateCounter = 1;
+    Jobs2::JobDispatch(
+        [system = this]
+    (SizeT totalJobs, SizeT groupSize, IndexT groupIndex, SizeT invocationOffset)
+    {
+        system->Update();
+    }
+    , 1
+    , extraCounters
+    , { &this->updateCounter }
+    , nullptr);
+
+    IndexT i;
+    for (i = 0; i < this->obs.count; i++)
+    {
+        n_assert(this->obs.completionCounters[i] == 0);
+        this->obs.completionCounters[i] = 1;
+
+        // Setup counters
+        Util::FixedArray<const Threading::AtomicCounter*, true> counters(previousSystemCompletionCounters == nullptr ? 1 : 2);
+        counters[0] = &this->updateCounter;
+        if (previousSystemCompletionCounters != nullptr)
+            counters[1] = &previousSystemCompletionCounters[i];
+
+        FrustumPlanes planes;
+        FrustumPlanesSetup(planes, this->obs.transforms[i], this->obs.isOrtho[i]);
+
+        // One job for the objects outside of the tree and in the root, and one per octant of the root
+        Jobs2::JobDispatch(
+            [
+                system = this
+                , planes
+                , results = &this->obs.results[i]
+            ]
+        (SizeT totalJobs, SizeT groupSize, IndexT groupIndex, SizeT invocationOffset)
+        {
+            N_SCOPE(OctreeViewFrustumCulling, Visibility);
+            for (IndexT i = 0; i < groupSize; i++)
+            {
+                IndexT index = i + invocationOffset;
+                if (index >= totalJobs)
+                    return;
+
+                if (index == 0)
+                {
+                    OctreeSystem::Cull(system, UnboundedNode, false, planes, results);
+                    OctreeSystem::Cull(system, RootNode, false, planes, results);
+                }
+                else
+                {
+                    const uint32 firstChild = system->nodes[RootNode].firstChild;
+                    if (firstChild != InvalidNode)
+                        OctreeSystem::Cull(system, firstChild + index - 1, true, planes, results);
+                }
+            }
+        }
+        , 9
+        , 1
+        , counters
+        , { &this->obs.completionCounters[i] }
+        , nullptr);
+    }
+}
+
+//------------------------------------------------------------------------------
+/**
+    Applies the changes of this frame to the tree. Objects which haven't
+    changed their bounding box are left alone.
+*/
+void
+OctreeSystem::Update()
+{
+    N_SCOPE(OctreeUpdate, Visibility);
+    this->frame++;
+
+    // Make room for new objects
+    uint32 numObjects = 0;
+    IndexT i;
+    for (i = 0; i < this->ent.count; i++)
+        numObjects = Math::max(numObjects, this->ent.ids[i] + 1);
+    if ((uint32)this->objects.Size() < numObjects)
+    {
+        SizeT oldSize = this->objects.Size();
+        this->objects.Resize(numObjects);
+        this->slots.Resize(numObjects);
+        for (i = oldSize; i < this->objects.Size(); i++)
+        {
+            this->objects[i].node = InvalidNode;
+            this->objects[i].frame = 0;
+            this->objects[i].alwaysVisible = false;
+        }
+    }
+
+    // Fit a world expanding tree around the objects when it's empty, or when too many objects have left it
+    if (this->worldExpanding && (this->numOutside > RebuildThreshold || this->nodes[RootNode].numObjects == 0))
+    {
+        Math::bbox bounds;
+        bounds.begin_extend();
+        bool hasBounds = false;
+        for (i = 0; i < this->ent.count; i++)
+        {
+            const uint32 id = this->ent.ids[i];
+            if (AllBits(this->ent.entityFlags[id], (uint32_t)Models::NodeInstanceFlags::NodeInstance_AlwaysVisible))
+                continue;
+            bounds.extend(this->ent.boxes[id]);
+            hasBounds = true;
+        }
+
+        if (hasBounds)
+        {
+            // leave some room for objects to move
+            Math::vector extents = bounds.extents() * 1.25f + Math::vector(1.0f);
+            this->Rebuild(Math::bbox(bounds.center(), extents));
+        }
+    }
+
+    for (i = 0; i < this->ent.count; i++)
+    {
+        const uint32 id = this->ent.ids[i];
+        const Math::bbox& box = this->ent.boxes[id];
+        const bool alwaysVisible = AllBits(this->ent.entityFlags[id], (uint32_t)Models::NodeInstanceFlags::NodeInstance_AlwaysVisible);
+        this->slots[id] = i;
+
+        Object& object = this->objects[id];
+        object.frame = this->frame;
+        if (object.node != InvalidNode
+            && object.alwaysVisible == alwaysVisible
+            && object.box.pmin == box.pmin
+            && object.box.pmax == box.pmax)
+            continue;
+
+        // Objects only change node when they leave their cell, or their size changes enough
+        const uint32 node = alwaysVisible ? UnboundedNode : this->Locate(box);
+        if (node != object.node || alwaysVisible != object.alwaysVisible)
+        {
+            if (object.node != InvalidNode)
+                this->Remove(id);
+            object.alwaysVisible = alwaysVisible;
+            this->Insert(id, node);
+        }
+        object.box = box;
+    }
+
+    // Remove objects which are gone
+    for (i = 0; i < this->objects.Size(); i++)
+    {
+        if (this->objects[i].node != InvalidNode && this->objects[i].frame != this->frame)
+            this->Remove(i);
+    }
+}
+
+//------------------------------------------------------------------------------
+/**
+*/
+void
+OctreeSystem::Rebuild(const Math::bbox& bounds)
+{
+    this->nodes.Clear();
+
+    Node unbounded;
+    unbounded.parent = InvalidNode;
+    unbounded.firstChild = InvalidNode;
+    unbounded.depth = 0;
+    unbounded.numObjects = 0;
+    this->nodes.Append(unbounded);
+
+    Node root;
+    root.cell = bounds;
+    root.box = Math::bbox(bounds.center(), bounds.extents() * 2.0f);
+    root.parent = InvalidNode;
+    root.firstChild = InvalidNode;
+    root.depth = 0;
+    root.numObjects = 0;
+    this->nodes.Append(root);
+
+    IndexT i;
+    for (i = 0; i < this->objects.Size(); i++)
+        this->objects[i].node = InvalidNode;
+    this->numOutside = 0;
+}
+
+//------------------------------------------------------------------------------
+/**
+*/
+void
+OctreeSystem::Split(uint32 node)
+{
+    n_assert(this->nodes[node].firstChild == InvalidNode);
+    const Math::bbox cell = this->nodes[node].cell;
+    const Math::point mid = cell.center();
+    const uint32 depth = this->nodes[node].depth + 1;
+    const uint32 firstChild = this->nodes.Size();
+
+    uint32 octant;
+    for (octant = 0; octant < 8; octant++)
+    {
+        Node child;
+        child.cell.pmin = Math::point(
+            octant & 1 ? mid.x : cell.pmin.x,
+            octant & 2 ? mid.y : cell.pmin.y,
+            octant & 4 ? mid.z : cell.pmin.z);
+        child.cell.pmax = Math::point(
+            octant & 1 ? cell.pmax.x : mid.x,
+            octant & 2 ? cell.pmax.y : mid.y,
+            octant & 4 ? cell.pmax.z : mid.z);
+        child.box = Math::bbox(child.cell.center(), child.cell.extents() * 2.0f);
+        child.parent = node;
+        child.firstChild = InvalidNode;
+        child.depth = depth;
+        child.numObjects = 0;
+        this->nodes.Append(child);
+    }
+    this->nodes[node].firstChild = firstChild;
+}
+
+//------------------------------------------------------------------------------
+/**
+    An object fits in a cell if its center is inside the cell and it's no
+    larger than the cell, the loose bounds of the cell then contain it.
+*/
+uint32
+OctreeSystem::Locate(const Math::bbox& box)
+{
+    const Math::point center = box.center();
+    const Math::vector size = box.size();
+    const Math::bbox& root = this->nodes[RootNode].cell;
+    if (center.x < root.pmin.x || center.y < root.pmin.y || center.z < root.pmin.z
+        || center.x > root.pmax.x || center.y > root.pmax.y || center.z > root.pmax.z)
+        return UnboundedNode;
+
+    const Math::vector rootSize = root.size();
+    if (size.x > rootSize.x || size.y > rootSize.y || size.z > rootSize.z)
+        return UnboundedNode;
+
+    // Go down as long as the object fits in the child cells
+    uint32 node = RootNode;
+    while (this->nodes[node].depth < this->maxDepth)
+    {
+        const Math::bbox cell = this->nodes[node].cell;
+        const Math::vector half = cell.extents();
+        if (size.x > half.x || size.y > half.y || size.z > half.z)
+            break;
+
+        const Math::point mid = cell.center();
+        const uint32 octant = (center.x >= mid.x ? 1 : 0) | (center.y >= mid.y ? 2 : 0) | (center.z >= mid.z ? 4 : 0);
+        if (this->nodes[node].firstChild == InvalidNode)
+            this->Split(node);
+        node = this->nodes[node].firstChild + octant;
+    }
+    return node;
+}
+
+//------------------------------------------------------------------------------
+/**
+*/
+void
+OctreeSystem::Insert(uint32 object, uint32 node)
+{
+    Object& obj = this->objects[object];
+    obj.node = node;
+    obj.slot = this->nodes[node].objects.Size();
+    this->nodes[node].objects.Append(object);
+    if (node == UnboundedNode && !obj.alwaysVisible)
+        this->numOutside++;
+
+    uint32 n;
+    for (n = node; n != InvalidNode; n = this->nodes[n].parent)
+        this->nodes[n].numObjects++;
+}
+
+//------------------------------------------------------------------------------
+/**
+*/
+void
+OctreeSystem::Remove(uint32 object)
+{
+    Object& obj = this->objects[object];
+    n_assert(obj.node != InvalidNode);
+    Node& node = this->nodes[obj.node];
+
+    // Move the last object of the node into the free slot
+    node.objects.EraseIndexSwap(obj.slot);
+    if (obj.slot < (uint32)node.objects.Size())
+        this->objects[node.objects[obj.slot]].slot = obj.slot;
+    if (obj.node == UnboundedNode && !obj.alwaysVisible)
+        this->numOutside--;
+
+    uint32 n;
+    for (n = obj.node; n != InvalidNode; n = this->nodes[n].parent)
+        this->nodes[n].numObjects--;
+    obj.node = InvalidNode;
 }
 
 } // namespace Visibility
@@ -3,11 +3,24 @@
 /**
     Octree system
 
+    Loose octree over the bounding boxes of all node instances. Each cell
+    tests against a box twice its size, so an object is stored in the deepest
+    cell its center is in and its size fits, and never needs to be split across
+    cells. Objects which don't fit in the tree, and objects which are always
+    visible, are kept in a separate list which is tested without the tree.
+
+    The tree is updated incrementally once per frame. Objects are inserted when
+    they first show up, moved when their bounding box leaves their cell and
+    removed when they are gone. Then one job per octant of the root is run for
+    each observer, which rejects whole subtrees outside the observer, and marks
+    whole subtrees inside of it as inside without testing their objects.
+
     @copyright
     (C) 2018-2020 Individual contributors, see AUTHORS file
 */
 //------------------------------------------------------------------------------
 #include "visibilitysystem.h"
+#include "frustumculling.h"
 #include "jobs/jobs.h"
 namespace Visibility
 {
@@ -15,12 +28,76 @@ namespace Visibility
 class OctreeSystem : public VisibilitySystem
 {
 public:
+    /// constructor
+    OctreeSystem();
+    /// destructor
+    virtual ~OctreeSystem();
+
+    /// run system
+    void Run(const Threading::AtomicCounter* previousSystemCompletionCounters, const Util::FixedArray<const Threading::AtomicCounter*, true>& extraCounters) override;
+
 private:
     friend class ObserverContext;
 
     /// setup from load info
     void Setup(const OctreeSystemLoadInfo& info);
+
+    struct Node
+    {
+        Math::bbox cell;                // bounds of the cell
+        Math::bbox box;                 // loose bounds, the cell grown by half its size on all sides
+        uint32 parent;
+        uint32 firstChild;              // first of 8 consecutive children, InvalidNode if none
+        uint32 depth;
+        uint32 numObjects;              // number of objects in this node and all below it
+        Util::Array<uint32> objects;
+    };
+
+    struct Object
+    {
+        Math::bbox box;                 // box the object was placed with
+        uint32 node;                    // node the object is in, InvalidNode if not in the tree
+        uint32 slot;                    // index in the object list of the node
+        uint32 frame;                   // last update the object was part of
+        bool alwaysVisible;
+    };
+
+    static const uint32 InvalidNode = 0xFFFFFFFF;
+    /// node of objects which are tested without the tree
+    static const uint32 UnboundedNode = 0;
+    static const uint32 RootNode = 1;
+    /// deepest level of the tree
+    static const uint32 MaxDepth = 10;
+    /// depth of a world expanding tree
+    static const uint32 DefaultDepth = 8;
+    /// a world expanding tree is rebuilt once this many objects are outside of it
+    static const SizeT RebuildThreshold = 256;
+
+    /// update the tree with the entities of this frame, run as a job
+    void Update();
+    /// reset the tree to new bounds, all objects have to be inserted again
+    void Rebuild(const Math::bbox& bounds);
+    /// create the 8 children of a node
+    void Split(uint32 node);
+    /// find the node an object belongs in, creates nodes as needed
+    uint32 Locate(const Math::bbox& box);
+    /// insert object in node
+    void Insert(uint32 object, uint32 node);
+    /// remove object from its node
+    void Remove(uint32 object);
+
+    /// cull the objects of a node, and the nodes below it if subtree is set
+    static void Cull(const OctreeSystem* system, uint32 node, bool subtree, const FrustumPlanes& planes, VisibleList* results);
+
+    bool worldExpanding;
+    uint32 maxDepth;
+    uint32 frame;
+    SizeT numOutside;
+    Util::Array<Node> nodes;
+    Util::Array<Object> objects;
+    /// index of every object in the entity list of this frame
+    Util::Array<uint32> slots;
+    Threading::AtomicCounter updateCounter;
 };
 
 } // namespace Visibility
-
@@ -4,7 +4,74 @@
 //------------------------------------------------------------------------------
 
 #include "octreesystem.h"
+#include "math/clipstatus.h"
 namespace Visibility
 {
 
+//------------------------------------------------------------------------------
+/**
+    Walks the tree depth first. Nodes below a node which is completely inside
+    are pushed with the inside bit set, and their objects are marked as
+    visible without being tested.
+*/
+void
+OctreeSystem::Cull(const OctreeSystem* system, uint32 node, bool subtree, const FrustumPlanes& planes, VisibleList* results)
+{
+    const Util::Array<Node>& nodes = system->nodes;
+    const Math::bbox* boxes = system->ent.boxes;
+    const uint32* slots = system->slots.ConstBegin();
+    VisibleBuffer visible(results);
+
+    // Objects outside of the tree have nothing to be culled with
+    if (node == UnboundedNode)
+    {
+        for (uint32 object : nodes[UnboundedNode].objects)
+        {
+            if (system->objects[object].alwaysVisible || FrustumClip(planes, boxes[object]) != Math::ClipStatus::Outside)
+                visible.Add(slots[object]);
+        }
+        return;
+    }
+
+    static const uint32 InsideBit = 0x80000000;
+    uint32 stack[8 * MaxDepth + 1];
+    SizeT top = 0;
+    stack[top++] = node;
+    while (top > 0)
+    {
+        const uint32 entry = stack[--top];
+        const Node& current = nodes[entry & ~InsideBit];
+        if (current.numObjects == 0)
+            continue;
+
+        Math::ClipStatus::Type status = Math::ClipStatus::Inside;
+        if ((entry & InsideBit) == 0)
+            status = FrustumClip(planes, current.box);
+        if (status == Math::ClipStatus::Outside)
+            continue;
+
+        if (status == Math::ClipStatus::Inside)
+        {
+            for (uint32 object : current.objects)
+                visible.Add(slots[object]);
+        }
+        else
+        {
+            for (uint32 object : current.objects)
+            {
+                if (FrustumClip(planes, boxes[object]) != Math::ClipStatus::Outside)
+                    visible.Add(slots[object]);
+            }
+        }
+
+        if (subtree && current.firstChild != InvalidNode)
+        {
+            const uint32 inside = status == Math::ClipStatus::Inside ? InsideBit : 0;
+            uint32 child;
+            for (child = 0; child < 8; child++)
+                stack[top++] = (current.firstChild + child) | inside;
+        }
+    }
+}
+
 } // namespace Visibility
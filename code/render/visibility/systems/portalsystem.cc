@@ -4,15 +4,389 @@
 //------------------------------------------------------------------------------
 
 #include "portalsystem.h"
+#include "jobs2/jobs2.h"
+#include "io/ioserver.h"
+#include "io/jsonreader.h"
 namespace Visibility
 {
 
+//------------------------------------------------------------------------------
+/**
+*/
+PortalSystem::PortalSystem()
+    : frame(0)
+    , relocate(false)
+    , updateCounter(0)
+{
+    // the outside and always visible cells have no bounds
+    this->cells.Resize(FirstCell);
+}
+
+//------------------------------------------------------------------------------
+/**
+*/
+PortalSystem::~PortalSystem()
+{
+    // empty
+}
+
 //------------------------------------------------------------------------------
 /**
 */
 void
-PortalSystem::Setup(const PortalSystemLoadInfo & info)
+PortalSystem::Setup(const PortalSystemLoadInfo& info)
 {
+    if (info.path.IsValid())
+    {
+        if (!this->Load(info.path.Value()))
+            n_warning("PortalSystem: failed to load '%s'\n", info.path.Value());
+    }
+}
+
+//------------------------------------------------------------------------------
+/**
+*/
+uint32
+PortalSystem::AddCell(const Math::bbox& box)
+{
+    Cell cell;
+    cell.box = box;
+    this->cells.Append(cell);
+    this->relocate = true;
+    return this->cells.Size() - 1;
+}
+
+//------------------------------------------------------------------------------
+/**
+*/
+void
+PortalSystem::AddPortal(uint32 cell0, uint32 cell1, const Math::vec3* vertices, SizeT numVertices)
+{
+    n_assert(cell0 != AlwaysVisibleCell && cell0 < (uint32)this->cells.Size());
+    n_assert(cell1 != AlwaysVisibleCell && cell1 < (uint32)this->cells.Size());
+    n_assert(cell0 != cell1);
+    n_assert(numVertices >= 3);
+
+    Portal portal;
+    portal.cells[0] = cell0;
+    portal.cells[1] = cell1;
+    IndexT i;
+    for (i = 0; i < numVertices; i++)
+        portal.vertices.Append(Math::vec4(vertices[i], 1.0f));
+
+    const uint32 index = this->portals.Size();
+    this->portals.Append(portal);
+    this->cells[cell0].portals.Append(index);
+    this->cells[cell1].portals.Append(index);
+}
+
+//------------------------------------------------------------------------------
+/**
+*/
+bool
+PortalSystem::Load(const IO::URI& path)
+{
+    Ptr<IO::JsonReader> reader = IO::JsonReader::Create();
+    reader->SetStream(IO::IoServer::Instance()->CreateStream(path));
+    if (!reader->Open())
+        return false;
+
+    const uint32 firstCell = this->cells.Size();
+    reader->SetToRoot();
+    if (reader->SetToFirstChild("cells"))
+    {
+        if (reader->SetToFirstChild())
+        {
+            do
+            {
+                Math::bbox box;
+                box.pmin = reader->GetVec3("min");
+                box.pmax = reader->GetVec3("max");
+                this->AddCell(box);
+            } while (reader->SetToNextChild());
+        }
+        reader->SetToParent();
+    }
+
+    bool valid = true;
+    if (reader->SetToFirstChild("portals"))
+    {
+        if (reader->SetToFirstChild())
+        {
+            do
+            {
+                Util::Array<int> cells;
+                reader->Get(cells, "cells");
+                if (cells.Size() != 2)
+                {
+                    valid = false;
+                    continue;
+                }
+
+                uint32 portalCells[2];
+                IndexT i;
+                for (i = 0; i < 2; i++)
+                {
+                    portalCells[i] = cells[i] < 0 ? OutsideCell : firstCell + cells[i];
+                    valid &= portalCells[i] < (uint32)this->cells.Size();
+                }
+
+                Util::Array<Math::vec3> vertices;
+                if (reader->SetToFirstChild("vertices"))
+                {
+                    if (reader->SetToFirstChild())
+                    {
+                        do
+                        {
+                            vertices.Append(reader->GetVec3());
+                        } while (reader->SetToNextChild());
+                    }
+                    reader->SetToParent();
+                }
+
+                if (valid && vertices.Size() >= 3 && portalCells[0] != portalCells[1])
+                    this->AddPortal(portalCells[0], portalCells[1], vertices.Begin(), vertices.Size());
+                else
+                    valid = false;
+            } while (reader->SetToNextChild());
+        }
+        reader->SetToParent();
+    }
+
+    reader->Close();
+    return valid;
+}
+
+//------------------------------------------------------------------------------
+/**
+*/
+void
+PortalSystem::Run(const Threading::AtomicCounter* previousSystemCompletionCounters, const Util::FixedArray<const Threading::AtomicCounter*, true>& extraCounters)
+{
+    // Scratch for the graph walk of each observer, the rectangles start out empty
+    const SizeT numCells = this->cells.Size();
+    if (this->rects.Size() != numCells * this->obs.count)
+    {
+        this->rects.Resize(numCells * this->obs.count);
+        this->rects.Fill(0, this->rects.Size(), Rect{ 1.0f, 1.0f, -1.0f, -1.0f });
+        this->visited.Resize(numCells * this->obs.count);
+    }
+
+    // Update the cells once the bounding boxes are ready
+    n_assert(this->updateCounter == 0);
+    this->updateCounter = 1;
+    Jobs2::JobDispatch(
+        [system = this]
+    (SizeT totalJobs, SizeT groupSize, IndexT groupIndex, SizeT invocationOffset)
+    {
+        system->Update();
+    }
+    , 1
+    , extraCounters
+    , { &this->updateCounter }
+    , nullptr);
+
+    IndexT i;
+    for (i = 0; i < this->obs.count; i++)
+    {
+        n_assert(this->obs.completionCounters[i] == 0);
+        this->obs.completionCounters[i] = 1;
+
+        // Setup counters
+        Util::FixedArray<const Threading::AtomicCounter*, true> counters(previousSystemCompletionCounters == nullptr ? 1 : 2);
+        counters[0] = &this->updateCounter;
+        if (previousSystemCompletionCounters != nullptr)
+            counters[1] = &previousSystemCompletionCounters[i];
+
+        Jobs2::JobDispatch(
+            [
+                system = this
+                , transform = &this->obs.transforms[i]
+                , isOrtho = this->obs.isOrtho[i]
+                , rects = this->rects.Begin() + i * numCells
+                , visited = this->visited.Begin() + i * numCells
+                , observer = i
+                , results = &this->obs.results[i]
+            ]
+        (SizeT totalJobs, SizeT groupSize, IndexT groupIndex, SizeT invocationOffset)
+        {
+            N_SCOPE(PortalVisibility, Visibility);
+
+            // The objects are only known once the update has run
+            uint32* added = system->added.Begin() + observer * system->objects.Size();
+            PortalSystem::Cull(system, *transform, isOrtho, rects, visited, added, results);
+        }
+        , 1
+        , counters
+        , { &this->obs.completionCounters[i] }
+        , nullptr);
+    }
+}
+
+//------------------------------------------------------------------------------
+/**
+    Applies the changes of this frame to the cells. Objects which haven't
+    changed their bounding box are left alone, unless cells were added.
+*/
+void
+PortalSystem::Update()
+{
+    N_SCOPE(PortalUpdate, Visibility);
+    this->frame++;
+
+    // Make room for new objects
+    uint32 numObjects = 0;
+    IndexT i;
+    for (i = 0; i < this->ent.count; i++)
+        numObjects = Math::max(numObjects, this->ent.ids[i] + 1);
+    if ((uint32)this->objects.Size() < numObjects)
+    {
+        SizeT oldSize = this->objects.Size();
+        this->objects.Resize(numObjects);
+        this->slots.Resize(numObjects);
+        for (i = oldSize; i < this->objects.Size(); i++)
+        {
+            this->objects[i].frame = 0;
+            this->objects[i].alwaysVisible = false;
+        }
+    }
+    if (this->added.Size() != this->objects.Size() * this->obs.count)
+    {
+        // Frames start at one, so nothing counts as added yet
+        this->added.Resize(this->objects.Size() * this->obs.count);
+        this->added.Fill(0, this->added.Size(), 0);
+    }
+
+    Util::Array<uint32, 8> cells;
+    for (i = 0; i < this->ent.count; i++)
+    {
+        const uint32 id = this->ent.ids[i];
+        const Math::bbox& box = this->ent.boxes[id];
+        const bool alwaysVisible = AllBits(this->ent.entityFlags[id], (uint32_t)Models::NodeInstanceFlags::NodeInstance_AlwaysVisible);
+        this->slots[id] = i;
+
+        Object& object = this->objects[id];
+        object.frame = this->frame;
+        if (!this->relocate
+            && !object.placements.IsEmpty()
+            && object.alwaysVisible == alwaysVisible
+            && object.box.pmin == box.pmin
+            && object.box.pmax == box.pmax)
+            continue;
+
+        cells.Clear();
+        if (alwaysVisible)
+            cells.Append(AlwaysVisibleCell);
+        else
+            this->Locate(box, cells);
+
+        bool moved = cells.Size() != object.placements.Size();
+        IndexT j;
+        for (j = 0; j < cells.Size() && !moved; j++)
+            moved = cells[j] != object.placements[j].cell;
+        if (moved)
+        {
+            this->Remove(id);
+            for (j = 0; j < cells.Size(); j++)
+                this->Insert(id, cells[j]);
+        }
+        object.alwaysVisible = alwaysVisible;
+        object.box = box;
+    }
+    this->relocate = false;
+
+    // Remove objects which are gone
+    for (i = 0; i < this->objects.Size(); i++)
+    {
+        if (!this->objects[i].placements.IsEmpty() && this->objects[i].frame != this->frame)
+            this->Remove(i);
+    }
+}
+
+//------------------------------------------------------------------------------
+/**
+    Cells may overlap, the first one containing the point wins
+*/
+uint32
+PortalSystem::Locate(const Math::point& point) const
+{
+    uint32 cell;
+    for (cell = FirstCell; cell < (uint32)this->cells.Size(); cell++)
+    {
+        if (this->cells[cell].box.contains(Math::xyz(point)))
+            return cell;
+    }
+    return OutsideCell;
+}
+
+//------------------------------------------------------------------------------
+/**
+    A box is in every cell it overlaps, so it is tested whichever of them is
+    seen. It is in the outside cell as well if none of those cells contains
+    one of its corners, which is conservative for boxes spanning several cells.
+*/
+void
+PortalSystem::Locate(const Math::bbox& box, Util::Array<uint32, 8>& cells) const
+{
+    uint32 cell;
+    for (cell = FirstCell; cell < (uint32)this->cells.Size(); cell++)
+    {
+        if (this->cells[cell].box.intersects(box))
+            cells.Append(cell);
+    }
+
+    bool outside = cells.IsEmpty();
+    int corner;
+    for (corner = 0; corner < 8 && !outside; corner++)
+    {
+        const Math::point point = box.corner_point(corner);
+        bool inside = false;
+        IndexT i;
+        for (i = 0; i < cells.Size() && !inside; i++)
+            inside = this->cells[cells[i]].box.contains(Math::xyz(point));
+        outside = !inside;
+    }
+    if (outside)
+        cells.Append(OutsideCell);
+}
+
+//------------------------------------------------------------------------------
+/**
+*/
+void
+PortalSystem::Insert(uint32 object, uint32 cell)
+{
+    Object& obj = this->objects[object];
+    obj.placements.Append({ cell, (uint32)this->cells[cell].objects.Size() });
+    this->cells[cell].objects.Append(object);
+}
+
+//------------------------------------------------------------------------------
+/**
+*/
+void
+PortalSystem::Remove(uint32 object)
+{
+    Object& obj = this->objects[object];
+    for (const Placement& placement : obj.placements)
+    {
+        Cell& cell = this->cells[placement.cell];
+
+        // Move the last object of the cell into the free slot
+        cell.objects.EraseIndexSwap(placement.slot);
+        if (placement.slot < (uint32)cell.objects.Size())
+        {
+            for (Placement& other : this->objects[cell.objects[placement.slot]].placements)
+            {
+                if (other.cell == placement.cell)
+                {
+                    other.slot = placement.slot;
+                    break;
+                }
+            }
+        }
+    }
+    obj.placements.Clear();
 }
 
 } // namespace Visibility
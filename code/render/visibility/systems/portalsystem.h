@@ -3,22 +3,139 @@
 /**
     Portal system
 
+    Interiors are authored as cells, which are boxes, connected by portals,
+    which are convex polygons like doors and windows. Everything not inside
+    any cell is in the outside cell, which portals can lead to as well.
+
+    Every object is kept in all cells its box overlaps, and in the outside
+    cell too if part of it may be outside of them, updated incrementally once
+    per frame. For each observer the graph is walked starting from the
+    cell the observer is in. Every portal seen is projected to the screen and
+    its rectangle intersected with the rectangle it's seen through, and the
+    cell behind it is visited with what's left. Only the objects of visited
+    cells are tested, against the frustum narrowed to the rectangles their
+    cell was seen through, so hidden rooms cost nothing. Objects in more than
+    one visited cell are only added once.
+
+    Portals crossing the near plane don't narrow the frustum, since the
+    observer is standing in them.
+
+    The file format is json, with portals referring to cells by their index
+    in the file, and to the outside cell with -1:
+
+        {
+            "cells": [ { "min": [x, y, z], "max": [x, y, z] }, ... ],
+            "portals": [ { "cells": [0, -1], "vertices": [ [x, y, z], ... ] }, ... ]
+        }
+
     @copyright
     (C) 2018-2020 Individual contributors, see AUTHORS file
 */
 //------------------------------------------------------------------------------
 #include "visibilitysystem.h"
-#include "jobs/jobs.h"
+#include "frustumculling.h"
+#include "io/uri.h"
 namespace Visibility
 {
-    
+
 class PortalSystem : public VisibilitySystem
 {
 public:
+    /// constructor
+    PortalSystem();
+    /// destructor
+    virtual ~PortalSystem();
+
+    /// the cell of everything outside of the authored cells
+    static constexpr uint32 OutsideCell = 0;
+
+    /// add a cell, returns its index
+    uint32 AddCell(const Math::bbox& box);
+    /// add a portal between two cells, the vertices form a convex polygon
+    void AddPortal(uint32 cell0, uint32 cell1, const Math::vec3* vertices, SizeT numVertices);
+    /// load cells and portals from a file, added to the ones already there
+    bool Load(const IO::URI& path);
+
+    /// run system
+    void Run(const Threading::AtomicCounter* previousSystemCompletionCounters, const Util::FixedArray<const Threading::AtomicCounter*, true>& extraCounters) override;
+
 private:
     friend class ObserverContext;
 
     /// setup from load info
     void Setup(const PortalSystemLoadInfo& info);
+
+    /// a rectangle in normalized device coordinates, empty if left > right
+    struct Rect
+    {
+        float left, bottom, right, top;
+    };
+
+    struct Cell
+    {
+        Math::bbox box;
+        Util::Array<uint32> portals;
+        Util::Array<uint32> objects;
+    };
+
+    struct Portal
+    {
+        uint32 cells[2];
+        Util::Array<Math::vec4> vertices;
+    };
+
+    struct Placement
+    {
+        uint32 cell;                    // cell the object is in
+        uint32 slot;                    // index in the object list of the cell
+    };
+
+    struct Object
+    {
+        Math::bbox box;                 // box the object was placed with
+        Util::Array<Placement, 2> placements;   // cells the object is in, empty if none
+        uint32 frame;                   // last update the object was part of
+        bool alwaysVisible;
+    };
+
+    /// cell of objects which are always visible, no matter where the observer is
+    static constexpr uint32 AlwaysVisibleCell = 1;
+    /// first authored cell
+    static constexpr uint32 FirstCell = 2;
+    /// longest chain of portals followed
+    static constexpr uint32 MaxDepth = 16;
+
+    /// update the cells with the entities of this frame, run as a job
+    void Update();
+    /// find the cell a point is in
+    uint32 Locate(const Math::point& point) const;
+    /// find the cells a box is in
+    void Locate(const Math::bbox& box, Util::Array<uint32, 8>& cells) const;
+    /// insert object in cell
+    void Insert(uint32 object, uint32 cell);
+    /// remove object from all its cells
+    void Remove(uint32 object);
+
+    /// walk the graph and cull the objects of the visited cells for an observer
+    static void Cull(const PortalSystem* system, const Math::mat4& transform, bool isOrtho, Rect* rects, uint32* visited, uint32* added, VisibleList* results);
+    /// visit a cell seen through a rectangle, and the cells behind its portals
+    static void Visit(const PortalSystem* system, const Math::mat4& transform, bool isOrtho, uint32 cell, const Rect& rect, uint32* path, uint32 depth, Rect* rects, uint32* visited, SizeT& numVisited);
+    /// narrow a rectangle to the part of it a portal covers, returns false if nothing is left
+    static bool ProjectPortal(const Portal& portal, const Math::mat4& transform, bool isOrtho, const Rect& rect, Rect& narrowed);
+
+    uint32 frame;
+    /// set when cells are added, so all objects are located again
+    bool relocate;
+    Util::Array<Cell> cells;
+    Util::Array<Portal> portals;
+    Util::Array<Object> objects;
+    /// index of every object in the entity list of this frame
+    Util::Array<uint32> slots;
+    /// rectangle each cell is seen through and the cells visited, per observer
+    Util::Array<Rect> rects;
+    Util::Array<uint32> visited;
+    /// frame each object was last added to the visible list, per observer
+    Util::Array<uint32> added;
+    Threading::AtomicCounter updateCounter;
 };
 } // namespace Visibility
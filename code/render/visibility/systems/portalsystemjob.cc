@@ -4,8 +4,152 @@
 //------------------------------------------------------------------------------
 
 #include "portalsystem.h"
+#include "math/clipstatus.h"
+#include <float.h>
 namespace Visibility
 {
 
+//------------------------------------------------------------------------------
+/**
+    Walks the graph from the cell the observer is in, then tests the objects
+    of every cell seen against the frustum narrowed to the rectangle the cell
+    was seen through. Always visible objects are added without testing.
+    Objects in several cells are stamped with the frame once added, so they
+    are added only once.
+*/
+void
+PortalSystem::Cull(const PortalSystem* system, const Math::mat4& transform, bool isOrtho, Rect* rects, uint32* visited, uint32* added, VisibleList* results)
+{
+    const Math::bbox* boxes = system->ent.boxes;
+    const uint32* slots = system->slots.ConstBegin();
+    VisibleBuffer visible(results);
+
+    for (uint32 object : system->cells[AlwaysVisibleCell].objects)
+        visible.Add(slots[object]);
+
+    // The observer is in the cell the center of its near plane is in
+    const Math::vec4 nearCenter = Math::inverse(transform) * Math::vec4(0.0f, 0.0f, 0.0f, 1.0f);
+    const float invW = isOrtho ? 1.0f : 1.0f / nearCenter.w;
+    const Math::point position(nearCenter.x * invW, nearCenter.y * invW, nearCenter.z * invW);
+
+    SizeT numVisited = 0;
+    uint32 path[MaxDepth];
+    const Rect screen = { -1.0f, -1.0f, 1.0f, 1.0f };
+    PortalSystem::Visit(system, transform, isOrtho, system->Locate(position), screen, path, 0, rects, visited, numVisited);
+
+    IndexT i;
+    for (i = 0; i < numVisited; i++)
+    {
+        const uint32 cell = visited[i];
+        Rect& rect = rects[cell];
+        FrustumPlanes planes;
+        FrustumPlanesSetup(planes, transform, isOrtho, rect.left, rect.bottom, rect.right, rect.top);
+        for (uint32 object : system->cells[cell].objects)
+        {
+            const bool shared = system->objects[object].placements.Size() > 1;
+            if (shared && added[object] == system->frame)
+                continue;
+            if (FrustumClip(planes, boxes[object]) != Math::ClipStatus::Outside)
+            {
+                if (shared)
+                    added[object] = system->frame;
+                visible.Add(slots[object]);
+            }
+        }
+
+        // Leave the rectangle empty for the next frame
+        rect = { 1.0f, 1.0f, -1.0f, -1.0f };
+    }
+}
+
+//------------------------------------------------------------------------------
+/**
+    A cell seen through more than one chain of portals is seen through the
+    bounds of all of their rectangles. Chains never go back through a cell
+    they have passed, and stop after MaxDepth cells.
+*/
+void
+PortalSystem::Visit(const PortalSystem* system, const Math::mat4& transform, bool isOrtho, uint32 cell, const Rect& rect, uint32* path, uint32 depth, Rect* rects, uint32* visited, SizeT& numVisited)
+{
+    Rect& seen = rects[cell];
+    if (seen.left > seen.right)
+    {
+        seen = rect;
+        visited[numVisited++] = cell;
+    }
+    else
+    {
+        seen.left = Math::min(seen.left, rect.left);
+        seen.bottom = Math::min(seen.bottom, rect.bottom);
+        seen.right = Math::max(seen.right, rect.right);
+        seen.top = Math::max(seen.top, rect.top);
+    }
+
+    path[depth] = cell;
+    if (depth + 1 == MaxDepth)
+        return;
+
+    for (uint32 index : system->cells[cell].portals)
+    {
+        const Portal& portal = system->portals[index];
+        const uint32 next = portal.cells[0] == cell ? portal.cells[1] : portal.cells[0];
+
+        bool onPath = false;
+        uint32 i;
+        for (i = 0; i <= depth && !onPath; i++)
+            onPath = path[i] == next;
+        if (onPath)
+            continue;
+
+        Rect narrowed;
+        if (PortalSystem::ProjectPortal(portal, transform, isOrtho, rect, narrowed))
+            PortalSystem::Visit(system, transform, isOrtho, next, narrowed, path, depth + 1, rects, visited, numVisited);
+    }
+}
+
+//------------------------------------------------------------------------------
+/**
+*/
+bool
+PortalSystem::ProjectPortal(const Portal& portal, const Math::mat4& transform, bool isOrtho, const Rect& rect, Rect& narrowed)
+{
+    Rect bounds = { FLT_MAX, FLT_MAX, -FLT_MAX, -FLT_MAX };
+    SizeT numNear = 0;
+    for (const Math::vec4& vertex : portal.vertices)
+    {
+        Math::vec4 clip = transform * vertex;
+        if (isOrtho)
+            clip.w = 1.0f;
+
+        // Closer than the near plane, or behind the observer
+        if (clip.z < 0.0f)
+        {
+            numNear++;
+            continue;
+        }
+
+        const float invW = 1.0f / clip.w;
+        bounds.left = Math::min(bounds.left, clip.x * invW);
+        bounds.bottom = Math::min(bounds.bottom, clip.y * invW);
+        bounds.right = Math::max(bounds.right, clip.x * invW);
+        bounds.top = Math::max(bounds.top, clip.y * invW);
+    }
+
+    // Nothing is seen through a portal completely behind the near plane,
+    // and a portal the observer is standing in doesn't narrow anything
+    if (numNear == portal.vertices.Size())
+        return false;
+    if (numNear > 0)
+    {
+        narrowed = rect;
+        return true;
+    }
+
+    narrowed.left = Math::max(rect.left, bounds.left);
+    narrowed.bottom = Math::max(rect.bottom, bounds.bottom);
+    narrowed.right = Math::min(rect.right, bounds.right);
+    narrowed.top = Math::min(rect.top, bounds.top);
+    return narrowed.left < narrowed.right && narrowed.bottom < narrowed.top;
+}
 
 } // namespace Visibility
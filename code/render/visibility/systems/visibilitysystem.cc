@@ -14,11 +14,18 @@ VisibilitySystem::VisibilitySystem()
 {
 }
 
+//------------------------------------------------------------------------------
+/**
+*/
+VisibilitySystem::~VisibilitySystem()
+{
+}
+
 //------------------------------------------------------------------------------
 /**
 */
 void
-VisibilitySystem::PrepareObservers(const Math::mat4* transforms, bool* orthoFlags, Util::Array<Math::ClipStatus::Type>* results, const SizeT count)
+VisibilitySystem::PrepareObservers(const Math::mat4* transforms, bool* orthoFlags, VisibleList* results, const SizeT count)
 {
     this->obs.completionCounters.Resize(count);
     for (auto& counter : this->obs.completionCounters)
@@ -3,8 +3,8 @@
 /**
     A visibility system describes some virtual representation of the scene, 
     wherein objects are searchable for visibility. This is coarse grained
-    visibility, and does not account for any pixel-perfect techniques like
-    occlusion culling.
+    visibility, the only finer grained system is the Occlusion system, which
+    refines what the systems before it found.
 
     Some systems are procedural (Octree and Quadtree) while other systems require
     authoring. 
@@ -31,7 +31,18 @@
         there is no importance of visibility along one axis (isomorphic RPG, 2D scroller)
 
     Bruteforce system:
-        Doesn't do anything but view frustum culling on everything in the scene.
+        Doesn't do anything but view frustum culling on everything in the scene. Observers
+        which don't move only test the entities which changed since the last frame.
+
+    Occlusion system:
+        Rasterizes a few large occluders on the CPU and removes what's hidden behind them
+        from the results of the systems created before it. Useful for dense scenes, like
+        cities, where most of what's in the frustum is behind buildings.
+
+    Systems don't output a clip status per entity, but append the indices of the
+    entities an observer sees to its VisibleList, so whatever consumes the results
+    only has to touch what's visible. If more than one system is used, an entity
+    can be in a list more than once.
 
     @copyright
     (C) 2018-2020 Individual contributors, see AUTHORS file
@@ -45,10 +56,44 @@
 #include "models/modelcontext.h"
 #include "threading/event.h"
 #include "jobs2/jobs2.h"
+#include "threading/interlocked.h"
 
 namespace Visibility
 {
 
+/// indices into the entity list of the entities an observer sees
+struct VisibleList
+{
+    Util::Array<uint32> indices;
+    Threading::AtomicCounter count = 0;
+
+    /// append indices, safe to call from several jobs at once
+    void Append(const uint32* visible, SizeT num);
+};
+
+/// collects visible indices in a job and appends them to a visible list when full
+struct VisibleBuffer
+{
+    static const SizeT Size = 512;
+
+    VisibleBuffer(VisibleList* list) : list(list), num(0) {}
+    ~VisibleBuffer() { this->list->Append(this->indices, this->num); }
+
+    void Add(uint32 index)
+    {
+        if (this->num == Size)
+        {
+            this->list->Append(this->indices, this->num);
+            this->num = 0;
+        }
+        this->indices[this->num++] = index;
+    }
+
+    VisibleList* list;
+    SizeT num;
+    uint32 indices[Size];
+};
+
 struct BoxSystemLoadInfo
 {
     Resources::ResourceName path;   // path to authored box system
@@ -80,15 +125,22 @@ struct BruteforceSystemLoadInfo
     // empty on purpose
 };
 
+struct OcclusionSystemLoadInfo
+{
+    uint width, height;             // size of the depth buffer occluders are rasterized to, 0 for the default
+};
+
 class VisibilitySystem
 {
 public:
 
     /// Constructor
     VisibilitySystem();
+    /// Destructor
+    virtual ~VisibilitySystem();
 
     /// setup observers
-    virtual void PrepareObservers(const Math::mat4* transforms, bool* orthoFlags, Util::Array<Math::ClipStatus::Type>* results, const SizeT count);
+    virtual void PrepareObservers(const Math::mat4* transforms, bool* orthoFlags, VisibleList* results, const SizeT count);
     /// prepare system with entities to insert into the structure
     virtual void PrepareEntities(const Math::bbox* transforms, const uint32* ranges, const Graphics::GraphicsEntityId* entities, const uint32_t* entityFlags, const SizeT count);
     /// run system
@@ -108,7 +160,7 @@ protected:
     {
         const Math::mat4* transforms;
         const bool* isOrtho;
-        Util::Array<Math::ClipStatus::Type>* results;
+        VisibleList* results;
         SizeT count;
         Util::Array<Threading::AtomicCounter> completionCounters;
     } obs;
@@ -123,4 +175,17 @@ protected:
     } ent;
 };
 
+//------------------------------------------------------------------------------
+/**
+*/
+inline void
+VisibleList::Append(const uint32* visible, SizeT num)
+{
+    if (num == 0)
+        return;
+    const int offset = Threading::Interlocked::Add(&this->count, num);
+    n_assert(offset + num <= this->indices.Size());
+    Memory::CopyElements(visible, this->indices.Begin() + offset, num);
+}
+
 } // namespace Visibility
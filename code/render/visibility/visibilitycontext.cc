@@ -19,10 +19,13 @@
 #include "systems/portalsystem.h"
 #include "systems/quadtreesystem.h"
 #include "systems/bruteforcesystem.h"
+#include "systems/occlusionsystem.h"
 
 #include "profiling/profiling.h"
 
 #include "util/randomnumbertable.h"
+#include "util/radixsort.h"
+#include "timing/timer.h"
 
 #include "jobs2/jobs2.h"
 
@@ -44,9 +47,23 @@ __ImplementContext(ObserverContext, ObserverContext::observerAllocator)
 
 struct ObservableGlobalState
 {
-    ObserverContext::VisibilityResultArray visibilityResults;
+    SizeT numNodeInstances = 0;
 } ObservableState;
 
+//------------------------------------------------------------------------------
+/**
+    Draws are ordered by the sort id of their node, which holds the pass and
+    the material and mesh of the node, then front to back within the same
+    node. The node instance index is or'ed into the lowest 16 bits.
+*/
+static inline uint64
+DrawListSortKey(uint64 sortId, const Math::bbox& box, const Math::mat4& viewProjection)
+{
+    const Math::vec4 clip = viewProjection * box.center();
+    const float depth = clip.w > 0.0f ? Math::clamp(clip.z / clip.w, 0.0f, 1.0f) : 0.0f;
+    return (sortId & 0xFFFFFFFF00000000) | ((uint64)(depth * 0xFFFF) << 16);
+}
+
 //------------------------------------------------------------------------------
 /**
 */
@@ -57,7 +74,6 @@ ObserverContext::Setup(const Graphics::GraphicsEntityId id, VisibilityEntityType
     observerAllocator.Set<Observer_EntityType>(cid.id, entityType);
     observerAllocator.Set<Observer_EntityId>(cid.id, id);
     observerAllocator.Set<Observer_IsOrtho>(cid.id, isOrtho);
-    observerAllocator.Set<Observer_ResultArray>(cid.id, ObservableState.visibilityResults);
 }
 
 //------------------------------------------------------------------------------
@@ -111,13 +127,22 @@ ObserverContext::RunVisibilityTests(const Graphics::FrameContext& ctx)
         }
     }
 
-    // reset all lists to that all entities are visible
+    // reset all lists so that no entities are visible, every system can see every entity once
+    const SizeT numVisible = ObservableState.numNodeInstances * Math::max(ObserverContext::systems.Size(), 1);
     for (i = 0; i < observerResults.Size(); i++)
     {
         VisibilityDrawList& visibilities = observerAllocator.Get<Observer_DrawList>(i);
-        observerResults[i].Fill(0, observerResults[i].Size(), Math::ClipStatus::Type::Outside);
+        if (observerResults[i].indices.Size() < numVisible)
+            observerResults[i].indices.Resize(numVisible);
+        observerResults[i].count = 0;
+        if (visibilities.keys.Size() < numVisible)
+        {
+            visibilities.keys.Resize(numVisible);
+            visibilities.scratch.Resize(numVisible);
+        }
         visibilities.visibilityTable.Clear();
         visibilities.drawPackets.Clear();
+        visibilities.generationTime = 0;
     }
 
     // prepare visibility systems
@@ -134,7 +159,7 @@ ObserverContext::RunVisibilityTests(const Graphics::FrameContext& ctx)
     const Util::Array<Graphics::GraphicsEntityId>& ids = ObservableContext::observableAllocator.GetArray<Observable_EntityId>();
     static Util::Array<uint32> nodes;
     nodes.Clear();
-    nodes.Resize(observerResults[0].Size());
+    nodes.Resize(ObservableState.numNodeInstances);
 
     static Threading::AtomicCounter idCounter;
     idCounter = 1;
@@ -221,81 +246,81 @@ ObserverContext::RunVisibilityTests(const Graphics::FrameContext& ctx)
             &Characters::CharacterContext::ConstantUpdateCounter,
         };
 
+        // Each bucket turns a range of the visible node instances into sort keys and sorts them
+        n_assert(visibilities.bucketCounter == 0);
+        visibilities.bucketCounter = 1;
         Jobs2::JobDispatch(
             [
-                statuses = results.ConstBegin()
+                visible = &results
                 , ids = nodes.ConstBegin()
                 , drawList = &visibilities
-                , allocator = &allocator
+                , transform = &observerTransforms[i]
                 , renderables = &NodeInstances
             ]
         (SizeT totalJobs, SizeT groupSize, IndexT groupIndex, SizeT invocationOffset)
         {
             N_SCOPE(VisibilitySortJob, Graphics);
-            allocator->Release();
-
-            // calculate amount of models
-            uint32 numNodeInstances = totalJobs;
+            Timing::Timer timer;
+            timer.Start();
+
+            // only the visible node instances are touched from here on
+            const IndexT bucket = invocationOffset;
+            const uint32 numNodeInstances = visible->count;
+            const uint32 begin = (uint64)numNodeInstances * bucket / totalJobs;
+            const uint32 end = (uint64)numNodeInstances * (bucket + 1) / totalJobs;
+
+            uint64* keys = drawList->keys.Begin() + begin;
+            uint32 numKeys = 0;
+            for (uint32 i = begin; i < end; i++)
+            {
+                // Make sure we're not exceeding the number of bits in the sort key reserved for the actual node instance
+                uint32 index = ids[visible->indices[i]];
+                n_assert(index <= 0xFFFF);
 
-            if (numNodeInstances == 0)
-                return;
+                // Skip inactive node instances
+                if (!AllBits(renderables->nodeFlags[index], Models::NodeInstanceFlags::NodeInstance_Active))
+                    continue;
 
-            uint64 visibleCounter = 0;
-            Util::FixedArray<uint64, true> indexBuffer(numNodeInstances);
-            Util::FixedArray<Math::ClipStatus::Type, true> clipStatuses(numNodeInstances);
-            for (uint32 i = 0; i < numNodeInstances; i++)
-            {
-                // Make sure we're not exceeding the number of bits in the index buffer reserved for the actual node instance
-                n_assert(ids[i] < 0xFFFFFFFF);
-                clipStatuses[visibleCounter] = statuses[i];
-                indexBuffer[visibleCounter] = ids[i];
-                visibleCounter++;
+                // Set the node visible flag (use this to figure out if a node is seen by __any__ observer)
+                renderables->nodeFlags[index] = SetBits(renderables->nodeFlags[index], Models::NodeInstanceFlags::NodeInstance_Visible);
+                keys[numKeys++] = DrawListSortKey(renderables->nodeSortId[index], renderables->nodeBoundingBoxes[index], *transform) | index;
             }
 
-            // loop over each node and give them the appropriate weight
-            uint32 i = 0;
-            while (i < visibleCounter)
-            {
-                n_assert(indexBuffer[i] < 0x00000000FFFFFFFF);
-                uint64 index = indexBuffer[i] & 0x00000000FFFFFFFF;
-                Math::ClipStatus::Type clipStatus = clipStatuses[i];
+            drawList->bucketKeys[bucket] = Util::RadixSort(keys, drawList->scratch.Begin() + begin, numKeys);
+            drawList->bucketSizes[bucket] = numKeys;
 
-                // If not visible nor active, erase item from index list
-                if (!AllBits(renderables->nodeFlags[index], Models::NodeInstanceFlags::NodeInstance_Active)
-                    || clipStatus == Math::ClipStatus::Outside)
-                {
-                    indexBuffer[i] = indexBuffer[visibleCounter - 1];
-                    clipStatuses[i] = clipStatuses[visibleCounter - 1];
-                    visibleCounter--;
-                    continue;
-                }
-                else
-                {
-                    // Set the node visible flag (use this to figure out if a node is seen by __any__ observer)
-                    renderables->nodeFlags[index] = SetBits(renderables->nodeFlags[index], Models::NodeInstanceFlags::NodeInstance_Visible);
-                }
+            timer.Stop();
+            Threading::Interlocked::Add(&drawList->generationTime, (int)(timer.GetTime() * 1000000.0));
+        }
+        , NumDrawListBuckets
+        , 1
+        , waitCounters
+        , { &visibilities.bucketCounter }
+        , nullptr);
 
-                // Get sort id and combine with index to get full sort id
-                uint64 sortId = renderables->nodeSortId[index];
-                indexBuffer[i] = sortId | index;
-                i++;
-            }
+        // Merge the sorted buckets and resolve them into draw commands
+        Jobs2::JobDispatch(
+            [
+                drawList = &visibilities
+                , allocator = &allocator
+                , renderables = &NodeInstances
+            ]
+        (SizeT totalJobs, SizeT groupSize, IndexT groupIndex, SizeT invocationOffset)
+        {
+            N_SCOPE(VisibilityDrawListJob, Graphics);
+            Timing::Timer timer;
+            timer.Start();
+            allocator->Release();
 
-            if (visibleCounter == 0)
+            uint32 numKeys = 0;
+            for (IndexT bucket = 0; bucket < NumDrawListBuckets; bucket++)
+                numKeys += drawList->bucketSizes[bucket];
+            if (numKeys == 0)
                 return; // early out
 
-            // sort the index buffer
-            std::qsort(indexBuffer.Begin(), visibleCounter, sizeof(uint64), [](const void* a, const void* b)
-            {
-                uint64 arg1 = *static_cast<const uint64*>(a);
-                uint64 arg2 = *static_cast<const uint64*>(b);
-                return (arg1 > arg2) - (arg1 < arg2);
-            });
-
-            // Now resolve the indexbuffer into draw commands
+            // Now resolve the sorted keys into draw commands
             uint32 numDraws = 0;
-            const uint32 numPackets = visibleCounter;
-            drawList->drawPackets.Reserve(numPackets);
+            drawList->drawPackets.Reserve(numKeys);
 
             // Allocate single command which we can
             ObserverContext::VisibilityBatchCommand* cmd = nullptr;
@@ -305,9 +330,32 @@ ObserverContext::RunVisibilityTests(const Graphics::FrameContext& ctx)
             Util::Tuple<uint32, uint32> drawModifiers = NullDrawModifiers;
             const MaterialTemplates::Entry* currentMaterialType = nullptr;
 
-            for (uint32 i = 0; i < numPackets; i++)
+            uint32 cursors[NumDrawListBuckets] = {};
+            uint64 previousKey = 0;
+            while (true)
             {
-                uint32 index = indexBuffer[i] & 0x00000000FFFFFFFF;
+                // Take the smallest key at the front of any bucket
+                IndexT next = InvalidIndex;
+                uint64 key = 0;
+                for (IndexT bucket = 0; bucket < NumDrawListBuckets; bucket++)
+                {
+                    if (cursors[bucket] < drawList->bucketSizes[bucket]
+                        && (next == InvalidIndex || drawList->bucketKeys[bucket][cursors[bucket]] < key))
+                    {
+                        next = bucket;
+                        key = drawList->bucketKeys[bucket][cursors[bucket]];
+                    }
+                }
+                if (next == InvalidIndex)
+                    break;
+                cursors[next]++;
+
+                // Node instances seen by more than one system have the same key, and are next to each other after merging
+                if (numDraws > 0 && key == previousKey)
+                    continue;
+                previousKey = key;
+
+                uint32 index = key & 0xFFFF;
 
                 // If new material, add a new entry into the lookup table
                 auto otherMaterialType = renderables->nodeMaterialTemplates[index];
@@ -326,7 +374,7 @@ ObserverContext::RunVisibilityTests(const Graphics::FrameContext& ctx)
                 }
                 n_assert(cmd != nullptr);
 
-                // If a new node (resource), add a model apply command
+                // If a new node (resource), add a model apply command, consecutive packets with the same mesh and material are drawn with it
                 auto otherMesh = renderables->nodeMeshes[index];
                 auto otherMat = renderables->nodeMaterials[index];
                 if (mesh != otherMesh || mat != otherMat)
@@ -376,7 +424,10 @@ ObserverContext::RunVisibilityTests(const Graphics::FrameContext& ctx)
                 cmd->numDrawPackets++;
                 numDraws++;
             }
-        }, nodes.Size(), waitCounters, &completionCounter, finishedEvent);
+
+            timer.Stop();
+            Threading::Interlocked::Add(&drawList->generationTime, (int)(timer.GetTime() * 1000000.0));
+        }, 1, { &visibilities.bucketCounter }, &completionCounter, finishedEvent);
     }
 
     if (finishedEvent != nullptr)
@@ -437,7 +488,7 @@ ObserverContext::CreateBoxSystem(const BoxSystemLoadInfo& info)
 //------------------------------------------------------------------------------
 /**
 */
-VisibilitySystem*
+PortalSystem*
 ObserverContext::CreatePortalSystem(const PortalSystemLoadInfo& info)
 {
     PortalSystem* system = new PortalSystem;
@@ -482,6 +533,30 @@ ObserverContext::CreateBruteforceSystem(const BruteforceSystemLoadInfo& info)
     return system;
 }
 
+//------------------------------------------------------------------------------
+/**
+*/
+OcclusionSystem*
+ObserverContext::CreateOcclusionSystem(const OcclusionSystemLoadInfo& info)
+{
+    OcclusionSystem* system = new OcclusionSystem;
+    system->Setup(info);
+    ObserverContext::systems.Append(system);
+    return system;
+}
+
+//------------------------------------------------------------------------------
+/**
+*/
+void
+ObserverContext::DestroySystem(VisibilitySystem* system)
+{
+    IndexT i = ObserverContext::systems.FindIndex(system);
+    n_assert(i != InvalidIndex);
+    ObserverContext::systems.EraseIndex(i);
+    delete system;
+}
+
 //------------------------------------------------------------------------------
 /**
 */
@@ -553,27 +628,6 @@ ObserverContext::OnRenderDebug(uint32_t flags)
     }
 
     Util::Array<VisibilityResultArray>& vis = observerAllocator.GetArray<Observer_ResultArray>();
-    Util::FixedArray<SizeT> insideCounters(vis.Size(), 0);
-    Util::FixedArray<SizeT> clippedCounters(vis.Size(), 0);
-    Util::FixedArray<SizeT> totalCounters(vis.Size(), 0);
-    for (IndexT i = 0; i < vis.Size(); i++)
-    {
-        auto res = vis[i];
-        for (IndexT j = 0; j < res.Size(); j++)
-            switch (res[j])
-            {
-            case Math::ClipStatus::Inside:
-                insideCounters[i]++;
-                totalCounters[i]++;
-                break;
-            case Math::ClipStatus::Clipped:
-                clippedCounters[i]++;
-                totalCounters[i]++;
-                break;
-            default:
-                break;
-            }
-    }
     if (ImGui::Begin("Visibility"))
     {
         ImGui::Checkbox("Single atom mode", &singleAtomMode);
@@ -584,7 +638,8 @@ ObserverContext::OnRenderDebug(uint32_t flags)
         ImGui::SliderInt("visIndex", &visIndex, 0, (int)foo.size() - 1);
         for (IndexT i = 0; i < vis.Size(); i++)
         {
-            ImGui::Text("Entities visible for observer %d: %d (inside [%d], clipped [%d])", i, totalCounters[i], insideCounters[i], clippedCounters[i]);
+            ImGui::Text("Entities visible for observer %d: %d", i, vis[i].count);
+            ImGui::Text("Draw list for observer %d: %d packets in %.3f ms", i, foo[i].drawPackets.Size(), foo[i].generationTime / 1000.0f);
         }
     }
     ImGui::End();
@@ -645,18 +700,8 @@ ObservableContext::Setup(const Graphics::GraphicsEntityId id, VisibilityEntityTy
         SizeT numNodes = nodeInstanceRange.end - nodeInstanceRange.begin;
         observableAllocator.Set<Observable_NumNodes>(cid.id, numNodes);
 
-        // Update global registry of observables
-        ObservableState.visibilityResults.Reserve(numNodes);
-        for (IndexT i = 0; i < numNodes; i++)
-            ObservableState.visibilityResults.Append(Math::ClipStatus::Outside);
-
-        // Then update observers
-        const Util::Array<ObserverContext::VisibilityResultArray>& visAllocators = ObserverContext::observerAllocator.GetArray<Observer_ResultArray>();
-        for (IndexT i = 0; i < visAllocators.Size(); i++)
-        {
-            ObserverContext::VisibilityResultArray& alloc = visAllocators[i];
-            alloc = ObservableState.visibilityResults;
-        }
+        // Update global registry of observables, the visible lists are resized on the next visibility update
+        ObservableState.numNodeInstances += numNodes;
     }
 }
 
@@ -689,14 +734,7 @@ ObservableContext::Dealloc(Graphics::ContextEntityId id)
 {
     uint32 numNodes = observableAllocator.Get<Observable_NumNodes>(id.id);
 
-    ObservableState.visibilityResults.EraseRange(0, numNodes);
-    // add as many atoms to each visibility result allocator
-    const Util::Array<ObserverContext::VisibilityResultArray>& visAllocators = ObserverContext::observerAllocator.GetArray<Observer_ResultArray>();
-    for (IndexT i = 0; i < visAllocators.Size(); i++)
-    {
-        ObserverContext::VisibilityResultArray& alloc = visAllocators[i];
-        alloc = ObservableState.visibilityResults;
-    }
+    ObservableState.numNodeInstances -= numNodes;
     observableAllocator.Dealloc(id.id);
 }
 
@@ -26,6 +26,9 @@ namespace Models
 namespace Visibility
 {
 
+class PortalSystem;
+class OcclusionSystem;
+
 enum
 {
     Observer_Matrix,
@@ -84,13 +87,17 @@ public:
     /// create a box system
     static VisibilitySystem* CreateBoxSystem(const BoxSystemLoadInfo& info);
     /// create a portal system
-    static VisibilitySystem* CreatePortalSystem(const PortalSystemLoadInfo& info);
+    static PortalSystem* CreatePortalSystem(const PortalSystemLoadInfo& info);
     /// create octree system
     static VisibilitySystem* CreateOctreeSystem(const OctreeSystemLoadInfo& info);
     /// create quadtree system
     static VisibilitySystem* CreateQuadtreeSystem(const QuadtreeSystemLoadInfo& info);
     /// create brute force system
     static VisibilitySystem* CreateBruteforceSystem(const BruteforceSystemLoadInfo& info);
+    /// create occlusion system, has to be created after the systems it should refine
+    static OcclusionSystem* CreateOcclusionSystem(const OcclusionSystemLoadInfo& info);
+    /// destroy a system created with one of the above
+    static void DestroySystem(VisibilitySystem* system);
 
     /// wait for all visibility jobs
     static void WaitForVisibility(const Graphics::FrameContext& ctx);
@@ -129,10 +136,22 @@ public:
         Util::Array<VisibilityDrawCommand, 1024> draws;
     };
 
+    /// number of ranges the visible node instances of an observer are split into to be sorted in parallel
+    static const SizeT NumDrawListBuckets = 8;
+
     struct VisibilityDrawList
     {
         Util::HashTable<const MaterialTemplates::Entry*, VisibilityBatchCommand> visibilityTable;
         Util::Array<Models::ShaderStateNode::DrawPacket*> drawPackets;
+
+        /// sort keys of the visible node instances, each bucket sorts its own range
+        Util::FixedArray<uint64> keys, scratch;
+        uint64* bucketKeys[NumDrawListBuckets];
+        uint32 bucketSizes[NumDrawListBuckets];
+        Threading::AtomicCounter bucketCounter = 0;
+
+        /// time spent building the draw list, summed over all jobs, in microseconds
+        Threading::AtomicCounter generationTime = 0;
     };
 
     /// get visibility draw list
@@ -148,14 +167,14 @@ private:
 
     friend class ObservableContext;
     friend struct ObservableGlobalState;
-    typedef Util::Array<Math::ClipStatus::Type> VisibilityResultArray;
+    typedef VisibleList VisibilityResultArray;
 
     typedef Ids::IdAllocator<
         Math::mat4                                 // transform of observer camera
         , bool                                     // observer is an orthogonal camera
         , Graphics::GraphicsEntityId               // entity id
         , VisibilityEntityType                     // type of object so we know how to get the transform
-        , VisibilityResultArray                    // visibility lookup table
+        , VisibilityResultArray                    // visible entities
         , Graphics::GraphicsEntityId               // dependency
         , DependencyMode                           // dependency mode
         , VisibilityDrawList                       // draw list
@@ -0,0 +1,185 @@
+//------------------------------------------------------------------------------
+// residencymanager.cc
+// (C)2024 Individual contributors, see AUTHORS file
+//------------------------------------------------------------------------------
+#include "foundation/stdneb.h"
+#include "residencymanager.h"
+#include "profiling/profiling.h"
+#include "util/bit.h"
+
+N_DECLARE_COUNTER(N_STREAMED_RESOURCE_MEMORY, Streamed Resource Memory);
+
+namespace Resources
+{
+
+__ImplementClass(Resources::ResidencyManager, 'RSRM', Core::RefCounted);
+//------------------------------------------------------------------------------
+/**
+*/
+ResidencyManager::ResidencyManager()
+    : budget(0)
+    , residentBytes(0)
+    , frameIndex(0)
+{
+    this->SetBudget(DefaultBudget);
+}
+
+//------------------------------------------------------------------------------
+/**
+*/
+ResidencyManager::~ResidencyManager()
+{
+    // empty
+}
+
+//------------------------------------------------------------------------------
+/**
+*/
+void
+ResidencyManager::SetBudget(uint64 bytes)
+{
+    this->budget = bytes;
+    N_BUDGET_COUNTER_SETUP(N_STREAMED_RESOURCE_MEMORY, bytes);
+}
+
+//------------------------------------------------------------------------------
+/**
+*/
+void
+ResidencyManager::Update(const Util::Array<Ptr<ResourceLoader>>& loaders, IndexT frameIndex)
+{
+    N_SCOPE(UpdateResidency, Resources);
+    this->frameIndex = frameIndex;
+    this->residentBytes = 0;
+    this->candidates.Clear();
+    this->stats = Stats();
+
+    IndexT i;
+    for (i = 0; i < loaders.Size(); i++)
+    {
+        ResourceLoader* loader = loaders[i].get_unsafe();
+        if (loader == nullptr)
+            continue;
+
+        // apply the usage reported since the last update
+        Util::Array<ResourceLoader::_UsageFeedback, 128> feedback;
+        loader->usageQueue.DequeueAll(feedback);
+        for (const ResourceLoader::_UsageFeedback& usage : feedback)
+        {
+            const Ids::Id32 entry = usage.id.loaderInstanceId;
+            if (entry >= (uint)loader->residency.Size() || loader->states[entry] == Resource::Unloaded)
+                continue;
+
+            ResourceLoader::_Residency& residency = loader->residency[entry];
+            if (residency.lastUsedFrame == frameIndex)
+                residency.usedLod = Math::min(residency.usedLod, usage.lod);
+            else
+            {
+                residency.usedLod = usage.lod;
+                residency.lastUsedFrame = frameIndex;
+            }
+        }
+
+        IndexT j;
+        for (j = 0; j < loader->ids.Size(); j++)
+        {
+            const Ids::Id32 entry = loader->ids.ValueAtIndex(j);
+            const Resource::State state = loader->states[entry];
+            const ResourceLoader::_StreamData& stream = loader->streamDatas[entry];
+
+            // skip resources which are gone or haven't been initialized yet
+            if (state == Resource::Unloaded || state == Resource::Failed || stream.data == nullptr)
+                continue;
+
+            // count LODs in flight too, they will be resident shortly
+            const ResourceLoader::LoadState& loadState = loader->loadStates[entry];
+            uint bits = loadState.loadedBits;
+            if (state == Resource::Pending)
+                bits |= loadState.requestedBits;
+
+            // only ask the loader when the LODs have changed
+            ResourceLoader::_Residency& residency = loader->residency[entry];
+            if (residency.bits != bits)
+            {
+                residency.bytes = loader->ResidentBytes(stream, bits);
+                residency.bits = bits;
+            }
+            if (residency.bytes == 0)
+                continue;
+
+            this->residentBytes += residency.bytes;
+            this->stats.numResident++;
+
+            // resources which are streaming can't be changed until they are done
+            if (state == Resource::Loaded && loadState.pendingBits == 0x0)
+                this->candidates.Append({ loader, entry, residency.bytes, this->Importance(residency) });
+        }
+    }
+
+    if (this->residentBytes <= this->budget)
+        this->Request();
+
+    N_BUDGET_COUNTER_RESET(N_STREAMED_RESOURCE_MEMORY);
+    N_BUDGET_COUNTER_INCR(N_STREAMED_RESOURCE_MEMORY, this->residentBytes);
+}
+
+//------------------------------------------------------------------------------
+/**
+    Resources used recently and with a fine LOD are the most important,
+    resources which have never been used are the least.
+*/
+float
+ResidencyManager::Importance(const ResourceLoader::_Residency& residency) const
+{
+    if (residency.lastUsedFrame == InvalidIndex)
+        return 0.0f;
+
+    const float age = (float)Math::max(0, this->frameIndex - residency.lastUsedFrame);
+    const float detail = 1.0f - Math::clamp(residency.usedLod, 0.0f, 1.0f);
+    return (1.0f + detail) / (1.0f + age);
+}
+
+//------------------------------------------------------------------------------
+/**
+    Requests the LOD a resource was last used with, for resources used in the
+    last couple of frames which don't have it loaded, most important first.
+    This is what brings back the detail held back while over budget.
+*/
+void
+ResidencyManager::Request()
+{
+    this->candidates.SortWithFunc([](const _Candidate& lhs, const _Candidate& rhs) -> bool
+    {
+        return lhs.importance > rhs.importance;
+    });
+
+    IndexT i;
+    for (i = 0; i < this->candidates.Size(); i++)
+    {
+        if (this->stats.numRequested >= MaxRequestsPerFrame)
+            break;
+
+        const _Candidate& candidate = this->candidates[i];
+        ResourceLoader* loader = candidate.loader;
+        ResourceLoader::_Residency& residency = loader->residency[candidate.entry];
+        if (residency.lastUsedFrame == InvalidIndex || this->frameIndex - residency.lastUsedFrame > 1)
+            continue;
+
+        const ResourceLoader::LoadState& loadState = loader->loadStates[candidate.entry];
+        const ResourceLoader::_StreamData& stream = loader->streamDatas[candidate.entry];
+        const uint wantedBits = loader->LodMask(stream, residency.usedLod, true);
+        if (AllBits(loadState.loadedBits, wantedBits))
+            continue;
+
+        // reserve the memory, the next update counts it as in flight
+        const uint64 bytes = loader->ResidentBytes(stream, loadState.loadedBits | wantedBits);
+        if (this->residentBytes - residency.bytes + bytes > this->budget)
+            continue;
+        this->residentBytes += bytes - residency.bytes;
+
+        loader->SetMinLod(loader->resources[candidate.entry], residency.usedLod, false, candidate.importance);
+        this->stats.numRequested++;
+    }
+}
+
+} // namespace Resources
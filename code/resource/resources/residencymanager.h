@@ -0,0 +1,131 @@
+#pragma once
+//------------------------------------------------------------------------------
+/**
+    @class Resources::ResidencyManager
+
+    Tracks the memory of streamed resources against a budget. Loaders report
+    the memory a resource allocates for its LODs through
+    ResourceLoader::ResidentBytes(), and the renderer reports which LOD a
+    resource was used with each frame through ResourceLoader::ReportUsage().
+
+    Once per frame the manager sums up the memory of all streamed resources,
+    including the LODs still in flight. While over budget, loaders hold back
+    requests for more detail that would take more memory. Within budget,
+    recently used resources which need more detail than they have are
+    streamed up, most important first, as long as they fit. Importance is
+    given by how recently a resource was used and how much detail it was
+    used with.
+
+    Memory is never taken back from a resource before it is unloaded, since
+    no loader can release a single LOD. Textures allocate their whole mip
+    chain up front, so they are counted at their full size, and streaming
+    their mips is never held back.
+
+    The tracked memory is exposed as the "Streamed Resource Memory" budget counter.
+
+    @copyright
+    (C) 2024 Individual contributors, see AUTHORS file
+*/
+//------------------------------------------------------------------------------
+#include "core/refcounted.h"
+#include "util/array.h"
+#include "resourceloader.h"
+
+namespace Resources
+{
+
+class ResidencyManager : public Core::RefCounted
+{
+    __DeclareClass(ResidencyManager);
+public:
+    /// constructor
+    ResidencyManager();
+    /// destructor
+    virtual ~ResidencyManager();
+
+    /// set the memory budget for streamed resources in bytes
+    void SetBudget(uint64 bytes);
+    /// get the memory budget
+    uint64 GetBudget() const;
+    /// get the memory used by streamed resources as of the last update
+    uint64 GetResidentBytes() const;
+    /// returns true if the streamed resources exceeded the budget in the last update
+    bool IsOverBudget() const;
+
+    /// apply usage feedback and stream LODs which fit within the budget
+    void Update(const Util::Array<Ptr<ResourceLoader>>& loaders, IndexT frameIndex);
+
+    /// statistics of the last update
+    struct Stats
+    {
+        /// number of resources with resident memory
+        SizeT numResident = 0;
+        /// number of resources requested to stream in more detail
+        SizeT numRequested = 0;
+    };
+    /// get statistics
+    const Stats& GetStats() const;
+
+    /// default budget
+    static const uint64 DefaultBudget = 1024ull * 1024ull * 1024ull;
+    /// max number of LOD requests issued per frame
+    static const SizeT MaxRequestsPerFrame = 16;
+
+private:
+    struct _Candidate
+    {
+        ResourceLoader* loader;
+        Ids::Id32 entry;
+        uint64 bytes;
+        float importance;
+    };
+
+    /// importance of a resource, the most important resources are streamed first
+    float Importance(const ResourceLoader::_Residency& residency) const;
+    /// stream in detail for resources which need it, if it fits
+    void Request();
+
+    uint64 budget;
+    uint64 residentBytes;
+    IndexT frameIndex;
+    Util::Array<_Candidate> candidates;
+    Stats stats;
+};
+
+//------------------------------------------------------------------------------
+/**
+*/
+inline uint64
+ResidencyManager::GetBudget() const
+{
+    return this->budget;
+}
+
+//------------------------------------------------------------------------------
+/**
+*/
+inline uint64
+ResidencyManager::GetResidentBytes() const
+{
+    return this->residentBytes;
+}
+
+//------------------------------------------------------------------------------
+/**
+*/
+inline bool
+ResidencyManager::IsOverBudget() const
+{
+    return this->residentBytes > this->budget;
+}
+
+//------------------------------------------------------------------------------
+/**
+*/
+inline const ResidencyManager::Stats&
+ResidencyManager::GetStats() const
+{
+    return this->stats;
+}
+
+} // namespace Resources
@@ -6,6 +6,7 @@
 #include "resourceloader.h"
 #include "io/ioserver.h"
 #include "resourceserver.h"
+#include "residencymanager.h"
 #include "util/bit.h"
 
 using namespace IO;
@@ -18,11 +19,14 @@ __ImplementAbstractClass(Resources::ResourceLoader, 'RSLO', Core::RefCounted);
 */
 ResourceLoader::ResourceLoader()
     : async(false)
+    , maxConcurrentJobs(1)
+    , prefetchDependencies(false)
 {
     // maybe this is arrogant, just 1024 pending resources (actual resources that is) per loader?
     this->pendingLoads.Reserve(1024);
     this->pendingStreamLods.Reserve(1024);
     this->pendingStreamQueue.SetSignalOnEnqueueEnabled(false);
+    this->usageQueue.SetSignalOnEnqueueEnabled(false);
     this->creatorThread = Threading::Thread::GetMyThreadId();
 }
 
@@ -44,13 +48,9 @@ ResourceLoader::Setup()
     // implement loader-specific setups, such as placeholder and error resource ids, as well as the acceptable resource class
     this->uniqueResourceId = 0;
 
-    // set the async flag in the constructor of your subclass implementation of the resource pool
-    if (this->async)
-    {
-        this->streamerThread = ResourceLoaderThread::Create();
-        this->streamerThread->SetName(this->streamerThreadName.Value());
-        this->streamerThread->Start();
-    }
+    // set the async flag in the constructor of your subclass implementation of the resource pool,
+    // async jobs are run by the resource server's load scheduler
+    n_assert(this->maxConcurrentJobs > 0);
 }
 
 //------------------------------------------------------------------------------
@@ -59,8 +59,9 @@ ResourceLoader::Setup()
 void
 ResourceLoader::Discard()
 {
-    this->streamerThread->Stop();
-    this->streamerThread = nullptr;
+    const Ptr<ResourceLoadScheduler>& scheduler = ResourceServer::Instance()->GetLoadScheduler();
+    if (this->async && scheduler.isvalid())
+        scheduler->Cancel(this);
 }
 
 //------------------------------------------------------------------------------
@@ -138,6 +139,16 @@ ResourceLoader::RequestLOD(const Ids::Id32 entry, float lod) const
     // Do nothing
 }
 
+//------------------------------------------------------------------------------
+/**
+*/
+uint64
+ResourceLoader::ResidentBytes(const _StreamData& stream, uint loadedBits) const
+{
+    // Assume the loader doesn't support streaming, so the residency manager leaves it alone
+    return 0;
+}
+
 //------------------------------------------------------------------------------
 /**
 */
@@ -146,7 +157,11 @@ ApplyLoadOutput(ResourceLoader* loader, const ResourceLoader::ResourceLoadOutput
 {
     output.UpdateLoaderState(loader);
     if (output.state == Resource::Loaded || output.state == Resource::Failed)
+    {
+        if (output.remainderJob.submitTime >= 0)
+            ResourceServer::Instance()->GetLoadScheduler()->RecordReady(loader, output.remainderJob.submitTime);
         loader->RunCallbacks(output.state, output.id);
+    }
     else
         loader->dependentJobs.Append(output.remainderJob);
 }
@@ -159,13 +174,18 @@ DispatchJob(ResourceLoader* loader, const ResourceLoader::ResourceLoadJob& job)
 {
     if (loader->async && !job.immediate)
     {
+        // Time stamp the first submission only, jobs that continue streaming keep it
+        ResourceLoader::ResourceLoadJob asyncJob = job;
+        if (asyncJob.submitTime < 0)
+            asyncJob.submitTime = ResourceServer::Instance()->GetLoadScheduler()->GetTime();
+
         // Create and send off job to thread
-        auto jobFunc = [loader, job]() -> void
+        auto jobFunc = [loader, asyncJob]() -> void
         {
-            ResourceLoader::ResourceLoadOutput output = _LoadInternal(loader, job);
+            ResourceLoader::ResourceLoadOutput output = _LoadInternal(loader, asyncJob);
             loader->loadOutputs.Enqueue(output);
         };
-        loader->EnqueueJob(jobFunc);
+        loader->EnqueueJob(asyncJob, jobFunc);
     }
     else
     {
@@ -194,6 +214,8 @@ ResourceLoader::ClearPendingUnloads()
                 // unload if loaded
                 this->states[unload.resourceId.loaderInstanceId] = Resource::Unloaded;
                 this->Unload(unload.resourceId);
+                this->streamDatas[unload.resourceId.loaderInstanceId].data = nullptr;
+                this->residency[unload.resourceId.loaderInstanceId] = _Residency{ .bytes = 0, .bits = 0x0, .lastUsedFrame = InvalidIndex, .usedLod = 1.0f };
 
                 Memory::Free(Memory::ScratchHeap, this->metaData[unload.resourceId.loaderInstanceId].data);
 
@@ -262,10 +284,25 @@ ResourceLoader::Update(IndexT frameIndex)
 
         if (this->states[streamLod.id.loaderInstanceId] == Resource::Loaded)
         {
+            // Don't stream in more detail that takes more memory while over the residency budget, the residency manager requests it again once there is room
+            const Ptr<ResidencyManager>& residencyManager = ResourceServer::Instance()->GetResidencyManager();
+            const _Residency& residency = this->residency[streamLod.id.loaderInstanceId];
+            if (residency.bytes > 0 && residencyManager.isvalid() && residencyManager->IsOverBudget())
+            {
+                const _StreamData& stream = this->streamDatas[streamLod.id.loaderInstanceId];
+                const uint wantedBits = this->loadStates[streamLod.id.loaderInstanceId].loadedBits | this->LodMask(stream, streamLod.lod, true);
+                if (this->ResidentBytes(stream, wantedBits) > residency.bytes)
+                {
+                    this->pendingStreamLods.EraseIndex(i);
+                    continue;
+                }
+            }
+
             this->states[streamLod.id.loaderInstanceId] = Resource::Pending;
 
             _PendingResourceLoad& load = this->loads[streamLod.id.loaderInstanceId];
             load.lod = streamLod.lod;
+            load.priority = streamLod.priority;
             load.flags |= LoadFlags::Update;
 
             // Update state to continue streaming
@@ -333,9 +370,9 @@ ResourceLoader::RunCallbacks(Resource::State status, const Resources::ResourceId
 /**
 */
 void
-ResourceLoader::EnqueueJob(const std::function<void()>& func)
+ResourceLoader::EnqueueJob(const ResourceLoadJob& job, const std::function<void()>& func)
 {
-    this->streamerThread->jobs.Enqueue(func);
+    ResourceServer::Instance()->GetLoadScheduler()->Enqueue(this, job.id.loaderInstanceId, job.priority, func);
 }
 
 //------------------------------------------------------------------------------
@@ -478,6 +515,7 @@ Resources::ResourceLoader::CreateResource(const ResourceName& res, const void* l
             this->loads.Resize(this->loads.Size() + ResourceIndexGrow);
             this->metaData.Resize(this->metaData.Size() + ResourceIndexGrow);
             this->streamDatas.Resize(this->streamDatas.Size() + ResourceIndexGrow);
+            this->residency.Resize(this->residency.Size() + ResourceIndexGrow);
         }
 
         // add the resource name to the resource id
@@ -487,6 +525,7 @@ Resources::ResourceLoader::CreateResource(const ResourceName& res, const void* l
         this->states[instanceId] = Resource::Pending;
 
         this->loadStates[instanceId] = LoadState{ .requestedBits = 0xFFFFFFFF, .pendingBits = 0x0, .loadedBits = 0x0 };
+        this->residency[instanceId] = _Residency{ .bytes = 0, .bits = 0x0, .lastUsedFrame = InvalidIndex, .usedLod = 1.0f };
 
         // allocate metadata if present
         _LoadMetaData metaData;
@@ -539,6 +578,10 @@ Resources::ResourceLoader::CreateResource(const ResourceName& res, const void* l
                 // we need not worry about the thread, since this resource is new
                 this->callbacks[instanceId].Append({ success, failed });
             }
+
+            // read the manifest on a loader thread, so the loads of all dependencies are issued before this resource has been parsed
+            if (this->prefetchDependencies)
+                ResourceServer::Instance()->PrefetchDependencies(res, tag, pending.priority);
         }
     }
     else // this means the resource container is already created, and it may or may not be pending
@@ -571,6 +614,10 @@ Resources::ResourceLoader::CreateResource(const ResourceName& res, const void* l
                 pend.immediate = pend.immediate || immediate;
             }
 
+            // a job which has already been queued stays async, so at least have it run next
+            if (immediate)
+                this->SetLoadPriority(ret, ImmediateLoadPriority);
+
             // since we are pending and inside the async section, it means the resource is not loaded yet, which means its safe to add the callback
             this->callbacks[instanceId].Append({ success, failed });
         }
@@ -758,11 +805,35 @@ ResourceLoader::ReloadResource(const Resources::ResourceId& id, std::function<vo
     this->callbacks[id.loaderInstanceId].Append({ success, failed });
 }
 
+//------------------------------------------------------------------------------
+/**
+    Jobs that have already been picked up by a loader thread are not affected.
+*/
+void
+ResourceLoader::SetLoadPriority(const Resources::ResourceId& id, float priority)
+{
+    n_assert(Threading::Thread::GetMyThreadId() == this->creatorThread);
+    this->loads[id.loaderInstanceId].priority = priority;
+    if (this->async)
+        ResourceServer::Instance()->GetLoadScheduler()->SetPriority(this, id.loaderInstanceId, priority);
+}
+
+//------------------------------------------------------------------------------
+/**
+    Usage is queued and applied by the ResidencyManager once per frame, so this
+    can be called from jobs. A lower LOD means more detail was needed.
+*/
+void
+ResourceLoader::ReportUsage(const Resources::ResourceId& id, float lod)
+{
+    this->usageQueue.Enqueue(_UsageFeedback{ .id = id, .lod = lod });
+}
+
 //------------------------------------------------------------------------------
 /**
 */
 void 
-ResourceLoader::SetMinLod(const Resources::ResourceId& id, const float lod, bool immediate)
+ResourceLoader::SetMinLod(const Resources::ResourceId& id, const float lod, bool immediate, float priority)
 {
     if (immediate)
     {
@@ -780,6 +851,7 @@ ResourceLoader::SetMinLod(const Resources::ResourceId& id, const float lod, bool
         _PendingStreamLod pending;
         pending.id = id;
         pending.lod = lod;
+        pending.priority = priority;
         pending.immediate = immediate;
         this->pendingStreamQueue.Enqueue(pending);
     }
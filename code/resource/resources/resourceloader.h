@@ -40,6 +40,7 @@
 #include "threading/safequeue.h"
 #include "threading/threadid.h"
 #include "ids/idpool.h"
+#include "timing/time.h"
 #include <tuple>
 #include <functional>
 
@@ -55,7 +56,7 @@ enum LoadFlags
 __ImplementEnumBitOperators(LoadFlags);
 
 class Resource;
-class ResourceLoaderThread;
+class ResourceLoadScheduler;
 class ResourceLoader : public Core::RefCounted
 {
     __DeclareAbstractClass(ResourceLoader);
@@ -109,8 +110,14 @@ public:
     /// reload resource using resource id
     void ReloadResource(const Resources::ResourceId& id, std::function<void(const Resources::ResourceId)> success, std::function<void(const Resources::ResourceId)> failed);
 
-    /// begin updating a resources lod
-    void SetMinLod(const Resources::ResourceId& id, const float lod, bool immediate);
+    /// begin updating a resources lod, the priority is used for the load if it is async
+    void SetMinLod(const Resources::ResourceId& id, const float lod, bool immediate, float priority = 0.0f);
+    /// priority of loads requested as immediate after they have already been queued
+    static constexpr float ImmediateLoadPriority = FLT_MAX;
+    /// set the load priority of a pending resource, higher priorities are loaded first
+    void SetLoadPriority(const Resources::ResourceId& id, float priority);
+    /// report that a resource is used this frame at a LOD, thread safe
+    void ReportUsage(const Resources::ResourceId& id, float lod);
 
     /// struct for pending resources which are about to be loaded
     struct _PendingResourceLoad
@@ -122,9 +129,10 @@ public:
         bool reload;
         IndexT frame;
         float lod;
+        float priority;
         LoadFlags flags;
 
-        _PendingResourceLoad() : entry(-1) {};
+        _PendingResourceLoad() : entry(-1), priority(0.0f) {};
     };
 
     struct _LoadMetaData
@@ -174,6 +182,9 @@ public:
         _LoadMetaData metadata;
         bool immediate;
         float lod;
+        float priority;
+        /// time the job was first handed to the scheduler, negative if not yet
+        Timing::Time submitTime;
         IndexT frameIndex;
         LoadFlags flags;
 
@@ -189,6 +200,8 @@ public:
             job.tag = load.tag.Value();
             job.immediate = load.immediate;
             job.lod = load.lod;
+            job.priority = load.priority;
+            job.submitTime = -1.0;
             job.frameIndex = frameIndex;
             job.flags = load.flags;
             return job;
@@ -215,6 +228,8 @@ public:
 
 protected:
     friend class ResourceServer;
+    friend class ResourceLoadScheduler;
+    friend class ResidencyManager;
     
     friend void ApplyLoadOutput(ResourceLoader* loader, const ResourceLoader::ResourceLoadOutput& output);
     friend void DispatchJob(ResourceLoader* loader, const ResourceLoader::ResourceLoadJob& job);
@@ -228,9 +243,10 @@ protected:
     {
         Resources::ResourceId id;
         float lod;
+        float priority;
         bool immediate;
 
-        _PendingStreamLod() : id(ResourceId::Invalid()) {};
+        _PendingStreamLod() : id(ResourceId::Invalid()), priority(0.0f) {};
     };
 
     struct _PendingResourceUnload
@@ -238,6 +254,22 @@ protected:
         Resources::ResourceId resourceId;
     };
 
+    /// usage reported for a resource, applied by the residency manager
+    struct _UsageFeedback
+    {
+        Resources::ResourceId id;
+        float lod;
+    };
+
+    /// residency tracking of a resource
+    struct _Residency
+    {
+        uint64 bytes;           // memory used by the loaded bits
+        uint bits;              // loaded bits the size was computed for
+        IndexT lastUsedFrame;   // last frame the resource was reported used, InvalidIndex if never
+        float usedLod;          // finest LOD the resource was used with in that frame
+    };
+
     /// callback functions to run when an associated resource is loaded (can be stacked)
     struct _Callbacks
     {
@@ -259,6 +291,8 @@ protected:
     virtual uint LodMask(const _StreamData& stream, float lod, bool async) const;
     /// Set lod factor for resource
     virtual void RequestLOD(const Ids::Id32 entry, float lod) const;
+    /// get the memory allocated for a resource with the loaded bits, bits go from least to most detailed, resources without a size are not managed by the residency manager
+    virtual uint64 ResidentBytes(const _StreamData& stream, uint loadedBits) const;
 
     /// unload resource (overload to implement resource deallocation)
     virtual void Unload(const Resources::ResourceId id) = 0;
@@ -272,7 +306,7 @@ protected:
     void RunCallbacks(Resource::State status, const Resources::ResourceId id);
 
     /// Issue async job
-    void EnqueueJob(const std::function<void()>& func);
+    void EnqueueJob(const ResourceLoadJob& job, const std::function<void()>& func);
 
     struct _PlaceholderResource
     {
@@ -292,16 +326,16 @@ protected:
     Resources::ResourceId failResourceId;
 
     bool async;
-
-    Ptr<ResourceLoaderThread> streamerThread;
-    std::function<void()> preJobFunc;
-    std::function<void()> postJobFunc;
-    Util::StringAtom streamerThreadName;
+    /// max number of async jobs of this loader that may run at the same time, raise only if the loader is thread safe
+    SizeT maxConcurrentJobs;
+    /// load the dependency manifest of new resources and prefetch everything listed in it
+    bool prefetchDependencies;
 
     Util::Array<IndexT> pendingLoads;
     Util::Array<_PendingResourceUnload> pendingUnloads;
     Util::Array<_PendingStreamLod> pendingStreamLods;
     Threading::SafeQueue<_PendingStreamLod> pendingStreamQueue;
+    Threading::SafeQueue<_UsageFeedback> usageQueue;
 
     Threading::SafeQueue<ResourceLoadOutput> loadOutputs;
     Util::Array<ResourceLoadJob> dependentJobs;
@@ -319,6 +353,7 @@ protected:
     Util::FixedArray<_PendingResourceLoad> loads;
     Util::FixedArray<_LoadMetaData> metaData;
     Util::FixedArray<_StreamData> streamDatas;
+    Util::FixedArray<_Residency> residency;
     uint32_t uniqueResourceId;
 
     /// id in resource manager
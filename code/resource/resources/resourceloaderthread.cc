@@ -5,6 +5,7 @@
 #include "foundation/stdneb.h"
 #include "io/ioserver.h"
 #include "resourceloaderthread.h"
+#include "resourceloadscheduler.h"
 #include "profiling/profiling.h"
 
 namespace Resources
@@ -15,8 +16,7 @@ __ImplementClass(Resources::ResourceLoaderThread, 'RETH', Threading::Thread);
 /**
 */
 ResourceLoaderThread::ResourceLoaderThread()
-    : completeEvent(true)
-    
+    : scheduler(nullptr)
 {
     // empty
 }
@@ -40,24 +40,20 @@ ResourceLoaderThread::DoWork()
 {
     this->ioServer = IO::IoServer::Create();
     Profiling::ProfilingRegisterThread();
-    Util::Array<std::function<void()>> arr;
-    arr.Reserve(1000);
+    ResourceLoadScheduler::Job job;
     while (!this->ThreadStopRequested())
     {
-        this->completeEvent.Reset();
-
-        this->jobs.DequeueAll(arr);
-        for (IndexT i = 0; i < arr.Size(); i++)
+        if (this->scheduler->Dequeue(job))
         {
-            arr[i]();
+            job.func();
+            this->scheduler->Finish(job);
+            job.func = nullptr;
+        }
+        else
+        {
+            // wait for more jobs!
+            this->scheduler->WaitForWork();
         }
-        arr.Reset();
-
-        // signal that this batch is complete
-        this->completeEvent.Signal();
-
-        // wait for more jobs!
-        this->jobs.Wait();
     }
 
     this->ioServer = nullptr;
@@ -69,16 +65,7 @@ ResourceLoaderThread::DoWork()
 void
 ResourceLoaderThread::EmitWakeupSignal()
 {
-    this->jobs.Signal();
-}
-
-//------------------------------------------------------------------------------
-/**
-*/
-void
-ResourceLoaderThread::Wait()
-{
-    this->completeEvent.Wait();
+    this->scheduler->Signal();
 }
 
 } // namespace Resources
@@ -1,15 +1,14 @@
 #pragma once
 //------------------------------------------------------------------------------
 /**
-    The resource loader thread is responsible to handle all ResourceLoaders that wish to load resources asynchronously
+    A resource loader thread runs the asynchronous jobs of all resource loaders,
+    as picked by the Resources::ResourceLoadScheduler it belongs to.
     
     @copyright
     (C) 2017-2020 Individual contributors, see AUTHORS file
 */
 //------------------------------------------------------------------------------
 #include "threading/thread.h"
-#include "threading/safequeue.h"
-#include <functional>
 #include "resourceid.h"
 
 namespace IO
@@ -19,6 +18,7 @@ class IoServer;
 
 namespace Resources
 {
+class ResourceLoadScheduler;
 class ResourceLoaderThread : public Threading::Thread
 {
     __DeclareClass(ResourceLoaderThread);
@@ -28,19 +28,15 @@ public:
     /// destructor
     virtual ~ResourceLoaderThread();
 
-    /// wait for the thread to be done (must be called from outside this thread!)
-    void Wait();
-
 private:
-    friend class ResourceLoader;
+    friend class ResourceLoadScheduler;
 
     /// perform work
     void DoWork() override;
     /// emit wakeup signal
     virtual void EmitWakeupSignal() override;
 
-    Threading::SafeQueue<std::function<void()>> jobs;
-    Threading::Event completeEvent;
+    ResourceLoadScheduler* scheduler;
     Ptr<IO::IoServer> ioServer;
 };
 } // namespace Resources
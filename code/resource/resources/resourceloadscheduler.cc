@@ -0,0 +1,324 @@
+//------------------------------------------------------------------------------
+// resourceloadscheduler.cc
+// (C)2024 Individual contributors, see AUTHORS file
+//------------------------------------------------------------------------------
+#include "foundation/stdneb.h"
+#include "resourceloadscheduler.h"
+#include "resourceloaderthread.h"
+#include "resourceloader.h"
+#include "timing/time.h"
+#include "profiling/profiling.h"
+
+N_DECLARE_COUNTER(N_RESOURCE_LOADS_QUEUED, Resource Loads Queued);
+N_DECLARE_COUNTER(N_RESOURCE_LOADS_RUNNING, Resource Loads Running);
+N_DECLARE_COUNTER(N_RESOURCE_LOAD_TIME_TO_READY, Resource Load Max Time To Ready (ms));
+
+namespace Resources
+{
+
+__ImplementClass(Resources::ResourceLoadScheduler, 'RLSC', Core::RefCounted);
+//------------------------------------------------------------------------------
+/**
+*/
+ResourceLoadScheduler::ResourceLoadScheduler()
+    : sequence(0)
+    , numRunning(0)
+    , frameMaxTimeToReady(0)
+    , shuttingDown(false)
+    , idleEvent(true)
+{
+    // the loader index of a resource id is 8 bits
+    this->stats.Resize(256);
+    this->idleEvent.Signal();
+}
+
+//------------------------------------------------------------------------------
+/**
+*/
+ResourceLoadScheduler::~ResourceLoadScheduler()
+{
+    n_assert(this->threads.IsEmpty());
+}
+
+//------------------------------------------------------------------------------
+/**
+*/
+void
+ResourceLoadScheduler::Setup(SizeT numThreads)
+{
+    n_assert(this->threads.IsEmpty());
+    n_assert(numThreads > 0);
+    this->timer.Reset();
+    this->timer.Start();
+
+    for (IndexT i = 0; i < numThreads; i++)
+    {
+        Ptr<ResourceLoaderThread> thread = ResourceLoaderThread::Create();
+        thread->scheduler = this;
+        thread->SetName(Util::String::Sprintf("Resource Loader Thread #%d", i));
+        thread->Start();
+        this->threads.Append(thread);
+    }
+
+    N_BUDGET_COUNTER_SETUP(N_RESOURCE_LOADS_QUEUED, MaxQueuedJobsBudget);
+    N_BUDGET_COUNTER_SETUP(N_RESOURCE_LOADS_RUNNING, numThreads);
+    N_BUDGET_COUNTER_SETUP(N_RESOURCE_LOAD_TIME_TO_READY, MaxTimeToReadyBudget);
+}
+
+//------------------------------------------------------------------------------
+/**
+*/
+void
+ResourceLoadScheduler::Discard()
+{
+    this->lock.Enter();
+    this->queue.Clear();
+    this->shuttingDown = true;
+    this->lock.Leave();
+    this->Signal();
+
+    for (IndexT i = 0; i < this->threads.Size(); i++)
+    {
+        this->threads[i]->Stop();
+    }
+    this->threads.Clear();
+    this->shuttingDown = false;
+    this->timer.Stop();
+}
+
+//------------------------------------------------------------------------------
+/**
+    Jobs with no loader, such as reading the dependency manifests of the
+    ResourceServer, are not limited and not counted in the statistics.
+*/
+void
+ResourceLoadScheduler::Enqueue(ResourceLoader* loader, Ids::Id32 entry, float priority, const std::function<void()>& func)
+{
+    Job job;
+    job.loader = loader;
+    job.entry = entry;
+    job.priority = priority;
+    job.func = func;
+
+    this->lock.Enter();
+    job.sequence = this->sequence++;
+    this->queue.Append(job);
+    if (loader != nullptr)
+        this->stats[loader->GetUniqueId()].queueDepth++;
+    this->idleEvent.Reset();
+    this->lock.Leave();
+
+    this->Signal();
+}
+
+//------------------------------------------------------------------------------
+/**
+*/
+void
+ResourceLoadScheduler::SetPriority(ResourceLoader* loader, Ids::Id32 entry, float priority)
+{
+    this->lock.Enter();
+    for (IndexT i = 0; i < this->queue.Size(); i++)
+    {
+        Job& job = this->queue[i];
+        if (job.loader == loader && job.entry == entry)
+            job.priority = priority;
+    }
+    this->lock.Leave();
+}
+
+//------------------------------------------------------------------------------
+/**
+*/
+void
+ResourceLoadScheduler::Cancel(ResourceLoader* loader)
+{
+    Stats& stats = this->stats[loader->GetUniqueId()];
+
+    this->lock.Enter();
+    for (IndexT i = this->queue.Size() - 1; i >= 0; i--)
+    {
+        if (this->queue[i].loader == loader)
+        {
+            this->queue.EraseIndex(i);
+            stats.queueDepth--;
+        }
+    }
+    if (this->queue.IsEmpty() && this->numRunning == 0)
+        this->idleEvent.Signal();
+    this->lock.Leave();
+
+    // jobs that are already running can't be interrupted
+    while (true)
+    {
+        this->lock.Enter();
+        SizeT const numRunning = stats.numRunning;
+        this->lock.Leave();
+        if (numRunning == 0)
+            break;
+        Timing::Sleep(0.001);
+    }
+}
+
+//------------------------------------------------------------------------------
+/**
+*/
+void
+ResourceLoadScheduler::Wait()
+{
+    this->idleEvent.Wait();
+}
+
+//------------------------------------------------------------------------------
+/**
+*/
+Timing::Time
+ResourceLoadScheduler::GetTime() const
+{
+    return this->timer.GetTime();
+}
+
+//------------------------------------------------------------------------------
+/**
+*/
+void
+ResourceLoadScheduler::RecordReady(ResourceLoader* loader, Timing::Time submitTime)
+{
+    Timing::Time const timeToReady = this->GetTime() - submitTime;
+
+    this->lock.Enter();
+    Stats& stats = this->stats[loader->GetUniqueId()];
+    stats.numReady++;
+    stats.totalTimeToReady += timeToReady;
+    stats.maxTimeToReady = Math::max(stats.maxTimeToReady, timeToReady);
+    this->frameMaxTimeToReady = Math::max(this->frameMaxTimeToReady, timeToReady);
+    this->lock.Leave();
+}
+
+//------------------------------------------------------------------------------
+/**
+*/
+ResourceLoadScheduler::Stats
+ResourceLoadScheduler::GetStats(ResourceLoader* loader)
+{
+    this->lock.Enter();
+    Stats stats = this->stats[loader->GetUniqueId()];
+    this->lock.Leave();
+    return stats;
+}
+
+//------------------------------------------------------------------------------
+/**
+*/
+void
+ResourceLoadScheduler::UpdateCounters()
+{
+    SizeT queueDepth = 0;
+    SizeT numRunning = 0;
+    this->lock.Enter();
+    for (IndexT i = 0; i < this->stats.Size(); i++)
+    {
+        queueDepth += this->stats[i].queueDepth;
+        numRunning += this->stats[i].numRunning;
+    }
+    Timing::Time const maxTimeToReady = this->frameMaxTimeToReady;
+    this->frameMaxTimeToReady = 0;
+    this->lock.Leave();
+
+    N_BUDGET_COUNTER_RESET(N_RESOURCE_LOADS_QUEUED);
+    N_BUDGET_COUNTER_INCR(N_RESOURCE_LOADS_QUEUED, queueDepth);
+    N_BUDGET_COUNTER_RESET(N_RESOURCE_LOADS_RUNNING);
+    N_BUDGET_COUNTER_INCR(N_RESOURCE_LOADS_RUNNING, numRunning);
+    N_BUDGET_COUNTER_RESET(N_RESOURCE_LOAD_TIME_TO_READY);
+    N_BUDGET_COUNTER_INCR(N_RESOURCE_LOAD_TIME_TO_READY, (uint64)(maxTimeToReady * 1000.0));
+}
+
+//------------------------------------------------------------------------------
+/**
+    Linear search, since the priority of queued jobs can change at any time,
+    and jobs of loaders that are already running at their limit have to be skipped.
+*/
+bool
+ResourceLoadScheduler::Dequeue(Job& job)
+{
+    this->lock.Enter();
+    IndexT best = InvalidIndex;
+    for (IndexT i = 0; i < this->queue.Size(); i++)
+    {
+        Job const& candidate = this->queue[i];
+        if (candidate.loader != nullptr && this->stats[candidate.loader->GetUniqueId()].numRunning >= candidate.loader->maxConcurrentJobs)
+            continue;
+
+        if (best == InvalidIndex || candidate.priority > this->queue[best].priority ||
+            (candidate.priority == this->queue[best].priority && candidate.sequence < this->queue[best].sequence))
+        {
+            best = i;
+        }
+    }
+
+    if (best != InvalidIndex)
+    {
+        job = std::move(this->queue[best]);
+        this->queue.EraseIndex(best);
+
+        if (job.loader != nullptr)
+        {
+            Stats& stats = this->stats[job.loader->GetUniqueId()];
+            stats.queueDepth--;
+            stats.numRunning++;
+        }
+        this->numRunning++;
+    }
+    bool const moreWork = !this->queue.IsEmpty();
+    this->lock.Leave();
+
+    // pass the wakeup on to the next thread, in case several jobs were queued at once
+    if (best != InvalidIndex && moreWork)
+        this->Signal();
+    return best != InvalidIndex;
+}
+
+//------------------------------------------------------------------------------
+/**
+*/
+void
+ResourceLoadScheduler::Finish(Job const& job)
+{
+    this->lock.Enter();
+    if (job.loader != nullptr)
+        this->stats[job.loader->GetUniqueId()].numRunning--;
+    this->numRunning--;
+    bool const idle = this->queue.IsEmpty() && this->numRunning == 0;
+    if (idle)
+        this->idleEvent.Signal();
+    this->lock.Leave();
+
+    // the loader has room for another job, which might be waiting
+    if (!idle)
+        this->Signal();
+}
+
+//------------------------------------------------------------------------------
+/**
+*/
+void
+ResourceLoadScheduler::WaitForWork()
+{
+    if (!this->shuttingDown)
+        this->workEvent.Wait();
+
+    // wake up the next thread, so that all threads get to see their stop request
+    if (this->shuttingDown)
+        this->Signal();
+}
+
+//------------------------------------------------------------------------------
+/**
+*/
+void
+ResourceLoadScheduler::Signal()
+{
+    this->workEvent.Signal();
+}
+
+} // namespace Resources
@@ -0,0 +1,136 @@
+#pragma once
+//------------------------------------------------------------------------------
+/**
+    @class Resources::ResourceLoadScheduler
+
+    Schedules the asynchronous jobs of all resource loaders on a shared pool of
+    loader threads. Each thread has its own IoServer, so file reads and resource
+    initialization run in parallel across threads.
+
+    Queued jobs are ordered by priority, highest first, and then by submission order.
+    The priority of a queued job can be changed until a thread picks it up.
+
+    A loader limits how many of its jobs may run at the same time with
+    ResourceLoader::maxConcurrentJobs. Loaders which initialize resources through
+    shared state that is not thread safe, such as command buffer pools, either keep
+    it at one or serialize just the parts that use that state.
+
+    The scheduler keeps statistics per loader, such as the queue depth and the
+    time it takes from a resource being submitted until it is ready. The totals
+    over all loaders are reported to the profiler's budget counters every frame.
+
+    @copyright
+    (C) 2024 Individual contributors, see AUTHORS file
+*/
+//------------------------------------------------------------------------------
+#include "core/refcounted.h"
+#include "threading/criticalsection.h"
+#include "threading/event.h"
+#include "timing/timer.h"
+#include "resourceid.h"
+#include <functional>
+
+namespace Resources
+{
+
+class ResourceLoader;
+class ResourceLoaderThread;
+class ResourceLoadScheduler : public Core::RefCounted
+{
+    __DeclareClass(ResourceLoadScheduler);
+public:
+    /// constructor
+    ResourceLoadScheduler();
+    /// destructor
+    virtual ~ResourceLoadScheduler();
+
+    /// start the loader threads
+    void Setup(SizeT numThreads);
+    /// stop the loader threads, queued jobs are discarded
+    void Discard();
+
+    /// queue a job for a resource, loader may be null for jobs that belong to no loader
+    void Enqueue(ResourceLoader* loader, Ids::Id32 entry, float priority, const std::function<void()>& func);
+    /// change the priority of all queued jobs for a resource
+    void SetPriority(ResourceLoader* loader, Ids::Id32 entry, float priority);
+    /// remove all queued jobs of a loader, and wait for its running jobs to finish
+    void Cancel(ResourceLoader* loader);
+    /// wait until all queued jobs have finished (must be called from outside the loader threads!)
+    void Wait();
+
+    /// get the number of loader threads
+    SizeT GetNumThreads() const;
+    /// get time since the scheduler was set up, used to time stamp jobs
+    Timing::Time GetTime() const;
+    /// record that a resource became ready, for statistics
+    void RecordReady(ResourceLoader* loader, Timing::Time submitTime);
+
+    /// statistics per loader
+    struct Stats
+    {
+        /// number of jobs waiting for a thread
+        SizeT queueDepth = 0;
+        /// number of jobs currently running
+        SizeT numRunning = 0;
+        /// number of resources that have become ready
+        SizeT numReady = 0;
+        /// sum of all times from submission until ready
+        Timing::Time totalTimeToReady = 0;
+        /// longest time from submission until ready
+        Timing::Time maxTimeToReady = 0;
+    };
+    /// get statistics of a loader
+    Stats GetStats(ResourceLoader* loader);
+    /// report the statistics of all loaders to the profiler, call once per frame
+    void UpdateCounters();
+
+private:
+    friend class ResourceLoaderThread;
+
+    /// budget of the queued jobs counter
+    static const SizeT MaxQueuedJobsBudget = 1024;
+    /// budget of the time to ready counter, in milliseconds
+    static const SizeT MaxTimeToReadyBudget = 1000;
+
+    struct Job
+    {
+        ResourceLoader* loader;
+        Ids::Id32 entry;
+        float priority;
+        uint64_t sequence;
+        std::function<void()> func;
+    };
+
+    /// pick the job with the highest priority that its loader has room for, returns false if there is none
+    bool Dequeue(Job& job);
+    /// called by a loader thread when a job has finished
+    void Finish(Job const& job);
+    /// wait for work to be enqueued or finished
+    void WaitForWork();
+    /// wake up a waiting loader thread
+    void Signal();
+
+    Util::Array<Ptr<ResourceLoaderThread>> threads;
+    Util::Array<Job> queue;
+    Util::FixedArray<Stats> stats;
+    uint64_t sequence;
+    SizeT numRunning;
+    /// longest time from submission until ready since the last UpdateCounters
+    Timing::Time frameMaxTimeToReady;
+    volatile bool shuttingDown;
+    Threading::CriticalSection lock;
+    Threading::Event workEvent;
+    Threading::Event idleEvent;
+    Timing::Timer timer;
+};
+
+//------------------------------------------------------------------------------
+/**
+*/
+inline SizeT
+ResourceLoadScheduler::GetNumThreads() const
+{
+    return this->threads.Size();
+}
+
+} // namespace Resources
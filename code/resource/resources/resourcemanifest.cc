@@ -0,0 +1,115 @@
+//------------------------------------------------------------------------------
+// resourcemanifest.cc
+// (C)2024 Individual contributors, see AUTHORS file
+//------------------------------------------------------------------------------
+#include "foundation/stdneb.h"
+#include "resourcemanifest.h"
+#include "io/ioserver.h"
+#include "io/binaryreader.h"
+#include "io/binarywriter.h"
+
+namespace Resources
+{
+
+static const uint ManifestMagic = 'DEPS';
+static const uint ManifestVersion = 1;
+
+//------------------------------------------------------------------------------
+/**
+*/
+void
+ResourceManifest::Add(const ResourceName& name, uint depth)
+{
+    n_assert(depth > 0);
+    IndexT i = this->lookup.FindIndex(name);
+    if (i == InvalidIndex)
+    {
+        this->lookup.Add(name, this->entries.Size());
+        this->entries.Append({ name, depth });
+    }
+    else
+    {
+        Entry& entry = this->entries[this->lookup.ValueAtIndex(i)];
+        entry.depth = Math::min(entry.depth, depth);
+    }
+}
+
+//------------------------------------------------------------------------------
+/**
+*/
+void
+ResourceManifest::Merge(const ResourceManifest& manifest)
+{
+    for (const Entry& entry : manifest.entries)
+    {
+        this->Add(entry.name, entry.depth + 1);
+    }
+}
+
+//------------------------------------------------------------------------------
+/**
+*/
+bool
+ResourceManifest::Load(const IO::URI& uri)
+{
+    IO::IoServer* ioServer = IO::IoServer::Instance();
+    if (!ioServer->FileExists(uri))
+    {
+        return false;
+    }
+
+    Ptr<IO::BinaryReader> reader = IO::BinaryReader::Create();
+    reader->SetStream(ioServer->CreateStream(uri));
+    if (!reader->Open())
+    {
+        return false;
+    }
+
+    bool valid = reader->ReadUInt() == ManifestMagic && reader->ReadUInt() == ManifestVersion;
+    if (valid)
+    {
+        uint numEntries = reader->ReadUInt();
+        this->entries.Reserve(this->entries.Size() + numEntries);
+        uint i;
+        for (i = 0; i < numEntries && !reader->Eof(); i++)
+        {
+            Util::String name = reader->ReadString();
+            uint depth = reader->ReadUChar();
+            this->Add(name, depth);
+        }
+        valid = i == numEntries;
+    }
+    else
+    {
+        n_warning("ResourceManifest::Load(): '%s' is not a valid manifest!\n", uri.AsString().AsCharPtr());
+    }
+    reader->Close();
+    return valid;
+}
+
+//------------------------------------------------------------------------------
+/**
+*/
+bool
+ResourceManifest::Save(const IO::URI& uri) const
+{
+    Ptr<IO::BinaryWriter> writer = IO::BinaryWriter::Create();
+    writer->SetStream(IO::IoServer::Instance()->CreateStream(uri));
+    if (!writer->Open())
+    {
+        return false;
+    }
+
+    writer->WriteUInt(ManifestMagic);
+    writer->WriteUInt(ManifestVersion);
+    writer->WriteUInt(this->entries.Size());
+    for (const Entry& entry : this->entries)
+    {
+        writer->WriteString(entry.name.AsString());
+        writer->WriteUChar((unsigned char)Math::min(entry.depth, 255u));
+    }
+    writer->Close();
+    return true;
+}
+
+} // namespace Resources
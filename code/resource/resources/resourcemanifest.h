@@ -0,0 +1,87 @@
+#pragma once
+//------------------------------------------------------------------------------
+/**
+    @class Resources::ResourceManifest
+
+    Lists the resources a resource depends on, such as the meshes, materials
+    and textures of a model, or everything referenced by a level. Manifests
+    are written by the asset tools next to the resource they describe, with
+    .deps appended to its name.
+
+    Each entry holds the depth at which the dependency is found, where direct
+    dependencies have depth 1. The ResourceServer uses a manifest to issue all
+    loads of a resource at once, instead of discovering them as each loader
+    parses its parent.
+
+    @see ResourceServer::PrefetchDependencies
+
+    @copyright
+    (C) 2024 Individual contributors, see AUTHORS file
+*/
+//------------------------------------------------------------------------------
+#include "util/array.h"
+#include "util/dictionary.h"
+#include "io/uri.h"
+#include "resourceid.h"
+
+namespace Resources
+{
+class ResourceManifest
+{
+public:
+    struct Entry
+    {
+        ResourceName name;
+        uint depth;
+    };
+
+    /// add a dependency, keeps the lowest depth if it is already listed
+    void Add(const ResourceName& name, uint depth);
+    /// add all entries of another manifest, one level deeper
+    void Merge(const ResourceManifest& manifest);
+    /// get entries
+    const Util::Array<Entry>& GetEntries() const;
+    /// return true if there are no entries
+    bool IsEmpty() const;
+
+    /// load from a file, returns false if it does not exist or is invalid
+    bool Load(const IO::URI& uri);
+    /// save to a file
+    bool Save(const IO::URI& uri) const;
+
+    /// get the path of the manifest describing a resource
+    static IO::URI GetManifestPath(const ResourceName& res);
+
+private:
+    Util::Array<Entry> entries;
+    Util::Dictionary<ResourceName, IndexT> lookup;
+};
+
+//------------------------------------------------------------------------------
+/**
+*/
+inline const Util::Array<ResourceManifest::Entry>&
+ResourceManifest::GetEntries() const
+{
+    return this->entries;
+}
+
+//------------------------------------------------------------------------------
+/**
+*/
+inline bool
+ResourceManifest::IsEmpty() const
+{
+    return this->entries.IsEmpty();
+}
+
+//------------------------------------------------------------------------------
+/**
+*/
+inline IO::URI
+ResourceManifest::GetManifestPath(const ResourceName& res)
+{
+    return IO::URI(res.AsString() + ".deps");
+}
+
+} // namespace Resources
@@ -5,9 +5,11 @@
 #include "foundation/stdneb.h"
 #include "resourceserver.h"
 #include "profiling/profiling.h"
+#include "system/systeminfo.h"
 
 #if NEBULA_DEBUG
 #include "core/sysfunc.h"
+#include "threading/interlocked.h"
 #endif
 namespace Resources
 {
@@ -23,6 +25,7 @@ ResourceServer::ResourceServer()
 {
     __ConstructSingleton;
     this->open = false;
+    this->prefetching = false;
 }
 
 //------------------------------------------------------------------------------
@@ -42,6 +45,12 @@ ResourceServer::Open()
 {
     n_assert(!this->open);
     this->loaders.Reserve(256); // lower 8 bits of resource id can only get to 256
+
+    // a few threads is enough to keep the disk busy, the rest are left to the job system
+    this->scheduler = ResourceLoadScheduler::Create();
+    this->scheduler->Setup(Math::clamp(System::NumCpuCores / 2, 1, 4));
+    this->residencyManager = ResidencyManager::Create();
+
     this->open = true;
     UniquePoolCounter = 0;
 }
@@ -85,6 +94,19 @@ ResourceServer::Close()
     }
 
 #endif
+    // stop the loader threads before the loaders and prefetches their jobs refer to
+    this->scheduler->Discard();
+    this->scheduler = nullptr;
+    this->residencyManager = nullptr;
+
+    // release the references held by unfinished prefetches
+    for (_Prefetch* prefetch : this->prefetches)
+    {
+        this->ReleasePrefetchReferences(prefetch);
+        n_delete(prefetch);
+    }
+    this->prefetches.Clear();
+
     this->loaders.Clear();
     this->extensionMap.Clear();
     this->open = false;
@@ -166,6 +188,180 @@ ResourceServer::Update(IndexT frameIndex)
         const Ptr<ResourceLoader>& loader = this->loaders[i];
         loader->Update(frameIndex);
     }
+    this->UpdatePrefetches();
+    this->residencyManager->Update(this->loaders, frameIndex);
+    this->scheduler->UpdateCounters();
+}
+
+//------------------------------------------------------------------------------
+/**
+    Reads the dependency manifest of a resource on a loader thread, and once
+    it has been read, creates all resources listed in it on the next Update,
+    rather than waiting for each loader to discover them while parsing its
+    parent. Dependencies closer to the resource get higher priorities, so a
+    model is set up before its meshes and materials, and those before their
+    textures. Dependencies with no registered loader are skipped.
+
+    The prefetch holds a reference to each dependency, and to the resource
+    itself if it has a loader, until the resource and all dependencies have
+    left the pending state. By then the resource holds its own references, so
+    no dependency drops to zero usage in between and gets loaded twice.
+    Resources without a loader, such as levels, are not tracked, and the
+    references are held until ReleasePrefetch is called for them.
+
+    Returns false if called while the dependencies of another manifest are
+    being created, since that manifest already lists them.
+*/
+bool
+ResourceServer::PrefetchDependencies(const ResourceName& res, const Util::StringAtom& tag, float priority)
+{
+    N_SCOPE(PrefetchDependencies, Resources);
+    n_assert(this->open);
+    if (this->prefetching)
+    {
+        // already part of a manifest being prefetched
+        return false;
+    }
+
+    _Prefetch* prefetch = n_new(_Prefetch);
+    prefetch->res = res;
+    prefetch->tag = tag;
+    prefetch->priority = priority;
+
+    IndexT i = this->extensionMap.FindIndex(res.AsString().GetFileExtension());
+    if (i != InvalidIndex)
+    {
+        const Ptr<ResourceLoader>& loader = this->loaders[this->extensionMap.ValueAtIndex(i)];
+        IndexT j = loader->ids.FindIndex(IO::URI(res.Value()).GetHostAndLocalPath());
+        if (j != InvalidIndex)
+        {
+            // take a reference of our own, so the id can't be reused before the resource has loaded
+            Ids::Id32 const entry = loader->ids.ValueAtIndex(j);
+            loader->usage[entry]++;
+            prefetch->root = loader->resources[entry];
+            prefetch->hasRoot = true;
+        }
+    }
+    this->prefetches.Append(prefetch);
+
+    // read the manifest before the resource itself, the prefetch outlives the job
+    this->scheduler->Enqueue(nullptr, 0, priority + 1.0f, [prefetch]()
+    {
+        bool const found = prefetch->manifest.Load(ResourceManifest::GetManifestPath(prefetch->res));
+        Threading::Interlocked::Exchange(&prefetch->state, found ? _Prefetch::ManifestRead : _Prefetch::NoManifest);
+    });
+    return true;
+}
+
+//------------------------------------------------------------------------------
+/**
+    Releases the references a prefetch holds for a resource without a loader,
+    call once the resource holds its own references to its dependencies, for
+    example when a level has been instantiated. Does nothing if there is no
+    such prefetch, so it is safe to call more than once.
+*/
+void
+ResourceServer::ReleasePrefetch(const ResourceName& res)
+{
+    for (_Prefetch* prefetch : this->prefetches)
+    {
+        if (!prefetch->hasRoot && !prefetch->released && prefetch->res == res)
+        {
+            prefetch->released = true;
+            break;
+        }
+    }
+}
+
+//------------------------------------------------------------------------------
+/**
+*/
+void
+ResourceServer::ReleasePrefetchReferences(_Prefetch* prefetch)
+{
+    for (const ResourceId& id : prefetch->ids)
+    {
+        this->DiscardResource(id);
+    }
+    prefetch->ids.Clear();
+    if (prefetch->hasRoot)
+    {
+        this->DiscardResource(prefetch->root);
+        prefetch->hasRoot = false;
+    }
+}
+
+//------------------------------------------------------------------------------
+/**
+    Creates the dependencies of prefetches whose manifest has been read, and
+    releases prefetches once the resources they were made for are done with them.
+*/
+void
+ResourceServer::UpdatePrefetches()
+{
+    IndexT i;
+    for (i = 0; i < this->prefetches.Size();)
+    {
+        _Prefetch* prefetch = this->prefetches[i];
+        if (prefetch->state == _Prefetch::Reading)
+        {
+            i++;
+            continue;
+        }
+
+        if (prefetch->state == _Prefetch::ManifestRead && !prefetch->released)
+        {
+            prefetch->state = _Prefetch::Created;
+            prefetch->ids.Reserve(prefetch->manifest.GetEntries().Size());
+
+            // dependencies must not trigger prefetches of their own, the manifest already lists them
+            this->prefetching = true;
+            for (const ResourceManifest::Entry& entry : prefetch->manifest.GetEntries())
+            {
+                IndexT j = this->extensionMap.FindIndex(entry.name.AsString().GetFileExtension());
+                if (j == InvalidIndex)
+                {
+                    continue;
+                }
+                const Ptr<ResourceLoader>& loader = this->loaders[this->extensionMap.ValueAtIndex(j)];
+                ResourceId id = loader->CreateResource(entry.name, nullptr, 0, prefetch->tag, nullptr, nullptr, false, true);
+                if (loader->GetState(id) == Resource::Pending)
+                {
+                    loader->SetLoadPriority(id, prefetch->priority - (float)entry.depth);
+                }
+                prefetch->ids.Append(id);
+            }
+            this->prefetching = false;
+        }
+
+        bool done;
+        if (prefetch->hasRoot)
+        {
+            // the resource holds its own references once it has loaded, and so do the dependencies
+            done = this->loaders[prefetch->root.loaderIndex]->GetState(prefetch->root) != Resource::Pending;
+            for (IndexT j = 0; done && j < prefetch->ids.Size(); j++)
+            {
+                const ResourceId& id = prefetch->ids[j];
+                done = this->loaders[id.loaderIndex]->GetState(id) != Resource::Pending;
+            }
+        }
+        else
+        {
+            // without a manifest nothing is held, otherwise wait for ReleasePrefetch
+            done = prefetch->released || prefetch->state == _Prefetch::NoManifest;
+        }
+
+        if (done)
+        {
+            this->ReleasePrefetchReferences(prefetch);
+            n_delete(prefetch);
+            this->prefetches.EraseIndexSwap(i);
+        }
+        else
+        {
+            i++;
+        }
+    }
 }
 
 //------------------------------------------------------------------------------
@@ -223,10 +419,7 @@ ResourceServer::GetType(const Resources::ResourceId id)
 void 
 ResourceServer::WaitForLoaderThread()
 {
-    for (const Ptr<ResourceLoader>& loader : this->loaders)
-    {
-        loader->streamerThread->Wait();
-    }
+    this->scheduler->Wait();
 }
 
 } // namespace Resources
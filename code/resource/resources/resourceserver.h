@@ -15,7 +15,10 @@
 #include "core/singleton.h"
 #include "resourceid.h"
 #include "resourceloader.h"
-#include "resourceloaderthread.h"
+#include "resourceloadscheduler.h"
+#include "residencymanager.h"
+#include "resourcemanifest.h"
+#include "threading/interlocked.h"
 namespace Resources
 {
 class ResourceServer : public Core::RefCounted
@@ -52,8 +55,16 @@ public:
     bool HasPendingResources();
     /// reload resource
     void ReloadResource(const ResourceName& res, std::function<void(const Resources::ResourceId)> success = nullptr, std::function<void(const Resources::ResourceId)> failed = nullptr);
-    /// stream in a new LOD
-    void SetMinLod(const ResourceId& id, float lod, bool immediate);
+    /// stream in a new LOD, higher priorities are loaded first
+    void SetMinLod(const ResourceId& id, float lod, bool immediate, float priority = 0.0f);
+    /// set the load priority of a pending resource, higher priorities are loaded first
+    void SetLoadPriority(const ResourceId& id, float priority);
+    /// report that a resource is used this frame at a LOD, thread safe
+    void ReportUsage(const ResourceId& id, float lod);
+    /// read the manifest of a resource asynchronously and issue loads for all dependencies listed in it
+    bool PrefetchDependencies(const ResourceName& res, const Util::StringAtom& tag, float priority = 0.0f);
+    /// release the dependencies prefetched for a resource without a loader, once it holds its own references
+    void ReleasePrefetch(const ResourceName& res);
     /// Create single-fire listener for resource. When resource is loaded, the callbacks will be invoked and the listener is destroyed
     void CreateResourceListener(const ResourceId& id, std::function<void(const Resources::ResourceId)> success, std::function<void(const Resources::ResourceId)> failed = nullptr);
 
@@ -82,16 +93,53 @@ public:
 
     /// Wait for all loader threads
     void WaitForLoaderThread();
+    /// get the scheduler which runs the asynchronous jobs of all loaders
+    const Ptr<ResourceLoadScheduler>& GetLoadScheduler() const;
+    /// get the residency manager which keeps streamed resources within the memory budget
+    const Ptr<ResidencyManager>& GetResidencyManager() const;
 
     /// goes through all pools and sets up their default resources
     void LoadDefaultResources();
 private:
     friend class ResourceLoader;
 
+    struct _Prefetch
+    {
+        enum State
+        {
+            Reading,        // manifest is being read on a loader thread
+            ManifestRead,   // dependencies can be created
+            NoManifest,     // the resource has no manifest
+            Created         // dependencies have been created
+        };
+
+        ResourceName res;
+        Util::StringAtom tag;
+        float priority = 0.0f;
+        /// the resource the manifest belongs to, only set if it has a loader
+        ResourceId root;
+        bool hasRoot = false;
+        /// set by ReleasePrefetch
+        bool released = false;
+        Threading::AtomicCounter state = Reading;
+        /// written by the loader thread until state leaves Reading
+        ResourceManifest manifest;
+        Util::Array<ResourceId> ids;
+    };
+
+    /// create the dependencies of read manifests, and release prefetches which are done
+    void UpdatePrefetches();
+    /// discard all references held by a prefetch
+    void ReleasePrefetchReferences(_Prefetch* prefetch);
+
     bool open;
+    bool prefetching;
+    Util::Array<_Prefetch*> prefetches;
     Util::Dictionary<Util::StringAtom, IndexT> extensionMap;
     Util::Dictionary<const Core::Rtti*, IndexT> typeMap;
     Util::Array<Ptr<ResourceLoader>> loaders;
+    Ptr<ResourceLoadScheduler> scheduler;
+    Ptr<ResidencyManager> residencyManager;
 
     static int32_t UniquePoolCounter;
 };
@@ -202,7 +250,7 @@ ResourceServer::ReloadResource(const ResourceName& res, std::function<void(const
 /**
 */
 inline void 
-ResourceServer::SetMinLod(const ResourceId& id, float lod, bool immediate)
+ResourceServer::SetMinLod(const ResourceId& id, float lod, bool immediate, float priority)
 {
     // get id of loader
     const Ids::Id8 loaderid = id.loaderIndex;
@@ -212,7 +260,55 @@ ResourceServer::SetMinLod(const ResourceId& id, float lod, bool immediate)
     const Ptr<ResourceLoader>& loader = this->loaders[loaderid].downcast<ResourceLoader>();
 
     // update LOD
-    loader->SetMinLod(id, lod, immediate);
+    loader->SetMinLod(id, lod, immediate, priority);
+}
+
+//------------------------------------------------------------------------------
+/**
+*/
+inline void
+ResourceServer::SetLoadPriority(const ResourceId& id, float priority)
+{
+    // get id of loader
+    const Ids::Id8 loaderid = id.loaderIndex;
+
+    // get resource loader by extension
+    n_assert(this->loaders.Size() > loaderid);
+    const Ptr<ResourceLoader>& loader = this->loaders[loaderid].downcast<ResourceLoader>();
+    loader->SetLoadPriority(id, priority);
+}
+
+//------------------------------------------------------------------------------
+/**
+*/
+inline void
+ResourceServer::ReportUsage(const ResourceId& id, float lod)
+{
+    // get id of loader
+    const Ids::Id8 loaderid = id.loaderIndex;
+
+    // get resource loader by extension
+    n_assert(this->loaders.Size() > loaderid);
+    const Ptr<ResourceLoader>& loader = this->loaders[loaderid].downcast<ResourceLoader>();
+    loader->ReportUsage(id, lod);
+}
+
+//------------------------------------------------------------------------------
+/**
+*/
+inline const Ptr<ResourceLoadScheduler>&
+ResourceServer::GetLoadScheduler() const
+{
+    return this->scheduler;
+}
+
+//------------------------------------------------------------------------------
+/**
+*/
+inline const Ptr<ResidencyManager>&
+ResourceServer::GetResidencyManager() const
+{
+    return this->residencyManager;
 }
 
 //------------------------------------------------------------------------------
@@ -399,9 +495,27 @@ CreateResourceListener(
 /**
 */
 inline void
-SetMinLod(const ResourceId& id, float lod, bool immediate)
+SetMinLod(const ResourceId& id, float lod, bool immediate, float priority = 0.0f)
+{
+    return ResourceServer::Instance()->SetMinLod(id, lod, immediate, priority);
+}
+
+//------------------------------------------------------------------------------
+/**
+*/
+inline void
+ReportUsage(const ResourceId& id, float lod)
+{
+    return ResourceServer::Instance()->ReportUsage(id, lod);
+}
+
+//------------------------------------------------------------------------------
+/**
+*/
+inline void
+SetLoadPriority(const ResourceId& id, float priority)
 {
-    return ResourceServer::Instance()->SetMinLod(id, lod, immediate);
+    return ResourceServer::Instance()->SetLoadPriority(id, priority);
 }
 
 //------------------------------------------------------------------------------
@@ -0,0 +1,273 @@
+//------------------------------------------------------------------------------
+//  archivebenchmark.cc
+//  (C) 2024 Individual contributors, see AUTHORS file
+//------------------------------------------------------------------------------
+#include "stdneb.h"
+#include "archivebenchmark.h"
+#include "io/ioserver.h"
+#include "io/assignregistry.h"
+#include "io/archfs/archivefilesystem.h"
+#include "io/zipfs/ziparchive.h"
+#include "io/packfs/packwriter.h"
+#include "threading/thread.h"
+
+namespace Benchmarking
+{
+__ImplementClass(Benchmarking::ArchiveBenchmark, 'ARBM', Benchmarking::Benchmark);
+
+using namespace Util;
+using namespace IO;
+using namespace Timing;
+
+static const SizeT NumThreads = 8;
+static const SizeT NumLoops = 4;
+
+//------------------------------------------------------------------------------
+/**
+    Reads its share of the files completely, NumLoops times.
+*/
+class ArchiveReaderThread : public Threading::Thread
+{
+    __DeclareClass(ArchiveReaderThread);
+public:
+    /// constructor
+    ArchiveReaderThread() : bytesRead(0) {};
+    /// set the files to read
+    void Setup(const Array<URI>& files_)
+    {
+        this->files = files_;
+        this->bytesRead = 0;
+    };
+    /// get the number of bytes read by the last run
+    int64_t GetBytesRead() const
+    {
+        return this->bytesRead;
+    };
+
+protected:
+    /// worker method
+    virtual void DoWork();
+
+private:
+    Array<URI> files;
+    int64_t bytesRead;
+};
+__ImplementClass(Benchmarking::ArchiveReaderThread, 'ARBT', Threading::Thread);
+
+//------------------------------------------------------------------------------
+/**
+*/
+void
+ArchiveReaderThread::DoWork()
+{
+    // each thread needs its own IoServer
+    Ptr<IoServer> ioServer = IoServer::Create();
+
+    IndexT loopIndex;
+    for (loopIndex = 0; loopIndex < NumLoops; loopIndex++)
+    {
+        IndexT i;
+        for (i = 0; i < this->files.Size(); i++)
+        {
+            Ptr<Stream> stream = ioServer->CreateStream(this->files[i]);
+            stream->SetAccessMode(Stream::ReadAccess);
+            if (stream->Open())
+            {
+                SizeT fileSize = stream->GetSize();
+                if (fileSize > 0)
+                {
+                    void* buf = Memory::Alloc(Memory::DefaultHeap, fileSize);
+                    SizeT readSize = stream->Read(buf, fileSize);
+                    n_assert(readSize == fileSize);
+                    Memory::Free(Memory::DefaultHeap, buf);
+                }
+                this->bytesRead += fileSize;
+                stream->Close();
+            }
+        }
+    }
+}
+
+//------------------------------------------------------------------------------
+/**
+*/
+static void
+CollectFiles(const Ptr<ArchiveBase>& archive, const String& dir, Array<String>& files)
+{
+    Array<String> names = archive->ListFiles(dir, "*");
+    IndexT i;
+    for (i = 0; i < names.Size(); i++)
+    {
+        files.Append(dir + "/" + names[i]);
+    }
+    Array<String> dirs = archive->ListDirectories(dir, "*");
+    for (i = 0; i < dirs.Size(); i++)
+    {
+        CollectFiles(archive, dir + "/" + dirs[i], files);
+    }
+}
+
+//------------------------------------------------------------------------------
+/**
+*/
+static URI
+MakeArchiveURI(const Ptr<ArchiveBase>& archive, const String& scheme, const String& pathInArchive)
+{
+    URI uri = AssignRegistry::Instance()->ResolveAssigns(archive->GetURI());
+    uri.SetScheme(scheme);
+    uri.SetQuery("file=" + pathInArchive);
+    return uri;
+}
+
+//------------------------------------------------------------------------------
+/**
+    Spreads the files over the reader threads and waits for all of them,
+    returns the number of bytes read.
+*/
+static int64_t
+ReadFiles(const Array<URI>& files, Timer& timer)
+{
+    Array<Ptr<ArchiveReaderThread>> threads;
+    IndexT i;
+    for (i = 0; i < NumThreads; i++)
+    {
+        Array<URI> share;
+        IndexT j;
+        for (j = i; j < files.Size(); j += NumThreads)
+        {
+            share.Append(files[j]);
+        }
+        Ptr<ArchiveReaderThread> thread = ArchiveReaderThread::Create();
+        thread->SetName(String::Sprintf("ArchiveReaderThread%d", i));
+        thread->Setup(share);
+        threads.Append(thread);
+    }
+
+    timer.Reset();
+    timer.Start();
+    for (i = 0; i < NumThreads; i++)
+    {
+        threads[i]->Start();
+    }
+    bool anyRunning;
+    do
+    {
+        anyRunning = false;
+        for (i = 0; i < NumThreads; i++)
+        {
+            if (threads[i]->IsRunning())
+            {
+                anyRunning = true;
+                break;
+            }
+        }
+        n_sleep(0.001);
+    }
+    while (anyRunning);
+    timer.Stop();
+
+    int64_t bytesRead = 0;
+    for (i = 0; i < NumThreads; i++)
+    {
+        bytesRead += threads[i]->GetBytesRead();
+    }
+    return bytesRead;
+}
+
+//------------------------------------------------------------------------------
+/**
+*/
+void
+ArchiveBenchmark::Run(Timer& timer)
+{
+    Ptr<IoServer> ioServer;
+    if (!IoServer::HasInstance())
+    {
+        ioServer = IoServer::Create();
+    }
+    IoServer::Instance()->MountStandardArchives();
+
+    // find the zip archive
+    Ptr<ArchiveBase> zipArchive;
+    Array<Ptr<ArchiveBase>> archives = ArchiveFileSystem::Instance()->GetMountedArchives();
+    IndexT i;
+    for (i = 0; i < archives.Size(); i++)
+    {
+        if (archives[i]->IsA(ZipArchive::RTTI))
+        {
+            zipArchive = archives[i];
+            break;
+        }
+    }
+    if (!zipArchive.isvalid())
+    {
+        n_printf("ArchiveBenchmark: no zip archive mounted, export.zip is needed, skipping.\n");
+        IoServer::Instance()->UnmountStandardArchives();
+        return;
+    }
+
+    // entries of the standard archive start with the archive name, like export/...
+    Array<String> paths;
+    URI zipUri = AssignRegistry::Instance()->ResolveAssigns(zipArchive->GetURI());
+    CollectFiles(zipArchive, zipUri.LocalPath().ExtractFileName(), paths);
+
+    // write a pack with the same content
+    Timer buildTimer;
+    buildTimer.Start();
+    Ptr<PackWriter> writer = PackWriter::Create();
+    writer->SetURI(URI("temp:archivebenchmark.pack"));
+    if (!writer->Open())
+    {
+        IoServer::Instance()->UnmountStandardArchives();
+        return;
+    }
+    for (i = 0; i < paths.Size(); i++)
+    {
+        Ptr<Stream> stream = IoServer::Instance()->CreateStream(MakeArchiveURI(zipArchive, "zip", paths[i]));
+        stream->SetAccessMode(Stream::ReadAccess);
+        if (stream->Open())
+        {
+            SizeT size = stream->GetSize();
+            writer->AddFile(paths[i], size > 0 ? stream->Map() : nullptr, size);
+            if (size > 0)
+            {
+                stream->Unmap();
+            }
+            stream->Close();
+        }
+    }
+    writer->Close();
+    writer = nullptr;
+    buildTimer.Stop();
+    n_printf("ArchiveBenchmark: packed %d files in %f s\n", paths.Size(), buildTimer.GetTime());
+
+    // mount it at the same root as the zip, so both contain the same paths
+    Ptr<ArchiveBase> packArchive = ArchiveFileSystem::Instance()->MountEmbedded(URI("temp:archivebenchmark"), "root:");
+    n_assert(packArchive.isvalid());
+
+    Array<URI> zipFiles;
+    Array<URI> packFiles;
+    for (i = 0; i < paths.Size(); i++)
+    {
+        zipFiles.Append(MakeArchiveURI(zipArchive, "zip", paths[i]));
+        packFiles.Append(MakeArchiveURI(packArchive, "pack", paths[i]));
+    }
+
+    timer.Start();
+    Timer readTimer;
+    int64_t zipBytes = ReadFiles(zipFiles, readTimer);
+    Time zipTime = readTimer.GetTime();
+    int64_t packBytes = ReadFiles(packFiles, readTimer);
+    Time packTime = readTimer.GetTime();
+    timer.Stop();
+
+    n_printf("ArchiveBenchmark: %d threads, %d files, %d loops\n", NumThreads, paths.Size(), NumLoops);
+    n_printf("  zip:  %f s, %f MB/s\n", zipTime, (zipBytes / (1024.0 * 1024.0)) / zipTime);
+    n_printf("  pack: %f s, %f MB/s\n", packTime, (packBytes / (1024.0 * 1024.0)) / packTime);
+
+    ArchiveFileSystem::Instance()->Unmount(packArchive);
+    IoServer::Instance()->DeleteFile("temp:archivebenchmark.pack");
+    IoServer::Instance()->UnmountStandardArchives();
+}
+
+} // namespace Benchmarking
@@ -0,0 +1,28 @@
+#pragma once
+//------------------------------------------------------------------------------
+/**
+    @class Benchmarking::ArchiveBenchmark
+
+    Compares multithreaded read throughput of the zip archive against a pack
+    archive with the same content, in the style of the zipstresstest.
+
+    Needs the standard export.zip archive, the pack archive is created from
+    it in the temp directory.
+
+    (C) 2024 Individual contributors, see AUTHORS file
+*/
+#include "benchmarkbase/benchmark.h"
+
+//------------------------------------------------------------------------------
+namespace Benchmarking
+{
+class ArchiveBenchmark : public Benchmark
+{
+    __DeclareClass(ArchiveBenchmark);
+public:
+    /// run the benchmark
+    virtual void Run(Timing::Timer& timer);
+};
+
+} // namespace Benchmarking
+//------------------------------------------------------------------------------
@@ -0,0 +1,143 @@
+//------------------------------------------------------------------------------
+//  jsontemplatebenchmark.cc
+//  (C) 2024 Individual contributors, see AUTHORS file
+//------------------------------------------------------------------------------
+#include "stdneb.h"
+#include "jsontemplatebenchmark.h"
+#include "io/ioserver.h"
+#include "io/jsonreader.h"
+#include "io/jsonpullreader.h"
+
+namespace Benchmarking
+{
+__ImplementClass(Benchmarking::JsonTemplateBenchmark, 'JTBM', Benchmarking::Benchmark);
+
+using namespace IO;
+using namespace Util;
+using namespace Timing;
+
+static const SizeT NumTemplates = 2048;
+static const SizeT NumLoops = 4;
+
+//------------------------------------------------------------------------------
+/**
+    A template with the components most entities have, and a few arrays.
+*/
+static String
+MakeTemplate(IndexT index)
+{
+    String json;
+    json.Format(
+        "{\n"
+        "    \"blueprint\": \"StaticEntity\",\n"
+        "    \"components\": {\n"
+        "        \"Position\": [%d.5, 0.25, -%d.125],\n"
+        "        \"Orientation\": [0.0, 0.7071, 0.0, 0.7071],\n"
+        "        \"Scale\": [1.0, 1.0, 1.0],\n"
+        "        \"ModelResource\": \"mdl:environment/props/prop_%04d.n3\",\n"
+        "        \"Tags\": [\"static\", \"shadow\", \"lod\\\\%d\"],\n"
+        "        \"Lods\": [5.0, 20.0, 50.0, 120.0, 300.0, 1000.0],\n"
+        "        \"Physics\": { \"Mass\": 0, \"Friction\": 0.8, \"Shape\": \"phys:props/prop_%04d.actor\" }\n"
+        "    }\n"
+        "}\n",
+        index, index, index, index % 4, index);
+    return json;
+}
+
+//------------------------------------------------------------------------------
+/**
+*/
+void
+JsonTemplateBenchmark::Run(Timer& timer)
+{
+    Ptr<IoServer> ioServer;
+    if (!IoServer::HasInstance())
+    {
+        ioServer = IoServer::Create();
+    }
+    const URI folder("temp:jsontemplatebenchmark");
+    IoServer::Instance()->CreateDirectory(folder);
+
+    // write the template folder
+    Array<URI> files;
+    Stream::Size numBytes = 0;
+    IndexT i;
+    for (i = 0; i < NumTemplates; i++)
+    {
+        URI file = folder;
+        file.AppendLocalPath(String::Sprintf("template_%04d.json", i));
+        String const json = MakeTemplate(i);
+        Ptr<Stream> stream = IoServer::Instance()->CreateStream(file);
+        stream->SetAccessMode(Stream::WriteAccess);
+        n_assert(stream->Open());
+        stream->Write(json.AsCharPtr(), json.Length());
+        stream->Close();
+        numBytes += json.Length();
+        files.Append(file);
+    }
+
+    timer.Start();
+    Timer treeTimer, pullTimer;
+    float sum = 0.0f;
+    SizeT numTokens = 0;
+    IndexT loop;
+    for (loop = 0; loop < NumLoops; loop++)
+    {
+        // build the tree and read the components, like BlueprintManager::ParseTemplate
+        treeTimer.Start();
+        for (i = 0; i < files.Size(); i++)
+        {
+            Ptr<JsonReader> reader = JsonReader::Create();
+            reader->SetStream(IoServer::Instance()->CreateStream(files[i]));
+            n_assert(reader->Open());
+            n_assert(reader->GetString("blueprint") == "StaticEntity");
+            n_assert(reader->SetToFirstChild("components"));
+            sum += reader->GetVec3("Position").x;
+            sum += reader->GetVec4("Orientation").w;
+            sum += reader->GetVec3("Scale").y;
+            sum += (float)reader->GetString("ModelResource").Length();
+            Array<String> tags;
+            reader->Get(tags, "Tags");
+            Array<float> lods;
+            reader->Get(lods, "Lods");
+            sum += lods.Back() + tags.Size();
+            n_assert(reader->SetToFirstChild("Physics"));
+            sum += reader->GetFloat("Friction");
+            reader->SetToParent();
+            reader->SetToParent();
+            reader->Close();
+        }
+        treeTimer.Stop();
+
+        // only scan the tokens, the least any parser has to do
+        pullTimer.Start();
+        for (i = 0; i < files.Size(); i++)
+        {
+            Ptr<JsonPullReader> reader = JsonPullReader::Create();
+            reader->SetStream(IoServer::Instance()->CreateStream(files[i]));
+            n_assert(reader->Open());
+            JsonPullReader::Token token;
+            while ((token = reader->Next()) != JsonPullReader::EndOfDocument)
+            {
+                n_assert(token != JsonPullReader::Error);
+                numTokens++;
+            }
+            reader->Close();
+        }
+        pullTimer.Stop();
+    }
+    timer.Stop();
+    n_assert(sum > 0.0f && numTokens > 0);
+
+    n_printf("JsonTemplateBenchmark: %d templates, %d KB, %d loops\n", NumTemplates, (int)(numBytes / 1024), NumLoops);
+    n_printf("  tree: %f ms per folder, %f us per template\n", treeTimer.GetTime() * 1000.0 / NumLoops, treeTimer.GetTime() * 1000000.0 / (NumLoops * NumTemplates));
+    n_printf("  scan: %f ms per folder, %f us per template\n", pullTimer.GetTime() * 1000.0 / NumLoops, pullTimer.GetTime() * 1000000.0 / (NumLoops * NumTemplates));
+
+    for (i = 0; i < files.Size(); i++)
+    {
+        IoServer::Instance()->DeleteFile(files[i]);
+    }
+    IoServer::Instance()->DeleteDirectory(folder);
+}
+
+} // namespace Benchmarking
@@ -0,0 +1,26 @@
+#pragma once
+//------------------------------------------------------------------------------
+/**
+    @class Benchmarking::JsonTemplateBenchmark
+
+    Parses a folder of entity templates the way the BlueprintManager does,
+    building a IO::JsonReader tree for every file and reading its components,
+    and compares it with only scanning the files with IO::JsonPullReader.
+
+    (C) 2024 Individual contributors, see AUTHORS file
+*/
+#include "benchmarkbase/benchmark.h"
+
+//------------------------------------------------------------------------------
+namespace Benchmarking
+{
+class JsonTemplateBenchmark : public Benchmark
+{
+    __DeclareClass(JsonTemplateBenchmark);
+public:
+    /// run the benchmark
+    virtual void Run(Timing::Timer& timer);
+};
+
+} // namespace Benchmarking
+//------------------------------------------------------------------------------
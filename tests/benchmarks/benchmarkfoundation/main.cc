@@ -14,9 +14,13 @@
 #include "float4math.h"
 #include "matrix44inverse.h"
 #include "matrix44multiply.h"
+#include "transformbatchevaluate.h"
 #include "mempoolbenchmark.h"
 #include "containerbenchmark.h"
 #include "delegates.h"
+#include "archivebenchmark.h"
+#include "mappedreadbenchmark.h"
+#include "jsontemplatebenchmark.h"
 
 using namespace Core;
 using namespace Benchmarking;
@@ -32,6 +36,7 @@ main(int argc, char** argv)
     // setup and run benchmarks
     Ptr<BenchmarkRunner> runner = BenchmarkRunner::Create();    
     runner->AttachBenchmark(Matrix44Multiply::Create());
+    runner->AttachBenchmark(TransformBatchEvaluate::Create());
     runner->AttachBenchmark(Matrix44Inverse::Create());
     runner->AttachBenchmark(Float4Math::Create());
     runner->AttachBenchmark(MemPoolBenchmark::Create());
@@ -40,6 +45,9 @@ main(int argc, char** argv)
     runner->AttachBenchmark(CreateObjectsByClassName::Create());
     runner->AttachBenchmark(ContainerBench::Create());
     runner->AttachBenchmark(DelegateBench::Create());
+    runner->AttachBenchmark(ArchiveBenchmark::Create());
+    runner->AttachBenchmark(MappedReadBenchmark::Create());
+    runner->AttachBenchmark(JsonTemplateBenchmark::Create());
     runner->Run();
     
     // shutdown Nebula runtime
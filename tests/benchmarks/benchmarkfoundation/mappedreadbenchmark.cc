@@ -0,0 +1,109 @@
+//------------------------------------------------------------------------------
+//  mappedreadbenchmark.cc
+//  (C) 2024 Individual contributors, see AUTHORS file
+//------------------------------------------------------------------------------
+#include "stdneb.h"
+#include "mappedreadbenchmark.h"
+#include "io/ioserver.h"
+#include "io/mappedview.h"
+
+namespace Benchmarking
+{
+__ImplementClass(Benchmarking::MappedReadBenchmark, 'MRBM', Benchmarking::Benchmark);
+
+using namespace IO;
+using namespace Timing;
+
+static const SizeT NumKeys = 8 * 1024 * 1024;
+static const SizeT NumLoops = 8;
+
+//------------------------------------------------------------------------------
+/**
+    Touches all keys, like sampling would.
+*/
+static float
+SumKeys(const float* keys, SizeT numKeys)
+{
+    float sum = 0.0f;
+    IndexT i;
+    for (i = 0; i < numKeys; i++)
+    {
+        sum += keys[i];
+    }
+    return sum;
+}
+
+//------------------------------------------------------------------------------
+/**
+*/
+void
+MappedReadBenchmark::Run(Timer& timer)
+{
+    Ptr<IoServer> ioServer;
+    if (!IoServer::HasInstance())
+    {
+        ioServer = IoServer::Create();
+    }
+    const URI uri("temp:mappedreadbenchmark.bin");
+    const Stream::Size size = NumKeys * sizeof(float);
+
+    // write the test file
+    {
+        float* keys = (float*)Memory::Alloc(Memory::DefaultHeap, size);
+        IndexT i;
+        for (i = 0; i < NumKeys; i++)
+        {
+            keys[i] = float(i % 1024) * 0.001f;
+        }
+        Ptr<Stream> stream = IoServer::Instance()->CreateStream(uri);
+        stream->SetAccessMode(Stream::WriteAccess);
+        n_assert(stream->Open());
+        stream->Write(keys, size);
+        stream->Close();
+        Memory::Free(Memory::DefaultHeap, keys);
+    }
+
+    timer.Start();
+    float copySum = 0.0f, viewSum = 0.0f;
+    Timer copyTimer, viewTimer;
+    IndexT loop;
+    for (loop = 0; loop < NumLoops; loop++)
+    {
+        // map into a scratch buffer, then copy into a resource allocation
+        copyTimer.Start();
+        Ptr<Stream> stream = IoServer::Instance()->CreateStream(uri);
+        stream->SetAccessMode(Stream::ReadAccess);
+        n_assert(stream->Open());
+        void* mapped = stream->Map();
+        float* keys = (float*)Memory::Alloc(Memory::ResourceHeap, size);
+        Memory::Copy(mapped, keys, size);
+        stream->Unmap();
+        stream->Close();
+        copySum += SumKeys(keys, NumKeys);
+        Memory::Free(Memory::ResourceHeap, keys);
+        copyTimer.Stop();
+
+        // point into the mapped view
+        viewTimer.Start();
+        stream = IoServer::Instance()->CreateStream(uri);
+        stream->SetAccessMode(Stream::ReadAccess);
+        n_assert(stream->Open());
+        Ptr<MappedView> view = MappedView::Create();
+        n_assert(view->Setup(stream));
+        stream = nullptr;
+        viewSum += SumKeys(view->At<float>(0), NumKeys);
+        view = nullptr;
+        viewTimer.Stop();
+    }
+    timer.Stop();
+    n_assert(copySum == viewSum);
+
+    // the copy path holds the scratch buffer and the copy at the same time
+    n_printf("MappedReadBenchmark: %d loops over %d MB\n", NumLoops, (int)(size / (1024 * 1024)));
+    n_printf("  copy: %f s, peak heap %d MB\n", copyTimer.GetTime(), (int)(2 * size / (1024 * 1024)));
+    n_printf("  view: %f s, peak heap 0 MB\n", viewTimer.GetTime());
+
+    IoServer::Instance()->DeleteFile(uri);
+}
+
+} // namespace Benchmarking
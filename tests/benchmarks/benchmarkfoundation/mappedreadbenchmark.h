@@ -0,0 +1,26 @@
+#pragma once
+//------------------------------------------------------------------------------
+/**
+    @class Benchmarking::MappedReadBenchmark
+
+    Compares the old way loaders got at immutable file data, mapping the
+    stream into a scratch buffer and copying it into their own allocation,
+    against pointing into an IO::MappedView.
+
+    (C) 2024 Individual contributors, see AUTHORS file
+*/
+#include "benchmarkbase/benchmark.h"
+
+//------------------------------------------------------------------------------
+namespace Benchmarking
+{
+class MappedReadBenchmark : public Benchmark
+{
+    __DeclareClass(MappedReadBenchmark);
+public:
+    /// run the benchmark
+    virtual void Run(Timing::Timer& timer);
+};
+
+} // namespace Benchmarking
+//------------------------------------------------------------------------------
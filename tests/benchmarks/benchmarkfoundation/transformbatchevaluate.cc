@@ -0,0 +1,84 @@
+//------------------------------------------------------------------------------
+//  transformbatchevaluate.cc
+//  (C) 2024 Individual contributors, see AUTHORS file
+//------------------------------------------------------------------------------
+#include "stdneb.h"
+#include "transformbatchevaluate.h"
+#include "math/transformbatch.h"
+#include "math/quat.h"
+
+namespace Benchmarking
+{
+__ImplementClass(Benchmarking::TransformBatchEvaluate, 'TBEV', Benchmarking::Benchmark);
+
+using namespace Timing;
+using namespace Math;
+
+//------------------------------------------------------------------------------
+/**
+*/
+void
+TransformBatchEvaluate::Run(Timer& timer)
+{
+    // 100 characters with a binary tree of 64 joints each
+    const SizeT numCharacters = 100;
+    const SizeT numJoints = 64;
+    IndexT* parents = new IndexT[numJoints];
+    IndexT* order = new IndexT[numJoints];
+    mat4* inverseBind = new mat4[numJoints];
+    IndexT i;
+    for (i = 0; i < numJoints; i++)
+    {
+        parents[i] = i == 0 ? InvalidIndex : (i - 1) / 2;
+        order[i] = i;
+        inverseBind[i] = translation(0.0f, -0.1f * i, 0.0f);
+    }
+
+    const SizeT batchSize = transformbatch_size(numJoints);
+    float* batches = new float[batchSize * numCharacters];
+    mat4* unscaled = new mat4[numJoints];
+    mat4* scaled = new mat4[numJoints * numCharacters];
+    mat4* skin = new mat4[numJoints * numCharacters];
+    for (i = 0; i < numCharacters; i++)
+    {
+        TransformBatch batch;
+        transformbatch_setup(batch, batches + i * batchSize, numJoints);
+        IndexT j;
+        for (j = 0; j < numJoints; j++)
+        {
+            const quat rotation = quatyawpitchroll(0.01f * j, 0.02f * i, 0.0f);
+            batch.translation[0][j] = 0.0f;
+            batch.translation[1][j] = 0.1f;
+            batch.translation[2][j] = 0.0f;
+            batch.rotation[0][j] = rotation.x;
+            batch.rotation[1][j] = rotation.y;
+            batch.rotation[2][j] = rotation.z;
+            batch.rotation[3][j] = rotation.w;
+            batch.scale[0][j] = batch.scale[1][j] = batch.scale[2][j] = 1.0f;
+        }
+    }
+
+    timer.Start();
+    for (i = 0; i < 100; i++)
+    {
+        IndexT j;
+        for (j = 0; j < numCharacters; j++)
+        {
+            TransformBatch batch;
+            transformbatch_setup(batch, batches + j * batchSize, numJoints);
+            transformbatch_evaluate(batch, parents, order, nullptr, unscaled, scaled + j * numJoints);
+            transformbatch_skin(scaled + j * numJoints, inverseBind, order, nullptr, numJoints, skin + j * numJoints);
+        }
+    }
+    timer.Stop();
+
+    delete[] parents;
+    delete[] order;
+    delete[] inverseBind;
+    delete[] batches;
+    delete[] unscaled;
+    delete[] scaled;
+    delete[] skin;
+}
+
+} // namespace Benchmarking
@@ -0,0 +1,25 @@
+#pragma once
+//------------------------------------------------------------------------------
+/**
+    @class Benchmarking::TransformBatchEvaluate
+    
+    Test transformbatch_evaluate() and transformbatch_skin() performance
+    on a crowd of skeletons.
+    
+    (C) 2024 Individual contributors, see AUTHORS file
+*/
+#include "benchmarkbase/benchmark.h"
+
+//------------------------------------------------------------------------------
+namespace Benchmarking
+{
+class TransformBatchEvaluate : public Benchmark
+{
+    __DeclareClass(TransformBatchEvaluate);
+public:
+    /// run the benchmark
+    virtual void Run(Timing::Timer& timer);
+};
+
+} // namespace Benchmarking
+//------------------------------------------------------------------------------
@@ -0,0 +1,60 @@
+//------------------------------------------------------------------------------
+//  benchmarkgame/main.cc
+//  (C) 2024 Individual contributors, see AUTHORS file
+//------------------------------------------------------------------------------
+#include "stdneb.h"
+#include "system/appentry.h"
+#include "core/sysfunc.h"
+#include "benchmarkbase/benchmarkrunner.h"
+#include "basegamefeature/basegamefeatureunit.h"
+#include "appgame/gameapplication.h"
+
+#include "worldsnapshotbenchmark.h"
+
+ImplementNebulaApplication();
+
+using namespace Core;
+using namespace Benchmarking;
+
+class GameBenchmarkApp : public App::GameApplication
+{
+private:
+    /// setup game features
+    void SetupGameFeatures()
+    {
+        gameFeature = BaseGameFeature::BaseGameFeatureUnit::Instance();
+    }
+
+    /// cleanup game features
+    void CleanupGameFeatures()
+    {
+        // empty
+    }
+
+    Ptr<BaseGameFeature::BaseGameFeatureUnit> gameFeature;
+};
+
+//------------------------------------------------------------------------------
+/**
+*/
+void
+NebulaMain(const Util::CommandLineArgs& args)
+{
+    GameBenchmarkApp gameApp;
+    gameApp.SetCompanyName("Test Company");
+    gameApp.SetAppTitle("Nebula Game Benchmark Runner");
+    if (!gameApp.Open())
+    {
+        n_printf("Aborting game benchmarks due to unrecoverable error...\n");
+        return;
+    }
+
+    // setup and run benchmarks
+    Ptr<BenchmarkRunner> runner = BenchmarkRunner::Create();
+    runner->AttachBenchmark(WorldSnapshotBenchmark::Create());
+    runner->Run();
+
+    runner = nullptr;
+    gameApp.Close();
+    SysFunc::Exit(0);
+}
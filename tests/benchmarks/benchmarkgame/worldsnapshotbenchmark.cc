@@ -0,0 +1,80 @@
+//------------------------------------------------------------------------------
+//  worldsnapshotbenchmark.cc
+//  (C) 2024 Individual contributors, see AUTHORS file
+//------------------------------------------------------------------------------
+#include "stdneb.h"
+#include "worldsnapshotbenchmark.h"
+#include "game/api.h"
+#include "game/world.h"
+#include "game/worldsnapshot.h"
+#include "basegamefeature/components/position.h"
+#include "basegamefeature/components/orientation.h"
+#include "basegamefeature/components/scale.h"
+#include "basegamefeature/components/velocity.h"
+
+namespace Benchmarking
+{
+__ImplementClass(Benchmarking::WorldSnapshotBenchmark, 'WSBM', Benchmarking::Benchmark);
+
+using namespace Timing;
+using namespace Game;
+
+static const SizeT NumEntities = 1000000;
+// every hundredth entity moves between the full and the delta snapshot
+static const SizeT MoveStride = 100;
+
+//------------------------------------------------------------------------------
+/**
+*/
+void
+WorldSnapshotBenchmark::Run(Timer& timer)
+{
+    World* world = Game::GetWorld(WORLD_DEFAULT);
+    MemDb::TableId const table = world->CreateEntityTable({
+        .name = "WorldSnapshotBenchmark",
+        .components = { GetComponentId<Entity>(), GetComponentId<Position>(), GetComponentId<Orientation>(), GetComponentId<Scale>(), GetComponentId<Velocity>() }
+    });
+
+    Util::Array<Entity> entities;
+    entities.Reserve(NumEntities);
+    IndexT i;
+    for (i = 0; i < NumEntities; i++)
+    {
+        Entity const entity = world->AllocateEntityId();
+        world->AllocateInstance(entity, table);
+        entities.Append(entity);
+    }
+
+    Timer writeTimer, deltaTimer, readTimer, readDeltaTimer;
+    timer.Start();
+
+    writeTimer.Start();
+    Util::Blob const snapshot = WorldSnapshot::Write(world);
+    writeTimer.Stop();
+
+    for (i = 0; i < NumEntities; i += MoveStride)
+        world->SetComponent(entities[i], Position(Math::vec3(float(i), 0.0f, 0.0f)));
+
+    deltaTimer.Start();
+    Util::Blob const delta = WorldSnapshot::WriteDelta(world, snapshot.GetPtr(), snapshot.Size());
+    deltaTimer.Stop();
+
+    readTimer.Start();
+    WorldSnapshot::Read(world, snapshot.GetPtr(), snapshot.Size());
+    readTimer.Stop();
+
+    readDeltaTimer.Start();
+    WorldSnapshot::Read(world, delta.GetPtr(), delta.Size(), snapshot.GetPtr(), snapshot.Size());
+    readDeltaTimer.Stop();
+
+    timer.Stop();
+
+    n_printf("WorldSnapshotBenchmark: %d entities\n", world->GetNumEntities());
+    n_printf("  full:  %d KB, written in %f ms, read in %f ms\n", (int)(snapshot.Size() / 1024), writeTimer.GetTime() * 1000.0, readTimer.GetTime() * 1000.0);
+    n_printf("  delta: %d KB, written in %f ms, read in %f ms\n", (int)(delta.Size() / 1024), deltaTimer.GetTime() * 1000.0, readDeltaTimer.GetTime() * 1000.0);
+
+    for (i = 0; i < NumEntities; i++)
+        world->DeleteEntity(entities[i]);
+}
+
+} // namespace Benchmarking
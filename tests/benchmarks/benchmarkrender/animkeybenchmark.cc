@@ -0,0 +1,185 @@
+//------------------------------------------------------------------------------
+//  animkeybenchmark.cc
+//  (C) 2024 Individual contributors, see AUTHORS file
+//------------------------------------------------------------------------------
+#include "foundation/stdneb.h"
+#include "animkeybenchmark.h"
+#include "coreanimation/animation.h"
+#include "coreanimation/animkeycompression.h"
+#include "coreanimation/naxfileformatstructs.h"
+#include "math/quat.h"
+#include <float.h>
+
+namespace Benchmarking
+{
+__ImplementClass(Benchmarking::AnimKeyBenchmark, 'AKBM', Benchmarking::Benchmark);
+
+using namespace Timing;
+using namespace Math;
+using namespace CoreAnimation;
+
+// 64 joints with a translation, rotation and scale curve each, 10 seconds at 30 keys per second
+static const SizeT NumJoints = 64;
+static const SizeT NumCurves = NumJoints * 3;
+static const SizeT NumKeys = 301;
+static const Tick KeyDuration = 33;
+static const SizeT NumFrames = 20000;
+static const Tick FrameDuration = 16;
+
+//------------------------------------------------------------------------------
+/**
+    Samples the clip once per frame, returns a sum of the samples so the
+    work can't be dropped
+*/
+static float
+SampleClip(const AnimClip& clip, const Util::FixedArray<AnimCurve>& curves, const Util::FixedArray<vec4>& idleSamples, const Ptr<AnimKeyBuffer>& keyBuffer, Timer& timer)
+{
+    Util::FixedArray<uint> intervals(NumCurves, 0);
+    Util::FixedArray<float> samples(NumJoints * 10 + 4);
+    Util::FixedArray<uchar> counts(NumCurves);
+    float sum = 0.0f;
+    timer.Start();
+    IndexT i;
+    for (i = 0; i < NumFrames; i++)
+    {
+        AnimSample(SampleType::Linear, clip, curves, i * FrameDuration, vec4(1.0f), idleSamples, keyBuffer, intervals.Begin(), samples.Begin(), counts.Begin());
+        sum += samples[i % (NumJoints * 10)];
+    }
+    timer.Stop();
+    return sum;
+}
+
+//------------------------------------------------------------------------------
+/**
+*/
+void
+AnimKeyBenchmark::Run(Timer& timer)
+{
+    // smooth motion, different for every joint
+    Util::Array<float> keys;
+    Util::Array<ushort> compressedKeys;
+    Util::FixedArray<AnimCurve> curves(NumCurves);
+    Util::FixedArray<AnimCurve> compressedCurves(NumCurves);
+    Util::FixedArray<vec4> idleSamples(NumCurves, vec4(0.0f, 0.0f, 0.0f, 1.0f));
+    Util::FixedArray<AnimKeyBuffer::Interval> intervals(NumCurves * (NumKeys - 1));
+    Util::FixedArray<AnimKeyBuffer::Interval> compressedIntervals(NumCurves * (NumKeys - 1));
+    IndexT i, j, k;
+    for (i = 0; i < NumCurves; i++)
+    {
+        const IndexT joint = i / 3;
+        const CurveType::Code curveType = (i % 3) == 0 ? CurveType::Translation : (i % 3) == 1 ? CurveType::Rotation : CurveType::Scale;
+        const SizeT stride = curveType == CurveType::Rotation ? 4 : 3;
+        const IndexT firstKey = keys.Size();
+        const IndexT firstCompressedKey = compressedKeys.Size();
+
+        AnimCurve& curve = curves[i];
+        curve.firstIntervalOffset = i * (NumKeys - 1);
+        curve.numIntervals = NumKeys - 1;
+        curve.curveType = curveType;
+        curve.preInfinityType = InfinityType::Cycle;
+        curve.postInfinityType = InfinityType::Cycle;
+
+        for (j = 0; j < NumKeys; j++)
+        {
+            const float t = j * 0.033f;
+            if (curveType == CurveType::Rotation)
+            {
+                const quat rotation = quatyawpitchroll(Math::sin(t + joint), Math::cos(t * 0.5f + joint), 0.1f * joint);
+                keys.Append(rotation.x);
+                keys.Append(rotation.y);
+                keys.Append(rotation.z);
+                keys.Append(rotation.w);
+            }
+            else
+            {
+                const float base = curveType == CurveType::Scale ? 1.0f : 0.1f * joint;
+                keys.Append(base + 0.1f * Math::sin(t));
+                keys.Append(base + 0.1f * Math::cos(t));
+                keys.Append(base + 0.05f * Math::sin(2.0f * t));
+            }
+        }
+
+        // quantize to the range of the curve, like the exporter does
+        AnimCurve& compressedCurve = compressedCurves[i];
+        compressedCurve = curve;
+        if (curveType == CurveType::Rotation)
+        {
+            for (j = 0; j < NumKeys; j++)
+            {
+                ushort key[AnimKeyCompressedStride];
+                const float* values = keys.Begin() + firstKey + j * 4;
+                AnimKeyEncodeRotation(quat(values[0], values[1], values[2], values[3]), key);
+                for (k = 0; k < AnimKeyCompressedStride; k++)
+                    compressedKeys.Append(key[k]);
+            }
+        }
+        else
+        {
+            vec4 minimum(FLT_MAX, FLT_MAX, FLT_MAX, 0.0f), maximum(-FLT_MAX, -FLT_MAX, -FLT_MAX, 0.0f);
+            for (j = 0; j < NumKeys; j++)
+            {
+                for (k = 0; k < 3; k++)
+                {
+                    minimum[k] = Math::min(minimum[k], keys[firstKey + j * 3 + k]);
+                    maximum[k] = Math::max(maximum[k], keys[firstKey + j * 3 + k]);
+                }
+            }
+            compressedCurve.keyOffset = minimum;
+            compressedCurve.keyScale = (maximum - minimum) * (1.0f / 65535.0f);
+            for (j = 0; j < NumKeys; j++)
+            {
+                ushort key[AnimKeyCompressedStride];
+                AnimKeyEncodeVector(keys.Begin() + firstKey + j * 3, compressedCurve.keyOffset, compressedCurve.keyScale, key);
+                for (k = 0; k < AnimKeyCompressedStride; k++)
+                    compressedKeys.Append(key[k]);
+            }
+        }
+
+        for (j = 0; j < NumKeys - 1; j++)
+        {
+            AnimKeyBuffer::Interval& interval = intervals[curve.firstIntervalOffset + j];
+            interval.start = j * KeyDuration;
+            interval.end = (j + 1) * KeyDuration;
+            interval.key0 = firstKey + j * stride;
+            interval.key1 = firstKey + (j + 1) * stride;
+            interval.duration = 1.0f / float(KeyDuration);
+
+            AnimKeyBuffer::Interval& compressedInterval = compressedIntervals[curve.firstIntervalOffset + j];
+            compressedInterval = interval;
+            compressedInterval.key0 = firstCompressedKey + j * AnimKeyCompressedStride;
+            compressedInterval.key1 = firstCompressedKey + (j + 1) * AnimKeyCompressedStride;
+        }
+    }
+
+    // the decoders read one ushort past the last key
+    compressedKeys.Append(0);
+
+    Ptr<AnimKeyBuffer> keyBuffer = AnimKeyBuffer::Create();
+    keyBuffer->Setup(intervals.Size(), keys.Size(), intervals.Begin(), keys.Begin());
+    Ptr<AnimKeyBuffer> compressedKeyBuffer = AnimKeyBuffer::Create();
+    compressedKeyBuffer->Setup(compressedIntervals.Size(), compressedKeys.Size(), compressedIntervals.Begin(), compressedKeys.Begin(), nullptr, true);
+
+    AnimClip clip;
+    clip.firstCurve = 0;
+    clip.numCurves = NumCurves;
+    clip.duration = (NumKeys - 1) * KeyDuration;
+
+    Timer floatTimer, compressedTimer;
+    timer.Start();
+    float sum = SampleClip(clip, curves, idleSamples, keyBuffer, floatTimer);
+    sum += SampleClip(clip, compressedCurves, idleSamples, compressedKeyBuffer, compressedTimer);
+    timer.Stop();
+
+    // intervals take the same space in memory either way, compressed files only store their durations
+    const SizeT intervalBytes = intervals.Size() * sizeof(AnimKeyBuffer::Interval);
+    const SizeT fileBytes = keyBuffer->GetByteSize() + intervals.Size() * sizeof(Nax3Interval) + NumCurves * sizeof(Nax3Curve);
+    const SizeT compressedFileBytes = compressedKeyBuffer->GetByteSize() + intervals.Size() * sizeof(ushort) + NumCurves * (sizeof(Nax3Curve) + sizeof(Nax3CompressedCurve));
+    n_printf("AnimKeyBenchmark: %d joints, %d keys, %d frames (%f)\n", NumJoints, NumKeys, NumFrames, sum);
+    n_printf("  float:      %d KB keys, %d KB intervals, %d KB in file, %f ms\n", keyBuffer->GetByteSize() / 1024, intervalBytes / 1024, fileBytes / 1024, floatTimer.GetTime() * 1000.0);
+    n_printf("  compressed: %d KB keys, %d KB intervals, %d KB in file, %f ms\n", compressedKeyBuffer->GetByteSize() / 1024, intervalBytes / 1024, compressedFileBytes / 1024, compressedTimer.GetTime() * 1000.0);
+
+    keyBuffer->Discard();
+    compressedKeyBuffer->Discard();
+}
+
+} // namespace Benchmarking
@@ -0,0 +1,26 @@
+#pragma once
+//------------------------------------------------------------------------------
+/**
+    @class Benchmarking::AnimKeyBenchmark
+
+    Samples a clip with float keys and the same clip with compressed keys,
+    and reports how much memory and file space the keys and their intervals
+    take in both cases.
+
+    (C) 2024 Individual contributors, see AUTHORS file
+*/
+#include "benchmarkbase/benchmark.h"
+
+//------------------------------------------------------------------------------
+namespace Benchmarking
+{
+class AnimKeyBenchmark : public Benchmark
+{
+    __DeclareClass(AnimKeyBenchmark);
+public:
+    /// run the benchmark
+    virtual void Run(Timing::Timer& timer);
+};
+
+} // namespace Benchmarking
+//------------------------------------------------------------------------------
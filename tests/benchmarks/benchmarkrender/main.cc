@@ -0,0 +1,34 @@
+//------------------------------------------------------------------------------
+//  benchmarkrender/main.cc
+//  (C) 2024 Individual contributors, see AUTHORS file
+//------------------------------------------------------------------------------
+#include "foundation/stdneb.h"
+#include "core/coreserver.h"
+#include "core/sysfunc.h"
+#include "benchmarkbase/benchmarkrunner.h"
+
+#include "animkeybenchmark.h"
+
+using namespace Core;
+using namespace Benchmarking;
+
+int __cdecl
+main(int argc, char** argv)
+{
+    // create Nebula runtime
+    Ptr<CoreServer> coreServer = CoreServer::Create();
+    coreServer->SetAppName(Util::StringAtom("Nebula Render Benchmark Runner"));
+    coreServer->Open();
+
+    // setup and run benchmarks
+    Ptr<BenchmarkRunner> runner = BenchmarkRunner::Create();
+    runner->AttachBenchmark(AnimKeyBenchmark::Create());
+    runner->Run();
+
+    // shutdown Nebula runtime
+    runner = nullptr;
+    coreServer->Close();
+    coreServer = nullptr;
+    SysFunc::Exit(0);
+    return 0;
+}
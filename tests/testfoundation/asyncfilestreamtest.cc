@@ -0,0 +1,118 @@
+//------------------------------------------------------------------------------
+//  asyncfilestreamtest.cc
+//  (C) 2024 Individual contributors, see AUTHORS file
+//------------------------------------------------------------------------------
+#include "stdneb.h"
+#include "asyncfilestreamtest.h"
+#include "io/ioserver.h"
+#include "io/asyncfilestream.h"
+
+namespace Test
+{
+__ImplementClass(Test::AsyncFileStreamTest, 'AFTS', Test::TestCase);
+
+using namespace IO;
+using namespace Util;
+
+//------------------------------------------------------------------------------
+/**
+*/
+void
+AsyncFileStreamTest::Run()
+{
+    Ptr<IoServer> ioServer = IoServer::Create();
+
+    // write a test file
+    const SizeT fileSize = 256 * 1024;
+    Array<uchar> data(fileSize, 0);
+    for (IndexT i = 0; i < fileSize; i++)
+    {
+        data.Append(uchar(i * 31 + 7));
+    }
+    Ptr<Stream> file = ioServer->CreateStream("temp:asyncfilestreamtest.bin");
+    file->SetAccessMode(Stream::WriteAccess);
+    VERIFY(file->Open());
+    file->Write(data.Begin(), fileSize);
+    file->Close();
+
+    // run the same reads through io_uring, where available, and the reader thread fallback
+    for (IndexT pass = 0; pass < 2; pass++)
+    {
+        Ptr<AsyncIoQueue> queue = AsyncIoQueue::Create();
+        queue->Setup(8, 2, pass == 1);
+        VERIFY(pass == 0 || queue->GetBackend() == AsyncIoQueue::ThreadPool);
+
+        Ptr<AsyncFileStream> stream = AsyncFileStream::Create();
+        stream->SetURI("temp:asyncfilestreamtest.bin");
+        stream->SetQueue(queue);
+        VERIFY(stream->Open());
+        VERIFY(stream->GetSize() == fileSize);
+
+        // keep more reads in flight than the queue has slots
+        const SizeT chunkSize = 4096;
+        const SizeT numChunks = fileSize / chunkSize;
+        Array<uchar> buffer(fileSize, 0, 0);
+        SizeT numCompleted = 0;
+        bool allSucceeded = true;
+        for (IndexT i = 0; i < numChunks; i++)
+        {
+            stream->ReadAsync(i * chunkSize, &buffer[i * chunkSize], chunkSize, [&](AsyncReadResult const& result)
+            {
+                allSucceeded &= result.success && result.bytesRead == chunkSize;
+                numCompleted++;
+            });
+        }
+        VERIFY(stream->GetNumPendingReads() == numChunks);
+        queue->Wait();
+        VERIFY(numCompleted == numChunks);
+        VERIFY(allSucceeded);
+        VERIFY(memcmp(buffer.Begin(), data.Begin(), fileSize) == 0);
+
+        // scatter two ranges into separate buffers, and read past the end of the file
+        uchar head[16];
+        uchar tail[64];
+        AsyncReadRegion regions[2];
+        regions[0] = { 100, head, sizeof(head) };
+        regions[1] = { fileSize - 32, tail, sizeof(tail) };
+        AsyncReadResult scatterResult = { false, 0 };
+        stream->ReadAsync(regions, 2, [&](AsyncReadResult const& result)
+        {
+            scatterResult = result;
+        });
+        while (queue->GetNumPending() > 0)
+        {
+            queue->Poll();
+        }
+        VERIFY(scatterResult.success);
+        VERIFY(scatterResult.bytesRead == sizeof(head) + 32);
+        VERIFY(memcmp(head, &data[100], sizeof(head)) == 0);
+        VERIFY(memcmp(tail, &data[fileSize - 32], 32) == 0);
+
+        // closing waits for reads in flight
+        stream->ReadAsync(0, buffer.Begin(), fileSize, nullptr);
+        stream->Close();
+        VERIFY(stream->GetNumPendingReads() == 0);
+        queue->Discard();
+    }
+
+    // read through the io server, which also handles files that can't be read asynchronously
+    uchar bytes[8];
+    bool found = false;
+    ioServer->ReadAsync("temp:asyncfilestreamtest.bin", 1000, bytes, sizeof(bytes), [&](AsyncReadResult const& result)
+    {
+        found = result.success && result.bytesRead == sizeof(bytes);
+    });
+    bool missing = true;
+    ioServer->ReadAsync("temp:asyncfilestreamtest_missing.bin", 0, bytes, sizeof(bytes), [&](AsyncReadResult const& result)
+    {
+        missing = !result.success;
+    });
+    ioServer->WaitForAsyncReads();
+    VERIFY(found);
+    VERIFY(missing);
+    VERIFY(memcmp(bytes, &data[1000], sizeof(bytes)) == 0);
+
+    ioServer->DeleteFile("temp:asyncfilestreamtest.bin");
+}
+
+} // namespace Test
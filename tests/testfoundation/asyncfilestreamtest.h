@@ -0,0 +1,26 @@
+#ifndef TEST_ASYNCFILESTREAMTEST_H
+#define TEST_ASYNCFILESTREAMTEST_H
+//------------------------------------------------------------------------------
+/**
+    @class Test::AsyncFileStreamTest
+    
+    Test IO::AsyncFileStream and IoServer::ReadAsync functionality.
+    
+    (C) 2024 Individual contributors, see AUTHORS file
+*/
+#include "testbase/testcase.h"
+
+//------------------------------------------------------------------------------
+namespace Test
+{
+class AsyncFileStreamTest : public TestCase
+{
+    __DeclareClass(AsyncFileStreamTest);
+public:
+    /// run the test
+    virtual void Run();
+};
+
+} // namespace Test
+//------------------------------------------------------------------------------
+#endif
@@ -94,10 +94,17 @@ FileWatcherTest::Run()
     ioServer->Instance()->DeleteDirectory("temp");       
     ioServer->Instance()->DeleteDirectory("temp2");
     
+#if __linux__
+    // inotify reports everything, bursts of writes to a file are merged into one event
+    VERIFY(fileAdded == 2);
+    VERIFY(fileModified >= 2);
+    VERIFY(fileDeleted == 2);
+#else
     // with low priority we only get a modify per file sometimes (which is fine for normal use)
     //VERIFY(fileAdded == 2);
     VERIFY(fileModified > 2);
     //VERIFY(fileDeleted == 2);
+#endif
     watcher = nullptr;
 }
 }
\ No newline at end of file
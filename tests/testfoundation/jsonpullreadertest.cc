@@ -0,0 +1,130 @@
+//------------------------------------------------------------------------------
+//  jsonpullreadertest.cc
+//  (C) 2024 Individual contributors, see AUTHORS file
+//------------------------------------------------------------------------------
+#include "stdneb.h"
+#include "jsonpullreadertest.h"
+#include "io/ioserver.h"
+#include "io/memorystream.h"
+#include "io/jsonpullreader.h"
+
+namespace Test
+{
+__ImplementClass(Test::JsonPullReaderTest, 'JPRT', Test::TestCase);
+
+using namespace IO;
+using namespace Util;
+
+//------------------------------------------------------------------------------
+/**
+*/
+static Ptr<JsonPullReader>
+OpenReader(const char* json)
+{
+    Ptr<MemoryStream> stream = MemoryStream::Create();
+    stream->SetAccessMode(Stream::WriteAccess);
+    stream->Open();
+    stream->Write(json, (Stream::Size)strlen(json));
+    stream->Close();
+    Ptr<JsonPullReader> reader = JsonPullReader::Create();
+    reader->SetStream(stream.upcast<Stream>());
+    n_assert(reader->Open());
+    return reader;
+}
+
+//------------------------------------------------------------------------------
+/**
+*/
+static JsonPullReader::Token
+ReadToEnd(const char* json)
+{
+    Ptr<JsonPullReader> reader = OpenReader(json);
+    JsonPullReader::Token token;
+    do
+    {
+        token = reader->Next();
+    }
+    while (token != JsonPullReader::EndOfDocument && token != JsonPullReader::Error);
+    reader->Close();
+    return token;
+}
+
+//------------------------------------------------------------------------------
+/**
+*/
+void
+JsonPullReaderTest::Run()
+{
+    // a long string exercises the vectorized scan, the escaped quote sits past the first 16 bytes
+    const char* json =
+        "{\n"
+        "  \"name\": \"a rather long string value with an \\\"escaped\\\" quote\",\n"
+        "  \"count\": -42,\n"
+        "  \"scale\": 1.5e2,\n"
+        "  \"flags\": [true, false, null],\n"
+        "  \"skipped\": { \"deep\": [1, [2, {\"x\": \"]\"}]], \"more\": {} },\n"
+        "  \"unicode\": \"\\u00e9\\ud83d\\ude00\",\n"
+        "  \"empty\": []\n"
+        "}\n";
+
+    Ptr<JsonPullReader> reader = OpenReader(json);
+    VERIFY(reader->Next() == JsonPullReader::BeginObject);
+    VERIFY(reader->GetDepth() == 1);
+
+    VERIFY(reader->Next() == JsonPullReader::Key);
+    VERIFY(reader->GetView().Equals("name"));
+    VERIFY(!reader->HasEscapes());
+    VERIFY(reader->Next() == JsonPullReader::String);
+    VERIFY(reader->HasEscapes());
+    VERIFY(reader->GetString() == "a rather long string value with an \"escaped\" quote");
+
+    VERIFY(reader->Next() == JsonPullReader::Key);
+    VERIFY(reader->GetView().Equals("count"));
+    VERIFY(reader->Next() == JsonPullReader::Number);
+    VERIFY(reader->GetInt() == -42);
+
+    VERIFY(reader->Next() == JsonPullReader::Key);
+    VERIFY(reader->Next() == JsonPullReader::Number);
+    VERIFY(reader->GetFloat() == 150.0f);
+    VERIFY(reader->GetInt() == 150);
+
+    VERIFY(reader->Next() == JsonPullReader::Key);
+    VERIFY(reader->GetView().Equals("flags"));
+    VERIFY(reader->Next() == JsonPullReader::BeginArray);
+    VERIFY(reader->Next() == JsonPullReader::True);
+    VERIFY(reader->GetBool());
+    VERIFY(reader->Next() == JsonPullReader::False);
+    VERIFY(reader->Next() == JsonPullReader::Null);
+    VERIFY(reader->Next() == JsonPullReader::EndArray);
+
+    VERIFY(reader->Next() == JsonPullReader::Key);
+    VERIFY(reader->GetView().Equals("skipped"));
+    VERIFY(reader->SkipValue());
+    VERIFY(reader->GetToken() == JsonPullReader::EndObject);
+    VERIFY(reader->GetDepth() == 1);
+
+    VERIFY(reader->Next() == JsonPullReader::Key);
+    VERIFY(reader->GetView().Equals("unicode"));
+    VERIFY(reader->Next() == JsonPullReader::String);
+    VERIFY(reader->GetString() == "\xC3\xA9\xF0\x9F\x98\x80");
+
+    VERIFY(reader->Next() == JsonPullReader::Key);
+    VERIFY(reader->Next() == JsonPullReader::BeginArray);
+    VERIFY(reader->Next() == JsonPullReader::EndArray);
+    VERIFY(reader->Next() == JsonPullReader::EndObject);
+    VERIFY(reader->GetDepth() == 0);
+    VERIFY(reader->Next() == JsonPullReader::EndOfDocument);
+    reader->Close();
+
+    // malformed documents
+    VERIFY(ReadToEnd("[1, 2,]") == JsonPullReader::Error);
+    VERIFY(ReadToEnd("{\"a\" 1}") == JsonPullReader::Error);
+    VERIFY(ReadToEnd("{\"a\": 1]") == JsonPullReader::Error);
+    VERIFY(ReadToEnd("[1 2]") == JsonPullReader::Error);
+    VERIFY(ReadToEnd("{\"a\": \"unterminated}") == JsonPullReader::Error);
+    VERIFY(ReadToEnd("[tru]") == JsonPullReader::Error);
+    VERIFY(ReadToEnd("{} {}") == JsonPullReader::Error);
+    VERIFY(ReadToEnd("[[[]]]") == JsonPullReader::EndOfDocument);
+}
+
+} // namespace Test
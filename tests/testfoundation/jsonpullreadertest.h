@@ -0,0 +1,26 @@
+#ifndef TEST_JSONPULLREADERTEST_H
+#define TEST_JSONPULLREADERTEST_H
+//------------------------------------------------------------------------------
+/**
+    @class Test::JsonPullReaderTest
+    
+    Test IO::JsonPullReader functionality.
+    
+    (C) 2024 Individual contributors, see AUTHORS file
+*/
+#include "testbase/testcase.h"
+
+//------------------------------------------------------------------------------
+namespace Test
+{
+class JsonPullReaderTest : public TestCase
+{
+    __DeclareClass(JsonPullReaderTest);
+public:
+    /// run the test
+    virtual void Run();
+};
+
+} // namespace Test
+//------------------------------------------------------------------------------
+#endif
@@ -22,6 +22,9 @@
 #include "memorystreamtest.h"
 #include "guidtest.h"
 #include "fileservertest.h"
+#include "asyncfilestreamtest.h"
+#include "packarchivetest.h"
+#include "streamcachetest.h"
 #include "filewatchertest.h"
 #include "uritest.h"
 #include "textreaderwritertest.h"
@@ -30,6 +33,7 @@
 #include "stackarraytest.h"
 #include "xmlreaderwritertest.h"
 // #include "jsonreaderwritertest.h"
+#include "jsonpullreadertest.h"
 #include "binaryreaderwritertest.h"
 #include "uritest.h"
 #include "mediatypetest.h"
@@ -41,11 +45,13 @@
 #include "zipfstest.h"
 #include "float4test.h"
 #include "matrix44test.h"
+#include "transformbatchtest.h"
 #include "threadtest.h"
 #include "memorypooltest.h"
 #include "runlengthcodectest.h"
 #include "sizeclassificationallocatortest.h"
 #include "ringbuffertest.h"
+#include "radixsorttest.h"
 #include "excelxmlreadertest.h"
 #include "delegatetest.h"
 #include "delegatetabletest.h"
@@ -87,11 +93,13 @@ __cdecl main()
     testRunner->AttachTestCase(BitFieldTest::Create());
     //testRunner->AttachTestCase(ExcelXmlReaderTest::Create());
     testRunner->AttachTestCase(RingBufferTest::Create());
+    testRunner->AttachTestCase(RadixSortTest::Create());
     testRunner->AttachTestCase(RunLengthCodecTest::Create());
     // FIXME 
     // testRunner->AttachTestCase(SizeClassificationAllocatorTest::Create());
     testRunner->AttachTestCase(MemoryPoolTest::Create());
     testRunner->AttachTestCase(Matrix44Test::Create());
+    testRunner->AttachTestCase(TransformBatchTest::Create());
     testRunner->AttachTestCase(Float4Test::Create());
     testRunner->AttachTestCase(ZipFSTest::Create());
     //testRunner->AttachTestCase(FileWatcherTest::Create());
@@ -115,10 +123,14 @@ __cdecl main()
     testRunner->AttachTestCase(MemoryStreamTest::Create());
     testRunner->AttachTestCase(GuidTest::Create());
     testRunner->AttachTestCase(FileServerTest::Create());
+    testRunner->AttachTestCase(AsyncFileStreamTest::Create());
+    testRunner->AttachTestCase(PackArchiveTest::Create());
+    testRunner->AttachTestCase(StreamCacheTest::Create());
     testRunner->AttachTestCase(TextReaderWriterTest::Create());
     testRunner->AttachTestCase(MessageReaderWriterTest::Create());
     testRunner->AttachTestCase(XmlReaderWriterTest::Create());
     // testRunner->AttachTestCase(JSonReaderWriterTest::Create());
+    testRunner->AttachTestCase(JsonPullReaderTest::Create());
     testRunner->AttachTestCase(BinaryReaderWriterTest::Create());
     testRunner->AttachTestCase(VariantTest::Create());
     testRunner->AttachTestCase(IOInterfaceTest::Create());
@@ -0,0 +1,110 @@
+//------------------------------------------------------------------------------
+//  packarchivetest.cc
+//  (C) 2024 Individual contributors, see AUTHORS file
+//------------------------------------------------------------------------------
+#include "stdneb.h"
+#include "packarchivetest.h"
+#include "io/ioserver.h"
+#include "io/archfs/archivefilesystem.h"
+#include "io/packfs/packarchive.h"
+#include "io/packfs/packwriter.h"
+
+namespace Test
+{
+__ImplementClass(Test::PackArchiveTest, 'PKTS', Test::TestCase);
+
+using namespace IO;
+using namespace Util;
+
+//------------------------------------------------------------------------------
+/**
+*/
+void
+PackArchiveTest::Run()
+{
+    Ptr<IoServer> ioServer = IoServer::Create();
+
+    // a compressible file spanning several blocks, an incompressible one and a small one
+    const SizeT bigSize = 200 * 1024;
+    Array<uchar> big(bigSize, 0);
+    for (IndexT i = 0; i < bigSize; i++)
+    {
+        big.Append(uchar(i % 7));
+    }
+    const SizeT noiseSize = 100 * 1024;
+    Array<uchar> noise(noiseSize, 0);
+    uint32_t seed = 12345;
+    for (IndexT i = 0; i < noiseSize; i++)
+    {
+        seed = seed * 1103515245 + 12345;
+        noise.Append(uchar(seed >> 24));
+    }
+    const char* small = "hello pack";
+
+    Ptr<PackWriter> writer = PackWriter::Create();
+    writer->SetURI("temp:packarchivetest.pack");
+    VERIFY(writer->Open());
+    VERIFY(writer->AddFile("packtest/big.bin", big.Begin(), bigSize));
+    VERIFY(writer->AddFile("packtest/sub/noise.bin", noise.Begin(), noiseSize));
+    VERIFY(writer->AddFile("packtest\\sub\\small.txt", small, (SizeT)strlen(small)));
+    VERIFY(!writer->AddFile("packtest/big.bin", small, (SizeT)strlen(small)));
+    VERIFY(writer->GetNumFiles() == 3);
+    writer->Close();
+
+    // mounting prefers the pack file
+    Ptr<ArchiveBase> archiveBase = ArchiveFileSystem::Instance()->MountEmbedded("temp:packarchivetest", "temp:");
+    VERIFY(archiveBase.isvalid());
+    VERIFY(archiveBase->IsA(PackArchive::RTTI));
+    Ptr<PackArchive> archive = archiveBase.downcast<PackArchive>();
+    VERIFY(archive->GetNumEntries() == 3);
+
+    // table of contents
+    const Pack::Entry* bigEntry = archive->FindEntry("packtest/big.bin");
+    const Pack::Entry* noiseEntry = archive->FindEntry("packtest/sub/noise.bin");
+    VERIFY(nullptr != bigEntry);
+    VERIFY(nullptr != noiseEntry);
+    VERIFY(nullptr == archive->FindEntry("packtest/missing.bin"));
+    VERIFY(bigEntry->codec == Pack::Zlib);
+    VERIFY(bigEntry->numBlocks == 4);
+    VERIFY(noiseEntry->codec == Pack::Stored);
+    VERIFY(noiseEntry->dataOffset % Pack::DataAlignment == 0);
+    VERIFY(nullptr == archive->GetEntryData(bigEntry));
+    VERIFY(0 == memcmp(archive->GetEntryData(noiseEntry), noise.Begin(), noiseSize));
+    VERIFY(archive->HasDirectory("packtest/sub"));
+    VERIFY(!archive->HasDirectory("packtest/none"));
+    Array<String> files = archive->ListFiles("packtest/sub", "*");
+    VERIFY(files.Size() == 2);
+    VERIFY(files.FindIndex("small.txt") != InvalidIndex);
+    Array<String> dirs = archive->ListDirectories("packtest", "*");
+    VERIFY(dirs.Size() == 1 && dirs[0] == "sub");
+
+    // transparent access through the io server
+    VERIFY(ioServer->FileExists("temp:packtest/big.bin"));
+    Ptr<Stream> stream = ioServer->CreateStream("temp:packtest/big.bin");
+    VERIFY(stream->GetURI().Scheme() == "pack");
+    stream->SetAccessMode(Stream::ReadAccess);
+    VERIFY(stream->Open());
+    VERIFY(stream->GetSize() == bigSize);
+    Array<uchar> buffer(bigSize, 0, 0);
+    VERIFY(stream->Read(buffer.Begin(), bigSize) == bigSize);
+    VERIFY(stream->Eof());
+    VERIFY(0 == memcmp(buffer.Begin(), big.Begin(), bigSize));
+    stream->Seek(70000, Stream::Begin);
+    uchar bytes[16];
+    VERIFY(stream->Read(bytes, sizeof(bytes)) == sizeof(bytes));
+    VERIFY(0 == memcmp(bytes, &big[70000], sizeof(bytes)));
+    stream->Close();
+
+    stream = ioServer->CreateStream("temp:packtest/sub/small.txt");
+    stream->SetAccessMode(Stream::ReadAccess);
+    VERIFY(stream->Open());
+    VERIFY(stream->GetSize() == (Stream::Size)strlen(small));
+    VERIFY(0 == memcmp(stream->Map(), small, strlen(small)));
+    stream->Unmap();
+    stream->Close();
+
+    ArchiveFileSystem::Instance()->Unmount(archiveBase);
+    ioServer->DeleteFile("temp:packarchivetest.pack");
+}
+
+} // namespace Test
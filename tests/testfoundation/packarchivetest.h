@@ -0,0 +1,26 @@
+#ifndef TEST_PACKARCHIVETEST_H
+#define TEST_PACKARCHIVETEST_H
+//------------------------------------------------------------------------------
+/**
+    @class Test::PackArchiveTest
+    
+    Test IO::PackWriter, IO::PackArchive and IO::PackFileStream functionality.
+    
+    (C) 2024 Individual contributors, see AUTHORS file
+*/
+#include "testbase/testcase.h"
+
+//------------------------------------------------------------------------------
+namespace Test
+{
+class PackArchiveTest : public TestCase
+{
+    __DeclareClass(PackArchiveTest);
+public:
+    /// run the test
+    virtual void Run();
+};
+
+} // namespace Test
+//------------------------------------------------------------------------------
+#endif
@@ -0,0 +1,71 @@
+//------------------------------------------------------------------------------
+//  radixsorttest.cc
+//  (C) 2024 Individual contributors, see AUTHORS file
+//------------------------------------------------------------------------------
+#include "stdneb.h"
+#include "radixsorttest.h"
+#include "util/radixsort.h"
+#include "util/fixedarray.h"
+#include <algorithm>
+
+namespace Test
+{
+__ImplementClass(Test::RadixSortTest, 'RDXT', Test::TestCase);
+
+using namespace Util;
+
+//------------------------------------------------------------------------------
+/**
+*/
+static bool
+SortAndCompare(FixedArray<uint64>& keys)
+{
+    FixedArray<uint64> expected = keys;
+    std::sort(expected.Begin(), expected.End());
+
+    FixedArray<uint64> scratch(keys.Size());
+    const uint64* sorted = RadixSort(keys.Begin(), scratch.Begin(), keys.Size());
+    IndexT i;
+    for (i = 0; i < keys.Size(); i++)
+    {
+        if (sorted[i] != expected[i])
+            return false;
+    }
+    return true;
+}
+
+//------------------------------------------------------------------------------
+/**
+*/
+void
+RadixSortTest::Run()
+{
+    // nothing and a single key
+    FixedArray<uint64> keys;
+    VERIFY(SortAndCompare(keys));
+    keys.Resize(1);
+    keys[0] = 0x0123456789ABCDEF;
+    VERIFY(SortAndCompare(keys));
+
+    // keys which differ in every digit
+    keys.Resize(10007);
+    IndexT i;
+    for (i = 0; i < keys.Size(); i++)
+        keys[i] = ((uint64)Math::irand(0, 65535) << 48) | ((uint64)Math::irand(0, 65535) << 32) | ((uint64)Math::irand(0, 65535) << 16) | (uint64)Math::irand(0, 65535);
+    VERIFY(SortAndCompare(keys));
+
+    // keys which share most digits, so most passes are skipped, with duplicates
+    for (i = 0; i < keys.Size(); i++)
+        keys[i] = 0xABCD000000000000 | ((uint64)(i % 37) << 24) | (uint64)(keys.Size() - i) % 1000;
+    VERIFY(SortAndCompare(keys));
+
+    // already sorted, and reversed
+    for (i = 0; i < keys.Size(); i++)
+        keys[i] = (uint64)i << 20;
+    VERIFY(SortAndCompare(keys));
+    for (i = 0; i < keys.Size(); i++)
+        keys[i] = (uint64)(keys.Size() - i) << 20;
+    VERIFY(SortAndCompare(keys));
+}
+
+} // namespace Test
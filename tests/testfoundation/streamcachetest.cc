@@ -0,0 +1,152 @@
+//------------------------------------------------------------------------------
+//  streamcachetest.cc
+//  (C) 2024 Individual contributors, see AUTHORS file
+//------------------------------------------------------------------------------
+#include "stdneb.h"
+#include "streamcachetest.h"
+#include "io/ioserver.h"
+#include "io/assignregistry.h"
+#include "io/filestream.h"
+#include "io/cache/cachedstream.h"
+#include "io/cache/streamcache.h"
+
+namespace Test
+{
+__ImplementClass(Test::StreamCacheTest, 'STCT', Test::TestCase);
+
+using namespace IO;
+using namespace Util;
+
+//------------------------------------------------------------------------------
+/**
+    Cached stream over plain files, so the test doesn't depend on http.
+*/
+class CachedTestFileStream : public CachedStream
+{
+    __DeclareClass(CachedTestFileStream);
+protected:
+    virtual Core::Rtti const& GetParentRtti() { return FileStream::RTTI; };
+};
+__ImplementClass(Test::CachedTestFileStream, 'STCF', IO::CachedStream);
+
+//------------------------------------------------------------------------------
+/**
+*/
+static URI
+WriteTestFile(const String& path, uchar value, SizeT size)
+{
+    URI uri = AssignRegistry::Instance()->ResolveAssigns(path);
+    Array<uchar> data(size, 0, value);
+    Ptr<Stream> stream = IoServer::Instance()->CreateStream(uri);
+    stream->SetAccessMode(Stream::WriteAccess);
+    n_assert(stream->Open());
+    stream->Write(data.Begin(), size);
+    stream->Close();
+    return uri;
+}
+
+//------------------------------------------------------------------------------
+/**
+*/
+static Ptr<Stream>
+OpenCached(const URI& uri)
+{
+    Ptr<Stream> stream = CachedTestFileStream::Create();
+    stream->SetURI(uri);
+    stream->SetAccessMode(Stream::ReadAccess);
+    return stream->Open() ? stream : Ptr<Stream>();
+}
+
+//------------------------------------------------------------------------------
+/**
+*/
+void
+StreamCacheTest::Run()
+{
+    Ptr<IoServer> ioServer = IoServer::Create();
+    StreamCache* cache = StreamCache::Instance();
+    const SizeT size = 64 * 1024;
+
+    // two uris with the same content, one with different content
+    URI a = WriteTestFile("temp:streamcachetest_a.bin", 1, size);
+    URI b = WriteTestFile("temp:streamcachetest_b.bin", 1, size);
+    URI c = WriteTestFile("temp:streamcachetest_c.bin", 2, size);
+
+    Ptr<Stream> streamA = OpenCached(a);
+    VERIFY(streamA.isvalid());
+    VERIFY(streamA->GetSize() == size);
+    Ptr<Stream> streamB = OpenCached(b);
+    VERIFY(streamB.isvalid());
+    VERIFY(streamB->Map() == streamA->Map());
+    streamB->Unmap();
+    streamA->Unmap();
+    VERIFY(cache->GetStats().misses == 2);
+    VERIFY(cache->GetStats().dedups == 1);
+    VERIFY(cache->GetStats().numBlobs == 1);
+    VERIFY(cache->GetStats().numBytes == size);
+
+    Ptr<Stream> streamA2 = OpenCached(a);
+    VERIFY(cache->GetStats().hits == 1);
+    uchar byte = 0;
+    streamA2->Seek(size - 1, Stream::Begin);
+    VERIFY(streamA2->Read(&byte, 1) == 1 && byte == 1);
+    VERIFY(streamA2->Eof());
+    streamA2->Close();
+
+    // pinned content survives a budget smaller than the cache
+    cache->SetBudget(size);
+    Ptr<Stream> streamC = OpenCached(c);
+    VERIFY(streamC.isvalid());
+    VERIFY(cache->GetStats().numBytes == 2 * size);
+    VERIFY(cache->GetStats().evictions == 0);
+
+    // unpinning lets the least recently used blob go
+    streamA->Close();
+    streamB->Close();
+    VERIFY(cache->GetStats().evictions == 1);
+    VERIFY(!cache->IsCached(a));
+    VERIFY(!cache->IsCached(b));
+    VERIFY(cache->IsCached(c));
+    streamC->Close();
+    cache->Purge();
+    VERIFY(cache->GetStats().numBlobs == 0);
+
+    // the disk cache serves content after eviction
+    cache->SetDiskCacheDirectory("temp:streamcachetest");
+    streamC = OpenCached(c);
+    VERIFY(streamC.isvalid());
+    streamC->Close();
+    cache->Purge();
+    streamC = OpenCached(c);
+    VERIFY(streamC.isvalid());
+    VERIFY(cache->GetStats().diskHits == 1);
+    streamC->Seek(0, Stream::Begin);
+    VERIFY(streamC->Read(&byte, 1) == 1 && byte == 2);
+    streamC->Close();
+
+    // but not once the source has changed
+    cache->Purge();
+    WriteTestFile("temp:streamcachetest_c.bin", 3, size / 2);
+    streamC = OpenCached(c);
+    VERIFY(streamC.isvalid());
+    VERIFY(cache->GetStats().diskHits == 1);
+    VERIFY(streamC->GetSize() == size / 2);
+    VERIFY(streamC->Read(&byte, 1) == 1 && byte == 3);
+    streamC->Close();
+
+    // or is gone
+    cache->Purge();
+    ioServer->DeleteFile(c);
+    streamC = OpenCached(c);
+    VERIFY(!streamC.isvalid());
+    VERIFY(cache->GetStats().diskHits == 1);
+
+    cache->Purge();
+    cache->ClearDiskCache();
+    ioServer->DeleteDirectory("temp:streamcachetest");
+    cache->SetDiskCacheDirectory(URI());
+    ioServer->DeleteFile(a);
+    ioServer->DeleteFile(b);
+}
+
+} // namespace Test
@@ -0,0 +1,26 @@
+#ifndef TEST_STREAMCACHETEST_H
+#define TEST_STREAMCACHETEST_H
+//------------------------------------------------------------------------------
+/**
+    @class Test::StreamCacheTest
+    
+    Test IO::StreamCache deduplication, eviction and disk cache.
+    
+    (C) 2024 Individual contributors, see AUTHORS file
+*/
+#include "testbase/testcase.h"
+
+//------------------------------------------------------------------------------
+namespace Test
+{
+class StreamCacheTest : public TestCase
+{
+    __DeclareClass(StreamCacheTest);
+public:
+    /// run the test
+    virtual void Run();
+};
+
+} // namespace Test
+//------------------------------------------------------------------------------
+#endif
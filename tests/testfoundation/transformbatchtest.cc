@@ -0,0 +1,205 @@
+//------------------------------------------------------------------------------
+//  transformbatchtest.cc
+//  (C) 2024 Individual contributors, see AUTHORS file
+//------------------------------------------------------------------------------
+#include "stdneb.h"
+#include "math/transformbatch.h"
+#include "math/quat.h"
+#include "system/cpu.h"
+#include "transformbatchtest.h"
+
+namespace Test
+{
+__ImplementClass(Test::TransformBatchTest, 'TBTS', Test::TestCase);
+
+using namespace Math;
+
+typedef SizeT (*EvaluateFunc)(const TransformBatch& batch, const IndexT* parents, const IndexT* order, const IndexT* follow, mat4* unscaled, mat4* scaled);
+typedef void (*SkinFunc)(const mat4* model, const mat4* inverseBind, const IndexT* palette, const IndexT* follow, SizeT num, mat4* out);
+
+//------------------------------------------------------------------------------
+/**
+*/
+static bool
+NearEqual(const mat4& m0, const mat4& m1)
+{
+    IndexT i, j;
+    for (i = 0; i < 4; i++)
+    {
+        for (j = 0; j < 4; j++)
+        {
+            if (Math::abs(m0.m[i][j] - m1.m[i][j]) > 0.0001f * (1.0f + Math::abs(m1.m[i][j])))
+                return false;
+        }
+    }
+    return true;
+}
+
+//------------------------------------------------------------------------------
+/**
+    Builds a random hierarchy of num joints with scale, where the joints are
+    numbered in a different order than they are evaluated in, and some of
+    the leaves follow a joint evaluated before them
+*/
+static void
+SetupHierarchy(SizeT num, TransformBatch& batch, Util::FixedArray<IndexT>& parents, Util::FixedArray<IndexT>& order, Util::FixedArray<IndexT>& follow)
+{
+    order.Resize(num);
+    IndexT i;
+    for (i = 0; i < num; i++)
+        order[i] = i;
+    for (i = num - 1; i > 0; i--)
+    {
+        const IndexT j = Math::min(IndexT(Math::rand() * (i + 1)), i);
+        const IndexT swap = order[i];
+        order[i] = order[j];
+        order[j] = swap;
+    }
+
+    // parents are picked among the joints evaluated before
+    parents.Resize(num);
+    Util::FixedArray<bool> hasChildren(num, false);
+    parents[order[0]] = InvalidIndex;
+    for (i = 1; i < num; i++)
+    {
+        const IndexT parent = Math::rand() < 0.1f ? InvalidIndex : order[Math::min(IndexT(Math::rand() * i), i - 1)];
+        parents[order[i]] = parent;
+        if (parent != InvalidIndex)
+            hasChildren[parent] = true;
+    }
+
+    follow.Resize(num);
+    follow.Fill(InvalidIndex);
+    for (i = 1; i < num; i++)
+    {
+        if (!hasChildren[order[i]] && Math::rand() < 0.2f)
+            follow[order[i]] = order[Math::min(IndexT(Math::rand() * i), i - 1)];
+    }
+
+    // rotations don't have to be normalized
+    for (i = 0; i < num; i++)
+    {
+        const quat rotation = quatyawpitchroll(Math::rand(-N_PI, N_PI), Math::rand(-N_PI, N_PI), Math::rand(-N_PI, N_PI));
+        const float length = Math::rand(0.8f, 1.2f);
+        batch.rotation[0][i] = rotation.x * length;
+        batch.rotation[1][i] = rotation.y * length;
+        batch.rotation[2][i] = rotation.z * length;
+        batch.rotation[3][i] = rotation.w * length;
+        IndexT j;
+        for (j = 0; j < 3; j++)
+        {
+            batch.translation[j][i] = Math::rand(-1.0f, 1.0f);
+            batch.scale[j][i] = Math::rand(0.5f, 2.0f);
+        }
+    }
+}
+
+//------------------------------------------------------------------------------
+/**
+    Children get the unscaled matrix of their parent, joints which follow
+    another joint get its scaled matrix
+*/
+static SizeT
+ReferenceEvaluate(const TransformBatch& batch, const IndexT* parents, const IndexT* order, const IndexT* follow, mat4* unscaled, mat4* scaled)
+{
+    SizeT numEvaluated = 0;
+    IndexT i;
+    for (i = 0; i < batch.num; i++)
+    {
+        const IndexT joint = order[i];
+        const quat rotation(batch.rotation[0][joint], batch.rotation[1][joint], batch.rotation[2][joint], batch.rotation[3][joint]);
+        const vec3 translation(batch.translation[0][joint], batch.translation[1][joint], batch.translation[2][joint]);
+        const vec3 scale(batch.scale[0][joint], batch.scale[1][joint], batch.scale[2][joint]);
+        unscaled[joint] = affine(vec3(1.0f), rotation, translation);
+        scaled[joint] = affine(scale, rotation, translation);
+        if (follow[joint] != InvalidIndex)
+        {
+            scaled[joint] = scaled[follow[joint]];
+            continue;
+        }
+        numEvaluated++;
+
+        const IndexT parent = parents[joint];
+        if (parent != InvalidIndex)
+        {
+            unscaled[joint] = unscaled[parent] * unscaled[joint];
+            scaled[joint] = unscaled[parent] * scaled[joint];
+        }
+    }
+    return numEvaluated;
+}
+
+//------------------------------------------------------------------------------
+/**
+*/
+void
+TransformBatchTest::Run()
+{
+    srand(4711);
+    Util::Array<EvaluateFunc> evaluates;
+    Util::Array<SkinFunc> skins;
+    evaluates.Append(transformbatch_evaluate_sse);
+    skins.Append(transformbatch_skin_sse);
+    if (System::Cpu::HasFeature(System::Cpu::AVX2))
+    {
+        evaluates.Append(transformbatch_evaluate_avx2);
+        skins.Append(transformbatch_skin_avx2);
+    }
+
+    // sizes below, at and past the batch width
+    const SizeT sizes[] = { 1, 5, TransformBatchWidth, 37, 64 };
+    IndexT size;
+    for (size = 0; size < (IndexT)(sizeof(sizes) / sizeof(sizes[0])); size++)
+    {
+        const SizeT num = sizes[size];
+        Util::FixedArray<float> memory(transformbatch_size(num));
+        TransformBatch batch;
+        transformbatch_setup(batch, memory.Begin(), num);
+        Util::FixedArray<IndexT> parents, order, follow;
+        SetupHierarchy(num, batch, parents, order, follow);
+
+        Util::FixedArray<mat4> expectedUnscaled(num), expectedScaled(num);
+        const SizeT expectedEvaluated = ReferenceEvaluate(batch, parents.Begin(), order.Begin(), follow.Begin(), expectedUnscaled.Begin(), expectedScaled.Begin());
+
+        // skin every joint in reverse, and a few twice
+        Util::Array<IndexT> palette;
+        Util::FixedArray<mat4> inverseBind(num);
+        IndexT i;
+        for (i = 0; i < num; i++)
+        {
+            palette.Append(num - 1 - i);
+            inverseBind[i] = affine(vec3(1.0f), quatyawpitchroll(Math::rand(-N_PI, N_PI), 0.0f, 0.0f), vec3(0.0f, Math::rand(-1.0f, 0.0f), 0.0f));
+        }
+        palette.Append(0);
+        palette.Append(num / 2);
+        Util::FixedArray<mat4> expectedSkin(palette.Size());
+        for (i = 0; i < palette.Size(); i++)
+        {
+            const IndexT joint = follow[palette[i]] != InvalidIndex ? follow[palette[i]] : palette[i];
+            expectedSkin[i] = expectedScaled[joint] * inverseBind[joint];
+        }
+
+        IndexT kernel;
+        for (kernel = 0; kernel < evaluates.Size(); kernel++)
+        {
+            Util::FixedArray<mat4> unscaled(num), scaled(num), skin(palette.Size());
+            const SizeT numEvaluated = evaluates[kernel](batch, parents.Begin(), order.Begin(), follow.Begin(), unscaled.Begin(), scaled.Begin());
+            skins[kernel](expectedScaled.Begin(), inverseBind.Begin(), palette.Begin(), follow.Begin(), palette.Size(), skin.Begin());
+            VERIFY(numEvaluated == expectedEvaluated);
+
+            bool unscaledMatches = true, scaledMatches = true, skinMatches = true;
+            for (i = 0; i < num; i++)
+            {
+                unscaledMatches &= follow[i] != InvalidIndex || NearEqual(unscaled[i], expectedUnscaled[i]);
+                scaledMatches &= NearEqual(scaled[i], expectedScaled[i]);
+            }
+            for (i = 0; i < palette.Size(); i++)
+                skinMatches &= NearEqual(skin[i], expectedSkin[i]);
+            VERIFY(unscaledMatches);
+            VERIFY(scaledMatches);
+            VERIFY(skinMatches);
+        }
+    }
+}
+
+} // namespace Test
@@ -10,6 +10,7 @@
 #include "framesync/framesynctimer.h"
 #include "profiling/profiling.h"
 #include "game/gameserver.h"
+#include "game/worldsnapshot.h"
 #include "testcomponents.h"
 
 #include "flatbuffers/idl.h"
@@ -437,6 +438,345 @@ EntitySystemTest::Run()
     
     StepFrame();
 
+    // Test dependency scheduling of async processors
+    {
+        // the processors keep running after this block, so their state has to outlive it
+        static int frameValue;
+        static Threading::AtomicCounter numMismatches;
+        frameValue = 0;
+        numMismatches = 0;
+        std::function writeFunc = [](World* world, Test::TestStruct& testStruct, Test::TestAsyncComponent)
+        {
+            testStruct.foo = frameValue;
+        };
+        std::function readFunc = [](World* world, Test::TestStruct const& testStruct, Test::TestAsyncComponent)
+        {
+            if (testStruct.foo != frameValue)
+                Threading::Interlocked::Increment(&numMismatches);
+        };
+        std::function healthFunc = [](World* world, Test::TestHealth const& testHealth, Test::TestAsyncComponent)
+        {
+        };
+
+        Game::ProcessorBuilder(world, "TestScheduleWrite").On("OnFrame").Func(writeFunc).Async().Build();
+        Game::ProcessorBuilder(world, "TestScheduleRead").On("OnFrame").Func(readFunc).Async().Build();
+        Game::ProcessorBuilder(world, "TestScheduleHealth").On("OnFrame").Func(healthFunc).Async().Build();
+
+        IndexT writeNode = InvalidIndex, readNode = InvalidIndex, healthNode = InvalidIndex;
+        auto const& schedule = world->GetFramePipeline().GetFrameEvent("OnFrame")->GetSchedule();
+        for (IndexT i = 0; i < schedule.Size(); i++)
+        {
+            if (schedule[i].processor->name == "TestScheduleWrite")
+                writeNode = i;
+            else if (schedule[i].processor->name == "TestScheduleRead")
+                readNode = i;
+            else if (schedule[i].processor->name == "TestScheduleHealth")
+                healthNode = i;
+        }
+        VERIFY(writeNode != InvalidIndex && readNode != InvalidIndex && healthNode != InvalidIndex);
+
+        // the reader has to wait for the writer, while the health reader depends on neither
+        VERIFY(schedule[readNode].predecessors.FindIndex(writeNode) != InvalidIndex);
+        VERIFY(schedule[healthNode].predecessors.FindIndex(writeNode) == InvalidIndex);
+        VERIFY(schedule[healthNode].predecessors.FindIndex(readNode) == InvalidIndex);
+
+        for (frameValue = 1; frameValue < 4; frameValue++)
+        {
+            StepFrame();
+        }
+        VERIFY(numMismatches == 0);
+        VERIFY(world->GetFramePipeline().GetFrameEvent("OnFrame")->GetCriticalPathTime() > 0);
+        VERIFY(world->GetFramePipeline().DumpSchedule().FindStringIndex("TestScheduleRead") != InvalidIndex);
+    }
+
+    // Test per component change detection
+    {
+        Entity entity = world->CreateEntity({.templateId = playerBlueprint, .immediate = true});
+        StepFrame();
+
+        Game::Filter filter = Game::FilterBuilder().Including<const TestHealth>().Changed<TestHealth>().Build();
+        uint64_t const tick = world->GetChangeTick();
+
+        // nothing has written to the health component since the tick
+        Game::Dataset data = world->Query(filter, tick);
+        VERIFY(data.numViews == 0);
+
+        TestHealth health;
+        health.value = 1337;
+        world->SetComponent(entity, health);
+
+        // only the partition that holds the entity should be returned, with only the entity marked as modified
+        MemDb::RowId const row = world->GetInstance(entity);
+        data = world->Query(filter, tick);
+        VERIFY(data.numViews == 1);
+        if (data.numViews == 1)
+        {
+            VERIFY(data.views[0].partitionId == row.partition);
+            VERIFY(data.views[0].modifiedInstances.IsSet(row.index));
+            uint32_t numModified = 0;
+            for (uint16_t i = 0; i < data.views[0].numInstances; i++)
+                numModified += data.views[0].modifiedInstances.IsSet(i) ? 1 : 0;
+            VERIFY(numModified == 1);
+        }
+
+        // a newer tick should not see the write
+        data = world->Query(filter, world->GetChangeTick());
+        VERIFY(data.numViews == 0);
+        Game::DestroyFilter(filter);
+        Game::ReleaseDatasets();
+
+        // processors that only care about health should not wake up when other components are written to.
+        // The processors keep running after this block, so their state has to outlive it.
+        static int numHealthUpdates;
+        numHealthUpdates = 0;
+        std::function healthChanged = [](World* world, Test::TestHealth const& testHealth)
+        {
+            numHealthUpdates++;
+        };
+        Game::ProcessorBuilder(world, "TestHealthChanged").On("OnEndFrame").OnlyModified<TestHealth>().Func(healthChanged).Build();
+
+        StepFrame();
+        VERIFY(numHealthUpdates == 1);
+
+        numHealthUpdates = 0;
+        StepFrame();
+        VERIFY(numHealthUpdates == 0);
+
+        world->SetComponent(entity, health);
+        StepFrame();
+        VERIFY(numHealthUpdates == 1);
+
+        // a processor writes TestStruct of the entity, which should stamp only that row, and not wake up the health processor
+        static bool writeStruct;
+        writeStruct = false;
+        std::function structWriter = [entity](World* world, Game::Entity const& owner, Test::TestStruct& testStruct)
+        {
+            if (writeStruct && owner == entity)
+                testStruct.foo++;
+        };
+        Game::ProcessorBuilder(world, "TestStructWriter").On("OnFrame").Func(structWriter).Build();
+
+        Game::Filter structFilter = Game::FilterBuilder().Including<const TestStruct>().Changed<TestStruct>().Build();
+        auto CountStructWrites = [world, structFilter, row](uint64_t since, bool& entityWritten)
+        {
+            SizeT numWritten = 0;
+            entityWritten = false;
+            Game::Dataset data = world->Query(structFilter, since);
+            for (uint32_t v = 0; v < data.numViews; v++)
+            {
+                for (uint16_t i = 0; i < data.views[v].numInstances; i++)
+                {
+                    if (data.views[v].modifiedInstances.IsSet(i))
+                    {
+                        numWritten++;
+                        entityWritten |= data.views[v].partitionId == row.partition && i == row.index;
+                    }
+                }
+            }
+            Game::ReleaseDatasets();
+            return numWritten;
+        };
+
+        // the async test processors write TestStruct of their own entities every frame, so only look at the player's partition
+        numHealthUpdates = 0;
+        uint64_t structTick = world->GetChangeTick();
+        bool entityWritten = false;
+        StepFrame();
+        CountStructWrites(structTick, entityWritten);
+        VERIFY(!entityWritten);
+
+        int const foo = world->GetComponent<TestStruct>(entity).foo;
+        structTick = world->GetChangeTick();
+        writeStruct = true;
+        StepFrame();
+        writeStruct = false;
+        VERIFY(CountStructWrites(structTick, entityWritten) > 0);
+        VERIFY(entityWritten);
+        VERIFY(world->GetComponent<TestStruct>(entity).foo == foo + 1);
+        VERIFY(numHealthUpdates == 0);
+
+        // and the write is not seen by anyone asking for changes after it
+        CountStructWrites(world->GetChangeTick(), entityWritten);
+        VERIFY(!entityWritten);
+
+        // processors which stamp all writes mark every row they process, even without changing it
+        std::function structToucher = [](World* world, Test::TestStruct& testStruct, Test::TestEmptyStruct)
+        {
+        };
+        Game::Processor* toucher = Game::ProcessorBuilder(world, "TestStructToucher").On("OnFrame").Func(structToucher).StampAllWrites().Build();
+        VERIFY(toucher->stampAllWrites);
+        structTick = world->GetChangeTick();
+        StepFrame();
+        CountStructWrites(structTick, entityWritten);
+        VERIFY(entityWritten);
+        VERIFY(numHealthUpdates == 0);
+        Game::DestroyFilter(structFilter);
+
+        // processors that can write to health only count as writing to the rows they actually change
+        static bool writeHealth;
+        writeHealth = false;
+        std::function healthWriter = [entity](World* world, Game::Entity const& owner, Test::TestHealth& testHealth)
+        {
+            if (writeHealth && owner == entity)
+                testHealth.value++;
+        };
+        Game::ProcessorBuilder(world, "TestHealthWriter").On("OnFrame").Func(healthWriter).Build();
+
+        numHealthUpdates = 0;
+        StepFrame();
+        VERIFY(numHealthUpdates == 0);
+
+        writeHealth = true;
+        StepFrame();
+        writeHealth = false;
+        VERIFY(numHealthUpdates == 1);
+    }
+
+    // Test deferred commands from async processors
+    {
+        // the processor keeps running after this block, so its state has to outlive it
+        static bool spawn;
+        static bool despawn;
+        spawn = false;
+        despawn = false;
+        std::function spawnFunc = [enemyBlueprint](World* world, Game::Entity const& entity, Test::TestHealth const& testHealth, Test::TestAsyncComponent)
+        {
+            if (spawn)
+            {
+                TestHealth health;
+                health.value = 4711;
+                world->GetCommandBuffer().CreateEntity(enemyBlueprint, health);
+            }
+            if (despawn)
+            {
+                world->GetCommandBuffer().DeleteEntity(entity);
+            }
+        };
+        Game::ProcessorBuilder(world, "TestDeferredSpawn").On("OnFrame").Func(spawnFunc).Async().Build();
+
+        Game::Filter spawnedFilter = Game::FilterBuilder().Including<const TestHealth, const TestVec4>().Build();
+        auto CountSpawned = [world, spawnedFilter]()
+        {
+            SizeT numSpawned = 0;
+            Game::Dataset data = world->Query(spawnedFilter);
+            for (uint32_t v = 0; v < data.numViews; v++)
+            {
+                TestHealth const* healths = (TestHealth const*)data.views[v].buffers[0];
+                for (uint32_t i = 0; i < data.views[v].numInstances; i++)
+                {
+                    if (data.views[v].validInstances.IsSet(i) && healths[i].value == 4711)
+                        numSpawned++;
+                }
+            }
+            Game::ReleaseDatasets();
+            return numSpawned;
+        };
+
+        // every async test entity spawns one enemy
+        SizeT const numEntities = world->GetNumEntities();
+        spawn = true;
+        StepFrame();
+        spawn = false;
+        SizeT const numSpawned = world->GetNumEntities() - numEntities;
+        VERIFY(numSpawned > 0);
+        VERIFY(CountSpawned() == numSpawned);
+
+        // the spawned enemies don't have the async component, so nothing more should be spawned
+        StepFrame();
+        VERIFY(world->GetNumEntities() == numEntities + numSpawned);
+
+        // every async test entity deletes itself
+        despawn = true;
+        StepFrame();
+        despawn = false;
+        VERIFY(world->GetNumEntities() == numEntities);
+        Game::DestroyFilter(spawnedFilter);
+    }
+
+    // Test world snapshots
+    {
+        Entity entity = world->CreateEntity({.templateId = playerBlueprint, .immediate = true});
+        TestHealth health;
+        health.value = 100;
+        world->SetComponent(entity, health);
+        StepFrame();
+
+        Util::Blob const snapshot = Game::WorldSnapshot::Write(world);
+        VERIFY(!Game::WorldSnapshot::IsDelta(snapshot.GetPtr(), snapshot.Size()));
+
+        health.value = 200;
+        world->SetComponent(entity, health);
+        StepFrame();
+
+        Util::Blob const delta = Game::WorldSnapshot::WriteDelta(world, snapshot.GetPtr(), snapshot.Size());
+        VERIFY(Game::WorldSnapshot::IsDelta(delta.GetPtr(), delta.Size()));
+        VERIFY(delta.Size() < snapshot.Size());
+
+        SizeT const numEntities = world->GetNumEntities();
+        Entity const deleted = world->CreateEntity({.templateId = enemyBlueprint, .immediate = true});
+        world->AddComponent<DecayTestComponent>(deleted);
+        StepFrame();
+        VERIFY(world->GetDecayBuffer(Game::GetComponentId<DecayTestComponent>()).size == 0);
+
+        Game::WorldSnapshot::Read(world, snapshot.GetPtr(), snapshot.Size());
+        VERIFY(world->GetNumEntities() == numEntities);
+        VERIFY(!world->IsValid(deleted));
+        // the components of the replaced entities are released
+        VERIFY(world->GetDecayBuffer(Game::GetComponentId<DecayTestComponent>()).size > 0);
+        VERIFY(world->IsValid(entity));
+        VERIFY(world->GetComponent<TestHealth>(entity).value == 100);
+
+        Game::WorldSnapshot::Read(world, delta.GetPtr(), delta.Size(), snapshot.GetPtr(), snapshot.Size());
+        VERIFY(world->IsValid(entity));
+        VERIFY(world->GetComponent<TestHealth>(entity).value == 200);
+        StepFrame();
+
+        // writes of a processor end up in the delta
+        Util::Blob const base = Game::WorldSnapshot::Write(world);
+        int const foo = world->GetComponent<TestStruct>(entity).foo;
+        std::function fooWriter = [entity](World* world, Game::Entity const& owner, Test::TestStruct& testStruct)
+        {
+            if (owner == entity)
+                testStruct.foo = 4711;
+        };
+        Game::ProcessorBuilder(world, "TestSnapshotWriter").On("OnFrame").Func(fooWriter).Build();
+        StepFrame();
+        VERIFY(world->GetComponent<TestStruct>(entity).foo == 4711);
+
+        // so do writes straight into a view, which don't bump any change tick
+        Game::Filter structFilter = Game::FilterBuilder().Including<const Game::Entity, TestStruct>().Build();
+        Game::Dataset data = world->Query(structFilter);
+        for (uint32_t v = 0; v < data.numViews; v++)
+        {
+            Game::Entity const* owners = (Game::Entity const*)data.views[v].buffers[0];
+            TestStruct* structs = (TestStruct*)data.views[v].buffers[1];
+            for (uint16_t i = 0; i < data.views[v].numInstances; i++)
+            {
+                if (data.views[v].validInstances.IsSet(i) && owners[i] == entity)
+                    structs[i].bar = 47.11f;
+            }
+        }
+        Game::ReleaseDatasets();
+        Game::DestroyFilter(structFilter);
+
+        Util::Blob const writes = Game::WorldSnapshot::WriteDelta(world, base.GetPtr(), base.Size());
+        Game::WorldSnapshot::Read(world, base.GetPtr(), base.Size());
+        VERIFY(world->GetComponent<TestStruct>(entity).foo == foo);
+        Game::WorldSnapshot::Read(world, writes.GetPtr(), writes.Size(), base.GetPtr(), base.Size());
+        VERIFY(world->GetComponent<TestStruct>(entity).foo == 4711);
+        VERIFY(world->GetComponent<TestStruct>(entity).bar == 47.11f);
+        VERIFY(world->GetComponent<TestHealth>(entity).value == 200);
+
+        // a delta of an unchanged world references all column data in the base
+        Util::Blob const restored = Game::WorldSnapshot::Write(world);
+        Util::Blob const unchanged = Game::WorldSnapshot::WriteDelta(world, restored.GetPtr(), restored.Size());
+        VERIFY(unchanged.Size() < writes.Size());
+
+        Game::WorldSnapshot::Read(world, snapshot.GetPtr(), snapshot.Size());
+        VERIFY(world->GetNumEntities() == numEntities);
+        StepFrame();
+    }
+
     t->StopTime();
 }
 
@@ -17,6 +17,9 @@ namespace Test
 
 __DeclareMsg(TestMsg, 'tsMs', int, float);
 
+/// run one frame of the game server
+void StepFrame();
+
 class EntitySystemTest : public TestCase
 {
     __DeclareClass(EntitySystemTest);
@@ -0,0 +1,135 @@
+//------------------------------------------------------------------------------
+//  leveltest.cc
+//  (C) 2024 Individual contributors, see AUTHORS file
+//------------------------------------------------------------------------------
+#include "stdneb.h"
+#include "leveltest.h"
+#include "entitysystemtest.h"
+#include "game/api.h"
+#include "game/world.h"
+#include "basegamefeature/level.h"
+#include "io/ioserver.h"
+#include "timing/time.h"
+#include "testcomponents.h"
+
+using namespace Game;
+
+namespace Test
+{
+__ImplementClass(Test::LevelTest, 'LVTS', Test::TestCase);
+
+static const SizeT NumLevelEntities = 100;
+
+//------------------------------------------------------------------------------
+/**
+    Sum of the health of the entities, to check that the level data is copied
+*/
+static uint
+SumHealth(World* world, Util::Array<Entity> const& entities)
+{
+    uint sum = 0;
+    for (IndexT i = 0; i < entities.Size(); i++)
+    {
+        if (world->HasComponent<TestHealth>(entities[i]))
+            sum += world->GetComponent<TestHealth>(entities[i]).value;
+    }
+    return sum;
+}
+
+//------------------------------------------------------------------------------
+/**
+*/
+static void
+DeleteEntities(World* world, Util::Array<Entity> const& entities)
+{
+    for (IndexT i = 0; i < entities.Size(); i++)
+        world->DeleteEntity(entities[i]);
+    StepFrame();
+}
+
+//------------------------------------------------------------------------------
+/**
+*/
+void
+LevelTest::Run()
+{
+    World* world = Game::GetWorld(WORLD_DEFAULT);
+    TemplateId const playerBlueprint = Game::GetTemplateId("Player"_atm);
+    TemplateId const enemyBlueprint = Game::GetTemplateId("Enemy"_atm);
+    Util::String const path = "temp:leveltest.nlvl";
+
+    // export a small level from the world. Entities that exist before the test end up in the level as well.
+    StepFrame();
+    SizeT const numEntities = world->GetNumEntities();
+    SizeT const numExported = numEntities + NumLevelEntities;
+    Util::Array<Entity> source;
+    for (IndexT i = 0; i < NumLevelEntities; i++)
+    {
+        Entity const entity = world->CreateEntity({.templateId = (i % 3) == 0 ? playerBlueprint : enemyBlueprint, .immediate = true});
+        TestHealth health;
+        health.value = 1000 + i;
+        world->SetComponent(entity, health);
+        source.Append(entity);
+    }
+    StepFrame();
+    uint const sourceHealth = SumHealth(world, source);
+    VERIFY(sourceHealth > 0);
+    world->ExportLevel(path);
+    DeleteEntities(world, source);
+    VERIFY(world->GetNumEntities() == numEntities);
+
+    // preload and instantiate it
+    PackedLevel* level = world->PreloadLevel(path);
+    VERIFY(level->IsLoaded());
+    Util::Array<Entity> instantiated = level->Instantiate();
+    VERIFY(instantiated.Size() == numExported);
+    VERIFY(world->GetNumEntities() == numEntities + numExported);
+    VERIFY(SumHealth(world, instantiated) >= sourceHealth);
+
+    // a level can be instantiated more than once
+    Util::Array<Entity> again = level->Instantiate();
+    VERIFY(again.Size() == numExported);
+    VERIFY(world->GetNumEntities() == numEntities + 2 * numExported);
+    world->UnloadLevel(level);
+    StepFrame();
+    DeleteEntities(world, instantiated);
+    DeleteEntities(world, again);
+    VERIFY(world->GetNumEntities() == numEntities);
+
+    // an async preload that is unloaded before it has finished never calls back
+    int numCallbacks = 0;
+    PackedLevel* cancelled = world->PreloadLevelAsync(path, [&numCallbacks](PackedLevel*) { numCallbacks++; });
+    world->UnloadLevel(cancelled);
+    StepFrame();
+    StepFrame();
+    VERIFY(numCallbacks == 0);
+    VERIFY(world->GetNumEntities() == numEntities);
+
+    // preloading the same level again afterwards works
+    PackedLevel* loaded = nullptr;
+    PackedLevel* retried = world->PreloadLevelAsync(path, [&numCallbacks, &loaded](PackedLevel* preloaded) { numCallbacks++; loaded = preloaded; });
+    IndexT frame;
+    for (frame = 0; frame < 1000 && loaded == nullptr; frame++)
+    {
+        StepFrame();
+        if (loaded == nullptr)
+            Timing::Sleep(0.001);
+    }
+    VERIFY(numCallbacks == 1);
+    VERIFY(loaded == retried);
+    if (loaded == retried)
+    {
+        VERIFY(retried->IsLoaded());
+        instantiated = retried->Instantiate();
+        VERIFY(instantiated.Size() == numExported);
+        VERIFY(world->GetNumEntities() == numEntities + numExported);
+        VERIFY(SumHealth(world, instantiated) >= sourceHealth);
+        DeleteEntities(world, instantiated);
+    }
+    world->UnloadLevel(retried);
+    VERIFY(world->GetNumEntities() == numEntities);
+
+    IO::IoServer::Instance()->DeleteFile(path);
+}
+
+} // namespace Test
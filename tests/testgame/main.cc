@@ -13,6 +13,7 @@
 #include "idtest.h"
 #include "databasetest.h"
 #include "entitysystemtest.h"
+#include "leveltest.h"
 #include "scriptingtest.h"
 
 #include "testcomponents.h"
@@ -96,6 +97,8 @@ NebulaMain(const Util::CommandLineArgs& args)
     Ptr<TestRunner> testRunner = TestRunner::Create();
     testRunner->AttachTestCase(IdTest::Create());
     testRunner->AttachTestCase(DatabaseTest::Create());
+    // runs before the entity system test, which leaves processors and entities behind
+    testRunner->AttachTestCase(LevelTest::Create());
     testRunner->AttachTestCase(EntitySystemTest::Create());
     //testRunner->AttachTestCase(ScriptingTest::Create());
     
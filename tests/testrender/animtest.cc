@@ -7,6 +7,7 @@
 #include "coreanimation/animcurve.h"
 #include "timing/time.h"
 #include "coreanimation/animation.h"
+#include "coreanimation/animkeycompression.h"
 #include "animtest.h"
 namespace Test
 {
@@ -134,6 +135,64 @@ AnimTest::Run()
     VERIFY(value[7] == 0.0f);
     VERIFY(value[8] == 0.0f);
     VERIFY(value[9] == 1.0f);
+
+    // Compressed keys, a translation curve and a rotation curve with 2 intervals each
+    const float translations[] = { 0, 1, 2, 3, 4, 5, 6, 7, 8 };
+    const Math::quat rotations[] =
+    {
+        Math::quat(0, 0, 0, 1)
+        , Math::rotationquataxis(Math::vec3(0, 1, 0), Math::deg2rad(90.0f))
+        , Math::rotationquataxis(Math::vec3(0, 1, 0), Math::deg2rad(180.0f))
+    };
+    ushort compressedKeys[6 * AnimKeyCompressedStride + 1] = {};
+    AnimCurve compressedPos = posCurve;
+    compressedPos.numIntervals = 2;
+    compressedPos.keyOffset = Math::vec4(0, 1, 2, 0);
+    compressedPos.keyScale = Math::vec4(6.0f / 65535.0f, 6.0f / 65535.0f, 6.0f / 65535.0f, 0);
+    IndexT i;
+    for (i = 0; i < 3; i++)
+    {
+        AnimKeyEncodeVector(&translations[i * 3], compressedPos.keyOffset, compressedPos.keyScale, &compressedKeys[i * AnimKeyCompressedStride]);
+        AnimKeyEncodeRotation(rotations[i], &compressedKeys[(i + 3) * AnimKeyCompressedStride]);
+    }
+    AnimCurve compressedRot;
+    compressedRot.firstIntervalOffset = 2;
+    compressedRot.numIntervals = 2;
+    compressedRot.curveType = CurveType::Rotation;
+    compressedRot.postInfinityType = InfinityType::Cycle;
+    compressedRot.preInfinityType = InfinityType::Cycle;
+
+    const float duration = 1.0f / 24.0f;
+    AnimKeyBuffer::Interval compressedIntervals[] = {
+        { 0, 24, 0, 3, duration }, { 24, 48, 3, 6, duration }
+        , { 0, 24, 9, 12, duration }, { 24, 48, 12, 15, duration }
+    };
+    Ptr<AnimKeyBuffer> compressedBuffer = AnimKeyBuffer::Create();
+    compressedBuffer->Setup(4, sizeof(compressedKeys) / sizeof(ushort), compressedIntervals, compressedKeys, nullptr, true);
+    VERIFY(compressedBuffer->IsCompressed());
+    VERIFY(compressedBuffer->GetKeyBufferPointer() == nullptr);
+
+    Util::FixedArray<AnimCurve> compressedCurves = { compressedPos, compressedRot };
+    clip.numCurves = 2;
+    uint compressedIndices[2] = { 0, 0 };
+    float compressedValue[7];
+    uchar compressedCount[2] = { 0, 0 };
+
+    // Halfway into the second interval
+    AnimSample(SampleType::Linear, clip, compressedCurves, 36, Math::vec4{ 1 }, idleSamples, compressedBuffer, compressedIndices, compressedValue, compressedCount);
+    const Math::quat expected = Math::slerp(rotations[1], rotations[2], 0.5f);
+    VERIFY(compressedCount[0] == 1 && compressedCount[1] == 1);
+    VERIFY(Math::nearequal(compressedValue[0], 4.5f, 0.001f));
+    VERIFY(Math::nearequal(compressedValue[1], 5.5f, 0.001f));
+    VERIFY(Math::nearequal(compressedValue[2], 6.5f, 0.001f));
+    VERIFY(Math::abs(Math::dot(Math::quat(compressedValue[3], compressedValue[4], compressedValue[5], compressedValue[6]), expected)) > 0.9999f);
+
+    // Step takes the first key of the interval
+    AnimSample(SampleType::Step, clip, compressedCurves, 12, Math::vec4{ 1 }, idleSamples, compressedBuffer, compressedIndices, compressedValue, compressedCount);
+    VERIFY(Math::nearequal(compressedValue[0], 0.0f, 0.001f));
+    VERIFY(Math::nearequal(compressedValue[1], 1.0f, 0.001f));
+    VERIFY(Math::nearequal(compressedValue[2], 2.0f, 0.001f));
+    VERIFY(Math::abs(compressedValue[6]) > 0.9999f);
 }
 
 } // namespace Test
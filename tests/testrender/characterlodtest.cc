@@ -0,0 +1,93 @@
+//------------------------------------------------------------------------------
+//  @file characterlodtest.cc
+//  @copyright (C) 2024 Individual contributors, see AUTHORS file
+//------------------------------------------------------------------------------
+#include "foundation/stdneb.h"
+#include "characters/charactercontext.h"
+#include "characterlodtest.h"
+
+using namespace Characters;
+namespace Test
+{
+
+__ImplementClass(CharacterLodTest, 'CLTE', Core::RefCounted);
+
+//------------------------------------------------------------------------------
+/**
+*/
+void
+CharacterLodTest::Run()
+{
+    // A small skeleton standing on the origin, with a two joint finger on the hand
+    struct
+    {
+        IndexT parent;
+        Math::vec3 position;
+    } skeleton[] =
+    {
+        { InvalidIndex, Math::vec3(0, 0, 0) },      // 0 root
+        { 0, Math::vec3(0, 1.0f, 0) },              // 1 spine
+        { 1, Math::vec3(0, 1.8f, 0) },              // 2 head
+        { 1, Math::vec3(0.5f, 1.5f, 0) },           // 3 hand
+        { 3, Math::vec3(0.7f, 1.5f, 0) },           // 4 finger
+        { 4, Math::vec3(0.75f, 1.5f, 0) },          // 5 finger tip
+        { 0, Math::vec3(-1.0f, 0, 0) },             // 6 leg
+    };
+    const SizeT numJoints = sizeof(skeleton) / sizeof(skeleton[0]);
+
+    Util::FixedArray<CharacterJoint> joints(numJoints);
+    Util::FixedArray<Math::mat4> bindPose(numJoints);
+    IndexT i;
+    for (i = 0; i < numJoints; i++)
+    {
+        joints[i].parentJointIndex = skeleton[i].parent;
+        joints[i].parentJoint = skeleton[i].parent != InvalidIndex ? &joints[skeleton[i].parent] : nullptr;
+        bindPose[i] = Math::inverse(Math::translation(skeleton[i].position));
+    }
+
+    // Any order with parents before their children
+    IndexT orderJoints[] = { 0, 6, 1, 3, 2, 4, 5 };
+    Util::FixedArray<IndexT> order(numJoints);
+    for (i = 0; i < numJoints; i++)
+        order[i] = orderJoints[i];
+
+    // The finger is shorter than 6% of the skeleton, so both its joints follow the hand,
+    // the leaves of the other chains follow their parents, the hand and spine are evaluated
+    Util::FixedArray<IndexT> parents;
+    CharacterContext::ComputeLodJointParents(joints, order, bindPose, parents);
+    VERIFY(parents.Size() == numJoints);
+    VERIFY(parents[0] == InvalidIndex);
+    VERIFY(parents[1] == InvalidIndex);
+    VERIFY(parents[2] == 1);
+    VERIFY(parents[3] == InvalidIndex);
+    VERIFY(parents[4] == 3);
+    VERIFY(parents[5] == 3);
+    VERIFY(parents[6] == 0);
+
+    // A box with a radius of sqrt(3) at a distance of 10
+    Math::bbox box(Math::point(0, 0, -10), Math::vector(1, 1, 1));
+    VERIFY(Math::nearequal(CharacterContext::LodScreenSize(box, Math::point(0, 0, 0), 1.0f), 0.1732051f, 0.0001f));
+    VERIFY(Math::nearequal(CharacterContext::LodScreenSize(box, Math::point(0, 0, 0), 2.0f), 0.3464102f, 0.0001f));
+    VERIFY(CharacterContext::LodScreenSize(box, Math::point(0, 0.5f, -9), 1.0f) == 1.0f);
+
+    // The interval doubles every time the size halves below the full rate size
+    CharacterContext::LodSettings settings;
+    VERIFY(CharacterContext::LodUpdateInterval(1.0f, settings) == 1);
+    VERIFY(CharacterContext::LodUpdateInterval(0.25f, settings) == 1);
+    VERIFY(CharacterContext::LodUpdateInterval(0.2f, settings) == 2);
+    VERIFY(CharacterContext::LodUpdateInterval(0.125f, settings) == 2);
+    VERIFY(CharacterContext::LodUpdateInterval(0.1f, settings) == 4);
+    VERIFY(CharacterContext::LodUpdateInterval(0.05f, settings) == 8);
+    VERIFY(CharacterContext::LodUpdateInterval(0.0f, settings) == 8);
+
+    settings.maxUpdateInterval = 2;
+    VERIFY(CharacterContext::LodUpdateInterval(0.05f, settings) == 2);
+    settings.maxUpdateInterval = 1;
+    VERIFY(CharacterContext::LodUpdateInterval(0.05f, settings) == 1);
+
+    VERIFY(!CharacterContext::LodFollowsParents(0.25f, settings));
+    VERIFY(!CharacterContext::LodFollowsParents(0.1f, settings));
+    VERIFY(CharacterContext::LodFollowsParents(0.09f, settings));
+}
+
+} // namespace Test
@@ -0,0 +1,22 @@
+#pragma once
+//------------------------------------------------------------------------------
+/**
+    Test for the character level of detail thresholds and joint parents
+
+    @copyright
+    (C) 2024 Individual contributors, see AUTHORS file
+*/
+//------------------------------------------------------------------------------
+#include "testbase/testcase.h"
+namespace Test
+{
+
+class CharacterLodTest : public TestCase
+{
+    __DeclareClass(CharacterLodTest);
+public:
+    /// run test
+    virtual void Run();
+};
+
+} // namespace Test
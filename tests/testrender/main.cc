@@ -7,6 +7,8 @@
 #include "core/coreserver.h"
 #include "testbase/testrunner.h"
 #include "animtest.h"
+#include "characterlodtest.h"
+#include "particletest.h"
 #include "rendertest.h"
 
 using namespace Core;
@@ -28,6 +30,8 @@ NebulaMain(const Util::CommandLineArgs& args)
     // setup and run test runner
     Ptr<TestRunner> testRunner = TestRunner::Create();
     testRunner->AttachTestCase(AnimTest::Create());
+    testRunner->AttachTestCase(CharacterLodTest::Create());
+    testRunner->AttachTestCase(ParticleTest::Create());
     testRunner->AttachTestCase(RenderTest::Create());
     testRunner->Run();
     //testRunner->AttachTestCase(BXmlReaderTest::Create());
@@ -0,0 +1,252 @@
+//------------------------------------------------------------------------------
+//  @file particletest.cc
+//  @copyright (C) 2024 Individual contributors, see AUTHORS file
+//------------------------------------------------------------------------------
+#include "foundation/stdneb.h"
+#include "particles/particlejob.h"
+#include "particles/emitterattrs.h"
+#include "system/cpu.h"
+#include "particletest.h"
+
+using namespace Particles;
+namespace Test
+{
+
+__ImplementClass(ParticleTest, 'PATE', Core::RefCounted);
+
+static const SizeT NumSteps = 30;
+static const float StepTime = 0.016f;
+
+//------------------------------------------------------------------------------
+/**
+    Scalar version of the simulation kernels, one particle at a time
+*/
+static void
+ReferenceStep(const ParticleJobUniformData& uniforms, float stepTime, Util::Array<Particle>& particles, ParticleJobSliceOutputData& output)
+{
+    output.numLivingParticles = 0;
+    output.numVisibleParticles = 0;
+    Math::vec3 minimum(FLT_MAX), maximum(-FLT_MAX);
+    IndexT i, j;
+    for (i = 0; i < particles.Size(); i++)
+    {
+        Particle& particle = particles[i];
+        particle.age += stepTime;
+        particle.relAge += stepTime * particle.oneDivLifeTime;
+        if (particle.relAge >= 1.0f)
+            continue;
+        output.numLivingParticles++;
+
+        const float* samples = uniforms.sampleBuffer + IndexT(particle.relAge * (ParticleSystemNumEnvelopeSamples - 1)) * EmitterAttrs::NumEnvelopeAttrs;
+        const float velocityFactor = samples[EmitterAttrs::VelocityFactor];
+        const float size = samples[EmitterAttrs::Size];
+        const float wind[] = { uniforms.windVector.x, uniforms.windVector.y, uniforms.windVector.z };
+        const float gravity[] = { uniforms.gravity.x, uniforms.gravity.y, uniforms.gravity.z };
+        float acceleration[3];
+        for (j = 0; j < 3; j++)
+            acceleration[j] = (wind[j] * samples[EmitterAttrs::AirResistance] + gravity[j]) * samples[EmitterAttrs::Mass];
+        for (j = 0; j < 3; j++)
+        {
+            particle.position[j] += particle.velocity[j] * velocityFactor * stepTime;
+            minimum[j] = Math::min(minimum[j], particle.position[j] - size);
+            maximum[j] = Math::max(maximum[j], particle.position[j] + size);
+            particle.velocity[j] += acceleration[j] * stepTime;
+        }
+
+        const float stretchTime = uniforms.stretchTime > 0.0f ? Math::min(particle.age, uniforms.stretchTime) : 0.0f;
+        for (j = 0; j < 3; j++)
+        {
+            if (uniforms.stretchToStart)
+                particle.stretchPosition[j] = particle.startPosition[j];
+            else if (stretchTime > 0.0f)
+                particle.stretchPosition[j] = particle.position[j] - (particle.velocity[j] - acceleration[j] * stretchTime * 0.5f) * (uniforms.stretchTime * velocityFactor);
+            else
+                particle.stretchPosition[j] = particle.position[j];
+        }
+        if (!uniforms.stretchToStart && stretchTime == 0.0f)
+            particle.rotation += particle.rotationVariation * samples[EmitterAttrs::RotationVelocity] * stepTime;
+
+        particle.color.set(samples[EmitterAttrs::Red], samples[EmitterAttrs::Green], samples[EmitterAttrs::Blue], Math::clamp(samples[EmitterAttrs::Alpha], 0.0f, 1.0f));
+        particle.size = size * particle.sizeVariation;
+        if (particle.color.w > ParticleMinAlpha)
+            output.numVisibleParticles++;
+    }
+
+    if (output.numLivingParticles == 0)
+        minimum = maximum = Math::vec3(0.0f);
+    output.bbox.pmin = minimum;
+    output.bbox.pmax = maximum;
+}
+
+//------------------------------------------------------------------------------
+/**
+*/
+static bool
+Near(float a, float b)
+{
+    return Math::abs(a - b) <= 0.0001f * (1.0f + Math::abs(a) + Math::abs(b));
+}
+
+//------------------------------------------------------------------------------
+/**
+*/
+static bool
+MatchesReference(const ParticleBuffer& buffer, const ParticleJobSliceOutputData& output, const Util::Array<Particle>& particles, const ParticleJobSliceOutputData& reference)
+{
+    if (output.numLivingParticles != reference.numLivingParticles || output.numVisibleParticles != reference.numVisibleParticles)
+        return false;
+    IndexT i, j;
+    for (i = 0; i < 3; i++)
+    {
+        if (!Near(output.bbox.pmin[i], reference.bbox.pmin[i]) || !Near(output.bbox.pmax[i], reference.bbox.pmax[i]))
+            return false;
+    }
+
+    for (i = 0; i < particles.Size(); i++)
+    {
+        const Particle& particle = particles[i];
+        const float expected[] =
+        {
+            particle.position.x, particle.position.y, particle.position.z,
+            particle.stretchPosition.x, particle.stretchPosition.y, particle.stretchPosition.z,
+            particle.velocity.x, particle.velocity.y, particle.velocity.z,
+            particle.color.x, particle.color.y, particle.color.z, particle.color.w,
+            particle.rotation, particle.size, particle.relAge, particle.age
+        };
+        const ParticleStream streams[] =
+        {
+            Stream_PositionX, Stream_PositionY, Stream_PositionZ,
+            Stream_StretchPositionX, Stream_StretchPositionY, Stream_StretchPositionZ,
+            Stream_VelocityX, Stream_VelocityY, Stream_VelocityZ,
+            Stream_ColorR, Stream_ColorG, Stream_ColorB, Stream_ColorA,
+            Stream_Rotation, Stream_Size, Stream_RelAge, Stream_Age
+        };
+        for (j = 0; j < (IndexT)(sizeof(streams) / sizeof(streams[0])); j++)
+        {
+            if (!Near(buffer.Stream(streams[j])[i], expected[j]))
+                return false;
+        }
+    }
+    return true;
+}
+
+//------------------------------------------------------------------------------
+/**
+    Checks the vertices of the first maxParticles visible particles
+*/
+static bool
+VerticesMatchReference(const ParticleBuffer& buffer, SizeT maxParticles, const Util::Array<Particle>& particles)
+{
+    Util::FixedArray<Math::vec4> vertices(Math::max(maxParticles, 1) * ParticleVertexWidth / 4);
+    const SizeT numWritten = ParticleWriteVertices(&buffer, maxParticles, (float*)vertices.Begin());
+
+    IndexT i, vertex = 0;
+    for (i = 0; i < particles.Size() && vertex < numWritten; i++)
+    {
+        const Particle& particle = particles[i];
+        if (particle.relAge >= 1.0f || particle.color.w <= ParticleMinAlpha)
+            continue;
+
+        const Math::vec4 expected[] =
+        {
+            Math::vec4(particle.position.x, particle.position.y, particle.position.z, 1.0f),
+            Math::vec4(particle.stretchPosition.x, particle.stretchPosition.y, particle.stretchPosition.z, 1.0f),
+            particle.color,
+            particle.uvMinMax,
+            Math::vec4(Math::sin(particle.rotation), Math::cos(particle.rotation), particle.size, particle.particleId)
+        };
+        const Math::vec4* written = vertices.Begin() + vertex * ParticleVertexWidth / 4;
+        IndexT j, k;
+        for (j = 0; j < 5; j++)
+            for (k = 0; k < 4; k++)
+                if (!Near(written[j][k], expected[j][k]))
+                    return false;
+        vertex++;
+    }
+    return vertex == numWritten && numWritten == maxParticles;
+}
+
+//------------------------------------------------------------------------------
+/**
+*/
+void
+ParticleTest::Run()
+{
+    srand(1234);
+    Util::FixedArray<float> samples(ParticleSystemNumEnvelopeSamples * EmitterAttrs::NumEnvelopeAttrs);
+    IndexT i;
+    for (i = 0; i < samples.Size(); i++)
+        samples[i] = Math::rand(-0.3f, 1.7f);
+
+    const bool avx2 = System::Cpu::HasFeature(System::Cpu::AVX2);
+    const SizeT capacities[] = { 1, 5, 8, 13, 37, 100 };
+
+    // plain, stretched to the start position and stretched over time
+    IndexT mode;
+    for (mode = 0; mode < 3; mode++)
+    {
+        ParticleJobUniformData uniforms;
+        uniforms.sampleBuffer = samples.Begin();
+        uniforms.gravity = Math::vector(0.0f, -9.8f, 0.0f);
+        uniforms.windVector = Math::vector(1.0f, 0.0f, 0.5f);
+        uniforms.stretchToStart = mode == 1;
+        uniforms.stretchTime = mode == 2 ? 0.05f : 0.0f;
+
+        IndexT c;
+        for (c = 0; c < (IndexT)(sizeof(capacities) / sizeof(capacities[0])); c++)
+        {
+            // emit a third more particles than fit, so the oldest ones get replaced
+            const SizeT capacity = capacities[c];
+            ParticleBuffer sse, wide;
+            sse.SetCapacity(capacity);
+            wide.SetCapacity(capacity);
+            Util::Array<Particle> reference;
+            for (i = 0; i < capacity + capacity / 3; i++)
+            {
+                Particle particle;
+                particle.position.set(Math::rand(-2.0f, 2.0f), Math::rand(-2.0f, 2.0f), Math::rand(-2.0f, 2.0f), 1.0f);
+                particle.startPosition.set(Math::rand(-2.0f, 2.0f), Math::rand(-2.0f, 2.0f), Math::rand(-2.0f, 2.0f), 1.0f);
+                particle.stretchPosition = particle.position;
+                particle.velocity.set(Math::rand(-2.0f, 2.0f), Math::rand(-2.0f, 2.0f), Math::rand(-2.0f, 2.0f), 0.0f);
+                particle.uvMinMax.set(0.0f, 0.0f, 1.0f, 1.0f);
+                particle.color.set(1.0f, 1.0f, 1.0f, 1.0f);
+                particle.rotation = Math::rand(-4.0f, 4.0f);
+                particle.rotationVariation = Math::rand(-2.0f, 2.0f);
+                particle.size = 1.0f;
+                particle.sizeVariation = Math::rand(0.5f, 1.5f);
+                particle.oneDivLifeTime = Math::rand(0.0f, 2.0f);
+                particle.relAge = Math::rand(0.0f, 0.9f);
+                particle.age = Math::rand(0.0f, 0.1f);
+                particle.particleId = float(i);
+
+                sse.Add(particle);
+                wide.Add(particle);
+                if (reference.Size() < capacity)
+                    reference.Append(particle);
+                else
+                    reference[i % capacity] = particle;
+            }
+
+            bool stepsMatch = true, verticesMatch = true;
+            IndexT step;
+            for (step = 0; step < NumSteps; step++)
+            {
+                ParticleJobSliceOutputData expected, sseOutput, wideOutput;
+                ReferenceStep(uniforms, StepTime, reference, expected);
+                ParticleStepSSE(&uniforms, StepTime, &sse, &sseOutput);
+                stepsMatch &= MatchesReference(sse, sseOutput, reference, expected);
+                verticesMatch &= VerticesMatchReference(sse, expected.numVisibleParticles, reference);
+                verticesMatch &= VerticesMatchReference(sse, expected.numVisibleParticles / 2, reference);
+                if (avx2)
+                {
+                    ParticleStepAVX2(&uniforms, StepTime, &wide, &wideOutput);
+                    stepsMatch &= MatchesReference(wide, wideOutput, reference, expected);
+                }
+            }
+            VERIFY(stepsMatch);
+            VERIFY(verticesMatch);
+        }
+    }
+}
+
+} // namespace Test
@@ -0,0 +1,22 @@
+#pragma once
+//------------------------------------------------------------------------------
+/**
+    Test for the particle simulation and vertex kernels
+
+    @copyright
+    (C) 2024 Individual contributors, see AUTHORS file
+*/
+//------------------------------------------------------------------------------
+#include "testbase/testcase.h"
+namespace Test
+{
+
+class ParticleTest : public TestCase
+{
+    __DeclareClass(ParticleTest);
+public:
+    /// run test
+    virtual void Run();
+};
+
+} // namespace Test
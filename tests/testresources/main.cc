@@ -6,7 +6,7 @@
 #include "system/appentry.h"
 #include "core/coreserver.h"
 #include "testbase/testrunner.h"
-#include "resourcetest.h"
+#include "residencymanagertest.h"
 
 using namespace Core;
 using namespace Test;
@@ -28,13 +28,13 @@ NebulaMain(const Util::CommandLineArgs& args)
 
     // setup and run test runner
     Ptr<TestRunner> testRunner = TestRunner::Create();
-    testRunner->AttachTestCase(ResourceTest::Create());
-    testRunner->Run();
+    testRunner->AttachTestCase(ResidencyManagerTest::Create());
+    bool result = testRunner->Run();
     //testRunner->AttachTestCase(BXmlReaderTest::Create());
 
     coreServer->Close();
     coreServer = nullptr;
     testRunner = nullptr;
 
-    Core::SysFunc::Exit(0);
+    Core::SysFunc::Exit(result ? 0 : -1);
 }
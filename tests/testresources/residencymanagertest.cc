@@ -0,0 +1,181 @@
+//------------------------------------------------------------------------------
+//  residencymanagertest.cc
+//  (C) 2024 Individual contributors, see AUTHORS file
+//------------------------------------------------------------------------------
+#include "stdneb.h"
+#include "residencymanagertest.h"
+#include "resources/residencymanager.h"
+
+namespace Test
+{
+__ImplementClass(Test::ResidencyManagerTest, 'RSMT', Test::TestCase);
+
+using namespace Resources;
+
+//------------------------------------------------------------------------------
+/**
+    Streams nothing, resources are added as loaded with the LODs given. Bit i
+    is LOD i from the coarsest, and each LOD is 4 times the size of the last.
+*/
+class FakeStreamingLoader : public ResourceLoader
+{
+    __DeclareClass(FakeStreamingLoader);
+public:
+    static const uint NumLods = 4;
+
+    /// add a loaded resource
+    ResourceId AddResource(const char* name, uint loadedBits)
+    {
+        Ids::Id32 entry = this->resourceInstanceIndexPool.Alloc();
+        if (entry >= (uint)this->names.Size())
+        {
+            this->names.Resize(this->names.Size() + ResourceIndexGrow);
+            this->states.Resize(this->states.Size() + ResourceIndexGrow);
+            this->loadStates.Resize(this->loadStates.Size() + ResourceIndexGrow);
+            this->resources.Resize(this->resources.Size() + ResourceIndexGrow);
+            this->streamDatas.Resize(this->streamDatas.Size() + ResourceIndexGrow);
+            this->residency.Resize(this->residency.Size() + ResourceIndexGrow);
+        }
+
+        ResourceId id;
+        id.loaderInstanceId = entry;
+        id.loaderIndex = 0;
+        id.resourceId = entry;
+        id.generation = 0;
+
+        this->names[entry] = name;
+        this->states[entry] = Resource::Loaded;
+        this->loadStates[entry] = LoadState{ .requestedBits = loadedBits, .pendingBits = 0x0, .loadedBits = loadedBits };
+        this->resources[entry] = id;
+        this->streamDatas[entry].data = this;
+        this->residency[entry] = _Residency{ .bytes = 0, .bits = 0x0, .lastUsedFrame = InvalidIndex, .usedLod = 1.0f };
+        this->ids.Add(name, entry);
+        return id;
+    }
+
+    /// pretend the loads have finished
+    void SetLoadedBits(const ResourceId id, uint loadedBits)
+    {
+        this->loadStates[id.loaderInstanceId].loadedBits = loadedBits;
+        this->loadStates[id.loaderInstanceId].requestedBits = loadedBits;
+    }
+
+    /// take the LOD requests issued since the last call
+    Util::Array<ResourceId> TakeRequests()
+    {
+        Util::Array<_PendingStreamLod> pending;
+        this->pendingStreamQueue.DequeueAll(pending);
+        Util::Array<ResourceId> ret;
+        for (const _PendingStreamLod& request : pending)
+            ret.Append(request.id);
+        return ret;
+    }
+
+    /// size of a LOD
+    static uint64 LodBytes(uint lod)
+    {
+        return 1024ull << (2 * lod);
+    }
+
+private:
+    ResourceInitOutput InitializeResource(const ResourceLoadJob& job, const Ptr<IO::Stream>& stream) override
+    {
+        return ResourceInitOutput();
+    }
+
+    void Unload(const Resources::ResourceId id) override
+    {
+        // empty
+    }
+
+    uint LodMask(const _StreamData& stream, float lod, bool async) const override
+    {
+        uint numLods = NumLods - (uint)((NumLods - 1) * lod);
+        return (1 << numLods) - 1;
+    }
+
+    uint64 ResidentBytes(const _StreamData& stream, uint loadedBits) const override
+    {
+        uint64 bytes = 0;
+        for (uint lod = 0; lod < NumLods; lod++)
+        {
+            if (loadedBits & (1 << lod))
+                bytes += LodBytes(lod);
+        }
+        return bytes;
+    }
+};
+__ImplementClass(Test::FakeStreamingLoader, 'FSLO', Resources::ResourceLoader);
+
+//------------------------------------------------------------------------------
+/**
+*/
+void
+ResidencyManagerTest::Run()
+{
+    Ptr<FakeStreamingLoader> loader = FakeStreamingLoader::Create();
+    Util::Array<Ptr<ResourceLoader>> loaders;
+    loaders.Append(loader.upcast<ResourceLoader>());
+
+    const ResourceId a = loader->AddResource("a", 0x1);
+    const ResourceId b = loader->AddResource("b", 0x1);
+    const ResourceId c = loader->AddResource("c", 0x3);
+    const uint64 allLods = FakeStreamingLoader::LodBytes(0) + FakeStreamingLoader::LodBytes(1) + FakeStreamingLoader::LodBytes(2) + FakeStreamingLoader::LodBytes(3);
+
+    Ptr<ResidencyManager> manager = ResidencyManager::Create();
+    manager->SetBudget(1024 * 1024);
+
+    // within budget, a resource used with full detail gets its LODs requested, and the memory is reserved
+    loader->ReportUsage(a, 0.0f);
+    manager->Update(loaders, 10);
+    VERIFY(!manager->IsOverBudget());
+    VERIFY(manager->GetStats().numResident == 3);
+    VERIFY(manager->GetStats().numRequested == 1);
+    Util::Array<ResourceId> requests = loader->TakeRequests();
+    VERIFY(requests.Size() == 1 && requests[0] == a);
+    const uint64 reserved = allLods + FakeStreamingLoader::LodBytes(0) + FakeStreamingLoader::LodBytes(0) + FakeStreamingLoader::LodBytes(1);
+    VERIFY(manager->GetResidentBytes() == reserved);
+
+    // the resident memory follows the loaded LODs
+    loader->SetLoadedBits(a, 0xF);
+    loader->SetLoadedBits(c, 0x1);
+    manager->Update(loaders, 11);
+    VERIFY(manager->GetResidentBytes() == allLods + 2 * FakeStreamingLoader::LodBytes(0));
+    VERIFY(manager->GetStats().numRequested == 0);
+    VERIFY(loader->TakeRequests().IsEmpty());
+
+    // over budget, nothing is requested
+    manager->SetBudget(allLods);
+    loader->ReportUsage(c, 0.0f);
+    manager->Update(loaders, 19);
+    VERIFY(manager->IsOverBudget());
+    VERIFY(manager->GetStats().numRequested == 0);
+    VERIFY(loader->TakeRequests().IsEmpty());
+
+    // with room for one more resource at full detail, only the one used most recently is requested
+    manager->SetBudget(2 * allLods + FakeStreamingLoader::LodBytes(0));
+    loader->ReportUsage(b, 0.0f);
+    manager->Update(loaders, 20);
+    VERIFY(!manager->IsOverBudget());
+    VERIFY(manager->GetStats().numRequested == 1);
+    requests = loader->TakeRequests();
+    VERIFY(requests.Size() == 1 && requests[0] == b);
+    VERIFY(manager->GetResidentBytes() == 2 * allLods + FakeStreamingLoader::LodBytes(0));
+
+    // once loaded the budget is used up, so the other resource still waits
+    loader->SetLoadedBits(b, 0xF);
+    loader->ReportUsage(c, 0.0f);
+    manager->Update(loaders, 21);
+    VERIFY(!manager->IsOverBudget());
+    VERIFY(manager->GetStats().numRequested == 0);
+    VERIFY(loader->TakeRequests().IsEmpty());
+
+    // and is requested once there is room
+    manager->SetBudget(3 * allLods);
+    loader->ReportUsage(c, 0.0f);
+    manager->Update(loaders, 22);
+    requests = loader->TakeRequests();
+    VERIFY(requests.Size() == 1 && requests[0] == c);
+}
+
+} // namespace Test
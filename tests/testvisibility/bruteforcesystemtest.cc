@@ -0,0 +1,128 @@
+//------------------------------------------------------------------------------
+// bruteforcesystemtest.cc
+// (C) 2024 Individual contributors, see AUTHORS file
+//------------------------------------------------------------------------------
+#include "stdneb.h"
+#include "core/refcounted.h"
+#include "bruteforcesystemtest.h"
+#include "system/systeminfo.h"
+#include "jobs2/jobs2.h"
+#include "visibility/visibilitycontext.h"
+#include "visibility/systems/frustumculling.h"
+#include "visibilitytestutil.h"
+#include <algorithm>
+
+using namespace Visibility;
+
+namespace Test
+{
+
+__ImplementClass(BruteforceSystemTest, 'VBFS', Core::RefCounted);
+
+static const SizeT NumObservers = 2;
+
+//------------------------------------------------------------------------------
+/**
+    Check the results against testing every entity on its own
+*/
+static bool
+CheckResults(const VisibleList& results, const Math::mat4& transform, bool isOrtho, const Math::bbox* boxes, const uint32* ids, const uint32_t* flags, SizeT count)
+{
+    FrustumPlanes planes;
+    FrustumPlanesSetup(planes, transform, isOrtho);
+
+    IndexT i, j = 0;
+    for (i = 0; i < count; i++)
+    {
+        const bool alwaysVisible = AllBits(flags[ids[i]], (uint32_t)Models::NodeInstanceFlags::NodeInstance_AlwaysVisible);
+        if (!alwaysVisible && FrustumClip(planes, boxes[ids[i]]) == Math::ClipStatus::Outside)
+            continue;
+        if (j >= results.count || results.indices[j] != (uint32)i)
+            return false;
+        j++;
+    }
+    return j == results.count;
+}
+
+//------------------------------------------------------------------------------
+/**
+*/
+void
+BruteforceSystemTest::Run()
+{
+    Jobs2::JobSystemInitInfo jobSystemInfo;
+    jobSystemInfo.name = "BruteforceSystemTest";
+    jobSystemInfo.numThreads = System::NumCpuCores;
+    jobSystemInfo.priority = UINT_MAX;
+    Jobs2::JobSystemInit(jobSystemInfo);
+
+    // Enough entities for several jobs, and a partial word at the end
+    const SizeT NumEntities = 5000 + 7;
+    const float WorldSize = 200.0f;
+    Util::FixedArray<Math::bbox> boxes(NumEntities);
+    Util::FixedArray<uint32> ids(NumEntities);
+    Util::FixedArray<uint32_t> flags(NumEntities);
+    IndexT i;
+    for (i = 0; i < NumEntities; i++)
+    {
+        Math::point center(Math::rand(-WorldSize, WorldSize), Math::rand(-WorldSize, WorldSize), Math::rand(-WorldSize, WorldSize));
+        boxes[i] = Math::bbox(center, Math::vector(Math::rand(0.1f, 5.0f)));
+        ids[i] = NumEntities - 1 - i;
+        flags[i] = (i % 499) == 0 ? (uint32_t)Models::NodeInstanceFlags::NodeInstance_AlwaysVisible : 0;
+    }
+
+    // One observer which never moves, and one which turns around once
+    const Math::mat4 proj = Math::perspfovrh(Math::deg2rad(60.0f), 16.0f / 9.0f, 0.1f, 500.0f);
+    Math::mat4 transforms[NumObservers] =
+    {
+        proj * Math::inverse(Math::lookatrh(Math::point(0, 0, 0), Math::point(0, 0, -1), Math::vector::upvec())),
+        Math::orthorh(200.0f, 200.0f, 0.1f, 500.0f) * Math::inverse(Math::lookatrh(Math::point(0, 0, 0), Math::point(1, 0, 0), Math::vector::upvec())),
+    };
+    bool isOrtho[NumObservers] = { false, true };
+
+    VisibilitySystem* bruteforce = ObserverContext::CreateBruteforceSystem({});
+    VisibleList results[NumObservers];
+
+    IndexT frame;
+    for (frame = 0; frame < 8; frame++)
+    {
+        SizeT count = NumEntities;
+        switch (frame)
+        {
+            case 2:
+                // move some entities around, which brings some into view and takes some out of it
+                for (i = 0; i < NumEntities; i += 13)
+                    boxes[i] = Math::bbox(Math::point(Math::rand(-WorldSize, WorldSize), 0, Math::rand(-WorldSize, WorldSize)), Math::vector(1.0f));
+                break;
+            case 3:
+                // turn the second observer
+                transforms[1] = Math::orthorh(200.0f, 200.0f, 0.1f, 500.0f) * Math::inverse(Math::lookatrh(Math::point(0, 0, 0), Math::point(-1, 0, 0), Math::vector::upvec()));
+                break;
+            case 4:
+                // change which entities are always visible
+                for (i = 0; i < NumEntities; i += 7)
+                    flags[i] ^= (uint32_t)Models::NodeInstanceFlags::NodeInstance_AlwaysVisible;
+                break;
+            case 5:
+                // remove entities
+                count = NumEntities - 1040;
+                break;
+            case 6:
+                // and add them back, in a different order
+                std::reverse(ids.Begin(), ids.End());
+                break;
+            default:
+                // nothing changes
+                break;
+        }
+
+        RunVisibilitySystem(bruteforce, nullptr, transforms, isOrtho, NumObservers, results, boxes.Begin(), ids.Begin(), flags.Begin(), count);
+        VERIFY(CheckResults(results[0], transforms[0], isOrtho[0], boxes.Begin(), ids.Begin(), flags.Begin(), count));
+        VERIFY(CheckResults(results[1], transforms[1], isOrtho[1], boxes.Begin(), ids.Begin(), flags.Begin(), count));
+    }
+
+    ObserverContext::DestroySystem(bruteforce);
+    Jobs2::JobSystemUninit();
+}
+
+} // namespace Test
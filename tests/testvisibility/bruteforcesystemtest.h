@@ -0,0 +1,20 @@
+#pragma once
+//------------------------------------------------------------------------------
+/**
+    Tests that the brute force system finds the same entities when it reuses
+    the results of the last frame as when it culls everything
+
+    (C) 2024 Individual contributors, see AUTHORS file
+*/
+//------------------------------------------------------------------------------
+#include "testbase/testcase.h"
+namespace Test
+{
+class BruteforceSystemTest : public TestCase
+{
+    __DeclareClass(BruteforceSystemTest);
+public:
+    /// run test
+    virtual void Run();
+};
+} // namespace Test
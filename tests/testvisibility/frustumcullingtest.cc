@@ -0,0 +1,105 @@
+//------------------------------------------------------------------------------
+// frustumcullingtest.cc
+// (C) 2024 Individual contributors, see AUTHORS file
+//------------------------------------------------------------------------------
+#include "stdneb.h"
+#include "core/refcounted.h"
+#include "timing/timer.h"
+#include "frustumcullingtest.h"
+#include "system/cpu.h"
+#include "visibility/systems/frustumculling.h"
+
+using namespace Timing;
+using namespace Visibility;
+
+namespace Test
+{
+
+__ImplementClass(FrustumCullingTest, 'VFCT', Core::RefCounted);
+
+//------------------------------------------------------------------------------
+/**
+*/
+void
+FrustumCullingTest::Run()
+{
+    // an odd number of boxes, so the kernels have to deal with a partial batch
+    const SizeT NumBoxes = 100003;
+    const SizeT Capacity = (NumBoxes + 31) & ~31;
+    const float WorldSize = 1000.0f;
+
+    Util::FixedArray<float> minX(Capacity, 0.0f), minY(Capacity, 0.0f), minZ(Capacity, 0.0f);
+    Util::FixedArray<float> maxX(Capacity, 0.0f), maxY(Capacity, 0.0f), maxZ(Capacity, 0.0f);
+    Util::FixedArray<uint32> alwaysVisible(Capacity / 32, 0u);
+    Util::FixedArray<Math::bbox> boxes(NumBoxes);
+    IndexT i;
+    for (i = 0; i < NumBoxes; i++)
+    {
+        Math::point center(Math::rand(-WorldSize, WorldSize), Math::rand(-WorldSize, WorldSize), Math::rand(-WorldSize, WorldSize));
+        boxes[i] = Math::bbox(center, Math::vector(Math::rand(0.1f, 10.0f)));
+        minX[i] = boxes[i].pmin.x;
+        minY[i] = boxes[i].pmin.y;
+        minZ[i] = boxes[i].pmin.z;
+        maxX[i] = boxes[i].pmax.x;
+        maxY[i] = boxes[i].pmax.y;
+        maxZ[i] = boxes[i].pmax.z;
+        if ((i % 997) == 0)
+            alwaysVisible[i >> 5] |= 1u << (i & 31);
+    }
+    const FrustumCullBoxes soa = { minX.Begin(), minY.Begin(), minZ.Begin(), maxX.Begin(), maxY.Begin(), maxZ.Begin(), alwaysVisible.Begin() };
+
+    for (IndexT ortho = 0; ortho < 2; ortho++)
+    {
+        Math::mat4 view = Math::inverse(Math::lookatrh(Math::point(0, 0, 0), Math::point(1, 0.2f, 1), Math::vector::upvec()));
+        Math::mat4 proj = ortho
+            ? Math::orthorh(400.0f, 400.0f, 0.1f, 800.0f)
+            : Math::perspfovrh(Math::deg2rad(60.0f), 16.0f / 9.0f, 0.1f, 800.0f);
+        FrustumPlanes planes;
+        FrustumPlanesSetup(planes, proj * view, ortho != 0);
+
+        // the scalar test is the reference
+        Util::FixedArray<uint32> expected(NumBoxes);
+        SizeT numExpected = 0;
+        for (i = 0; i < NumBoxes; i++)
+        {
+            if (AllBits(alwaysVisible[i >> 5], 1u << (i & 31)) || FrustumClip(planes, boxes[i]) != Math::ClipStatus::Outside)
+                expected[numExpected++] = i;
+        }
+        VERIFY(numExpected > 0 && numExpected < NumBoxes);
+
+        struct Kernel
+        {
+            const char* name;
+            System::Cpu::Feature feature;
+            FrustumCullFunc func;
+        } kernels[] =
+        {
+            { "SSE", System::Cpu::SSE41, FrustumCullSSE },
+            { "AVX", System::Cpu::AVX, FrustumCullAVX },
+            { "AVX-512", System::Cpu::AVX512F, FrustumCullAVX512 },
+        };
+
+        Util::FixedArray<uint32> visible(NumBoxes);
+        for (const Kernel& kernel : kernels)
+        {
+            if (!System::Cpu::HasFeature(kernel.feature))
+            {
+                n_printf("%s kernel not supported, skipped\n", kernel.name);
+                continue;
+            }
+
+            Timer timer;
+            timer.Start();
+            SizeT numVisible = kernel.func(planes, soa, 0, NumBoxes, visible.Begin());
+            timer.Stop();
+
+            bool same = numVisible == numExpected;
+            for (i = 0; same && i < numVisible; i++)
+                same = visible[i] == expected[i];
+            VERIFY(same);
+            n_printf("%s kernel (%s): %d of %d visible in %f ms\n", kernel.name, ortho ? "ortho" : "perspective", numVisible, NumBoxes, timer.GetTime() * 1000);
+        }
+    }
+}
+
+} // namespace Test
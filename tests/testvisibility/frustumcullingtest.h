@@ -0,0 +1,20 @@
+#pragma once
+//------------------------------------------------------------------------------
+/**
+    Tests the frustum culling kernels against the scalar test,
+    and compares their timings
+
+    (C) 2024 Individual contributors, see AUTHORS file
+*/
+//------------------------------------------------------------------------------
+#include "testbase/testcase.h"
+namespace Test
+{
+class FrustumCullingTest : public TestCase
+{
+    __DeclareClass(FrustumCullingTest);
+public:
+    /// run test
+    virtual void Run();
+};
+} // namespace Test
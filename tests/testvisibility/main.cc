@@ -7,6 +7,11 @@
 #include "core/coreserver.h"
 #include "testbase/testrunner.h"
 #include "visibilitytest.h"
+#include "octreesystemtest.h"
+#include "frustumcullingtest.h"
+#include "bruteforcesystemtest.h"
+#include "occlusionsystemtest.h"
+#include "portalsystemtest.h"
 
 using namespace Core;
 using namespace Test;
@@ -23,6 +28,11 @@ int main(int argc, char** argv)
 
     // setup and run test runner
     Ptr<TestRunner> testRunner = TestRunner::Create();
+    testRunner->AttachTestCase(FrustumCullingTest::Create());
+    testRunner->AttachTestCase(BruteforceSystemTest::Create());
+    testRunner->AttachTestCase(OctreeSystemTest::Create());
+    testRunner->AttachTestCase(OcclusionSystemTest::Create());
+    testRunner->AttachTestCase(PortalSystemTest::Create());
     testRunner->AttachTestCase(VisibilityTest::Create());
     testRunner->Run();
     //testRunner->AttachTestCase(BXmlReaderTest::Create());
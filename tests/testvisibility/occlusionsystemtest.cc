@@ -0,0 +1,167 @@
+//------------------------------------------------------------------------------
+// occlusionsystemtest.cc
+// (C) 2024 Individual contributors, see AUTHORS file
+//------------------------------------------------------------------------------
+#include "stdneb.h"
+#include "core/refcounted.h"
+#include "occlusionsystemtest.h"
+#include "system/systeminfo.h"
+#include "jobs2/jobs2.h"
+#include "visibility/visibilitycontext.h"
+#include "visibility/systems/occlusionsystem.h"
+#include "visibilitytestutil.h"
+
+using namespace Visibility;
+
+namespace Test
+{
+
+__ImplementClass(OcclusionSystemTest, 'VOCC', Core::RefCounted);
+
+static const SizeT MaxObservers = 2;
+
+//------------------------------------------------------------------------------
+/**
+    Add a wall facing the z axis as an occluder
+*/
+static IndexT
+AddWall(OcclusionSystem* system, const Math::point& center, float width, float height)
+{
+    const Math::vec3 vertices[] =
+    {
+        Math::vec3(center.x - width * 0.5f, center.y - height * 0.5f, center.z),
+        Math::vec3(center.x + width * 0.5f, center.y - height * 0.5f, center.z),
+        Math::vec3(center.x + width * 0.5f, center.y + height * 0.5f, center.z),
+        Math::vec3(center.x - width * 0.5f, center.y + height * 0.5f, center.z),
+    };
+    const uint32 indices[] = { 0, 1, 2, 0, 2, 3 };
+    return system->AddOccluder(vertices, 4, indices, 6, Math::mat4::identity);
+}
+
+//------------------------------------------------------------------------------
+/**
+*/
+void
+OcclusionSystemTest::Run()
+{
+    Jobs2::JobSystemInitInfo jobSystemInfo;
+    jobSystemInfo.name = "OcclusionSystemTest";
+    jobSystemInfo.numThreads = System::NumCpuCores;
+    jobSystemInfo.priority = UINT_MAX;
+    Jobs2::JobSystemInit(jobSystemInfo);
+
+    // A perspective and an orthographic observer at the origin, looking down -z
+    Math::mat4 view = Math::inverse(Math::lookatrh(Math::point(0, 0, 0), Math::point(0, 0, -1), Math::vector::upvec()));
+    Math::mat4 transforms[MaxObservers] =
+    {
+        Math::perspfovrh(Math::deg2rad(60.0f), 16.0f / 9.0f, 0.1f, 1000.0f) * view,
+        Math::orthorh(100.0f, 100.0f, 0.1f, 1000.0f) * view,
+    };
+    bool isOrtho[MaxObservers] = { false, true };
+
+    // Boxes around a 20 by 20 wall 20 units in front of the observers
+    struct Object
+    {
+        Math::point center;
+        float extents;
+        bool alwaysVisible;
+    } objects[] =
+    {
+        { Math::point(0, 0, -60), 0.5f, false },    // behind the wall
+        { Math::point(20, 0, -60), 0.5f, false },   // behind the wall in perspective only
+        { Math::point(45, 0, -60), 0.5f, false },   // beside the wall
+        { Math::point(30, 0, -60), 1.0f, false },   // partially behind the wall in perspective
+        { Math::point(0, 0, -10), 0.5f, false },    // in front of the wall
+        { Math::point(0, 0, -60), 40.0f, false },   // bigger than the wall
+        { Math::point(0, 25, -60), 0.5f, false },   // above the wall in ortho only
+        { Math::point(0, 32, -60), 0.5f, false },   // above the wall
+        { Math::point(5, 5, -21), 0.5f, false },    // right behind the wall
+        { Math::point(0, 0, -60), 0.5f, true },     // behind the wall, but always visible
+        { Math::point(0, 0, 0), 0.5f, false },      // crossing the near plane
+    };
+    const SizeT numObjects = sizeof(objects) / sizeof(Object);
+    const uint32 all = (1u << numObjects) - 1;
+    const uint32 expected[MaxObservers] =
+    {
+        all & ~((1u << 0) | (1u << 1) | (1u << 6) | (1u << 8)),
+        all & ~((1u << 0) | (1u << 8)),
+    };
+
+    Util::FixedArray<Math::bbox> boxes(numObjects);
+    Util::FixedArray<uint32> ids(numObjects);
+    Util::FixedArray<uint32_t> flags(numObjects);
+    IndexT i;
+    for (i = 0; i < numObjects; i++)
+    {
+        boxes[i] = Math::bbox(objects[i].center, Math::vector(objects[i].extents));
+        ids[i] = i;
+        flags[i] = objects[i].alwaysVisible ? (uint32_t)Models::NodeInstanceFlags::NodeInstance_AlwaysVisible : 0;
+    }
+
+    VisibilitySystem* bruteforce = ObserverContext::CreateBruteforceSystem({});
+    OcclusionSystem* occlusion = ObserverContext::CreateOcclusionSystem({ 0, 0 });
+    VisibleList results[MaxObservers];
+
+    // without occluders, everything is visible
+    RunVisibilitySystem(bruteforce, occlusion, transforms, isOrtho, MaxObservers, results, boxes.Begin(), ids.Begin(), flags.Begin(), numObjects);
+    VERIFY(CheckVisibleMask(results[0], all));
+    VERIFY(CheckVisibleMask(results[1], all));
+
+    IndexT wall = AddWall(occlusion, Math::point(0, 0, -20), 20.0f, 20.0f);
+    RunVisibilitySystem(bruteforce, occlusion, transforms, isOrtho, MaxObservers, results, boxes.Begin(), ids.Begin(), flags.Begin(), numObjects);
+    VERIFY(CheckVisibleMask(results[0], expected[0]));
+    VERIFY(CheckVisibleMask(results[1], expected[1]));
+
+    // move the wall out of view
+    occlusion->SetOccluderTransform(wall, Math::translation(200.0f, 0.0f, 0.0f));
+    RunVisibilitySystem(bruteforce, occlusion, transforms, isOrtho, MaxObservers, results, boxes.Begin(), ids.Begin(), flags.Begin(), numObjects);
+    VERIFY(CheckVisibleMask(results[0], all));
+    VERIFY(CheckVisibleMask(results[1], all));
+
+    // and back again
+    occlusion->SetOccluderTransform(wall, Math::mat4::identity);
+    RunVisibilitySystem(bruteforce, occlusion, transforms, isOrtho, MaxObservers, results, boxes.Begin(), ids.Begin(), flags.Begin(), numObjects);
+    VERIFY(CheckVisibleMask(results[0], expected[0]));
+    VERIFY(CheckVisibleMask(results[1], expected[1]));
+
+    occlusion->RemoveOccluder(wall);
+    RunVisibilitySystem(bruteforce, occlusion, transforms, isOrtho, MaxObservers, results, boxes.Begin(), ids.Begin(), flags.Begin(), numObjects);
+    VERIFY(CheckVisibleMask(results[0], all));
+    VERIFY(CheckVisibleMask(results[1], all));
+
+    // A street lined with walls, with a grid of small objects behind them
+    const SizeT gridX = 200, gridZ = 200;
+    const SizeT numGrid = gridX * gridZ;
+    boxes.Resize(numGrid);
+    ids.Resize(numGrid);
+    flags.Resize(numGrid);
+    for (i = 0; i < numGrid; i++)
+    {
+        Math::point center(-500.0f + (i % gridX) * 5.0f, 1.0f, -60.0f - (i / gridX) * 5.0f);
+        boxes[i] = Math::bbox(center, Math::vector(1.0f));
+        ids[i] = i;
+        flags[i] = 0;
+    }
+    for (i = 0; i < 8; i++)
+        AddWall(occlusion, Math::point(-350.0f + i * 100.0f, 20.0f, -50.0f), 100.0f, 40.0f);
+
+    Math::mat4 streetView = Math::inverse(Math::lookatrh(Math::point(0, 2, 0), Math::point(0, 2, -1), Math::vector::upvec()));
+    Math::mat4 streetTransform = Math::perspfovrh(Math::deg2rad(60.0f), 16.0f / 9.0f, 0.1f, 2000.0f) * streetView;
+    bool streetOrtho = false;
+
+    double frustumTime = RunVisibilitySystem(bruteforce, nullptr, &streetTransform, &streetOrtho, 1, results, boxes.Begin(), ids.Begin(), flags.Begin(), numGrid);
+    const SizeT numInFrustum = results[0].count;
+    double occlusionTime = RunVisibilitySystem(bruteforce, occlusion, &streetTransform, &streetOrtho, 1, results, boxes.Begin(), ids.Begin(), flags.Begin(), numGrid);
+    const SizeT numUnoccluded = results[0].count;
+
+    // the walls cover the whole view below their top edge
+    VERIFY(numInFrustum > 0);
+    VERIFY(numUnoccluded < numInFrustum / 10);
+    n_printf("Frustum culling: %d of %d visible in %f ms, with occlusion culling: %d visible in %f ms\n", numInFrustum, numGrid, frustumTime, numUnoccluded, occlusionTime);
+
+    ObserverContext::DestroySystem(occlusion);
+    ObserverContext::DestroySystem(bruteforce);
+    Jobs2::JobSystemUninit();
+}
+
+} // namespace Test
@@ -0,0 +1,20 @@
+#pragma once
+//------------------------------------------------------------------------------
+/**
+    Tests the occlusion system on a fixed scene where it's known what's
+    hidden, and compares its timing to frustum culling alone
+
+    (C) 2024 Individual contributors, see AUTHORS file
+*/
+//------------------------------------------------------------------------------
+#include "testbase/testcase.h"
+namespace Test
+{
+class OcclusionSystemTest : public TestCase
+{
+    __DeclareClass(OcclusionSystemTest);
+public:
+    /// run test
+    virtual void Run();
+};
+} // namespace Test
@@ -0,0 +1,129 @@
+//------------------------------------------------------------------------------
+// octreesystemtest.cc
+// (C) 2024 Individual contributors, see AUTHORS file
+//------------------------------------------------------------------------------
+#include "stdneb.h"
+#include "core/refcounted.h"
+#include "octreesystemtest.h"
+#include "system/systeminfo.h"
+#include "jobs2/jobs2.h"
+#include "visibility/visibilitycontext.h"
+#include "visibilitytestutil.h"
+
+using namespace Visibility;
+
+namespace Test
+{
+
+__ImplementClass(OctreeSystemTest, 'VOCT', Core::RefCounted);
+
+static const SizeT NumObjects = 200000;
+static const SizeT NumObservers = 8;
+static const float WorldSize = 4000.0f;
+
+//------------------------------------------------------------------------------
+/**
+    Compare the sorted results of two systems
+*/
+static bool
+CompareResults(VisibleList* lhs, VisibleList* rhs)
+{
+    IndexT i;
+    for (i = 0; i < NumObservers; i++)
+    {
+        if (lhs[i].count != rhs[i].count)
+            return false;
+        IndexT j;
+        for (j = 0; j < lhs[i].count; j++)
+        {
+            if (lhs[i].indices[j] != rhs[i].indices[j])
+                return false;
+        }
+    }
+    return true;
+}
+
+//------------------------------------------------------------------------------
+/**
+*/
+void
+OctreeSystemTest::Run()
+{
+    Jobs2::JobSystemInitInfo jobSystemInfo;
+    jobSystemInfo.name = "OctreeSystemTest";
+    jobSystemInfo.numThreads = System::NumCpuCores;
+    jobSystemInfo.priority = UINT_MAX;
+    Jobs2::JobSystemInit(jobSystemInfo);
+
+    // scatter small objects over the world, with a few huge ones and a few which are always visible
+    Util::FixedArray<Math::bbox> boxes(NumObjects);
+    Util::FixedArray<uint32> ids(NumObjects);
+    Util::FixedArray<uint32_t> flags(NumObjects);
+    IndexT i;
+    for (i = 0; i < NumObjects; i++)
+    {
+        Math::point center(Math::rand(-WorldSize, WorldSize), Math::rand(-50.0f, 50.0f), Math::rand(-WorldSize, WorldSize));
+        float extents = (i % 5000) == 0 ? WorldSize * 2.0f : Math::rand(0.1f, 8.0f);
+        boxes[i] = Math::bbox(center, Math::vector(extents));
+        flags[i] = (i % 1000) == 0 ? (uint32_t)Models::NodeInstanceFlags::NodeInstance_AlwaysVisible : 0;
+
+        // the order of ids doesn't match the objects, as in the observer context
+        ids[i] = NumObjects - 1 - i;
+    }
+
+    Math::mat4 transforms[NumObservers];
+    bool isOrtho[NumObservers];
+    for (i = 0; i < NumObservers; i++)
+    {
+        Math::point eye(Math::rand(-WorldSize, WorldSize), 10.0f, Math::rand(-WorldSize, WorldSize));
+        Math::point at(Math::rand(-WorldSize, WorldSize), 0.0f, Math::rand(-WorldSize, WorldSize));
+        Math::mat4 view = Math::inverse(Math::lookatrh(eye, at, Math::vector::upvec()));
+        isOrtho[i] = i == NumObservers - 1;
+        Math::mat4 proj = isOrtho[i]
+            ? Math::orthorh(500.0f, 500.0f, 0.1f, 1000.0f)
+            : Math::perspfovrh(Math::deg2rad(60.0f), 16.0f / 9.0f, 0.1f, 1000.0f);
+        transforms[i] = proj * view;
+    }
+
+    VisibilitySystem* octree = ObserverContext::CreateOctreeSystem({ true });
+    VisibilitySystem* bruteforce = ObserverContext::CreateBruteforceSystem({});
+    VisibleList octreeResults[NumObservers];
+    VisibleList bruteforceResults[NumObservers];
+
+    // first frame builds the tree
+    double octreeTime = RunVisibilitySystem(octree, nullptr, transforms, isOrtho, NumObservers, octreeResults, boxes.Begin(), ids.Begin(), flags.Begin(), NumObjects);
+    double bruteforceTime = RunVisibilitySystem(bruteforce, nullptr, transforms, isOrtho, NumObservers, bruteforceResults, boxes.Begin(), ids.Begin(), flags.Begin(), NumObjects);
+    VERIFY(CompareResults(octreeResults, bruteforceResults));
+    n_printf("Octree build and cull: %f ms, brute force: %f ms\n", octreeTime, bruteforceTime);
+
+    // nothing has moved
+    octreeTime = RunVisibilitySystem(octree, nullptr, transforms, isOrtho, NumObservers, octreeResults, boxes.Begin(), ids.Begin(), flags.Begin(), NumObjects);
+    bruteforceTime = RunVisibilitySystem(bruteforce, nullptr, transforms, isOrtho, NumObservers, bruteforceResults, boxes.Begin(), ids.Begin(), flags.Begin(), NumObjects);
+    VERIFY(CompareResults(octreeResults, bruteforceResults));
+    n_printf("Octree static cull: %f ms, brute force: %f ms\n", octreeTime, bruteforceTime);
+
+    // move every tenth object
+    for (i = 0; i < NumObjects; i += 10)
+    {
+        Math::vector offset(Math::rand(-20.0f, 20.0f), 0.0f, Math::rand(-20.0f, 20.0f));
+        boxes[i].pmin += offset;
+        boxes[i].pmax += offset;
+    }
+    octreeTime = RunVisibilitySystem(octree, nullptr, transforms, isOrtho, NumObservers, octreeResults, boxes.Begin(), ids.Begin(), flags.Begin(), NumObjects);
+    bruteforceTime = RunVisibilitySystem(bruteforce, nullptr, transforms, isOrtho, NumObservers, bruteforceResults, boxes.Begin(), ids.Begin(), flags.Begin(), NumObjects);
+    VERIFY(CompareResults(octreeResults, bruteforceResults));
+    n_printf("Octree update and cull: %f ms, brute force: %f ms\n", octreeTime, bruteforceTime);
+
+    // remove half of the objects, the ids of the other half stay where they are
+    const SizeT numRemaining = NumObjects / 2;
+    octreeTime = RunVisibilitySystem(octree, nullptr, transforms, isOrtho, NumObservers, octreeResults, boxes.Begin(), ids.Begin(), flags.Begin(), numRemaining);
+    bruteforceTime = RunVisibilitySystem(bruteforce, nullptr, transforms, isOrtho, NumObservers, bruteforceResults, boxes.Begin(), ids.Begin(), flags.Begin(), numRemaining);
+    VERIFY(CompareResults(octreeResults, bruteforceResults));
+    n_printf("Octree removal and cull: %f ms, brute force: %f ms\n", octreeTime, bruteforceTime);
+
+    ObserverContext::DestroySystem(octree);
+    ObserverContext::DestroySystem(bruteforce);
+    Jobs2::JobSystemUninit();
+}
+
+} // namespace Test
@@ -0,0 +1,20 @@
+#pragma once
+//------------------------------------------------------------------------------
+/**
+    Tests the octree visibility system against the brute force system,
+    and compares their timings
+
+    (C) 2024 Individual contributors, see AUTHORS file
+*/
+//------------------------------------------------------------------------------
+#include "testbase/testcase.h"
+namespace Test
+{
+class OctreeSystemTest : public TestCase
+{
+    __DeclareClass(OctreeSystemTest);
+public:
+    /// run test
+    virtual void Run();
+};
+} // namespace Test
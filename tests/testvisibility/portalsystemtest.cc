@@ -0,0 +1,126 @@
+//------------------------------------------------------------------------------
+// portalsystemtest.cc
+// (C) 2024 Individual contributors, see AUTHORS file
+//------------------------------------------------------------------------------
+#include "stdneb.h"
+#include "core/refcounted.h"
+#include "portalsystemtest.h"
+#include "system/systeminfo.h"
+#include "jobs2/jobs2.h"
+#include "visibility/visibilitycontext.h"
+#include "visibility/systems/portalsystem.h"
+#include "visibilitytestutil.h"
+
+using namespace Visibility;
+
+namespace Test
+{
+
+__ImplementClass(PortalSystemTest, 'VPRT', Core::RefCounted);
+
+static const SizeT NumObservers = 2;
+
+//------------------------------------------------------------------------------
+/**
+    Add a 2 by 3 opening in a wall facing the z axis
+*/
+static void
+AddOpening(PortalSystem* system, uint32 cell0, uint32 cell1, float z)
+{
+    const Math::vec3 vertices[] =
+    {
+        Math::vec3(-1.0f, 0.0f, z),
+        Math::vec3(1.0f, 0.0f, z),
+        Math::vec3(1.0f, 3.0f, z),
+        Math::vec3(-1.0f, 3.0f, z),
+    };
+    system->AddPortal(cell0, cell1, vertices, 4);
+}
+
+//------------------------------------------------------------------------------
+/**
+*/
+void
+PortalSystemTest::Run()
+{
+    Jobs2::JobSystemInitInfo jobSystemInfo;
+    jobSystemInfo.name = "PortalSystemTest";
+    jobSystemInfo.numThreads = System::NumCpuCores;
+    jobSystemInfo.priority = UINT_MAX;
+    Jobs2::JobSystemInit(jobSystemInfo);
+
+    // Two rooms in a row, connected by a door, with a window to the outside
+    // at the end, and a closed room to the side of the first one
+    PortalSystem* portals = ObserverContext::CreatePortalSystem({});
+    const uint32 roomA = portals->AddCell(Math::bbox(Math::point(0, 2.5f, -10), Math::vector(10, 2.5f, 10)));
+    const uint32 roomB = portals->AddCell(Math::bbox(Math::point(0, 2.5f, -30), Math::vector(10, 2.5f, 10)));
+    portals->AddCell(Math::bbox(Math::point(-20, 2.5f, -10), Math::vector(10, 2.5f, 10)));
+    AddOpening(portals, roomA, roomB, -20.0f);
+    AddOpening(portals, roomB, PortalSystem::OutsideCell, -40.0f);
+
+    // One observer in the first room looking at the door, one outside looking at the window
+    const Math::mat4 proj = Math::perspfovrh(Math::deg2rad(60.0f), 16.0f / 9.0f, 0.1f, 1000.0f);
+    Math::mat4 transforms[NumObservers] =
+    {
+        proj * Math::inverse(Math::lookatrh(Math::point(0, 1.5f, -2), Math::point(0, 1.5f, -3), Math::vector::upvec())),
+        proj * Math::inverse(Math::lookatrh(Math::point(0, 1.5f, -80), Math::point(0, 1.5f, 0), Math::vector::upvec())),
+    };
+    bool isOrtho[NumObservers] = { false, false };
+
+    struct Object
+    {
+        Math::point center;
+        bool alwaysVisible;
+        Math::vector extents = Math::vector(0.5f);
+    } objects[] =
+    {
+        { Math::point(0, 1, -10), false },      // in the first room
+        { Math::point(0, 1, -30), false },      // in the second room, in line with the door
+        { Math::point(8, 1, -35), false },      // in the second room, beside the door
+        { Math::point(-15, 1, -18), false },    // in the closed room
+        { Math::point(0, 1, -60), false },      // outside, in line with the window
+        { Math::point(5, 1, -60), false },      // outside, beside the window
+        { Math::point(-15, 1, -10), true },     // in the closed room, but always visible
+        { Math::point(0, 1, -90), false },      // outside, behind the outside observer
+        { Math::point(-11, 1, -15), false, Math::vector(2, 0.5f, 0.5f) },   // mostly in the closed room, reaching into the first room
+        { Math::point(0, 1, -20), false },      // in the door, in both rooms
+    };
+    const SizeT numObjects = sizeof(objects) / sizeof(Object);
+
+    Util::FixedArray<Math::bbox> boxes(numObjects);
+    Util::FixedArray<uint32> ids(numObjects);
+    Util::FixedArray<uint32_t> flags(numObjects);
+    IndexT i;
+    for (i = 0; i < numObjects; i++)
+    {
+        boxes[i] = Math::bbox(objects[i].center, objects[i].extents);
+        ids[i] = i;
+        flags[i] = objects[i].alwaysVisible ? (uint32_t)Models::NodeInstanceFlags::NodeInstance_AlwaysVisible : 0;
+    }
+
+    VisibleList results[NumObservers];
+    RunVisibilitySystem(portals, nullptr, transforms, isOrtho, NumObservers, results, boxes.Begin(), ids.Begin(), flags.Begin(), numObjects);
+    VERIFY(CheckVisibleMask(results[0], (1 << 0) | (1 << 1) | (1 << 4) | (1 << 6) | (1 << 7) | (1 << 8) | (1 << 9)));
+    VERIFY(CheckVisibleMask(results[1], (1 << 0) | (1 << 1) | (1 << 4) | (1 << 5) | (1 << 6) | (1 << 9)));
+
+    // nothing has moved
+    RunVisibilitySystem(portals, nullptr, transforms, isOrtho, NumObservers, results, boxes.Begin(), ids.Begin(), flags.Begin(), numObjects);
+    VERIFY(CheckVisibleMask(results[0], (1 << 0) | (1 << 1) | (1 << 4) | (1 << 6) | (1 << 7) | (1 << 8) | (1 << 9)));
+    VERIFY(CheckVisibleMask(results[1], (1 << 0) | (1 << 1) | (1 << 4) | (1 << 5) | (1 << 6) | (1 << 9)));
+
+    // move the object beside the door into the first room
+    boxes[2] = Math::bbox(Math::point(8, 1, -10), Math::vector(0.5f));
+    RunVisibilitySystem(portals, nullptr, transforms, isOrtho, NumObservers, results, boxes.Begin(), ids.Begin(), flags.Begin(), numObjects);
+    VERIFY(CheckVisibleMask(results[0], (1 << 0) | (1 << 1) | (1 << 2) | (1 << 4) | (1 << 6) | (1 << 7) | (1 << 8) | (1 << 9)));
+    VERIFY(CheckVisibleMask(results[1], (1 << 0) | (1 << 1) | (1 << 4) | (1 << 5) | (1 << 6) | (1 << 9)));
+
+    // remove the last objects
+    RunVisibilitySystem(portals, nullptr, transforms, isOrtho, NumObservers, results, boxes.Begin(), ids.Begin(), flags.Begin(), 4);
+    VERIFY(CheckVisibleMask(results[0], (1 << 0) | (1 << 1) | (1 << 2)));
+    VERIFY(CheckVisibleMask(results[1], (1 << 0) | (1 << 1)));
+
+    ObserverContext::DestroySystem(portals);
+    Jobs2::JobSystemUninit();
+}
+
+} // namespace Test
@@ -0,0 +1,20 @@
+#pragma once
+//------------------------------------------------------------------------------
+/**
+    Tests the portal system on a few rooms connected by portals,
+    seen from inside and outside
+
+    (C) 2024 Individual contributors, see AUTHORS file
+*/
+//------------------------------------------------------------------------------
+#include "testbase/testcase.h"
+namespace Test
+{
+class PortalSystemTest : public TestCase
+{
+    __DeclareClass(PortalSystemTest);
+public:
+    /// run test
+    virtual void Run();
+};
+} // namespace Test
@@ -0,0 +1,82 @@
+//------------------------------------------------------------------------------
+// visibilitytestutil.cc
+// (C) 2024 Individual contributors, see AUTHORS file
+//------------------------------------------------------------------------------
+#include "stdneb.h"
+#include "visibilitytestutil.h"
+#include "timing/timer.h"
+#include "jobs2/jobs2.h"
+#include "threading/event.h"
+#include <algorithm>
+
+using namespace Visibility;
+
+namespace Test
+{
+
+//------------------------------------------------------------------------------
+/**
+    The refining system waits for the first one per observer, as the
+    occlusion system does for the systems before it. Only the systems are
+    timed, not the sorting.
+*/
+double
+RunVisibilitySystem(VisibilitySystem* system, VisibilitySystem* refine, const Math::mat4* transforms, bool* isOrtho, SizeT numObservers, VisibleList* results, const Math::bbox* boxes, const uint32* ids, const uint32_t* flags, SizeT count)
+{
+    IndexT i;
+    for (i = 0; i < numObservers; i++)
+    {
+        results[i].indices.Resize(count);
+        results[i].count = 0;
+    }
+
+    Jobs2::JobNewFrame();
+
+    Timing::Timer timer;
+    timer.Start();
+    system->PrepareObservers(transforms, isOrtho, results, numObservers);
+    system->PrepareEntities(boxes, ids, nullptr, flags, count);
+    system->Run(nullptr, nullptr);
+    VisibilitySystem* last = system;
+    if (refine != nullptr)
+    {
+        refine->PrepareObservers(transforms, isOrtho, results, numObservers);
+        refine->PrepareEntities(boxes, ids, nullptr, flags, count);
+        refine->Run(system->GetCompletionCounters(), nullptr);
+        last = refine;
+    }
+
+    // wait for all observers to finish
+    Util::FixedArray<const Threading::AtomicCounter*, true> counters(numObservers);
+    for (i = 0; i < numObservers; i++)
+        counters[i] = &last->GetCompletionCounters()[i];
+    Threading::Event finished;
+    Jobs2::JobDispatch([](SizeT totalJobs, SizeT groupSize, IndexT groupIndex, SizeT invocationOffset) {}, 1, counters, nullptr, &finished);
+    finished.Wait();
+    timer.Stop();
+
+    // the systems append visible entities in any order
+    for (i = 0; i < numObservers; i++)
+        std::sort(results[i].indices.Begin(), results[i].indices.Begin() + results[i].count);
+    return timer.GetTime() * 1000;
+}
+
+//------------------------------------------------------------------------------
+/**
+*/
+bool
+CheckVisibleMask(const VisibleList& results, uint32 expected)
+{
+    IndexT i, j = 0;
+    for (i = 0; i < 32; i++)
+    {
+        if ((expected & (1u << i)) == 0)
+            continue;
+        if (j >= results.count || results.indices[j] != (uint32)i)
+            return false;
+        j++;
+    }
+    return j == results.count;
+}
+
+} // namespace Test
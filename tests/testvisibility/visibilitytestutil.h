@@ -0,0 +1,21 @@
+#pragma once
+//------------------------------------------------------------------------------
+/**
+    @file visibilitytestutil.h
+
+    Running visibility systems for one frame and checking their results,
+    shared by the visibility system tests
+
+    (C) 2024 Individual contributors, see AUTHORS file
+*/
+//------------------------------------------------------------------------------
+#include "visibility/systems/visibilitysystem.h"
+namespace Test
+{
+
+/// run one frame of a system, optionally followed by one refining its results, wait for it and sort the results, returns the time in ms
+double RunVisibilitySystem(Visibility::VisibilitySystem* system, Visibility::VisibilitySystem* refine, const Math::mat4* transforms, bool* isOrtho, SizeT numObservers, Visibility::VisibleList* results, const Math::bbox* boxes, const uint32* ids, const uint32_t* flags, SizeT count);
+/// check that the sorted results are exactly the entities with their bit set
+bool CheckVisibleMask(const Visibility::VisibleList& results, uint32 expected);
+
+} // namespace Test
@@ -9,9 +9,10 @@
 /**
 */
 int
-__cdecl main()
+__cdecl main(int argc, const char** argv)
 {
     App::ZipStressTestApplication app;
+    app.SetCmdLineArgs(Util::CommandLineArgs(argc, argv));
     app.SetCompanyName("Radon Labs GmbH");
     app.SetAppID("ZipStressTest");
     if (app.Open())
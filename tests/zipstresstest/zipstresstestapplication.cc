@@ -6,6 +6,7 @@
 #include "zipstresstestapplication.h"
 #include "threading/thread.h"
 #include "io/stream.h"
+#include "timing/timer.h"
 
 namespace App
 {
@@ -39,6 +40,35 @@ private:
 };
 __ImplementClass(App::ReaderThread, 'RTHR', Threading::Thread);
 
+// thread subclass for throughput measurement, reads a list of files once
+class ThroughputThread : public Threading::Thread
+{
+    __DeclareClass(ThroughputThread);
+public:
+    /// constructor
+    ThroughputThread() : bytesRead(0) {};
+    /// setup the files to read
+    void Setup(const Array<String>& files_)
+    {
+        this->files = files_;
+        this->bytesRead = 0;
+    };
+    /// get number of bytes read
+    int64_t GetBytesRead() const
+    {
+        return this->bytesRead;
+    };
+
+protected:
+    /// worker method
+    virtual void DoWork();
+
+private:
+    Array<String> files;
+    int64_t bytesRead;
+};
+__ImplementClass(App::ThroughputThread, 'TTHR', Threading::Thread);
+
 //------------------------------------------------------------------------------
 /**
 */
@@ -75,6 +105,53 @@ ReaderThread::DoWork()
     // shutdown the thread
 }
 
+//------------------------------------------------------------------------------
+/**
+*/
+void
+ThroughputThread::DoWork()
+{
+    Ptr<IoServer> ioServer = IoServer::Create();
+    IndexT i;
+    for (i = 0; i < this->files.Size(); i++)
+    {
+        Ptr<Stream> stream = ioServer->CreateStream(this->files[i]);
+        if (stream->Open())
+        {
+            SizeT fileSize = stream->GetSize();
+            if (fileSize > 0)
+            {
+                void* buf = Memory::Alloc(Memory::DefaultHeap, fileSize);
+                SizeT readSize = stream->Read(buf, fileSize);
+                n_assert(readSize == fileSize);
+                Memory::Free(Memory::DefaultHeap, buf);
+            }
+            this->bytesRead += fileSize;
+            stream->Close();
+        }
+    }
+}
+
+//------------------------------------------------------------------------------
+/**
+*/
+static void
+CollectFiles(const String& dir, Array<String>& files)
+{
+    IoServer* ioServer = IoServer::Instance();
+    Array<String> names = ioServer->ListFiles(dir, "*");
+    IndexT i;
+    for (i = 0; i < names.Size(); i++)
+    {
+        files.Append(dir + "/" + names[i]);
+    }
+    Array<String> dirs = ioServer->ListDirectories(dir, "*");
+    for (i = 0; i < dirs.Size(); i++)
+    {
+        CollectFiles(dir + "/" + dirs[i], files);
+    }
+}
+
 //------------------------------------------------------------------------------
 /**
 */
@@ -83,6 +160,82 @@ ZipStressTestApplication::Run()
 {
     // mount standard zip archives
     IoServer::Instance()->MountStandardArchives();
+
+    if (this->args.GetBoolFlag("-throughput"))
+    {
+        Array<String> files;
+        CollectFiles("root:export", files);
+        n_printf("%d files\n", files.Size());
+        this->RunThroughputTest(1, files);
+        this->RunThroughputTest(this->args.GetInt("-threads", 8), files);
+    }
+    else
+    {
+        this->RunStressTest();
+    }
+}
+
+//------------------------------------------------------------------------------
+/**
+*/
+void
+ZipStressTestApplication::RunThroughputTest(SizeT numThreads, const Array<String>& files)
+{
+    // spread the files over the threads
+    Array<Ptr<ThroughputThread>> threads;
+    IndexT i;
+    for (i = 0; i < numThreads; i++)
+    {
+        Array<String> share;
+        IndexT j;
+        for (j = i; j < files.Size(); j += numThreads)
+        {
+            share.Append(files[j]);
+        }
+        Ptr<ThroughputThread> newThread = ThroughputThread::Create();
+        newThread->SetName(String::Sprintf("ThroughputThread%d", i));
+        newThread->Setup(share);
+        threads.Append(newThread);
+    }
+
+    Timing::Timer timer;
+    timer.Start();
+    for (i = 0; i < numThreads; i++)
+    {
+        threads[i]->Start();
+    }
+    bool anyRunning;
+    do
+    {
+        anyRunning = false;
+        for (i = 0; i < numThreads; i++)
+        {
+            if (threads[i]->IsRunning())
+            {
+                anyRunning = true;
+                break;
+            }
+        }
+        n_sleep(0.001);
+    }
+    while (anyRunning);
+    timer.Stop();
+
+    int64_t bytesRead = 0;
+    for (i = 0; i < numThreads; i++)
+    {
+        bytesRead += threads[i]->GetBytesRead();
+    }
+    double const megaBytes = bytesRead / (1024.0 * 1024.0);
+    n_printf("%d threads: %.1f MB in %f s, %.1f MB/s\n", numThreads, megaBytes, timer.GetTime(), megaBytes / timer.GetTime());
+}
+
+//------------------------------------------------------------------------------
+/**
+*/
+void
+ZipStressTestApplication::RunStressTest()
+{
     const SizeT numThreads = 8;
 
     // create reader threads
@@ -4,6 +4,11 @@
     @class ZipStressTestApplication
     
     Multithreading stress test for zip file access.
+
+    With -throughput, all files of the mounted archives are read by a number
+    of threads (-threads, default 8) and the read throughput is printed, once
+    with a single thread and once with all threads, to show how zip reads
+    scale with cores.
     
     (C) 2009 Radon Labs GmbH
 */
@@ -18,6 +23,12 @@ class ZipStressTestApplication : public ConsoleApplication
 public:
     /// run the application, return when user wants to exit
     virtual void Run();
+
+private:
+    /// run the original stress test
+    void RunStressTest();
+    /// measure read throughput with numThreads threads
+    void RunThroughputTest(SizeT numThreads, const Util::Array<Util::String>& files);
 }; 
 
 } // namespace App
@@ -20,7 +20,8 @@ using namespace IO;
 /**
 */
 ArchiverApp::ArchiverApp() :
-    webDeployFlag(false)
+    webDeployFlag(false),
+    packFlag(false)
 {
     // empty
 }
@@ -35,7 +36,8 @@ ArchiverApp::ShowHelp()
              "(C) Radon Labs GmbH\n"
              "Creates platform-specific asset archives (e.g. export.zip, export_win32.zip)\n"
              "-help -- display this help\n"
-             "-webdeploy -- create a web-deployment directory (only win32 platform)!\n");
+             "-webdeploy -- create a web-deployment directory (only win32 platform)!\n"
+             "-pack -- create a memory mappable pack archive (e.g. export.pack) instead of a zip archive\n");
 }
 
 //------------------------------------------------------------------------------
@@ -47,6 +49,7 @@ ArchiverApp::ParseCmdLineArgs()
     if (ToolkitApp::ParseCmdLineArgs())
     {
         this->webDeployFlag = this->args.GetBoolFlag("-webdeploy");
+        this->packFlag = this->args.GetBoolFlag("-pack");
         return true;
     }
     return false;
@@ -111,7 +114,14 @@ ArchiverApp::Run()
             }
             // fallthrough!
         case Platform::Linux:
-            this->PackDirectoryWin360(this->projectInfo.GetAttr("DstDir"));
+            if (this->packFlag)
+            {
+                this->PackDirectoryPack(this->projectInfo.GetAttr("DstDir"));
+            }
+            else
+            {
+                this->PackDirectoryWin360(this->projectInfo.GetAttr("DstDir"));
+            }
             break;
     }
 }
@@ -273,6 +283,101 @@ ArchiverApp::PackDirectoryWin360(const String& dirPath)
     }
 }
 
+//------------------------------------------------------------------------------
+/**
+    Packs a single directory into a pack archive next to it. Paths in the
+    archive start with the directory name, like in the zip archive, so both
+    are mounted the same way.
+*/
+void
+ArchiverApp::PackDirectoryPack(const String& dirPath)
+{
+    IoServer* ioServer = IoServer::Instance();
+
+    // make sure the directory exists
+    if (!ioServer->DirectoryExists(dirPath))
+    {
+        n_printf("ERROR: dir '%s' does not exist!", dirPath.AsCharPtr());
+        return;
+    }
+
+    // delete the target file, if exists
+    String filePath = dirPath + ".pack";
+    if (ioServer->FileExists(filePath))
+    {
+        ioServer->DeleteFile(filePath);
+    }
+
+    n_printf("Archiving: %s\n", filePath.AsCharPtr());
+    Ptr<PackWriter> writer = PackWriter::Create();
+    writer->SetURI(filePath);
+    writer->SetCompressionLevel(9);
+    if (!writer->Open())
+    {
+        n_printf("ERROR: failed to create '%s'!\n", filePath.AsCharPtr());
+        return;
+    }
+    this->RecursePackDirectory(writer, dirPath, dirPath.ExtractFileName());
+    n_printf("-> %s (%d files)\n", filePath.AsCharPtr(), writer->GetNumFiles());
+    writer->Close();
+}
+
+//------------------------------------------------------------------------------
+/**
+*/
+void
+ArchiverApp::RecursePackDirectory(PackWriter* writer, const String& dir, const String& pathInArchive)
+{
+    IoServer* ioServer = IoServer::Instance();
+
+    Array<String> files = ioServer->ListFiles(dir, "*");
+    IndexT fileIndex;
+    for (fileIndex = 0; fileIndex < files.Size(); fileIndex++)
+    {
+        const String& file = files[fileIndex];
+        bool excluded = false;
+        IndexT i;
+        for (i = 0; i < this->excludePatterns.Size() && !excluded; i++)
+        {
+            excluded = String::MatchPattern(file, this->excludePatterns[i]);
+        }
+        if (excluded)
+        {
+            continue;
+        }
+
+        String srcPath = dir + "/" + file;
+        Ptr<Stream> srcStream = ioServer->CreateStream(srcPath);
+        srcStream->SetAccessMode(Stream::ReadAccess);
+        if (srcStream->Open())
+        {
+            SizeT srcSize = srcStream->GetSize();
+            void* srcData = srcSize > 0 ? srcStream->Map() : nullptr;
+            writer->AddFile(pathInArchive + "/" + file, srcData, srcSize);
+            if (srcSize > 0)
+            {
+                srcStream->Unmap();
+            }
+            srcStream->Close();
+        }
+        else
+        {
+            n_printf("WARNING: failed to open '%s'!\n", srcPath.AsCharPtr());
+        }
+    }
+
+    Array<String> dirs = ioServer->ListDirectories(dir, "*");
+    IndexT dirIndex;
+    for (dirIndex = 0; dirIndex < dirs.Size(); dirIndex++)
+    {
+        const String& curDir = dirs[dirIndex];
+        if ((curDir != "CVS") && (curDir != ".svn"))
+        {
+            this->RecursePackDirectory(writer, dir + "/" + curDir, pathInArchive + "/" + curDir);
+        }
+    }
+}
+
 
 
 } // namespace Toolkit
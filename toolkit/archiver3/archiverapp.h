@@ -9,6 +9,7 @@
     (C) 2013-2016 Individual contributors, see AUTHORS file
 */
 #include "toolkitutil/toolkitapp.h"
+#include "io/packfs/packwriter.h"
 
 //------------------------------------------------------------------------------
 namespace Toolkit
@@ -32,6 +33,10 @@ private:
     void PackWebDeploy(const Util::String& dir, const Util::String& webDeployDir);
     /// pack directory using ZIP for the Win32 and Xbox360 platforms
     void PackDirectoryWin360(const Util::String& dir);    
+    /// pack directory into a memory mappable pack archive
+    void PackDirectoryPack(const Util::String& dir);
+    /// recursively add the files of a directory to a pack archive
+    void RecursePackDirectory(IO::PackWriter* writer, const Util::String& dir, const Util::String& pathInArchive);
     /// recursively pack and copy a web-deployment directory
     void RecursePackWebDeployDirectory(const Util::String& srcDir, const Util::String& dstDir);
     /// compress and copy a file for web deployment
@@ -41,6 +46,7 @@ private:
     Util::String wiiDvdRoot;
     Util::Array<Util::String> excludePatterns;
     bool webDeployFlag;
+    bool packFlag;
 };
 
 } // namespace Toolkit
\ No newline at end of file
@@ -27,7 +27,8 @@ enum ExportFlags
     ImportSecondaryUVs = 1 << 4,
     CalcTangents = 1 << 5,
     CalcRigidSkin = 1 << 6,
-    All = (1 << 7) - 1,
+    CompressAnimations = 1 << 7,
+    All = (1 << 8) - 1,
 
     NumMeshFlags
 };
@@ -8,6 +8,9 @@
 #include "io/jsonreader.h"
 #include "game/world.h"
 #include "basegamefeature/levelparser.h"
+#include "io/assignregistry.h"
+#include "io/jsonpullreader.h"
+#include "resources/resourcemanifest.h"
 
 using namespace IO;
 using namespace Util;
@@ -139,9 +142,58 @@ LevelExporter::ExportLevel(const Ptr<IO::JsonReader>& reader, Game::World* world
     if (!entities.IsEmpty())
     {
         world->ExportLevel(outputFile.GetHostAndLocalPath());
+        this->ExportDependencies(reader->GetStream()->GetURI(), Resources::ResourceManifest::GetManifestPath(outputFile.GetHostAndLocalPath()));
         return true;
     }
     return false;
 }
 
+//------------------------------------------------------------------------------
+/**
+    Collects every string in the level which names a resource, together with
+    the dependencies of those resources, so that the whole level can be
+    prefetched from a single manifest.
+*/
+bool
+LevelExporter::ExportDependencies(const IO::URI& level, const IO::URI& manifestFile)
+{
+    Ptr<JsonPullReader> reader = JsonPullReader::Create();
+    reader->SetStream(IoServer::Instance()->CreateStream(level));
+    if (!reader->Open())
+    {
+        return false;
+    }
+
+    AssignRegistry* assigns = AssignRegistry::Instance();
+    Resources::ResourceManifest manifest;
+    JsonPullReader::Token token;
+    while ((token = reader->Next()) != JsonPullReader::EndOfDocument && token != JsonPullReader::Error)
+    {
+        if (token != JsonPullReader::String)
+        {
+            continue;
+        }
+        String value = reader->GetString();
+        IndexT colon = value.FindCharIndex(':');
+        if (colon > 1 && assigns->HasAssign(value.ExtractRange(0, colon)) && !value.GetFileExtension().IsEmpty())
+        {
+            manifest.Add(value, 1);
+
+            Resources::ResourceManifest dependencies;
+            if (dependencies.Load(Resources::ResourceManifest::GetManifestPath(value)))
+            {
+                manifest.Merge(dependencies);
+            }
+        }
+    }
+    reader->Close();
+
+    if (token == JsonPullReader::Error)
+    {
+        this->logger->Warning("Could not collect dependencies of level: %s\n", level.LocalPath().AsCharPtr());
+        return false;
+    }
+    return manifest.Save(manifestFile);
+}
+
 } // namespace ToolkitUtil
\ No newline at end of file
@@ -48,6 +48,8 @@ private:
 
     /// exports level data
     bool ExportLevel(const Ptr<IO::JsonReader>& reader, Game::World* world, const IO::URI& outputFile);
+    /// writes the manifest of all resources used by a level
+    bool ExportDependencies(const IO::URI& level, const IO::URI& manifestFile);
 
     ToolkitUtil::Logger* logger;
 }; 
@@ -5,6 +5,9 @@
 //------------------------------------------------------------------------------
 #include "foundation/stdneb.h"
 #include "model/animutil/animbuilder.h"
+#include "coreanimation/naxfileformatstructs.h"
+#include "math/quat.h"
+#include "math/vec3.h"
 
 namespace ToolkitUtil
 {
@@ -154,4 +157,100 @@ AnimBuilder::BuildVelocityCurves(float keysPerMS)
     }    
 }
 
-} // namespace ToolkitUtil
\ No newline at end of file
+//------------------------------------------------------------------------------
+/**
+    Returns true if every key between first and last is within tolerance of
+    the interpolation between the two, as a distance for vector keys and as
+    an angle in radians for rotation keys.
+*/
+static bool
+CanInterpolate(const float* keys, const Timing::Tick* times, SizeT stride, IndexT first, IndexT last, float tolerance)
+{
+    const Timing::Tick duration = times[last] - times[first];
+    IndexT i;
+    for (i = first + 1; i < last; i++)
+    {
+        const float t = duration > 0 ? float(times[i] - times[first]) / float(duration) : 0.0f;
+        if (stride == 4)
+        {
+            quat q0, q1, q;
+            q0.loadu(keys + first * 4);
+            q1.loadu(keys + last * 4);
+            q.loadu(keys + i * 4);
+            const float angle = 2.0f * Math::acos(Math::min(1.0f, Math::abs(dot(slerp(q0, q1, t), q))));
+            if (angle > tolerance)
+                return false;
+        }
+        else
+        {
+            vec3 v0, v1, v;
+            v0.loadu(keys + first * 3);
+            v1.loadu(keys + last * 3);
+            v.loadu(keys + i * 3);
+            if (length(lerp(v0, v1, t) - v) > tolerance)
+                return false;
+        }
+    }
+    return true;
+}
+
+//------------------------------------------------------------------------------
+/**
+    Keys are removed from each curve separately, so the error is bounded for
+    every joint on its own. The first and last key of a curve are always
+    kept, so clip durations don't change, and no two kept keys are further
+    apart than a compressed interval can store.
+*/
+void
+AnimBuilder::ReduceKeys(float tolerance)
+{
+    Array<float> reducedKeys;
+    Array<Timing::Tick> reducedKeyTimes;
+    reducedKeys.Reserve(this->keys.Size());
+    reducedKeyTimes.Reserve(this->keyTimes.Size());
+
+    for (auto& curve : this->curves)
+    {
+        const SizeT stride = curve.curveType == CurveType::Rotation ? 4 : 3;
+        const float* keys = this->keys.Begin() + curve.firstKeyOffset;
+        const Timing::Tick* times = this->keyTimes.Begin() + curve.firstTimeOffset;
+        const uint firstKeyOffset = reducedKeys.Size();
+        const uint firstTimeOffset = reducedKeyTimes.Size();
+
+        auto keep = [&](IndexT key)
+        {
+            IndexT i;
+            for (i = 0; i < stride; i++)
+                reducedKeys.Append(keys[key * stride + i]);
+            reducedKeyTimes.Append(times[key]);
+        };
+
+        if (curve.numKeys > 0)
+        {
+            // extend the interpolated span until a key in it is off by too much
+            keep(0);
+            IndexT anchor = 0;
+            IndexT next;
+            for (next = 2; next < (IndexT)curve.numKeys; next++)
+            {
+                if (times[next] - times[anchor] > (Timing::Tick)Nax3MaxCompressedIntervalDuration
+                    || !CanInterpolate(keys, times, stride, anchor, next, tolerance))
+                {
+                    anchor = next - 1;
+                    keep(anchor);
+                }
+            }
+            if (curve.numKeys > 1)
+                keep(curve.numKeys - 1);
+        }
+
+        curve.firstKeyOffset = firstKeyOffset;
+        curve.firstTimeOffset = firstTimeOffset;
+        curve.numKeys = reducedKeyTimes.Size() - firstTimeOffset;
+    }
+
+    this->keys = reducedKeys;
+    this->keyTimes = reducedKeyTimes;
+}
+
+} // namespace ToolkitUtil
@@ -40,6 +40,8 @@ public:
 
     /// Generate velocity curves from translation curves
     void BuildVelocityCurves(float keysPerMS);
+    /// remove keys which interpolating the remaining keys reproduces within a tolerance
+    void ReduceKeys(float tolerance);
 
     Util::Array<float> keys;
     Util::Array<Timing::Tick> keyTimes;
@@ -7,6 +7,8 @@
 #include "model/animutil/animbuildersaver.h"
 #include "io/ioserver.h"
 #include "coreanimation/naxfileformatstructs.h"
+#include "coreanimation/animkeycompression.h"
+#include <float.h>
 
 namespace ToolkitUtil
 {
@@ -20,7 +22,7 @@ using namespace Math;
 /**
 */
 bool
-AnimBuilderSaver::Save(const URI& uri, const Util::Array<AnimBuilder>& animBuilders, Platform::Code platform)
+AnimBuilderSaver::Save(const URI& uri, const Util::Array<AnimBuilder>& animBuilders, Platform::Code platform, bool compress)
 {
     // make sure the target directory exists
     IoServer::Instance()->CreateDirectory(uri.LocalPath().ExtractDirName());
@@ -30,8 +32,8 @@ AnimBuilderSaver::Save(const URI& uri, const Util::Array<AnimBuilder>& animBuild
     if (stream->Open())
     {
         ByteOrder byteOrder(ByteOrder::Host, Platform::GetPlatformByteOrder(platform));
-        AnimBuilderSaver::WriteHeader(stream, animBuilders, byteOrder);
-        AnimBuilderSaver::WriteAnimations(stream, animBuilders, byteOrder);
+        AnimBuilderSaver::WriteHeader(stream, animBuilders, byteOrder, compress);
+        AnimBuilderSaver::WriteAnimations(stream, animBuilders, byteOrder, compress);
 
         stream->Close();
         stream = nullptr;
@@ -48,11 +50,11 @@ AnimBuilderSaver::Save(const URI& uri, const Util::Array<AnimBuilder>& animBuild
 /**
 */
 void
-AnimBuilderSaver::WriteHeader(const Ptr<Stream>& stream, const Util::Array<AnimBuilder>& animBuilders, const ByteOrder& byteOrder)
+AnimBuilderSaver::WriteHeader(const Ptr<Stream>& stream, const Util::Array<AnimBuilder>& animBuilders, const ByteOrder& byteOrder, bool compress)
 {
     // setup header
     Nax3Header nax3Header;
-    nax3Header.magic         = byteOrder.Convert<uint>(NEBULA_NAX3_MAGICNUMBER);
+    nax3Header.magic         = byteOrder.Convert<uint>(compress ? NEBULA_NAX3_COMPRESSED_MAGICNUMBER : NEBULA_NAX3_MAGICNUMBER);
     nax3Header.numAnimations = byteOrder.Convert(animBuilders.Size());
 
     // write header
@@ -61,17 +63,80 @@ AnimBuilderSaver::WriteHeader(const Ptr<Stream>& stream, const Util::Array<AnimB
 
 //------------------------------------------------------------------------------
 /**
+    Compressed keys take 3 ushorts each, and their intervals only store
+    the duration in a ushort. A joint sampled at every key costs 40 bytes
+    of keys and 3 intervals of 20 bytes per key uncompressed, 100 bytes,
+    and 18 bytes of keys and 6 bytes of intervals compressed, 24 bytes.
+    The loader expands the intervals again, so in memory it's 78 bytes.
 */
 void 
-AnimBuilderSaver::WriteAnimations(const Ptr<IO::Stream>& stream, const Util::Array<AnimBuilder>& animBuilders, const System::ByteOrder& byteOrder)
+AnimBuilderSaver::WriteAnimations(const Ptr<IO::Stream>& stream, const Util::Array<AnimBuilder>& animBuilders, const System::ByteOrder& byteOrder, bool compress)
 {
     for (auto& anim : animBuilders)
     {
+        // quantize the keys of every curve
+        Util::Array<ushort> compressedKeys;
+        Util::Array<Nax3CompressedCurve> compressedCurves;
+        if (compress)
+        {
+            for (const auto& curve : anim.curves)
+            {
+                const float* keys = anim.keys.Begin() + curve.firstKeyOffset;
+                Nax3CompressedCurve compressedCurve = { { 0, 0, 0 }, { 0, 0, 0 }, (uint)compressedKeys.Size(), 0 };
+                if (curve.numKeys > 0)
+                    compressedCurve.startTime = anim.keyTimes[curve.firstTimeOffset];
+                IndexT i, j;
+                if (curve.curveType == CurveType::Rotation)
+                {
+                    for (i = 0; i < (IndexT)curve.numKeys; i++)
+                    {
+                        ushort key[AnimKeyCompressedStride];
+                        AnimKeyEncodeRotation(quat(keys[i * 4], keys[i * 4 + 1], keys[i * 4 + 2], keys[i * 4 + 3]), key);
+                        for (j = 0; j < AnimKeyCompressedStride; j++)
+                            compressedKeys.Append(key[j]);
+                    }
+                }
+                else
+                {
+                    // the range of the curve is split into 65536 steps
+                    vec4 minimum(FLT_MAX, FLT_MAX, FLT_MAX, 0), maximum(-FLT_MAX, -FLT_MAX, -FLT_MAX, 0);
+                    for (i = 0; i < (IndexT)curve.numKeys; i++)
+                    {
+                        for (j = 0; j < 3; j++)
+                        {
+                            minimum[j] = Math::min(minimum[j], keys[i * 3 + j]);
+                            maximum[j] = Math::max(maximum[j], keys[i * 3 + j]);
+                        }
+                    }
+                    vec4 offset(0.0f), scale(0.0f);
+                    if (curve.numKeys > 0)
+                    {
+                        for (j = 0; j < 3; j++)
+                        {
+                            offset[j] = compressedCurve.offset[j] = minimum[j];
+                            scale[j] = compressedCurve.scale[j] = (maximum[j] - minimum[j]) / 65535.0f;
+                        }
+                    }
+                    for (i = 0; i < (IndexT)curve.numKeys; i++)
+                    {
+                        ushort key[AnimKeyCompressedStride];
+                        AnimKeyEncodeVector(keys + i * 3, offset, scale, key);
+                        for (j = 0; j < AnimKeyCompressedStride; j++)
+                            compressedKeys.Append(key[j]);
+                    }
+                }
+                compressedCurves.Append(compressedCurve);
+            }
+
+            // the decoders read one ushort past the last key
+            compressedKeys.Append(0);
+        }
+
         Nax3Anim nax3;
         nax3.numClips = anim.GetNumClips();
         nax3.numEvents = anim.events.Size();
         nax3.numCurves = anim.curves.Size();
-        nax3.numKeys = anim.keys.Size();
+        nax3.numKeys = compress ? compressedKeys.Size() : anim.keys.Size();
         nax3.numIntervals = 0;
         for (const auto& curve : anim.curves)
         {
@@ -82,13 +147,20 @@ AnimBuilderSaver::WriteAnimations(const Ptr<IO::Stream>& stream, const Util::Arr
         stream->Write(&nax3, sizeof(nax3));
 
         Util::Array<Nax3Interval> intervals;
+        Util::Array<ushort> compressedIntervals;
+        uint numIntervals = 0;
 
-        for (const auto& curve : anim.curves)
+        IndexT curveIndex;
+        for (curveIndex = 0; curveIndex < anim.curves.Size(); curveIndex++)
         {
+            const AnimBuilderCurve& curve = anim.curves[curveIndex];
+
+            const SizeT numCurveIntervals = curve.numKeys == 0 ? 0 : curve.numKeys - 1;
+
             // write curve attributes
             Nax3Curve nax3Curve;
-            nax3Curve.firstIntervalOffset = intervals.Size();
-            nax3Curve.numIntervals = curve.numKeys == 0 ? 0 : curve.numKeys - 1;
+            nax3Curve.firstIntervalOffset = numIntervals;
+            nax3Curve.numIntervals = numCurveIntervals;
             nax3Curve.preInfinityType = curve.preInfinityType;
             nax3Curve.postInfinityType = curve.postInfinityType;
             nax3Curve.curveType = curve.curveType;
@@ -99,22 +171,49 @@ AnimBuilderSaver::WriteAnimations(const Ptr<IO::Stream>& stream, const Util::Arr
             // write to stream
             stream->Write(&nax3Curve, sizeof(nax3Curve));            
 
-            int stride = curve.curveType == CurveType::Rotation ? 4 : 3;
+            numIntervals += numCurveIntervals;
+            if (compress)
+            {
+                // the keys of compressed intervals follow from their index, only the durations are stored
+                Nax3CompressedCurve compressedCurve = compressedCurves[curveIndex];
+                IndexT i;
+                for (i = 0; i < 3; i++)
+                {
+                    byteOrder.ConvertInPlace(compressedCurve.offset[i]);
+                    byteOrder.ConvertInPlace(compressedCurve.scale[i]);
+                }
+                byteOrder.ConvertInPlace(compressedCurve.firstKey);
+                byteOrder.ConvertInPlace(compressedCurve.startTime);
+                stream->Write(&compressedCurve, sizeof(compressedCurve));
 
-            // Create intervals for the keys
-            for (IndexT i = 0; i < nax3Curve.numIntervals; i++)
+                for (i = 0; i < numCurveIntervals; i++)
+                {
+                    const Timing::Tick duration = anim.keyTimes[curve.firstTimeOffset + i + 1] - anim.keyTimes[curve.firstTimeOffset + i];
+                    if (duration < 0 || (uint)duration > Nax3MaxCompressedIntervalDuration)
+                    {
+                        n_error("AnimBuilderSaver: Keys %d ms apart can't be compressed (file=%s)\n", duration, stream->GetURI().LocalPath().AsCharPtr());
+                    }
+                    compressedIntervals.Append(byteOrder.Convert((ushort)duration));
+                }
+            }
+            else
             {
-                Timing::Tick start = anim.keyTimes[curve.firstTimeOffset + i];
-                Timing::Tick end = anim.keyTimes[curve.firstTimeOffset + i + 1];
-                Nax3Interval interval;
+                // Create intervals for the keys
+                const int stride = curve.curveType == CurveType::Rotation ? 4 : 3;
+                for (IndexT i = 0; i < numCurveIntervals; i++)
+                {
+                    Timing::Tick start = anim.keyTimes[curve.firstTimeOffset + i];
+                    Timing::Tick end = anim.keyTimes[curve.firstTimeOffset + i + 1];
+                    Nax3Interval interval;
 
-                interval.start = byteOrder.Convert(start);
-                interval.end = byteOrder.Convert(end);
-                interval.key0 = byteOrder.Convert(curve.firstKeyOffset + i * stride);
-                interval.key1 = byteOrder.Convert(curve.firstKeyOffset + (i + 1) * stride);
-                interval.duration = 1 / float(interval.end - interval.start);
+                    interval.start = byteOrder.Convert(start);
+                    interval.end = byteOrder.Convert(end);
+                    interval.key0 = byteOrder.Convert(curve.firstKeyOffset + i * stride);
+                    interval.key1 = byteOrder.Convert(curve.firstKeyOffset + (i + 1) * stride);
+                    interval.duration = 1 / float(end - start);
 
-                intervals.Append(interval);
+                    intervals.Append(interval);
+                }
             }
         }
 
@@ -181,15 +280,44 @@ AnimBuilderSaver::WriteAnimations(const Ptr<IO::Stream>& stream, const Util::Arr
             stream->Write(&nax3Clip, sizeof(nax3Clip));
         }
 
-        for (const auto& interval : intervals)
+        if (compress)
+        {
+            // pad the durations to whole words, so what follows stays 4-byte aligned
+            if (compressedIntervals.Size() & 1)
+                compressedIntervals.Append(0);
+            if (!compressedIntervals.IsEmpty())
+                stream->Write(compressedIntervals.Begin(), compressedIntervals.ByteSize());
+        }
+        else
         {
-            stream->Write(&interval, sizeof(Nax3Interval));
+            for (const auto& interval : intervals)
+            {
+                stream->Write(&interval, sizeof(Nax3Interval));
+            }
         }
 
-        for (const float key : anim.keys)
+        if (compress)
+        {
+            for (const ushort key : compressedKeys)
+            {
+                ushort value = byteOrder.Convert(key);
+                stream->Write(&value, sizeof(ushort));
+            }
+
+            // same for the keys, the padding isn't counted in numKeys
+            if (compressedKeys.Size() & 1)
+            {
+                const ushort padding = 0;
+                stream->Write(&padding, sizeof(ushort));
+            }
+        }
+        else
         {
-            float value = byteOrder.Convert(key);
-            stream->Write(&value, sizeof(float));
+            for (const float key : anim.keys)
+            {
+                float value = byteOrder.Convert(key);
+                stream->Write(&value, sizeof(float));
+            }
         }
     }
 }
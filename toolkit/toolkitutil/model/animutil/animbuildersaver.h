@@ -3,7 +3,7 @@
 /**
     @class ToolkitUtil::AnimBuilderSaver
     
-    Save AnimBuilder object into NAX3 file.
+    Save AnimBuilder object into NAX3 file, optionally with compressed keys.
     
     (C) 2009 Radon Labs GmbH
     (C) 2013-2016 Individual contributors, see AUTHORS file
@@ -21,13 +21,13 @@ class AnimBuilderSaver
 {
 public:
     /// Save NAX3 file
-    static bool Save(const IO::URI& uri, const Util::Array<AnimBuilder>& animBuilders, Platform::Code platform);
+    static bool Save(const IO::URI& uri, const Util::Array<AnimBuilder>& animBuilders, Platform::Code platform, bool compress = false);
 
 private:
     /// Write header to stream
-    static void WriteHeader(const Ptr<IO::Stream>& stream, const Util::Array<AnimBuilder>& animBuilders, const System::ByteOrder& byteOrder);
+    static void WriteHeader(const Ptr<IO::Stream>& stream, const Util::Array<AnimBuilder>& animBuilders, const System::ByteOrder& byteOrder, bool compress);
     /// Write anim header to stream
-    static void WriteAnimations(const Ptr<IO::Stream>& stream, const Util::Array<AnimBuilder>& animBuilders, const System::ByteOrder& byteOrder);
+    static void WriteAnimations(const Ptr<IO::Stream>& stream, const Util::Array<AnimBuilder>& animBuilders, const System::ByteOrder& byteOrder, bool compress);
 };
 
 } // namespace ToolkitUtil
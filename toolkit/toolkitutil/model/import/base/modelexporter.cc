@@ -188,14 +188,17 @@ ModelExporter::ExportFile(const IO::URI& file)
         timer.Reset();
         timer.Start();
 
-        // Cleanup animations
+        // Cleanup animations, compressed animations also drop the keys they can do without
+        const bool compress = (this->exportFlags & ToolkitUtil::CompressAnimations) != 0;
         for (auto& anim : this->scene->animations)
         {
             anim.BuildVelocityCurves(AnimationFrameRate);
+            if (compress)
+                anim.ReduceKeys(AnimationKeyTolerance);
         }
 
         // now save actual animation
-        if (!AnimBuilderSaver::Save(destinationFiles[DestinationFile::Animation], this->scene->animations, this->platform))
+        if (!AnimBuilderSaver::Save(destinationFiles[DestinationFile::Animation], this->scene->animations, this->platform, compress))
         {
             this->logger->Error("Failed to save animation file: %s\n", destinationFiles[DestinationFile::Animation].LocalPath().AsCharPtr());
         }
@@ -20,6 +20,7 @@ namespace ToolkitUtil
 float SceneScale = 1.0f;
 float AdjustedScale = 1.0f;
 float AnimationFrameRate = 24.0f;
+float AnimationKeyTolerance = 0.0005f;    // in scene units for positions and scales, in radians for rotations
 int KeysPerMS = 40;
 
 //------------------------------------------------------------------------------
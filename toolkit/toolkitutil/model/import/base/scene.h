@@ -17,6 +17,7 @@ extern int KeysPerMS;
 extern float SceneScale;
 extern float AdjustedScale;
 extern float AnimationFrameRate;
+extern float AnimationKeyTolerance;
 class ModelAttributes;
 struct SkeletonBuilder;
 class MeshBuilder;
@@ -21,12 +21,6 @@
 #include "io/stream.h"
 #include "coregraphics/vertexcomponent.h"
 #include "coregraphics/primitivetopology.h"
-namespace pjson
-{
-    class value_variant;
-    class document;
-}
-
 namespace Gltf
 {
 struct GltfBase
@@ -14,14 +14,6 @@
 #include "io/filestream.h"
 #include "io/memorystream.h"
 
-#ifdef min
-#undef min
-#endif
-#ifdef max
-#undef max
-#endif
-#include "pjson/pjson.h"
-
 #pragma warning( disable : 4307 )
 
 //------------------------------------------------------------------------------
@@ -33,27 +25,86 @@ constexpr unsigned int chash(const char* c, int h = 0)
     return !c[h] ? 5381 : (chash(c, h + 1) * 33) ^ c[h];
 }
 
+//------------------------------------------------------------------------------
+/**
+*/
+static void
+SerializeString(const char* str, Util::String& out)
+{
+    out.AppendChar('"');
+    for (const char* c = str; *c != 0; c++)
+    {
+        switch (*c)
+        {
+            case '"': out.Append("\\\""); break;
+            case '\\': out.Append("\\\\"); break;
+            case '\n': out.Append("\\n"); break;
+            case '\r': out.Append("\\r"); break;
+            case '\t': out.Append("\\t"); break;
+            default:
+                if ((unsigned char)*c < 0x20)
+                    out.Append(Util::String::Sprintf("\\u%04x", (unsigned char)*c));
+                else
+                    out.AppendChar(*c);
+        }
+    }
+    out.AppendChar('"');
+}
+
+//------------------------------------------------------------------------------
+/**
+    Writes a node back to json text, extensions and extras are kept serialized.
+*/
+static void
+SerializeNode(const IO::JsonReader::Node& node, Util::String& out)
+{
+    using Node = IO::JsonReader::Node;
+    switch (node.type)
+    {
+        case Node::NullType: out.Append("null"); break;
+        case Node::BoolType: out.Append(node.b ? "true" : "false"); break;
+        case Node::IntType: out.Append(Util::String::Sprintf("%lld", (long long)node.i)); break;
+        case Node::DoubleType: out.Append(Util::String::Sprintf("%.17g", node.d)); break;
+        case Node::StringType: SerializeString(node.str, out); break;
+        case Node::ArrayType:
+        case Node::ObjectType:
+        {
+            bool const isObject = node.IsObject();
+            out.AppendChar(isObject ? '{' : '[');
+            for (IndexT i = 0; i < node.Size(); i++)
+            {
+                if (i > 0)
+                    out.AppendChar(',');
+                if (isObject)
+                {
+                    SerializeString(node.KeyAt(i), out);
+                    out.AppendChar(':');
+                }
+                SerializeNode(node.At(i), out);
+            }
+            out.AppendChar(isObject ? '}' : ']');
+            break;
+        }
+    }
+}
+
 //------------------------------------------------------------------------------
 /**
 */
 void
-ReadExtensionsAndExtras(Gltf::GltfBase& base, const pjson::value_variant* object)
+ReadExtensionsAndExtras(Gltf::GltfBase& base, const IO::JsonReader::Node* object)
 {
-    int extsIdx = object->find_key("extensions");
-    if (extsIdx >= 0)
+    const IO::JsonReader::Node* exts = object->Find("extensions");
+    if (exts != nullptr)
     {
-        //FIXME overload this with native nebula type
-        pjson::char_vec_t vec;
-        object->get_value_at_index(extsIdx).serialize(vec);
-        base.extensions = &vec[0];
+        base.extensions.Clear();
+        SerializeNode(*exts, base.extensions);
     }
-    int extrasIdx = object->find_key("extras");
-    if (extrasIdx >= 0)
+    const IO::JsonReader::Node* extras = object->Find("extras");
+    if (extras != nullptr)
     {
-        //FIXME overload this with native nebula type
-        pjson::char_vec_t vec;
-        object->get_value_at_index(extrasIdx).serialize(vec);
-        base.extras = &vec[0];
+        base.extras.Clear();
+        SerializeNode(*extras, base.extras);
     }
 }
 
@@ -1097,7 +1148,7 @@ Document::Deserialize(Ptr<IO::Stream> const& stream, bool binary)
         return false;
     }
 
-    // binary file, must splice the input buffer into two separate streams because of how pjson works
+    // binary file, must splice the input buffer into two separate streams because the json reader needs the json chunk on its own
     Ptr<IO::StreamReader> streamReader = IO::StreamReader::Create();
     streamReader->SetStream(stream);
 
@@ -22,7 +22,7 @@ __ImplementClass(ToolkitUtil::ModelAttributes, 'MOAT', Core::RefCounted);
 /**
 */
 ModelAttributes::ModelAttributes() :    
-    exportFlags(ToolkitUtil::ExportFlags(ToolkitUtil::FlipUVs)),
+    exportFlags(ToolkitUtil::ExportFlags(ToolkitUtil::FlipUVs | ToolkitUtil::CompressAnimations)),
     scaleFactor(1.0f)
 {
     // empty
@@ -13,6 +13,7 @@
 #include "nflatbuffer/flatbufferinterface.h"
 #include "nflatbuffer/nebula_flat.h"
 #include "flat/physics/actor.h"
+#include "io/xmlreader.h"
 
 using namespace Util;
 using namespace IO;
@@ -98,11 +99,94 @@ ModelBuilder::SaveN3(const IO::URI& uri, Platform::Code platform)
         writer->Close();
 
         stream->Close();
+
+        // the resource server uses the manifest to load all dependencies up front
+        this->SaveDependencies(Resources::ResourceManifest::GetManifestPath(uri.AsString()));
         return true;
     }
 
     return false;
 }
+
+//------------------------------------------------------------------------------
+/**
+*/
+bool
+ModelBuilder::SaveDependencies(const IO::URI& uri)
+{
+    Resources::ResourceManifest manifest;
+    for (const ModelConstants::ShapeNode& shape : this->constants->GetShapeNodes())
+    {
+        manifest.Add(shape.meshResource, 1);
+        this->AddMaterialDependencies(manifest, this->attributes->GetState(shape.path).material);
+    }
+    for (const ModelConstants::SkinSetNode& skinSet : this->constants->GetSkinSetNodes())
+    {
+        for (const ModelConstants::SkinNode& skin : skinSet.skinFragments)
+        {
+            manifest.Add(skin.meshResource, 1);
+            this->AddMaterialDependencies(manifest, this->attributes->GetState(skin.path).material);
+        }
+    }
+    for (const ModelConstants::ParticleNode& particle : this->constants->GetParticleNodes())
+    {
+        const String& emitterMesh = this->attributes->GetEmitterMesh(particle.path);
+        if (emitterMesh.IsValid())
+        {
+            manifest.Add(emitterMesh, 1);
+        }
+        this->AddMaterialDependencies(manifest, this->attributes->GetState(particle.path).material);
+    }
+    return manifest.Save(uri);
+}
+
+//------------------------------------------------------------------------------
+/**
+    Textures are looked up in the surface source, since the surface might not
+    have been exported yet. Surface parameters with a resource path as value
+    are textures.
+*/
+void
+ModelBuilder::AddMaterialDependencies(Resources::ResourceManifest& manifest, const Util::String& material)
+{
+    if (!material.IsValid())
+    {
+        return;
+    }
+    manifest.Add(material, 1);
+
+    // sur:category/name.sur is exported from src:assets/category/name.sur
+    if (!material.BeginsWithString("sur:"))
+    {
+        return;
+    }
+    URI source = "src:assets/" + material.ExtractToEnd(4);
+    if (!IoServer::Instance()->FileExists(source))
+    {
+        return;
+    }
+
+    Ptr<XmlReader> reader = XmlReader::Create();
+    reader->SetStream(IoServer::Instance()->CreateStream(source));
+    if (reader->Open())
+    {
+        if (reader->HasNode("/Nebula/Surface"))
+        {
+            reader->SetToNode("/Nebula/Surface");
+            if (reader->SetToFirstChild("Param")) do
+            {
+                String value = reader->GetOptString("value", "");
+                if (value.FindCharIndex(':') > 0)
+                {
+                    manifest.Add(value + NEBULA_TEXTURE_EXTENSION, 2);
+                }
+            }
+            while (reader->SetToNextChild("Param"));
+        }
+        reader->Close();
+    }
+}
+
 //------------------------------------------------------------------------------
 /**
 */
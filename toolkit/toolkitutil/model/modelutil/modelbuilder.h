@@ -13,6 +13,7 @@
 #include "modelconstants.h"
 #include "modelattributes.h"
 #include "model/binarymodelwriter.h"
+#include "resources/resourcemanifest.h"
 
 namespace ToolkitUtil
 {
@@ -56,6 +57,11 @@ private:
     /// writes particles
     void WriteParticles(const Ptr<ModelWriter>& writer);
 
+    /// saves the manifest of meshes, materials and textures the model depends on
+    bool SaveDependencies(const IO::URI& uri);
+    /// add a material and the textures it uses to a manifest
+    void AddMaterialDependencies(Resources::ResourceManifest& manifest, const Util::String& material);
+
     Ptr<ModelConstants> constants;
     Ptr<ModelAttributes> attributes;
     Ptr<ModelPhysics> physics;